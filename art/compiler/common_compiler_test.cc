@@ -307,9 +307,7 @@ void CommonCompilerTest::SetUp() {
       }
     }
 
-    // TODO: make selectable
-    Compiler::Kind compiler_kind
-    = (kUsePortableCompiler) ? Compiler::kPortable : Compiler::kQuick;
+    Compiler::Kind compiler_kind = GetCompilerKind();
     timer_.reset(new CumulativeLogger("Compilation times"));
     compiler_driver_.reset(new CompilerDriver(compiler_options_.get(),
                                               verification_results_.get(),
@@ -323,6 +321,10 @@ void CommonCompilerTest::SetUp() {
   compiler_driver_->SetSupportBootImageFixup(false);
 }
 
+Compiler::Kind CommonCompilerTest::GetCompilerKind() const {
+  return kUsePortableCompiler ? Compiler::kPortable : Compiler::kQuick;
+}
+
 void CommonCompilerTest::SetUpRuntimeOptions(RuntimeOptions* options) {
   CommonRuntimeTest::SetUpRuntimeOptions(options);
 
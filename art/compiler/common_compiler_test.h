@@ -21,6 +21,7 @@
 #include <vector>
 
 #include "common_runtime_test.h"
+#include "compiler.h"
 #include "oat_file.h"
 
 namespace art {
@@ -58,6 +59,9 @@ class CommonCompilerTest : public CommonRuntimeTest {
 
   virtual void TearDown();
 
+  // The compiler the tests compile methods with.
+  virtual Compiler::Kind GetCompilerKind() const;
+
   void CompileClass(mirror::ClassLoader* class_loader, const char* class_name)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
@@ -109,6 +109,9 @@ class Compiler {
     return nullptr;
   }
 
+  // Logs the statistics gathered while compiling, when dex2oat runs with --dump-stats.
+  virtual void DumpStats() const {}
+
  protected:
   explicit Compiler(CompilerDriver* driver, uint64_t warning) :
       driver_(driver), maximum_compilation_time_before_warning_(warning) {
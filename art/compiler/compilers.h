@@ -18,6 +18,7 @@
 #define ART_COMPILER_COMPILERS_H_
 
 #include "compiler.h"
+#include "optimizing/optimizing_compiler_stats.h"
 
 namespace art {
 
@@ -91,9 +92,18 @@ class OptimizingCompiler FINAL : public QuickCompiler {
                              jobject class_loader,
                              const DexFile& dex_file) const;
 
+  void DumpStats() const OVERRIDE;
+
+  const OptimizingCompilerStats& GetCompilationStats() const {
+    return compilation_stats_;
+  }
+
  private:
   std::unique_ptr<std::ostream> visualizer_output_;
 
+  // Counts the methods compiled, and the reasons why the others fell back to Quick.
+  mutable OptimizingCompilerStats compilation_stats_;
+
   DISALLOW_COPY_AND_ASSIGN(OptimizingCompiler);
 };
 
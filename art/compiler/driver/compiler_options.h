@@ -17,6 +17,8 @@
 #ifndef ART_COMPILER_DRIVER_COMPILER_OPTIONS_H_
 #define ART_COMPILER_DRIVER_COMPILER_OPTIONS_H_
 
+#include <string>
+
 namespace art {
 
 class CompilerOptions {
@@ -41,6 +43,8 @@ class CompilerOptions {
   static const size_t kDefaultSmallMethodThreshold = 60;
   static const size_t kDefaultTinyMethodThreshold = 20;
   static const size_t kDefaultNumDexMethodsThreshold = 900;
+  static const size_t kDefaultInlineMaxCodeUnits = 32;
+  static const size_t kDefaultInlineMaxTotalCodeUnits = 256;
   static constexpr double kDefaultTopKProfileThreshold = 90.0;
   static const bool kDefaultIncludeDebugSymbols = kIsDebugBuild;
   static const bool kDefaultIncludePatchInformation = false;
@@ -59,7 +63,9 @@ class CompilerOptions {
     implicit_null_checks_(false),
     implicit_so_checks_(false),
     implicit_suspend_checks_(false),
-    compile_pic_(false)
+    compile_pic_(false),
+    inline_max_code_units_(kDefaultInlineMaxCodeUnits),
+    inline_max_total_code_units_(kDefaultInlineMaxTotalCodeUnits)
 #ifdef ART_SEA_IR_MODE
     , sea_ir_mode_(false)
 #endif
@@ -96,7 +102,9 @@ class CompilerOptions {
     implicit_null_checks_(implicit_null_checks),
     implicit_so_checks_(implicit_so_checks),
     implicit_suspend_checks_(implicit_suspend_checks),
-    compile_pic_(compile_pic)
+    compile_pic_(compile_pic),
+    inline_max_code_units_(kDefaultInlineMaxCodeUnits),
+    inline_max_total_code_units_(kDefaultInlineMaxTotalCodeUnits)
 #ifdef ART_SEA_IR_MODE
     , sea_ir_mode_(sea_ir_mode)
 #endif
@@ -204,6 +212,46 @@ class CompilerOptions {
     return compile_pic_;
   }
 
+  // The optimizing compiler passes not to run, by name, separated by commas.
+  void SetDisabledPasses(const std::string& disabled_passes) {
+    disabled_passes_ = disabled_passes;
+  }
+
+  // Whether the pass is one of the disabled ones. Names are compared whole, so that disabling
+  // a pass doesn't disable every pass whose name contains it.
+  bool IsPassDisabled(const char* pass_name) const {
+    size_t start = 0;
+    while (start < disabled_passes_.size()) {
+      size_t end = disabled_passes_.find(',', start);
+      if (end == std::string::npos) {
+        end = disabled_passes_.size();
+      }
+      if (disabled_passes_.compare(start, end - start, pass_name) == 0) {
+        return true;
+      }
+      start = end + 1;
+    }
+    return false;
+  }
+
+  // The size, in code units, of the largest method the optimizing compiler inlines.
+  size_t GetInlineMaxCodeUnits() const {
+    return inline_max_code_units_;
+  }
+
+  void SetInlineMaxCodeUnits(size_t inline_max_code_units) {
+    inline_max_code_units_ = inline_max_code_units;
+  }
+
+  // The total size, in code units, of the methods inlined into one method.
+  size_t GetInlineMaxTotalCodeUnits() const {
+    return inline_max_total_code_units_;
+  }
+
+  void SetInlineMaxTotalCodeUnits(size_t inline_max_total_code_units) {
+    inline_max_total_code_units_ = inline_max_total_code_units;
+  }
+
  private:
   CompilerFilter compiler_filter_;
   size_t huge_method_threshold_;
@@ -220,6 +268,9 @@ class CompilerOptions {
   bool implicit_so_checks_;
   bool implicit_suspend_checks_;
   bool compile_pic_;
+  std::string disabled_passes_;
+  size_t inline_max_code_units_;
+  size_t inline_max_total_code_units_;
 #ifdef ART_SEA_IR_MODE
   bool sea_ir_mode_;
 #endif
@@ -0,0 +1,164 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "bounds_check_elimination.h"
+
+namespace art {
+
+// Returns the array `length` is read from, past its null checks, or null if `length`
+// is not an array length.
+static HInstruction* GetArrayOf(HInstruction* length) {
+  if (!length->IsArrayLength()) {
+    return nullptr;
+  }
+  HInstruction* array = length->InputAt(0);
+  while (array->IsNullCheck()) {
+    array = array->InputAt(0);
+  }
+  return array;
+}
+
+static bool IsLengthOf(HInstruction* length, HInstruction* array) {
+  return array != nullptr && GetArrayOf(length) == array;
+}
+
+static bool IsIntConstant(HInstruction* instruction, int32_t value) {
+  return instruction->IsIntConstant() && instruction->AsIntConstant()->GetValue() == value;
+}
+
+// Returns a bounds check of the same index against the same array executed before `check`,
+// or null if there is none.
+static HBoundsCheck* FindDominatingBoundsCheck(HBoundsCheck* check) {
+  HInstruction* index = check->InputAt(0);
+  HInstruction* length = check->InputAt(1);
+  HInstruction* array = GetArrayOf(length);
+  for (HUseIterator<HInstruction> it(index->GetUses()); !it.Done(); it.Advance()) {
+    HInstruction* user = it.Current()->GetUser();
+    if (user->IsBoundsCheck()
+        && it.Current()->GetIndex() == 0
+        && (user->InputAt(1) == length || IsLengthOf(user->InputAt(1), array))
+        && user->StrictlyDominates(check)) {
+      return user->AsBoundsCheck();
+    }
+  }
+  return nullptr;
+}
+
+HBasicBlock* HBoundsCheckElimination::FindUpperBoundTest(HPhi* phi,
+                                                        HInstruction* array,
+                                                        HBasicBlock* block) const {
+  HBasicBlock* header = phi->GetBlock();
+  HLoopInformation* loop_info = header->GetLoopInformation();
+  // Walk up the dominator tree, within the loop, looking for a block only entered through
+  // one branch of a test of `phi`.
+  for (HBasicBlock* current = block;
+       current != header && loop_info->Contains(*current);
+       current = current->GetDominator()) {
+    if (current->GetPredecessors().Size() != 1) {
+      continue;
+    }
+    HInstruction* last = current->GetPredecessors().Get(0)->GetLastInstruction();
+    if (!last->IsIf() || !last->InputAt(0)->IsCondition()) {
+      continue;
+    }
+    HIf* if_instruction = last->AsIf();
+    HCondition* condition = if_instruction->InputAt(0)->AsCondition();
+    HInstruction* left = condition->InputAt(0);
+    HInstruction* right = condition->InputAt(1);
+    // The conditions under which `phi` is less than the length when the branch is taken.
+    bool is_less;
+    if (current == if_instruction->IfTrueSuccessor()) {
+      is_less = (condition->GetCondition() == kCondLT && left == phi && IsLengthOf(right, array))
+          || (condition->GetCondition() == kCondGT && right == phi && IsLengthOf(left, array));
+    } else {
+      DCHECK_EQ(current, if_instruction->IfFalseSuccessor());
+      is_less = (condition->GetCondition() == kCondGE && left == phi && IsLengthOf(right, array))
+          || (condition->GetCondition() == kCondLE && right == phi && IsLengthOf(left, array));
+    }
+    if (is_less) {
+      return current;
+    }
+  }
+  return nullptr;
+}
+
+bool HBoundsCheckElimination::IsInductionVariableInBounds(HPhi* phi,
+                                                          HInstruction* array,
+                                                          HBasicBlock* block) const {
+  HBasicBlock* header = phi->GetBlock();
+  if (array == nullptr || !header->IsLoopHeader()) {
+    return false;
+  }
+  HLoopInformation* loop_info = header->GetLoopInformation();
+  if (loop_info->NumberOfBackEdges() != 1
+      || phi->InputCount() != 2
+      || !loop_info->Contains(*block)) {
+    return false;
+  }
+
+  // The phi must be `initial` when entering the loop and `phi + 1` on the back edge.
+  size_t back_edge_index = (header->GetPredecessors().Get(0) == loop_info->GetBackEdges().Get(0))
+      ? 0
+      : 1;
+  HInstruction* initial = phi->InputAt(1 - back_edge_index);
+  HInstruction* update = phi->InputAt(back_edge_index);
+  if (!initial->IsIntConstant() || initial->AsIntConstant()->GetValue() < 0) {
+    return false;
+  }
+  if (!update->IsAdd() || update->GetType() != Primitive::kPrimInt) {
+    return false;
+  }
+  if (!(update->InputAt(0) == phi && IsIntConstant(update->InputAt(1), 1))
+      && !(update->InputAt(1) == phi && IsIntConstant(update->InputAt(0), 1))) {
+    return false;
+  }
+
+  // The test bounds the phi where the check is. It must also guard the increment: the
+  // phi is then less than a length when incremented, so it never overflows and stays
+  // non-negative.
+  HBasicBlock* bounded = FindUpperBoundTest(phi, array, block);
+  return bounded != nullptr && bounded->Dominates(update->GetBlock());
+}
+
+void HBoundsCheckElimination::Run() {
+  // Process the blocks in reverse post order, so that a dominating bounds check has been
+  // looked at, and kept or removed, before the checks it dominates.
+  for (HReversePostOrderIterator it(*graph_); !it.Done(); it.Advance()) {
+    HBasicBlock* block = it.Current();
+    for (HInstructionIterator inst_it(block->GetInstructions()); !inst_it.Done();
+         inst_it.Advance()) {
+      HBoundsCheck* check = inst_it.Current()->AsBoundsCheck();
+      if (check == nullptr) {
+        continue;
+      }
+      HInstruction* index = check->InputAt(0);
+      bool is_redundant = FindDominatingBoundsCheck(check) != nullptr;
+      if (!is_redundant && index->IsPhi()) {
+        is_redundant =
+            IsInductionVariableInBounds(index->AsPhi(), GetArrayOf(check->InputAt(1)), block);
+      }
+      if (is_redundant) {
+        check->ReplaceWith(index);
+        block->RemoveInstruction(check);
+        if (compilation_stats_ != nullptr) {
+          compilation_stats_->RecordStat(MethodCompilationStat::kRemovedBoundsCheck);
+        }
+      }
+    }
+  }
+}
+
+}  // namespace art
@@ -0,0 +1,60 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_COMPILER_OPTIMIZING_BOUNDS_CHECK_ELIMINATION_H_
+#define ART_COMPILER_OPTIMIZING_BOUNDS_CHECK_ELIMINATION_H_
+
+#include "optimization.h"
+#include "optimizing_compiler_stats.h"
+
+namespace art {
+
+/**
+ * Optimization pass removing the bounds checks that can never fail:
+ * - a check of an index already checked against the same array by a dominating check,
+ * - a check of a loop induction variable that starts at a non-negative constant, is
+ *   incremented by one, and is compared against the length of the same array by a test
+ *   of the loop that guards the check.
+ * The length of an array never changes, so two lengths are the same when they are
+ * read from the same array, whatever null checks the array went through.
+ */
+class HBoundsCheckElimination : public HOptimization {
+ public:
+  explicit HBoundsCheckElimination(HGraph* graph,
+                                   OptimizingCompilerStats* compilation_stats = nullptr)
+      : HOptimization(graph, kBoundsCheckEliminationPassName),
+        compilation_stats_(compilation_stats) {}
+
+  virtual void Run() OVERRIDE;
+
+  static constexpr const char* kBoundsCheckEliminationPassName = "BCE";
+
+ private:
+  // Returns whether `index`, a phi of a loop header, is in [0, length of `array`) in `block`.
+  bool IsInductionVariableInBounds(HPhi* index, HInstruction* array, HBasicBlock* block) const;
+
+  // Returns the successor of a test of the loop of `phi`, guarding `block`, that is only
+  // taken when `phi` is less than the length of `array`. Returns null if there is none.
+  HBasicBlock* FindUpperBoundTest(HPhi* phi, HInstruction* array, HBasicBlock* block) const;
+
+  OptimizingCompilerStats* const compilation_stats_;
+
+  DISALLOW_COPY_AND_ASSIGN(HBoundsCheckElimination);
+};
+
+}  // namespace art
+
+#endif  // ART_COMPILER_OPTIMIZING_BOUNDS_CHECK_ELIMINATION_H_
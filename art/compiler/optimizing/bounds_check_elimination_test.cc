@@ -0,0 +1,172 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "bounds_check_elimination.h"
+#include "nodes.h"
+#include "null_check_elimination.h"
+#include "utils/arena_allocator.h"
+
+#include "gtest/gtest.h"
+
+namespace art {
+
+static HBasicBlock* CreateBlock(HGraph* graph, ArenaAllocator* allocator) {
+  HBasicBlock* block = new (allocator) HBasicBlock(graph);
+  graph->AddBlock(block);
+  return block;
+}
+
+// Builds the SSA graph of:
+//   for (int i = 0; i < array.length; i += increment) { array[i]; }
+// Reading the length and the element both null check the array. Returns the bounds check.
+static HBoundsCheck* BuildArrayLoop(HGraph* graph, ArenaAllocator* allocator, int32_t increment) {
+  HBasicBlock* entry = CreateBlock(graph, allocator);
+  graph->SetEntryBlock(entry);
+  HInstruction* array = new (allocator) HParameterValue(0, Primitive::kPrimNot);
+  entry->AddInstruction(array);
+  HInstruction* constant_0 = new (allocator) HIntConstant(0);
+  entry->AddInstruction(constant_0);
+  HInstruction* constant_increment = new (allocator) HIntConstant(increment);
+  entry->AddInstruction(constant_increment);
+  entry->AddInstruction(new (allocator) HGoto());
+
+  HBasicBlock* header = CreateBlock(graph, allocator);
+  HPhi* phi = new (allocator) HPhi(allocator, 0, 0, Primitive::kPrimInt);
+  header->AddPhi(phi);
+  HInstruction* null_check = new (allocator) HNullCheck(array, 0);
+  header->AddInstruction(null_check);
+  HInstruction* length = new (allocator) HArrayLength(null_check);
+  header->AddInstruction(length);
+  HInstruction* compare = new (allocator) HGreaterThanOrEqual(phi, length);
+  header->AddInstruction(compare);
+  header->AddInstruction(new (allocator) HIf(compare));
+
+  HBasicBlock* body = CreateBlock(graph, allocator);
+  null_check = new (allocator) HNullCheck(array, 0);
+  body->AddInstruction(null_check);
+  length = new (allocator) HArrayLength(null_check);
+  body->AddInstruction(length);
+  HBoundsCheck* bounds_check = new (allocator) HBoundsCheck(phi, length, 0);
+  body->AddInstruction(bounds_check);
+  body->AddInstruction(new (allocator) HArrayGet(null_check, bounds_check, Primitive::kPrimInt));
+  HInstruction* add = new (allocator) HAdd(Primitive::kPrimInt, phi, constant_increment);
+  body->AddInstruction(add);
+  body->AddInstruction(new (allocator) HGoto());
+
+  HBasicBlock* return_block = CreateBlock(graph, allocator);
+  return_block->AddInstruction(new (allocator) HReturnVoid());
+  HBasicBlock* exit = CreateBlock(graph, allocator);
+  graph->SetExitBlock(exit);
+  exit->AddInstruction(new (allocator) HExit());
+
+  entry->AddSuccessor(header);
+  header->AddSuccessor(return_block);
+  header->AddSuccessor(body);
+  body->AddSuccessor(header);
+  return_block->AddSuccessor(exit);
+  phi->AddInput(constant_0);
+  phi->AddInput(add);
+
+  graph->BuildDominatorTree();
+  graph->FindNaturalLoops();
+  return bounds_check;
+}
+
+TEST(BoundsCheckEliminationTest, LoopInductionVariable) {
+  ArenaPool pool;
+  ArenaAllocator allocator(&pool);
+  HGraph* graph = new (&allocator) HGraph(&allocator);
+  HBoundsCheck* bounds_check = BuildArrayLoop(graph, &allocator, 1);
+  HInstruction* index = bounds_check->InputAt(0);
+  HInstruction* array_get = bounds_check->GetUses()->GetUser();
+
+  HBoundsCheckElimination(graph).Run();
+  EXPECT_FALSE(bounds_check->IsInBlock());
+  EXPECT_EQ(index, array_get->InputAt(1));
+}
+
+TEST(BoundsCheckEliminationTest, LoopIncrementByTwo) {
+  ArenaPool pool;
+  ArenaAllocator allocator(&pool);
+  HGraph* graph = new (&allocator) HGraph(&allocator);
+  // The index may overflow past the length.
+  HBoundsCheck* bounds_check = BuildArrayLoop(graph, &allocator, 2);
+
+  HBoundsCheckElimination(graph).Run();
+  EXPECT_TRUE(bounds_check->IsInBlock());
+}
+
+TEST(BoundsCheckEliminationTest, DominatingCheck) {
+  // array[index] = array[index];
+  ArenaPool pool;
+  ArenaAllocator allocator(&pool);
+  HGraph* graph = new (&allocator) HGraph(&allocator);
+  HBasicBlock* entry = CreateBlock(graph, &allocator);
+  graph->SetEntryBlock(entry);
+  HInstruction* array = new (&allocator) HParameterValue(0, Primitive::kPrimNot);
+  entry->AddInstruction(array);
+  HInstruction* index = new (&allocator) HParameterValue(1, Primitive::kPrimInt);
+  entry->AddInstruction(index);
+
+  HBasicBlock* block = CreateBlock(graph, &allocator);
+  HInstruction* null_check = new (&allocator) HNullCheck(array, 0);
+  block->AddInstruction(null_check);
+  HInstruction* length = new (&allocator) HArrayLength(null_check);
+  block->AddInstruction(length);
+  HBoundsCheck* first_check = new (&allocator) HBoundsCheck(index, length, 0);
+  block->AddInstruction(first_check);
+  HInstruction* array_get =
+      new (&allocator) HArrayGet(null_check, first_check, Primitive::kPrimInt);
+  block->AddInstruction(array_get);
+  null_check = new (&allocator) HNullCheck(array, 0);
+  block->AddInstruction(null_check);
+  length = new (&allocator) HArrayLength(null_check);
+  block->AddInstruction(length);
+  HBoundsCheck* second_check = new (&allocator) HBoundsCheck(index, length, 0);
+  block->AddInstruction(second_check);
+  HInstruction* array_set = new (&allocator) HArraySet(null_check, second_check, array_get, 0);
+  block->AddInstruction(array_set);
+  block->AddInstruction(new (&allocator) HReturnVoid());
+  entry->AddSuccessor(block);
+  HBasicBlock* exit = CreateBlock(graph, &allocator);
+  graph->SetExitBlock(exit);
+  exit->AddInstruction(new (&allocator) HExit());
+  block->AddSuccessor(exit);
+  graph->BuildDominatorTree();
+
+  HBoundsCheckElimination(graph).Run();
+  EXPECT_TRUE(first_check->IsInBlock());
+  EXPECT_FALSE(second_check->IsInBlock());
+  EXPECT_EQ(index, array_set->InputAt(1));
+}
+
+TEST(NullCheckEliminationTest, DominatingCheck) {
+  ArenaPool pool;
+  ArenaAllocator allocator(&pool);
+  HGraph* graph = new (&allocator) HGraph(&allocator);
+  HBoundsCheck* bounds_check = BuildArrayLoop(graph, &allocator, 1);
+  // The check of the loop body is dominated by the one of the loop header.
+  HInstruction* body_check = bounds_check->InputAt(1)->InputAt(0);
+  ASSERT_TRUE(body_check->IsNullCheck());
+
+  HNullCheckElimination(graph).Run();
+  EXPECT_FALSE(body_check->IsInBlock());
+  HInstruction* header_check = bounds_check->InputAt(1)->InputAt(0);
+  ASSERT_TRUE(header_check->IsNullCheck());
+  EXPECT_EQ(graph->GetEntryBlock()->GetSuccessors().Get(0), header_check->GetBlock());
+}
+
+}  // namespace art
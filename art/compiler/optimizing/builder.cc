@@ -31,6 +31,7 @@
 #include "primitive.h"
 #include "scoped_thread_state_change.h"
 #include "thread.h"
+#include "utils.h"
 
 namespace art {
 
@@ -65,8 +66,78 @@ class Temporaries : public ValueObject {
   size_t index_;
 };
 
-static bool IsTypeSupported(Primitive::Type type) {
-  return type != Primitive::kPrimFloat && type != Primitive::kPrimDouble;
+/**
+ * Helper class to read the payload of a packed-switch or sparse-switch. The targets are
+ * offsets relative to the switch instruction.
+ */
+class SwitchTable : public ValueObject {
+ public:
+  explicit SwitchTable(const Instruction& instruction)
+      : is_packed_(instruction.Opcode() == Instruction::PACKED_SWITCH) {
+    const uint16_t* payload =
+        reinterpret_cast<const uint16_t*>(&instruction) + instruction.VRegB_31t();
+    if (is_packed_) {
+      const Instruction::PackedSwitchPayload* table =
+          reinterpret_cast<const Instruction::PackedSwitchPayload*>(payload);
+      DCHECK_EQ(table->ident, static_cast<uint16_t>(Instruction::kPackedSwitchSignature));
+      num_entries_ = table->case_count;
+      first_key_ = table->first_key;
+      keys_ = nullptr;
+      targets_ = table->targets;
+    } else {
+      const Instruction::SparseSwitchPayload* table =
+          reinterpret_cast<const Instruction::SparseSwitchPayload*>(payload);
+      DCHECK_EQ(table->ident, static_cast<uint16_t>(Instruction::kSparseSwitchSignature));
+      num_entries_ = table->case_count;
+      first_key_ = 0;
+      keys_ = table->GetKeys();
+      targets_ = table->GetTargets();
+    }
+  }
+
+  size_t GetNumEntries() const { return num_entries_; }
+
+  int32_t GetKeyAt(size_t index) const {
+    DCHECK_LT(index, num_entries_);
+    return is_packed_ ? first_key_ + static_cast<int32_t>(index) : keys_[index];
+  }
+
+  int32_t GetTargetAt(size_t index) const {
+    DCHECK_LT(index, num_entries_);
+    return targets_[index];
+  }
+
+ private:
+  const bool is_packed_;
+  size_t num_entries_;
+
+  // The first key of a packed-switch, whose keys are consecutive.
+  int32_t first_key_;
+
+  // The keys of a sparse-switch.
+  const int32_t* keys_;
+
+  const int32_t* targets_;
+};
+
+static InvokeType GetInvokeTypeFromOpcode(Instruction::Code opcode) {
+  switch (opcode) {
+    case Instruction::INVOKE_STATIC:
+    case Instruction::INVOKE_STATIC_RANGE:
+      return kStatic;
+    case Instruction::INVOKE_DIRECT:
+    case Instruction::INVOKE_DIRECT_RANGE:
+      return kDirect;
+    case Instruction::INVOKE_VIRTUAL:
+    case Instruction::INVOKE_VIRTUAL_RANGE:
+      return kVirtual;
+    case Instruction::INVOKE_INTERFACE:
+    case Instruction::INVOKE_INTERFACE_RANGE:
+      return kInterface;
+    default:
+      LOG(FATAL) << "Unexpected invoke opcode " << opcode;
+      return kStatic;
+  }
 }
 
 void HGraphBuilder::InitializeLocals(uint16_t count) {
@@ -79,10 +150,10 @@ void HGraphBuilder::InitializeLocals(uint16_t count) {
   }
 }
 
-bool HGraphBuilder::InitializeParameters(uint16_t number_of_parameters) {
+void HGraphBuilder::InitializeParameters(uint16_t number_of_parameters) {
   // dex_compilation_unit_ is null only when unit testing.
   if (dex_compilation_unit_ == nullptr) {
-    return true;
+    return;
   }
 
   graph_->SetNumberOfInVRegs(number_of_parameters);
@@ -102,31 +173,19 @@ bool HGraphBuilder::InitializeParameters(uint16_t number_of_parameters) {
 
   uint32_t pos = 1;
   for (int i = 0; i < number_of_parameters; i++) {
-    switch (shorty[pos++]) {
-      case 'F':
-      case 'D': {
-        return false;
-      }
-
-      default: {
-        // integer and reference parameters.
-        HParameterValue* parameter =
-            new (arena_) HParameterValue(parameter_index++, Primitive::GetType(shorty[pos - 1]));
-        entry_block_->AddInstruction(parameter);
-        HLocal* local = GetLocalAt(locals_index++);
-        // Store the parameter value in the local that the dex code will use
-        // to reference that parameter.
-        entry_block_->AddInstruction(new (arena_) HStoreLocal(local, parameter));
-        if (parameter->GetType() == Primitive::kPrimLong) {
-          i++;
-          locals_index++;
-          parameter_index++;
-        }
-        break;
-      }
+    HParameterValue* parameter =
+        new (arena_) HParameterValue(parameter_index++, Primitive::GetType(shorty[pos++]));
+    entry_block_->AddInstruction(parameter);
+    HLocal* local = GetLocalAt(locals_index++);
+    // Store the parameter value in the local that the dex code will use
+    // to reference that parameter.
+    entry_block_->AddInstruction(new (arena_) HStoreLocal(local, parameter));
+    if (Primitive::Is64BitType(parameter->GetType())) {
+      i++;
+      locals_index++;
+      parameter_index++;
     }
   }
-  return true;
 }
 
 static bool CanHandleCodeItem(const DexFile::CodeItem& code_item) {
@@ -171,6 +230,7 @@ void HGraphBuilder::If_21t(const Instruction& instruction, uint32_t dex_offset)
 
 HGraph* HGraphBuilder::BuildGraph(const DexFile::CodeItem& code_item) {
   if (!CanHandleCodeItem(code_item)) {
+    MaybeRecordStat(MethodCompilationStat::kNotCompiledTryCatch);
     return nullptr;
   }
 
@@ -192,9 +252,7 @@ HGraph* HGraphBuilder::BuildGraph(const DexFile::CodeItem& code_item) {
   // start a new block, and create these blocks.
   ComputeBranchTargets(code_ptr, code_end);
 
-  if (!InitializeParameters(code_item.ins_size_)) {
-    return nullptr;
-  }
+  InitializeParameters(code_item.ins_size_);
 
   size_t dex_offset = 0;
   while (code_ptr < code_end) {
@@ -231,7 +289,6 @@ void HGraphBuilder::MaybeUpdateCurrentBlock(size_t index) {
 }
 
 void HGraphBuilder::ComputeBranchTargets(const uint16_t* code_ptr, const uint16_t* code_end) {
-  // TODO: Support switch instructions.
   branch_targets_.SetSize(code_end - code_ptr);
 
   // Create the first block for the dex instructions, single successor of the entry block.
@@ -257,6 +314,23 @@ void HGraphBuilder::ComputeBranchTargets(const uint16_t* code_ptr, const uint16_
         block = new (arena_) HBasicBlock(graph_);
         branch_targets_.Put(dex_offset, block);
       }
+    } else if (instruction.IsSwitch()) {
+      // Create a block for each case target, and one for the instruction following the
+      // switch, which is the default target.
+      SwitchTable table(instruction);
+      for (size_t i = 0, e = table.GetNumEntries(); i < e; ++i) {
+        int32_t target = table.GetTargetAt(i) + dex_offset;
+        if (FindBlockStartingAt(target) == nullptr) {
+          block = new (arena_) HBasicBlock(graph_);
+          branch_targets_.Put(target, block);
+        }
+      }
+      dex_offset += instruction.SizeInCodeUnits();
+      code_ptr += instruction.SizeInCodeUnits();
+      if ((code_ptr < code_end) && (FindBlockStartingAt(dex_offset) == nullptr)) {
+        block = new (arena_) HBasicBlock(graph_);
+        branch_targets_.Put(dex_offset, block);
+      }
     } else {
       code_ptr += instruction.SizeInCodeUnits();
       dex_offset += instruction.SizeInCodeUnits();
@@ -307,17 +381,102 @@ void HGraphBuilder::Binop_22b(const Instruction& instruction, bool reverse) {
   UpdateLocal(instruction.VRegA(), current_block_->GetLastInstruction());
 }
 
+void HGraphBuilder::Binop_23x_cmp(const Instruction& instruction,
+                                  Primitive::Type type,
+                                  HCompare::Bias bias) {
+  HInstruction* first = LoadLocal(instruction.VRegB(), type);
+  HInstruction* second = LoadLocal(instruction.VRegC(), type);
+  current_block_->AddInstruction(new (arena_) HCompare(type, first, second, bias));
+  UpdateLocal(instruction.VRegA(), current_block_->GetLastInstruction());
+}
+
+template<typename T>
+void HGraphBuilder::BuildIntDivOrRem(uint16_t out_vreg,
+                                     uint16_t first_vreg,
+                                     int32_t second_vreg_or_literal,
+                                     bool second_is_literal,
+                                     uint32_t dex_offset) {
+  HInstruction* first = LoadLocal(first_vreg, Primitive::kPrimInt);
+  HInstruction* second = second_is_literal
+      ? GetIntConstant(second_vreg_or_literal)
+      : LoadLocal(second_vreg_or_literal, Primitive::kPrimInt);
+  if (!second_is_literal || second_vreg_or_literal == 0) {
+    // The code generators move the inputs of the division to fixed registers: the checked
+    // divisor is kept in a temporary, so that moving the dividend cannot overwrite it.
+    Temporaries temps(graph_, 1);
+    second = new (arena_) HDivZeroCheck(second, dex_offset);
+    current_block_->AddInstruction(second);
+    temps.Add(second);
+  }
+  current_block_->AddInstruction(new (arena_) T(Primitive::kPrimInt, first, second));
+  UpdateLocal(out_vreg, current_block_->GetLastInstruction());
+}
+
+template<typename T>
+void HGraphBuilder::Unop_12x(const Instruction& instruction, Primitive::Type type) {
+  HInstruction* first = LoadLocal(instruction.VRegB(), type);
+  current_block_->AddInstruction(new (arena_) T(type, first));
+  UpdateLocal(instruction.VRegA(), current_block_->GetLastInstruction());
+}
+
+void HGraphBuilder::Conversion_12x(const Instruction& instruction,
+                                   Primitive::Type input_type,
+                                   Primitive::Type result_type) {
+  HInstruction* first = LoadLocal(instruction.VRegB(), input_type);
+  current_block_->AddInstruction(new (arena_) HTypeConversion(result_type, input_type, first));
+  UpdateLocal(instruction.VRegA(), current_block_->GetLastInstruction());
+}
+
 void HGraphBuilder::BuildReturn(const Instruction& instruction, Primitive::Type type) {
   if (type == Primitive::kPrimVoid) {
     current_block_->AddInstruction(new (arena_) HReturnVoid());
   } else {
     HInstruction* value = LoadLocal(instruction.VRegA(), type);
-    current_block_->AddInstruction(new (arena_) HReturn(value));
+    current_block_->AddInstruction(new (arena_) HReturn(value, type));
   }
   current_block_->AddSuccessor(exit_block_);
   current_block_ = nullptr;
 }
 
+Primitive::Type HGraphBuilder::GetReturnType(Primitive::Type type) const {
+  // dex_compilation_unit_ is null only when unit testing.
+  if (dex_compilation_unit_ == nullptr) {
+    return type;
+  }
+  return Primitive::GetType(dex_compilation_unit_->GetShorty()[0]);
+}
+
+void HGraphBuilder::BuildSwitch(const Instruction& instruction, uint32_t dex_offset) {
+  SwitchTable table(instruction);
+  HBasicBlock* default_target = FindBlockStartingAt(dex_offset + instruction.SizeInCodeUnits());
+  DCHECK(default_target != nullptr);
+
+  // Each comparison ends its block. When it fails, the next comparison is done in a new
+  // block, and the last one falls through to the default target.
+  for (size_t i = 0, e = table.GetNumEntries(); i < e; ++i) {
+    HInstruction* value = LoadLocal(instruction.VRegA_31t(), Primitive::kPrimInt);
+    HEqual* comparison = new (arena_) HEqual(value, GetIntConstant(table.GetKeyAt(i)));
+    current_block_->AddInstruction(comparison);
+    current_block_->AddInstruction(new (arena_) HIf(comparison));
+    HBasicBlock* case_target = FindBlockStartingAt(dex_offset + table.GetTargetAt(i));
+    DCHECK(case_target != nullptr);
+    current_block_->AddSuccessor(case_target);
+    HBasicBlock* next = default_target;
+    if (i != e - 1) {
+      next = new (arena_) HBasicBlock(graph_);
+      graph_->AddBlock(next);
+    }
+    current_block_->AddSuccessor(next);
+    current_block_ = next;
+  }
+
+  if (table.GetNumEntries() == 0) {
+    current_block_->AddInstruction(new (arena_) HGoto());
+    current_block_->AddSuccessor(default_target);
+  }
+  current_block_ = nullptr;
+}
+
 bool HGraphBuilder::BuildInvoke(const Instruction& instruction,
                                 uint32_t dex_offset,
                                 uint32_t method_idx,
@@ -329,14 +488,40 @@ bool HGraphBuilder::BuildInvoke(const Instruction& instruction,
   const DexFile::ProtoId& proto_id = dex_file_->GetProtoId(method_id.proto_idx_);
   const char* descriptor = dex_file_->StringDataByIdx(proto_id.shorty_idx_);
   Primitive::Type return_type = Primitive::GetType(descriptor[0]);
-  bool is_instance_call =
-      instruction.Opcode() != Instruction::INVOKE_STATIC
-      && instruction.Opcode() != Instruction::INVOKE_STATIC_RANGE;
+  InvokeType invoke_type = GetInvokeTypeFromOpcode(instruction.Opcode());
+  bool is_instance_call = invoke_type != kStatic;
   const size_t number_of_arguments = strlen(descriptor) - (is_instance_call ? 0 : 1);
 
-  // Treat invoke-direct like static calls for now.
-  HInvoke* invoke = new (arena_) HInvokeStatic(
-      arena_, number_of_arguments, return_type, dex_offset, method_idx);
+  HInvoke* invoke = nullptr;
+  if (invoke_type == kVirtual || invoke_type == kInterface) {
+    MethodReference target_method(dex_file_, method_idx);
+    uintptr_t direct_code;
+    uintptr_t direct_method;
+    int table_index;
+    InvokeType optimized_invoke_type = invoke_type;
+    // Do not devirtualize: the call goes through the tables of the class of the receiver,
+    // which only need the method to be resolved.
+    if (!compiler_driver_->ComputeInvokeInfo(dex_compilation_unit_, dex_offset, false, false,
+                                             &optimized_invoke_type, &target_method,
+                                             &table_index, &direct_code, &direct_method)) {
+      VLOG(compiler) << "Could not resolve " << PrettyMethod(method_idx, *dex_file_)
+                     << " called from " << dex_compilation_unit_->GetSymbol();
+      MaybeRecordStat(MethodCompilationStat::kNotCompiledUnresolvedMethod);
+      return false;
+    }
+    DCHECK_EQ(optimized_invoke_type, invoke_type);
+    if (invoke_type == kVirtual) {
+      invoke = new (arena_) HInvokeVirtual(
+          arena_, number_of_arguments, return_type, dex_offset, table_index);
+    } else {
+      invoke = new (arena_) HInvokeInterface(
+          arena_, number_of_arguments, return_type, dex_offset, method_idx, table_index);
+    }
+  } else {
+    // Treat invoke-direct like static calls for now.
+    invoke = new (arena_) HInvokeStatic(
+        arena_, number_of_arguments, return_type, dex_offset, method_idx);
+  }
 
   size_t start_index = 0;
   Temporaries temps(graph_, is_instance_call ? 1 : 0);
@@ -353,26 +538,21 @@ bool HGraphBuilder::BuildInvoke(const Instruction& instruction,
   uint32_t argument_index = start_index;
   for (size_t i = start_index; i < number_of_vreg_arguments; i++, argument_index++) {
     Primitive::Type type = Primitive::GetType(descriptor[descriptor_index++]);
-    if (!IsTypeSupported(type)) {
-      return false;
-    }
-    if (!is_range && type == Primitive::kPrimLong && args[i] + 1 != args[i + 1]) {
+    bool is_wide = Primitive::Is64BitType(type);
+    if (!is_range && is_wide && args[i] + 1 != args[i + 1]) {
       LOG(WARNING) << "Non sequential register pair in " << dex_compilation_unit_->GetSymbol()
                    << " at " << dex_offset;
       // We do not implement non sequential register pair.
+      MaybeRecordStat(MethodCompilationStat::kNotCompiledNonSequentialRegPair);
       return false;
     }
     HInstruction* arg = LoadLocal(is_range ? register_index + i : args[i], type);
     invoke->SetArgumentAt(argument_index, arg);
-    if (type == Primitive::kPrimLong) {
+    if (is_wide) {
       i++;
     }
   }
 
-  if (!IsTypeSupported(return_type)) {
-    return false;
-  }
-
   DCHECK_EQ(argument_index, number_of_arguments);
   current_block_->AddInstruction(invoke);
   return true;
@@ -391,16 +571,15 @@ bool HGraphBuilder::BuildFieldAccess(const Instruction& instruction,
       compiler_driver_->ComputeInstanceFieldInfo(field_index, dex_compilation_unit_, is_put, soa)));
 
   if (resolved_field.Get() == nullptr) {
+    MaybeRecordStat(MethodCompilationStat::kNotCompiledUnresolvedField);
     return false;
   }
   if (resolved_field->IsVolatile()) {
+    MaybeRecordStat(MethodCompilationStat::kNotCompiledVolatile);
     return false;
   }
 
   Primitive::Type field_type = resolved_field->GetTypeAsPrimitiveType();
-  if (!IsTypeSupported(field_type)) {
-    return false;
-  }
 
   HInstruction* object = LoadLocal(obj_reg, Primitive::kPrimNot);
   current_block_->AddInstruction(new (arena_) HNullCheck(object, dex_offset));
@@ -425,6 +604,26 @@ bool HGraphBuilder::BuildFieldAccess(const Instruction& instruction,
   return true;
 }
 
+void HGraphBuilder::BuildTypeCheck(const Instruction& instruction,
+                                   uint8_t destination_vreg,
+                                   uint8_t reference_vreg,
+                                   uint16_t type_index,
+                                   uint32_t dex_offset) {
+  // The class comes from the dex cache, unless its access has to be checked at run time.
+  bool can_access = compiler_driver_->CanAccessTypeWithoutChecks(
+      dex_compilation_unit_->GetDexMethodIndex(), *dex_file_, type_index);
+  HInstruction* object = LoadLocal(reference_vreg, Primitive::kPrimNot);
+  HLoadClass* load_class = new (arena_) HLoadClass(type_index, !can_access, dex_offset);
+  current_block_->AddInstruction(load_class);
+  if (instruction.Opcode() == Instruction::INSTANCE_OF) {
+    current_block_->AddInstruction(new (arena_) HInstanceOf(object, load_class, dex_offset));
+    UpdateLocal(destination_vreg, current_block_->GetLastInstruction());
+  } else {
+    DCHECK_EQ(instruction.Opcode(), Instruction::CHECK_CAST);
+    current_block_->AddInstruction(new (arena_) HCheckCast(object, load_class, dex_offset));
+  }
+}
+
 void HGraphBuilder::BuildArrayAccess(const Instruction& instruction,
                                      uint32_t dex_offset,
                                      bool is_put,
@@ -433,8 +632,6 @@ void HGraphBuilder::BuildArrayAccess(const Instruction& instruction,
   uint8_t array_reg = instruction.VRegB_23x();
   uint8_t index_reg = instruction.VRegC_23x();
 
-  DCHECK(IsTypeSupported(anticipated_type));
-
   // We need one temporary for the null check, one for the index, and one for the length.
   Temporaries temps(graph_, 3);
 
@@ -575,6 +772,12 @@ bool HGraphBuilder::AnalyzeDexInstruction(const Instruction& instruction, int32_
     IF_XX(HGreaterThan, GT);
     IF_XX(HGreaterThanOrEqual, GE);
 
+    case Instruction::PACKED_SWITCH:
+    case Instruction::SPARSE_SWITCH: {
+      BuildSwitch(instruction, dex_offset);
+      break;
+    }
+
     case Instruction::GOTO:
     case Instruction::GOTO_16:
     case Instruction::GOTO_32: {
@@ -587,7 +790,7 @@ bool HGraphBuilder::AnalyzeDexInstruction(const Instruction& instruction, int32_
     }
 
     case Instruction::RETURN: {
-      BuildReturn(instruction, Primitive::kPrimInt);
+      BuildReturn(instruction, GetReturnType(Primitive::kPrimInt));
       break;
     }
 
@@ -597,12 +800,14 @@ bool HGraphBuilder::AnalyzeDexInstruction(const Instruction& instruction, int32_
     }
 
     case Instruction::RETURN_WIDE: {
-      BuildReturn(instruction, Primitive::kPrimLong);
+      BuildReturn(instruction, GetReturnType(Primitive::kPrimLong));
       break;
     }
 
     case Instruction::INVOKE_STATIC:
-    case Instruction::INVOKE_DIRECT: {
+    case Instruction::INVOKE_DIRECT:
+    case Instruction::INVOKE_VIRTUAL:
+    case Instruction::INVOKE_INTERFACE: {
       uint32_t method_idx = instruction.VRegB_35c();
       uint32_t number_of_vreg_arguments = instruction.VRegA_35c();
       uint32_t args[5];
@@ -614,7 +819,9 @@ bool HGraphBuilder::AnalyzeDexInstruction(const Instruction& instruction, int32_
     }
 
     case Instruction::INVOKE_STATIC_RANGE:
-    case Instruction::INVOKE_DIRECT_RANGE: {
+    case Instruction::INVOKE_DIRECT_RANGE:
+    case Instruction::INVOKE_VIRTUAL_RANGE:
+    case Instruction::INVOKE_INTERFACE_RANGE: {
       uint32_t method_idx = instruction.VRegB_3rc();
       uint32_t number_of_vreg_arguments = instruction.VRegA_3rc();
       uint32_t register_index = instruction.VRegC();
@@ -665,11 +872,152 @@ bool HGraphBuilder::AnalyzeDexInstruction(const Instruction& instruction, int32_
       break;
     }
 
+    case Instruction::ADD_FLOAT: {
+      Binop_23x<HAdd>(instruction, Primitive::kPrimFloat);
+      break;
+    }
+
+    case Instruction::ADD_DOUBLE: {
+      Binop_23x<HAdd>(instruction, Primitive::kPrimDouble);
+      break;
+    }
+
+    case Instruction::SUB_FLOAT: {
+      Binop_23x<HSub>(instruction, Primitive::kPrimFloat);
+      break;
+    }
+
+    case Instruction::SUB_DOUBLE: {
+      Binop_23x<HSub>(instruction, Primitive::kPrimDouble);
+      break;
+    }
+
+    case Instruction::MUL_INT: {
+      Binop_23x<HMul>(instruction, Primitive::kPrimInt);
+      break;
+    }
+
+    case Instruction::MUL_LONG: {
+      Binop_23x<HMul>(instruction, Primitive::kPrimLong);
+      break;
+    }
+
+    case Instruction::MUL_FLOAT: {
+      Binop_23x<HMul>(instruction, Primitive::kPrimFloat);
+      break;
+    }
+
+    case Instruction::MUL_DOUBLE: {
+      Binop_23x<HMul>(instruction, Primitive::kPrimDouble);
+      break;
+    }
+
+    case Instruction::DIV_FLOAT: {
+      Binop_23x<HDiv>(instruction, Primitive::kPrimFloat);
+      break;
+    }
+
+    case Instruction::DIV_DOUBLE: {
+      Binop_23x<HDiv>(instruction, Primitive::kPrimDouble);
+      break;
+    }
+
+    case Instruction::DIV_INT: {
+      BuildIntDivOrRem<HDiv>(instruction.VRegA(), instruction.VRegB(), instruction.VRegC(),
+                             false, dex_offset);
+      break;
+    }
+
+    case Instruction::REM_INT: {
+      BuildIntDivOrRem<HRem>(instruction.VRegA(), instruction.VRegB(), instruction.VRegC(),
+                             false, dex_offset);
+      break;
+    }
+
+    case Instruction::ADD_FLOAT_2ADDR: {
+      Binop_12x<HAdd>(instruction, Primitive::kPrimFloat);
+      break;
+    }
+
+    case Instruction::ADD_DOUBLE_2ADDR: {
+      Binop_12x<HAdd>(instruction, Primitive::kPrimDouble);
+      break;
+    }
+
+    case Instruction::SUB_FLOAT_2ADDR: {
+      Binop_12x<HSub>(instruction, Primitive::kPrimFloat);
+      break;
+    }
+
+    case Instruction::SUB_DOUBLE_2ADDR: {
+      Binop_12x<HSub>(instruction, Primitive::kPrimDouble);
+      break;
+    }
+
+    case Instruction::MUL_INT_2ADDR: {
+      Binop_12x<HMul>(instruction, Primitive::kPrimInt);
+      break;
+    }
+
+    case Instruction::MUL_LONG_2ADDR: {
+      Binop_12x<HMul>(instruction, Primitive::kPrimLong);
+      break;
+    }
+
+    case Instruction::MUL_FLOAT_2ADDR: {
+      Binop_12x<HMul>(instruction, Primitive::kPrimFloat);
+      break;
+    }
+
+    case Instruction::MUL_DOUBLE_2ADDR: {
+      Binop_12x<HMul>(instruction, Primitive::kPrimDouble);
+      break;
+    }
+
+    case Instruction::DIV_FLOAT_2ADDR: {
+      Binop_12x<HDiv>(instruction, Primitive::kPrimFloat);
+      break;
+    }
+
+    case Instruction::DIV_DOUBLE_2ADDR: {
+      Binop_12x<HDiv>(instruction, Primitive::kPrimDouble);
+      break;
+    }
+
+    case Instruction::DIV_INT_2ADDR: {
+      BuildIntDivOrRem<HDiv>(instruction.VRegA(), instruction.VRegA(), instruction.VRegB(),
+                             false, dex_offset);
+      break;
+    }
+
+    case Instruction::REM_INT_2ADDR: {
+      BuildIntDivOrRem<HRem>(instruction.VRegA(), instruction.VRegA(), instruction.VRegB(),
+                             false, dex_offset);
+      break;
+    }
+
     case Instruction::ADD_INT_LIT16: {
       Binop_22s<HAdd>(instruction, false);
       break;
     }
 
+    case Instruction::MUL_INT_LIT16: {
+      Binop_22s<HMul>(instruction, false);
+      break;
+    }
+
+    case Instruction::DIV_INT_LIT16: {
+      BuildIntDivOrRem<HDiv>(instruction.VRegA(), instruction.VRegB(), instruction.VRegC_22s(),
+                             true, dex_offset);
+      break;
+    }
+
+    case Instruction::REM_INT_LIT16: {
+      BuildIntDivOrRem<HRem>(instruction.VRegA(), instruction.VRegB(), instruction.VRegC_22s(),
+                             true, dex_offset);
+      break;
+    }
+
     case Instruction::RSUB_INT: {
       Binop_22s<HSub>(instruction, true);
       break;
@@ -685,6 +1033,118 @@ bool HGraphBuilder::AnalyzeDexInstruction(const Instruction& instruction, int32_
       break;
     }
 
+    case Instruction::MUL_INT_LIT8: {
+      Binop_22b<HMul>(instruction, false);
+      break;
+    }
+
+    case Instruction::DIV_INT_LIT8: {
+      BuildIntDivOrRem<HDiv>(instruction.VRegA(), instruction.VRegB(), instruction.VRegC_22b(),
+                             true, dex_offset);
+      break;
+    }
+
+    case Instruction::REM_INT_LIT8: {
+      BuildIntDivOrRem<HRem>(instruction.VRegA(), instruction.VRegB(), instruction.VRegC_22b(),
+                             true, dex_offset);
+      break;
+    }
+
+    case Instruction::NEG_INT: {
+      Unop_12x<HNeg>(instruction, Primitive::kPrimInt);
+      break;
+    }
+
+    case Instruction::NEG_LONG: {
+      Unop_12x<HNeg>(instruction, Primitive::kPrimLong);
+      break;
+    }
+
+    case Instruction::NEG_FLOAT: {
+      Unop_12x<HNeg>(instruction, Primitive::kPrimFloat);
+      break;
+    }
+
+    case Instruction::NEG_DOUBLE: {
+      Unop_12x<HNeg>(instruction, Primitive::kPrimDouble);
+      break;
+    }
+
+    case Instruction::INT_TO_LONG: {
+      Conversion_12x(instruction, Primitive::kPrimInt, Primitive::kPrimLong);
+      break;
+    }
+
+    case Instruction::INT_TO_FLOAT: {
+      Conversion_12x(instruction, Primitive::kPrimInt, Primitive::kPrimFloat);
+      break;
+    }
+
+    case Instruction::INT_TO_DOUBLE: {
+      Conversion_12x(instruction, Primitive::kPrimInt, Primitive::kPrimDouble);
+      break;
+    }
+
+    case Instruction::LONG_TO_INT: {
+      Conversion_12x(instruction, Primitive::kPrimLong, Primitive::kPrimInt);
+      break;
+    }
+
+    case Instruction::LONG_TO_FLOAT: {
+      Conversion_12x(instruction, Primitive::kPrimLong, Primitive::kPrimFloat);
+      break;
+    }
+
+    case Instruction::LONG_TO_DOUBLE: {
+      Conversion_12x(instruction, Primitive::kPrimLong, Primitive::kPrimDouble);
+      break;
+    }
+
+    case Instruction::FLOAT_TO_INT: {
+      Conversion_12x(instruction, Primitive::kPrimFloat, Primitive::kPrimInt);
+      break;
+    }
+
+    case Instruction::FLOAT_TO_LONG: {
+      Conversion_12x(instruction, Primitive::kPrimFloat, Primitive::kPrimLong);
+      break;
+    }
+
+    case Instruction::FLOAT_TO_DOUBLE: {
+      Conversion_12x(instruction, Primitive::kPrimFloat, Primitive::kPrimDouble);
+      break;
+    }
+
+    case Instruction::DOUBLE_TO_INT: {
+      Conversion_12x(instruction, Primitive::kPrimDouble, Primitive::kPrimInt);
+      break;
+    }
+
+    case Instruction::DOUBLE_TO_LONG: {
+      Conversion_12x(instruction, Primitive::kPrimDouble, Primitive::kPrimLong);
+      break;
+    }
+
+    case Instruction::DOUBLE_TO_FLOAT: {
+      Conversion_12x(instruction, Primitive::kPrimDouble, Primitive::kPrimFloat);
+      break;
+    }
+
+    case Instruction::INT_TO_BYTE: {
+      Conversion_12x(instruction, Primitive::kPrimInt, Primitive::kPrimByte);
+      break;
+    }
+
+    case Instruction::INT_TO_CHAR: {
+      Conversion_12x(instruction, Primitive::kPrimInt, Primitive::kPrimChar);
+      break;
+    }
+
+    case Instruction::INT_TO_SHORT: {
+      Conversion_12x(instruction, Primitive::kPrimInt, Primitive::kPrimShort);
+      break;
+    }
+
     case Instruction::NEW_INSTANCE: {
       current_block_->AddInstruction(
           new (arena_) HNewInstance(dex_offset, instruction.VRegB_21c()));
@@ -692,6 +1152,18 @@ bool HGraphBuilder::AnalyzeDexInstruction(const Instruction& instruction, int32_
       break;
     }
 
+    case Instruction::INSTANCE_OF: {
+      BuildTypeCheck(instruction, instruction.VRegA_22c(), instruction.VRegB_22c(),
+                     instruction.VRegC_22c(), dex_offset);
+      break;
+    }
+
+    case Instruction::CHECK_CAST: {
+      BuildTypeCheck(instruction, 0, instruction.VRegA_21c(), instruction.VRegB_21c(),
+                     dex_offset);
+      break;
+    }
+
     case Instruction::MOVE_RESULT:
     case Instruction::MOVE_RESULT_WIDE:
     case Instruction::MOVE_RESULT_OBJECT:
@@ -699,7 +1171,27 @@ bool HGraphBuilder::AnalyzeDexInstruction(const Instruction& instruction, int32_
       break;
 
     case Instruction::CMP_LONG: {
-      Binop_23x<HCompare>(instruction, Primitive::kPrimLong);
+      Binop_23x_cmp(instruction, Primitive::kPrimLong, HCompare::kNoBias);
+      break;
+    }
+
+    case Instruction::CMPG_FLOAT: {
+      Binop_23x_cmp(instruction, Primitive::kPrimFloat, HCompare::kGtBias);
+      break;
+    }
+
+    case Instruction::CMPL_FLOAT: {
+      Binop_23x_cmp(instruction, Primitive::kPrimFloat, HCompare::kLtBias);
+      break;
+    }
+
+    case Instruction::CMPG_DOUBLE: {
+      Binop_23x_cmp(instruction, Primitive::kPrimDouble, HCompare::kGtBias);
+      break;
+    }
+
+    case Instruction::CMPL_DOUBLE: {
+      Binop_23x_cmp(instruction, Primitive::kPrimDouble, HCompare::kLtBias);
       break;
     }
 
@@ -751,6 +1243,8 @@ bool HGraphBuilder::AnalyzeDexInstruction(const Instruction& instruction, int32_
     ARRAY_XX(_SHORT, Primitive::kPrimShort);
 
     default:
+      VLOG(compiler) << "Unhandled instruction " << instruction.Name() << " at " << dex_offset;
+      MaybeRecordStat(MethodCompilationStat::kNotCompiledUnhandledInstruction);
       return false;
   }
   return true;
@@ -792,6 +1286,12 @@ HLongConstant* HGraphBuilder::GetLongConstant(int64_t constant) {
   return instruction;
 }
 
+void HGraphBuilder::MaybeRecordStat(MethodCompilationStat compilation_stat) {
+  if (compilation_stats_ != nullptr) {
+    compilation_stats_->RecordStat(compilation_stat);
+  }
+}
+
 HLocal* HGraphBuilder::GetLocalAt(int register_index) const {
   return locals_.Get(register_index);
 }
@@ -24,6 +24,7 @@
 #include "utils/allocation.h"
 #include "utils/growable_array.h"
 #include "nodes.h"
+#include "optimizing_compiler_stats.h"
 
 namespace art {
 
@@ -34,7 +35,8 @@ class HGraphBuilder : public ValueObject {
   HGraphBuilder(ArenaAllocator* arena,
                 DexCompilationUnit* dex_compilation_unit = nullptr,
                 const DexFile* dex_file = nullptr,
-                CompilerDriver* driver = nullptr)
+                CompilerDriver* driver = nullptr,
+                OptimizingCompilerStats* compiler_stats = nullptr)
       : arena_(arena),
         branch_targets_(arena, 0),
         locals_(arena, 0),
@@ -46,7 +48,8 @@ class HGraphBuilder : public ValueObject {
         constant1_(nullptr),
         dex_file_(dex_file),
         dex_compilation_unit_(dex_compilation_unit),
-        compiler_driver_(driver) {}
+        compiler_driver_(driver),
+        compilation_stats_(compiler_stats) {}
 
   HGraph* BuildGraph(const DexFile::CodeItem& code);
 
@@ -71,9 +74,7 @@ class HGraphBuilder : public ValueObject {
   void UpdateLocal(int register_index, HInstruction* instruction) const;
   HInstruction* LoadLocal(int register_index, Primitive::Type type) const;
 
-  // Temporarily returns whether the compiler supports the parameters
-  // of the method.
-  bool InitializeParameters(uint16_t number_of_parameters);
+  void InitializeParameters(uint16_t number_of_parameters);
 
   template<typename T>
   void Binop_23x(const Instruction& instruction, Primitive::Type type);
@@ -87,17 +88,51 @@ class HGraphBuilder : public ValueObject {
   template<typename T>
   void Binop_22s(const Instruction& instruction, bool reverse);
 
+  void Binop_23x_cmp(const Instruction& instruction, Primitive::Type type, HCompare::Bias bias);
+
+  // Builds an int division or remainder, whose divisor is checked against zero unless it
+  // is a non-zero literal.
+  template<typename T>
+  void BuildIntDivOrRem(uint16_t out_vreg,
+                        uint16_t first_vreg,
+                        int32_t second_vreg_or_literal,
+                        bool second_is_literal,
+                        uint32_t dex_offset);
+
+  template<typename T>
+  void Unop_12x(const Instruction& instruction, Primitive::Type type);
+
+  void Conversion_12x(const Instruction& instruction,
+                      Primitive::Type input_type,
+                      Primitive::Type result_type);
+
   template<typename T> void If_21t(const Instruction& instruction, uint32_t dex_offset);
   template<typename T> void If_22t(const Instruction& instruction, uint32_t dex_offset);
 
   void BuildReturn(const Instruction& instruction, Primitive::Type type);
 
+  // Returns the type returned by the method, or `type` when unit testing. The return
+  // instructions do not tell apart integral and floating-point values.
+  Primitive::Type GetReturnType(Primitive::Type type) const;
+
+  // Builds a chain of comparisons of the value of a packed-switch or sparse-switch
+  // with each of its case keys.
+  void BuildSwitch(const Instruction& instruction, uint32_t dex_offset);
+
   bool BuildFieldAccess(const Instruction& instruction, uint32_t dex_offset, bool is_get);
   void BuildArrayAccess(const Instruction& instruction,
                         uint32_t dex_offset,
                         bool is_get,
                         Primitive::Type anticipated_type);
 
+  // Builds an instance-of or a check-cast of the object in `reference_vreg`, which load
+  // the class of `type_index` first.
+  void BuildTypeCheck(const Instruction& instruction,
+                      uint8_t destination_vreg,
+                      uint8_t reference_vreg,
+                      uint16_t type_index,
+                      uint32_t dex_offset);
+
   // Builds an invocation node and returns whether the instruction is supported.
   bool BuildInvoke(const Instruction& instruction,
                    uint32_t dex_offset,
@@ -107,6 +142,8 @@ class HGraphBuilder : public ValueObject {
                    uint32_t* args,
                    uint32_t register_index);
 
+  void MaybeRecordStat(MethodCompilationStat compilation_stat);
+
   ArenaAllocator* const arena_;
 
   // A list of the size of the dex code holding block information for
@@ -128,6 +165,8 @@ class HGraphBuilder : public ValueObject {
   DexCompilationUnit* const dex_compilation_unit_;
   CompilerDriver* const compiler_driver_;
 
+  OptimizingCompilerStats* const compilation_stats_;
+
   DISALLOW_COPY_AND_ASSIGN(HGraphBuilder);
 };
 
@@ -17,6 +17,7 @@
 #include "code_generator.h"
 
 #include "code_generator_arm.h"
+#include "code_generator_arm64.h"
 #include "code_generator_x86.h"
 #include "code_generator_x86_64.h"
 #include "dex/verified_method.h"
@@ -24,6 +25,7 @@
 #include "gc_map_builder.h"
 #include "leb128.h"
 #include "mapping_table.h"
+#include "parallel_move_resolver.h"
 #include "utils/assembler.h"
 #include "verifier/dex_gc_map.h"
 #include "vmap_table.h"
@@ -35,6 +37,7 @@ void CodeGenerator::CompileBaseline(CodeAllocator* allocator, bool is_leaf) {
   DCHECK(blocks.Get(0) == GetGraph()->GetEntryBlock());
   DCHECK(GoesToNextBlock(GetGraph()->GetEntryBlock(), blocks.Get(1)));
   block_labels_.SetSize(blocks.Size());
+  Initialize();
 
   DCHECK_EQ(frame_size_, kUninitializedFrameSize);
   if (!is_leaf) {
@@ -48,7 +51,7 @@ void CodeGenerator::CompileBaseline(CodeAllocator* allocator, bool is_leaf) {
 
   for (size_t i = 0, e = blocks.Size(); i < e; ++i) {
     HBasicBlock* block = blocks.Get(i);
-    Bind(GetLabelOf(block));
+    Bind(block);
     HGraphVisitor* location_builder = GetLocationBuilder();
     HGraphVisitor* instruction_visitor = GetInstructionVisitor();
     for (HInstructionIterator it(block->GetInstructions()); !it.Done(); it.Advance()) {
@@ -59,6 +62,7 @@ void CodeGenerator::CompileBaseline(CodeAllocator* allocator, bool is_leaf) {
     }
   }
   GenerateSlowPaths();
+  GetAssembler()->EmitSlowPaths();
 
   size_t code_size = GetAssembler()->CodeSize();
   uint8_t* buffer = allocator->Allocate(code_size);
@@ -69,15 +73,17 @@ void CodeGenerator::CompileBaseline(CodeAllocator* allocator, bool is_leaf) {
 void CodeGenerator::CompileOptimized(CodeAllocator* allocator) {
   // The frame size has already been computed during register allocation.
   DCHECK_NE(frame_size_, kUninitializedFrameSize);
+  is_baseline_ = false;
   const GrowableArray<HBasicBlock*>& blocks = GetGraph()->GetBlocks();
   DCHECK(blocks.Get(0) == GetGraph()->GetEntryBlock());
   DCHECK(GoesToNextBlock(GetGraph()->GetEntryBlock(), blocks.Get(1)));
   block_labels_.SetSize(blocks.Size());
+  Initialize();
 
   GenerateFrameEntry();
   for (size_t i = 0, e = blocks.Size(); i < e; ++i) {
     HBasicBlock* block = blocks.Get(i);
-    Bind(GetLabelOf(block));
+    Bind(block);
     HGraphVisitor* instruction_visitor = GetInstructionVisitor();
     for (HInstructionIterator it(block->GetInstructions()); !it.Done(); it.Advance()) {
       HInstruction* current = it.Current();
@@ -85,6 +91,7 @@ void CodeGenerator::CompileOptimized(CodeAllocator* allocator) {
     }
   }
   GenerateSlowPaths();
+  GetAssembler()->EmitSlowPaths();
 
   size_t code_size = GetAssembler()->CodeSize();
   uint8_t* buffer = allocator->Allocate(code_size);
@@ -92,6 +99,13 @@ void CodeGenerator::CompileOptimized(CodeAllocator* allocator) {
   GetAssembler()->FinalizeInstructions(code);
 }
 
+void CodeGenerator::EmitParallelMoves(Location from1, Location to1, Location from2, Location to2) {
+  HParallelMove parallel_move(GetGraph()->GetArena());
+  parallel_move.AddMove(new (GetGraph()->GetArena()) MoveOperands(from1, to1));
+  parallel_move.AddMove(new (GetGraph()->GetArena()) MoveOperands(from2, to2));
+  GetMoveResolver()->EmitNativeCode(&parallel_move);
+}
+
 void CodeGenerator::GenerateSlowPaths() {
   for (size_t i = 0, e = slow_paths_.Size(); i < e; ++i) {
     slow_paths_.Get(i)->EmitNativeCode(this);
@@ -259,6 +273,9 @@ CodeGenerator* CodeGenerator::Create(ArenaAllocator* allocator,
     case kThumb2: {
       return new (allocator) arm::CodeGeneratorARM(graph);
     }
+    case kArm64: {
+      return new (allocator) arm64::CodeGeneratorARM64(graph);
+    }
     case kMips:
       return nullptr;
     case kX86: {
@@ -287,9 +304,17 @@ void CodeGenerator::BuildNativeGCMap(
   }
 
   GcMapBuilder builder(data, pc_infos_.Size(), max_native_offset, dex_gc_map.RegWidth());
+  // The stack slots of optimized code are spill slots, not dex registers: do not report
+  // any reference. The frame is only walked when one of its runtime calls throws, and the
+  // method has no catch handler, so its values are dead.
+  std::vector<uint8_t> no_references(dex_gc_map.RegWidth(), 0);
   for (size_t i = 0; i < pc_infos_.Size(); i++) {
     struct PcInfo pc_info = pc_infos_.Get(i);
     uint32_t native_offset = pc_info.native_pc;
+    if (!is_baseline_) {
+      builder.AddEntry(native_offset, no_references.data());
+      continue;
+    }
     uint32_t dex_pc = pc_info.dex_pc;
     const uint8_t* references = dex_gc_map.FindBitMap(dex_pc, false);
     CHECK(references != NULL) << "Missing ref for dex pc 0x" << std::hex << dex_pc;
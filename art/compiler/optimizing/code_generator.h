@@ -32,6 +32,7 @@ static size_t constexpr kUninitializedFrameSize = 0;
 
 class CodeGenerator;
 class DexCompilationUnit;
+class ParallelMoveResolver;
 
 class CodeAllocator {
  public:
@@ -90,7 +91,7 @@ class CodeGenerator : public ArenaObject {
 
   virtual void GenerateFrameEntry() = 0;
   virtual void GenerateFrameExit() = 0;
-  virtual void Bind(Label* label) = 0;
+  virtual void Bind(HBasicBlock* block) = 0;
   virtual void Move(HInstruction* instruction, Location location, HInstruction* move_for) = 0;
   virtual HGraphVisitor* GetLocationBuilder() = 0;
   virtual HGraphVisitor* GetInstructionVisitor() = 0;
@@ -112,6 +113,7 @@ class CodeGenerator : public ArenaObject {
   virtual void DumpCoreRegister(std::ostream& stream, int reg) const = 0;
   virtual void DumpFloatingPointRegister(std::ostream& stream, int reg) const = 0;
   virtual InstructionSet GetInstructionSet() const = 0;
+  virtual ParallelMoveResolver* GetMoveResolver() = 0;
 
   void RecordPcInfo(uint32_t dex_pc) {
     struct PcInfo pc_info;
@@ -126,6 +128,10 @@ class CodeGenerator : public ArenaObject {
 
   void GenerateSlowPaths();
 
+  // Emits the two moves as a parallel move, so that one destination can be the source of
+  // the other move. Used by slow paths that set up the arguments of a runtime call.
+  void EmitParallelMoves(Location from1, Location to1, Location from2, Location to2);
+
   void BuildMappingTable(std::vector<uint8_t>* vector) const;
   void BuildVMapTable(std::vector<uint8_t>* vector) const;
   void BuildNativeGCMap(
@@ -147,7 +153,8 @@ class CodeGenerator : public ArenaObject {
         pc_infos_(graph->GetArena(), 32),
         slow_paths_(graph->GetArena(), 8),
         blocked_registers_(graph->GetArena()->AllocArray<bool>(number_of_registers)),
-        is_leaf_(true) {}
+        is_leaf_(true),
+        is_baseline_(true) {}
   ~CodeGenerator() {}
 
   // Register allocation logic.
@@ -163,6 +170,10 @@ class CodeGenerator : public ArenaObject {
 
   virtual Location GetStackLocation(HLoadLocal* load) const = 0;
 
+  // Called once the blocks to compile are known, before any code is generated. Backends that
+  // don't use the labels of `block_labels_` set up their own here.
+  virtual void Initialize() {}
+
   // Frame size required for this method.
   uint32_t frame_size_;
   uint32_t core_spill_mask_;
@@ -182,6 +193,10 @@ class CodeGenerator : public ArenaObject {
 
   bool is_leaf_;
 
+  // Whether the dex registers live in their stack slots, as the GC map of the verifier
+  // expects. Optimized code only records pcs at which the method throws out of its frame.
+  bool is_baseline_;
+
   DISALLOW_COPY_AND_ASSIGN(CodeGenerator);
 };
 
@@ -20,6 +20,7 @@
 #include "gc/accounting/card_table.h"
 #include "mirror/array.h"
 #include "mirror/art_method.h"
+#include "mirror/class.h"
 #include "thread.h"
 #include "utils/assembler.h"
 #include "utils/arm/assembler_arm.h"
@@ -98,11 +99,14 @@ class BoundsCheckSlowPathARM : public SlowPathCode {
       : dex_pc_(dex_pc), index_location_(index_location), length_location_(length_location) {}
 
   virtual void EmitNativeCode(CodeGenerator* codegen) OVERRIDE {
-    CodeGeneratorARM* arm_codegen = reinterpret_cast<CodeGeneratorARM*>(codegen);
     __ Bind(GetEntryLabel());
     InvokeRuntimeCallingConvention calling_convention;
-    arm_codegen->Move32(ArmCoreLocation(calling_convention.GetRegisterAt(0)), index_location_);
-    arm_codegen->Move32(ArmCoreLocation(calling_convention.GetRegisterAt(1)), length_location_);
+    // We're moving two locations to locations that could overlap, so we need a parallel
+    // move resolver.
+    codegen->EmitParallelMoves(index_location_,
+                               ArmCoreLocation(calling_convention.GetRegisterAt(0)),
+                               length_location_,
+                               ArmCoreLocation(calling_convention.GetRegisterAt(1)));
     int32_t offset = QUICK_ENTRYPOINT_OFFSET(kArmWordSize, pThrowArrayBounds).Int32Value();
     __ ldr(LR, Address(TR, offset));
     __ blx(LR);
@@ -117,6 +121,82 @@ class BoundsCheckSlowPathARM : public SlowPathCode {
   DISALLOW_COPY_AND_ASSIGN(BoundsCheckSlowPathARM);
 };
 
+class DivZeroCheckSlowPathARM : public SlowPathCode {
+ public:
+  explicit DivZeroCheckSlowPathARM(uint32_t dex_pc) : dex_pc_(dex_pc) {}
+
+  virtual void EmitNativeCode(CodeGenerator* codegen) OVERRIDE {
+    __ Bind(GetEntryLabel());
+    int32_t offset = QUICK_ENTRYPOINT_OFFSET(kArmWordSize, pThrowDivZero).Int32Value();
+    __ ldr(LR, Address(TR, offset));
+    __ blx(LR);
+    codegen->RecordPcInfo(dex_pc_);
+  }
+
+ private:
+  const uint32_t dex_pc_;
+  DISALLOW_COPY_AND_ASSIGN(DivZeroCheckSlowPathARM);
+};
+
+// Resolves a class missing from the dex cache. The current method is already in the
+// second argument register, and the runtime returns the class in R0.
+class LoadClassSlowPathARM : public SlowPathCode {
+ public:
+  LoadClassSlowPathARM(uint16_t type_index, uint32_t dex_pc)
+      : type_index_(type_index), dex_pc_(dex_pc) {}
+
+  virtual void EmitNativeCode(CodeGenerator* codegen) OVERRIDE {
+    __ Bind(GetEntryLabel());
+    InvokeRuntimeCallingConvention calling_convention;
+    __ LoadImmediate(calling_convention.GetRegisterAt(0), type_index_);
+    int32_t offset = QUICK_ENTRYPOINT_OFFSET(kArmWordSize, pInitializeType).Int32Value();
+    __ ldr(LR, Address(TR, offset));
+    __ blx(LR);
+    codegen->RecordPcInfo(dex_pc_);
+    __ b(GetExitLabel());
+  }
+
+ private:
+  const uint16_t type_index_;
+  const uint32_t dex_pc_;
+
+  DISALLOW_COPY_AND_ASSIGN(LoadClassSlowPathARM);
+};
+
+// Calls the runtime for the instanceof or check-cast whose class did not match the class
+// of the object exactly. The class of the object is already in the second argument register.
+class TypeCheckSlowPathARM : public SlowPathCode {
+ public:
+  TypeCheckSlowPathARM(HInstruction* instruction, Location class_location)
+      : instruction_(instruction), class_location_(class_location) {}
+
+  virtual void EmitNativeCode(CodeGenerator* codegen) OVERRIDE {
+    __ Bind(GetEntryLabel());
+    InvokeRuntimeCallingConvention calling_convention;
+    __ mov(calling_convention.GetRegisterAt(0),
+           ShifterOperand(class_location_.AsArm().AsCoreRegister()));
+    if (instruction_->IsInstanceOf()) {
+      int32_t offset =
+          QUICK_ENTRYPOINT_OFFSET(kArmWordSize, pInstanceofNonTrivial).Int32Value();
+      __ ldr(LR, Address(TR, offset));
+      __ blx(LR);
+    } else {
+      DCHECK(instruction_->IsCheckCast());
+      int32_t offset = QUICK_ENTRYPOINT_OFFSET(kArmWordSize, pCheckCast).Int32Value();
+      __ ldr(LR, Address(TR, offset));
+      __ blx(LR);
+      codegen->RecordPcInfo(instruction_->AsCheckCast()->GetDexPc());
+    }
+    __ b(GetExitLabel());
+  }
+
+ private:
+  HInstruction* const instruction_;
+  const Location class_location_;
+
+  DISALLOW_COPY_AND_ASSIGN(TypeCheckSlowPathARM);
+};
+
 #undef __
 #define __ reinterpret_cast<ArmAssembler*>(GetAssembler())->
 
@@ -174,7 +254,8 @@ static bool* GetBlockedRegisterPairs(bool* blocked_registers) {
 ManagedRegister CodeGeneratorARM::AllocateFreeRegister(Primitive::Type type,
                                                        bool* blocked_registers) const {
   switch (type) {
-    case Primitive::kPrimLong: {
+    case Primitive::kPrimLong:
+    case Primitive::kPrimDouble: {
       bool* blocked_register_pairs = GetBlockedRegisterPairs(blocked_registers);
       size_t reg = AllocateFreeRegisterInternal(blocked_register_pairs, kNumberOfRegisterPairs);
       ArmManagedRegister pair =
@@ -200,7 +281,8 @@ ManagedRegister CodeGeneratorARM::AllocateFreeRegister(Primitive::Type type,
     case Primitive::kPrimChar:
     case Primitive::kPrimShort:
     case Primitive::kPrimInt:
-    case Primitive::kPrimNot: {
+    case Primitive::kPrimNot:
+    case Primitive::kPrimFloat: {
       int reg = AllocateFreeRegisterInternal(blocked_registers, kNumberOfCoreRegisters);
       // Block all register pairs that contain `reg`.
       bool* blocked_register_pairs = GetBlockedRegisterPairs(blocked_registers);
@@ -214,10 +296,6 @@ ManagedRegister CodeGeneratorARM::AllocateFreeRegister(Primitive::Type type,
       return ArmManagedRegister::FromCoreRegister(static_cast<Register>(reg));
     }
 
-    case Primitive::kPrimFloat:
-    case Primitive::kPrimDouble:
-      LOG(FATAL) << "Unimplemented register type " << type;
-
     case Primitive::kPrimVoid:
       LOG(FATAL) << "Unreachable type " << type;
   }
@@ -294,23 +372,21 @@ void CodeGeneratorARM::GenerateFrameExit() {
   __ PopList(1 << PC | 1 << R6 | 1 << R7);
 }
 
-void CodeGeneratorARM::Bind(Label* label) {
-  __ Bind(label);
+void CodeGeneratorARM::Bind(HBasicBlock* block) {
+  __ Bind(GetLabelOf(block));
 }
 
 Location CodeGeneratorARM::GetStackLocation(HLoadLocal* load) const {
   switch (load->GetType()) {
     case Primitive::kPrimLong:
+    case Primitive::kPrimDouble:
       return Location::DoubleStackSlot(GetStackSlot(load->GetLocal()));
       break;
 
     case Primitive::kPrimInt:
     case Primitive::kPrimNot:
-      return Location::StackSlot(GetStackSlot(load->GetLocal()));
-
     case Primitive::kPrimFloat:
-    case Primitive::kPrimDouble:
-      LOG(FATAL) << "Unimplemented type " << load->GetType();
+      return Location::StackSlot(GetStackSlot(load->GetLocal()));
 
     case Primitive::kPrimBoolean:
     case Primitive::kPrimByte:
@@ -331,7 +407,8 @@ Location InvokeDexCallingConventionVisitor::GetNextLocation(Primitive::Type type
     case Primitive::kPrimChar:
     case Primitive::kPrimShort:
     case Primitive::kPrimInt:
-    case Primitive::kPrimNot: {
+    case Primitive::kPrimNot:
+    case Primitive::kPrimFloat: {
       uint32_t index = gp_index_++;
       if (index < calling_convention.GetNumberOfRegisters()) {
         return ArmCoreLocation(calling_convention.GetRegisterAt(index));
@@ -340,7 +417,10 @@ Location InvokeDexCallingConventionVisitor::GetNextLocation(Primitive::Type type
       }
     }
 
-    case Primitive::kPrimLong: {
+    // The calling convention is soft-float: float and double arguments are passed in
+    // core registers, like int and long ones.
+    case Primitive::kPrimLong:
+    case Primitive::kPrimDouble: {
       uint32_t index = gp_index_;
       gp_index_ += 2;
       if (index + 1 < calling_convention.GetNumberOfRegisters()) {
@@ -353,11 +433,6 @@ Location InvokeDexCallingConventionVisitor::GetNextLocation(Primitive::Type type
       }
     }
 
-    case Primitive::kPrimDouble:
-    case Primitive::kPrimFloat:
-      LOG(FATAL) << "Unimplemented parameter type " << type;
-      break;
-
     case Primitive::kPrimVoid:
       LOG(FATAL) << "Unexpected parameter type " << type;
       break;
@@ -488,10 +563,12 @@ void CodeGeneratorARM::Move(HInstruction* instruction, Location location, HInstr
       case Primitive::kPrimShort:
       case Primitive::kPrimInt:
       case Primitive::kPrimNot:
+      case Primitive::kPrimFloat:
         Move32(location, Location::StackSlot(stack_slot));
         break;
 
       case Primitive::kPrimLong:
+      case Primitive::kPrimDouble:
         Move64(location, Location::DoubleStackSlot(stack_slot));
         break;
 
@@ -507,10 +584,12 @@ void CodeGeneratorARM::Move(HInstruction* instruction, Location location, HInstr
       case Primitive::kPrimShort:
       case Primitive::kPrimNot:
       case Primitive::kPrimInt:
+      case Primitive::kPrimFloat:
         Move32(location, locations->Out());
         break;
 
       case Primitive::kPrimLong:
+      case Primitive::kPrimDouble:
         Move64(location, locations->Out());
         break;
 
@@ -547,45 +626,63 @@ void InstructionCodeGeneratorARM::VisitExit(HExit* exit) {
 void LocationsBuilderARM::VisitIf(HIf* if_instr) {
   LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(if_instr);
   HInstruction* cond = if_instr->InputAt(0);
-  DCHECK(cond->IsCondition());
-  HCondition* condition = cond->AsCondition();
-  if (condition->NeedsMaterialization()) {
-    locations->SetInAt(0, Location::Any());
+  if (cond->IsIntConstant()) {
+    // A condition folded to a constant: the branch taken is known.
+    locations->SetInAt(0, Location::ConstantLocation(cond->AsConstant()));
+  } else {
+    DCHECK(cond->IsCondition());
+    HCondition* condition = cond->AsCondition();
+    if (condition->NeedsMaterialization()) {
+      locations->SetInAt(0, Location::Any());
+    }
   }
   if_instr->SetLocations(locations);
 }
 
 void InstructionCodeGeneratorARM::VisitIf(HIf* if_instr) {
   HInstruction* cond = if_instr->InputAt(0);
-  DCHECK(cond->IsCondition());
-  HCondition* condition = cond->AsCondition();
-  if (condition->NeedsMaterialization()) {
-    // Condition has been materialized, compare the output to 0
-    DCHECK(if_instr->GetLocations()->InAt(0).IsRegister());
-    __ cmp(if_instr->GetLocations()->InAt(0).AsArm().AsCoreRegister(),
-           ShifterOperand(0));
-    __ b(codegen_->GetLabelOf(if_instr->IfTrueSuccessor()), EQ);
+  if (cond->IsIntConstant()) {
+    // The condition was folded to 0 or 1.
+    int32_t cond_value = cond->AsIntConstant()->GetValue();
+    if (cond_value == 1) {
+      if (!codegen_->GoesToNextBlock(if_instr->GetBlock(), if_instr->IfTrueSuccessor())) {
+        __ b(codegen_->GetLabelOf(if_instr->IfTrueSuccessor()));
+      }
+      return;
+    } else {
+      DCHECK_EQ(cond_value, 0);
+    }
   } else {
-    // Condition has not been materialized, use its inputs as the comparison and its
-    // condition as the branch condition.
-    LocationSummary* locations = condition->GetLocations();
-    if (locations->InAt(1).IsRegister()) {
-      __ cmp(locations->InAt(0).AsArm().AsCoreRegister(),
-             ShifterOperand(locations->InAt(1).AsArm().AsCoreRegister()));
+    DCHECK(cond->IsCondition());
+    HCondition* condition = cond->AsCondition();
+    if (condition->NeedsMaterialization()) {
+      // Condition has been materialized, compare the output to 0
+      DCHECK(if_instr->GetLocations()->InAt(0).IsRegister());
+      __ cmp(if_instr->GetLocations()->InAt(0).AsArm().AsCoreRegister(),
+             ShifterOperand(0));
+      __ b(codegen_->GetLabelOf(if_instr->IfTrueSuccessor()), EQ);
     } else {
-      DCHECK(locations->InAt(1).IsConstant());
-      int32_t value = locations->InAt(1).GetConstant()->AsIntConstant()->GetValue();
-      ShifterOperand operand;
-      if (ShifterOperand::CanHoldArm(value, &operand)) {
-        __ cmp(locations->InAt(0).AsArm().AsCoreRegister(), ShifterOperand(value));
+      // Condition has not been materialized, use its inputs as the comparison and its
+      // condition as the branch condition.
+      LocationSummary* locations = condition->GetLocations();
+      if (locations->InAt(1).IsRegister()) {
+        __ cmp(locations->InAt(0).AsArm().AsCoreRegister(),
+               ShifterOperand(locations->InAt(1).AsArm().AsCoreRegister()));
       } else {
-        Register temp = IP;
-        __ LoadImmediate(temp, value);
-        __ cmp(locations->InAt(0).AsArm().AsCoreRegister(), ShifterOperand(temp));
+        DCHECK(locations->InAt(1).IsConstant());
+        int32_t value = locations->InAt(1).GetConstant()->AsIntConstant()->GetValue();
+        ShifterOperand operand;
+        if (ShifterOperand::CanHoldArm(value, &operand)) {
+          __ cmp(locations->InAt(0).AsArm().AsCoreRegister(), ShifterOperand(value));
+        } else {
+          Register temp = IP;
+          __ LoadImmediate(temp, value);
+          __ cmp(locations->InAt(0).AsArm().AsCoreRegister(), ShifterOperand(temp));
+        }
       }
+      __ b(codegen_->GetLabelOf(if_instr->IfTrueSuccessor()),
+           ARMCondition(condition->GetCondition()));
     }
-    __ b(codegen_->GetLabelOf(if_instr->IfTrueSuccessor()),
-         ARMCondition(condition->GetCondition()));
   }
 
   if (!codegen_->GoesToNextBlock(if_instr->GetBlock(), if_instr->IfFalseSuccessor())) {
@@ -703,10 +800,12 @@ void LocationsBuilderARM::VisitStoreLocal(HStoreLocal* store) {
     case Primitive::kPrimShort:
     case Primitive::kPrimInt:
     case Primitive::kPrimNot:
+    case Primitive::kPrimFloat:
       locations->SetInAt(1, Location::StackSlot(codegen_->GetStackSlot(store->GetLocal())));
       break;
 
     case Primitive::kPrimLong:
+    case Primitive::kPrimDouble:
       locations->SetInAt(1, Location::DoubleStackSlot(codegen_->GetStackSlot(store->GetLocal())));
       break;
 
@@ -755,10 +854,12 @@ void LocationsBuilderARM::VisitReturn(HReturn* ret) {
     case Primitive::kPrimShort:
     case Primitive::kPrimInt:
     case Primitive::kPrimNot:
+    case Primitive::kPrimFloat:
       locations->SetInAt(0, ArmCoreLocation(R0));
       break;
 
     case Primitive::kPrimLong:
+    case Primitive::kPrimDouble:
       locations->SetInAt(
           0, Location::RegisterLocation(ArmManagedRegister::FromRegisterPair(R0_R1)));
       break;
@@ -779,10 +880,12 @@ void InstructionCodeGeneratorARM::VisitReturn(HReturn* ret) {
       case Primitive::kPrimShort:
       case Primitive::kPrimInt:
       case Primitive::kPrimNot:
+      case Primitive::kPrimFloat:
         DCHECK_EQ(ret->GetLocations()->InAt(0).AsArm().AsCoreRegister(), R0);
         break;
 
       case Primitive::kPrimLong:
+      case Primitive::kPrimDouble:
         DCHECK_EQ(ret->GetLocations()->InAt(0).AsArm().AsRegisterPair(), R0_R1);
         break;
 
@@ -794,6 +897,18 @@ void InstructionCodeGeneratorARM::VisitReturn(HReturn* ret) {
 }
 
 void LocationsBuilderARM::VisitInvokeStatic(HInvokeStatic* invoke) {
+  HandleInvoke(invoke);
+}
+
+void LocationsBuilderARM::VisitInvokeVirtual(HInvokeVirtual* invoke) {
+  HandleInvoke(invoke);
+}
+
+void LocationsBuilderARM::VisitInvokeInterface(HInvokeInterface* invoke) {
+  HandleInvoke(invoke);
+}
+
+void LocationsBuilderARM::HandleInvoke(HInvoke* invoke) {
   codegen_->MarkNotLeaf();
   LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(invoke);
   locations->AddTemp(ArmCoreLocation(R0));
@@ -811,20 +926,17 @@ void LocationsBuilderARM::VisitInvokeStatic(HInvokeStatic* invoke) {
     case Primitive::kPrimShort:
     case Primitive::kPrimInt:
     case Primitive::kPrimNot:
+    case Primitive::kPrimFloat:
       locations->SetOut(ArmCoreLocation(R0));
       break;
 
     case Primitive::kPrimLong:
+    case Primitive::kPrimDouble:
       locations->SetOut(Location::RegisterLocation(ArmManagedRegister::FromRegisterPair(R0_R1)));
       break;
 
     case Primitive::kPrimVoid:
       break;
-
-    case Primitive::kPrimDouble:
-    case Primitive::kPrimFloat:
-      LOG(FATAL) << "Unimplemented return type " << invoke->GetType();
-      break;
   }
 
   invoke->SetLocations(locations);
@@ -863,6 +975,52 @@ void InstructionCodeGeneratorARM::VisitInvokeStatic(HInvokeStatic* invoke) {
   DCHECK(!codegen_->IsLeafMethod());
 }
 
+void InstructionCodeGeneratorARM::VisitInvokeVirtual(HInvokeVirtual* invoke) {
+  LocationSummary* locations = invoke->GetLocations();
+  Register temp = locations->GetTemp(0).AsArm().AsCoreRegister();
+  // The receiver is the first argument, which is always passed in a register.
+  Register receiver = locations->InAt(0).AsArm().AsCoreRegister();
+  uint32_t method_offset = mirror::Class::EmbeddedVTableOffset().Uint32Value() +
+      invoke->GetVTableIndex() * sizeof(mirror::Class::VTableEntry);
+
+  // temp = receiver->klass_;
+  __ LoadFromOffset(kLoadWord, temp, receiver, mirror::Object::ClassOffset().Int32Value());
+  // temp = temp->embedded_vtable_[vtable_index];
+  __ LoadFromOffset(kLoadWord, temp, temp, method_offset);
+  // LR = temp[offset_of_quick_compiled_code]
+  __ ldr(LR, Address(temp, mirror::ArtMethod::EntryPointFromQuickCompiledCodeOffset(
+      kArmPointerSize).Int32Value()));
+  // LR()
+  __ blx(LR);
+
+  codegen_->RecordPcInfo(invoke->GetDexPc());
+  DCHECK(!codegen_->IsLeafMethod());
+}
+
+void InstructionCodeGeneratorARM::VisitInvokeInterface(HInvokeInterface* invoke) {
+  LocationSummary* locations = invoke->GetLocations();
+  Register temp = locations->GetTemp(0).AsArm().AsCoreRegister();
+  Register receiver = locations->InAt(0).AsArm().AsCoreRegister();
+  uint32_t method_offset = mirror::Class::EmbeddedImTableOffset().Uint32Value() +
+      (invoke->GetImtIndex() % mirror::Class::kImtSize) * sizeof(mirror::Class::ImTableEntry);
+
+  // temp = receiver->klass_;
+  __ LoadFromOffset(kLoadWord, temp, receiver, mirror::Object::ClassOffset().Int32Value());
+  // temp = temp->embedded_imtable_[imt_index];
+  __ LoadFromOffset(kLoadWord, temp, temp, method_offset);
+  // The IMT conflict trampoline expects the dex method index in IP. Set it last, as
+  // the loads above may use IP for large offsets.
+  __ LoadImmediate(IP, invoke->GetDexMethodIndex());
+  // LR = temp[offset_of_quick_compiled_code]
+  __ ldr(LR, Address(temp, mirror::ArtMethod::EntryPointFromQuickCompiledCodeOffset(
+      kArmPointerSize).Int32Value()));
+  // LR()
+  __ blx(LR);
+
+  codegen_->RecordPcInfo(invoke->GetDexPc());
+  DCHECK(!codegen_->IsLeafMethod());
+}
+
 void LocationsBuilderARM::VisitAdd(HAdd* add) {
   LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(add);
   switch (add->GetResultType()) {
@@ -874,6 +1032,14 @@ void LocationsBuilderARM::VisitAdd(HAdd* add) {
       break;
     }
 
+    case Primitive::kPrimFloat:
+    case Primitive::kPrimDouble: {
+      locations->SetInAt(0, Location::RequiresRegister());
+      locations->SetInAt(1, Location::RequiresRegister());
+      locations->SetOut(Location::RequiresRegister());
+      break;
+    }
+
     case Primitive::kPrimBoolean:
     case Primitive::kPrimByte:
     case Primitive::kPrimChar:
@@ -911,6 +1077,23 @@ void InstructionCodeGeneratorARM::VisitAdd(HAdd* add) {
              ShifterOperand(locations->InAt(1).AsArm().AsRegisterPairHigh()));
       break;
 
+    case Primitive::kPrimFloat:
+      __ vmovsr(S0, locations->InAt(0).AsArm().AsCoreRegister());
+      __ vmovsr(S1, locations->InAt(1).AsArm().AsCoreRegister());
+      __ vadds(S0, S0, S1);
+      __ vmovrs(locations->Out().AsArm().AsCoreRegister(), S0);
+      break;
+
+    case Primitive::kPrimDouble:
+      __ vmovdrr(D0, locations->InAt(0).AsArm().AsRegisterPairLow(),
+                 locations->InAt(0).AsArm().AsRegisterPairHigh());
+      __ vmovdrr(D1, locations->InAt(1).AsArm().AsRegisterPairLow(),
+                 locations->InAt(1).AsArm().AsRegisterPairHigh());
+      __ vaddd(D0, D0, D1);
+      __ vmovrrd(locations->Out().AsArm().AsRegisterPairLow(),
+                 locations->Out().AsArm().AsRegisterPairHigh(), D0);
+      break;
+
     case Primitive::kPrimBoolean:
     case Primitive::kPrimByte:
     case Primitive::kPrimChar:
@@ -934,6 +1117,14 @@ void LocationsBuilderARM::VisitSub(HSub* sub) {
       break;
     }
 
+    case Primitive::kPrimFloat:
+    case Primitive::kPrimDouble: {
+      locations->SetInAt(0, Location::RequiresRegister());
+      locations->SetInAt(1, Location::RequiresRegister());
+      locations->SetOut(Location::RequiresRegister());
+      break;
+    }
+
     case Primitive::kPrimBoolean:
     case Primitive::kPrimByte:
     case Primitive::kPrimChar:
@@ -972,6 +1163,23 @@ void InstructionCodeGeneratorARM::VisitSub(HSub* sub) {
              ShifterOperand(locations->InAt(1).AsArm().AsRegisterPairHigh()));
       break;
 
+    case Primitive::kPrimFloat:
+      __ vmovsr(S0, locations->InAt(0).AsArm().AsCoreRegister());
+      __ vmovsr(S1, locations->InAt(1).AsArm().AsCoreRegister());
+      __ vsubs(S0, S0, S1);
+      __ vmovrs(locations->Out().AsArm().AsCoreRegister(), S0);
+      break;
+
+    case Primitive::kPrimDouble:
+      __ vmovdrr(D0, locations->InAt(0).AsArm().AsRegisterPairLow(),
+                 locations->InAt(0).AsArm().AsRegisterPairHigh());
+      __ vmovdrr(D1, locations->InAt(1).AsArm().AsRegisterPairLow(),
+                 locations->InAt(1).AsArm().AsRegisterPairHigh());
+      __ vsubd(D0, D0, D1);
+      __ vmovrrd(locations->Out().AsArm().AsRegisterPairLow(),
+                 locations->Out().AsArm().AsRegisterPairHigh(), D0);
+      break;
+
     case Primitive::kPrimBoolean:
     case Primitive::kPrimByte:
     case Primitive::kPrimChar:
@@ -984,6 +1192,341 @@ void InstructionCodeGeneratorARM::VisitSub(HSub* sub) {
   }
 }
 
+void LocationsBuilderARM::VisitMul(HMul* mul) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(mul);
+  switch (mul->GetResultType()) {
+    case Primitive::kPrimInt:
+    case Primitive::kPrimLong:
+    case Primitive::kPrimFloat:
+    case Primitive::kPrimDouble: {
+      locations->SetInAt(0, Location::RequiresRegister());
+      locations->SetInAt(1, Location::RequiresRegister());
+      locations->SetOut(Location::RequiresRegister());
+      break;
+    }
+
+    default:
+      LOG(FATAL) << "Unexpected mul type " << mul->GetResultType();
+  }
+  mul->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorARM::VisitMul(HMul* mul) {
+  LocationSummary* locations = mul->GetLocations();
+  switch (mul->GetResultType()) {
+    case Primitive::kPrimInt:
+      __ mul(locations->Out().AsArm().AsCoreRegister(),
+             locations->InAt(0).AsArm().AsCoreRegister(),
+             locations->InAt(1).AsArm().AsCoreRegister());
+      break;
+
+    case Primitive::kPrimLong: {
+      ArmManagedRegister left = locations->InAt(0).AsArm();
+      ArmManagedRegister right = locations->InAt(1).AsArm();
+      ArmManagedRegister out = locations->Out().AsArm();
+      // IP = left.lo * right.hi + left.hi * right.lo
+      __ mul(IP, left.AsRegisterPairLow(), right.AsRegisterPairHigh());
+      __ mla(IP, left.AsRegisterPairHigh(), right.AsRegisterPairLow(), IP);
+      // out = left.lo * right.lo, out.hi += IP
+      __ umull(out.AsRegisterPairLow(), out.AsRegisterPairHigh(),
+               left.AsRegisterPairLow(), right.AsRegisterPairLow());
+      __ add(out.AsRegisterPairHigh(), out.AsRegisterPairHigh(), ShifterOperand(IP));
+      break;
+    }
+
+    case Primitive::kPrimFloat:
+      __ vmovsr(S0, locations->InAt(0).AsArm().AsCoreRegister());
+      __ vmovsr(S1, locations->InAt(1).AsArm().AsCoreRegister());
+      __ vmuls(S0, S0, S1);
+      __ vmovrs(locations->Out().AsArm().AsCoreRegister(), S0);
+      break;
+
+    case Primitive::kPrimDouble:
+      __ vmovdrr(D0, locations->InAt(0).AsArm().AsRegisterPairLow(),
+                 locations->InAt(0).AsArm().AsRegisterPairHigh());
+      __ vmovdrr(D1, locations->InAt(1).AsArm().AsRegisterPairLow(),
+                 locations->InAt(1).AsArm().AsRegisterPairHigh());
+      __ vmuld(D0, D0, D1);
+      __ vmovrrd(locations->Out().AsArm().AsRegisterPairLow(),
+                 locations->Out().AsArm().AsRegisterPairHigh(), D0);
+      break;
+
+    default:
+      LOG(FATAL) << "Unexpected mul type " << mul->GetResultType();
+  }
+}
+
+// Integer divisions call __aeabi_idivmod, like the Quick compiler: not all ARM cores have
+// a divide instruction. It takes its operands in R0 and R1, and returns the quotient in R0
+// and the remainder in R1. It does not throw, nor suspend.
+static void SetIntDivOrRemLocations(LocationSummary* locations, bool is_div) {
+  InvokeRuntimeCallingConvention calling_convention;
+  locations->SetInAt(0, ArmCoreLocation(calling_convention.GetRegisterAt(0)));
+  locations->SetInAt(1, ArmCoreLocation(calling_convention.GetRegisterAt(1)));
+  locations->SetOut(ArmCoreLocation(is_div ? R0 : R1));
+}
+
+void InstructionCodeGeneratorARM::GenerateIntDivOrRem() {
+  int32_t offset = QUICK_ENTRYPOINT_OFFSET(kArmWordSize, pIdivmod).Int32Value();
+  __ ldr(LR, Address(TR, offset));
+  __ blx(LR);
+  DCHECK(!codegen_->IsLeafMethod());
+}
+
+void LocationsBuilderARM::VisitDiv(HDiv* div) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(div);
+  if (div->GetResultType() == Primitive::kPrimInt) {
+    codegen_->MarkNotLeaf();
+    SetIntDivOrRemLocations(locations, true);
+  } else {
+    locations->SetInAt(0, Location::RequiresRegister());
+    locations->SetInAt(1, Location::RequiresRegister());
+    locations->SetOut(Location::RequiresRegister());
+  }
+  div->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorARM::VisitDiv(HDiv* div) {
+  LocationSummary* locations = div->GetLocations();
+  switch (div->GetResultType()) {
+    case Primitive::kPrimInt:
+      GenerateIntDivOrRem();
+      break;
+
+    case Primitive::kPrimFloat:
+      __ vmovsr(S0, locations->InAt(0).AsArm().AsCoreRegister());
+      __ vmovsr(S1, locations->InAt(1).AsArm().AsCoreRegister());
+      __ vdivs(S0, S0, S1);
+      __ vmovrs(locations->Out().AsArm().AsCoreRegister(), S0);
+      break;
+
+    case Primitive::kPrimDouble:
+      __ vmovdrr(D0, locations->InAt(0).AsArm().AsRegisterPairLow(),
+                 locations->InAt(0).AsArm().AsRegisterPairHigh());
+      __ vmovdrr(D1, locations->InAt(1).AsArm().AsRegisterPairLow(),
+                 locations->InAt(1).AsArm().AsRegisterPairHigh());
+      __ vdivd(D0, D0, D1);
+      __ vmovrrd(locations->Out().AsArm().AsRegisterPairLow(),
+                 locations->Out().AsArm().AsRegisterPairHigh(), D0);
+      break;
+
+    default:
+      LOG(FATAL) << "Unexpected div type " << div->GetResultType();
+  }
+}
+
+void LocationsBuilderARM::VisitRem(HRem* rem) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(rem);
+  switch (rem->GetResultType()) {
+    case Primitive::kPrimInt:
+      codegen_->MarkNotLeaf();
+      SetIntDivOrRemLocations(locations, false);
+      break;
+
+    default:
+      LOG(FATAL) << "Unexpected rem type " << rem->GetResultType();
+  }
+  rem->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorARM::VisitRem(HRem* rem) {
+  switch (rem->GetResultType()) {
+    case Primitive::kPrimInt:
+      GenerateIntDivOrRem();
+      break;
+
+    default:
+      LOG(FATAL) << "Unexpected rem type " << rem->GetResultType();
+  }
+}
+
+void LocationsBuilderARM::VisitDivZeroCheck(HDivZeroCheck* instruction) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
+  locations->SetInAt(0, Location::RequiresRegister());
+  locations->SetOut(Location::SameAsFirstInput());
+  instruction->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorARM::VisitDivZeroCheck(HDivZeroCheck* instruction) {
+  SlowPathCode* slow_path =
+      new (GetGraph()->GetArena()) DivZeroCheckSlowPathARM(instruction->GetDexPc());
+  codegen_->AddSlowPath(slow_path);
+
+  LocationSummary* locations = instruction->GetLocations();
+  Location value = locations->InAt(0);
+  DCHECK(value.Equals(locations->Out()));
+
+  __ cmp(value.AsArm().AsCoreRegister(), ShifterOperand(0));
+  __ b(slow_path->GetEntryLabel(), EQ);
+}
+
+void LocationsBuilderARM::VisitNeg(HNeg* neg) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(neg);
+  locations->SetInAt(0, Location::RequiresRegister());
+  locations->SetOut(Location::RequiresRegister());
+  neg->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorARM::VisitNeg(HNeg* neg) {
+  LocationSummary* locations = neg->GetLocations();
+  ArmManagedRegister in = locations->InAt(0).AsArm();
+  ArmManagedRegister out = locations->Out().AsArm();
+  switch (neg->GetResultType()) {
+    case Primitive::kPrimInt:
+      __ rsb(out.AsCoreRegister(), in.AsCoreRegister(), ShifterOperand(0));
+      break;
+
+    case Primitive::kPrimLong:
+      // Do LoadImmediate before `rsbs`, as LoadImmediate might affect the status flags.
+      __ LoadImmediate(IP, 0);
+      __ rsbs(out.AsRegisterPairLow(), in.AsRegisterPairLow(), ShifterOperand(0));
+      __ sbc(out.AsRegisterPairHigh(), IP, ShifterOperand(in.AsRegisterPairHigh()));
+      break;
+
+    // Negating a float or a double flips its sign bit, including for NaN and zero.
+    case Primitive::kPrimFloat:
+      __ LoadImmediate(IP, static_cast<int32_t>(0x80000000));
+      __ eor(out.AsCoreRegister(), in.AsCoreRegister(), ShifterOperand(IP));
+      break;
+
+    case Primitive::kPrimDouble:
+      __ LoadImmediate(IP, static_cast<int32_t>(0x80000000));
+      __ Mov(out.AsRegisterPairLow(), in.AsRegisterPairLow());
+      __ eor(out.AsRegisterPairHigh(), in.AsRegisterPairHigh(), ShifterOperand(IP));
+      break;
+
+    default:
+      LOG(FATAL) << "Unexpected neg type " << neg->GetResultType();
+  }
+}
+
+void LocationsBuilderARM::VisitTypeConversion(HTypeConversion* conversion) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(conversion);
+  Primitive::Type input_type = conversion->GetInputType();
+  Primitive::Type result_type = conversion->GetResultType();
+  bool is_runtime_call =
+      (input_type == Primitive::kPrimLong && Primitive::IsFloatingPointType(result_type))
+      || (result_type == Primitive::kPrimLong && Primitive::IsFloatingPointType(input_type));
+  if (is_runtime_call) {
+    // The conversion is done by the runtime, which follows the soft-float C calling
+    // convention.
+    codegen_->MarkNotLeaf();
+    if (Primitive::Is64BitType(input_type)) {
+      locations->SetInAt(
+          0, Location::RegisterLocation(ArmManagedRegister::FromRegisterPair(R0_R1)));
+    } else {
+      locations->SetInAt(0, ArmCoreLocation(R0));
+    }
+    if (Primitive::Is64BitType(result_type)) {
+      locations->SetOut(Location::RegisterLocation(ArmManagedRegister::FromRegisterPair(R0_R1)));
+    } else {
+      locations->SetOut(ArmCoreLocation(R0));
+    }
+  } else {
+    locations->SetInAt(0, Location::RequiresRegister());
+    locations->SetOut(Location::RequiresRegister());
+  }
+  conversion->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorARM::VisitTypeConversion(HTypeConversion* conversion) {
+  LocationSummary* locations = conversion->GetLocations();
+  ArmManagedRegister in = locations->InAt(0).AsArm();
+  ArmManagedRegister out = locations->Out().AsArm();
+  Primitive::Type input_type = conversion->GetInputType();
+  Primitive::Type result_type = conversion->GetResultType();
+  int32_t entry_point_offset = 0;
+  switch (result_type) {
+    case Primitive::kPrimByte:
+      DCHECK_EQ(input_type, Primitive::kPrimInt);
+      __ Lsl(out.AsCoreRegister(), in.AsCoreRegister(), 24);
+      __ Asr(out.AsCoreRegister(), out.AsCoreRegister(), 24);
+      break;
+
+    case Primitive::kPrimShort:
+      DCHECK_EQ(input_type, Primitive::kPrimInt);
+      __ Lsl(out.AsCoreRegister(), in.AsCoreRegister(), 16);
+      __ Asr(out.AsCoreRegister(), out.AsCoreRegister(), 16);
+      break;
+
+    case Primitive::kPrimChar:
+      DCHECK_EQ(input_type, Primitive::kPrimInt);
+      __ Lsl(out.AsCoreRegister(), in.AsCoreRegister(), 16);
+      __ Lsr(out.AsCoreRegister(), out.AsCoreRegister(), 16);
+      break;
+
+    // The VFP conversions to integers round towards zero, saturate, and convert NaN
+    // to zero, as Java wants.
+    case Primitive::kPrimInt:
+      if (input_type == Primitive::kPrimLong) {
+        __ Mov(out.AsCoreRegister(), in.AsRegisterPairLow());
+      } else if (input_type == Primitive::kPrimFloat) {
+        __ vmovsr(S0, in.AsCoreRegister());
+        __ vcvtis(S0, S0);
+        __ vmovrs(out.AsCoreRegister(), S0);
+      } else {
+        DCHECK_EQ(input_type, Primitive::kPrimDouble);
+        __ vmovdrr(D0, in.AsRegisterPairLow(), in.AsRegisterPairHigh());
+        __ vcvtid(S2, D0);
+        __ vmovrs(out.AsCoreRegister(), S2);
+      }
+      break;
+
+    case Primitive::kPrimLong:
+      if (input_type == Primitive::kPrimInt) {
+        __ Mov(out.AsRegisterPairLow(), in.AsCoreRegister());
+        __ Asr(out.AsRegisterPairHigh(), in.AsCoreRegister(), 31);
+      } else if (input_type == Primitive::kPrimFloat) {
+        entry_point_offset = QUICK_ENTRYPOINT_OFFSET(kArmWordSize, pF2l).Int32Value();
+      } else {
+        DCHECK_EQ(input_type, Primitive::kPrimDouble);
+        entry_point_offset = QUICK_ENTRYPOINT_OFFSET(kArmWordSize, pD2l).Int32Value();
+      }
+      break;
+
+    case Primitive::kPrimFloat:
+      if (input_type == Primitive::kPrimLong) {
+        entry_point_offset = QUICK_ENTRYPOINT_OFFSET(kArmWordSize, pL2f).Int32Value();
+      } else {
+        if (input_type == Primitive::kPrimInt) {
+          __ vmovsr(S0, in.AsCoreRegister());
+          __ vcvtsi(S2, S0);
+        } else {
+          DCHECK_EQ(input_type, Primitive::kPrimDouble);
+          __ vmovdrr(D0, in.AsRegisterPairLow(), in.AsRegisterPairHigh());
+          __ vcvtsd(S2, D0);
+        }
+        __ vmovrs(out.AsCoreRegister(), S2);
+      }
+      break;
+
+    case Primitive::kPrimDouble:
+      if (input_type == Primitive::kPrimLong) {
+        entry_point_offset = QUICK_ENTRYPOINT_OFFSET(kArmWordSize, pL2d).Int32Value();
+      } else {
+        __ vmovsr(S0, in.AsCoreRegister());
+        if (input_type == Primitive::kPrimInt) {
+          __ vcvtdi(D1, S0);
+        } else {
+          DCHECK_EQ(input_type, Primitive::kPrimFloat);
+          __ vcvtds(D1, S0);
+        }
+        __ vmovrrd(out.AsRegisterPairLow(), out.AsRegisterPairHigh(), D1);
+      }
+      break;
+
+    default:
+      LOG(FATAL) << "Unexpected type conversion from " << input_type << " to " << result_type;
+  }
+
+  if (entry_point_offset != 0) {
+    // The entry point neither throws nor suspends, so there is no pc to record.
+    __ ldr(LR, Address(TR, entry_point_offset));
+    __ blx(LR);
+    DCHECK(!codegen_->IsLeafMethod());
+  }
+}
+
 void LocationsBuilderARM::VisitNewInstance(HNewInstance* instruction) {
   codegen_->MarkNotLeaf();
   LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
@@ -1007,6 +1550,112 @@ void InstructionCodeGeneratorARM::VisitNewInstance(HNewInstance* instruction) {
   DCHECK(!codegen_->IsLeafMethod());
 }
 
+void LocationsBuilderARM::VisitLoadClass(HLoadClass* cls) {
+  codegen_->MarkNotLeaf();
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(cls);
+  InvokeRuntimeCallingConvention calling_convention;
+  locations->AddTemp(ArmCoreLocation(calling_convention.GetRegisterAt(0)));
+  locations->AddTemp(ArmCoreLocation(calling_convention.GetRegisterAt(1)));
+  locations->SetOut(ArmCoreLocation(R0));
+  cls->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorARM::VisitLoadClass(HLoadClass* cls) {
+  InvokeRuntimeCallingConvention calling_convention;
+  Register method = calling_convention.GetRegisterAt(1);
+  Register out = cls->GetLocations()->Out().AsArm().AsCoreRegister();
+  LoadCurrentMethod(method);
+
+  if (cls->NeedsAccessCheck()) {
+    __ LoadImmediate(calling_convention.GetRegisterAt(0), cls->GetTypeIndex());
+    int32_t offset =
+        QUICK_ENTRYPOINT_OFFSET(kArmWordSize, pInitializeTypeAndVerifyAccess).Int32Value();
+    __ ldr(LR, Address(TR, offset));
+    __ blx(LR);
+    codegen_->RecordPcInfo(cls->GetDexPc());
+  } else {
+    SlowPathCode* slow_path = new (GetGraph()->GetArena()) LoadClassSlowPathARM(
+        cls->GetTypeIndex(), cls->GetDexPc());
+    codegen_->AddSlowPath(slow_path);
+    uint32_t heap_reference_size = sizeof(mirror::HeapReference<mirror::Object>);
+    size_t index_in_cache = mirror::Array::DataOffset(heap_reference_size).Int32Value() +
+        cls->GetTypeIndex() * heap_reference_size;
+    // out = method->dex_cache_resolved_types_[type_index]
+    __ ldr(out, Address(method, mirror::ArtMethod::DexCacheResolvedTypesOffset().Int32Value()));
+    __ LoadFromOffset(kLoadWord, out, out, index_in_cache);
+    __ cmp(out, ShifterOperand(0));
+    __ b(slow_path->GetEntryLabel(), EQ);
+    __ Bind(slow_path->GetExitLabel());
+  }
+  DCHECK(!codegen_->IsLeafMethod());
+}
+
+// The type checks compare the class of the object with the class checked against, and
+// only call the runtime when they differ.
+static void SetTypeCheckLocations(LocationSummary* locations) {
+  locations->SetInAt(0, Location::RequiresRegister());
+  locations->SetInAt(1, Location::RequiresRegister());
+  InvokeRuntimeCallingConvention calling_convention;
+  locations->AddTemp(ArmCoreLocation(calling_convention.GetRegisterAt(0)));
+  locations->AddTemp(ArmCoreLocation(calling_convention.GetRegisterAt(1)));
+}
+
+void LocationsBuilderARM::VisitInstanceOf(HInstanceOf* instruction) {
+  codegen_->MarkNotLeaf();
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
+  SetTypeCheckLocations(locations);
+  locations->SetOut(ArmCoreLocation(R0));
+  instruction->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorARM::VisitInstanceOf(HInstanceOf* instruction) {
+  LocationSummary* locations = instruction->GetLocations();
+  Register obj = locations->InAt(0).AsArm().AsCoreRegister();
+  Register cls = locations->InAt(1).AsArm().AsCoreRegister();
+  Register obj_cls = locations->GetTemp(1).AsArm().AsCoreRegister();
+  Register out = locations->Out().AsArm().AsCoreRegister();
+  SlowPathCode* slow_path =
+      new (GetGraph()->GetArena()) TypeCheckSlowPathARM(instruction, locations->InAt(1));
+  codegen_->AddSlowPath(slow_path);
+  Label is_null;
+
+  __ cmp(obj, ShifterOperand(0));
+  __ b(&is_null, EQ);
+  __ ldr(obj_cls, Address(obj, mirror::Object::ClassOffset().Int32Value()));
+  __ cmp(obj_cls, ShifterOperand(cls));
+  __ b(slow_path->GetEntryLabel(), NE);
+  __ LoadImmediate(out, 1);
+  __ b(slow_path->GetExitLabel());
+  __ Bind(&is_null);
+  __ LoadImmediate(out, 0);
+  __ Bind(slow_path->GetExitLabel());
+}
+
+void LocationsBuilderARM::VisitCheckCast(HCheckCast* instruction) {
+  codegen_->MarkNotLeaf();
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
+  SetTypeCheckLocations(locations);
+  instruction->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorARM::VisitCheckCast(HCheckCast* instruction) {
+  LocationSummary* locations = instruction->GetLocations();
+  Register obj = locations->InAt(0).AsArm().AsCoreRegister();
+  Register cls = locations->InAt(1).AsArm().AsCoreRegister();
+  Register obj_cls = locations->GetTemp(1).AsArm().AsCoreRegister();
+  SlowPathCode* slow_path =
+      new (GetGraph()->GetArena()) TypeCheckSlowPathARM(instruction, locations->InAt(1));
+  codegen_->AddSlowPath(slow_path);
+
+  // A null reference can be cast to any type.
+  __ cmp(obj, ShifterOperand(0));
+  __ b(slow_path->GetExitLabel(), EQ);
+  __ ldr(obj_cls, Address(obj, mirror::Object::ClassOffset().Int32Value()));
+  __ cmp(obj_cls, ShifterOperand(cls));
+  __ b(slow_path->GetEntryLabel(), NE);
+  __ Bind(slow_path->GetExitLabel());
+}
+
 void LocationsBuilderARM::VisitParameterValue(HParameterValue* instruction) {
   LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
   Location location = parameter_visitor_.GetNextLocation(instruction->GetType());
@@ -1047,7 +1696,7 @@ void LocationsBuilderARM::VisitCompare(HCompare* compare) {
 void InstructionCodeGeneratorARM::VisitCompare(HCompare* compare) {
   Label greater, done;
   LocationSummary* locations = compare->GetLocations();
-  switch (compare->InputAt(0)->GetType()) {
+  switch (compare->GetInputType()) {
     case Primitive::kPrimLong: {
       Register output = locations->Out().AsArm().AsCoreRegister();
       ArmManagedRegister left = locations->InAt(0).AsArm();
@@ -1075,8 +1724,42 @@ void InstructionCodeGeneratorARM::VisitCompare(HCompare* compare) {
       __ Bind(&done);
       break;
     }
+    case Primitive::kPrimFloat:
+    case Primitive::kPrimDouble: {
+      Register output = locations->Out().AsArm().AsCoreRegister();
+      ArmManagedRegister left = locations->InAt(0).AsArm();
+      ArmManagedRegister right = locations->InAt(1).AsArm();
+      Label less, greater, done;
+      if (compare->GetInputType() == Primitive::kPrimFloat) {
+        __ vmovsr(S0, left.AsCoreRegister());
+        __ vmovsr(S1, right.AsCoreRegister());
+        __ vcmps(S0, S1);
+      } else {
+        __ vmovdrr(D0, left.AsRegisterPairLow(), left.AsRegisterPairHigh());
+        __ vmovdrr(D1, right.AsRegisterPairLow(), right.AsRegisterPairHigh());
+        __ vcmpd(D0, D1);
+      }
+      // Do LoadImmediate before transferring the flags, as LoadImmediate might affect
+      // the status flags.
+      __ LoadImmediate(output, 0);
+      __ vmstat();  // Transfer the FP status flags to the core flags.
+      // An unordered comparison, with a NaN, sets the overflow flag.
+      __ b(compare->IsGtBias() ? &greater : &less, VS);
+      __ b(&done, EQ);
+      __ b(&less, CC);
+
+      __ Bind(&greater);
+      __ LoadImmediate(output, 1);
+      __ b(&done);
+
+      __ Bind(&less);
+      __ LoadImmediate(output, -1);
+
+      __ Bind(&done);
+      break;
+    }
     default:
-      LOG(FATAL) << "Unimplemented compare type " << compare->InputAt(0)->GetType();
+      LOG(FATAL) << "Unimplemented compare type " << compare->GetInputType();
   }
 }
 
@@ -1127,6 +1810,7 @@ void InstructionCodeGeneratorARM::VisitInstanceFieldSet(HInstanceFieldSet* instr
     }
 
     case Primitive::kPrimInt:
+    case Primitive::kPrimFloat:
     case Primitive::kPrimNot: {
       Register value = locations->InAt(1).AsArm().AsCoreRegister();
       __ StoreToOffset(kStoreWord, value, obj, offset);
@@ -1138,16 +1822,13 @@ void InstructionCodeGeneratorARM::VisitInstanceFieldSet(HInstanceFieldSet* instr
       break;
     }
 
-    case Primitive::kPrimLong: {
+    case Primitive::kPrimLong:
+    case Primitive::kPrimDouble: {
       ArmManagedRegister value = locations->InAt(1).AsArm();
       __ StoreToOffset(kStoreWordPair, value.AsRegisterPairLow(), obj, offset);
       break;
     }
 
-    case Primitive::kPrimFloat:
-    case Primitive::kPrimDouble:
-      LOG(FATAL) << "Unimplemented register type " << field_type;
-
     case Primitive::kPrimVoid:
       LOG(FATAL) << "Unreachable type " << field_type;
   }
@@ -1191,23 +1872,21 @@ void InstructionCodeGeneratorARM::VisitInstanceFieldGet(HInstanceFieldGet* instr
     }
 
     case Primitive::kPrimInt:
+    case Primitive::kPrimFloat:
     case Primitive::kPrimNot: {
       Register out = locations->Out().AsArm().AsCoreRegister();
       __ LoadFromOffset(kLoadWord, out, obj, offset);
       break;
     }
 
-    case Primitive::kPrimLong: {
+    case Primitive::kPrimLong:
+    case Primitive::kPrimDouble: {
       // TODO: support volatile.
       ArmManagedRegister out = locations->Out().AsArm();
       __ LoadFromOffset(kLoadWordPair, out.AsRegisterPairLow(), obj, offset);
       break;
     }
 
-    case Primitive::kPrimFloat:
-    case Primitive::kPrimDouble:
-      LOG(FATAL) << "Unimplemented register type " << instruction->GetType();
-
     case Primitive::kPrimVoid:
       LOG(FATAL) << "Unreachable type " << instruction->GetType();
   }
@@ -1303,6 +1982,7 @@ void InstructionCodeGeneratorARM::VisitArrayGet(HArrayGet* instruction) {
     }
 
     case Primitive::kPrimInt:
+    case Primitive::kPrimFloat:
     case Primitive::kPrimNot: {
       DCHECK_EQ(sizeof(mirror::HeapReference<mirror::Object>), sizeof(int32_t));
       uint32_t data_offset = mirror::Array::DataOffset(sizeof(int32_t)).Uint32Value();
@@ -1317,7 +1997,8 @@ void InstructionCodeGeneratorARM::VisitArrayGet(HArrayGet* instruction) {
       break;
     }
 
-    case Primitive::kPrimLong: {
+    case Primitive::kPrimLong:
+    case Primitive::kPrimDouble: {
       uint32_t data_offset = mirror::Array::DataOffset(sizeof(int64_t)).Uint32Value();
       ArmManagedRegister out = locations->Out().AsArm();
       if (index.IsConstant()) {
@@ -1330,10 +2011,6 @@ void InstructionCodeGeneratorARM::VisitArrayGet(HArrayGet* instruction) {
       break;
     }
 
-    case Primitive::kPrimFloat:
-    case Primitive::kPrimDouble:
-      LOG(FATAL) << "Unimplemented register type " << instruction->GetType();
-
     case Primitive::kPrimVoid:
       LOG(FATAL) << "Unreachable type " << instruction->GetType();
   }
@@ -1391,7 +2068,8 @@ void InstructionCodeGeneratorARM::VisitArraySet(HArraySet* instruction) {
       break;
     }
 
-    case Primitive::kPrimInt: {
+    case Primitive::kPrimInt:
+    case Primitive::kPrimFloat: {
       uint32_t data_offset = mirror::Array::DataOffset(sizeof(int32_t)).Uint32Value();
       Register value = locations->InAt(2).AsArm().AsCoreRegister();
       if (index.IsConstant()) {
@@ -1413,7 +2091,8 @@ void InstructionCodeGeneratorARM::VisitArraySet(HArraySet* instruction) {
       break;
     }
 
-    case Primitive::kPrimLong: {
+    case Primitive::kPrimLong:
+    case Primitive::kPrimDouble: {
       uint32_t data_offset = mirror::Array::DataOffset(sizeof(int64_t)).Uint32Value();
       ArmManagedRegister value = locations->InAt(2).AsArm();
       if (index.IsConstant()) {
@@ -1426,10 +2105,6 @@ void InstructionCodeGeneratorARM::VisitArraySet(HArraySet* instruction) {
       break;
     }
 
-    case Primitive::kPrimFloat:
-    case Primitive::kPrimDouble:
-      LOG(FATAL) << "Unimplemented register type " << instruction->GetType();
-
     case Primitive::kPrimVoid:
       LOG(FATAL) << "Unreachable type " << instruction->GetType();
   }
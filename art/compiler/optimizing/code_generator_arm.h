@@ -94,6 +94,8 @@ class LocationsBuilderARM : public HGraphVisitor {
 #undef DECLARE_VISIT_INSTRUCTION
 
  private:
+  void HandleInvoke(HInvoke* invoke);
+
   CodeGeneratorARM* const codegen_;
   InvokeDexCallingConventionVisitor parameter_visitor_;
 
@@ -115,6 +117,9 @@ class InstructionCodeGeneratorARM : public HGraphVisitor {
   void LoadCurrentMethod(Register reg);
 
  private:
+  // Calls the runtime to divide R0 by R1.
+  void GenerateIntDivOrRem();
+
   ArmAssembler* const assembler_;
   CodeGeneratorARM* const codegen_;
 
@@ -128,7 +133,7 @@ class CodeGeneratorARM : public CodeGenerator {
 
   virtual void GenerateFrameEntry() OVERRIDE;
   virtual void GenerateFrameExit() OVERRIDE;
-  virtual void Bind(Label* label) OVERRIDE;
+  virtual void Bind(HBasicBlock* block) OVERRIDE;
   virtual void Move(HInstruction* instruction, Location location, HInstruction* move_for) OVERRIDE;
 
   virtual size_t GetWordSize() const OVERRIDE {
@@ -167,7 +172,7 @@ class CodeGeneratorARM : public CodeGenerator {
   virtual void DumpCoreRegister(std::ostream& stream, int reg) const OVERRIDE;
   virtual void DumpFloatingPointRegister(std::ostream& stream, int reg) const OVERRIDE;
 
-  ParallelMoveResolverARM* GetMoveResolver() {
+  ParallelMoveResolverARM* GetMoveResolver() OVERRIDE {
     return &move_resolver_;
   }
 
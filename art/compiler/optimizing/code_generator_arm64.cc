@@ -0,0 +1,1933 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "code_generator_arm64.h"
+
+#include "entrypoints/quick/quick_entrypoints.h"
+#include "gc/accounting/card_table.h"
+#include "mirror/array.h"
+#include "mirror/art_method.h"
+#include "mirror/class.h"
+#include "mirror/object_reference.h"
+#include "thread.h"
+#include "utils/arm64/assembler_arm64.h"
+#include "utils/arm64/managed_register_arm64.h"
+#include "utils/assembler.h"
+#include "utils/stack_checks.h"
+
+namespace art {
+
+arm64::Arm64ManagedRegister Location::AsArm64() const {
+  return reg().AsArm64();
+}
+
+namespace arm64 {
+
+static constexpr bool kExplicitStackOverflowCheck = false;
+
+// LR is stored at the top of the frame, like in Quick.
+static constexpr int kNumberOfPushedRegistersAtEntry = 1;
+static constexpr int kCurrentMethodStackOffset = 0;
+
+// Upper bounds of the code emitted for the frame entry, for one instruction of the graph
+// (including its slow path), and for one move between locations. The VIXL buffer does not
+// grow, so it is sized from these before generating code.
+static constexpr size_t kMaxFrameEntryCodeSize = 64;
+static constexpr size_t kMaxInstructionCodeSize = 96;
+static constexpr size_t kMaxMoveCodeSize = 32;
+
+static Location ARM64CoreLocation(Register reg) {
+  return Location::RegisterLocation(Arm64ManagedRegister::FromCoreRegister(reg));
+}
+
+// Locations only hold X registers, which are used as W registers for 32-bit values.
+static vixl::Register XRegisterFrom(Location location) {
+  return vixl::Register::XRegFromCode(location.AsArm64().AsCoreRegister());
+}
+
+static vixl::Register WRegisterFrom(Location location) {
+  return vixl::Register::WRegFromCode(location.AsArm64().AsCoreRegister());
+}
+
+static vixl::Register RegisterFrom(Location location, Primitive::Type type) {
+  return Primitive::Is64BitType(type) ? XRegisterFrom(location) : WRegisterFrom(location);
+}
+
+// Float and double values are kept in core registers, like int and long values. They are
+// moved to FP registers to be operated on: the scratch ones are the first two, as the
+// arguments of the method are spilled to their stack slots on entry.
+static vixl::FPRegister FPRegisterFrom(unsigned code, Primitive::Type type) {
+  DCHECK(Primitive::IsFloatingPointType(type));
+  return type == Primitive::kPrimDouble ? vixl::FPRegister::DRegFromCode(code)
+                                        : vixl::FPRegister::SRegFromCode(code);
+}
+
+static int64_t Int64ConstantFrom(Location location) {
+  HConstant* constant = location.GetConstant();
+  if (constant->IsIntConstant()) {
+    return constant->AsIntConstant()->GetValue();
+  }
+  DCHECK(constant->IsLongConstant());
+  return constant->AsLongConstant()->GetValue();
+}
+
+static vixl::Operand OperandFrom(Location location, Primitive::Type type) {
+  if (location.IsRegister()) {
+    return vixl::Operand(RegisterFrom(location, type));
+  }
+  return vixl::Operand(Int64ConstantFrom(location));
+}
+
+static vixl::MemOperand StackOperandFrom(Location location) {
+  return vixl::MemOperand(vixl::sp, location.GetStackIndex());
+}
+
+static vixl::Register ThreadRegister() {
+  return vixl::Register::XRegFromCode(TR);
+}
+
+static vixl::Register LinkRegister() {
+  return vixl::Register::XRegFromCode(LR);
+}
+
+static constexpr Register kRuntimeParameterCoreRegisters[] = { X0, X1, X2 };
+static constexpr size_t kRuntimeParameterCoreRegistersLength =
+    arraysize(kRuntimeParameterCoreRegisters);
+
+class InvokeRuntimeCallingConvention : public CallingConvention<Register> {
+ public:
+  InvokeRuntimeCallingConvention()
+      : CallingConvention(kRuntimeParameterCoreRegisters,
+                          kRuntimeParameterCoreRegistersLength) {}
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(InvokeRuntimeCallingConvention);
+};
+
+#define __ reinterpret_cast<CodeGeneratorARM64*>(codegen)->GetVIXLAssembler()->
+
+class NullCheckSlowPathARM64 : public SlowPathCodeARM64 {
+ public:
+  explicit NullCheckSlowPathARM64(uint32_t dex_pc) : dex_pc_(dex_pc) {}
+
+  virtual void EmitNativeCode(CodeGenerator* codegen) OVERRIDE {
+    __ Bind(GetEntryLabel());
+    reinterpret_cast<CodeGeneratorARM64*>(codegen)->InvokeRuntime(
+        QUICK_ENTRYPOINT_OFFSET(kArm64WordSize, pThrowNullPointer).Int32Value(), dex_pc_);
+  }
+
+ private:
+  const uint32_t dex_pc_;
+  DISALLOW_COPY_AND_ASSIGN(NullCheckSlowPathARM64);
+};
+
+class StackOverflowCheckSlowPathARM64 : public SlowPathCodeARM64 {
+ public:
+  StackOverflowCheckSlowPathARM64() {}
+
+  virtual void EmitNativeCode(CodeGenerator* codegen) OVERRIDE {
+    __ Bind(GetEntryLabel());
+    // The frame has not been created yet: tail call the entrypoint.
+    vixl::UseScratchRegisterScope temps(reinterpret_cast<CodeGeneratorARM64*>(codegen)
+                                            ->GetVIXLAssembler());
+    vixl::Register temp = temps.AcquireX();
+    __ Ldr(temp, vixl::MemOperand(ThreadRegister(),
+        QUICK_ENTRYPOINT_OFFSET(kArm64WordSize, pThrowStackOverflow).Int32Value()));
+    __ Br(temp);
+  }
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(StackOverflowCheckSlowPathARM64);
+};
+
+class BoundsCheckSlowPathARM64 : public SlowPathCodeARM64 {
+ public:
+  explicit BoundsCheckSlowPathARM64(uint32_t dex_pc,
+                                    Location index_location,
+                                    Location length_location)
+      : dex_pc_(dex_pc), index_location_(index_location), length_location_(length_location) {}
+
+  virtual void EmitNativeCode(CodeGenerator* codegen) OVERRIDE {
+    CodeGeneratorARM64* arm64_codegen = reinterpret_cast<CodeGeneratorARM64*>(codegen);
+    __ Bind(GetEntryLabel());
+    InvokeRuntimeCallingConvention calling_convention;
+    // We're moving two locations to locations that could overlap, so we need a parallel
+    // move resolver.
+    codegen->EmitParallelMoves(index_location_,
+                               ARM64CoreLocation(calling_convention.GetRegisterAt(0)),
+                               length_location_,
+                               ARM64CoreLocation(calling_convention.GetRegisterAt(1)));
+    arm64_codegen->InvokeRuntime(
+        QUICK_ENTRYPOINT_OFFSET(kArm64WordSize, pThrowArrayBounds).Int32Value(), dex_pc_);
+  }
+
+ private:
+  const uint32_t dex_pc_;
+  const Location index_location_;
+  const Location length_location_;
+
+  DISALLOW_COPY_AND_ASSIGN(BoundsCheckSlowPathARM64);
+};
+
+class DivZeroCheckSlowPathARM64 : public SlowPathCodeARM64 {
+ public:
+  explicit DivZeroCheckSlowPathARM64(uint32_t dex_pc) : dex_pc_(dex_pc) {}
+
+  virtual void EmitNativeCode(CodeGenerator* codegen) OVERRIDE {
+    __ Bind(GetEntryLabel());
+    reinterpret_cast<CodeGeneratorARM64*>(codegen)->InvokeRuntime(
+        QUICK_ENTRYPOINT_OFFSET(kArm64WordSize, pThrowDivZero).Int32Value(), dex_pc_);
+  }
+
+ private:
+  const uint32_t dex_pc_;
+  DISALLOW_COPY_AND_ASSIGN(DivZeroCheckSlowPathARM64);
+};
+
+// Resolves a class missing from the dex cache. The current method is already in the
+// second argument register, and the runtime returns the class in W0.
+class LoadClassSlowPathARM64 : public SlowPathCodeARM64 {
+ public:
+  LoadClassSlowPathARM64(uint16_t type_index, uint32_t dex_pc)
+      : type_index_(type_index), dex_pc_(dex_pc) {}
+
+  virtual void EmitNativeCode(CodeGenerator* codegen) OVERRIDE {
+    __ Bind(GetEntryLabel());
+    InvokeRuntimeCallingConvention calling_convention;
+    __ Mov(vixl::Register::WRegFromCode(calling_convention.GetRegisterAt(0)), type_index_);
+    reinterpret_cast<CodeGeneratorARM64*>(codegen)->InvokeRuntime(
+        QUICK_ENTRYPOINT_OFFSET(kArm64WordSize, pInitializeType).Int32Value(), dex_pc_);
+    __ B(GetExitLabel());
+  }
+
+ private:
+  const uint16_t type_index_;
+  const uint32_t dex_pc_;
+
+  DISALLOW_COPY_AND_ASSIGN(LoadClassSlowPathARM64);
+};
+
+// Calls the runtime for the instanceof or check-cast whose class did not match the class
+// of the object exactly. The class of the object is already in the second argument register.
+class TypeCheckSlowPathARM64 : public SlowPathCodeARM64 {
+ public:
+  TypeCheckSlowPathARM64(HInstruction* instruction, Location class_location, uint32_t dex_pc)
+      : instruction_(instruction), class_location_(class_location), dex_pc_(dex_pc) {}
+
+  virtual void EmitNativeCode(CodeGenerator* codegen) OVERRIDE {
+    __ Bind(GetEntryLabel());
+    InvokeRuntimeCallingConvention calling_convention;
+    __ Mov(vixl::Register::WRegFromCode(calling_convention.GetRegisterAt(0)),
+           WRegisterFrom(class_location_));
+    int32_t entry_point_offset = instruction_->IsInstanceOf()
+        ? QUICK_ENTRYPOINT_OFFSET(kArm64WordSize, pInstanceofNonTrivial).Int32Value()
+        : QUICK_ENTRYPOINT_OFFSET(kArm64WordSize, pCheckCast).Int32Value();
+    reinterpret_cast<CodeGeneratorARM64*>(codegen)->InvokeRuntime(entry_point_offset, dex_pc_);
+    __ B(GetExitLabel());
+  }
+
+ private:
+  HInstruction* const instruction_;
+  const Location class_location_;
+  const uint32_t dex_pc_;
+
+  DISALLOW_COPY_AND_ASSIGN(TypeCheckSlowPathARM64);
+};
+
+#undef __
+#define __ GetVIXLAssembler()->
+
+inline vixl::Condition ARM64Condition(IfCondition cond) {
+  switch (cond) {
+    case kCondEQ: return vixl::eq;
+    case kCondNE: return vixl::ne;
+    case kCondLT: return vixl::lt;
+    case kCondLE: return vixl::le;
+    case kCondGT: return vixl::gt;
+    case kCondGE: return vixl::ge;
+    default:
+      LOG(FATAL) << "Unknown if condition";
+  }
+  return vixl::eq;  // Unreachable.
+}
+
+void CodeGeneratorARM64::DumpCoreRegister(std::ostream& stream, int reg) const {
+  stream << Arm64ManagedRegister::FromCoreRegister(Register(reg));
+}
+
+void CodeGeneratorARM64::DumpFloatingPointRegister(std::ostream& stream, int reg) const {
+  stream << Arm64ManagedRegister::FromDRegister(DRegister(reg));
+}
+
+CodeGeneratorARM64::CodeGeneratorARM64(HGraph* graph)
+    : CodeGenerator(graph, kNumberOfRegIds),
+      location_builder_(graph, this),
+      instruction_visitor_(graph, this),
+      move_resolver_(graph->GetArena(), this),
+      block_labels_(nullptr) {}
+
+size_t CodeGeneratorARM64::FrameEntrySpillSize() const {
+  return kNumberOfPushedRegistersAtEntry * kArm64WordSize;
+}
+
+InstructionCodeGeneratorARM64::InstructionCodeGeneratorARM64(HGraph* graph,
+                                                             CodeGeneratorARM64* codegen)
+      : HGraphVisitor(graph),
+        codegen_(codegen),
+        number_of_fp_parameters_(0) {}
+
+vixl::MacroAssembler* InstructionCodeGeneratorARM64::GetVIXLAssembler() const {
+  return codegen_->GetVIXLAssembler();
+}
+
+void CodeGeneratorARM64::Initialize() {
+  const GrowableArray<HBasicBlock*>& blocks = GetGraph()->GetBlocks();
+  size_t code_size = kMaxFrameEntryCodeSize;
+  for (size_t i = 0, e = blocks.Size(); i < e; ++i) {
+    for (HInstructionIterator it(blocks.Get(i)->GetInstructions()); !it.Done(); it.Advance()) {
+      HInstruction* current = it.Current();
+      // The baseline compiler moves each input, and the output of a temporary.
+      size_t moves = current->InputCount() + 1;
+      if (current->IsParallelMove()) {
+        moves += current->AsParallelMove()->NumMoves();
+      }
+      code_size += kMaxInstructionCodeSize + moves * kMaxMoveCodeSize;
+    }
+  }
+  assembler_.reset(new Arm64Assembler(code_size));
+
+  block_labels_ = static_cast<vixl::Label*>(GetGraph()->GetArena()->Alloc(
+      blocks.Size() * sizeof(vixl::Label), kArenaAllocMisc));
+  for (size_t i = 0, e = blocks.Size(); i < e; ++i) {
+    new (block_labels_ + i) vixl::Label();
+  }
+}
+
+ManagedRegister CodeGeneratorARM64::AllocateFreeRegister(Primitive::Type type,
+                                                         bool* blocked_registers) const {
+  switch (type) {
+    case Primitive::kPrimLong:
+    case Primitive::kPrimByte:
+    case Primitive::kPrimBoolean:
+    case Primitive::kPrimChar:
+    case Primitive::kPrimShort:
+    case Primitive::kPrimInt:
+    case Primitive::kPrimNot:
+    case Primitive::kPrimFloat:
+    case Primitive::kPrimDouble: {
+      size_t reg = AllocateFreeRegisterInternal(blocked_registers, kNumberOfCoreRegisters);
+      return Arm64ManagedRegister::FromCoreRegister(static_cast<Register>(reg));
+    }
+
+    case Primitive::kPrimVoid:
+      LOG(FATAL) << "Unreachable type " << type;
+  }
+
+  return ManagedRegister::NoRegister();
+}
+
+void CodeGeneratorARM64::SetupBlockedRegisters(bool* blocked_registers) const {
+  // Stack register and zero register are always reserved.
+  blocked_registers[SP] = true;
+  blocked_registers[XZR] = true;
+
+  // Scratch registers of VIXL, used for temporaries.
+  blocked_registers[IP0] = true;
+  blocked_registers[IP1] = true;
+
+  // Thread register, frame pointer and link register.
+  blocked_registers[TR] = true;
+  blocked_registers[FP] = true;
+  blocked_registers[LR] = true;
+
+  // TODO: We currently don't use Quick's callee saved registers. This also reserves ETR.
+  for (int reg = X19; reg <= X28; ++reg) {
+    blocked_registers[reg] = true;
+  }
+}
+
+void CodeGeneratorARM64::GenerateFrameEntry() {
+  bool skip_overflow_check = IsLeafMethod()
+      && !FrameNeedsStackCheck(GetFrameSize(), InstructionSet::kArm64);
+
+  if (!skip_overflow_check) {
+    vixl::UseScratchRegisterScope temps(GetVIXLAssembler());
+    vixl::Register temp = temps.AcquireX();
+    if (kExplicitStackOverflowCheck) {
+      SlowPathCodeARM64* slow_path =
+          new (GetGraph()->GetArena()) StackOverflowCheckSlowPathARM64();
+      AddSlowPath(slow_path);
+
+      __ Ldr(temp, vixl::MemOperand(ThreadRegister(),
+                                    Thread::StackEndOffset<kArm64WordSize>().Int32Value()));
+      __ Cmp(vixl::sp, temp);
+      __ B(slow_path->GetEntryLabel(), vixl::lo);
+    } else {
+      __ Sub(temp, vixl::sp, static_cast<int32_t>(GetStackOverflowReservedBytes(kArm64)));
+      __ Ldr(temp, vixl::MemOperand(temp, 0));
+      RecordPcInfo(0);
+    }
+  }
+
+  core_spill_mask_ |= (1 << LR);
+
+  __ Sub(vixl::sp, vixl::sp, GetFrameSize());
+  __ Str(LinkRegister(), vixl::MemOperand(vixl::sp, GetFrameSize() - kArm64WordSize));
+  __ Str(vixl::Register::WRegFromCode(X0), vixl::MemOperand(vixl::sp, kCurrentMethodStackOffset));
+}
+
+void CodeGeneratorARM64::GenerateFrameExit() {
+  __ Ldr(LinkRegister(), vixl::MemOperand(vixl::sp, GetFrameSize() - kArm64WordSize));
+  __ Add(vixl::sp, vixl::sp, GetFrameSize());
+}
+
+void CodeGeneratorARM64::Bind(HBasicBlock* block) {
+  __ Bind(GetLabelOf(block));
+}
+
+void CodeGeneratorARM64::InvokeRuntime(int32_t entry_point_offset, uint32_t dex_pc) {
+  __ Ldr(LinkRegister(), vixl::MemOperand(ThreadRegister(), entry_point_offset));
+  __ Blr(LinkRegister());
+  RecordPcInfo(dex_pc);
+}
+
+void InstructionCodeGeneratorARM64::LoadCurrentMethod(const vixl::Register& reg) {
+  __ Ldr(reg.W(), vixl::MemOperand(vixl::sp, kCurrentMethodStackOffset));
+}
+
+Location CodeGeneratorARM64::GetStackLocation(HLoadLocal* load) const {
+  switch (load->GetType()) {
+    case Primitive::kPrimLong:
+    case Primitive::kPrimDouble:
+      return Location::DoubleStackSlot(GetStackSlot(load->GetLocal()));
+      break;
+
+    case Primitive::kPrimInt:
+    case Primitive::kPrimNot:
+    case Primitive::kPrimFloat:
+      return Location::StackSlot(GetStackSlot(load->GetLocal()));
+
+    case Primitive::kPrimBoolean:
+    case Primitive::kPrimByte:
+    case Primitive::kPrimChar:
+    case Primitive::kPrimShort:
+    case Primitive::kPrimVoid:
+      LOG(FATAL) << "Unexpected type " << load->GetType();
+  }
+
+  LOG(FATAL) << "Unreachable";
+  return Location();
+}
+
+void CodeGeneratorARM64::Move(Location destination, Location source) {
+  if (source.Equals(destination)) {
+    return;
+  }
+  if (destination.IsRegister()) {
+    if (source.IsRegister()) {
+      __ Mov(XRegisterFrom(destination), XRegisterFrom(source));
+    } else if (source.IsStackSlot()) {
+      __ Ldr(WRegisterFrom(destination), StackOperandFrom(source));
+    } else if (source.IsDoubleStackSlot()) {
+      __ Ldr(XRegisterFrom(destination), StackOperandFrom(source));
+    } else {
+      DCHECK(source.IsConstant());
+      __ Mov(XRegisterFrom(destination), Int64ConstantFrom(source));
+    }
+  } else {
+    bool is_64bit = destination.IsDoubleStackSlot();
+    DCHECK(is_64bit || destination.IsStackSlot());
+    if (source.IsRegister()) {
+      __ Str(is_64bit ? XRegisterFrom(source) : WRegisterFrom(source),
+             StackOperandFrom(destination));
+    } else {
+      vixl::UseScratchRegisterScope temps(GetVIXLAssembler());
+      vixl::Register temp = is_64bit ? temps.AcquireX() : temps.AcquireW();
+      if (source.IsConstant()) {
+        __ Mov(temp, Int64ConstantFrom(source));
+      } else {
+        DCHECK(is_64bit ? source.IsDoubleStackSlot() : source.IsStackSlot());
+        __ Ldr(temp, StackOperandFrom(source));
+      }
+      __ Str(temp, StackOperandFrom(destination));
+    }
+  }
+}
+
+void CodeGeneratorARM64::Move(HInstruction* instruction,
+                              Location location,
+                              HInstruction* move_for) {
+  if (instruction->AsIntConstant() != nullptr || instruction->AsLongConstant() != nullptr) {
+    Move(location, Location::ConstantLocation(instruction->AsConstant()));
+  } else if (instruction->AsLoadLocal() != nullptr) {
+    switch (instruction->GetType()) {
+      case Primitive::kPrimBoolean:
+      case Primitive::kPrimByte:
+      case Primitive::kPrimChar:
+      case Primitive::kPrimShort:
+      case Primitive::kPrimInt:
+      case Primitive::kPrimNot:
+      case Primitive::kPrimFloat:
+        Move(location, Location::StackSlot(GetStackSlot(instruction->AsLoadLocal()->GetLocal())));
+        break;
+
+      case Primitive::kPrimLong:
+      case Primitive::kPrimDouble:
+        Move(location,
+             Location::DoubleStackSlot(GetStackSlot(instruction->AsLoadLocal()->GetLocal())));
+        break;
+
+      default:
+        LOG(FATAL) << "Unimplemented local type " << instruction->GetType();
+    }
+  } else {
+    DCHECK((instruction->GetNext() == move_for) || instruction->GetNext()->IsTemporary());
+    switch (instruction->GetType()) {
+      case Primitive::kPrimBoolean:
+      case Primitive::kPrimByte:
+      case Primitive::kPrimChar:
+      case Primitive::kPrimShort:
+      case Primitive::kPrimInt:
+      case Primitive::kPrimNot:
+      case Primitive::kPrimLong:
+      case Primitive::kPrimFloat:
+      case Primitive::kPrimDouble:
+        Move(location, instruction->GetLocations()->Out());
+        break;
+
+      default:
+        LOG(FATAL) << "Unimplemented type " << instruction->GetType();
+    }
+  }
+}
+
+void LocationsBuilderARM64::VisitGoto(HGoto* got) {
+  got->SetLocations(nullptr);
+}
+
+void InstructionCodeGeneratorARM64::VisitGoto(HGoto* got) {
+  HBasicBlock* successor = got->GetSuccessor();
+  if (GetGraph()->GetExitBlock() == successor) {
+    codegen_->GenerateFrameExit();
+  } else if (!codegen_->GoesToNextBlock(got->GetBlock(), successor)) {
+    __ B(codegen_->GetLabelOf(successor));
+  }
+}
+
+void LocationsBuilderARM64::VisitExit(HExit* exit) {
+  exit->SetLocations(nullptr);
+}
+
+void InstructionCodeGeneratorARM64::VisitExit(HExit* exit) {
+  if (kIsDebugBuild) {
+    __ Brk();
+  }
+}
+
+void LocationsBuilderARM64::VisitIf(HIf* if_instr) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(if_instr);
+  HInstruction* cond = if_instr->InputAt(0);
+  if (cond->IsIntConstant()) {
+    // A condition folded to a constant: the branch taken is known.
+    locations->SetInAt(0, Location::ConstantLocation(cond->AsConstant()));
+  } else {
+    DCHECK(cond->IsCondition());
+    HCondition* condition = cond->AsCondition();
+    if (condition->NeedsMaterialization()) {
+      locations->SetInAt(0, Location::RequiresRegister());
+    }
+  }
+  if_instr->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorARM64::VisitIf(HIf* if_instr) {
+  HInstruction* cond = if_instr->InputAt(0);
+  vixl::Label* true_target = codegen_->GetLabelOf(if_instr->IfTrueSuccessor());
+  if (cond->IsIntConstant()) {
+    // The condition was folded to 0 or 1.
+    int32_t cond_value = cond->AsIntConstant()->GetValue();
+    if (cond_value == 1) {
+      if (!codegen_->GoesToNextBlock(if_instr->GetBlock(), if_instr->IfTrueSuccessor())) {
+        __ B(true_target);
+      }
+      return;
+    } else {
+      DCHECK_EQ(cond_value, 0);
+    }
+  } else {
+    DCHECK(cond->IsCondition());
+    HCondition* condition = cond->AsCondition();
+    if (condition->NeedsMaterialization()) {
+      // The materialized condition is 1 when it holds.
+      __ Cbnz(WRegisterFrom(if_instr->GetLocations()->InAt(0)), true_target);
+    } else {
+      // Use the inputs of the condition for the comparison and its condition for the branch.
+      LocationSummary* locations = condition->GetLocations();
+      Primitive::Type type = condition->InputAt(0)->GetType();
+      __ Cmp(RegisterFrom(locations->InAt(0), type), OperandFrom(locations->InAt(1), type));
+      __ B(true_target, ARM64Condition(condition->GetCondition()));
+    }
+  }
+  if (!codegen_->GoesToNextBlock(if_instr->GetBlock(), if_instr->IfFalseSuccessor())) {
+    __ B(codegen_->GetLabelOf(if_instr->IfFalseSuccessor()));
+  }
+}
+
+void LocationsBuilderARM64::VisitLocal(HLocal* local) {
+  local->SetLocations(nullptr);
+}
+
+void InstructionCodeGeneratorARM64::VisitLocal(HLocal* local) {
+  DCHECK_EQ(local->GetBlock(), GetGraph()->GetEntryBlock());
+}
+
+void LocationsBuilderARM64::VisitLoadLocal(HLoadLocal* local) {
+  local->SetLocations(nullptr);
+}
+
+void InstructionCodeGeneratorARM64::VisitLoadLocal(HLoadLocal* load) {
+  // Nothing to do, this is driven by the code generator.
+}
+
+void LocationsBuilderARM64::VisitStoreLocal(HStoreLocal* store) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(store);
+  switch (store->InputAt(1)->GetType()) {
+    case Primitive::kPrimBoolean:
+    case Primitive::kPrimByte:
+    case Primitive::kPrimChar:
+    case Primitive::kPrimShort:
+    case Primitive::kPrimInt:
+    case Primitive::kPrimNot:
+    case Primitive::kPrimFloat:
+      locations->SetInAt(1, Location::StackSlot(codegen_->GetStackSlot(store->GetLocal())));
+      break;
+
+    case Primitive::kPrimLong:
+    case Primitive::kPrimDouble:
+      locations->SetInAt(1, Location::DoubleStackSlot(codegen_->GetStackSlot(store->GetLocal())));
+      break;
+
+    default:
+      LOG(FATAL) << "Unimplemented local type " << store->InputAt(1)->GetType();
+  }
+  store->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorARM64::VisitStoreLocal(HStoreLocal* store) {
+}
+
+void LocationsBuilderARM64::VisitCondition(HCondition* comp) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(comp);
+  locations->SetInAt(0, Location::RequiresRegister());
+  locations->SetInAt(1, Location::RegisterOrConstant(comp->InputAt(1)));
+  if (comp->NeedsMaterialization()) {
+    locations->SetOut(Location::RequiresRegister());
+  }
+  comp->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorARM64::VisitCondition(HCondition* comp) {
+  if (comp->NeedsMaterialization()) {
+    LocationSummary* locations = comp->GetLocations();
+    Primitive::Type type = comp->InputAt(0)->GetType();
+    __ Cmp(RegisterFrom(locations->InAt(0), type), OperandFrom(locations->InAt(1), type));
+    __ Cset(WRegisterFrom(locations->Out()), ARM64Condition(comp->GetCondition()));
+  }
+}
+
+void LocationsBuilderARM64::VisitEqual(HEqual* comp) {
+  VisitCondition(comp);
+}
+
+void InstructionCodeGeneratorARM64::VisitEqual(HEqual* comp) {
+  VisitCondition(comp);
+}
+
+void LocationsBuilderARM64::VisitNotEqual(HNotEqual* comp) {
+  VisitCondition(comp);
+}
+
+void InstructionCodeGeneratorARM64::VisitNotEqual(HNotEqual* comp) {
+  VisitCondition(comp);
+}
+
+void LocationsBuilderARM64::VisitLessThan(HLessThan* comp) {
+  VisitCondition(comp);
+}
+
+void InstructionCodeGeneratorARM64::VisitLessThan(HLessThan* comp) {
+  VisitCondition(comp);
+}
+
+void LocationsBuilderARM64::VisitLessThanOrEqual(HLessThanOrEqual* comp) {
+  VisitCondition(comp);
+}
+
+void InstructionCodeGeneratorARM64::VisitLessThanOrEqual(HLessThanOrEqual* comp) {
+  VisitCondition(comp);
+}
+
+void LocationsBuilderARM64::VisitGreaterThan(HGreaterThan* comp) {
+  VisitCondition(comp);
+}
+
+void InstructionCodeGeneratorARM64::VisitGreaterThan(HGreaterThan* comp) {
+  VisitCondition(comp);
+}
+
+void LocationsBuilderARM64::VisitGreaterThanOrEqual(HGreaterThanOrEqual* comp) {
+  VisitCondition(comp);
+}
+
+void InstructionCodeGeneratorARM64::VisitGreaterThanOrEqual(HGreaterThanOrEqual* comp) {
+  VisitCondition(comp);
+}
+
+void LocationsBuilderARM64::VisitCompare(HCompare* compare) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(compare);
+  locations->SetInAt(0, Location::RequiresRegister());
+  locations->SetInAt(1, Location::RequiresRegister());
+  locations->SetOut(Location::RequiresRegister());
+  compare->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorARM64::VisitCompare(HCompare* compare) {
+  LocationSummary* locations = compare->GetLocations();
+  Primitive::Type type = compare->GetInputType();
+  vixl::Condition less_cond = vixl::lt;
+  switch (type) {
+    case Primitive::kPrimLong:
+      __ Cmp(XRegisterFrom(locations->InAt(0)), XRegisterFrom(locations->InAt(1)));
+      break;
+
+    case Primitive::kPrimFloat:
+    case Primitive::kPrimDouble: {
+      vixl::FPRegister lhs = FPRegisterFrom(0, type);
+      vixl::FPRegister rhs = FPRegisterFrom(1, type);
+      __ Fmov(lhs, RegisterFrom(locations->InAt(0), type));
+      __ Fmov(rhs, RegisterFrom(locations->InAt(1), type));
+      __ Fcmp(lhs, rhs);
+      // An unordered comparison, with a NaN, is `lt` but not `mi`.
+      less_cond = compare->IsGtBias() ? vixl::mi : vixl::lt;
+      break;
+    }
+
+    default:
+      LOG(FATAL) << "Unimplemented compare type " << type;
+  }
+  vixl::Register out = WRegisterFrom(locations->Out());
+  // out = (lhs == rhs) ? 0 : 1, then negated if lhs < rhs.
+  __ Cset(out, vixl::ne);
+  __ Cneg(out, out, less_cond);
+}
+
+void LocationsBuilderARM64::VisitIntConstant(HIntConstant* constant) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(constant);
+  locations->SetOut(Location::ConstantLocation(constant));
+  constant->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorARM64::VisitIntConstant(HIntConstant* constant) {
+}
+
+void LocationsBuilderARM64::VisitLongConstant(HLongConstant* constant) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(constant);
+  locations->SetOut(Location::ConstantLocation(constant));
+  constant->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorARM64::VisitLongConstant(HLongConstant* constant) {
+}
+
+void LocationsBuilderARM64::VisitReturnVoid(HReturnVoid* ret) {
+  ret->SetLocations(nullptr);
+}
+
+void InstructionCodeGeneratorARM64::VisitReturnVoid(HReturnVoid* ret) {
+  codegen_->GenerateFrameExit();
+  __ Ret();
+}
+
+void LocationsBuilderARM64::VisitReturn(HReturn* ret) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(ret);
+  switch (ret->InputAt(0)->GetType()) {
+    case Primitive::kPrimBoolean:
+    case Primitive::kPrimByte:
+    case Primitive::kPrimChar:
+    case Primitive::kPrimShort:
+    case Primitive::kPrimInt:
+    case Primitive::kPrimNot:
+    case Primitive::kPrimLong:
+    case Primitive::kPrimFloat:
+    case Primitive::kPrimDouble:
+      locations->SetInAt(0, ARM64CoreLocation(X0));
+      break;
+
+    default:
+      LOG(FATAL) << "Unimplemented return type " << ret->InputAt(0)->GetType();
+  }
+  ret->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorARM64::VisitReturn(HReturn* ret) {
+  if (kIsDebugBuild) {
+    switch (ret->InputAt(0)->GetType()) {
+      case Primitive::kPrimBoolean:
+      case Primitive::kPrimByte:
+      case Primitive::kPrimChar:
+      case Primitive::kPrimShort:
+      case Primitive::kPrimInt:
+      case Primitive::kPrimNot:
+      case Primitive::kPrimLong:
+      case Primitive::kPrimFloat:
+      case Primitive::kPrimDouble:
+        DCHECK_EQ(ret->GetLocations()->InAt(0).AsArm64().AsCoreRegister(), X0);
+        break;
+
+      default:
+        LOG(FATAL) << "Unimplemented return type " << ret->InputAt(0)->GetType();
+    }
+  }
+  // Float and double values are returned in s0 and d0.
+  Primitive::Type return_type = ret->GetReturnType();
+  if (Primitive::IsFloatingPointType(return_type)) {
+    __ Fmov(FPRegisterFrom(0, return_type),
+            RegisterFrom(ret->GetLocations()->InAt(0), return_type));
+  }
+  codegen_->GenerateFrameExit();
+  __ Ret();
+}
+
+Location InvokeDexCallingConventionVisitor::GetNextLocation(Primitive::Type type) {
+  switch (type) {
+    case Primitive::kPrimBoolean:
+    case Primitive::kPrimByte:
+    case Primitive::kPrimChar:
+    case Primitive::kPrimShort:
+    case Primitive::kPrimInt:
+    case Primitive::kPrimNot: {
+      uint32_t index = gp_index_++;
+      stack_index_++;
+      if (index < calling_convention.GetNumberOfRegisters()) {
+        return ARM64CoreLocation(calling_convention.GetRegisterAt(index));
+      } else {
+        return Location::StackSlot(calling_convention.GetStackOffsetOf(stack_index_ - 1));
+      }
+    }
+
+    case Primitive::kPrimLong: {
+      uint32_t index = gp_index_;
+      stack_index_ += 2;
+      if (index < calling_convention.GetNumberOfRegisters()) {
+        gp_index_ += 1;
+        return ARM64CoreLocation(calling_convention.GetRegisterAt(index));
+      } else {
+        gp_index_ += 2;
+        return Location::DoubleStackSlot(calling_convention.GetStackOffsetOf(stack_index_ - 2));
+      }
+    }
+
+    // Float and double arguments are passed in FP registers when there are enough, but
+    // are kept in the stack slot reserved for them. See
+    // InstructionCodeGeneratorARM64::LoadFPArguments and VisitParameterValue.
+    case Primitive::kPrimFloat: {
+      stack_index_++;
+      return Location::StackSlot(calling_convention.GetStackOffsetOf(stack_index_ - 1));
+    }
+
+    case Primitive::kPrimDouble: {
+      stack_index_ += 2;
+      return Location::DoubleStackSlot(calling_convention.GetStackOffsetOf(stack_index_ - 2));
+    }
+
+    case Primitive::kPrimVoid:
+      LOG(FATAL) << "Unexpected parameter type " << type;
+      break;
+  }
+  return Location();
+}
+
+void LocationsBuilderARM64::VisitInvokeStatic(HInvokeStatic* invoke) {
+  HandleInvoke(invoke);
+}
+
+void LocationsBuilderARM64::VisitInvokeVirtual(HInvokeVirtual* invoke) {
+  HandleInvoke(invoke);
+}
+
+void LocationsBuilderARM64::VisitInvokeInterface(HInvokeInterface* invoke) {
+  HandleInvoke(invoke);
+}
+
+void LocationsBuilderARM64::HandleInvoke(HInvoke* invoke) {
+  codegen_->MarkNotLeaf();
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(invoke);
+  locations->AddTemp(ARM64CoreLocation(X0));
+
+  InvokeDexCallingConventionVisitor calling_convention_visitor;
+  for (size_t i = 0; i < invoke->InputCount(); ++i) {
+    HInstruction* input = invoke->InputAt(i);
+    locations->SetInAt(i, calling_convention_visitor.GetNextLocation(input->GetType()));
+  }
+
+  switch (invoke->GetType()) {
+    case Primitive::kPrimBoolean:
+    case Primitive::kPrimByte:
+    case Primitive::kPrimChar:
+    case Primitive::kPrimShort:
+    case Primitive::kPrimInt:
+    case Primitive::kPrimNot:
+    case Primitive::kPrimLong:
+    case Primitive::kPrimFloat:
+    case Primitive::kPrimDouble:
+      locations->SetOut(ARM64CoreLocation(X0));
+      break;
+
+    case Primitive::kPrimVoid:
+      break;
+  }
+
+  invoke->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorARM64::VisitInvokeStatic(HInvokeStatic* invoke) {
+  vixl::Register temp = XRegisterFrom(invoke->GetLocations()->GetTemp(0));
+  uint32_t heap_reference_size = sizeof(mirror::HeapReference<mirror::Object>);
+  size_t index_in_cache = mirror::Array::DataOffset(heap_reference_size).SizeValue() +
+      invoke->GetIndexInDexCache() * heap_reference_size;
+
+  // TODO: Implement all kinds of calls:
+  // 1) boot -> boot
+  // 2) app -> boot
+  // 3) app -> app
+  //
+  // Currently we implement the app -> app logic, which looks up in the resolve cache.
+
+  // temp = method;
+  LoadCurrentMethod(temp);
+  // temp = temp->dex_cache_resolved_methods_;
+  __ Ldr(temp.W(), vixl::MemOperand(temp,
+      mirror::ArtMethod::DexCacheResolvedMethodsOffset().Int32Value()));
+  // temp = temp[index_in_cache];
+  __ Ldr(temp.W(), vixl::MemOperand(temp, index_in_cache));
+  LoadFPArguments(invoke);
+  // lr = temp->entry_point_from_quick_compiled_code_;
+  __ Ldr(LinkRegister(), vixl::MemOperand(temp,
+      mirror::ArtMethod::EntryPointFromQuickCompiledCodeOffset(kArm64PointerSize).Int32Value()));
+  // lr();
+  __ Blr(LinkRegister());
+
+  DCHECK(!codegen_->IsLeafMethod());
+  codegen_->RecordPcInfo(invoke->GetDexPc());
+  MoveFPResult(invoke);
+}
+
+void InstructionCodeGeneratorARM64::VisitInvokeVirtual(HInvokeVirtual* invoke) {
+  LocationSummary* locations = invoke->GetLocations();
+  vixl::Register temp = XRegisterFrom(locations->GetTemp(0));
+  // The receiver is the first argument, which is always passed in a register.
+  vixl::Register receiver = XRegisterFrom(locations->InAt(0));
+  size_t method_offset = mirror::Class::EmbeddedVTableOffset().SizeValue() +
+      invoke->GetVTableIndex() * sizeof(mirror::Class::VTableEntry);
+
+  // temp = receiver->klass_;
+  __ Ldr(temp.W(), vixl::MemOperand(receiver, mirror::Object::ClassOffset().Int32Value()));
+  // temp = temp->embedded_vtable_[vtable_index];
+  __ Ldr(temp.W(), vixl::MemOperand(temp, method_offset));
+  LoadFPArguments(invoke);
+  // lr = temp->entry_point_from_quick_compiled_code_;
+  __ Ldr(LinkRegister(), vixl::MemOperand(temp,
+      mirror::ArtMethod::EntryPointFromQuickCompiledCodeOffset(kArm64PointerSize).Int32Value()));
+  // lr();
+  __ Blr(LinkRegister());
+
+  DCHECK(!codegen_->IsLeafMethod());
+  codegen_->RecordPcInfo(invoke->GetDexPc());
+  MoveFPResult(invoke);
+}
+
+void InstructionCodeGeneratorARM64::VisitInvokeInterface(HInvokeInterface* invoke) {
+  LocationSummary* locations = invoke->GetLocations();
+  vixl::Register temp = XRegisterFrom(locations->GetTemp(0));
+  vixl::Register receiver = XRegisterFrom(locations->InAt(0));
+  size_t method_offset = mirror::Class::EmbeddedImTableOffset().SizeValue() +
+      (invoke->GetImtIndex() % mirror::Class::kImtSize) * sizeof(mirror::Class::ImTableEntry);
+
+  // temp = receiver->klass_;
+  __ Ldr(temp.W(), vixl::MemOperand(receiver, mirror::Object::ClassOffset().Int32Value()));
+  // temp = temp->embedded_imtable_[imt_index];
+  __ Ldr(temp.W(), vixl::MemOperand(temp, method_offset));
+  LoadFPArguments(invoke);
+  // The IMT conflict trampoline expects the dex method index in IP1. Set it last, as
+  // the macro assembler may use IP1 as a scratch register for large offsets.
+  __ Mov(vixl::Register::WRegFromCode(IP1), invoke->GetDexMethodIndex());
+  // lr = temp->entry_point_from_quick_compiled_code_;
+  __ Ldr(LinkRegister(), vixl::MemOperand(temp,
+      mirror::ArtMethod::EntryPointFromQuickCompiledCodeOffset(kArm64PointerSize).Int32Value()));
+  // lr();
+  __ Blr(LinkRegister());
+
+  DCHECK(!codegen_->IsLeafMethod());
+  codegen_->RecordPcInfo(invoke->GetDexPc());
+  MoveFPResult(invoke);
+}
+
+void InstructionCodeGeneratorARM64::LoadFPArguments(HInvoke* invoke) {
+  InvokeDexCallingConvention calling_convention;
+  LocationSummary* locations = invoke->GetLocations();
+  size_t fp_index = 0;
+  for (size_t i = 0; i < invoke->InputCount(); ++i) {
+    // The inputs of an invoke are loads of locals, typed from the signature of the callee.
+    Primitive::Type type = invoke->InputAt(i)->GetType();
+    if (!Primitive::IsFloatingPointType(type)) {
+      continue;
+    }
+    if (fp_index == calling_convention.GetNumberOfFPRegisters()) {
+      // The remaining arguments are passed on the stack.
+      break;
+    }
+    __ Ldr(FPRegisterFrom(calling_convention.GetFPRegisterAt(fp_index++), type),
+           StackOperandFrom(locations->InAt(i)));
+  }
+}
+
+void InstructionCodeGeneratorARM64::MoveFPResult(HInvoke* invoke) {
+  // Float and double values are returned in s0 and d0.
+  Primitive::Type type = invoke->GetType();
+  if (Primitive::IsFloatingPointType(type)) {
+    __ Fmov(RegisterFrom(invoke->GetLocations()->Out(), type), FPRegisterFrom(0, type));
+  }
+}
+
+void LocationsBuilderARM64::VisitAdd(HAdd* add) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(add);
+  switch (add->GetResultType()) {
+    case Primitive::kPrimInt:
+    case Primitive::kPrimLong: {
+      locations->SetInAt(0, Location::RequiresRegister());
+      locations->SetInAt(1, Location::RegisterOrConstant(add->InputAt(1)));
+      locations->SetOut(Location::RequiresRegister());
+      break;
+    }
+
+    case Primitive::kPrimFloat:
+    case Primitive::kPrimDouble: {
+      locations->SetInAt(0, Location::RequiresRegister());
+      locations->SetInAt(1, Location::RequiresRegister());
+      locations->SetOut(Location::RequiresRegister());
+      break;
+    }
+
+    case Primitive::kPrimBoolean:
+    case Primitive::kPrimByte:
+    case Primitive::kPrimChar:
+    case Primitive::kPrimShort:
+      LOG(FATAL) << "Unexpected add type " << add->GetResultType();
+      break;
+
+    default:
+      LOG(FATAL) << "Unimplemented add type " << add->GetResultType();
+  }
+  add->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorARM64::VisitAdd(HAdd* add) {
+  LocationSummary* locations = add->GetLocations();
+  Primitive::Type type = add->GetResultType();
+  switch (type) {
+    case Primitive::kPrimInt:
+    case Primitive::kPrimLong:
+      __ Add(RegisterFrom(locations->Out(), type),
+             RegisterFrom(locations->InAt(0), type),
+             OperandFrom(locations->InAt(1), type));
+      break;
+
+    case Primitive::kPrimFloat:
+    case Primitive::kPrimDouble:
+      HandleFPBinaryOperation(add);
+      break;
+
+    case Primitive::kPrimBoolean:
+    case Primitive::kPrimByte:
+    case Primitive::kPrimChar:
+    case Primitive::kPrimShort:
+      LOG(FATAL) << "Unexpected add type " << type;
+      break;
+
+    default:
+      LOG(FATAL) << "Unimplemented add type " << type;
+  }
+}
+
+void LocationsBuilderARM64::VisitSub(HSub* sub) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(sub);
+  switch (sub->GetResultType()) {
+    case Primitive::kPrimInt:
+    case Primitive::kPrimLong: {
+      locations->SetInAt(0, Location::RequiresRegister());
+      locations->SetInAt(1, Location::RegisterOrConstant(sub->InputAt(1)));
+      locations->SetOut(Location::RequiresRegister());
+      break;
+    }
+
+    case Primitive::kPrimFloat:
+    case Primitive::kPrimDouble: {
+      locations->SetInAt(0, Location::RequiresRegister());
+      locations->SetInAt(1, Location::RequiresRegister());
+      locations->SetOut(Location::RequiresRegister());
+      break;
+    }
+
+    case Primitive::kPrimBoolean:
+    case Primitive::kPrimByte:
+    case Primitive::kPrimChar:
+    case Primitive::kPrimShort:
+      LOG(FATAL) << "Unexpected sub type " << sub->GetResultType();
+      break;
+
+    default:
+      LOG(FATAL) << "Unimplemented sub type " << sub->GetResultType();
+  }
+  sub->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorARM64::VisitSub(HSub* sub) {
+  LocationSummary* locations = sub->GetLocations();
+  Primitive::Type type = sub->GetResultType();
+  switch (type) {
+    case Primitive::kPrimInt:
+    case Primitive::kPrimLong:
+      __ Sub(RegisterFrom(locations->Out(), type),
+             RegisterFrom(locations->InAt(0), type),
+             OperandFrom(locations->InAt(1), type));
+      break;
+
+    case Primitive::kPrimFloat:
+    case Primitive::kPrimDouble:
+      HandleFPBinaryOperation(sub);
+      break;
+
+    case Primitive::kPrimBoolean:
+    case Primitive::kPrimByte:
+    case Primitive::kPrimChar:
+    case Primitive::kPrimShort:
+      LOG(FATAL) << "Unexpected sub type " << type;
+      break;
+
+    default:
+      LOG(FATAL) << "Unimplemented sub type " << type;
+  }
+}
+
+void LocationsBuilderARM64::VisitMul(HMul* mul) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(mul);
+  switch (mul->GetResultType()) {
+    case Primitive::kPrimInt:
+    case Primitive::kPrimLong:
+    case Primitive::kPrimFloat:
+    case Primitive::kPrimDouble: {
+      locations->SetInAt(0, Location::RequiresRegister());
+      locations->SetInAt(1, Location::RequiresRegister());
+      locations->SetOut(Location::RequiresRegister());
+      break;
+    }
+
+    default:
+      LOG(FATAL) << "Unexpected mul type " << mul->GetResultType();
+  }
+  mul->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorARM64::VisitMul(HMul* mul) {
+  LocationSummary* locations = mul->GetLocations();
+  Primitive::Type type = mul->GetResultType();
+  switch (type) {
+    case Primitive::kPrimInt:
+    case Primitive::kPrimLong:
+      __ Mul(RegisterFrom(locations->Out(), type),
+             RegisterFrom(locations->InAt(0), type),
+             RegisterFrom(locations->InAt(1), type));
+      break;
+
+    case Primitive::kPrimFloat:
+    case Primitive::kPrimDouble:
+      HandleFPBinaryOperation(mul);
+      break;
+
+    default:
+      LOG(FATAL) << "Unexpected mul type " << type;
+  }
+}
+
+void LocationsBuilderARM64::VisitDiv(HDiv* div) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(div);
+  locations->SetInAt(0, Location::RequiresRegister());
+  locations->SetInAt(1, Location::RequiresRegister());
+  locations->SetOut(Location::RequiresRegister());
+  div->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorARM64::VisitDiv(HDiv* div) {
+  Primitive::Type type = div->GetResultType();
+  switch (type) {
+    case Primitive::kPrimInt:
+      GenerateIntDivOrRem(div);
+      break;
+
+    case Primitive::kPrimFloat:
+    case Primitive::kPrimDouble:
+      HandleFPBinaryOperation(div);
+      break;
+
+    default:
+      LOG(FATAL) << "Unexpected div type " << type;
+  }
+}
+
+// sdiv does not trap: it returns 0 for a division by zero, which the HDivZeroCheck
+// of the divisor has excluded, and the dividend for the minimum int divided by -1.
+void InstructionCodeGeneratorARM64::GenerateIntDivOrRem(HBinaryOperation* instruction) {
+  DCHECK(instruction->IsDiv() || instruction->IsRem());
+  LocationSummary* locations = instruction->GetLocations();
+  vixl::Register dividend = WRegisterFrom(locations->InAt(0));
+  vixl::Register divisor = WRegisterFrom(locations->InAt(1));
+  vixl::Register out = WRegisterFrom(locations->Out());
+  if (instruction->IsDiv()) {
+    __ Sdiv(out, dividend, divisor);
+  } else {
+    // out = dividend - (dividend / divisor) * divisor
+    vixl::UseScratchRegisterScope temps(GetVIXLAssembler());
+    vixl::Register quotient = temps.AcquireW();
+    __ Sdiv(quotient, dividend, divisor);
+    __ Msub(out, quotient, divisor, dividend);
+  }
+}
+
+void LocationsBuilderARM64::VisitRem(HRem* rem) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(rem);
+  locations->SetInAt(0, Location::RequiresRegister());
+  locations->SetInAt(1, Location::RequiresRegister());
+  locations->SetOut(Location::RequiresRegister());
+  rem->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorARM64::VisitRem(HRem* rem) {
+  Primitive::Type type = rem->GetResultType();
+  switch (type) {
+    case Primitive::kPrimInt:
+      GenerateIntDivOrRem(rem);
+      break;
+
+    default:
+      LOG(FATAL) << "Unexpected rem type " << type;
+  }
+}
+
+void LocationsBuilderARM64::VisitDivZeroCheck(HDivZeroCheck* instruction) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
+  locations->SetInAt(0, Location::RequiresRegister());
+  locations->SetOut(Location::SameAsFirstInput());
+  instruction->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorARM64::VisitDivZeroCheck(HDivZeroCheck* instruction) {
+  SlowPathCodeARM64* slow_path =
+      new (GetGraph()->GetArena()) DivZeroCheckSlowPathARM64(instruction->GetDexPc());
+  codegen_->AddSlowPath(slow_path);
+
+  LocationSummary* locations = instruction->GetLocations();
+  Location value = locations->InAt(0);
+  DCHECK(value.Equals(locations->Out()));
+
+  __ Cbz(WRegisterFrom(value), slow_path->GetEntryLabel());
+}
+
+void InstructionCodeGeneratorARM64::HandleFPBinaryOperation(HBinaryOperation* instruction) {
+  LocationSummary* locations = instruction->GetLocations();
+  Primitive::Type type = instruction->GetResultType();
+  vixl::FPRegister lhs = FPRegisterFrom(0, type);
+  vixl::FPRegister rhs = FPRegisterFrom(1, type);
+  __ Fmov(lhs, RegisterFrom(locations->InAt(0), type));
+  __ Fmov(rhs, RegisterFrom(locations->InAt(1), type));
+  if (instruction->IsAdd()) {
+    __ Fadd(lhs, lhs, rhs);
+  } else if (instruction->IsSub()) {
+    __ Fsub(lhs, lhs, rhs);
+  } else if (instruction->IsMul()) {
+    __ Fmul(lhs, lhs, rhs);
+  } else {
+    DCHECK(instruction->IsDiv());
+    __ Fdiv(lhs, lhs, rhs);
+  }
+  __ Fmov(RegisterFrom(locations->Out(), type), lhs);
+}
+
+void LocationsBuilderARM64::VisitNeg(HNeg* neg) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(neg);
+  locations->SetInAt(0, Location::RequiresRegister());
+  locations->SetOut(Location::RequiresRegister());
+  neg->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorARM64::VisitNeg(HNeg* neg) {
+  LocationSummary* locations = neg->GetLocations();
+  Primitive::Type type = neg->GetResultType();
+  vixl::Register out = RegisterFrom(locations->Out(), type);
+  vixl::Register in = RegisterFrom(locations->InAt(0), type);
+  switch (type) {
+    case Primitive::kPrimInt:
+    case Primitive::kPrimLong:
+      __ Neg(out, vixl::Operand(in));
+      break;
+
+    // Negating a float or a double flips its sign bit, including for NaN and zero.
+    case Primitive::kPrimFloat:
+      __ Eor(out, in, INT64_C(0x80000000));
+      break;
+
+    case Primitive::kPrimDouble:
+      __ Eor(out, in, static_cast<int64_t>(UINT64_C(0x8000000000000000)));
+      break;
+
+    default:
+      LOG(FATAL) << "Unexpected neg type " << type;
+  }
+}
+
+void LocationsBuilderARM64::VisitTypeConversion(HTypeConversion* conversion) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(conversion);
+  locations->SetInAt(0, Location::RequiresRegister());
+  locations->SetOut(Location::RequiresRegister());
+  conversion->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorARM64::VisitTypeConversion(HTypeConversion* conversion) {
+  LocationSummary* locations = conversion->GetLocations();
+  Primitive::Type input_type = conversion->GetInputType();
+  Primitive::Type result_type = conversion->GetResultType();
+  vixl::Register in = RegisterFrom(locations->InAt(0), input_type);
+  vixl::Register out = RegisterFrom(locations->Out(), result_type);
+  switch (result_type) {
+    case Primitive::kPrimByte:
+      DCHECK_EQ(input_type, Primitive::kPrimInt);
+      __ Sxtb(out, in);
+      break;
+
+    case Primitive::kPrimShort:
+      DCHECK_EQ(input_type, Primitive::kPrimInt);
+      __ Sxth(out, in);
+      break;
+
+    case Primitive::kPrimChar:
+      DCHECK_EQ(input_type, Primitive::kPrimInt);
+      __ Uxth(out, in);
+      break;
+
+    case Primitive::kPrimInt:
+    case Primitive::kPrimLong:
+      if (input_type == Primitive::kPrimInt) {
+        __ Sxtw(out, in);
+      } else if (input_type == Primitive::kPrimLong) {
+        __ Mov(out, in.W());
+      } else {
+        // The conversion saturates, and returns zero for NaN, as Java wants.
+        vixl::FPRegister value = FPRegisterFrom(0, input_type);
+        __ Fmov(value, in);
+        __ Fcvtzs(out, value);
+      }
+      break;
+
+    case Primitive::kPrimFloat:
+    case Primitive::kPrimDouble: {
+      vixl::FPRegister value = FPRegisterFrom(0, result_type);
+      if (Primitive::IsFloatingPointType(input_type)) {
+        vixl::FPRegister input = FPRegisterFrom(1, input_type);
+        __ Fmov(input, in);
+        __ Fcvt(value, input);
+      } else {
+        __ Scvtf(value, in);
+      }
+      __ Fmov(out, value);
+      break;
+    }
+
+    default:
+      LOG(FATAL) << "Unexpected type conversion from " << input_type << " to " << result_type;
+  }
+}
+
+void LocationsBuilderARM64::VisitNewInstance(HNewInstance* instruction) {
+  codegen_->MarkNotLeaf();
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
+  locations->SetOut(ARM64CoreLocation(X0));
+  instruction->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorARM64::VisitNewInstance(HNewInstance* instruction) {
+  InvokeRuntimeCallingConvention calling_convention;
+  LoadCurrentMethod(vixl::Register::XRegFromCode(calling_convention.GetRegisterAt(1)));
+  __ Mov(vixl::Register::WRegFromCode(calling_convention.GetRegisterAt(0)),
+         instruction->GetTypeIndex());
+
+  DCHECK(!codegen_->IsLeafMethod());
+  codegen_->InvokeRuntime(
+      QUICK_ENTRYPOINT_OFFSET(kArm64WordSize, pAllocObjectWithAccessCheck).Int32Value(),
+      instruction->GetDexPc());
+}
+
+void LocationsBuilderARM64::VisitLoadClass(HLoadClass* cls) {
+  codegen_->MarkNotLeaf();
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(cls);
+  InvokeRuntimeCallingConvention calling_convention;
+  locations->AddTemp(ARM64CoreLocation(calling_convention.GetRegisterAt(0)));
+  locations->AddTemp(ARM64CoreLocation(calling_convention.GetRegisterAt(1)));
+  locations->SetOut(ARM64CoreLocation(X0));
+  cls->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorARM64::VisitLoadClass(HLoadClass* cls) {
+  InvokeRuntimeCallingConvention calling_convention;
+  vixl::Register method = vixl::Register::XRegFromCode(calling_convention.GetRegisterAt(1));
+  vixl::Register out = WRegisterFrom(cls->GetLocations()->Out());
+  LoadCurrentMethod(method);
+
+  DCHECK(!codegen_->IsLeafMethod());
+  if (cls->NeedsAccessCheck()) {
+    __ Mov(vixl::Register::WRegFromCode(calling_convention.GetRegisterAt(0)),
+           cls->GetTypeIndex());
+    codegen_->InvokeRuntime(
+        QUICK_ENTRYPOINT_OFFSET(kArm64WordSize, pInitializeTypeAndVerifyAccess).Int32Value(),
+        cls->GetDexPc());
+  } else {
+    SlowPathCodeARM64* slow_path = new (GetGraph()->GetArena()) LoadClassSlowPathARM64(
+        cls->GetTypeIndex(), cls->GetDexPc());
+    codegen_->AddSlowPath(slow_path);
+    uint32_t heap_reference_size = sizeof(mirror::HeapReference<mirror::Object>);
+    size_t index_in_cache = mirror::Array::DataOffset(heap_reference_size).SizeValue() +
+        cls->GetTypeIndex() * heap_reference_size;
+    // out = method->dex_cache_resolved_types_[type_index]
+    __ Ldr(out, vixl::MemOperand(method,
+        mirror::ArtMethod::DexCacheResolvedTypesOffset().Int32Value()));
+    __ Ldr(out, vixl::MemOperand(out.X(), index_in_cache));
+    __ Cbz(out, slow_path->GetEntryLabel());
+    __ Bind(slow_path->GetExitLabel());
+  }
+}
+
+// The type checks compare the class of the object with the class checked against, and
+// only call the runtime when they differ.
+static void SetTypeCheckLocations(LocationSummary* locations) {
+  locations->SetInAt(0, Location::RequiresRegister());
+  locations->SetInAt(1, Location::RequiresRegister());
+  InvokeRuntimeCallingConvention calling_convention;
+  locations->AddTemp(ARM64CoreLocation(calling_convention.GetRegisterAt(0)));
+  locations->AddTemp(ARM64CoreLocation(calling_convention.GetRegisterAt(1)));
+}
+
+void LocationsBuilderARM64::VisitInstanceOf(HInstanceOf* instruction) {
+  codegen_->MarkNotLeaf();
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
+  SetTypeCheckLocations(locations);
+  locations->SetOut(ARM64CoreLocation(X0));
+  instruction->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorARM64::VisitInstanceOf(HInstanceOf* instruction) {
+  LocationSummary* locations = instruction->GetLocations();
+  vixl::Register obj = WRegisterFrom(locations->InAt(0));
+  vixl::Register cls = WRegisterFrom(locations->InAt(1));
+  vixl::Register obj_cls = WRegisterFrom(locations->GetTemp(1));
+  vixl::Register out = WRegisterFrom(locations->Out());
+  SlowPathCodeARM64* slow_path = new (GetGraph()->GetArena()) TypeCheckSlowPathARM64(
+      instruction, locations->InAt(1), instruction->GetDexPc());
+  codegen_->AddSlowPath(slow_path);
+  vixl::Label is_null;
+
+  __ Cbz(obj, &is_null);
+  __ Ldr(obj_cls, vixl::MemOperand(obj.X(), mirror::Object::ClassOffset().Int32Value()));
+  __ Cmp(obj_cls, cls);
+  __ B(slow_path->GetEntryLabel(), vixl::ne);
+  __ Mov(out, 1);
+  __ B(slow_path->GetExitLabel());
+  __ Bind(&is_null);
+  __ Mov(out, 0);
+  __ Bind(slow_path->GetExitLabel());
+}
+
+void LocationsBuilderARM64::VisitCheckCast(HCheckCast* instruction) {
+  codegen_->MarkNotLeaf();
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
+  SetTypeCheckLocations(locations);
+  instruction->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorARM64::VisitCheckCast(HCheckCast* instruction) {
+  LocationSummary* locations = instruction->GetLocations();
+  vixl::Register obj = WRegisterFrom(locations->InAt(0));
+  vixl::Register cls = WRegisterFrom(locations->InAt(1));
+  vixl::Register obj_cls = WRegisterFrom(locations->GetTemp(1));
+  SlowPathCodeARM64* slow_path = new (GetGraph()->GetArena()) TypeCheckSlowPathARM64(
+      instruction, locations->InAt(1), instruction->GetDexPc());
+  codegen_->AddSlowPath(slow_path);
+
+  // A null reference can be cast to any type.
+  __ Cbz(obj, slow_path->GetExitLabel());
+  __ Ldr(obj_cls, vixl::MemOperand(obj.X(), mirror::Object::ClassOffset().Int32Value()));
+  __ Cmp(obj_cls, cls);
+  __ B(slow_path->GetEntryLabel(), vixl::ne);
+  __ Bind(slow_path->GetExitLabel());
+}
+
+void LocationsBuilderARM64::VisitParameterValue(HParameterValue* instruction) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
+  Location location = parameter_visitor_.GetNextLocation(instruction->GetType());
+  if (location.IsStackSlot()) {
+    location = Location::StackSlot(location.GetStackIndex() + codegen_->GetFrameSize());
+  } else if (location.IsDoubleStackSlot()) {
+    location = Location::DoubleStackSlot(location.GetStackIndex() + codegen_->GetFrameSize());
+  }
+  locations->SetOut(location);
+  instruction->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorARM64::VisitParameterValue(HParameterValue* instruction) {
+  Primitive::Type type = instruction->GetType();
+  if (!Primitive::IsFloatingPointType(type)) {
+    // Nothing to do, the parameter is already at its location.
+    return;
+  }
+  // Floating-point parameters are passed in FP registers, which the code does not
+  // allocate: spill them to the home slot the parameter visitor gave them.
+  InvokeDexCallingConvention calling_convention;
+  size_t index = number_of_fp_parameters_++;
+  if (index < calling_convention.GetNumberOfFPRegisters()) {
+    __ Str(FPRegisterFrom(calling_convention.GetFPRegisterAt(index), type),
+           StackOperandFrom(instruction->GetLocations()->Out()));
+  }
+}
+
+void LocationsBuilderARM64::VisitNot(HNot* instruction) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
+  locations->SetInAt(0, Location::RequiresRegister());
+  locations->SetOut(Location::RequiresRegister());
+  instruction->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorARM64::VisitNot(HNot* instruction) {
+  LocationSummary* locations = instruction->GetLocations();
+  __ Eor(WRegisterFrom(locations->Out()), WRegisterFrom(locations->InAt(0)), 1);
+}
+
+void LocationsBuilderARM64::VisitPhi(HPhi* instruction) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
+  for (size_t i = 0, e = instruction->InputCount(); i < e; ++i) {
+    locations->SetInAt(i, Location::Any());
+  }
+  locations->SetOut(Location::Any());
+  instruction->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorARM64::VisitPhi(HPhi* instruction) {
+  LOG(FATAL) << "Unimplemented";
+}
+
+void LocationsBuilderARM64::VisitInstanceFieldSet(HInstanceFieldSet* instruction) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
+  locations->SetInAt(0, Location::RequiresRegister());
+  locations->SetInAt(1, Location::RequiresRegister());
+  instruction->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorARM64::VisitInstanceFieldSet(HInstanceFieldSet* instruction) {
+  LocationSummary* locations = instruction->GetLocations();
+  vixl::Register obj = XRegisterFrom(locations->InAt(0));
+  Location value = locations->InAt(1);
+  vixl::MemOperand field(obj, instruction->GetFieldOffset().Int32Value());
+  Primitive::Type field_type = instruction->InputAt(1)->GetType();
+
+  switch (field_type) {
+    case Primitive::kPrimBoolean:
+    case Primitive::kPrimByte: {
+      __ Strb(WRegisterFrom(value), field);
+      break;
+    }
+
+    case Primitive::kPrimShort:
+    case Primitive::kPrimChar: {
+      __ Strh(WRegisterFrom(value), field);
+      break;
+    }
+
+    case Primitive::kPrimInt:
+    case Primitive::kPrimNot:
+    case Primitive::kPrimFloat: {
+      __ Str(WRegisterFrom(value), field);
+      if (field_type == Primitive::kPrimNot) {
+        codegen_->MarkGCCard(obj, WRegisterFrom(value));
+      }
+      break;
+    }
+
+    case Primitive::kPrimLong:
+    case Primitive::kPrimDouble: {
+      __ Str(XRegisterFrom(value), field);
+      break;
+    }
+
+    case Primitive::kPrimVoid:
+      LOG(FATAL) << "Unreachable type " << field_type;
+  }
+}
+
+void LocationsBuilderARM64::VisitInstanceFieldGet(HInstanceFieldGet* instruction) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
+  locations->SetInAt(0, Location::RequiresRegister());
+  locations->SetOut(Location::RequiresRegister());
+  instruction->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorARM64::VisitInstanceFieldGet(HInstanceFieldGet* instruction) {
+  LocationSummary* locations = instruction->GetLocations();
+  vixl::Register obj = XRegisterFrom(locations->InAt(0));
+  Location out = locations->Out();
+  vixl::MemOperand field(obj, instruction->GetFieldOffset().Int32Value());
+
+  switch (instruction->GetType()) {
+    case Primitive::kPrimBoolean: {
+      __ Ldrb(WRegisterFrom(out), field);
+      break;
+    }
+
+    case Primitive::kPrimByte: {
+      __ Ldrsb(WRegisterFrom(out), field);
+      break;
+    }
+
+    case Primitive::kPrimShort: {
+      __ Ldrsh(WRegisterFrom(out), field);
+      break;
+    }
+
+    case Primitive::kPrimChar: {
+      __ Ldrh(WRegisterFrom(out), field);
+      break;
+    }
+
+    case Primitive::kPrimInt:
+    case Primitive::kPrimNot:
+    case Primitive::kPrimFloat: {
+      __ Ldr(WRegisterFrom(out), field);
+      break;
+    }
+
+    case Primitive::kPrimLong:
+    case Primitive::kPrimDouble: {
+      __ Ldr(XRegisterFrom(out), field);
+      break;
+    }
+
+    case Primitive::kPrimVoid:
+      LOG(FATAL) << "Unreachable type " << instruction->GetType();
+  }
+}
+
+void LocationsBuilderARM64::VisitNullCheck(HNullCheck* instruction) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
+  locations->SetInAt(0, Location::RequiresRegister());
+  // TODO: Have a normalization phase that makes this instruction never used.
+  locations->SetOut(Location::SameAsFirstInput());
+  instruction->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorARM64::VisitNullCheck(HNullCheck* instruction) {
+  SlowPathCodeARM64* slow_path =
+      new (GetGraph()->GetArena()) NullCheckSlowPathARM64(instruction->GetDexPc());
+  codegen_->AddSlowPath(slow_path);
+
+  LocationSummary* locations = instruction->GetLocations();
+  Location obj = locations->InAt(0);
+  DCHECK(obj.Equals(locations->Out()));
+
+  __ Cbz(WRegisterFrom(obj), slow_path->GetEntryLabel());
+}
+
+// Returns the address of the element at `index` of the array in `obj`. The address is
+// computed in `temp` when the index is not a constant.
+static vixl::MemOperand ArrayElementFrom(vixl::MacroAssembler* masm,
+                                         const vixl::Register& obj,
+                                         Location index,
+                                         size_t element_size,
+                                         const vixl::Register& temp) {
+  uint32_t data_offset = mirror::Array::DataOffset(element_size).Uint32Value();
+  if (index.IsConstant()) {
+    return vixl::MemOperand(
+        obj, index.GetConstant()->AsIntConstant()->GetValue() * element_size + data_offset);
+  }
+  masm->Add(temp, obj, data_offset);
+  return vixl::MemOperand(temp, WRegisterFrom(index), vixl::SXTW, CTZ(element_size));
+}
+
+void LocationsBuilderARM64::VisitArrayGet(HArrayGet* instruction) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
+  locations->SetInAt(0, Location::RequiresRegister());
+  locations->SetInAt(1, Location::RegisterOrConstant(instruction->InputAt(1)));
+  locations->SetOut(Location::RequiresRegister());
+  instruction->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorARM64::VisitArrayGet(HArrayGet* instruction) {
+  LocationSummary* locations = instruction->GetLocations();
+  vixl::Register obj = XRegisterFrom(locations->InAt(0));
+  Location index = locations->InAt(1);
+  Location out = locations->Out();
+  vixl::UseScratchRegisterScope temps(GetVIXLAssembler());
+  vixl::Register temp = temps.AcquireX();
+
+  switch (instruction->GetType()) {
+    case Primitive::kPrimBoolean:
+      __ Ldrb(WRegisterFrom(out),
+              ArrayElementFrom(GetVIXLAssembler(), obj, index, sizeof(uint8_t), temp));
+      break;
+
+    case Primitive::kPrimByte:
+      __ Ldrsb(WRegisterFrom(out),
+               ArrayElementFrom(GetVIXLAssembler(), obj, index, sizeof(int8_t), temp));
+      break;
+
+    case Primitive::kPrimShort:
+      __ Ldrsh(WRegisterFrom(out),
+               ArrayElementFrom(GetVIXLAssembler(), obj, index, sizeof(int16_t), temp));
+      break;
+
+    case Primitive::kPrimChar:
+      __ Ldrh(WRegisterFrom(out),
+              ArrayElementFrom(GetVIXLAssembler(), obj, index, sizeof(uint16_t), temp));
+      break;
+
+    case Primitive::kPrimInt:
+    case Primitive::kPrimNot:
+    case Primitive::kPrimFloat:
+      DCHECK_EQ(sizeof(mirror::HeapReference<mirror::Object>), sizeof(int32_t));
+      __ Ldr(WRegisterFrom(out),
+             ArrayElementFrom(GetVIXLAssembler(), obj, index, sizeof(int32_t), temp));
+      break;
+
+    case Primitive::kPrimLong:
+    case Primitive::kPrimDouble:
+      __ Ldr(XRegisterFrom(out),
+             ArrayElementFrom(GetVIXLAssembler(), obj, index, sizeof(int64_t), temp));
+      break;
+
+    case Primitive::kPrimVoid:
+      LOG(FATAL) << "Unreachable type " << instruction->GetType();
+  }
+}
+
+void LocationsBuilderARM64::VisitArraySet(HArraySet* instruction) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
+  Primitive::Type value_type = instruction->InputAt(2)->GetType();
+  if (value_type == Primitive::kPrimNot) {
+    InvokeRuntimeCallingConvention calling_convention;
+    locations->SetInAt(0, ARM64CoreLocation(calling_convention.GetRegisterAt(0)));
+    locations->SetInAt(1, ARM64CoreLocation(calling_convention.GetRegisterAt(1)));
+    locations->SetInAt(2, ARM64CoreLocation(calling_convention.GetRegisterAt(2)));
+    codegen_->MarkNotLeaf();
+  } else {
+    locations->SetInAt(0, Location::RequiresRegister());
+    locations->SetInAt(1, Location::RegisterOrConstant(instruction->InputAt(1)));
+    locations->SetInAt(2, Location::RequiresRegister());
+  }
+  instruction->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorARM64::VisitArraySet(HArraySet* instruction) {
+  LocationSummary* locations = instruction->GetLocations();
+  Primitive::Type value_type = instruction->InputAt(2)->GetType();
+
+  if (value_type == Primitive::kPrimNot) {
+    DCHECK(!codegen_->IsLeafMethod());
+    codegen_->InvokeRuntime(QUICK_ENTRYPOINT_OFFSET(kArm64WordSize, pAputObject).Int32Value(),
+                            instruction->GetDexPc());
+    return;
+  }
+
+  vixl::Register obj = XRegisterFrom(locations->InAt(0));
+  Location index = locations->InAt(1);
+  Location value = locations->InAt(2);
+  vixl::UseScratchRegisterScope temps(GetVIXLAssembler());
+  vixl::Register temp = temps.AcquireX();
+
+  switch (value_type) {
+    case Primitive::kPrimBoolean:
+    case Primitive::kPrimByte:
+      __ Strb(WRegisterFrom(value),
+              ArrayElementFrom(GetVIXLAssembler(), obj, index, sizeof(uint8_t), temp));
+      break;
+
+    case Primitive::kPrimShort:
+    case Primitive::kPrimChar:
+      __ Strh(WRegisterFrom(value),
+              ArrayElementFrom(GetVIXLAssembler(), obj, index, sizeof(uint16_t), temp));
+      break;
+
+    case Primitive::kPrimInt:
+    case Primitive::kPrimFloat:
+      __ Str(WRegisterFrom(value),
+             ArrayElementFrom(GetVIXLAssembler(), obj, index, sizeof(int32_t), temp));
+      break;
+
+    case Primitive::kPrimLong:
+    case Primitive::kPrimDouble:
+      __ Str(XRegisterFrom(value),
+             ArrayElementFrom(GetVIXLAssembler(), obj, index, sizeof(int64_t), temp));
+      break;
+
+    case Primitive::kPrimNot:
+    case Primitive::kPrimVoid:
+      LOG(FATAL) << "Unreachable type " << instruction->GetType();
+  }
+}
+
+void LocationsBuilderARM64::VisitArrayLength(HArrayLength* instruction) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
+  locations->SetInAt(0, Location::RequiresRegister());
+  locations->SetOut(Location::RequiresRegister());
+  instruction->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorARM64::VisitArrayLength(HArrayLength* instruction) {
+  LocationSummary* locations = instruction->GetLocations();
+  uint32_t offset = mirror::Array::LengthOffset().Uint32Value();
+  __ Ldr(WRegisterFrom(locations->Out()),
+         vixl::MemOperand(XRegisterFrom(locations->InAt(0)), offset));
+}
+
+void LocationsBuilderARM64::VisitBoundsCheck(HBoundsCheck* instruction) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
+  locations->SetInAt(0, Location::RequiresRegister());
+  locations->SetInAt(1, Location::RequiresRegister());
+  // TODO: Have a normalization phase that makes this instruction never used.
+  locations->SetOut(Location::SameAsFirstInput());
+  instruction->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorARM64::VisitBoundsCheck(HBoundsCheck* instruction) {
+  LocationSummary* locations = instruction->GetLocations();
+  SlowPathCodeARM64* slow_path = new (GetGraph()->GetArena()) BoundsCheckSlowPathARM64(
+      instruction->GetDexPc(), locations->InAt(0), locations->InAt(1));
+  codegen_->AddSlowPath(slow_path);
+
+  // An unsigned comparison also catches negative indices.
+  __ Cmp(WRegisterFrom(locations->InAt(0)), WRegisterFrom(locations->InAt(1)));
+  __ B(slow_path->GetEntryLabel(), vixl::hs);
+}
+
+void CodeGeneratorARM64::MarkGCCard(const vixl::Register& object, const vixl::Register& value) {
+  vixl::UseScratchRegisterScope temps(GetVIXLAssembler());
+  vixl::Register card = temps.AcquireX();
+  vixl::Register temp = temps.AcquireX();
+  vixl::Label is_null;
+  __ Cbz(value, &is_null);
+  __ Ldr(card, vixl::MemOperand(ThreadRegister(),
+                                Thread::CardTableOffset<kArm64WordSize>().Int32Value()));
+  __ Lsr(temp, object, gc::accounting::CardTable::kCardShift);
+  // The card table base is biased so that its low byte is the dirty card value.
+  __ Strb(card.W(), vixl::MemOperand(card, temp));
+  __ Bind(&is_null);
+}
+
+void LocationsBuilderARM64::VisitTemporary(HTemporary* temp) {
+  temp->SetLocations(nullptr);
+}
+
+void InstructionCodeGeneratorARM64::VisitTemporary(HTemporary* temp) {
+  // Nothing to do, this is driven by the code generator.
+}
+
+void LocationsBuilderARM64::VisitParallelMove(HParallelMove* instruction) {
+  LOG(FATAL) << "Unimplemented";
+}
+
+void InstructionCodeGeneratorARM64::VisitParallelMove(HParallelMove* instruction) {
+  codegen_->GetMoveResolver()->EmitNativeCode(instruction);
+}
+
+vixl::MacroAssembler* ParallelMoveResolverARM64::GetVIXLAssembler() const {
+  return codegen_->GetVIXLAssembler();
+}
+
+void ParallelMoveResolverARM64::EmitMove(size_t index) {
+  MoveOperands* move = moves_.Get(index);
+  codegen_->Move(move->GetDestination(), move->GetSource());
+}
+
+void ParallelMoveResolverARM64::Exchange(const vixl::Register& reg, int mem) {
+  vixl::UseScratchRegisterScope temps(GetVIXLAssembler());
+  vixl::Register temp = reg.Is64Bits() ? temps.AcquireX() : temps.AcquireW();
+  __ Ldr(temp, vixl::MemOperand(vixl::sp, mem));
+  __ Str(reg, vixl::MemOperand(vixl::sp, mem));
+  __ Mov(reg, temp);
+}
+
+void ParallelMoveResolverARM64::Exchange(int mem1, int mem2, bool is_64bit) {
+  // VIXL has two scratch registers, so no register of the graph needs to be spilled.
+  vixl::UseScratchRegisterScope temps(GetVIXLAssembler());
+  vixl::Register temp1 = is_64bit ? temps.AcquireX() : temps.AcquireW();
+  vixl::Register temp2 = is_64bit ? temps.AcquireX() : temps.AcquireW();
+  __ Ldr(temp1, vixl::MemOperand(vixl::sp, mem1));
+  __ Ldr(temp2, vixl::MemOperand(vixl::sp, mem2));
+  __ Str(temp1, vixl::MemOperand(vixl::sp, mem2));
+  __ Str(temp2, vixl::MemOperand(vixl::sp, mem1));
+}
+
+void ParallelMoveResolverARM64::EmitSwap(size_t index) {
+  MoveOperands* move = moves_.Get(index);
+  Location source = move->GetSource();
+  Location destination = move->GetDestination();
+
+  if (source.IsRegister() && destination.IsRegister()) {
+    vixl::UseScratchRegisterScope temps(GetVIXLAssembler());
+    vixl::Register temp = temps.AcquireX();
+    __ Mov(temp, XRegisterFrom(source));
+    __ Mov(XRegisterFrom(source), XRegisterFrom(destination));
+    __ Mov(XRegisterFrom(destination), temp);
+  } else if (source.IsRegister() && destination.IsStackSlot()) {
+    Exchange(WRegisterFrom(source), destination.GetStackIndex());
+  } else if (source.IsStackSlot() && destination.IsRegister()) {
+    Exchange(WRegisterFrom(destination), source.GetStackIndex());
+  } else if (source.IsStackSlot() && destination.IsStackSlot()) {
+    Exchange(source.GetStackIndex(), destination.GetStackIndex(), false);
+  } else if (source.IsRegister() && destination.IsDoubleStackSlot()) {
+    Exchange(XRegisterFrom(source), destination.GetStackIndex());
+  } else if (source.IsDoubleStackSlot() && destination.IsRegister()) {
+    Exchange(XRegisterFrom(destination), source.GetStackIndex());
+  } else if (source.IsDoubleStackSlot() && destination.IsDoubleStackSlot()) {
+    Exchange(source.GetStackIndex(), destination.GetStackIndex(), true);
+  } else {
+    LOG(FATAL) << "Unimplemented";
+  }
+}
+
+void ParallelMoveResolverARM64::SpillScratch(int reg) {
+  LOG(FATAL) << "Unreachable: swaps use the scratch registers of VIXL";
+}
+
+void ParallelMoveResolverARM64::RestoreScratch(int reg) {
+  LOG(FATAL) << "Unreachable: swaps use the scratch registers of VIXL";
+}
+
+}  // namespace arm64
+}  // namespace art
@@ -24,6 +24,7 @@
 #include "entrypoints/quick/quick_entrypoints.h"
 #include "mirror/array.h"
 #include "mirror/art_method.h"
+#include "mirror/class.h"
 #include "thread.h"
 
 namespace art {
@@ -97,11 +98,14 @@ class BoundsCheckSlowPathX86 : public SlowPathCode {
       : dex_pc_(dex_pc), index_location_(index_location), length_location_(length_location) {}
 
   virtual void EmitNativeCode(CodeGenerator* codegen) OVERRIDE {
-    CodeGeneratorX86* x86_codegen = reinterpret_cast<CodeGeneratorX86*>(codegen);
     __ Bind(GetEntryLabel());
     InvokeRuntimeCallingConvention calling_convention;
-    x86_codegen->Move32(X86CpuLocation(calling_convention.GetRegisterAt(0)), index_location_);
-    x86_codegen->Move32(X86CpuLocation(calling_convention.GetRegisterAt(1)), length_location_);
+    // We're moving two locations to locations that could overlap, so we need a parallel
+    // move resolver.
+    codegen->EmitParallelMoves(index_location_,
+                               X86CpuLocation(calling_convention.GetRegisterAt(0)),
+                               length_location_,
+                               X86CpuLocation(calling_convention.GetRegisterAt(1)));
     __ fs()->call(Address::Absolute(QUICK_ENTRYPOINT_OFFSET(kX86WordSize, pThrowArrayBounds)));
     codegen->RecordPcInfo(dex_pc_);
   }
@@ -114,6 +118,73 @@ class BoundsCheckSlowPathX86 : public SlowPathCode {
   DISALLOW_COPY_AND_ASSIGN(BoundsCheckSlowPathX86);
 };
 
+class DivZeroCheckSlowPathX86 : public SlowPathCode {
+ public:
+  explicit DivZeroCheckSlowPathX86(uint32_t dex_pc) : dex_pc_(dex_pc) {}
+
+  virtual void EmitNativeCode(CodeGenerator* codegen) OVERRIDE {
+    __ Bind(GetEntryLabel());
+    __ fs()->call(Address::Absolute(QUICK_ENTRYPOINT_OFFSET(kX86WordSize, pThrowDivZero)));
+    codegen->RecordPcInfo(dex_pc_);
+  }
+
+ private:
+  const uint32_t dex_pc_;
+  DISALLOW_COPY_AND_ASSIGN(DivZeroCheckSlowPathX86);
+};
+
+// Resolves a class missing from the dex cache. The current method is already in the
+// second argument register, and the runtime returns the class in EAX.
+class LoadClassSlowPathX86 : public SlowPathCode {
+ public:
+  LoadClassSlowPathX86(uint16_t type_index, uint32_t dex_pc)
+      : type_index_(type_index), dex_pc_(dex_pc) {}
+
+  virtual void EmitNativeCode(CodeGenerator* codegen) OVERRIDE {
+    __ Bind(GetEntryLabel());
+    InvokeRuntimeCallingConvention calling_convention;
+    __ movl(calling_convention.GetRegisterAt(0), Immediate(type_index_));
+    __ fs()->call(Address::Absolute(QUICK_ENTRYPOINT_OFFSET(kX86WordSize, pInitializeType)));
+    codegen->RecordPcInfo(dex_pc_);
+    __ jmp(GetExitLabel());
+  }
+
+ private:
+  const uint16_t type_index_;
+  const uint32_t dex_pc_;
+
+  DISALLOW_COPY_AND_ASSIGN(LoadClassSlowPathX86);
+};
+
+// Calls the runtime for the instanceof or check-cast whose class did not match the class
+// of the object exactly. The class of the object is already in the second argument register.
+class TypeCheckSlowPathX86 : public SlowPathCode {
+ public:
+  TypeCheckSlowPathX86(HInstruction* instruction, Location class_location)
+      : instruction_(instruction), class_location_(class_location) {}
+
+  virtual void EmitNativeCode(CodeGenerator* codegen) OVERRIDE {
+    __ Bind(GetEntryLabel());
+    InvokeRuntimeCallingConvention calling_convention;
+    __ movl(calling_convention.GetRegisterAt(0), class_location_.AsX86().AsCpuRegister());
+    if (instruction_->IsInstanceOf()) {
+      __ fs()->call(
+          Address::Absolute(QUICK_ENTRYPOINT_OFFSET(kX86WordSize, pInstanceofNonTrivial)));
+    } else {
+      DCHECK(instruction_->IsCheckCast());
+      __ fs()->call(Address::Absolute(QUICK_ENTRYPOINT_OFFSET(kX86WordSize, pCheckCast)));
+      codegen->RecordPcInfo(instruction_->AsCheckCast()->GetDexPc());
+    }
+    __ jmp(GetExitLabel());
+  }
+
+ private:
+  HInstruction* const instruction_;
+  const Location class_location_;
+
+  DISALLOW_COPY_AND_ASSIGN(TypeCheckSlowPathX86);
+};
+
 #undef __
 #define __ reinterpret_cast<X86Assembler*>(GetAssembler())->
 
@@ -156,7 +227,8 @@ static bool* GetBlockedRegisterPairs(bool* blocked_registers) {
 ManagedRegister CodeGeneratorX86::AllocateFreeRegister(Primitive::Type type,
                                                        bool* blocked_registers) const {
   switch (type) {
-    case Primitive::kPrimLong: {
+    case Primitive::kPrimLong:
+    case Primitive::kPrimDouble: {
       bool* blocked_register_pairs = GetBlockedRegisterPairs(blocked_registers);
       size_t reg = AllocateFreeRegisterInternal(blocked_register_pairs, kNumberOfRegisterPairs);
       X86ManagedRegister pair =
@@ -182,7 +254,8 @@ ManagedRegister CodeGeneratorX86::AllocateFreeRegister(Primitive::Type type,
     case Primitive::kPrimChar:
     case Primitive::kPrimShort:
     case Primitive::kPrimInt:
-    case Primitive::kPrimNot: {
+    case Primitive::kPrimNot:
+    case Primitive::kPrimFloat: {
       Register reg = static_cast<Register>(
           AllocateFreeRegisterInternal(blocked_registers, kNumberOfCpuRegisters));
       // Block all register pairs that contain `reg`.
@@ -197,10 +270,6 @@ ManagedRegister CodeGeneratorX86::AllocateFreeRegister(Primitive::Type type,
       return X86ManagedRegister::FromCpuRegister(reg);
     }
 
-    case Primitive::kPrimFloat:
-    case Primitive::kPrimDouble:
-      LOG(FATAL) << "Unimplemented register type " << type;
-
     case Primitive::kPrimVoid:
       LOG(FATAL) << "Unreachable type " << type;
   }
@@ -265,8 +334,8 @@ void CodeGeneratorX86::GenerateFrameExit() {
   __ addl(ESP, Immediate(GetFrameSize() - kNumberOfPushedRegistersAtEntry * kX86WordSize));
 }
 
-void CodeGeneratorX86::Bind(Label* label) {
-  __ Bind(label);
+void CodeGeneratorX86::Bind(HBasicBlock* block) {
+  __ Bind(GetLabelOf(block));
 }
 
 void InstructionCodeGeneratorX86::LoadCurrentMethod(Register reg) {
@@ -276,16 +345,14 @@ void InstructionCodeGeneratorX86::LoadCurrentMethod(Register reg) {
 Location CodeGeneratorX86::GetStackLocation(HLoadLocal* load) const {
   switch (load->GetType()) {
     case Primitive::kPrimLong:
+    case Primitive::kPrimDouble:
       return Location::DoubleStackSlot(GetStackSlot(load->GetLocal()));
       break;
 
     case Primitive::kPrimInt:
     case Primitive::kPrimNot:
-      return Location::StackSlot(GetStackSlot(load->GetLocal()));
-
     case Primitive::kPrimFloat:
-    case Primitive::kPrimDouble:
-      LOG(FATAL) << "Unimplemented type " << load->GetType();
+      return Location::StackSlot(GetStackSlot(load->GetLocal()));
 
     case Primitive::kPrimBoolean:
     case Primitive::kPrimByte:
@@ -306,7 +373,8 @@ Location InvokeDexCallingConventionVisitor::GetNextLocation(Primitive::Type type
     case Primitive::kPrimChar:
     case Primitive::kPrimShort:
     case Primitive::kPrimInt:
-    case Primitive::kPrimNot: {
+    case Primitive::kPrimNot:
+    case Primitive::kPrimFloat: {
       uint32_t index = gp_index_++;
       if (index < calling_convention.GetNumberOfRegisters()) {
         return X86CpuLocation(calling_convention.GetRegisterAt(index));
@@ -315,7 +383,9 @@ Location InvokeDexCallingConventionVisitor::GetNextLocation(Primitive::Type type
       }
     }
 
-    case Primitive::kPrimLong: {
+    // Float and double arguments are passed in core registers, like int and long ones.
+    case Primitive::kPrimLong:
+    case Primitive::kPrimDouble: {
       uint32_t index = gp_index_;
       gp_index_ += 2;
       if (index + 1 < calling_convention.GetNumberOfRegisters()) {
@@ -328,11 +398,6 @@ Location InvokeDexCallingConventionVisitor::GetNextLocation(Primitive::Type type
       }
     }
 
-    case Primitive::kPrimDouble:
-    case Primitive::kPrimFloat:
-      LOG(FATAL) << "Unimplemented parameter type " << type;
-      break;
-
     case Primitive::kPrimVoid:
       LOG(FATAL) << "Unexpected parameter type " << type;
       break;
@@ -445,10 +510,12 @@ void CodeGeneratorX86::Move(HInstruction* instruction, Location location, HInstr
       case Primitive::kPrimShort:
       case Primitive::kPrimInt:
       case Primitive::kPrimNot:
+      case Primitive::kPrimFloat:
         Move32(location, Location::StackSlot(GetStackSlot(instruction->AsLoadLocal()->GetLocal())));
         break;
 
       case Primitive::kPrimLong:
+      case Primitive::kPrimDouble:
         Move64(location, Location::DoubleStackSlot(
             GetStackSlot(instruction->AsLoadLocal()->GetLocal())));
         break;
@@ -465,10 +532,12 @@ void CodeGeneratorX86::Move(HInstruction* instruction, Location location, HInstr
       case Primitive::kPrimShort:
       case Primitive::kPrimInt:
       case Primitive::kPrimNot:
+      case Primitive::kPrimFloat:
         Move32(location, instruction->GetLocations()->Out());
         break;
 
       case Primitive::kPrimLong:
+      case Primitive::kPrimDouble:
         Move64(location, instruction->GetLocations()->Out());
         break;
 
@@ -505,42 +574,60 @@ void InstructionCodeGeneratorX86::VisitExit(HExit* exit) {
 void LocationsBuilderX86::VisitIf(HIf* if_instr) {
   LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(if_instr);
   HInstruction* cond = if_instr->InputAt(0);
-  DCHECK(cond->IsCondition());
-  HCondition* condition = cond->AsCondition();
-  if (condition->NeedsMaterialization()) {
-    locations->SetInAt(0, Location::Any());
+  if (cond->IsIntConstant()) {
+    // A condition folded to a constant: the branch taken is known.
+    locations->SetInAt(0, Location::ConstantLocation(cond->AsConstant()));
+  } else {
+    DCHECK(cond->IsCondition());
+    HCondition* condition = cond->AsCondition();
+    if (condition->NeedsMaterialization()) {
+      locations->SetInAt(0, Location::Any());
+    }
   }
   if_instr->SetLocations(locations);
 }
 
 void InstructionCodeGeneratorX86::VisitIf(HIf* if_instr) {
   HInstruction* cond = if_instr->InputAt(0);
-  DCHECK(cond->IsCondition());
-  HCondition* condition = cond->AsCondition();
-  if (condition->NeedsMaterialization()) {
-    // Materialized condition, compare against 0
-    Location lhs = if_instr->GetLocations()->InAt(0);
-    if (lhs.IsRegister()) {
-      __ cmpl(lhs.AsX86().AsCpuRegister(), Immediate(0));
+  if (cond->IsIntConstant()) {
+    // The condition was folded to 0 or 1.
+    int32_t cond_value = cond->AsIntConstant()->GetValue();
+    if (cond_value == 1) {
+      if (!codegen_->GoesToNextBlock(if_instr->GetBlock(), if_instr->IfTrueSuccessor())) {
+        __ jmp(codegen_->GetLabelOf(if_instr->IfTrueSuccessor()));
+      }
+      return;
     } else {
-      __ cmpl(Address(ESP, lhs.GetStackIndex()), Immediate(0));
+      DCHECK_EQ(cond_value, 0);
     }
-    __ j(kEqual,  codegen_->GetLabelOf(if_instr->IfTrueSuccessor()));
   } else {
-    Location lhs = condition->GetLocations()->InAt(0);
-    Location rhs = condition->GetLocations()->InAt(1);
-    // LHS is guaranteed to be in a register (see LocationsBuilderX86::VisitCondition).
-    if (rhs.IsRegister()) {
-      __ cmpl(lhs.AsX86().AsCpuRegister(), rhs.AsX86().AsCpuRegister());
-    } else if (rhs.IsConstant()) {
-      HIntConstant* instruction = rhs.GetConstant()->AsIntConstant();
-      Immediate imm(instruction->AsIntConstant()->GetValue());
-      __ cmpl(lhs.AsX86().AsCpuRegister(), imm);
+    DCHECK(cond->IsCondition());
+    HCondition* condition = cond->AsCondition();
+    if (condition->NeedsMaterialization()) {
+      // Materialized condition, compare against 0
+      Location lhs = if_instr->GetLocations()->InAt(0);
+      if (lhs.IsRegister()) {
+        __ cmpl(lhs.AsX86().AsCpuRegister(), Immediate(0));
+      } else {
+        __ cmpl(Address(ESP, lhs.GetStackIndex()), Immediate(0));
+      }
+      __ j(kEqual,  codegen_->GetLabelOf(if_instr->IfTrueSuccessor()));
     } else {
-      __ cmpl(lhs.AsX86().AsCpuRegister(), Address(ESP, rhs.GetStackIndex()));
+      Location lhs = condition->GetLocations()->InAt(0);
+      Location rhs = condition->GetLocations()->InAt(1);
+      // LHS is guaranteed to be in a register (see LocationsBuilderX86::VisitCondition).
+      if (rhs.IsRegister()) {
+        __ cmpl(lhs.AsX86().AsCpuRegister(), rhs.AsX86().AsCpuRegister());
+      } else if (rhs.IsConstant()) {
+        HIntConstant* instruction = rhs.GetConstant()->AsIntConstant();
+        Immediate imm(instruction->AsIntConstant()->GetValue());
+        __ cmpl(lhs.AsX86().AsCpuRegister(), imm);
+      } else {
+        __ cmpl(lhs.AsX86().AsCpuRegister(), Address(ESP, rhs.GetStackIndex()));
+      }
+      __ j(X86Condition(condition->GetCondition()),
+           codegen_->GetLabelOf(if_instr->IfTrueSuccessor()));
     }
-    __ j(X86Condition(condition->GetCondition()),
-         codegen_->GetLabelOf(if_instr->IfTrueSuccessor()));
   }
   if (!codegen_->GoesToNextBlock(if_instr->GetBlock(), if_instr->IfFalseSuccessor())) {
     __ jmp(codegen_->GetLabelOf(if_instr->IfFalseSuccessor()));
@@ -572,10 +659,12 @@ void LocationsBuilderX86::VisitStoreLocal(HStoreLocal* store) {
     case Primitive::kPrimShort:
     case Primitive::kPrimInt:
     case Primitive::kPrimNot:
+    case Primitive::kPrimFloat:
       locations->SetInAt(1, Location::StackSlot(codegen_->GetStackSlot(store->GetLocal())));
       break;
 
     case Primitive::kPrimLong:
+    case Primitive::kPrimDouble:
       locations->SetInAt(1, Location::DoubleStackSlot(codegen_->GetStackSlot(store->GetLocal())));
       break;
 
@@ -701,10 +790,12 @@ void LocationsBuilderX86::VisitReturn(HReturn* ret) {
     case Primitive::kPrimShort:
     case Primitive::kPrimInt:
     case Primitive::kPrimNot:
+    case Primitive::kPrimFloat:
       locations->SetInAt(0, X86CpuLocation(EAX));
       break;
 
     case Primitive::kPrimLong:
+    case Primitive::kPrimDouble:
       locations->SetInAt(
           0, Location::RegisterLocation(X86ManagedRegister::FromRegisterPair(EAX_EDX)));
       break;
@@ -724,10 +815,12 @@ void InstructionCodeGeneratorX86::VisitReturn(HReturn* ret) {
       case Primitive::kPrimShort:
       case Primitive::kPrimInt:
       case Primitive::kPrimNot:
+      case Primitive::kPrimFloat:
         DCHECK_EQ(ret->GetLocations()->InAt(0).AsX86().AsCpuRegister(), EAX);
         break;
 
       case Primitive::kPrimLong:
+      case Primitive::kPrimDouble:
         DCHECK_EQ(ret->GetLocations()->InAt(0).AsX86().AsRegisterPair(), EAX_EDX);
         break;
 
@@ -735,11 +828,28 @@ void InstructionCodeGeneratorX86::VisitReturn(HReturn* ret) {
         LOG(FATAL) << "Unimplemented return type " << ret->InputAt(0)->GetType();
     }
   }
+  // Float and double values are returned in XMM0.
+  Primitive::Type return_type = ret->GetReturnType();
+  if (Primitive::IsFloatingPointType(return_type)) {
+    MoveToFpuRegister(XMM0, ret->GetLocations()->InAt(0), return_type == Primitive::kPrimDouble);
+  }
   codegen_->GenerateFrameExit();
   __ ret();
 }
 
 void LocationsBuilderX86::VisitInvokeStatic(HInvokeStatic* invoke) {
+  HandleInvoke(invoke);
+}
+
+void LocationsBuilderX86::VisitInvokeVirtual(HInvokeVirtual* invoke) {
+  HandleInvoke(invoke);
+}
+
+void LocationsBuilderX86::VisitInvokeInterface(HInvokeInterface* invoke) {
+  HandleInvoke(invoke);
+}
+
+void LocationsBuilderX86::HandleInvoke(HInvoke* invoke) {
   codegen_->MarkNotLeaf();
   LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(invoke);
   locations->AddTemp(X86CpuLocation(EAX));
@@ -757,20 +867,17 @@ void LocationsBuilderX86::VisitInvokeStatic(HInvokeStatic* invoke) {
     case Primitive::kPrimShort:
     case Primitive::kPrimInt:
     case Primitive::kPrimNot:
+    case Primitive::kPrimFloat:
       locations->SetOut(X86CpuLocation(EAX));
       break;
 
     case Primitive::kPrimLong:
+    case Primitive::kPrimDouble:
       locations->SetOut(Location::RegisterLocation(X86ManagedRegister::FromRegisterPair(EAX_EDX)));
       break;
 
     case Primitive::kPrimVoid:
       break;
-
-    case Primitive::kPrimDouble:
-    case Primitive::kPrimFloat:
-      LOG(FATAL) << "Unimplemented return type " << invoke->GetType();
-      break;
   }
 
   invoke->SetLocations(locations);
@@ -801,6 +908,103 @@ void InstructionCodeGeneratorX86::VisitInvokeStatic(HInvokeStatic* invoke) {
 
   DCHECK(!codegen_->IsLeafMethod());
   codegen_->RecordPcInfo(invoke->GetDexPc());
+  if (Primitive::IsFloatingPointType(invoke->GetType())) {
+    // Float and double values are returned in XMM0.
+    MoveFromFpuRegister(invoke->GetLocations()->Out(), XMM0,
+                        invoke->GetType() == Primitive::kPrimDouble);
+  }
+}
+
+void InstructionCodeGeneratorX86::VisitInvokeVirtual(HInvokeVirtual* invoke) {
+  LocationSummary* locations = invoke->GetLocations();
+  Register temp = locations->GetTemp(0).AsX86().AsCpuRegister();
+  // The receiver is the first argument, which is always passed in a register.
+  Register receiver = locations->InAt(0).AsX86().AsCpuRegister();
+  uint32_t method_offset = mirror::Class::EmbeddedVTableOffset().Uint32Value() +
+      invoke->GetVTableIndex() * sizeof(mirror::Class::VTableEntry);
+
+  // temp = receiver->klass_;
+  __ movl(temp, Address(receiver, mirror::Object::ClassOffset().Int32Value()));
+  // temp = temp->embedded_vtable_[vtable_index];
+  __ movl(temp, Address(temp, method_offset));
+  // (temp + offset_of_quick_compiled_code)()
+  __ call(Address(temp, mirror::ArtMethod::EntryPointFromQuickCompiledCodeOffset(
+                  kX86PointerSize).Int32Value()));
+
+  DCHECK(!codegen_->IsLeafMethod());
+  codegen_->RecordPcInfo(invoke->GetDexPc());
+  if (Primitive::IsFloatingPointType(invoke->GetType())) {
+    // Float and double values are returned in XMM0.
+    MoveFromFpuRegister(invoke->GetLocations()->Out(), XMM0,
+                        invoke->GetType() == Primitive::kPrimDouble);
+  }
+}
+
+void InstructionCodeGeneratorX86::VisitInvokeInterface(HInvokeInterface* invoke) {
+  LocationSummary* locations = invoke->GetLocations();
+  Register temp = locations->GetTemp(0).AsX86().AsCpuRegister();
+  Register receiver = locations->InAt(0).AsX86().AsCpuRegister();
+  uint32_t method_offset = mirror::Class::EmbeddedImTableOffset().Uint32Value() +
+      (invoke->GetImtIndex() % mirror::Class::kImtSize) * sizeof(mirror::Class::ImTableEntry);
+
+  // The IMT conflict trampoline expects the dex method index in XMM0, which the
+  // register allocator does not use.
+  __ movl(temp, Immediate(invoke->GetDexMethodIndex()));
+  __ movd(XMM0, temp);
+  // temp = receiver->klass_;
+  __ movl(temp, Address(receiver, mirror::Object::ClassOffset().Int32Value()));
+  // temp = temp->embedded_imtable_[imt_index];
+  __ movl(temp, Address(temp, method_offset));
+  // (temp + offset_of_quick_compiled_code)()
+  __ call(Address(temp, mirror::ArtMethod::EntryPointFromQuickCompiledCodeOffset(
+                  kX86PointerSize).Int32Value()));
+
+  DCHECK(!codegen_->IsLeafMethod());
+  codegen_->RecordPcInfo(invoke->GetDexPc());
+  if (Primitive::IsFloatingPointType(invoke->GetType())) {
+    // Float and double values are returned in XMM0.
+    MoveFromFpuRegister(invoke->GetLocations()->Out(), XMM0,
+                        invoke->GetType() == Primitive::kPrimDouble);
+  }
+}
+
+void InstructionCodeGeneratorX86::MoveToFpuRegister(XmmRegister dst,
+                                                    Location src,
+                                                    bool is_double) {
+  if (!is_double) {
+    if (src.IsRegister()) {
+      __ movd(dst, src.AsX86().AsCpuRegister());
+    } else {
+      __ movss(dst, Address(ESP, src.GetStackIndex()));
+    }
+  } else if (src.IsRegister()) {
+    // A register pair is moved to an XMM register through the stack.
+    __ pushl(src.AsX86().AsRegisterPairHigh());
+    __ pushl(src.AsX86().AsRegisterPairLow());
+    __ movsd(dst, Address(ESP, 0));
+    __ addl(ESP, Immediate(2 * kX86WordSize));
+  } else {
+    __ movsd(dst, Address(ESP, src.GetStackIndex()));
+  }
+}
+
+void InstructionCodeGeneratorX86::MoveFromFpuRegister(Location dst,
+                                                      XmmRegister src,
+                                                      bool is_double) {
+  if (!is_double) {
+    if (dst.IsRegister()) {
+      __ movd(dst.AsX86().AsCpuRegister(), src);
+    } else {
+      __ movss(Address(ESP, dst.GetStackIndex()), src);
+    }
+  } else if (dst.IsRegister()) {
+    __ subl(ESP, Immediate(2 * kX86WordSize));
+    __ movsd(Address(ESP, 0), src);
+    __ popl(dst.AsX86().AsRegisterPairLow());
+    __ popl(dst.AsX86().AsRegisterPairHigh());
+  } else {
+    __ movsd(Address(ESP, dst.GetStackIndex()), src);
+  }
 }
 
 void LocationsBuilderX86::VisitAdd(HAdd* add) {
@@ -814,6 +1018,14 @@ void LocationsBuilderX86::VisitAdd(HAdd* add) {
       break;
     }
 
+    case Primitive::kPrimFloat:
+    case Primitive::kPrimDouble: {
+      locations->SetInAt(0, Location::RequiresRegister());
+      locations->SetInAt(1, Location::RequiresRegister());
+      locations->SetOut(Location::SameAsFirstInput());
+      break;
+    }
+
     case Primitive::kPrimBoolean:
     case Primitive::kPrimByte:
     case Primitive::kPrimChar:
@@ -864,6 +1076,20 @@ void InstructionCodeGeneratorX86::VisitAdd(HAdd* add) {
       break;
     }
 
+    case Primitive::kPrimFloat:
+    case Primitive::kPrimDouble: {
+      bool is_double = add->GetResultType() == Primitive::kPrimDouble;
+      MoveToFpuRegister(XMM0, locations->InAt(0), is_double);
+      MoveToFpuRegister(XMM1, locations->InAt(1), is_double);
+      if (is_double) {
+        __ addsd(XMM0, XMM1);
+      } else {
+        __ addss(XMM0, XMM1);
+      }
+      MoveFromFpuRegister(locations->Out(), XMM0, is_double);
+      break;
+    }
+
     case Primitive::kPrimBoolean:
     case Primitive::kPrimByte:
     case Primitive::kPrimChar:
@@ -887,6 +1113,14 @@ void LocationsBuilderX86::VisitSub(HSub* sub) {
       break;
     }
 
+    case Primitive::kPrimFloat:
+    case Primitive::kPrimDouble: {
+      locations->SetInAt(0, Location::RequiresRegister());
+      locations->SetInAt(1, Location::RequiresRegister());
+      locations->SetOut(Location::SameAsFirstInput());
+      break;
+    }
+
     case Primitive::kPrimBoolean:
     case Primitive::kPrimByte:
     case Primitive::kPrimChar:
@@ -937,6 +1171,20 @@ void InstructionCodeGeneratorX86::VisitSub(HSub* sub) {
       break;
     }
 
+    case Primitive::kPrimFloat:
+    case Primitive::kPrimDouble: {
+      bool is_double = sub->GetResultType() == Primitive::kPrimDouble;
+      MoveToFpuRegister(XMM0, locations->InAt(0), is_double);
+      MoveToFpuRegister(XMM1, locations->InAt(1), is_double);
+      if (is_double) {
+        __ subsd(XMM0, XMM1);
+      } else {
+        __ subss(XMM0, XMM1);
+      }
+      MoveFromFpuRegister(locations->Out(), XMM0, is_double);
+      break;
+    }
+
     case Primitive::kPrimBoolean:
     case Primitive::kPrimByte:
     case Primitive::kPrimChar:
@@ -949,6 +1197,396 @@ void InstructionCodeGeneratorX86::VisitSub(HSub* sub) {
   }
 }
 
+void LocationsBuilderX86::VisitMul(HMul* mul) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(mul);
+  switch (mul->GetResultType()) {
+    case Primitive::kPrimInt: {
+      locations->SetInAt(0, Location::RequiresRegister());
+      locations->SetInAt(1, Location::Any());
+      locations->SetOut(Location::SameAsFirstInput());
+      break;
+    }
+
+    case Primitive::kPrimLong: {
+      // The multiplication is done by the runtime, which takes the operands in
+      // EAX:ECX and EDX:EBX.
+      codegen_->MarkNotLeaf();
+      locations->SetInAt(
+          0, Location::RegisterLocation(X86ManagedRegister::FromRegisterPair(EAX_ECX)));
+      locations->SetInAt(
+          1, Location::RegisterLocation(X86ManagedRegister::FromRegisterPair(EDX_EBX)));
+      locations->SetOut(Location::RegisterLocation(X86ManagedRegister::FromRegisterPair(EAX_EDX)));
+      break;
+    }
+
+    case Primitive::kPrimFloat:
+    case Primitive::kPrimDouble: {
+      locations->SetInAt(0, Location::RequiresRegister());
+      locations->SetInAt(1, Location::RequiresRegister());
+      locations->SetOut(Location::SameAsFirstInput());
+      break;
+    }
+
+    default:
+      LOG(FATAL) << "Unexpected mul type " << mul->GetResultType();
+  }
+  mul->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorX86::VisitMul(HMul* mul) {
+  LocationSummary* locations = mul->GetLocations();
+  switch (mul->GetResultType()) {
+    case Primitive::kPrimInt: {
+      DCHECK_EQ(locations->InAt(0).AsX86().AsCpuRegister(),
+                locations->Out().AsX86().AsCpuRegister());
+      if (locations->InAt(1).IsRegister()) {
+        __ imull(locations->InAt(0).AsX86().AsCpuRegister(),
+                 locations->InAt(1).AsX86().AsCpuRegister());
+      } else if (locations->InAt(1).IsConstant()) {
+        HConstant* instruction = locations->InAt(1).GetConstant();
+        Immediate imm(instruction->AsIntConstant()->GetValue());
+        __ imull(locations->InAt(0).AsX86().AsCpuRegister(), imm);
+      } else {
+        __ imull(locations->InAt(0).AsX86().AsCpuRegister(),
+                 Address(ESP, locations->InAt(1).GetStackIndex()));
+      }
+      break;
+    }
+
+    case Primitive::kPrimLong: {
+      __ fs()->call(Address::Absolute(QUICK_ENTRYPOINT_OFFSET(kX86WordSize, pLmul)));
+      // The entry point neither throws nor suspends, so there is no pc to record.
+      DCHECK(!codegen_->IsLeafMethod());
+      break;
+    }
+
+    case Primitive::kPrimFloat:
+    case Primitive::kPrimDouble: {
+      bool is_double = mul->GetResultType() == Primitive::kPrimDouble;
+      MoveToFpuRegister(XMM0, locations->InAt(0), is_double);
+      MoveToFpuRegister(XMM1, locations->InAt(1), is_double);
+      if (is_double) {
+        __ mulsd(XMM0, XMM1);
+      } else {
+        __ mulss(XMM0, XMM1);
+      }
+      MoveFromFpuRegister(locations->Out(), XMM0, is_double);
+      break;
+    }
+
+    default:
+      LOG(FATAL) << "Unexpected mul type " << mul->GetResultType();
+  }
+}
+
+// idivl divides EDX:EAX, and leaves the quotient in EAX and the remainder in EDX.
+static void SetIntDivOrRemLocations(LocationSummary* locations, bool is_div) {
+  locations->SetInAt(0, X86CpuLocation(EAX));
+  locations->SetInAt(1, Location::RequiresRegister());
+  locations->AddTemp(X86CpuLocation(EDX));
+  locations->SetOut(X86CpuLocation(is_div ? EAX : EDX));
+}
+
+void InstructionCodeGeneratorX86::GenerateIntDivOrRem(HBinaryOperation* instruction) {
+  DCHECK(instruction->IsDiv() || instruction->IsRem());
+  LocationSummary* locations = instruction->GetLocations();
+  DCHECK_EQ(EAX, locations->InAt(0).AsX86().AsCpuRegister());
+  Register second = locations->InAt(1).AsX86().AsCpuRegister();
+  Label not_minus_one, done;
+
+  // idivl faults on the minimum int divided by -1, whose quotient overflows back to the
+  // dividend. Negating gives that quotient, and the remainder of any division by -1 is 0.
+  __ cmpl(second, Immediate(-1));
+  __ j(kNotEqual, &not_minus_one);
+  if (instruction->IsDiv()) {
+    __ negl(EAX);
+  } else {
+    __ xorl(EDX, EDX);
+  }
+  __ jmp(&done);
+  __ Bind(&not_minus_one);
+  __ cdq();
+  __ idivl(second);
+  __ Bind(&done);
+}
+
+void LocationsBuilderX86::VisitDiv(HDiv* div) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(div);
+  if (div->GetResultType() == Primitive::kPrimInt) {
+    SetIntDivOrRemLocations(locations, true);
+  } else {
+    locations->SetInAt(0, Location::RequiresRegister());
+    locations->SetInAt(1, Location::RequiresRegister());
+    locations->SetOut(Location::SameAsFirstInput());
+  }
+  div->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorX86::VisitDiv(HDiv* div) {
+  LocationSummary* locations = div->GetLocations();
+  switch (div->GetResultType()) {
+    case Primitive::kPrimInt:
+      GenerateIntDivOrRem(div);
+      break;
+
+    case Primitive::kPrimFloat:
+    case Primitive::kPrimDouble: {
+      bool is_double = div->GetResultType() == Primitive::kPrimDouble;
+      MoveToFpuRegister(XMM0, locations->InAt(0), is_double);
+      MoveToFpuRegister(XMM1, locations->InAt(1), is_double);
+      if (is_double) {
+        __ divsd(XMM0, XMM1);
+      } else {
+        __ divss(XMM0, XMM1);
+      }
+      MoveFromFpuRegister(locations->Out(), XMM0, is_double);
+      break;
+    }
+
+    default:
+      LOG(FATAL) << "Unexpected div type " << div->GetResultType();
+  }
+}
+
+void LocationsBuilderX86::VisitRem(HRem* rem) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(rem);
+  switch (rem->GetResultType()) {
+    case Primitive::kPrimInt:
+      SetIntDivOrRemLocations(locations, false);
+      break;
+
+    default:
+      LOG(FATAL) << "Unexpected rem type " << rem->GetResultType();
+  }
+  rem->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorX86::VisitRem(HRem* rem) {
+  switch (rem->GetResultType()) {
+    case Primitive::kPrimInt:
+      GenerateIntDivOrRem(rem);
+      break;
+
+    default:
+      LOG(FATAL) << "Unexpected rem type " << rem->GetResultType();
+  }
+}
+
+void LocationsBuilderX86::VisitDivZeroCheck(HDivZeroCheck* instruction) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
+  locations->SetInAt(0, Location::Any());
+  locations->SetOut(Location::SameAsFirstInput());
+  instruction->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorX86::VisitDivZeroCheck(HDivZeroCheck* instruction) {
+  SlowPathCode* slow_path =
+      new (GetGraph()->GetArena()) DivZeroCheckSlowPathX86(instruction->GetDexPc());
+  codegen_->AddSlowPath(slow_path);
+
+  LocationSummary* locations = instruction->GetLocations();
+  Location value = locations->InAt(0);
+  DCHECK(value.Equals(locations->Out()));
+
+  if (value.IsRegister()) {
+    __ cmpl(value.AsX86().AsCpuRegister(), Immediate(0));
+  } else {
+    DCHECK(value.IsStackSlot());
+    __ cmpl(Address(ESP, value.GetStackIndex()), Immediate(0));
+  }
+  __ j(kEqual, slow_path->GetEntryLabel());
+}
+
+void LocationsBuilderX86::VisitNeg(HNeg* neg) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(neg);
+  locations->SetInAt(0, Location::RequiresRegister());
+  locations->SetOut(Location::SameAsFirstInput());
+  neg->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorX86::VisitNeg(HNeg* neg) {
+  LocationSummary* locations = neg->GetLocations();
+  X86ManagedRegister out = locations->Out().AsX86();
+  DCHECK(locations->InAt(0).Equals(locations->Out()));
+  switch (neg->GetResultType()) {
+    case Primitive::kPrimInt:
+      __ negl(out.AsCpuRegister());
+      break;
+
+    case Primitive::kPrimLong:
+      __ negl(out.AsRegisterPairLow());
+      __ adcl(out.AsRegisterPairHigh(), Immediate(0));
+      __ negl(out.AsRegisterPairHigh());
+      break;
+
+    // Negating a float or a double flips its sign bit, including for NaN and zero.
+    case Primitive::kPrimFloat:
+      __ xorl(out.AsCpuRegister(), Immediate(static_cast<int32_t>(0x80000000)));
+      break;
+
+    case Primitive::kPrimDouble:
+      __ xorl(out.AsRegisterPairHigh(), Immediate(static_cast<int32_t>(0x80000000)));
+      break;
+
+    default:
+      LOG(FATAL) << "Unexpected neg type " << neg->GetResultType();
+  }
+}
+
+void LocationsBuilderX86::VisitTypeConversion(HTypeConversion* conversion) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(conversion);
+  Primitive::Type input_type = conversion->GetInputType();
+  Primitive::Type result_type = conversion->GetResultType();
+  if (result_type == Primitive::kPrimLong && Primitive::IsFloatingPointType(input_type)) {
+    // The conversion is done by the runtime, which takes a float in EAX and a double
+    // in EAX:ECX.
+    codegen_->MarkNotLeaf();
+    if (input_type == Primitive::kPrimFloat) {
+      locations->SetInAt(0, X86CpuLocation(EAX));
+    } else {
+      locations->SetInAt(
+          0, Location::RegisterLocation(X86ManagedRegister::FromRegisterPair(EAX_ECX)));
+    }
+    locations->SetOut(Location::RegisterLocation(X86ManagedRegister::FromRegisterPair(EAX_EDX)));
+  } else {
+    if (result_type == Primitive::kPrimByte) {
+      // Ensure the value is in a byte register.
+      locations->SetInAt(0, X86CpuLocation(EAX));
+    } else {
+      locations->SetInAt(0, Location::RequiresRegister());
+    }
+    locations->SetOut(Location::RequiresRegister());
+  }
+  conversion->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorX86::VisitTypeConversion(HTypeConversion* conversion) {
+  LocationSummary* locations = conversion->GetLocations();
+  Location in = locations->InAt(0);
+  Location out = locations->Out();
+  Primitive::Type input_type = conversion->GetInputType();
+  Primitive::Type result_type = conversion->GetResultType();
+  switch (result_type) {
+    case Primitive::kPrimByte:
+      DCHECK_EQ(input_type, Primitive::kPrimInt);
+      __ movsxb(out.AsX86().AsCpuRegister(), in.AsX86().AsByteRegister());
+      break;
+
+    case Primitive::kPrimShort:
+      DCHECK_EQ(input_type, Primitive::kPrimInt);
+      __ movsxw(out.AsX86().AsCpuRegister(), in.AsX86().AsCpuRegister());
+      break;
+
+    case Primitive::kPrimChar:
+      DCHECK_EQ(input_type, Primitive::kPrimInt);
+      __ movzxw(out.AsX86().AsCpuRegister(), in.AsX86().AsCpuRegister());
+      break;
+
+    case Primitive::kPrimInt:
+      if (input_type == Primitive::kPrimLong) {
+        __ movl(out.AsX86().AsCpuRegister(), in.AsX86().AsRegisterPairLow());
+      } else {
+        GenerateFloatingPointToInt(conversion);
+      }
+      break;
+
+    case Primitive::kPrimLong:
+      if (input_type == Primitive::kPrimInt) {
+        __ movl(out.AsX86().AsRegisterPairLow(), in.AsX86().AsCpuRegister());
+        __ movl(out.AsX86().AsRegisterPairHigh(), in.AsX86().AsCpuRegister());
+        __ sarl(out.AsX86().AsRegisterPairHigh(), Immediate(31));
+      } else {
+        if (input_type == Primitive::kPrimFloat) {
+          __ fs()->call(Address::Absolute(QUICK_ENTRYPOINT_OFFSET(kX86WordSize, pF2l)));
+        } else {
+          __ fs()->call(Address::Absolute(QUICK_ENTRYPOINT_OFFSET(kX86WordSize, pD2l)));
+        }
+        // The entry point neither throws nor suspends, so there is no pc to record.
+        DCHECK(!codegen_->IsLeafMethod());
+      }
+      break;
+
+    case Primitive::kPrimFloat:
+      if (input_type == Primitive::kPrimLong) {
+        // SSE has no conversion from a 64-bit integer in 32-bit mode: use the x87 unit.
+        __ pushl(in.AsX86().AsRegisterPairHigh());
+        __ pushl(in.AsX86().AsRegisterPairLow());
+        __ fildl(Address(ESP, 0));
+        __ fstps(Address(ESP, 0));
+        __ movl(out.AsX86().AsCpuRegister(), Address(ESP, 0));
+        __ addl(ESP, Immediate(2 * kX86WordSize));
+      } else {
+        if (input_type == Primitive::kPrimInt) {
+          __ cvtsi2ss(XMM0, in.AsX86().AsCpuRegister());
+        } else {
+          MoveToFpuRegister(XMM0, in, true);
+          __ cvtsd2ss(XMM0, XMM0);
+        }
+        __ movd(out.AsX86().AsCpuRegister(), XMM0);
+      }
+      break;
+
+    case Primitive::kPrimDouble:
+      if (input_type == Primitive::kPrimLong) {
+        __ pushl(in.AsX86().AsRegisterPairHigh());
+        __ pushl(in.AsX86().AsRegisterPairLow());
+        __ fildl(Address(ESP, 0));
+        __ fstpl(Address(ESP, 0));
+        __ popl(out.AsX86().AsRegisterPairLow());
+        __ popl(out.AsX86().AsRegisterPairHigh());
+      } else {
+        if (input_type == Primitive::kPrimInt) {
+          __ cvtsi2sd(XMM0, in.AsX86().AsCpuRegister());
+        } else {
+          __ movd(XMM0, in.AsX86().AsCpuRegister());
+          __ cvtss2sd(XMM0, XMM0);
+        }
+        MoveFromFpuRegister(out, XMM0, true);
+      }
+      break;
+
+    default:
+      LOG(FATAL) << "Unexpected type conversion from " << input_type << " to " << result_type;
+  }
+}
+
+void InstructionCodeGeneratorX86::GenerateFloatingPointToInt(HTypeConversion* conversion) {
+  LocationSummary* locations = conversion->GetLocations();
+  Register out = locations->Out().AsX86().AsCpuRegister();
+  bool is_double = conversion->GetInputType() == Primitive::kPrimDouble;
+  MoveToFpuRegister(XMM0, locations->InAt(0), is_double);
+  if (is_double) {
+    __ cvttsd2si(out, XMM0);
+  } else {
+    __ cvttss2si(out, XMM0);
+  }
+
+  // The conversion returns the minimum int for NaN and for values out of range. Java
+  // wants zero for NaN, and the maximum int for large positive values.
+  Label nan, done;
+  __ cmpl(out, Immediate(std::numeric_limits<int32_t>::min()));
+  __ j(kNotEqual, &done);
+  if (is_double) {
+    __ comisd(XMM0, XMM0);
+  } else {
+    __ comiss(XMM0, XMM0);
+  }
+  __ j(kParityEven, &nan);
+  if (is_double) {
+    __ xorpd(XMM1, XMM1);
+    __ comisd(XMM0, XMM1);
+  } else {
+    __ xorps(XMM1, XMM1);
+    __ comiss(XMM0, XMM1);
+  }
+  __ j(kBelow, &done);
+  __ movl(out, Immediate(std::numeric_limits<int32_t>::max()));
+  __ jmp(&done);
+  __ Bind(&nan);
+  __ xorl(out, out);
+  __ Bind(&done);
+}
+
 void LocationsBuilderX86::VisitNewInstance(HNewInstance* instruction) {
   codegen_->MarkNotLeaf();
   LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
@@ -971,6 +1609,110 @@ void InstructionCodeGeneratorX86::VisitNewInstance(HNewInstance* instruction) {
   DCHECK(!codegen_->IsLeafMethod());
 }
 
+void LocationsBuilderX86::VisitLoadClass(HLoadClass* cls) {
+  codegen_->MarkNotLeaf();
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(cls);
+  locations->SetOut(X86CpuLocation(EAX));
+  InvokeRuntimeCallingConvention calling_convention;
+  locations->AddTemp(X86CpuLocation(calling_convention.GetRegisterAt(0)));
+  locations->AddTemp(X86CpuLocation(calling_convention.GetRegisterAt(1)));
+  cls->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorX86::VisitLoadClass(HLoadClass* cls) {
+  InvokeRuntimeCallingConvention calling_convention;
+  Register method = calling_convention.GetRegisterAt(1);
+  Register out = cls->GetLocations()->Out().AsX86().AsCpuRegister();
+  LoadCurrentMethod(method);
+
+  if (cls->NeedsAccessCheck()) {
+    __ movl(calling_convention.GetRegisterAt(0), Immediate(cls->GetTypeIndex()));
+    __ fs()->call(Address::Absolute(
+        QUICK_ENTRYPOINT_OFFSET(kX86WordSize, pInitializeTypeAndVerifyAccess)));
+    codegen_->RecordPcInfo(cls->GetDexPc());
+  } else {
+    SlowPathCode* slow_path = new (GetGraph()->GetArena()) LoadClassSlowPathX86(
+        cls->GetTypeIndex(), cls->GetDexPc());
+    codegen_->AddSlowPath(slow_path);
+    uint32_t heap_reference_size = sizeof(mirror::HeapReference<mirror::Object>);
+    size_t index_in_cache = mirror::Array::DataOffset(heap_reference_size).Int32Value() +
+        cls->GetTypeIndex() * heap_reference_size;
+    // out = method->dex_cache_resolved_types_[type_index]
+    __ movl(out, Address(method, mirror::ArtMethod::DexCacheResolvedTypesOffset().Int32Value()));
+    __ movl(out, Address(out, index_in_cache));
+    __ testl(out, out);
+    __ j(kEqual, slow_path->GetEntryLabel());
+    __ Bind(slow_path->GetExitLabel());
+  }
+  DCHECK(!codegen_->IsLeafMethod());
+}
+
+// The type checks compare the class of the object with the class checked against, and
+// only call the runtime when they differ.
+static void SetTypeCheckLocations(LocationSummary* locations) {
+  locations->SetInAt(0, Location::RequiresRegister());
+  locations->SetInAt(1, Location::RequiresRegister());
+  InvokeRuntimeCallingConvention calling_convention;
+  locations->AddTemp(X86CpuLocation(calling_convention.GetRegisterAt(0)));
+  locations->AddTemp(X86CpuLocation(calling_convention.GetRegisterAt(1)));
+}
+
+void LocationsBuilderX86::VisitInstanceOf(HInstanceOf* instruction) {
+  codegen_->MarkNotLeaf();
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
+  SetTypeCheckLocations(locations);
+  locations->SetOut(X86CpuLocation(EAX));
+  instruction->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorX86::VisitInstanceOf(HInstanceOf* instruction) {
+  LocationSummary* locations = instruction->GetLocations();
+  Register obj = locations->InAt(0).AsX86().AsCpuRegister();
+  Register cls = locations->InAt(1).AsX86().AsCpuRegister();
+  Register obj_cls = locations->GetTemp(1).AsX86().AsCpuRegister();
+  Register out = locations->Out().AsX86().AsCpuRegister();
+  SlowPathCode* slow_path =
+      new (GetGraph()->GetArena()) TypeCheckSlowPathX86(instruction, locations->InAt(1));
+  codegen_->AddSlowPath(slow_path);
+  Label is_null;
+
+  __ testl(obj, obj);
+  __ j(kEqual, &is_null);
+  __ movl(obj_cls, Address(obj, mirror::Object::ClassOffset().Int32Value()));
+  __ cmpl(obj_cls, cls);
+  __ j(kNotEqual, slow_path->GetEntryLabel());
+  __ movl(out, Immediate(1));
+  __ jmp(slow_path->GetExitLabel());
+  __ Bind(&is_null);
+  __ xorl(out, out);
+  __ Bind(slow_path->GetExitLabel());
+}
+
+void LocationsBuilderX86::VisitCheckCast(HCheckCast* instruction) {
+  codegen_->MarkNotLeaf();
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
+  SetTypeCheckLocations(locations);
+  instruction->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorX86::VisitCheckCast(HCheckCast* instruction) {
+  LocationSummary* locations = instruction->GetLocations();
+  Register obj = locations->InAt(0).AsX86().AsCpuRegister();
+  Register cls = locations->InAt(1).AsX86().AsCpuRegister();
+  Register obj_cls = locations->GetTemp(1).AsX86().AsCpuRegister();
+  SlowPathCode* slow_path =
+      new (GetGraph()->GetArena()) TypeCheckSlowPathX86(instruction, locations->InAt(1));
+  codegen_->AddSlowPath(slow_path);
+
+  // A null reference can be cast to any type.
+  __ testl(obj, obj);
+  __ j(kEqual, slow_path->GetExitLabel());
+  __ movl(obj_cls, Address(obj, mirror::Object::ClassOffset().Int32Value()));
+  __ cmpl(obj_cls, cls);
+  __ j(kNotEqual, slow_path->GetEntryLabel());
+  __ Bind(slow_path->GetExitLabel());
+}
+
 void LocationsBuilderX86::VisitParameterValue(HParameterValue* instruction) {
   LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
   Location location = parameter_visitor_.GetNextLocation(instruction->GetType());
@@ -1003,7 +1745,11 @@ void InstructionCodeGeneratorX86::VisitNot(HNot* instruction) {
 void LocationsBuilderX86::VisitCompare(HCompare* compare) {
   LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(compare);
   locations->SetInAt(0, Location::RequiresRegister());
-  locations->SetInAt(1, Location::Any());
+  if (compare->IsFloatingPoint()) {
+    locations->SetInAt(1, Location::RequiresRegister());
+  } else {
+    locations->SetInAt(1, Location::Any());
+  }
   locations->SetOut(Location::RequiresRegister());
   compare->SetLocations(locations);
 }
@@ -1011,7 +1757,7 @@ void LocationsBuilderX86::VisitCompare(HCompare* compare) {
 void InstructionCodeGeneratorX86::VisitCompare(HCompare* compare) {
   Label greater, done;
   LocationSummary* locations = compare->GetLocations();
-  switch (compare->InputAt(0)->GetType()) {
+  switch (compare->GetInputType()) {
     case Primitive::kPrimLong: {
       Label less, greater, done;
       Register output = locations->Out().AsX86().AsCpuRegister();
@@ -1045,8 +1791,36 @@ void InstructionCodeGeneratorX86::VisitCompare(HCompare* compare) {
       __ Bind(&done);
       break;
     }
+    case Primitive::kPrimFloat:
+    case Primitive::kPrimDouble: {
+      Label less, greater, done;
+      Register output = locations->Out().AsX86().AsCpuRegister();
+      bool is_double = compare->GetInputType() == Primitive::kPrimDouble;
+      MoveToFpuRegister(XMM0, locations->InAt(0), is_double);
+      MoveToFpuRegister(XMM1, locations->InAt(1), is_double);
+      if (is_double) {
+        __ comisd(XMM0, XMM1);
+      } else {
+        __ comiss(XMM0, XMM1);
+      }
+      __ movl(output, Immediate(0));
+      // An unordered comparison, with a NaN, sets the parity flag.
+      __ j(kParityEven, compare->IsGtBias() ? &greater : &less);
+      __ j(kEqual, &done);
+      __ j(kBelow, &less);
+
+      __ Bind(&greater);
+      __ movl(output, Immediate(1));
+      __ jmp(&done);
+
+      __ Bind(&less);
+      __ movl(output, Immediate(-1));
+
+      __ Bind(&done);
+      break;
+    }
     default:
-      LOG(FATAL) << "Unimplemented compare type " << compare->InputAt(0)->GetType();
+      LOG(FATAL) << "Unimplemented compare type " << compare->GetInputType();
   }
 }
 
@@ -1104,6 +1878,7 @@ void InstructionCodeGeneratorX86::VisitInstanceFieldSet(HInstanceFieldSet* instr
     }
 
     case Primitive::kPrimInt:
+    case Primitive::kPrimFloat:
     case Primitive::kPrimNot: {
       Register value = locations->InAt(1).AsX86().AsCpuRegister();
       __ movl(Address(obj, offset), value);
@@ -1116,17 +1891,14 @@ void InstructionCodeGeneratorX86::VisitInstanceFieldSet(HInstanceFieldSet* instr
       break;
     }
 
-    case Primitive::kPrimLong: {
+    case Primitive::kPrimLong:
+    case Primitive::kPrimDouble: {
       X86ManagedRegister value = locations->InAt(1).AsX86();
       __ movl(Address(obj, offset), value.AsRegisterPairLow());
       __ movl(Address(obj, kX86WordSize + offset), value.AsRegisterPairHigh());
       break;
     }
 
-    case Primitive::kPrimFloat:
-    case Primitive::kPrimDouble:
-      LOG(FATAL) << "Unimplemented register type " << field_type;
-
     case Primitive::kPrimVoid:
       LOG(FATAL) << "Unreachable type " << field_type;
   }
@@ -1182,13 +1954,15 @@ void InstructionCodeGeneratorX86::VisitInstanceFieldGet(HInstanceFieldGet* instr
     }
 
     case Primitive::kPrimInt:
+    case Primitive::kPrimFloat:
     case Primitive::kPrimNot: {
       Register out = locations->Out().AsX86().AsCpuRegister();
       __ movl(out, Address(obj, offset));
       break;
     }
 
-    case Primitive::kPrimLong: {
+    case Primitive::kPrimLong:
+    case Primitive::kPrimDouble: {
       // TODO: support volatile.
       X86ManagedRegister out = locations->Out().AsX86();
       __ movl(out.AsRegisterPairLow(), Address(obj, offset));
@@ -1196,10 +1970,6 @@ void InstructionCodeGeneratorX86::VisitInstanceFieldGet(HInstanceFieldGet* instr
       break;
     }
 
-    case Primitive::kPrimFloat:
-    case Primitive::kPrimDouble:
-      LOG(FATAL) << "Unimplemented register type " << instruction->GetType();
-
     case Primitive::kPrimVoid:
       LOG(FATAL) << "Unreachable type " << instruction->GetType();
   }
@@ -1294,6 +2064,7 @@ void InstructionCodeGeneratorX86::VisitArrayGet(HArrayGet* instruction) {
     }
 
     case Primitive::kPrimInt:
+    case Primitive::kPrimFloat:
     case Primitive::kPrimNot: {
       uint32_t data_offset = mirror::Array::DataOffset(sizeof(int32_t)).Uint32Value();
       Register out = locations->Out().AsX86().AsCpuRegister();
@@ -1306,7 +2077,8 @@ void InstructionCodeGeneratorX86::VisitArrayGet(HArrayGet* instruction) {
       break;
     }
 
-    case Primitive::kPrimLong: {
+    case Primitive::kPrimLong:
+    case Primitive::kPrimDouble: {
       uint32_t data_offset = mirror::Array::DataOffset(sizeof(int64_t)).Uint32Value();
       X86ManagedRegister out = locations->Out().AsX86();
       if (index.IsConstant()) {
@@ -1322,10 +2094,6 @@ void InstructionCodeGeneratorX86::VisitArrayGet(HArrayGet* instruction) {
       break;
     }
 
-    case Primitive::kPrimFloat:
-    case Primitive::kPrimDouble:
-      LOG(FATAL) << "Unimplemented register type " << instruction->GetType();
-
     case Primitive::kPrimVoid:
       LOG(FATAL) << "Unreachable type " << instruction->GetType();
   }
@@ -1387,7 +2155,8 @@ void InstructionCodeGeneratorX86::VisitArraySet(HArraySet* instruction) {
       break;
     }
 
-    case Primitive::kPrimInt: {
+    case Primitive::kPrimInt:
+    case Primitive::kPrimFloat: {
       uint32_t data_offset = mirror::Array::DataOffset(sizeof(int32_t)).Uint32Value();
       Register value = locations->InAt(2).AsX86().AsCpuRegister();
       if (index.IsConstant()) {
@@ -1406,7 +2175,8 @@ void InstructionCodeGeneratorX86::VisitArraySet(HArraySet* instruction) {
       break;
     }
 
-    case Primitive::kPrimLong: {
+    case Primitive::kPrimLong:
+    case Primitive::kPrimDouble: {
       uint32_t data_offset = mirror::Array::DataOffset(sizeof(int64_t)).Uint32Value();
       X86ManagedRegister value = locations->InAt(2).AsX86();
       if (index.IsConstant()) {
@@ -1422,10 +2192,6 @@ void InstructionCodeGeneratorX86::VisitArraySet(HArraySet* instruction) {
       break;
     }
 
-    case Primitive::kPrimFloat:
-    case Primitive::kPrimDouble:
-      LOG(FATAL) << "Unimplemented register type " << instruction->GetType();
-
     case Primitive::kPrimVoid:
       LOG(FATAL) << "Unreachable type " << instruction->GetType();
   }
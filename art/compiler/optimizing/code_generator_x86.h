@@ -95,6 +95,8 @@ class LocationsBuilderX86 : public HGraphVisitor {
 #undef DECLARE_VISIT_INSTRUCTION
 
  private:
+  void HandleInvoke(HInvoke* invoke);
+
   CodeGeneratorX86* const codegen_;
   InvokeDexCallingConventionVisitor parameter_visitor_;
 
@@ -117,6 +119,13 @@ class InstructionCodeGeneratorX86 : public HGraphVisitor {
   X86Assembler* GetAssembler() const { return assembler_; }
 
  private:
+  // Float and double values live in core registers and register pairs. These helpers
+  // move them to and from the XMM registers the arithmetic is done in.
+  void MoveToFpuRegister(XmmRegister dst, Location src, bool is_double);
+  void MoveFromFpuRegister(Location dst, XmmRegister src, bool is_double);
+  void GenerateFloatingPointToInt(HTypeConversion* conversion);
+  void GenerateIntDivOrRem(HBinaryOperation* instruction);
+
   X86Assembler* const assembler_;
   CodeGeneratorX86* const codegen_;
 
@@ -130,7 +139,7 @@ class CodeGeneratorX86 : public CodeGenerator {
 
   virtual void GenerateFrameEntry() OVERRIDE;
   virtual void GenerateFrameExit() OVERRIDE;
-  virtual void Bind(Label* label) OVERRIDE;
+  virtual void Bind(HBasicBlock* block) OVERRIDE;
   virtual void Move(HInstruction* instruction, Location location, HInstruction* move_for) OVERRIDE;
 
   virtual size_t GetWordSize() const OVERRIDE {
@@ -169,7 +178,7 @@ class CodeGeneratorX86 : public CodeGenerator {
   virtual void DumpCoreRegister(std::ostream& stream, int reg) const OVERRIDE;
   virtual void DumpFloatingPointRegister(std::ostream& stream, int reg) const OVERRIDE;
 
-  ParallelMoveResolverX86* GetMoveResolver() {
+  ParallelMoveResolverX86* GetMoveResolver() OVERRIDE {
     return &move_resolver_;
   }
 
@@ -20,6 +20,7 @@
 #include "gc/accounting/card_table.h"
 #include "mirror/array.h"
 #include "mirror/art_method.h"
+#include "mirror/class.h"
 #include "mirror/object_reference.h"
 #include "thread.h"
 #include "utils/assembler.h"
@@ -103,11 +104,14 @@ class BoundsCheckSlowPathX86_64 : public SlowPathCode {
       : dex_pc_(dex_pc), index_location_(index_location), length_location_(length_location) {}
 
   virtual void EmitNativeCode(CodeGenerator* codegen) OVERRIDE {
-    CodeGeneratorX86_64* x64_codegen = reinterpret_cast<CodeGeneratorX86_64*>(codegen);
     __ Bind(GetEntryLabel());
     InvokeRuntimeCallingConvention calling_convention;
-    x64_codegen->Move(X86_64CpuLocation(calling_convention.GetRegisterAt(0)), index_location_);
-    x64_codegen->Move(X86_64CpuLocation(calling_convention.GetRegisterAt(1)), length_location_);
+    // We're moving two locations to locations that could overlap, so we need a parallel
+    // move resolver.
+    codegen->EmitParallelMoves(index_location_,
+                               X86_64CpuLocation(calling_convention.GetRegisterAt(0)),
+                               length_location_,
+                               X86_64CpuLocation(calling_convention.GetRegisterAt(1)));
     __ gs()->call(Address::Absolute(
         QUICK_ENTRYPOINT_OFFSET(kX86_64WordSize, pThrowArrayBounds), true));
     codegen->RecordPcInfo(dex_pc_);
@@ -121,6 +125,77 @@ class BoundsCheckSlowPathX86_64 : public SlowPathCode {
   DISALLOW_COPY_AND_ASSIGN(BoundsCheckSlowPathX86_64);
 };
 
+class DivZeroCheckSlowPathX86_64 : public SlowPathCode {
+ public:
+  explicit DivZeroCheckSlowPathX86_64(uint32_t dex_pc) : dex_pc_(dex_pc) {}
+
+  virtual void EmitNativeCode(CodeGenerator* codegen) OVERRIDE {
+    __ Bind(GetEntryLabel());
+    __ gs()->call(
+        Address::Absolute(QUICK_ENTRYPOINT_OFFSET(kX86_64WordSize, pThrowDivZero), true));
+    codegen->RecordPcInfo(dex_pc_);
+  }
+
+ private:
+  const uint32_t dex_pc_;
+  DISALLOW_COPY_AND_ASSIGN(DivZeroCheckSlowPathX86_64);
+};
+
+// Resolves a class missing from the dex cache. The current method is already in the
+// second argument register, and the runtime returns the class in RAX.
+class LoadClassSlowPathX86_64 : public SlowPathCode {
+ public:
+  LoadClassSlowPathX86_64(uint16_t type_index, uint32_t dex_pc)
+      : type_index_(type_index), dex_pc_(dex_pc) {}
+
+  virtual void EmitNativeCode(CodeGenerator* codegen) OVERRIDE {
+    __ Bind(GetEntryLabel());
+    InvokeRuntimeCallingConvention calling_convention;
+    __ movl(CpuRegister(calling_convention.GetRegisterAt(0)), Immediate(type_index_));
+    __ gs()->call(
+        Address::Absolute(QUICK_ENTRYPOINT_OFFSET(kX86_64WordSize, pInitializeType), true));
+    codegen->RecordPcInfo(dex_pc_);
+    __ jmp(GetExitLabel());
+  }
+
+ private:
+  const uint16_t type_index_;
+  const uint32_t dex_pc_;
+
+  DISALLOW_COPY_AND_ASSIGN(LoadClassSlowPathX86_64);
+};
+
+// Calls the runtime for the instanceof or check-cast whose class did not match the class
+// of the object exactly. The class of the object is already in the second argument register.
+class TypeCheckSlowPathX86_64 : public SlowPathCode {
+ public:
+  TypeCheckSlowPathX86_64(HInstruction* instruction, Location class_location)
+      : instruction_(instruction), class_location_(class_location) {}
+
+  virtual void EmitNativeCode(CodeGenerator* codegen) OVERRIDE {
+    __ Bind(GetEntryLabel());
+    InvokeRuntimeCallingConvention calling_convention;
+    __ movl(CpuRegister(calling_convention.GetRegisterAt(0)),
+            class_location_.AsX86_64().AsCpuRegister());
+    if (instruction_->IsInstanceOf()) {
+      __ gs()->call(Address::Absolute(
+          QUICK_ENTRYPOINT_OFFSET(kX86_64WordSize, pInstanceofNonTrivial), true));
+    } else {
+      DCHECK(instruction_->IsCheckCast());
+      __ gs()->call(
+          Address::Absolute(QUICK_ENTRYPOINT_OFFSET(kX86_64WordSize, pCheckCast), true));
+      codegen->RecordPcInfo(instruction_->AsCheckCast()->GetDexPc());
+    }
+    __ jmp(GetExitLabel());
+  }
+
+ private:
+  HInstruction* const instruction_;
+  const Location class_location_;
+
+  DISALLOW_COPY_AND_ASSIGN(TypeCheckSlowPathX86_64);
+};
+
 #undef __
 #define __ reinterpret_cast<X86_64Assembler*>(GetAssembler())->
 
@@ -160,7 +235,8 @@ InstructionCodeGeneratorX86_64::InstructionCodeGeneratorX86_64(HGraph* graph,
                                                                CodeGeneratorX86_64* codegen)
       : HGraphVisitor(graph),
         assembler_(codegen->GetAssembler()),
-        codegen_(codegen) {}
+        codegen_(codegen),
+        number_of_fp_parameters_(0) {}
 
 ManagedRegister CodeGeneratorX86_64::AllocateFreeRegister(Primitive::Type type,
                                                           bool* blocked_registers) const {
@@ -171,15 +247,13 @@ ManagedRegister CodeGeneratorX86_64::AllocateFreeRegister(Primitive::Type type,
     case Primitive::kPrimChar:
     case Primitive::kPrimShort:
     case Primitive::kPrimInt:
-    case Primitive::kPrimNot: {
+    case Primitive::kPrimNot:
+    case Primitive::kPrimFloat:
+    case Primitive::kPrimDouble: {
       size_t reg = AllocateFreeRegisterInternal(blocked_registers, kNumberOfCpuRegisters);
       return X86_64ManagedRegister::FromCpuRegister(static_cast<Register>(reg));
     }
 
-    case Primitive::kPrimFloat:
-    case Primitive::kPrimDouble:
-      LOG(FATAL) << "Unimplemented register type " << type;
-
     case Primitive::kPrimVoid:
       LOG(FATAL) << "Unreachable type " << type;
   }
@@ -237,8 +311,8 @@ void CodeGeneratorX86_64::GenerateFrameExit() {
           Immediate(GetFrameSize() - kNumberOfPushedRegistersAtEntry * kX86_64WordSize));
 }
 
-void CodeGeneratorX86_64::Bind(Label* label) {
-  __ Bind(label);
+void CodeGeneratorX86_64::Bind(HBasicBlock* block) {
+  __ Bind(GetLabelOf(block));
 }
 
 void InstructionCodeGeneratorX86_64::LoadCurrentMethod(CpuRegister reg) {
@@ -248,16 +322,14 @@ void InstructionCodeGeneratorX86_64::LoadCurrentMethod(CpuRegister reg) {
 Location CodeGeneratorX86_64::GetStackLocation(HLoadLocal* load) const {
   switch (load->GetType()) {
     case Primitive::kPrimLong:
+    case Primitive::kPrimDouble:
       return Location::DoubleStackSlot(GetStackSlot(load->GetLocal()));
       break;
 
     case Primitive::kPrimInt:
     case Primitive::kPrimNot:
-      return Location::StackSlot(GetStackSlot(load->GetLocal()));
-
     case Primitive::kPrimFloat:
-    case Primitive::kPrimDouble:
-      LOG(FATAL) << "Unimplemented type " << load->GetType();
+      return Location::StackSlot(GetStackSlot(load->GetLocal()));
 
     case Primitive::kPrimBoolean:
     case Primitive::kPrimByte:
@@ -330,10 +402,12 @@ void CodeGeneratorX86_64::Move(HInstruction* instruction,
       case Primitive::kPrimShort:
       case Primitive::kPrimInt:
       case Primitive::kPrimNot:
+      case Primitive::kPrimFloat:
         Move(location, Location::StackSlot(GetStackSlot(instruction->AsLoadLocal()->GetLocal())));
         break;
 
       case Primitive::kPrimLong:
+      case Primitive::kPrimDouble:
         Move(location, Location::DoubleStackSlot(GetStackSlot(instruction->AsLoadLocal()->GetLocal())));
         break;
 
@@ -350,6 +424,8 @@ void CodeGeneratorX86_64::Move(HInstruction* instruction,
       case Primitive::kPrimInt:
       case Primitive::kPrimNot:
       case Primitive::kPrimLong:
+      case Primitive::kPrimFloat:
+      case Primitive::kPrimDouble:
         Move(location, instruction->GetLocations()->Out());
         break;
 
@@ -386,40 +462,58 @@ void InstructionCodeGeneratorX86_64::VisitExit(HExit* exit) {
 void LocationsBuilderX86_64::VisitIf(HIf* if_instr) {
   LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(if_instr);
   HInstruction* cond = if_instr->InputAt(0);
-  DCHECK(cond->IsCondition());
-  HCondition* condition = cond->AsCondition();
-  if (condition->NeedsMaterialization()) {
-    locations->SetInAt(0, Location::Any());
+  if (cond->IsIntConstant()) {
+    // A condition folded to a constant: the branch taken is known.
+    locations->SetInAt(0, Location::ConstantLocation(cond->AsConstant()));
+  } else {
+    DCHECK(cond->IsCondition());
+    HCondition* condition = cond->AsCondition();
+    if (condition->NeedsMaterialization()) {
+      locations->SetInAt(0, Location::Any());
+    }
   }
   if_instr->SetLocations(locations);
 }
 
 void InstructionCodeGeneratorX86_64::VisitIf(HIf* if_instr) {
   HInstruction* cond = if_instr->InputAt(0);
-  DCHECK(cond->IsCondition());
-  HCondition* condition = cond->AsCondition();
-  if (condition->NeedsMaterialization()) {
-    // Materialized condition, compare against 0.
-    Location lhs = if_instr->GetLocations()->InAt(0);
-    if (lhs.IsRegister()) {
-      __ cmpl(lhs.AsX86_64().AsCpuRegister(), Immediate(0));
+  if (cond->IsIntConstant()) {
+    // The condition was folded to 0 or 1.
+    int32_t cond_value = cond->AsIntConstant()->GetValue();
+    if (cond_value == 1) {
+      if (!codegen_->GoesToNextBlock(if_instr->GetBlock(), if_instr->IfTrueSuccessor())) {
+        __ jmp(codegen_->GetLabelOf(if_instr->IfTrueSuccessor()));
+      }
+      return;
     } else {
-      __ cmpl(Address(CpuRegister(RSP), lhs.GetStackIndex()), Immediate(0));
+      DCHECK_EQ(cond_value, 0);
     }
-    __ j(kEqual, codegen_->GetLabelOf(if_instr->IfTrueSuccessor()));
   } else {
-    Location lhs = condition->GetLocations()->InAt(0);
-    Location rhs = condition->GetLocations()->InAt(1);
-    if (rhs.IsRegister()) {
-      __ cmpl(lhs.AsX86_64().AsCpuRegister(), rhs.AsX86_64().AsCpuRegister());
-    } else if (rhs.IsConstant()) {
-      __ cmpl(lhs.AsX86_64().AsCpuRegister(),
-              Immediate(rhs.GetConstant()->AsIntConstant()->GetValue()));
+    DCHECK(cond->IsCondition());
+    HCondition* condition = cond->AsCondition();
+    if (condition->NeedsMaterialization()) {
+      // Materialized condition, compare against 0.
+      Location lhs = if_instr->GetLocations()->InAt(0);
+      if (lhs.IsRegister()) {
+        __ cmpl(lhs.AsX86_64().AsCpuRegister(), Immediate(0));
+      } else {
+        __ cmpl(Address(CpuRegister(RSP), lhs.GetStackIndex()), Immediate(0));
+      }
+      __ j(kEqual, codegen_->GetLabelOf(if_instr->IfTrueSuccessor()));
     } else {
-      __ cmpl(lhs.AsX86_64().AsCpuRegister(), Address(CpuRegister(RSP), rhs.GetStackIndex()));
+      Location lhs = condition->GetLocations()->InAt(0);
+      Location rhs = condition->GetLocations()->InAt(1);
+      if (rhs.IsRegister()) {
+        __ cmpl(lhs.AsX86_64().AsCpuRegister(), rhs.AsX86_64().AsCpuRegister());
+      } else if (rhs.IsConstant()) {
+        __ cmpl(lhs.AsX86_64().AsCpuRegister(),
+                Immediate(rhs.GetConstant()->AsIntConstant()->GetValue()));
+      } else {
+        __ cmpl(lhs.AsX86_64().AsCpuRegister(), Address(CpuRegister(RSP), rhs.GetStackIndex()));
+      }
+      __ j(X86_64Condition(condition->GetCondition()),
+           codegen_->GetLabelOf(if_instr->IfTrueSuccessor()));
     }
-    __ j(X86_64Condition(condition->GetCondition()),
-         codegen_->GetLabelOf(if_instr->IfTrueSuccessor()));
   }
   if (!codegen_->GoesToNextBlock(if_instr->GetBlock(), if_instr->IfFalseSuccessor())) {
     __ jmp(codegen_->GetLabelOf(if_instr->IfFalseSuccessor()));
@@ -451,10 +545,12 @@ void LocationsBuilderX86_64::VisitStoreLocal(HStoreLocal* store) {
     case Primitive::kPrimShort:
     case Primitive::kPrimInt:
     case Primitive::kPrimNot:
+    case Primitive::kPrimFloat:
       locations->SetInAt(1, Location::StackSlot(codegen_->GetStackSlot(store->GetLocal())));
       break;
 
     case Primitive::kPrimLong:
+    case Primitive::kPrimDouble:
       locations->SetInAt(1, Location::DoubleStackSlot(codegen_->GetStackSlot(store->GetLocal())));
       break;
 
@@ -552,26 +648,46 @@ void LocationsBuilderX86_64::VisitCompare(HCompare* compare) {
 }
 
 void InstructionCodeGeneratorX86_64::VisitCompare(HCompare* compare) {
-  Label greater, done;
+  Label less, greater, done;
   LocationSummary* locations = compare->GetLocations();
-  switch (compare->InputAt(0)->GetType()) {
+  Condition less_cond = kLess;
+  switch (compare->GetInputType()) {
     case Primitive::kPrimLong:
       __ cmpq(locations->InAt(0).AsX86_64().AsCpuRegister(),
               locations->InAt(1).AsX86_64().AsCpuRegister());
       break;
+    case Primitive::kPrimFloat:
+    case Primitive::kPrimDouble: {
+      bool is_double = compare->GetInputType() == Primitive::kPrimDouble;
+      MoveToFpuRegister(XmmRegister(XMM0), locations->InAt(0), is_double);
+      MoveToFpuRegister(XmmRegister(XMM1), locations->InAt(1), is_double);
+      if (is_double) {
+        __ comisd(XmmRegister(XMM0), XmmRegister(XMM1));
+      } else {
+        __ comiss(XmmRegister(XMM0), XmmRegister(XMM1));
+      }
+      less_cond = kBelow;
+      break;
+    }
     default:
-      LOG(FATAL) << "Unimplemented compare type " << compare->InputAt(0)->GetType();
+      LOG(FATAL) << "Unimplemented compare type " << compare->GetInputType();
   }
 
-  __ movl(locations->Out().AsX86_64().AsCpuRegister(), Immediate(0));
+  CpuRegister out = locations->Out().AsX86_64().AsCpuRegister();
+  __ movl(out, Immediate(0));
+  if (compare->IsFloatingPoint()) {
+    // An unordered comparison, with a NaN, sets the parity flag.
+    __ j(kParityEven, compare->IsGtBias() ? &greater : &less);
+  }
   __ j(kEqual, &done);
-  __ j(kGreater, &greater);
+  __ j(less_cond, &less);
 
-  __ movl(locations->Out().AsX86_64().AsCpuRegister(), Immediate(-1));
+  __ Bind(&greater);
+  __ movl(out, Immediate(1));
   __ jmp(&done);
 
-  __ Bind(&greater);
-  __ movl(locations->Out().AsX86_64().AsCpuRegister(), Immediate(1));
+  __ Bind(&less);
+  __ movl(out, Immediate(-1));
 
   __ Bind(&done);
 }
@@ -613,6 +729,8 @@ void LocationsBuilderX86_64::VisitReturn(HReturn* ret) {
     case Primitive::kPrimInt:
     case Primitive::kPrimNot:
     case Primitive::kPrimLong:
+    case Primitive::kPrimFloat:
+    case Primitive::kPrimDouble:
       locations->SetInAt(0, X86_64CpuLocation(RAX));
       break;
 
@@ -632,6 +750,8 @@ void InstructionCodeGeneratorX86_64::VisitReturn(HReturn* ret) {
       case Primitive::kPrimInt:
       case Primitive::kPrimNot:
       case Primitive::kPrimLong:
+      case Primitive::kPrimFloat:
+      case Primitive::kPrimDouble:
         DCHECK_EQ(ret->GetLocations()->InAt(0).AsX86_64().AsCpuRegister().AsRegister(), RAX);
         break;
 
@@ -639,6 +759,12 @@ void InstructionCodeGeneratorX86_64::VisitReturn(HReturn* ret) {
         LOG(FATAL) << "Unimplemented return type " << ret->InputAt(0)->GetType();
     }
   }
+  // Float and double values are returned in XMM0.
+  Primitive::Type return_type = ret->GetReturnType();
+  if (Primitive::IsFloatingPointType(return_type)) {
+    MoveToFpuRegister(XmmRegister(XMM0), ret->GetLocations()->InAt(0),
+                      return_type == Primitive::kPrimDouble);
+  }
   codegen_->GenerateFrameExit();
   __ ret();
 }
@@ -672,10 +798,18 @@ Location InvokeDexCallingConventionVisitor::GetNextLocation(Primitive::Type type
       }
     }
 
-    case Primitive::kPrimDouble:
-    case Primitive::kPrimFloat:
-      LOG(FATAL) << "Unimplemented parameter type " << type;
-      break;
+    // Float and double arguments are passed in XMM registers when there are enough, but
+    // are kept in the stack slot reserved for them. See
+    // InstructionCodeGeneratorX86_64::LoadFloatingPointArguments and VisitParameterValue.
+    case Primitive::kPrimFloat: {
+      stack_index_++;
+      return Location::StackSlot(calling_convention.GetStackOffsetOf(stack_index_ - 1));
+    }
+
+    case Primitive::kPrimDouble: {
+      stack_index_ += 2;
+      return Location::DoubleStackSlot(calling_convention.GetStackOffsetOf(stack_index_ - 2));
+    }
 
     case Primitive::kPrimVoid:
       LOG(FATAL) << "Unexpected parameter type " << type;
@@ -685,6 +819,20 @@ Location InvokeDexCallingConventionVisitor::GetNextLocation(Primitive::Type type
 }
 
 void LocationsBuilderX86_64::VisitInvokeStatic(HInvokeStatic* invoke) {
+  HandleInvoke(invoke);
+}
+
+void LocationsBuilderX86_64::VisitInvokeVirtual(HInvokeVirtual* invoke) {
+  HandleInvoke(invoke);
+}
+
+void LocationsBuilderX86_64::VisitInvokeInterface(HInvokeInterface* invoke) {
+  HandleInvoke(invoke);
+  // The IMT conflict trampoline expects the dex method index in RAX.
+  invoke->GetLocations()->AddTemp(X86_64CpuLocation(RAX));
+}
+
+void LocationsBuilderX86_64::HandleInvoke(HInvoke* invoke) {
   codegen_->MarkNotLeaf();
   LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(invoke);
   locations->AddTemp(X86_64CpuLocation(RDI));
@@ -703,16 +851,13 @@ void LocationsBuilderX86_64::VisitInvokeStatic(HInvokeStatic* invoke) {
     case Primitive::kPrimInt:
     case Primitive::kPrimNot:
     case Primitive::kPrimLong:
+    case Primitive::kPrimFloat:
+    case Primitive::kPrimDouble:
       locations->SetOut(X86_64CpuLocation(RAX));
       break;
 
     case Primitive::kPrimVoid:
       break;
-
-    case Primitive::kPrimDouble:
-    case Primitive::kPrimFloat:
-      LOG(FATAL) << "Unimplemented return type " << invoke->GetType();
-      break;
   }
 
   invoke->SetLocations(locations);
@@ -737,12 +882,119 @@ void InstructionCodeGeneratorX86_64::VisitInvokeStatic(HInvokeStatic* invoke) {
   __ movl(temp, Address(temp, mirror::ArtMethod::DexCacheResolvedMethodsOffset().SizeValue()));
   // temp = temp[index_in_cache]
   __ movl(temp, Address(temp, index_in_cache));
+  LoadFloatingPointArguments(invoke);
   // (temp + offset_of_quick_compiled_code)()
   __ call(Address(temp, mirror::ArtMethod::EntryPointFromQuickCompiledCodeOffset(
                   kX86_64PointerSize).SizeValue()));
 
   DCHECK(!codegen_->IsLeafMethod());
   codegen_->RecordPcInfo(invoke->GetDexPc());
+  if (Primitive::IsFloatingPointType(invoke->GetType())) {
+    // Float and double values are returned in XMM0.
+    MoveFromFpuRegister(invoke->GetLocations()->Out(), XmmRegister(XMM0),
+                        invoke->GetType() == Primitive::kPrimDouble);
+  }
+}
+
+void InstructionCodeGeneratorX86_64::VisitInvokeVirtual(HInvokeVirtual* invoke) {
+  LocationSummary* locations = invoke->GetLocations();
+  CpuRegister temp = locations->GetTemp(0).AsX86_64().AsCpuRegister();
+  // The receiver is the first argument, which is always passed in a register.
+  CpuRegister receiver = locations->InAt(0).AsX86_64().AsCpuRegister();
+  size_t method_offset = mirror::Class::EmbeddedVTableOffset().SizeValue() +
+      invoke->GetVTableIndex() * sizeof(mirror::Class::VTableEntry);
+
+  // temp = receiver->klass_;
+  __ movl(temp, Address(receiver, mirror::Object::ClassOffset().SizeValue()));
+  // temp = temp->embedded_vtable_[vtable_index];
+  __ movl(temp, Address(temp, method_offset));
+  LoadFloatingPointArguments(invoke);
+  // (temp + offset_of_quick_compiled_code)()
+  __ call(Address(temp, mirror::ArtMethod::EntryPointFromQuickCompiledCodeOffset(
+                  kX86_64PointerSize).SizeValue()));
+
+  DCHECK(!codegen_->IsLeafMethod());
+  codegen_->RecordPcInfo(invoke->GetDexPc());
+  if (Primitive::IsFloatingPointType(invoke->GetType())) {
+    // Float and double values are returned in XMM0.
+    MoveFromFpuRegister(invoke->GetLocations()->Out(), XmmRegister(XMM0),
+                        invoke->GetType() == Primitive::kPrimDouble);
+  }
+}
+
+void InstructionCodeGeneratorX86_64::VisitInvokeInterface(HInvokeInterface* invoke) {
+  LocationSummary* locations = invoke->GetLocations();
+  CpuRegister temp = locations->GetTemp(0).AsX86_64().AsCpuRegister();
+  CpuRegister hidden_argument = locations->GetTemp(1).AsX86_64().AsCpuRegister();
+  CpuRegister receiver = locations->InAt(0).AsX86_64().AsCpuRegister();
+  size_t method_offset = mirror::Class::EmbeddedImTableOffset().SizeValue() +
+      (invoke->GetImtIndex() % mirror::Class::kImtSize) * sizeof(mirror::Class::ImTableEntry);
+
+  __ movl(hidden_argument, Immediate(invoke->GetDexMethodIndex()));
+  // temp = receiver->klass_;
+  __ movl(temp, Address(receiver, mirror::Object::ClassOffset().SizeValue()));
+  // temp = temp->embedded_imtable_[imt_index];
+  __ movl(temp, Address(temp, method_offset));
+  LoadFloatingPointArguments(invoke);
+  // (temp + offset_of_quick_compiled_code)()
+  __ call(Address(temp, mirror::ArtMethod::EntryPointFromQuickCompiledCodeOffset(
+                  kX86_64PointerSize).SizeValue()));
+
+  DCHECK(!codegen_->IsLeafMethod());
+  codegen_->RecordPcInfo(invoke->GetDexPc());
+  if (Primitive::IsFloatingPointType(invoke->GetType())) {
+    // Float and double values are returned in XMM0.
+    MoveFromFpuRegister(invoke->GetLocations()->Out(), XmmRegister(XMM0),
+                        invoke->GetType() == Primitive::kPrimDouble);
+  }
+}
+
+void InstructionCodeGeneratorX86_64::LoadFloatingPointArguments(HInvoke* invoke) {
+  InvokeDexCallingConvention calling_convention;
+  LocationSummary* locations = invoke->GetLocations();
+  size_t fp_index = 0;
+  for (size_t i = 0; i < invoke->InputCount(); ++i) {
+    // The inputs of an invoke are loads of locals, typed from the signature of the callee.
+    Primitive::Type type = invoke->InputAt(i)->GetType();
+    if (!Primitive::IsFloatingPointType(type)) {
+      continue;
+    }
+    if (fp_index == calling_convention.GetNumberOfFpuRegisters()) {
+      // The remaining arguments are passed on the stack.
+      break;
+    }
+    XmmRegister reg(calling_convention.GetFpuRegisterAt(fp_index++));
+    Address slot(CpuRegister(RSP), locations->InAt(i).GetStackIndex());
+    if (type == Primitive::kPrimDouble) {
+      __ movsd(reg, slot);
+    } else {
+      __ movss(reg, slot);
+    }
+  }
+}
+
+void InstructionCodeGeneratorX86_64::MoveToFpuRegister(XmmRegister dst,
+                                                       Location src,
+                                                       bool is64bit) {
+  if (src.IsRegister()) {
+    __ movd(dst, src.AsX86_64().AsCpuRegister(), is64bit);
+  } else if (is64bit) {
+    __ movsd(dst, Address(CpuRegister(RSP), src.GetStackIndex()));
+  } else {
+    __ movss(dst, Address(CpuRegister(RSP), src.GetStackIndex()));
+  }
+}
+
+void InstructionCodeGeneratorX86_64::MoveFromFpuRegister(Location dst,
+                                                         XmmRegister src,
+                                                         bool is64bit) {
+  if (dst.IsRegister()) {
+    __ movd(dst.AsX86_64().AsCpuRegister(), src, is64bit);
+  } else if (is64bit) {
+    __ movsd(Address(CpuRegister(RSP), dst.GetStackIndex()), src);
+  } else {
+    __ movss(Address(CpuRegister(RSP), dst.GetStackIndex()), src);
+  }
 }
 
 void LocationsBuilderX86_64::VisitAdd(HAdd* add) {
@@ -754,7 +1006,9 @@ void LocationsBuilderX86_64::VisitAdd(HAdd* add) {
       locations->SetOut(Location::SameAsFirstInput());
       break;
     }
-    case Primitive::kPrimLong: {
+    case Primitive::kPrimLong:
+    case Primitive::kPrimFloat:
+    case Primitive::kPrimDouble: {
       locations->SetInAt(0, Location::RequiresRegister());
       locations->SetInAt(1, Location::RequiresRegister());
       locations->SetOut(Location::SameAsFirstInput());
@@ -798,6 +1052,20 @@ void InstructionCodeGeneratorX86_64::VisitAdd(HAdd* add) {
               locations->InAt(1).AsX86_64().AsCpuRegister());
       break;
     }
+    case Primitive::kPrimFloat: {
+      MoveToFpuRegister(XmmRegister(XMM0), locations->InAt(0), false);
+      MoveToFpuRegister(XmmRegister(XMM1), locations->InAt(1), false);
+      __ addss(XmmRegister(XMM0), XmmRegister(XMM1));
+      MoveFromFpuRegister(locations->Out(), XmmRegister(XMM0), false);
+      break;
+    }
+    case Primitive::kPrimDouble: {
+      MoveToFpuRegister(XmmRegister(XMM0), locations->InAt(0), true);
+      MoveToFpuRegister(XmmRegister(XMM1), locations->InAt(1), true);
+      __ addsd(XmmRegister(XMM0), XmmRegister(XMM1));
+      MoveFromFpuRegister(locations->Out(), XmmRegister(XMM0), true);
+      break;
+    }
 
     case Primitive::kPrimBoolean:
     case Primitive::kPrimByte:
@@ -820,7 +1088,9 @@ void LocationsBuilderX86_64::VisitSub(HSub* sub) {
       locations->SetOut(Location::SameAsFirstInput());
       break;
     }
-    case Primitive::kPrimLong: {
+    case Primitive::kPrimLong:
+    case Primitive::kPrimFloat:
+    case Primitive::kPrimDouble: {
       locations->SetInAt(0, Location::RequiresRegister());
       locations->SetInAt(1, Location::RequiresRegister());
       locations->SetOut(Location::SameAsFirstInput());
@@ -864,6 +1134,20 @@ void InstructionCodeGeneratorX86_64::VisitSub(HSub* sub) {
               locations->InAt(1).AsX86_64().AsCpuRegister());
       break;
     }
+    case Primitive::kPrimFloat: {
+      MoveToFpuRegister(XmmRegister(XMM0), locations->InAt(0), false);
+      MoveToFpuRegister(XmmRegister(XMM1), locations->InAt(1), false);
+      __ subss(XmmRegister(XMM0), XmmRegister(XMM1));
+      MoveFromFpuRegister(locations->Out(), XmmRegister(XMM0), false);
+      break;
+    }
+    case Primitive::kPrimDouble: {
+      MoveToFpuRegister(XmmRegister(XMM0), locations->InAt(0), true);
+      MoveToFpuRegister(XmmRegister(XMM1), locations->InAt(1), true);
+      __ subsd(XmmRegister(XMM0), XmmRegister(XMM1));
+      MoveFromFpuRegister(locations->Out(), XmmRegister(XMM0), true);
+      break;
+    }
 
     case Primitive::kPrimBoolean:
     case Primitive::kPrimByte:
@@ -877,6 +1161,329 @@ void InstructionCodeGeneratorX86_64::VisitSub(HSub* sub) {
   }
 }
 
+void LocationsBuilderX86_64::VisitMul(HMul* mul) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(mul);
+  switch (mul->GetResultType()) {
+    case Primitive::kPrimInt:
+    case Primitive::kPrimLong:
+    case Primitive::kPrimFloat:
+    case Primitive::kPrimDouble: {
+      locations->SetInAt(0, Location::RequiresRegister());
+      locations->SetInAt(1, Location::RequiresRegister());
+      locations->SetOut(Location::SameAsFirstInput());
+      break;
+    }
+
+    default:
+      LOG(FATAL) << "Unexpected mul type " << mul->GetResultType();
+  }
+  mul->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorX86_64::VisitMul(HMul* mul) {
+  LocationSummary* locations = mul->GetLocations();
+  DCHECK_EQ(locations->InAt(0).AsX86_64().AsCpuRegister().AsRegister(),
+            locations->Out().AsX86_64().AsCpuRegister().AsRegister());
+  switch (mul->GetResultType()) {
+    case Primitive::kPrimInt: {
+      __ imull(locations->InAt(0).AsX86_64().AsCpuRegister(),
+               locations->InAt(1).AsX86_64().AsCpuRegister());
+      break;
+    }
+    case Primitive::kPrimLong: {
+      __ imulq(locations->InAt(0).AsX86_64().AsCpuRegister(),
+               locations->InAt(1).AsX86_64().AsCpuRegister());
+      break;
+    }
+    case Primitive::kPrimFloat: {
+      MoveToFpuRegister(XmmRegister(XMM0), locations->InAt(0), false);
+      MoveToFpuRegister(XmmRegister(XMM1), locations->InAt(1), false);
+      __ mulss(XmmRegister(XMM0), XmmRegister(XMM1));
+      MoveFromFpuRegister(locations->Out(), XmmRegister(XMM0), false);
+      break;
+    }
+    case Primitive::kPrimDouble: {
+      MoveToFpuRegister(XmmRegister(XMM0), locations->InAt(0), true);
+      MoveToFpuRegister(XmmRegister(XMM1), locations->InAt(1), true);
+      __ mulsd(XmmRegister(XMM0), XmmRegister(XMM1));
+      MoveFromFpuRegister(locations->Out(), XmmRegister(XMM0), true);
+      break;
+    }
+
+    default:
+      LOG(FATAL) << "Unexpected mul type " << mul->GetResultType();
+  }
+}
+
+// idivl divides EDX:EAX, and leaves the quotient in EAX and the remainder in EDX.
+static void SetIntDivOrRemLocations(LocationSummary* locations, bool is_div) {
+  locations->SetInAt(0, X86_64CpuLocation(RAX));
+  locations->SetInAt(1, Location::RequiresRegister());
+  locations->AddTemp(X86_64CpuLocation(RDX));
+  locations->SetOut(X86_64CpuLocation(is_div ? RAX : RDX));
+}
+
+void InstructionCodeGeneratorX86_64::GenerateIntDivOrRem(HBinaryOperation* instruction) {
+  DCHECK(instruction->IsDiv() || instruction->IsRem());
+  LocationSummary* locations = instruction->GetLocations();
+  DCHECK_EQ(RAX, locations->InAt(0).AsX86_64().AsCpuRegister().AsRegister());
+  CpuRegister second = locations->InAt(1).AsX86_64().AsCpuRegister();
+  Label not_minus_one, done;
+
+  // idivl faults on the minimum int divided by -1, whose quotient overflows back to the
+  // dividend. Negating gives that quotient, and the remainder of any division by -1 is 0.
+  __ cmpl(second, Immediate(-1));
+  __ j(kNotEqual, &not_minus_one);
+  if (instruction->IsDiv()) {
+    __ negl(CpuRegister(RAX));
+  } else {
+    __ xorl(CpuRegister(RDX), CpuRegister(RDX));
+  }
+  __ jmp(&done);
+  __ Bind(&not_minus_one);
+  __ cdq();
+  __ idivl(second);
+  __ Bind(&done);
+}
+
+void LocationsBuilderX86_64::VisitDiv(HDiv* div) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(div);
+  if (div->GetResultType() == Primitive::kPrimInt) {
+    SetIntDivOrRemLocations(locations, true);
+  } else {
+    locations->SetInAt(0, Location::RequiresRegister());
+    locations->SetInAt(1, Location::RequiresRegister());
+    locations->SetOut(Location::SameAsFirstInput());
+  }
+  div->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorX86_64::VisitDiv(HDiv* div) {
+  LocationSummary* locations = div->GetLocations();
+  switch (div->GetResultType()) {
+    case Primitive::kPrimInt:
+      GenerateIntDivOrRem(div);
+      break;
+
+    case Primitive::kPrimFloat: {
+      MoveToFpuRegister(XmmRegister(XMM0), locations->InAt(0), false);
+      MoveToFpuRegister(XmmRegister(XMM1), locations->InAt(1), false);
+      __ divss(XmmRegister(XMM0), XmmRegister(XMM1));
+      MoveFromFpuRegister(locations->Out(), XmmRegister(XMM0), false);
+      break;
+    }
+    case Primitive::kPrimDouble: {
+      MoveToFpuRegister(XmmRegister(XMM0), locations->InAt(0), true);
+      MoveToFpuRegister(XmmRegister(XMM1), locations->InAt(1), true);
+      __ divsd(XmmRegister(XMM0), XmmRegister(XMM1));
+      MoveFromFpuRegister(locations->Out(), XmmRegister(XMM0), true);
+      break;
+    }
+
+    default:
+      LOG(FATAL) << "Unexpected div type " << div->GetResultType();
+  }
+}
+
+void LocationsBuilderX86_64::VisitRem(HRem* rem) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(rem);
+  switch (rem->GetResultType()) {
+    case Primitive::kPrimInt:
+      SetIntDivOrRemLocations(locations, false);
+      break;
+
+    default:
+      LOG(FATAL) << "Unexpected rem type " << rem->GetResultType();
+  }
+  rem->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorX86_64::VisitRem(HRem* rem) {
+  switch (rem->GetResultType()) {
+    case Primitive::kPrimInt:
+      GenerateIntDivOrRem(rem);
+      break;
+
+    default:
+      LOG(FATAL) << "Unexpected rem type " << rem->GetResultType();
+  }
+}
+
+void LocationsBuilderX86_64::VisitDivZeroCheck(HDivZeroCheck* instruction) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
+  locations->SetInAt(0, Location::Any());
+  locations->SetOut(Location::SameAsFirstInput());
+  instruction->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorX86_64::VisitDivZeroCheck(HDivZeroCheck* instruction) {
+  SlowPathCode* slow_path =
+      new (GetGraph()->GetArena()) DivZeroCheckSlowPathX86_64(instruction->GetDexPc());
+  codegen_->AddSlowPath(slow_path);
+
+  LocationSummary* locations = instruction->GetLocations();
+  Location value = locations->InAt(0);
+  DCHECK(value.Equals(locations->Out()));
+
+  if (value.IsRegister()) {
+    __ cmpl(value.AsX86_64().AsCpuRegister(), Immediate(0));
+  } else {
+    DCHECK(value.IsStackSlot());
+    __ cmpl(Address(CpuRegister(RSP), value.GetStackIndex()), Immediate(0));
+  }
+  __ j(kEqual, slow_path->GetEntryLabel());
+}
+
+void LocationsBuilderX86_64::VisitNeg(HNeg* neg) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(neg);
+  locations->SetInAt(0, Location::RequiresRegister());
+  locations->SetOut(Location::SameAsFirstInput());
+  neg->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorX86_64::VisitNeg(HNeg* neg) {
+  LocationSummary* locations = neg->GetLocations();
+  CpuRegister out = locations->Out().AsX86_64().AsCpuRegister();
+  DCHECK_EQ(locations->InAt(0).AsX86_64().AsCpuRegister().AsRegister(), out.AsRegister());
+  switch (neg->GetResultType()) {
+    case Primitive::kPrimInt:
+      __ negl(out);
+      break;
+
+    case Primitive::kPrimLong:
+      __ negq(out);
+      break;
+
+    // Negating a float or a double flips its sign bit, including for NaN and zero.
+    case Primitive::kPrimFloat:
+      __ xorl(out, Immediate(static_cast<int32_t>(0x80000000)));
+      break;
+
+    case Primitive::kPrimDouble:
+      __ movq(CpuRegister(TMP), Immediate(static_cast<int64_t>(UINT64_C(0x8000000000000000))));
+      __ xorq(out, CpuRegister(TMP));
+      break;
+
+    default:
+      LOG(FATAL) << "Unexpected neg type " << neg->GetResultType();
+  }
+}
+
+void LocationsBuilderX86_64::VisitTypeConversion(HTypeConversion* conversion) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(conversion);
+  locations->SetInAt(0, Location::RequiresRegister());
+  locations->SetOut(Location::RequiresRegister());
+  conversion->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorX86_64::VisitTypeConversion(HTypeConversion* conversion) {
+  LocationSummary* locations = conversion->GetLocations();
+  CpuRegister in = locations->InAt(0).AsX86_64().AsCpuRegister();
+  CpuRegister out = locations->Out().AsX86_64().AsCpuRegister();
+  Primitive::Type input_type = conversion->GetInputType();
+  Primitive::Type result_type = conversion->GetResultType();
+  switch (result_type) {
+    case Primitive::kPrimByte:
+      DCHECK_EQ(input_type, Primitive::kPrimInt);
+      __ movsxb(out, in);
+      break;
+
+    case Primitive::kPrimShort:
+      DCHECK_EQ(input_type, Primitive::kPrimInt);
+      __ movsxw(out, in);
+      break;
+
+    case Primitive::kPrimChar:
+      DCHECK_EQ(input_type, Primitive::kPrimInt);
+      __ movzxw(out, in);
+      break;
+
+    case Primitive::kPrimInt:
+    case Primitive::kPrimLong:
+      if (input_type == Primitive::kPrimInt) {
+        __ movsxd(out, in);
+      } else if (input_type == Primitive::kPrimLong) {
+        __ movl(out, in);
+      } else {
+        GenerateFloatingPointToIntegral(conversion);
+      }
+      break;
+
+    case Primitive::kPrimFloat:
+      if (input_type == Primitive::kPrimDouble) {
+        __ movd(XmmRegister(XMM0), in, true);
+        __ cvtsd2ss(XmmRegister(XMM0), XmmRegister(XMM0));
+      } else {
+        __ cvtsi2ss(XmmRegister(XMM0), in, input_type == Primitive::kPrimLong);
+      }
+      __ movd(out, XmmRegister(XMM0), false);
+      break;
+
+    case Primitive::kPrimDouble:
+      if (input_type == Primitive::kPrimFloat) {
+        __ movd(XmmRegister(XMM0), in, false);
+        __ cvtss2sd(XmmRegister(XMM0), XmmRegister(XMM0));
+      } else {
+        __ cvtsi2sd(XmmRegister(XMM0), in, input_type == Primitive::kPrimLong);
+      }
+      __ movd(out, XmmRegister(XMM0), true);
+      break;
+
+    default:
+      LOG(FATAL) << "Unexpected type conversion from " << input_type << " to " << result_type;
+  }
+}
+
+void InstructionCodeGeneratorX86_64::GenerateFloatingPointToIntegral(
+    HTypeConversion* conversion) {
+  LocationSummary* locations = conversion->GetLocations();
+  CpuRegister out = locations->Out().AsX86_64().AsCpuRegister();
+  bool is_double = conversion->GetInputType() == Primitive::kPrimDouble;
+  bool is_long = conversion->GetResultType() == Primitive::kPrimLong;
+  XmmRegister value(XMM0);
+  XmmRegister zero(XMM1);
+  MoveToFpuRegister(value, locations->InAt(0), is_double);
+  if (is_double) {
+    __ cvttsd2si(out, value, is_long);
+  } else {
+    __ cvttss2si(out, value, is_long);
+  }
+
+  // The conversion returns the minimum value for NaN and for values out of range. Java
+  // wants zero for NaN, and the maximum value for large positive values.
+  Label nan, done;
+  if (is_long) {
+    __ movq(CpuRegister(TMP), Immediate(std::numeric_limits<int64_t>::min()));
+    __ cmpq(out, CpuRegister(TMP));
+  } else {
+    __ cmpl(out, Immediate(std::numeric_limits<int32_t>::min()));
+  }
+  __ j(kNotEqual, &done);
+  if (is_double) {
+    __ comisd(value, value);
+  } else {
+    __ comiss(value, value);
+  }
+  __ j(kParityEven, &nan);
+  if (is_double) {
+    __ xorpd(zero, zero);
+    __ comisd(value, zero);
+  } else {
+    __ xorps(zero, zero);
+    __ comiss(value, zero);
+  }
+  __ j(kBelow, &done);
+  if (is_long) {
+    __ movq(out, Immediate(std::numeric_limits<int64_t>::max()));
+  } else {
+    __ movl(out, Immediate(std::numeric_limits<int32_t>::max()));
+  }
+  __ jmp(&done);
+  __ Bind(&nan);
+  __ xorl(out, out);
+  __ Bind(&done);
+}
+
 void LocationsBuilderX86_64::VisitNewInstance(HNewInstance* instruction) {
   codegen_->MarkNotLeaf();
   LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
@@ -896,6 +1503,110 @@ void InstructionCodeGeneratorX86_64::VisitNewInstance(HNewInstance* instruction)
   codegen_->RecordPcInfo(instruction->GetDexPc());
 }
 
+void LocationsBuilderX86_64::VisitLoadClass(HLoadClass* cls) {
+  codegen_->MarkNotLeaf();
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(cls);
+  locations->SetOut(X86_64CpuLocation(RAX));
+  InvokeRuntimeCallingConvention calling_convention;
+  locations->AddTemp(X86_64CpuLocation(calling_convention.GetRegisterAt(0)));
+  locations->AddTemp(X86_64CpuLocation(calling_convention.GetRegisterAt(1)));
+  cls->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorX86_64::VisitLoadClass(HLoadClass* cls) {
+  InvokeRuntimeCallingConvention calling_convention;
+  CpuRegister method = CpuRegister(calling_convention.GetRegisterAt(1));
+  CpuRegister out = cls->GetLocations()->Out().AsX86_64().AsCpuRegister();
+  LoadCurrentMethod(method);
+
+  if (cls->NeedsAccessCheck()) {
+    __ movl(CpuRegister(calling_convention.GetRegisterAt(0)), Immediate(cls->GetTypeIndex()));
+    __ gs()->call(Address::Absolute(
+        QUICK_ENTRYPOINT_OFFSET(kX86_64WordSize, pInitializeTypeAndVerifyAccess), true));
+    codegen_->RecordPcInfo(cls->GetDexPc());
+  } else {
+    SlowPathCode* slow_path = new (GetGraph()->GetArena()) LoadClassSlowPathX86_64(
+        cls->GetTypeIndex(), cls->GetDexPc());
+    codegen_->AddSlowPath(slow_path);
+    uint32_t heap_reference_size = sizeof(mirror::HeapReference<mirror::Object>);
+    size_t index_in_cache = mirror::Array::DataOffset(heap_reference_size).SizeValue() +
+        cls->GetTypeIndex() * heap_reference_size;
+    // out = method->dex_cache_resolved_types_[type_index]
+    __ movl(out, Address(method, mirror::ArtMethod::DexCacheResolvedTypesOffset().SizeValue()));
+    __ movl(out, Address(out, index_in_cache));
+    __ testl(out, out);
+    __ j(kEqual, slow_path->GetEntryLabel());
+    __ Bind(slow_path->GetExitLabel());
+  }
+  DCHECK(!codegen_->IsLeafMethod());
+}
+
+// The type checks compare the class of the object with the class checked against, and
+// only call the runtime when they differ.
+static void SetTypeCheckLocations(LocationSummary* locations) {
+  locations->SetInAt(0, Location::RequiresRegister());
+  locations->SetInAt(1, Location::RequiresRegister());
+  InvokeRuntimeCallingConvention calling_convention;
+  locations->AddTemp(X86_64CpuLocation(calling_convention.GetRegisterAt(0)));
+  locations->AddTemp(X86_64CpuLocation(calling_convention.GetRegisterAt(1)));
+}
+
+void LocationsBuilderX86_64::VisitInstanceOf(HInstanceOf* instruction) {
+  codegen_->MarkNotLeaf();
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
+  SetTypeCheckLocations(locations);
+  locations->SetOut(X86_64CpuLocation(RAX));
+  instruction->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorX86_64::VisitInstanceOf(HInstanceOf* instruction) {
+  LocationSummary* locations = instruction->GetLocations();
+  CpuRegister obj = locations->InAt(0).AsX86_64().AsCpuRegister();
+  CpuRegister cls = locations->InAt(1).AsX86_64().AsCpuRegister();
+  CpuRegister obj_cls = locations->GetTemp(1).AsX86_64().AsCpuRegister();
+  CpuRegister out = locations->Out().AsX86_64().AsCpuRegister();
+  SlowPathCode* slow_path =
+      new (GetGraph()->GetArena()) TypeCheckSlowPathX86_64(instruction, locations->InAt(1));
+  codegen_->AddSlowPath(slow_path);
+  Label is_null;
+
+  __ testl(obj, obj);
+  __ j(kEqual, &is_null);
+  __ movl(obj_cls, Address(obj, mirror::Object::ClassOffset().SizeValue()));
+  __ cmpl(obj_cls, cls);
+  __ j(kNotEqual, slow_path->GetEntryLabel());
+  __ movl(out, Immediate(1));
+  __ jmp(slow_path->GetExitLabel());
+  __ Bind(&is_null);
+  __ xorl(out, out);
+  __ Bind(slow_path->GetExitLabel());
+}
+
+void LocationsBuilderX86_64::VisitCheckCast(HCheckCast* instruction) {
+  codegen_->MarkNotLeaf();
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
+  SetTypeCheckLocations(locations);
+  instruction->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorX86_64::VisitCheckCast(HCheckCast* instruction) {
+  LocationSummary* locations = instruction->GetLocations();
+  CpuRegister obj = locations->InAt(0).AsX86_64().AsCpuRegister();
+  CpuRegister cls = locations->InAt(1).AsX86_64().AsCpuRegister();
+  CpuRegister obj_cls = locations->GetTemp(1).AsX86_64().AsCpuRegister();
+  SlowPathCode* slow_path =
+      new (GetGraph()->GetArena()) TypeCheckSlowPathX86_64(instruction, locations->InAt(1));
+  codegen_->AddSlowPath(slow_path);
+
+  // A null reference can be cast to any type.
+  __ testl(obj, obj);
+  __ j(kEqual, slow_path->GetExitLabel());
+  __ movl(obj_cls, Address(obj, mirror::Object::ClassOffset().SizeValue()));
+  __ cmpl(obj_cls, cls);
+  __ j(kNotEqual, slow_path->GetEntryLabel());
+  __ Bind(slow_path->GetExitLabel());
+}
+
 void LocationsBuilderX86_64::VisitParameterValue(HParameterValue* instruction) {
   LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
   Location location = parameter_visitor_.GetNextLocation(instruction->GetType());
@@ -909,7 +1620,24 @@ void LocationsBuilderX86_64::VisitParameterValue(HParameterValue* instruction) {
 }
 
 void InstructionCodeGeneratorX86_64::VisitParameterValue(HParameterValue* instruction) {
-  // Nothing to do, the parameter is already at its location.
+  Primitive::Type type = instruction->GetType();
+  if (!Primitive::IsFloatingPointType(type)) {
+    // Nothing to do, the parameter is already at its location.
+    return;
+  }
+  // Floating-point parameters are passed in XMM registers, which the code does not
+  // allocate: spill them to the home slot the parameter visitor gave them.
+  InvokeDexCallingConvention calling_convention;
+  size_t index = number_of_fp_parameters_++;
+  if (index < calling_convention.GetNumberOfFpuRegisters()) {
+    Address home(CpuRegister(RSP), instruction->GetLocations()->Out().GetStackIndex());
+    XmmRegister reg(calling_convention.GetFpuRegisterAt(index));
+    if (type == Primitive::kPrimDouble) {
+      __ movsd(home, reg);
+    } else {
+      __ movss(home, reg);
+    }
+  }
 }
 
 void LocationsBuilderX86_64::VisitNot(HNot* instruction) {
@@ -972,6 +1700,7 @@ void InstructionCodeGeneratorX86_64::VisitInstanceFieldSet(HInstanceFieldSet* in
     }
 
     case Primitive::kPrimInt:
+    case Primitive::kPrimFloat:
     case Primitive::kPrimNot: {
       __ movl(Address(obj, offset), value);
       if (field_type == Primitive::kPrimNot) {
@@ -982,15 +1711,12 @@ void InstructionCodeGeneratorX86_64::VisitInstanceFieldSet(HInstanceFieldSet* in
       break;
     }
 
-    case Primitive::kPrimLong: {
+    case Primitive::kPrimLong:
+    case Primitive::kPrimDouble: {
       __ movq(Address(obj, offset), value);
       break;
     }
 
-    case Primitive::kPrimFloat:
-    case Primitive::kPrimDouble:
-      LOG(FATAL) << "Unimplemented register type " << field_type;
-
     case Primitive::kPrimVoid:
       LOG(FATAL) << "Unreachable type " << field_type;
   }
@@ -1031,20 +1757,18 @@ void InstructionCodeGeneratorX86_64::VisitInstanceFieldGet(HInstanceFieldGet* in
     }
 
     case Primitive::kPrimInt:
+    case Primitive::kPrimFloat:
     case Primitive::kPrimNot: {
       __ movl(out, Address(obj, offset));
       break;
     }
 
-    case Primitive::kPrimLong: {
+    case Primitive::kPrimLong:
+    case Primitive::kPrimDouble: {
       __ movq(out, Address(obj, offset));
       break;
     }
 
-    case Primitive::kPrimFloat:
-    case Primitive::kPrimDouble:
-      LOG(FATAL) << "Unimplemented register type " << instruction->GetType();
-
     case Primitive::kPrimVoid:
       LOG(FATAL) << "Unreachable type " << instruction->GetType();
   }
@@ -1139,6 +1863,7 @@ void InstructionCodeGeneratorX86_64::VisitArrayGet(HArrayGet* instruction) {
     }
 
     case Primitive::kPrimInt:
+    case Primitive::kPrimFloat:
     case Primitive::kPrimNot: {
       DCHECK_EQ(sizeof(mirror::HeapReference<mirror::Object>), sizeof(int32_t));
       uint32_t data_offset = mirror::Array::DataOffset(sizeof(int32_t)).Uint32Value();
@@ -1152,7 +1877,8 @@ void InstructionCodeGeneratorX86_64::VisitArrayGet(HArrayGet* instruction) {
       break;
     }
 
-    case Primitive::kPrimLong: {
+    case Primitive::kPrimLong:
+    case Primitive::kPrimDouble: {
       uint32_t data_offset = mirror::Array::DataOffset(sizeof(int64_t)).Uint32Value();
       CpuRegister out = locations->Out().AsX86_64().AsCpuRegister();
       if (index.IsConstant()) {
@@ -1164,10 +1890,6 @@ void InstructionCodeGeneratorX86_64::VisitArrayGet(HArrayGet* instruction) {
       break;
     }
 
-    case Primitive::kPrimFloat:
-    case Primitive::kPrimDouble:
-      LOG(FATAL) << "Unimplemented register type " << instruction->GetType();
-
     case Primitive::kPrimVoid:
       LOG(FATAL) << "Unreachable type " << instruction->GetType();
   }
@@ -1223,7 +1945,8 @@ void InstructionCodeGeneratorX86_64::VisitArraySet(HArraySet* instruction) {
       break;
     }
 
-    case Primitive::kPrimInt: {
+    case Primitive::kPrimInt:
+    case Primitive::kPrimFloat: {
       uint32_t data_offset = mirror::Array::DataOffset(sizeof(int32_t)).Uint32Value();
       CpuRegister value = locations->InAt(2).AsX86_64().AsCpuRegister();
       if (index.IsConstant()) {
@@ -1242,7 +1965,8 @@ void InstructionCodeGeneratorX86_64::VisitArraySet(HArraySet* instruction) {
       break;
     }
 
-    case Primitive::kPrimLong: {
+    case Primitive::kPrimLong:
+    case Primitive::kPrimDouble: {
       uint32_t data_offset = mirror::Array::DataOffset(sizeof(int64_t)).Uint32Value();
       CpuRegister value = locations->InAt(2).AsX86_64().AsCpuRegister();
       if (index.IsConstant()) {
@@ -1254,10 +1978,6 @@ void InstructionCodeGeneratorX86_64::VisitArraySet(HArraySet* instruction) {
       break;
     }
 
-    case Primitive::kPrimFloat:
-    case Primitive::kPrimDouble:
-      LOG(FATAL) << "Unimplemented register type " << instruction->GetType();
-
     case Primitive::kPrimVoid:
       LOG(FATAL) << "Unreachable type " << instruction->GetType();
   }
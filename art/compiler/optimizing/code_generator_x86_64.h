@@ -31,11 +31,23 @@ static constexpr Register kParameterCoreRegisters[] = { RSI, RDX, RCX, R8, R9 };
 
 static constexpr size_t kParameterCoreRegistersLength = arraysize(kParameterCoreRegisters);
 
+static constexpr FloatRegister kParameterFloatRegisters[] =
+    { XMM0, XMM1, XMM2, XMM3, XMM4, XMM5, XMM6, XMM7 };
+
+static constexpr size_t kParameterFloatRegistersLength = arraysize(kParameterFloatRegisters);
+
 class InvokeDexCallingConvention : public CallingConvention<Register> {
  public:
   InvokeDexCallingConvention()
       : CallingConvention(kParameterCoreRegisters, kParameterCoreRegistersLength) {}
 
+  // Float and double arguments are passed in their own registers, in order.
+  size_t GetNumberOfFpuRegisters() const { return kParameterFloatRegistersLength; }
+  FloatRegister GetFpuRegisterAt(size_t index) const {
+    DCHECK_LT(index, GetNumberOfFpuRegisters());
+    return kParameterFloatRegisters[index];
+  }
+
  private:
   DISALLOW_COPY_AND_ASSIGN(InvokeDexCallingConvention);
 };
@@ -92,6 +104,8 @@ class LocationsBuilderX86_64 : public HGraphVisitor {
 #undef DECLARE_VISIT_INSTRUCTION
 
  private:
+  void HandleInvoke(HInvoke* invoke);
+
   CodeGeneratorX86_64* const codegen_;
   InvokeDexCallingConventionVisitor parameter_visitor_;
 
@@ -114,9 +128,25 @@ class InstructionCodeGeneratorX86_64 : public HGraphVisitor {
   X86_64Assembler* GetAssembler() const { return assembler_; }
 
  private:
+  // Float and double values are kept in core registers. These move them to and from
+  // the XMM registers they are operated on.
+  void MoveToFpuRegister(XmmRegister dst, Location src, bool is64bit);
+  void MoveFromFpuRegister(Location dst, XmmRegister src, bool is64bit);
+
+  // The floating-point arguments of a call are moved to their stack slots like the others.
+  // This loads the ones passed in registers, before the call.
+  void LoadFloatingPointArguments(HInvoke* invoke);
+
+  void GenerateFloatingPointToIntegral(HTypeConversion* conversion);
+  void GenerateIntDivOrRem(HBinaryOperation* instruction);
+
   X86_64Assembler* const assembler_;
   CodeGeneratorX86_64* const codegen_;
 
+  // The number of float and double parameters visited, to find the registers they
+  // were passed in.
+  size_t number_of_fp_parameters_;
+
   DISALLOW_COPY_AND_ASSIGN(InstructionCodeGeneratorX86_64);
 };
 
@@ -127,7 +157,7 @@ class CodeGeneratorX86_64 : public CodeGenerator {
 
   virtual void GenerateFrameEntry() OVERRIDE;
   virtual void GenerateFrameExit() OVERRIDE;
-  virtual void Bind(Label* label) OVERRIDE;
+  virtual void Bind(HBasicBlock* block) OVERRIDE;
   virtual void Move(HInstruction* instruction, Location location, HInstruction* move_for) OVERRIDE;
 
   virtual size_t GetWordSize() const OVERRIDE {
@@ -148,7 +178,7 @@ class CodeGeneratorX86_64 : public CodeGenerator {
     return &assembler_;
   }
 
-  ParallelMoveResolverX86_64* GetMoveResolver() {
+  ParallelMoveResolverX86_64* GetMoveResolver() OVERRIDE {
     return &move_resolver_;
   }
 
@@ -47,7 +47,7 @@ class InternalCodeAllocator : public CodeAllocator {
   DISALLOW_COPY_AND_ASSIGN(InternalCodeAllocator);
 };
 
-#if defined(__i386__) || defined(__arm__) || defined(__x86_64__)
+#if defined(__i386__) || defined(__arm__) || defined(__x86_64__) || defined(__aarch64__)
 static void Run(const InternalCodeAllocator& allocator,
                 const CodeGenerator& codegen,
                 bool has_result,
@@ -94,6 +94,12 @@ static void TestCode(const uint16_t* data, bool has_result = false, int32_t expe
 #if defined(__x86_64__)
   Run(allocator, *codegen, has_result, expected);
 #endif
+
+  codegen = CodeGenerator::Create(&arena, graph, kArm64);
+  codegen->CompileBaseline(&allocator, true);
+#if defined(__aarch64__)
+  Run(allocator, *codegen, has_result, expected);
+#endif
 }
 
 TEST(CodegenTest, ReturnVoid) {
@@ -254,4 +260,218 @@ TEST(CodegenTest, ReturnAdd4) {
   TestCode(data, true, 7);
 }
 
+TEST(CodegenTest, ReturnMulInt) {
+  const uint16_t data[] = ONE_REGISTER_CODE_ITEM(
+    Instruction::CONST_4 | 3 << 12 | 0 << 8,
+    Instruction::MUL_INT_LIT8, 5 << 8 | 0,
+    Instruction::RETURN);
+
+  TestCode(data, true, 15);
+}
+
+TEST(CodegenTest, ReturnNegLong) {
+  const uint16_t data[] = TWO_REGISTERS_CODE_ITEM(
+    Instruction::CONST_WIDE_16 | 0 << 8, 5,
+    Instruction::NEG_LONG | 0 << 8 | 0 << 12,
+    Instruction::LONG_TO_INT | 0 << 8 | 0 << 12,
+    Instruction::RETURN | 0 << 8);
+
+  TestCode(data, true, -5);
+}
+
+TEST(CodegenTest, ReturnIntToByteAndChar) {
+  const uint16_t data1[] = ONE_REGISTER_CODE_ITEM(
+    Instruction::CONST_16 | 0 << 8, 0x1FF,
+    Instruction::INT_TO_BYTE | 0 << 8 | 0 << 12,
+    Instruction::RETURN | 0 << 8);
+
+  TestCode(data1, true, -1);
+
+  const uint16_t data2[] = ONE_REGISTER_CODE_ITEM(
+    Instruction::CONST_4 | 0xF << 12 | 0 << 8,
+    Instruction::INT_TO_CHAR | 0 << 8 | 0 << 12,
+    Instruction::RETURN | 0 << 8);
+
+  TestCode(data2, true, 0xFFFF);
+}
+
+TEST(CodegenTest, ReturnAddFloat) {
+  // 2.5f + 2.5f
+  const uint16_t data[] = ONE_REGISTER_CODE_ITEM(
+    Instruction::CONST_HIGH16 | 0 << 8, 0x4020,
+    Instruction::ADD_FLOAT, 0 << 8 | 0,
+    Instruction::FLOAT_TO_INT | 0 << 8 | 0 << 12,
+    Instruction::RETURN | 0 << 8);
+
+  TestCode(data, true, 5);
+}
+
+TEST(CodegenTest, ReturnMulDouble) {
+  // 2.5 * 2.5
+  const uint16_t data[] = TWO_REGISTERS_CODE_ITEM(
+    Instruction::CONST_WIDE_HIGH16 | 0 << 8, 0x4004,
+    Instruction::MUL_DOUBLE_2ADDR | 0 << 8 | 0 << 12,
+    Instruction::DOUBLE_TO_INT | 0 << 8 | 0 << 12,
+    Instruction::RETURN | 0 << 8);
+
+  TestCode(data, true, 6);
+}
+
+TEST(CodegenTest, ReturnDivAndNegFloat) {
+  // -(7 / 2.0f)
+  const uint16_t data[] = TWO_REGISTERS_CODE_ITEM(
+    Instruction::CONST_4 | 7 << 12 | 0 << 8,
+    Instruction::INT_TO_FLOAT | 0 << 8 | 0 << 12,
+    Instruction::CONST_HIGH16 | 1 << 8, 0x4000,
+    Instruction::DIV_FLOAT_2ADDR | 0 << 8 | 1 << 12,
+    Instruction::NEG_FLOAT | 0 << 8 | 0 << 12,
+    Instruction::FLOAT_TO_INT | 0 << 8 | 0 << 12,
+    Instruction::RETURN | 0 << 8);
+
+  TestCode(data, true, -3);
+}
+
+// ARM divides in the runtime, which these tests do not set up.
+#if !defined(__arm__)
+TEST(CodegenTest, ReturnDivAndRemInt) {
+  // 7 / 2
+  const uint16_t data1[] = ONE_REGISTER_CODE_ITEM(
+    Instruction::CONST_4 | 7 << 12 | 0 << 8,
+    Instruction::DIV_INT_LIT8, 2 << 8 | 0,
+    Instruction::RETURN | 0 << 8);
+
+  TestCode(data1, true, 3);
+
+  // -7 % 2
+  const uint16_t data2[] = TWO_REGISTERS_CODE_ITEM(
+    Instruction::CONST_4 | 0x9 << 12 | 0 << 8,
+    Instruction::CONST_4 | 2 << 12 | 1 << 8,
+    Instruction::REM_INT | 0 << 8, 1 << 8 | 0,
+    Instruction::RETURN | 0 << 8);
+
+  TestCode(data2, true, -1);
+
+  // The minimum int divided by -1 is itself, and the remainder is zero.
+  const uint16_t data3[] = TWO_REGISTERS_CODE_ITEM(
+    Instruction::CONST_HIGH16 | 0 << 8, 0x8000,
+    Instruction::CONST_4 | 0xF << 12 | 1 << 8,
+    Instruction::DIV_INT_2ADDR | 0 << 8 | 1 << 12,
+    Instruction::RETURN | 0 << 8);
+
+  TestCode(data3, true, std::numeric_limits<int32_t>::min());
+
+  const uint16_t data4[] = TWO_REGISTERS_CODE_ITEM(
+    Instruction::CONST_HIGH16 | 0 << 8, 0x8000,
+    Instruction::CONST_4 | 0xF << 12 | 1 << 8,
+    Instruction::REM_INT_2ADDR | 0 << 8 | 1 << 12,
+    Instruction::RETURN | 0 << 8);
+
+  TestCode(data4, true, 0);
+}
+#endif
+
+TEST(CodegenTest, ReturnFloatToIntSpecialValues) {
+  // NaN converts to zero.
+  const uint16_t data1[] = ONE_REGISTER_CODE_ITEM(
+    Instruction::CONST_HIGH16 | 0 << 8, 0x7FC0,
+    Instruction::FLOAT_TO_INT | 0 << 8 | 0 << 12,
+    Instruction::RETURN | 0 << 8);
+
+  TestCode(data1, true, 0);
+
+  // 2^32 saturates to the maximum int.
+  const uint16_t data2[] = ONE_REGISTER_CODE_ITEM(
+    Instruction::CONST_HIGH16 | 0 << 8, 0x4F80,
+    Instruction::FLOAT_TO_INT | 0 << 8 | 0 << 12,
+    Instruction::RETURN | 0 << 8);
+
+  TestCode(data2, true, std::numeric_limits<int32_t>::max());
+
+  // -2^32 saturates to the minimum int.
+  const uint16_t data3[] = ONE_REGISTER_CODE_ITEM(
+    Instruction::CONST_HIGH16 | 0 << 8, 0xCF80,
+    Instruction::FLOAT_TO_INT | 0 << 8 | 0 << 12,
+    Instruction::RETURN | 0 << 8);
+
+  TestCode(data3, true, std::numeric_limits<int32_t>::min());
+}
+
+TEST(CodegenTest, ReturnCompareFloatWithNaN) {
+  // cmpl-float and cmpg-float of NaN and 0.0f.
+  const uint16_t data1[] = TWO_REGISTERS_CODE_ITEM(
+    Instruction::CONST_HIGH16 | 0 << 8, 0x7FC0,
+    Instruction::CONST_4 | 0 << 12 | 1 << 8,
+    Instruction::CMPL_FLOAT | 0 << 8, 1 << 8 | 0,
+    Instruction::RETURN | 0 << 8);
+
+  TestCode(data1, true, -1);
+
+  const uint16_t data2[] = TWO_REGISTERS_CODE_ITEM(
+    Instruction::CONST_HIGH16 | 0 << 8, 0x7FC0,
+    Instruction::CONST_4 | 0 << 12 | 1 << 8,
+    Instruction::CMPG_FLOAT | 0 << 8, 1 << 8 | 0,
+    Instruction::RETURN | 0 << 8);
+
+  TestCode(data2, true, 1);
+}
+
+TEST(CodegenTest, ReturnCompareDouble) {
+  // cmpl-double of 2.0 and 2.5.
+  const uint16_t data[] = FOUR_REGISTERS_CODE_ITEM(
+    Instruction::CONST_WIDE_HIGH16 | 0 << 8, 0x4000,
+    Instruction::CONST_WIDE_HIGH16 | 2 << 8, 0x4004,
+    Instruction::CMPL_DOUBLE | 0 << 8, 2 << 8 | 0,
+    Instruction::RETURN | 0 << 8);
+
+  TestCode(data, true, -1);
+}
+
+TEST(CodegenTest, PackedSwitch) {
+  const uint16_t data[] = ONE_REGISTER_CODE_ITEM(
+    Instruction::CONST_4 | 0 << 8 | 1 << 12,
+    Instruction::PACKED_SWITCH | 0 << 8, 9, 0,
+    Instruction::CONST_4 | 0 << 8 | 0 << 12,
+    Instruction::RETURN | 0 << 8,
+    Instruction::CONST_4 | 0 << 8 | 5 << 12,
+    Instruction::RETURN | 0 << 8,
+    Instruction::CONST_4 | 0 << 8 | 7 << 12,
+    Instruction::RETURN | 0 << 8,
+    // Payload: two cases with keys 0 and 1.
+    Instruction::kPackedSwitchSignature, 2, 0, 0, 5, 0, 7, 0);
+
+  TestCode(data, true, 7);
+}
+
+TEST(CodegenTest, SparseSwitch) {
+  const uint16_t data[] = ONE_REGISTER_CODE_ITEM(
+    Instruction::CONST_4 | 0 << 8 | 0xD << 12,
+    Instruction::SPARSE_SWITCH | 0 << 8, 9, 0,
+    Instruction::CONST_4 | 0 << 8 | 0 << 12,
+    Instruction::RETURN | 0 << 8,
+    Instruction::CONST_4 | 0 << 8 | 5 << 12,
+    Instruction::RETURN | 0 << 8,
+    Instruction::CONST_4 | 0 << 8 | 7 << 12,
+    Instruction::RETURN | 0 << 8,
+    // Payload: two cases with keys -3 and 6.
+    Instruction::kSparseSwitchSignature, 2, 0xFFFD, 0xFFFF, 6, 0, 5, 0, 7, 0);
+
+  TestCode(data, true, 5);
+}
+
+TEST(CodegenTest, SwitchDefault) {
+  const uint16_t data[] = ONE_REGISTER_CODE_ITEM(
+    Instruction::CONST_4 | 0 << 8 | 4 << 12,
+    Instruction::SPARSE_SWITCH | 0 << 8, 9, 0,
+    Instruction::CONST_4 | 0 << 8 | 0 << 12,
+    Instruction::RETURN | 0 << 8,
+    Instruction::CONST_4 | 0 << 8 | 5 << 12,
+    Instruction::RETURN | 0 << 8,
+    Instruction::CONST_4 | 0 << 8 | 7 << 12,
+    Instruction::RETURN | 0 << 8,
+    // Payload: two cases with keys -3 and 6.
+    Instruction::kSparseSwitchSignature, 2, 0xFFFD, 0xFFFF, 6, 0, 5, 0, 7, 0);
+
+  TestCode(data, true, 0);
+}
+
 }  // namespace art
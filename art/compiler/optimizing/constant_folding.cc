@@ -0,0 +1,44 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "constant_folding.h"
+
+namespace art {
+
+void HConstantFolding::Run() {
+  // Process the blocks in reverse post order, so that the inputs of an instruction are folded
+  // before the instruction, except for phis.
+  HBasicBlock* entry_block = graph_->GetEntryBlock();
+  for (HReversePostOrderIterator it(*graph_); !it.Done(); it.Advance()) {
+    HBasicBlock* block = it.Current();
+    for (HInstructionIterator inst_it(block->GetInstructions()); !inst_it.Done();
+         inst_it.Advance()) {
+      HInstruction* inst = inst_it.Current();
+      if (!inst->IsBinaryOperation()) {
+        continue;
+      }
+      HConstant* constant = inst->AsBinaryOperation()->TryStaticEvaluation(graph_->GetArena());
+      if (constant != nullptr) {
+        // Constants live in the entry block, which dominates all their uses.
+        entry_block->InsertInstructionBefore(constant, entry_block->GetLastInstruction());
+        inst->ReplaceWith(constant);
+        block->RemoveInstruction(inst);
+      }
+    }
+  }
+}
+
+}  // namespace art
@@ -0,0 +1,129 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "builder.h"
+#include "constant_folding.h"
+#include "dead_code_elimination.h"
+#include "dex_instruction.h"
+#include "nodes.h"
+#include "optimizing_unit_test.h"
+#include "utils/arena_allocator.h"
+
+#include "gtest/gtest.h"
+
+namespace art {
+
+static HGraph* BuildSsaGraph(ArenaAllocator* allocator, const uint16_t* data) {
+  HGraphBuilder builder(allocator);
+  const DexFile::CodeItem* item = reinterpret_cast<const DexFile::CodeItem*>(data);
+  HGraph* graph = builder.BuildGraph(*item);
+  graph->BuildDominatorTree();
+  graph->TransformToSSA();
+  return graph;
+}
+
+static size_t CountInstructions(HGraph* graph, HInstruction::InstructionKind kind) {
+  size_t count = 0;
+  for (HReversePostOrderIterator it(*graph); !it.Done(); it.Advance()) {
+    for (HInstructionIterator inst_it(it.Current()->GetInstructions()); !inst_it.Done();
+         inst_it.Advance()) {
+      if (inst_it.Current()->GetKind() == kind) {
+        ++count;
+      }
+    }
+  }
+  return count;
+}
+
+static HInstruction* FindFirst(HGraph* graph, HInstruction::InstructionKind kind) {
+  for (HReversePostOrderIterator it(*graph); !it.Done(); it.Advance()) {
+    for (HInstructionIterator inst_it(it.Current()->GetInstructions()); !inst_it.Done();
+         inst_it.Advance()) {
+      if (inst_it.Current()->GetKind() == kind) {
+        return inst_it.Current();
+      }
+    }
+  }
+  return nullptr;
+}
+
+TEST(ConstantFoldingTest, IntAddition) {
+  // v0 = 1 + 2; return v0
+  const uint16_t data[] = THREE_REGISTERS_CODE_ITEM(
+    Instruction::CONST_4 | 0 << 8 | 1 << 12,
+    Instruction::CONST_4 | 1 << 8 | 2 << 12,
+    Instruction::ADD_INT | 2 << 8, 0 | 1 << 8,
+    Instruction::RETURN | 2 << 8);
+
+  ArenaPool pool;
+  ArenaAllocator allocator(&pool);
+  HGraph* graph = BuildSsaGraph(&allocator, data);
+  ASSERT_EQ(1u, CountInstructions(graph, HInstruction::kAdd));
+
+  HConstantFolding(graph).Run();
+  EXPECT_EQ(0u, CountInstructions(graph, HInstruction::kAdd));
+  HInstruction* ret = FindFirst(graph, HInstruction::kReturn);
+  ASSERT_NE(ret, nullptr);
+  ASSERT_TRUE(ret->InputAt(0)->IsIntConstant());
+  EXPECT_EQ(3, ret->InputAt(0)->AsIntConstant()->GetValue());
+  // The folded constant lives in the entry block.
+  EXPECT_EQ(graph->GetEntryBlock(), ret->InputAt(0)->GetBlock());
+}
+
+TEST(ConstantFoldingTest, Condition) {
+  // if (1 != 2) return; else return;
+  const uint16_t data[] = TWO_REGISTERS_CODE_ITEM(
+    Instruction::CONST_4 | 0 << 8 | 1 << 12,
+    Instruction::CONST_4 | 1 << 8 | 2 << 12,
+    Instruction::IF_NE | 0 << 8 | 1 << 12, 3,
+    Instruction::RETURN_VOID,
+    Instruction::RETURN_VOID);
+
+  ArenaPool pool;
+  ArenaAllocator allocator(&pool);
+  HGraph* graph = BuildSsaGraph(&allocator, data);
+  ASSERT_EQ(1u, CountInstructions(graph, HInstruction::kNotEqual));
+
+  HConstantFolding(graph).Run();
+  EXPECT_EQ(0u, CountInstructions(graph, HInstruction::kNotEqual));
+  HInstruction* if_instr = FindFirst(graph, HInstruction::kIf);
+  ASSERT_NE(if_instr, nullptr);
+  ASSERT_TRUE(if_instr->InputAt(0)->IsIntConstant());
+  EXPECT_EQ(1, if_instr->InputAt(0)->AsIntConstant()->GetValue());
+}
+
+TEST(DeadCodeEliminationTest, UnusedAddition) {
+  // v2 = v0 + v1; return-void
+  const uint16_t data[] = THREE_REGISTERS_CODE_ITEM(
+    Instruction::CONST_4 | 0 << 8 | 1 << 12,
+    Instruction::CONST_4 | 1 << 8 | 2 << 12,
+    Instruction::ADD_INT | 2 << 8, 0 | 1 << 8,
+    Instruction::RETURN_VOID);
+
+  ArenaPool pool;
+  ArenaAllocator allocator(&pool);
+  HGraph* graph = BuildSsaGraph(&allocator, data);
+  ASSERT_EQ(1u, CountInstructions(graph, HInstruction::kAdd));
+
+  HDeadCodeElimination(graph).Run();
+  EXPECT_EQ(0u, CountInstructions(graph, HInstruction::kAdd));
+  // The constants it used are dead too.
+  EXPECT_EQ(0u, CountInstructions(graph, HInstruction::kIntConstant));
+  // Control flow stays.
+  EXPECT_EQ(1u, CountInstructions(graph, HInstruction::kReturnVoid));
+}
+
+}  // namespace art
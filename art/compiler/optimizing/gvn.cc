@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "gvn.h"
+
+namespace art {
+
+void ValueSet::KillMemoryDependencies() {
+  for (size_t i = 0; i < kNumberOfBuckets; ++i) {
+    ValueSetNode* previous = nullptr;
+    for (ValueSetNode* node = table_[i]; node != nullptr; node = node->GetNext()) {
+      if (node->GetInstruction()->GetSideEffects().HasDependencies()) {
+        if (previous == nullptr) {
+          table_[i] = node->GetNext();
+        } else {
+          previous->SetNext(node->GetNext());
+        }
+      } else {
+        previous = node;
+      }
+    }
+  }
+}
+
+ValueSet* ValueSet::Copy() const {
+  ValueSet* copy = new (allocator_) ValueSet(allocator_);
+  for (size_t i = 0; i < kNumberOfBuckets; ++i) {
+    for (ValueSetNode* node = table_[i]; node != nullptr; node = node->GetNext()) {
+      copy->table_[i] = new (allocator_) ValueSetNode(
+          node->GetInstruction(), node->GetHashCode(), copy->table_[i]);
+    }
+  }
+  return copy;
+}
+
+void GVNOptimization::Run() {
+  // A block is visited after its dominator, whose set it starts from.
+  sets_.SetSize(graph_->GetBlocks().Size());
+  for (HReversePostOrderIterator it(*graph_); !it.Done(); it.Advance()) {
+    VisitBasicBlock(it.Current());
+  }
+}
+
+void GVNOptimization::VisitBasicBlock(HBasicBlock* block) {
+  ValueSet* set;
+  HBasicBlock* dominator = block->GetDominator();
+  if (dominator == nullptr) {
+    set = new (graph_->GetArena()) ValueSet(graph_->GetArena());
+  } else {
+    set = sets_.Get(dominator->GetBlockId())->Copy();
+    const GrowableArray<HBasicBlock*>& predecessors = block->GetPredecessors();
+    if (predecessors.Size() != 1 || predecessors.Get(0) != dominator) {
+      // Other paths from the dominator may write to the heap, like the back edges of a loop.
+      set->KillMemoryDependencies();
+    }
+  }
+  sets_.Put(block->GetBlockId(), set);
+
+  HInstruction* current = block->GetFirstInstruction();
+  while (current != nullptr) {
+    HInstruction* next = current->GetNext();
+    if (current->GetSideEffects().HasSideEffects()) {
+      set->KillMemoryDependencies();
+    }
+    if (current->CanBeMoved()) {
+      HInstruction* existing = set->Lookup(current);
+      if (existing != nullptr) {
+        current->ReplaceWith(existing);
+        block->RemoveInstruction(current);
+      } else {
+        set->Add(current);
+      }
+    }
+    current = next;
+  }
+}
+
+}  // namespace art
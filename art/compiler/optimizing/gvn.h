@@ -0,0 +1,123 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_COMPILER_OPTIMIZING_GVN_H_
+#define ART_COMPILER_OPTIMIZING_GVN_H_
+
+#include "optimization.h"
+
+namespace art {
+
+/**
+ * A node in the collision list of a ValueSet. Encodes the instruction and its hash code.
+ */
+class ValueSetNode : public ArenaObject {
+ public:
+  ValueSetNode(HInstruction* instruction, size_t hash_code, ValueSetNode* next)
+      : instruction_(instruction), hash_code_(hash_code), next_(next) {}
+
+  size_t GetHashCode() const { return hash_code_; }
+  HInstruction* GetInstruction() const { return instruction_; }
+  ValueSetNode* GetNext() const { return next_; }
+  void SetNext(ValueSetNode* node) { next_ = node; }
+
+ private:
+  HInstruction* const instruction_;
+  const size_t hash_code_;
+  ValueSetNode* next_;
+
+  DISALLOW_COPY_AND_ASSIGN(ValueSetNode);
+};
+
+/**
+ * A ValueSet holds the instructions available at a point of the graph, hashed by
+ * HInstruction::ComputeHashCode. It is a fixed size table with collision lists.
+ */
+class ValueSet : public ArenaObject {
+ public:
+  explicit ValueSet(ArenaAllocator* allocator) : allocator_(allocator) {
+    for (size_t i = 0; i < kNumberOfBuckets; ++i) {
+      table_[i] = nullptr;
+    }
+  }
+
+  // Adds an instruction to the set.
+  void Add(HInstruction* instruction) {
+    DCHECK(Lookup(instruction) == nullptr);
+    size_t hash_code = instruction->ComputeHashCode();
+    size_t index = hash_code % kNumberOfBuckets;
+    table_[index] = new (allocator_) ValueSetNode(instruction, hash_code, table_[index]);
+  }
+
+  // Returns an instruction of the set equal to `instruction`, or nullptr.
+  HInstruction* Lookup(HInstruction* instruction) const {
+    size_t hash_code = instruction->ComputeHashCode();
+    for (ValueSetNode* node = table_[hash_code % kNumberOfBuckets];
+         node != nullptr;
+         node = node->GetNext()) {
+      if (node->GetHashCode() == hash_code && node->GetInstruction()->Equals(instruction)) {
+        return node->GetInstruction();
+      }
+    }
+    return nullptr;
+  }
+
+  // Removes the instructions whose result depends on the heap.
+  void KillMemoryDependencies();
+
+  // Returns a copy of this set, to be updated independently.
+  ValueSet* Copy() const;
+
+ private:
+  static constexpr size_t kNumberOfBuckets = 8;
+
+  ArenaAllocator* const allocator_;
+  ValueSetNode* table_[kNumberOfBuckets];
+
+  DISALLOW_COPY_AND_ASSIGN(ValueSet);
+};
+
+/**
+ * Optimization pass doing global value numbering. An instruction which can be moved is
+ * replaced by an equal instruction dominating it.
+ *
+ * The blocks are visited in reverse post order. A block starts from the values available
+ * at the end of its dominator. The values depending on the heap only stay available if
+ * the dominator is the only predecessor of the block, as otherwise a write on another path
+ * could change them; within a block they are killed by the instructions writing the heap.
+ */
+class GVNOptimization : public HOptimization {
+ public:
+  explicit GVNOptimization(HGraph* graph)
+      : HOptimization(graph, kGlobalValueNumberingPassName),
+        sets_(graph->GetArena(), graph->GetBlocks().Size()) {}
+
+  virtual void Run() OVERRIDE;
+
+  static constexpr const char* kGlobalValueNumberingPassName = "GVN";
+
+ private:
+  void VisitBasicBlock(HBasicBlock* block);
+
+  // The value set at the end of each block, indexed by block id.
+  GrowableArray<ValueSet*> sets_;
+
+  DISALLOW_COPY_AND_ASSIGN(GVNOptimization);
+};
+
+}  // namespace art
+
+#endif  // ART_COMPILER_OPTIMIZING_GVN_H_
@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "builder.h"
+#include "dex_instruction.h"
+#include "gvn.h"
+#include "nodes.h"
+#include "optimizing_unit_test.h"
+#include "utils/arena_allocator.h"
+
+#include "gtest/gtest.h"
+
+namespace art {
+
+static HGraph* BuildSsaGraph(ArenaAllocator* allocator, const uint16_t* data) {
+  HGraphBuilder builder(allocator);
+  const DexFile::CodeItem* item = reinterpret_cast<const DexFile::CodeItem*>(data);
+  HGraph* graph = builder.BuildGraph(*item);
+  graph->BuildDominatorTree();
+  graph->TransformToSSA();
+  return graph;
+}
+
+static HInstruction* FindReturn(HGraph* graph) {
+  for (HReversePostOrderIterator it(*graph); !it.Done(); it.Advance()) {
+    HInstruction* last = it.Current()->GetLastInstruction();
+    if (last->IsReturn()) {
+      return last;
+    }
+  }
+  return nullptr;
+}
+
+TEST(GVNTest, SameAdditions) {
+  // v2 = v0 + v1; v0 = v0 + v1; v0 = v0 + v2; return v0
+  const uint16_t data[] = THREE_REGISTERS_CODE_ITEM(
+    Instruction::CONST_4 | 0 << 8 | 3 << 12,
+    Instruction::CONST_4 | 1 << 8 | 4 << 12,
+    Instruction::ADD_INT | 2 << 8, 0 | 1 << 8,
+    Instruction::ADD_INT | 0 << 8, 0 | 1 << 8,
+    Instruction::ADD_INT | 0 << 8, 0 | 2 << 8,
+    Instruction::RETURN | 0 << 8);
+
+  ArenaPool pool;
+  ArenaAllocator allocator(&pool);
+  HGraph* graph = BuildSsaGraph(&allocator, data);
+  HInstruction* ret = FindReturn(graph);
+  ASSERT_NE(ret, nullptr);
+  HInstruction* sum = ret->InputAt(0);
+  ASSERT_TRUE(sum->IsAdd());
+  EXPECT_NE(sum->InputAt(0), sum->InputAt(1));
+
+  GVNOptimization(graph).Run();
+  ASSERT_EQ(sum, ret->InputAt(0));
+  EXPECT_EQ(sum->InputAt(0), sum->InputAt(1));
+  EXPECT_TRUE(sum->InputAt(0)->IsAdd());
+}
+
+TEST(GVNTest, SameConstants) {
+  // v0 = 5; v1 = 5; v0 = v0 - v1; return v0
+  const uint16_t data[] = TWO_REGISTERS_CODE_ITEM(
+    Instruction::CONST_16 | 0 << 8, 5,
+    Instruction::CONST_16 | 1 << 8, 5,
+    Instruction::SUB_INT | 0 << 8, 0 | 1 << 8,
+    Instruction::RETURN | 0 << 8);
+
+  ArenaPool pool;
+  ArenaAllocator allocator(&pool);
+  HGraph* graph = BuildSsaGraph(&allocator, data);
+  HInstruction* difference = FindReturn(graph)->InputAt(0);
+  ASSERT_TRUE(difference->IsSub());
+  EXPECT_NE(difference->InputAt(0), difference->InputAt(1));
+
+  GVNOptimization(graph).Run();
+  EXPECT_EQ(difference->InputAt(0), difference->InputAt(1));
+}
+
+}  // namespace art
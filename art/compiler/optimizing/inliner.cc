@@ -0,0 +1,248 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "inliner.h"
+
+#include "builder.h"
+#include "class_linker.h"
+#include "dex_instruction-inl.h"
+#include "driver/compiler_driver-inl.h"
+#include "driver/compiler_options.h"
+#include "driver/dex_compilation_unit.h"
+#include "handle_scope-inl.h"
+#include "mirror/art_method-inl.h"
+#include "mirror/class-inl.h"
+#include "mirror/class_loader.h"
+#include "mirror/dex_cache.h"
+#include "nodes.h"
+#include "register_allocator.h"
+#include "scoped_thread_state_change.h"
+#include "thread.h"
+#include "utils.h"
+
+namespace art {
+
+bool HInliner::OnlyInvokesNeedEnvironment(const HGraph& graph) {
+  bool has_invokes = false;
+  for (size_t i = 0, e = graph.GetBlocks().Size(); i < e; ++i) {
+    for (HInstructionIterator it(graph.GetBlocks().Get(i)->GetInstructions());
+         !it.Done();
+         it.Advance()) {
+      HInstruction* current = it.Current();
+      if (current->IsInvokeStatic()) {
+        has_invokes = true;
+      } else if (current->NeedsEnvironment()
+                 && !RegisterAllocator::SupportsEnvironmentOf(current)) {
+        return false;
+      }
+    }
+  }
+  return has_invokes;
+}
+
+HInstruction* HInliner::CopyCheckForInvoke(HInstruction* check, HInvoke* invoke) {
+  ArenaAllocator* arena = graph_->GetArena();
+  HInstruction* copy;
+  if (check->IsNullCheck()) {
+    copy = new (arena) HNullCheck(check->InputAt(0), invoke->GetDexPc());
+  } else if (check->IsDivZeroCheck()) {
+    copy = new (arena) HDivZeroCheck(check->InputAt(0), invoke->GetDexPc());
+  } else {
+    DCHECK(check->IsBoundsCheck());
+    copy = new (arena) HBoundsCheck(check->InputAt(0), check->InputAt(1), invoke->GetDexPc());
+  }
+  for (size_t i = 0, e = copy->InputCount(); i < e; ++i) {
+    copy->InputAt(i)->AddUseAt(copy, i);
+  }
+  GrowableArray<HInstruction*>* invoke_vregs = invoke->GetEnvironment()->GetVRegs();
+  HEnvironment* environment = new (arena) HEnvironment(arena, invoke_vregs->Size());
+  environment->Populate(*invoke_vregs);
+  copy->SetEnvironment(environment);
+  return copy;
+}
+
+void HInliner::Run() {
+  for (HReversePostOrderIterator it(*graph_); !it.Done(); it.Advance()) {
+    for (HInstructionIterator instr_it(it.Current()->GetInstructions());
+         !instr_it.Done();
+         instr_it.Advance()) {
+      HInvokeStatic* invoke = instr_it.Current()->AsInvokeStatic();
+      if (invoke != nullptr) {
+        TryInline(invoke);
+      }
+    }
+  }
+}
+
+bool HInliner::TryInline(HInvokeStatic* invoke) {
+  const DexFile& dex_file = *outer_compilation_unit_.GetDexFile();
+  const uint32_t method_index = invoke->GetIndexInDexCache();
+
+  // The builder creates an HInvokeStatic for direct calls too: look at the dex instruction.
+  const Instruction* instruction =
+      Instruction::At(outer_compilation_unit_.GetCodeItem()->insns_ + invoke->GetDexPc());
+  const bool is_static = instruction->Opcode() == Instruction::INVOKE_STATIC
+      || instruction->Opcode() == Instruction::INVOKE_STATIC_RANGE;
+
+  const DexFile::CodeItem* code_item;
+  uint32_t callee_method_index;
+  uint16_t callee_class_def_index;
+  uint32_t callee_access_flags;
+  {
+    ScopedObjectAccess soa(Thread::Current());
+    StackHandleScope<4> hs(soa.Self());
+    Handle<mirror::DexCache> dex_cache(hs.NewHandle(
+        compiler_driver_->GetDexCache(&outer_compilation_unit_)));
+    Handle<mirror::ClassLoader> class_loader(hs.NewHandle(
+        compiler_driver_->GetClassLoader(soa, &outer_compilation_unit_)));
+    Handle<mirror::ArtMethod> resolved_method(hs.NewHandle(compiler_driver_->ResolveMethod(
+        soa, dex_cache, class_loader, &outer_compilation_unit_, method_index,
+        is_static ? kStatic : kDirect)));
+    if (resolved_method.Get() == nullptr) {
+      VLOG(compiler) << "Method cannot be resolved " << PrettyMethod(method_index, dex_file);
+      return false;
+    }
+    Handle<mirror::Class> referrer_class(hs.NewHandle(
+        compiler_driver_->ResolveCompilingMethodsClass(
+            soa, dex_cache, class_loader, &outer_compilation_unit_)));
+    mirror::Class* declaring_class = resolved_method->GetDeclaringClass();
+
+    // The code of the callee indexes the dex cache of its own dex file, which the code
+    // generated for the caller does not load.
+    if (resolved_method->GetDexFile() != &dex_file) {
+      VLOG(compiler) << "Method " << PrettyMethod(method_index, dex_file)
+                     << " is not in the dex file of the caller";
+      return false;
+    }
+
+    if (referrer_class.Get() == nullptr
+        || !referrer_class->CanAccessResolvedMethod(
+            declaring_class, resolved_method.Get(), dex_cache.Get(), method_index)) {
+      VLOG(compiler) << "Method " << PrettyMethod(method_index, dex_file)
+                     << " is not accessible from the caller";
+      return false;
+    }
+
+    if (!declaring_class->IsVerified()) {
+      VLOG(compiler) << "Method " << PrettyMethod(method_index, dex_file)
+                     << " is in an unverified class";
+      return false;
+    }
+
+    // Calling a static method initializes its class, which the inlined code would not do.
+    if (is_static && declaring_class != referrer_class.Get() && !declaring_class->IsInitialized()) {
+      VLOG(compiler) << "Method " << PrettyMethod(method_index, dex_file)
+                     << " is in a class that may not be initialized";
+      return false;
+    }
+
+    if (resolved_method->IsSynchronized()) {
+      VLOG(compiler) << "Method " << PrettyMethod(method_index, dex_file) << " is synchronized";
+      return false;
+    }
+
+    code_item = resolved_method->GetCodeItem();
+    if (code_item == nullptr) {
+      VLOG(compiler) << "Method " << PrettyMethod(method_index, dex_file)
+                     << " is native or abstract";
+      return false;
+    }
+
+    callee_method_index = resolved_method->GetDexMethodIndex();
+    callee_class_def_index = declaring_class->GetDexClassDefIndex();
+    callee_access_flags = resolved_method->GetAccessFlags();
+  }
+
+  const CompilerOptions& compiler_options = compiler_driver_->GetCompilerOptions();
+  const size_t code_units = code_item->insns_size_in_code_units_;
+  if (code_units > compiler_options.GetInlineMaxCodeUnits()) {
+    VLOG(compiler) << "Method " << PrettyMethod(method_index, dex_file) << " is too big to inline";
+    return false;
+  }
+  if (inlined_code_units_ + code_units > compiler_options.GetInlineMaxTotalCodeUnits()) {
+    VLOG(compiler) << "Method " << PrettyMethod(method_index, dex_file)
+                   << " exceeds the inlining budget of the caller";
+    return false;
+  }
+
+  DexCompilationUnit dex_compilation_unit(
+      nullptr, outer_compilation_unit_.GetClassLoader(), outer_compilation_unit_.GetClassLinker(),
+      dex_file, code_item, callee_class_def_index, callee_method_index, callee_access_flags,
+      compiler_driver_->GetVerifiedMethod(&dex_file, callee_method_index));
+
+  HGraphBuilder builder(graph_->GetArena(), &dex_compilation_unit, &dex_file, compiler_driver_);
+  HGraph* callee_graph = builder.BuildGraph(*code_item);
+  if (callee_graph == nullptr) {
+    VLOG(compiler) << "Method " << PrettyMethod(method_index, dex_file)
+                   << " could not be built";
+    return false;
+  }
+
+  // Only inline straight-line code: an entry block, a body and an exit block.
+  if (callee_graph->GetBlocks().Size() != 3) {
+    VLOG(compiler) << "Method " << PrettyMethod(method_index, dex_file) << " has branches";
+    return false;
+  }
+
+  callee_graph->BuildDominatorTree();
+  callee_graph->TransformToSSA();
+
+  HInstruction* receiver = nullptr;
+  if (!is_static) {
+    for (HInstructionIterator it(callee_graph->GetEntryBlock()->GetInstructions());
+         !it.Done();
+         it.Advance()) {
+      HParameterValue* parameter = it.Current()->AsParameterValue();
+      if (parameter != nullptr && parameter->GetIndex() == 0) {
+        receiver = parameter;
+        break;
+      }
+    }
+  }
+
+  HBasicBlock* body = callee_graph->GetBlocks().Get(1);
+  for (HInstructionIterator it(body->GetInstructions()); !it.Done(); it.Advance()) {
+    HInstruction* current = it.Current();
+    if (!current->NeedsEnvironment()) {
+      continue;
+    }
+    if (current->IsNullCheck() && current->InputAt(0) == receiver) {
+      // The caller checked the receiver before the call.
+      current->ReplaceWith(receiver);
+      body->RemoveInstruction(current);
+    } else if (RegisterAllocator::SupportsEnvironmentOf(current)) {
+      // The check throws in the caller, as if it was thrown by the invoke.
+      HInstruction* check = CopyCheckForInvoke(current, invoke);
+      body->InsertInstructionBefore(check, current);
+      current->ReplaceWith(check);
+      body->RemoveInstruction(current);
+    } else {
+      VLOG(compiler) << "Method " << PrettyMethod(method_index, dex_file)
+                     << " has instructions that need an environment";
+      return false;
+    }
+  }
+
+  callee_graph->InlineInto(graph_, invoke);
+  inlined_code_units_ += code_units;
+  if (compilation_stats_ != nullptr) {
+    compilation_stats_->RecordStat(MethodCompilationStat::kInlinedInvoke);
+  }
+  VLOG(compiler) << "Successfully inlined " << PrettyMethod(callee_method_index, dex_file);
+  return true;
+}
+
+}  // namespace art
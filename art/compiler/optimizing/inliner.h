@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_COMPILER_OPTIMIZING_INLINER_H_
+#define ART_COMPILER_OPTIMIZING_INLINER_H_
+
+#include "optimization.h"
+#include "optimizing_compiler_stats.h"
+
+namespace art {
+
+class CompilerDriver;
+class DexCompilationUnit;
+
+/**
+ * Optimization pass replacing the static and direct calls to small methods of the same
+ * dex file with the graphs of these methods. A callee is inlined if its graph is a single
+ * block whose only instructions needing an environment are null and bounds checks, and if
+ * it fits in the budgets of the compiler options.
+ */
+class HInliner : public HOptimization {
+ public:
+  HInliner(HGraph* outer_graph,
+           const DexCompilationUnit& outer_compilation_unit,
+           CompilerDriver* compiler_driver,
+           OptimizingCompilerStats* compilation_stats = nullptr)
+      : HOptimization(outer_graph, kInlinerPassName),
+        outer_compilation_unit_(outer_compilation_unit),
+        compiler_driver_(compiler_driver),
+        compilation_stats_(compilation_stats),
+        inlined_code_units_(0) {}
+
+  virtual void Run() OVERRIDE;
+
+  // Returns whether the invokes are the only instructions of `graph` that need an
+  // environment the register allocator does not support. Inlining all of them lets the
+  // method be compiled with the optimizations.
+  static bool OnlyInvokesNeedEnvironment(const HGraph& graph);
+
+  static constexpr const char* kInlinerPassName = "inliner";
+
+ private:
+  bool TryInline(HInvokeStatic* invoke);
+
+  // Returns a copy of `check`, a null or bounds check of the callee of `invoke`, that
+  // throws at the dex pc of `invoke`, with its environment.
+  HInstruction* CopyCheckForInvoke(HInstruction* check, HInvoke* invoke);
+
+  const DexCompilationUnit& outer_compilation_unit_;
+  CompilerDriver* const compiler_driver_;
+  OptimizingCompilerStats* const compilation_stats_;
+
+  // The size of the methods inlined so far, in code units.
+  size_t inlined_code_units_;
+
+  DISALLOW_COPY_AND_ASSIGN(HInliner);
+};
+
+}  // namespace art
+
+#endif  // ART_COMPILER_OPTIMIZING_INLINER_H_
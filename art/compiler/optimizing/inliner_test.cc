@@ -0,0 +1,165 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "builder.h"
+#include "dex_instruction.h"
+#include "nodes.h"
+#include "optimizing_unit_test.h"
+#include "utils/arena_allocator.h"
+
+#include "gtest/gtest.h"
+
+namespace art {
+
+static HBasicBlock* CreateBlock(HGraph* graph, ArenaAllocator* allocator) {
+  HBasicBlock* block = new (allocator) HBasicBlock(graph);
+  graph->AddBlock(block);
+  return block;
+}
+
+/**
+ * Creates a graph whose body calls a method with `arguments`, and returns its result
+ * if `return_type` is not void.
+ */
+static HGraph* CreateCaller(ArenaAllocator* allocator,
+                            HInstruction** arguments,
+                            size_t number_of_arguments,
+                            Primitive::Type return_type,
+                            HInvokeStatic** invoke) {
+  HGraph* graph = new (allocator) HGraph(allocator);
+  HBasicBlock* entry = CreateBlock(graph, allocator);
+  graph->SetEntryBlock(entry);
+  for (size_t i = 0; i < number_of_arguments; i++) {
+    entry->AddInstruction(arguments[i]);
+  }
+  entry->AddInstruction(new (allocator) HGoto());
+
+  HBasicBlock* body = CreateBlock(graph, allocator);
+  entry->AddSuccessor(body);
+  *invoke = new (allocator) HInvokeStatic(allocator, number_of_arguments, return_type, 0, 0);
+  for (size_t i = 0; i < number_of_arguments; i++) {
+    (*invoke)->SetArgumentAt(i, arguments[i]);
+  }
+  body->AddInstruction(*invoke);
+  if (return_type == Primitive::kPrimVoid) {
+    body->AddInstruction(new (allocator) HReturnVoid());
+  } else {
+    body->AddInstruction(new (allocator) HReturn(*invoke, return_type));
+  }
+
+  HBasicBlock* exit = CreateBlock(graph, allocator);
+  body->AddSuccessor(exit);
+  exit->AddInstruction(new (allocator) HExit());
+  graph->SetExitBlock(exit);
+  return graph;
+}
+
+static HGraph* BuildSsaGraph(ArenaAllocator* allocator, const uint16_t* data) {
+  HGraphBuilder builder(allocator);
+  const DexFile::CodeItem* item = reinterpret_cast<const DexFile::CodeItem*>(data);
+  HGraph* graph = builder.BuildGraph(*item);
+  graph->BuildDominatorTree();
+  graph->TransformToSSA();
+  return graph;
+}
+
+TEST(InlinerTest, ParametersAreReplacedWithArguments) {
+  ArenaPool pool;
+  ArenaAllocator allocator(&pool);
+
+  HInstruction* arguments[] = { new (&allocator) HIntConstant(3),
+                                new (&allocator) HIntConstant(4) };
+  HInvokeStatic* invoke;
+  HGraph* caller = CreateCaller(&allocator, arguments, 2, Primitive::kPrimInt, &invoke);
+  HBasicBlock* caller_body = invoke->GetBlock();
+  HInstruction* ret = invoke->GetNext();
+
+  // Callee: return p0 + p1.
+  HGraph* callee = new (&allocator) HGraph(&allocator);
+  HBasicBlock* entry = CreateBlock(callee, &allocator);
+  callee->SetEntryBlock(entry);
+  HInstruction* first = new (&allocator) HParameterValue(0, Primitive::kPrimInt);
+  HInstruction* second = new (&allocator) HParameterValue(1, Primitive::kPrimInt);
+  entry->AddInstruction(first);
+  entry->AddInstruction(second);
+  entry->AddInstruction(new (&allocator) HGoto());
+  HBasicBlock* body = CreateBlock(callee, &allocator);
+  entry->AddSuccessor(body);
+  HInstruction* add = new (&allocator) HAdd(Primitive::kPrimInt, first, second);
+  body->AddInstruction(add);
+  body->AddInstruction(new (&allocator) HReturn(add, Primitive::kPrimInt));
+  HBasicBlock* exit = CreateBlock(callee, &allocator);
+  body->AddSuccessor(exit);
+  exit->AddInstruction(new (&allocator) HExit());
+  callee->SetExitBlock(exit);
+
+  callee->InlineInto(caller, invoke);
+
+  EXPECT_EQ(invoke->GetBlock(), nullptr);
+  EXPECT_EQ(add->GetBlock(), caller_body);
+  EXPECT_EQ(caller_body->GetFirstInstruction(), add);
+  EXPECT_EQ(add->GetNext(), ret);
+  EXPECT_EQ(ret->InputAt(0), add);
+  EXPECT_EQ(add->InputAt(0), arguments[0]);
+  EXPECT_EQ(add->InputAt(1), arguments[1]);
+  EXPECT_TRUE(arguments[0]->HasOnlyOneUse());
+  EXPECT_EQ(arguments[0]->GetUses()->GetUser(), add);
+  EXPECT_GT(add->GetId(), ret->GetId());
+}
+
+TEST(InlinerTest, ConstantsMoveToTheEntryBlock) {
+  ArenaPool pool;
+  ArenaAllocator allocator(&pool);
+
+  HInvokeStatic* invoke;
+  HGraph* caller = CreateCaller(&allocator, nullptr, 0, Primitive::kPrimInt, &invoke);
+  HInstruction* ret = invoke->GetNext();
+
+  // Callee: return 3.
+  const uint16_t data[] = ONE_REGISTER_CODE_ITEM(
+    Instruction::CONST_4 | 0 << 8 | 3 << 12,
+    Instruction::RETURN | 0 << 8);
+  HGraph* callee = BuildSsaGraph(&allocator, data);
+
+  callee->InlineInto(caller, invoke);
+
+  HInstruction* constant = ret->InputAt(0);
+  ASSERT_TRUE(constant->IsIntConstant());
+  EXPECT_EQ(constant->AsIntConstant()->GetValue(), 3);
+  EXPECT_EQ(constant->GetBlock(), caller->GetEntryBlock());
+  EXPECT_TRUE(caller->GetEntryBlock()->GetLastInstruction()->IsGoto());
+  EXPECT_EQ(ret->GetBlock()->GetFirstInstruction(), ret);
+}
+
+TEST(InlinerTest, VoidCallIsRemoved) {
+  ArenaPool pool;
+  ArenaAllocator allocator(&pool);
+
+  HInvokeStatic* invoke;
+  HGraph* caller = CreateCaller(&allocator, nullptr, 0, Primitive::kPrimVoid, &invoke);
+  HBasicBlock* caller_body = invoke->GetBlock();
+
+  const uint16_t data[] = ZERO_REGISTER_CODE_ITEM(Instruction::RETURN_VOID);
+  HGraph* callee = BuildSsaGraph(&allocator, data);
+
+  callee->InlineInto(caller, invoke);
+
+  EXPECT_EQ(invoke->GetBlock(), nullptr);
+  EXPECT_TRUE(caller_body->GetFirstInstruction()->IsReturnVoid());
+  EXPECT_EQ(caller_body->GetFirstInstruction(), caller_body->GetLastInstruction());
+}
+
+}  // namespace art
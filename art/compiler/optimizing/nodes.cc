@@ -231,6 +231,48 @@ bool HGraph::FindNaturalLoops() const {
   return true;
 }
 
+void HGraph::InlineInto(HGraph* outer_graph, HInvoke* invoke) {
+  DCHECK_EQ(blocks_.Size(), 3u);
+  HBasicBlock* body = blocks_.Get(1);
+  DCHECK(body != entry_block_ && body != exit_block_);
+  DCHECK(body->GetFirstPhi() == nullptr);
+
+  // Move the constants to the entry block of the outer graph, and replace the parameters,
+  // which are in the order of the arguments, with the arguments of the invoke.
+  HBasicBlock* outer_entry_block = outer_graph->GetEntryBlock();
+  size_t parameter_index = 0;
+  for (HInstructionIterator it(entry_block_->GetInstructions()); !it.Done(); it.Advance()) {
+    HInstruction* current = it.Current();
+    if (current->IsConstant()) {
+      outer_entry_block->MoveInstructionBefore(current, outer_entry_block->GetLastInstruction());
+    } else if (current->IsParameterValue()) {
+      current->ReplaceWith(invoke->InputAt(parameter_index++));
+    } else {
+      DCHECK(current->IsGoto());
+    }
+  }
+  DCHECK_EQ(parameter_index, invoke->InputCount());
+
+  // Move the body before the invoke, and replace the invoke with the returned value.
+  HBasicBlock* invoke_block = invoke->GetBlock();
+  HInstruction* last = body->GetLastInstruction();
+  for (HInstructionIterator it(body->GetInstructions()); !it.Done(); it.Advance()) {
+    HInstruction* current = it.Current();
+    if (current != last) {
+      invoke_block->MoveInstructionBefore(current, invoke);
+    }
+  }
+  if (last->IsReturn()) {
+    invoke->ReplaceWith(last->InputAt(0));
+  } else {
+    DCHECK(last->IsReturnVoid());
+  }
+  body->RemoveInstruction(last);
+  invoke_block->RemoveInstruction(invoke);
+
+  outer_graph->UpdateNumberOfTemporaries(number_of_temporaries_);
+}
+
 void HLoopInformation::PopulateRecursive(HBasicBlock* block) {
   if (blocks_.IsBitSet(block->GetBlockId())) {
     return;
@@ -288,6 +330,23 @@ bool HBasicBlock::Dominates(HBasicBlock* other) const {
   return false;
 }
 
+bool HInstruction::StrictlyDominates(HInstruction* other) const {
+  DCHECK_NE(GetKind(), kPhi);
+  DCHECK_NE(other->GetKind(), kPhi);
+  if (this == other) {
+    return false;
+  }
+  if (GetBlock() != other->GetBlock()) {
+    return GetBlock()->Dominates(other->GetBlock());
+  }
+  for (HInstruction* current = GetNext(); current != nullptr; current = current->GetNext()) {
+    if (current == other) {
+      return true;
+    }
+  }
+  return false;
+}
+
 void HBasicBlock::InsertInstructionBefore(HInstruction* instruction, HInstruction* cursor) {
   DCHECK(cursor->AsPhi() == nullptr);
   DCHECK(instruction->AsPhi() == nullptr);
@@ -307,6 +366,17 @@ void HBasicBlock::InsertInstructionBefore(HInstruction* instruction, HInstructio
   instruction->SetId(GetGraph()->GetNextInstructionId());
 }
 
+void HBasicBlock::MoveInstructionBefore(HInstruction* instruction, HInstruction* cursor) {
+  DCHECK_NE(instruction, cursor);
+  // Unlink the instruction, but leave its use lists and those of its inputs untouched.
+  instruction->GetBlock()->instructions_.RemoveInstruction(instruction);
+  instruction->previous_ = nullptr;
+  instruction->next_ = nullptr;
+  instruction->SetBlock(nullptr);
+  instruction->SetId(-1);
+  InsertInstructionBefore(instruction, cursor);
+}
+
 static void Add(HInstructionList* instruction_list,
                 HBasicBlock* block,
                 HInstruction* instruction) {
@@ -446,6 +516,40 @@ void HGraphVisitor::VisitBasicBlock(HBasicBlock* block) {
 }
 
 
+bool HInstruction::Equals(HInstruction* other) const {
+  if (GetKind() != other->GetKind()) return false;
+  if (GetType() != other->GetType()) return false;
+  if (!InstructionDataEquals(other)) return false;
+  if (InputCount() != other->InputCount()) return false;
+
+  for (size_t i = 0, e = InputCount(); i < e; ++i) {
+    if (InputAt(i) != other->InputAt(i)) return false;
+  }
+  DCHECK_EQ(ComputeHashCode(), other->ComputeHashCode());
+  return true;
+}
+
+HConstant* HBinaryOperation::TryStaticEvaluation(ArenaAllocator* allocator) const {
+  if (IsFloatingPoint()) {
+    return nullptr;
+  }
+  if (GetLeft()->IsIntConstant() && GetRight()->IsIntConstant()) {
+    int32_t value = Evaluate(GetLeft()->AsIntConstant()->GetValue(),
+                             GetRight()->AsIntConstant()->GetValue());
+    return new (allocator) HIntConstant(value);
+  } else if (GetLeft()->IsLongConstant() && GetRight()->IsLongConstant()) {
+    int64_t value = Evaluate(GetLeft()->AsLongConstant()->GetValue(),
+                             GetRight()->AsLongConstant()->GetValue());
+    if (GetResultType() == Primitive::kPrimLong) {
+      return new (allocator) HLongConstant(value);
+    } else {
+      // A comparison or a condition.
+      return new (allocator) HIntConstant(static_cast<int32_t>(value));
+    }
+  }
+  return nullptr;
+}
+
 bool HCondition::NeedsMaterialization() const {
   if (!HasOnlyOneUse()) {
     return true;
@@ -30,6 +30,7 @@ class HBasicBlock;
 class HEnvironment;
 class HInstruction;
 class HIntConstant;
+class HInvoke;
 class HGraphVisitor;
 class HPhi;
 class LiveInterval;
@@ -103,6 +104,11 @@ class HGraph : public ArenaObject {
   void SplitCriticalEdge(HBasicBlock* block, HBasicBlock* successor);
   void SimplifyLoop(HBasicBlock* header);
 
+  // Inlines this graph, in SSA form and with a single block between its entry and exit
+  // blocks, at `invoke` in `outer_graph`. The parameters are replaced by the arguments
+  // of `invoke`, and `invoke` by the returned value.
+  void InlineInto(HGraph* outer_graph, HInvoke* invoke);
+
   int GetNextInstructionId() {
     return current_instruction_id_++;
   }
@@ -352,6 +358,9 @@ class HBasicBlock : public ArenaObject {
   void AddInstruction(HInstruction* instruction);
   void RemoveInstruction(HInstruction* instruction);
   void InsertInstructionBefore(HInstruction* instruction, HInstruction* cursor);
+  // Moves `instruction`, which may be in another block or graph, before `cursor`. The
+  // instruction keeps its inputs and uses, and gets a new id in the graph of this block.
+  void MoveInstructionBefore(HInstruction* instruction, HInstruction* cursor);
   void AddPhi(HPhi* phi);
   void RemovePhi(HPhi* phi);
 
@@ -422,6 +431,8 @@ class HBasicBlock : public ArenaObject {
   M(If)                                                    \
   M(IntConstant)                                           \
   M(InvokeStatic)                                          \
+  M(InvokeVirtual)                                         \
+  M(InvokeInterface)                                       \
   M(LoadLocal)                                             \
   M(Local)                                                 \
   M(LongConstant)                                          \
@@ -434,6 +445,11 @@ class HBasicBlock : public ArenaObject {
   M(ReturnVoid)                                            \
   M(StoreLocal)                                            \
   M(Sub)                                                   \
+  M(Mul)                                                   \
+  M(Div)                                                   \
+  M(Rem)                                                   \
+  M(Neg)                                                   \
+  M(TypeConversion)                                        \
   M(Compare)                                               \
   M(InstanceFieldGet)                                      \
   M(InstanceFieldSet)                                      \
@@ -442,17 +458,23 @@ class HBasicBlock : public ArenaObject {
   M(ArrayLength)                                           \
   M(BoundsCheck)                                           \
   M(NullCheck)                                             \
+  M(DivZeroCheck)                                          \
+  M(LoadClass)                                             \
+  M(InstanceOf)                                            \
+  M(CheckCast)                                             \
   M(Temporary)                                             \
 
 #define FOR_EACH_INSTRUCTION(M)                            \
   FOR_EACH_CONCRETE_INSTRUCTION(M)                         \
-  M(Constant)
+  M(Constant)                                              \
+  M(BinaryOperation)
 
 #define FORWARD_DECLARATION(type) class H##type;
 FOR_EACH_INSTRUCTION(FORWARD_DECLARATION)
 #undef FORWARD_DECLARATION
 
 #define DECLARE_INSTRUCTION(type)                          \
+  virtual InstructionKind GetKind() const { return k##type; } \
   virtual const char* DebugName() const { return #type; }  \
   virtual H##type* As##type() { return this; }             \
   virtual void Accept(HGraphVisitor* visitor)              \
@@ -477,8 +499,45 @@ class HUseListNode : public ArenaObject {
   DISALLOW_COPY_AND_ASSIGN(HUseListNode);
 };
 
+// What an instruction does with the heap, for the optimizations which move or remove
+// instructions.
+class SideEffects : public ValueObject {
+ public:
+  static SideEffects None() {
+    return SideEffects(0);
+  }
+
+  static SideEffects All() {
+    return SideEffects(kChangesMemory | kDependsOnMemory);
+  }
+
+  static SideEffects DependsOnMemory() {
+    return SideEffects(kDependsOnMemory);
+  }
+
+  // Whether the instruction may write to the heap, or do anything else than compute its result.
+  bool HasSideEffects() const { return (flags_ & kChangesMemory) != 0; }
+
+  // Whether the result of the instruction depends on what is in the heap.
+  bool HasDependencies() const { return (flags_ & kDependsOnMemory) != 0; }
+
+ private:
+  static constexpr uint32_t kChangesMemory = 1;
+  static constexpr uint32_t kDependsOnMemory = 2;
+
+  explicit SideEffects(uint32_t flags) : flags_(flags) {}
+
+  uint32_t flags_;
+};
+
 class HInstruction : public ArenaObject {
  public:
+#define DECLARE_KIND(type) k##type,
+  enum InstructionKind {
+    FOR_EACH_INSTRUCTION(DECLARE_KIND)
+  };
+#undef DECLARE_KIND
+
   HInstruction()
       : previous_(nullptr),
         next_(nullptr),
@@ -502,11 +561,16 @@ class HInstruction : public ArenaObject {
   bool IsInBlock() const { return block_ != nullptr; }
   bool IsInLoop() const { return block_->IsInLoop(); }
 
+  // Returns whether this instruction is executed before `other` on every path reaching
+  // `other`. Phis are not supported.
+  bool StrictlyDominates(HInstruction* other) const;
+
   virtual size_t InputCount() const  = 0;
   virtual HInstruction* InputAt(size_t i) const = 0;
 
   virtual void Accept(HGraphVisitor* visitor) = 0;
   virtual const char* DebugName() const = 0;
+  virtual InstructionKind GetKind() const = 0;
 
   virtual Primitive::Type GetType() const { return Primitive::kPrimVoid; }
   virtual void SetRawInputAt(size_t index, HInstruction* input) = 0;
@@ -514,6 +578,31 @@ class HInstruction : public ArenaObject {
   virtual bool NeedsEnvironment() const { return false; }
   virtual bool IsControlFlow() const { return false; }
 
+  // Instructions are assumed to read and write the heap unless they say otherwise.
+  virtual SideEffects GetSideEffects() const { return SideEffects::All(); }
+
+  // Returns whether the instruction computes the same value wherever it is, given the same
+  // inputs and, if it depends on the heap, no intervening write. Such an instruction may be
+  // replaced by an equal one which dominates it. It must not throw.
+  virtual bool CanBeMoved() const { return false; }
+
+  // Returns whether the data of `other`, an instruction of the same kind, is equal to the data
+  // of this instruction. The inputs are compared by `Equals`.
+  virtual bool InstructionDataEquals(HInstruction* other) const { return false; }
+
+  // Returns whether this instruction and `other` compute the same value. Only meaningful for
+  // instructions which can be moved.
+  bool Equals(HInstruction* other) const;
+
+  // A hash code consistent with `Equals`.
+  virtual size_t ComputeHashCode() const {
+    size_t result = GetKind();
+    for (size_t i = 0, e = InputCount(); i < e; ++i) {
+      result = (result * 31) + InputAt(i)->GetId();
+    }
+    return result;
+  }
+
   void AddUseAt(HInstruction* user, size_t index) {
     uses_ = new (block_->GetGraph()->GetArena()) HUseListNode<HInstruction>(user, index, uses_);
   }
@@ -823,15 +912,21 @@ class HReturnVoid : public HTemplateInstruction<0> {
 // instruction that branches to the exit block.
 class HReturn : public HTemplateInstruction<1> {
  public:
-  explicit HReturn(HInstruction* value) {
+  HReturn(HInstruction* value, Primitive::Type return_type) : return_type_(return_type) {
     SetRawInputAt(0, value);
   }
 
+  // The type returned by the method. A constant value has an integral type, even when
+  // it holds the bits of a float or double.
+  Primitive::Type GetReturnType() const { return return_type_; }
+
   virtual bool IsControlFlow() const { return true; }
 
   DECLARE_INSTRUCTION(Return);
 
  private:
+  const Primitive::Type return_type_;
+
   DISALLOW_COPY_AND_ASSIGN(HReturn);
 };
 
@@ -909,6 +1004,27 @@ class HBinaryOperation : public HExpression<2> {
 
   virtual bool IsCommutative() { return false; }
 
+  virtual SideEffects GetSideEffects() const { return SideEffects::None(); }
+  virtual bool CanBeMoved() const { return true; }
+  virtual bool InstructionDataEquals(HInstruction* other) const { return true; }
+
+  // Whether the operation is done on float or double values. Dex constants are not typed,
+  // so the constant inputs of such an operation hold the bits of the values and cannot
+  // be evaluated statically.
+  virtual bool IsFloatingPoint() const {
+    return Primitive::IsFloatingPointType(GetResultType());
+  }
+
+  // Returns the result of the operation on constant inputs.
+  virtual int32_t Evaluate(int32_t x, int32_t y) const = 0;
+  virtual int64_t Evaluate(int64_t x, int64_t y) const = 0;
+
+  // Returns a constant holding the result of the operation if both inputs are constants, or
+  // nullptr. The constant is not added to the graph.
+  HConstant* TryStaticEvaluation(ArenaAllocator* allocator) const;
+
+  DECLARE_INSTRUCTION(BinaryOperation);
+
  private:
   DISALLOW_COPY_AND_ASSIGN(HBinaryOperation);
 };
@@ -921,6 +1037,10 @@ class HCondition : public HBinaryOperation {
   virtual bool IsCommutative() { return true; }
   bool NeedsMaterialization() const;
 
+  // A condition used by more than one branch would need to be materialized, which costs more
+  // than comparing again.
+  virtual bool CanBeMoved() const { return false; }
+
   DECLARE_INSTRUCTION(Condition);
 
   virtual IfCondition GetCondition() const = 0;
@@ -935,6 +1055,9 @@ class HEqual : public HCondition {
   HEqual(HInstruction* first, HInstruction* second)
       : HCondition(first, second) {}
 
+  virtual int32_t Evaluate(int32_t x, int32_t y) const { return x == y; }
+  virtual int64_t Evaluate(int64_t x, int64_t y) const { return x == y; }
+
   DECLARE_INSTRUCTION(Equal);
 
   virtual IfCondition GetCondition() const {
@@ -950,6 +1073,9 @@ class HNotEqual : public HCondition {
   HNotEqual(HInstruction* first, HInstruction* second)
       : HCondition(first, second) {}
 
+  virtual int32_t Evaluate(int32_t x, int32_t y) const { return x != y; }
+  virtual int64_t Evaluate(int64_t x, int64_t y) const { return x != y; }
+
   DECLARE_INSTRUCTION(NotEqual);
 
   virtual IfCondition GetCondition() const {
@@ -965,6 +1091,9 @@ class HLessThan : public HCondition {
   HLessThan(HInstruction* first, HInstruction* second)
       : HCondition(first, second) {}
 
+  virtual int32_t Evaluate(int32_t x, int32_t y) const { return x < y; }
+  virtual int64_t Evaluate(int64_t x, int64_t y) const { return x < y; }
+
   DECLARE_INSTRUCTION(LessThan);
 
   virtual IfCondition GetCondition() const {
@@ -980,6 +1109,9 @@ class HLessThanOrEqual : public HCondition {
   HLessThanOrEqual(HInstruction* first, HInstruction* second)
       : HCondition(first, second) {}
 
+  virtual int32_t Evaluate(int32_t x, int32_t y) const { return x <= y; }
+  virtual int64_t Evaluate(int64_t x, int64_t y) const { return x <= y; }
+
   DECLARE_INSTRUCTION(LessThanOrEqual);
 
   virtual IfCondition GetCondition() const {
@@ -995,6 +1127,9 @@ class HGreaterThan : public HCondition {
   HGreaterThan(HInstruction* first, HInstruction* second)
       : HCondition(first, second) {}
 
+  virtual int32_t Evaluate(int32_t x, int32_t y) const { return x > y; }
+  virtual int64_t Evaluate(int64_t x, int64_t y) const { return x > y; }
+
   DECLARE_INSTRUCTION(GreaterThan);
 
   virtual IfCondition GetCondition() const {
@@ -1010,6 +1145,9 @@ class HGreaterThanOrEqual : public HCondition {
   HGreaterThanOrEqual(HInstruction* first, HInstruction* second)
       : HCondition(first, second) {}
 
+  virtual int32_t Evaluate(int32_t x, int32_t y) const { return x >= y; }
+  virtual int64_t Evaluate(int64_t x, int64_t y) const { return x >= y; }
+
   DECLARE_INSTRUCTION(GreaterThanOrEqual);
 
   virtual IfCondition GetCondition() const {
@@ -1025,15 +1163,46 @@ class HGreaterThanOrEqual : public HCondition {
 // Result is 0 if input0 == input1, 1 if input0 > input1, or -1 if input0 < input1.
 class HCompare : public HBinaryOperation {
  public:
-  HCompare(Primitive::Type type, HInstruction* first, HInstruction* second)
-      : HBinaryOperation(Primitive::kPrimInt, first, second) {
+  // How a comparison involving NaN is resolved: cmpg-* and cmpl-* respectively make it
+  // a greater than or a less than.
+  enum Bias {
+    kNoBias,
+    kGtBias,
+    kLtBias,
+  };
+
+  HCompare(Primitive::Type type, HInstruction* first, HInstruction* second, Bias bias)
+      : HBinaryOperation(Primitive::kPrimInt, first, second), input_type_(type), bias_(bias) {
     DCHECK_EQ(type, first->GetType());
     DCHECK_EQ(type, second->GetType());
+    DCHECK_EQ(bias == kNoBias, !Primitive::IsFloatingPointType(type));
+  }
+
+  Primitive::Type GetInputType() const { return input_type_; }
+  Bias GetBias() const { return bias_; }
+  bool IsGtBias() const { return bias_ == kGtBias; }
+
+  virtual bool IsFloatingPoint() const {
+    return Primitive::IsFloatingPointType(input_type_);
+  }
+
+  virtual bool InstructionDataEquals(HInstruction* other) const {
+    return input_type_ == other->AsCompare()->input_type_ && bias_ == other->AsCompare()->bias_;
+  }
+
+  virtual int32_t Evaluate(int32_t x, int32_t y) const {
+    return x == y ? 0 : (x > y ? 1 : -1);
+  }
+  virtual int64_t Evaluate(int64_t x, int64_t y) const {
+    return x == y ? 0 : (x > y ? 1 : -1);
   }
 
   DECLARE_INSTRUCTION(Compare);
 
  private:
+  const Primitive::Type input_type_;
+  const Bias bias_;
+
   DISALLOW_COPY_AND_ASSIGN(HCompare);
 };
 
@@ -1089,6 +1258,9 @@ class HConstant : public HExpression<0> {
  public:
   explicit HConstant(Primitive::Type type) : HExpression(type) {}
 
+  virtual SideEffects GetSideEffects() const { return SideEffects::None(); }
+  virtual bool CanBeMoved() const { return true; }
+
   DECLARE_INSTRUCTION(Constant);
 
  private:
@@ -1103,6 +1275,12 @@ class HIntConstant : public HConstant {
 
   int32_t GetValue() const { return value_; }
 
+  virtual bool InstructionDataEquals(HInstruction* other) const {
+    return other->AsIntConstant()->value_ == value_;
+  }
+
+  virtual size_t ComputeHashCode() const { return GetValue(); }
+
   DECLARE_INSTRUCTION(IntConstant);
 
  private:
@@ -1117,6 +1295,12 @@ class HLongConstant : public HConstant {
 
   int64_t GetValue() const { return value_; }
 
+  virtual bool InstructionDataEquals(HInstruction* other) const {
+    return other->AsLongConstant()->value_ == value_;
+  }
+
+  virtual size_t ComputeHashCode() const { return static_cast<size_t>(GetValue()); }
+
   DECLARE_INSTRUCTION(LongConstant);
 
  private:
@@ -1185,6 +1369,55 @@ class HInvokeStatic : public HInvoke {
   DISALLOW_COPY_AND_ASSIGN(HInvokeStatic);
 };
 
+// Calls the method at `vtable_index` in the embedded vtable of the class of the receiver,
+// which is the first argument.
+class HInvokeVirtual : public HInvoke {
+ public:
+  HInvokeVirtual(ArenaAllocator* arena,
+                 uint32_t number_of_arguments,
+                 Primitive::Type return_type,
+                 uint32_t dex_pc,
+                 uint32_t vtable_index)
+      : HInvoke(arena, number_of_arguments, return_type, dex_pc),
+        vtable_index_(vtable_index) {}
+
+  uint32_t GetVTableIndex() const { return vtable_index_; }
+
+  DECLARE_INSTRUCTION(InvokeVirtual);
+
+ private:
+  const uint32_t vtable_index_;
+
+  DISALLOW_COPY_AND_ASSIGN(HInvokeVirtual);
+};
+
+// Calls the method at `imt_index` in the embedded interface method table of the class of
+// the receiver. When several interface methods share that entry, the conflict trampoline
+// finds the callee with `dex_method_index`, passed in a hidden argument.
+class HInvokeInterface : public HInvoke {
+ public:
+  HInvokeInterface(ArenaAllocator* arena,
+                   uint32_t number_of_arguments,
+                   Primitive::Type return_type,
+                   uint32_t dex_pc,
+                   uint32_t dex_method_index,
+                   uint32_t imt_index)
+      : HInvoke(arena, number_of_arguments, return_type, dex_pc),
+        dex_method_index_(dex_method_index),
+        imt_index_(imt_index) {}
+
+  uint32_t GetImtIndex() const { return imt_index_; }
+  uint32_t GetDexMethodIndex() const { return dex_method_index_; }
+
+  DECLARE_INSTRUCTION(InvokeInterface);
+
+ private:
+  const uint32_t dex_method_index_;
+  const uint32_t imt_index_;
+
+  DISALLOW_COPY_AND_ASSIGN(HInvokeInterface);
+};
+
 class HNewInstance : public HExpression<0> {
  public:
   HNewInstance(uint32_t dex_pc, uint16_t type_index) : HExpression(Primitive::kPrimNot),
@@ -1212,6 +1445,9 @@ class HAdd : public HBinaryOperation {
 
   virtual bool IsCommutative() { return true; }
 
+  virtual int32_t Evaluate(int32_t x, int32_t y) const { return x + y; }
+  virtual int64_t Evaluate(int64_t x, int64_t y) const { return x + y; }
+
   DECLARE_INSTRUCTION(Add);
 
  private:
@@ -1225,12 +1461,76 @@ class HSub : public HBinaryOperation {
 
   virtual bool IsCommutative() { return false; }
 
+  virtual int32_t Evaluate(int32_t x, int32_t y) const { return x - y; }
+  virtual int64_t Evaluate(int64_t x, int64_t y) const { return x - y; }
+
   DECLARE_INSTRUCTION(Sub);
 
  private:
   DISALLOW_COPY_AND_ASSIGN(HSub);
 };
 
+class HMul : public HBinaryOperation {
+ public:
+  HMul(Primitive::Type result_type, HInstruction* left, HInstruction* right)
+      : HBinaryOperation(result_type, left, right) {}
+
+  virtual bool IsCommutative() { return true; }
+
+  virtual int32_t Evaluate(int32_t x, int32_t y) const { return x * y; }
+  virtual int64_t Evaluate(int64_t x, int64_t y) const { return x * y; }
+
+  DECLARE_INSTRUCTION(Mul);
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(HMul);
+};
+
+// A division. The divisor of an integer division is the result of an HDivZeroCheck.
+class HDiv : public HBinaryOperation {
+ public:
+  HDiv(Primitive::Type result_type, HInstruction* left, HInstruction* right)
+      : HBinaryOperation(result_type, left, right) {}
+
+  // Dividing the minimum value by -1 overflows: Java wants the minimum value back.
+  virtual int32_t Evaluate(int32_t x, int32_t y) const {
+    DCHECK_NE(y, 0);
+    return (y == -1) ? static_cast<int32_t>(0u - static_cast<uint32_t>(x)) : x / y;
+  }
+  virtual int64_t Evaluate(int64_t x, int64_t y) const {
+    DCHECK_NE(y, 0);
+    return (y == -1) ? static_cast<int64_t>(UINT64_C(0) - static_cast<uint64_t>(x)) : x / y;
+  }
+
+  DECLARE_INSTRUCTION(Div);
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(HDiv);
+};
+
+// The remainder of an integer division, whose divisor is the result of an HDivZeroCheck.
+class HRem : public HBinaryOperation {
+ public:
+  HRem(Primitive::Type result_type, HInstruction* left, HInstruction* right)
+      : HBinaryOperation(result_type, left, right) {
+    DCHECK(!Primitive::IsFloatingPointType(result_type));
+  }
+
+  virtual int32_t Evaluate(int32_t x, int32_t y) const {
+    DCHECK_NE(y, 0);
+    return (y == -1) ? 0 : x % y;
+  }
+  virtual int64_t Evaluate(int64_t x, int64_t y) const {
+    DCHECK_NE(y, 0);
+    return (y == -1) ? 0 : x % y;
+  }
+
+  DECLARE_INSTRUCTION(Rem);
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(HRem);
+};
+
 // The value of a parameter in this method. Its location depends on
 // the calling convention.
 class HParameterValue : public HExpression<0> {
@@ -1256,12 +1556,63 @@ class HNot : public HExpression<1> {
     SetRawInputAt(0, input);
   }
 
+  virtual SideEffects GetSideEffects() const { return SideEffects::None(); }
+  virtual bool CanBeMoved() const { return true; }
+  virtual bool InstructionDataEquals(HInstruction* other) const { return true; }
+
   DECLARE_INSTRUCTION(Not);
 
  private:
   DISALLOW_COPY_AND_ASSIGN(HNot);
 };
 
+class HNeg : public HExpression<1> {
+ public:
+  HNeg(Primitive::Type result_type, HInstruction* input) : HExpression(result_type) {
+    SetRawInputAt(0, input);
+  }
+
+  Primitive::Type GetResultType() const { return GetType(); }
+
+  virtual SideEffects GetSideEffects() const { return SideEffects::None(); }
+  virtual bool CanBeMoved() const { return true; }
+  virtual bool InstructionDataEquals(HInstruction* other) const { return true; }
+
+  DECLARE_INSTRUCTION(Neg);
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(HNeg);
+};
+
+// A conversion between primitive types, with the Java semantics: float and double
+// values are rounded towards zero and saturated when converted to integral types.
+class HTypeConversion : public HExpression<1> {
+ public:
+  HTypeConversion(Primitive::Type result_type, Primitive::Type input_type, HInstruction* input)
+      : HExpression(result_type), input_type_(input_type) {
+    SetRawInputAt(0, input);
+  }
+
+  HInstruction* GetInput() const { return InputAt(0); }
+  // The type of the input is kept, as a constant input does not have the type of the
+  // value it holds.
+  Primitive::Type GetInputType() const { return input_type_; }
+  Primitive::Type GetResultType() const { return GetType(); }
+
+  virtual SideEffects GetSideEffects() const { return SideEffects::None(); }
+  virtual bool CanBeMoved() const { return true; }
+  virtual bool InstructionDataEquals(HInstruction* other) const {
+    return input_type_ == other->AsTypeConversion()->input_type_;
+  }
+
+  DECLARE_INSTRUCTION(TypeConversion);
+
+ private:
+  const Primitive::Type input_type_;
+
+  DISALLOW_COPY_AND_ASSIGN(HTypeConversion);
+};
+
 class HPhi : public HInstruction {
  public:
   HPhi(ArenaAllocator* arena, uint32_t reg_number, size_t number_of_inputs, Primitive::Type type)
@@ -1321,6 +1672,27 @@ class HNullCheck : public HExpression<1> {
   DISALLOW_COPY_AND_ASSIGN(HNullCheck);
 };
 
+// Throws an ArithmeticException if the divisor of an integer division or remainder is
+// zero, and is the divisor otherwise.
+class HDivZeroCheck : public HExpression<1> {
+ public:
+  HDivZeroCheck(HInstruction* value, uint32_t dex_pc)
+      : HExpression(value->GetType()), dex_pc_(dex_pc) {
+    SetRawInputAt(0, value);
+  }
+
+  virtual bool NeedsEnvironment() const { return true; }
+
+  uint32_t GetDexPc() const { return dex_pc_; }
+
+  DECLARE_INSTRUCTION(DivZeroCheck);
+
+ private:
+  const uint32_t dex_pc_;
+
+  DISALLOW_COPY_AND_ASSIGN(HDivZeroCheck);
+};
+
 class FieldInfo : public ValueObject {
  public:
   explicit FieldInfo(MemberOffset field_offset)
@@ -1343,6 +1715,17 @@ class HInstanceFieldGet : public HExpression<1> {
 
   MemberOffset GetFieldOffset() const { return field_info_.GetFieldOffset(); }
 
+  virtual SideEffects GetSideEffects() const { return SideEffects::DependsOnMemory(); }
+  virtual bool CanBeMoved() const { return true; }
+  virtual bool InstructionDataEquals(HInstruction* other) const {
+    size_t other_offset = other->AsInstanceFieldGet()->GetFieldOffset().SizeValue();
+    return other_offset == GetFieldOffset().SizeValue();
+  }
+
+  virtual size_t ComputeHashCode() const {
+    return (HInstruction::ComputeHashCode() * 31) + GetFieldOffset().SizeValue();
+  }
+
   DECLARE_INSTRUCTION(InstanceFieldGet);
 
  private:
@@ -1379,6 +1762,10 @@ class HArrayGet : public HExpression<2> {
     SetRawInputAt(1, index);
   }
 
+  virtual SideEffects GetSideEffects() const { return SideEffects::DependsOnMemory(); }
+  virtual bool CanBeMoved() const { return true; }
+  virtual bool InstructionDataEquals(HInstruction* other) const { return true; }
+
   DECLARE_INSTRUCTION(ArrayGet);
 
  private:
@@ -1418,6 +1805,11 @@ class HArrayLength : public HExpression<1> {
     SetRawInputAt(0, array);
   }
 
+  // The length of an array never changes.
+  virtual SideEffects GetSideEffects() const { return SideEffects::None(); }
+  virtual bool CanBeMoved() const { return true; }
+  virtual bool InstructionDataEquals(HInstruction* other) const { return true; }
+
   DECLARE_INSTRUCTION(ArrayLength);
 
  private:
@@ -1445,6 +1837,76 @@ class HBoundsCheck : public HExpression<2> {
   DISALLOW_COPY_AND_ASSIGN(HBoundsCheck);
 };
 
+// The class of a type index of the dex file, from the dex cache of the method. The runtime
+// resolves and initializes it when the cache does not have it, or when the access to the
+// class has to be checked.
+class HLoadClass : public HExpression<0> {
+ public:
+  HLoadClass(uint16_t type_index, bool needs_access_check, uint32_t dex_pc)
+      : HExpression(Primitive::kPrimNot),
+        type_index_(type_index),
+        needs_access_check_(needs_access_check),
+        dex_pc_(dex_pc) {}
+
+  uint16_t GetTypeIndex() const { return type_index_; }
+  bool NeedsAccessCheck() const { return needs_access_check_; }
+  uint32_t GetDexPc() const { return dex_pc_; }
+
+  // Calls runtime so needs an environment.
+  virtual bool NeedsEnvironment() const { return true; }
+
+  DECLARE_INSTRUCTION(LoadClass);
+
+ private:
+  const uint16_t type_index_;
+  const bool needs_access_check_;
+  const uint32_t dex_pc_;
+
+  DISALLOW_COPY_AND_ASSIGN(HLoadClass);
+};
+
+// Whether an object is an instance of a class, the result of an HLoadClass. The runtime
+// is only called when the object is not null and its class is not the one checked.
+class HInstanceOf : public HExpression<2> {
+ public:
+  HInstanceOf(HInstruction* object, HLoadClass* load_class, uint32_t dex_pc)
+      : HExpression(Primitive::kPrimBoolean), dex_pc_(dex_pc) {
+    SetRawInputAt(0, object);
+    SetRawInputAt(1, load_class);
+  }
+
+  uint32_t GetDexPc() const { return dex_pc_; }
+
+  DECLARE_INSTRUCTION(InstanceOf);
+
+ private:
+  const uint32_t dex_pc_;
+
+  DISALLOW_COPY_AND_ASSIGN(HInstanceOf);
+};
+
+// Throws a ClassCastException if an object is not null and not an instance of a class,
+// the result of an HLoadClass.
+class HCheckCast : public HTemplateInstruction<2> {
+ public:
+  HCheckCast(HInstruction* object, HLoadClass* load_class, uint32_t dex_pc)
+      : dex_pc_(dex_pc) {
+    SetRawInputAt(0, object);
+    SetRawInputAt(1, load_class);
+  }
+
+  virtual bool NeedsEnvironment() const { return true; }
+
+  uint32_t GetDexPc() const { return dex_pc_; }
+
+  DECLARE_INSTRUCTION(CheckCast);
+
+ private:
+  const uint32_t dex_pc_;
+
+  DISALLOW_COPY_AND_ASSIGN(HCheckCast);
+};
+
 /**
  * Some DEX instructions are folded into multiple HInstructions that need
  * to stay live until the last HInstruction. This class
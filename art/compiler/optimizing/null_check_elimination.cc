@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "null_check_elimination.h"
+
+namespace art {
+
+// Returns a null check of `value` executed before `check`, or null if there is none.
+static HNullCheck* FindDominatingNullCheck(HInstruction* value, HNullCheck* check) {
+  for (HUseIterator<HInstruction> it(value->GetUses()); !it.Done(); it.Advance()) {
+    HInstruction* user = it.Current()->GetUser();
+    if (user->IsNullCheck() && user->StrictlyDominates(check)) {
+      return user->AsNullCheck();
+    }
+  }
+  return nullptr;
+}
+
+void HNullCheckElimination::RemoveCheck(HNullCheck* check, HInstruction* replacement) {
+  check->ReplaceWith(replacement);
+  check->GetBlock()->RemoveInstruction(check);
+  if (compilation_stats_ != nullptr) {
+    compilation_stats_->RecordStat(MethodCompilationStat::kRemovedNullCheck);
+  }
+}
+
+void HNullCheckElimination::Run() {
+  // Process the blocks in reverse post order, so that a dominating null check has been
+  // looked at, and kept or replaced, before the checks it dominates.
+  for (HReversePostOrderIterator it(*graph_); !it.Done(); it.Advance()) {
+    HBasicBlock* block = it.Current();
+    for (HInstructionIterator inst_it(block->GetInstructions()); !inst_it.Done();
+         inst_it.Advance()) {
+      HNullCheck* check = inst_it.Current()->AsNullCheck();
+      if (check == nullptr) {
+        continue;
+      }
+      HInstruction* value = check->InputAt(0);
+      if (value->IsNewInstance()) {
+        // An allocation either returns an object or throws.
+        RemoveCheck(check, value);
+        continue;
+      }
+      HNullCheck* dominating_check = FindDominatingNullCheck(value, check);
+      if (dominating_check != nullptr) {
+        RemoveCheck(check, dominating_check);
+      }
+    }
+  }
+}
+
+}  // namespace art
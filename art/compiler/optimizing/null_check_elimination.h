@@ -0,0 +1,51 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_COMPILER_OPTIMIZING_NULL_CHECK_ELIMINATION_H_
+#define ART_COMPILER_OPTIMIZING_NULL_CHECK_ELIMINATION_H_
+
+#include "optimization.h"
+#include "optimizing_compiler_stats.h"
+
+namespace art {
+
+/**
+ * Optimization pass removing the null checks of values known not to be null: objects
+ * allocated by the method, and values already checked by a null check that dominates
+ * the new one.
+ */
+class HNullCheckElimination : public HOptimization {
+ public:
+  explicit HNullCheckElimination(HGraph* graph,
+                                 OptimizingCompilerStats* compilation_stats = nullptr)
+      : HOptimization(graph, kNullCheckEliminationPassName),
+        compilation_stats_(compilation_stats) {}
+
+  virtual void Run() OVERRIDE;
+
+  static constexpr const char* kNullCheckEliminationPassName = "null_check_elimination";
+
+ private:
+  void RemoveCheck(HNullCheck* check, HInstruction* replacement);
+
+  OptimizingCompilerStats* const compilation_stats_;
+
+  DISALLOW_COPY_AND_ASSIGN(HNullCheckElimination);
+};
+
+}  // namespace art
+
+#endif  // ART_COMPILER_OPTIMIZING_NULL_CHECK_ELIMINATION_H_
@@ -0,0 +1,53 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_COMPILER_OPTIMIZING_OPTIMIZATION_H_
+#define ART_COMPILER_OPTIMIZING_OPTIMIZATION_H_
+
+#include "nodes.h"
+
+namespace art {
+
+/**
+ * Abstraction to implement an optimization pass on an SSA graph. The optimizing
+ * compiler runs the passes in order, and dumps and times them by name.
+ */
+class HOptimization : public ValueObject {
+ public:
+  HOptimization(HGraph* graph, const char* pass_name)
+      : graph_(graph), pass_name_(pass_name) {}
+
+  virtual ~HOptimization() {}
+
+  // The name of the pass, as given to --disable-passes and shown in the timings and the
+  // visualizer output.
+  const char* GetPassName() const { return pass_name_; }
+
+  // Performs the optimization on the graph.
+  virtual void Run() = 0;
+
+ protected:
+  HGraph* const graph_;
+
+ private:
+  const char* const pass_name_;
+
+  DISALLOW_COPY_AND_ASSIGN(HOptimization);
+};
+
+}  // namespace art
+
+#endif  // ART_COMPILER_OPTIMIZING_OPTIMIZATION_H_
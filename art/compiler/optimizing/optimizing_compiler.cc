@@ -17,13 +17,22 @@
 #include <fstream>
 #include <stdint.h>
 
+#include "base/timing_logger.h"
+#include "bounds_check_elimination.h"
 #include "builder.h"
 #include "code_generator.h"
 #include "compilers.h"
+#include "constant_folding.h"
+#include "dead_code_elimination.h"
 #include "driver/compiler_driver.h"
+#include "driver/compiler_options.h"
 #include "driver/dex_compilation_unit.h"
 #include "graph_visualizer.h"
+#include "gvn.h"
+#include "inliner.h"
 #include "nodes.h"
+#include "null_check_elimination.h"
+#include "optimizing_compiler_stats.h"
 #include "register_allocator.h"
 #include "ssa_phi_elimination.h"
 #include "ssa_liveness_analysis.h"
@@ -65,6 +74,48 @@ static bool kIsVisualizerEnabled = false;
  */
 static const char* kStringFilter = "";
 
+/**
+ * Runs the optimization passes on the SSA graph, except those disabled with --disable-passes.
+ * When `timings` is not null, each pass is timed under its name. The checks removed are
+ * counted in `compilation_stats`.
+ */
+static void RunOptimizations(HGraph* graph,
+                             const CompilerOptions& compiler_options,
+                             TimingLogger* timings,
+                             HGraphVisualizer* visualizer,
+                             OptimizingCompilerStats* compilation_stats) {
+  HConstantFolding constant_folding(graph);
+  HDeadCodeElimination dead_code_elimination(graph);
+  HNullCheckElimination null_check_elimination(graph, compilation_stats);
+  GVNOptimization gvn(graph);
+  HBoundsCheckElimination bounds_check_elimination(graph, compilation_stats);
+
+  // Null check elimination runs before GVN, so that the array lengths read through the
+  // removed checks can be shared.
+  HOptimization* optimizations[] = {
+    &constant_folding,
+    &dead_code_elimination,
+    &null_check_elimination,
+    &gvn,
+    &bounds_check_elimination,
+  };
+
+  for (HOptimization* optimization : optimizations) {
+    const char* pass_name = optimization->GetPassName();
+    if (compiler_options.IsPassDisabled(pass_name)) {
+      continue;
+    }
+    if (timings != nullptr) {
+      timings->StartTiming(pass_name);
+    }
+    optimization->Run();
+    if (timings != nullptr) {
+      timings->EndTiming();
+    }
+    visualizer->DumpGraph(pass_name);
+  }
+}
+
 OptimizingCompiler::OptimizingCompiler(CompilerDriver* driver) : QuickCompiler(driver) {
   if (kIsVisualizerEnabled) {
     visualizer_output_.reset(new std::ofstream("art.cfg"));
@@ -78,6 +129,7 @@ CompiledMethod* OptimizingCompiler::TryCompile(const DexFile::CodeItem* code_ite
                                                uint32_t method_idx,
                                                jobject class_loader,
                                                const DexFile& dex_file) const {
+  compilation_stats_.RecordStat(MethodCompilationStat::kAttemptCompilation);
   InstructionSet instruction_set = GetCompilerDriver()->GetInstructionSet();
   // Always use the thumb2 assembler: some runtime functionality (like implicit stack
   // overflow checks) assume thumb2.
@@ -86,7 +138,11 @@ CompiledMethod* OptimizingCompiler::TryCompile(const DexFile::CodeItem* code_ite
   }
 
   // Do not attempt to compile on architectures we do not support.
-  if (instruction_set != kX86 && instruction_set != kX86_64 && instruction_set != kThumb2) {
+  if (instruction_set != kX86
+      && instruction_set != kX86_64
+      && instruction_set != kThumb2
+      && instruction_set != kArm64) {
+    compilation_stats_.RecordStat(MethodCompilationStat::kNotCompiledUnsupportedIsa);
     return nullptr;
   }
 
@@ -103,7 +159,8 @@ CompiledMethod* OptimizingCompiler::TryCompile(const DexFile::CodeItem* code_ite
 
   ArenaPool pool;
   ArenaAllocator arena(&pool);
-  HGraphBuilder builder(&arena, &dex_compilation_unit, &dex_file, GetCompilerDriver());
+  HGraphBuilder builder(&arena, &dex_compilation_unit, &dex_file, GetCompilerDriver(),
+                        &compilation_stats_);
 
   HGraph* graph = builder.BuildGraph(*code_item);
   if (graph == nullptr) {
@@ -113,29 +170,63 @@ CompiledMethod* OptimizingCompiler::TryCompile(const DexFile::CodeItem* code_ite
     return nullptr;
   }
 
+  // Invokes need an environment, which the register allocator does not support yet (it
+  // only supports the one of the null and bounds checks). When they are what keeps the
+  // method from being optimized, try to inline them all in the SSA form of the graph, and
+  // build the graph again for the baseline compiler if that fails.
+  bool can_optimize = RegisterAllocator::CanAllocateRegistersFor(*graph, instruction_set);
+  bool is_ssa = false;
+  if (!can_optimize
+      && RegisterAllocator::Supports(instruction_set)
+      && !GetCompilerDriver()->GetCompilerOptions().IsPassDisabled(HInliner::kInlinerPassName)
+      && HInliner::OnlyInvokesNeedEnvironment(*graph)) {
+    graph->BuildDominatorTree();
+    graph->TransformToSSA();
+    HInliner(graph, dex_compilation_unit, GetCompilerDriver(), &compilation_stats_).Run();
+    can_optimize = RegisterAllocator::CanAllocateRegistersFor(*graph, instruction_set);
+    if (can_optimize) {
+      is_ssa = true;
+    } else {
+      HGraphBuilder baseline_builder(&arena, &dex_compilation_unit, &dex_file, GetCompilerDriver());
+      graph = baseline_builder.BuildGraph(*code_item);
+      DCHECK(graph != nullptr);
+    }
+  }
+
   CodeGenerator* codegen = CodeGenerator::Create(&arena, graph, instruction_set);
   if (codegen == nullptr) {
     if (shouldCompile) {
       LOG(FATAL) << "Could not find code generator for optimizing compiler";
     }
+    compilation_stats_.RecordStat(MethodCompilationStat::kNotCompiledNoCodegen);
     return nullptr;
   }
 
   HGraphVisualizer visualizer(
       visualizer_output_.get(), graph, kStringFilter, *codegen, dex_compilation_unit);
-  visualizer.DumpGraph("builder");
+  visualizer.DumpGraph(is_ssa ? HInliner::kInlinerPassName : "builder");
 
   CodeVectorAllocator allocator;
 
-  if (RegisterAllocator::CanAllocateRegistersFor(*graph, instruction_set)) {
-    graph->BuildDominatorTree();
-    graph->TransformToSSA();
+  if (can_optimize) {
+    if (!is_ssa) {
+      graph->BuildDominatorTree();
+      graph->TransformToSSA();
+    }
     visualizer.DumpGraph("ssa");
     graph->FindNaturalLoops();
 
     SsaRedundantPhiElimination(graph).Run();
     SsaDeadPhiElimination(graph).Run();
 
+    const bool dump_passes = GetCompilerDriver()->GetDumpPasses();
+    TimingLogger timings("OptimizingCompiler", true, false);
+    RunOptimizations(graph, GetCompilerDriver()->GetCompilerOptions(),
+                     dump_passes ? &timings : nullptr, &visualizer, &compilation_stats_);
+    if (dump_passes) {
+      GetCompilerDriver()->GetTimingsLogger()->AddLogger(timings);
+    }
+
     SsaLivenessAnalysis liveness(*graph, codegen);
     liveness.Analyze();
     visualizer.DumpGraph(kLivenessPassName);
@@ -145,10 +236,12 @@ CompiledMethod* OptimizingCompiler::TryCompile(const DexFile::CodeItem* code_ite
 
     visualizer.DumpGraph(kRegisterAllocatorPassName);
     codegen->CompileOptimized(&allocator);
+    compilation_stats_.RecordStat(MethodCompilationStat::kCompiledOptimized);
   } else if (shouldOptimize && RegisterAllocator::Supports(instruction_set)) {
     LOG(FATAL) << "Could not allocate registers in optimizing compiler";
   } else {
     codegen->CompileBaseline(&allocator);
+    compilation_stats_.RecordStat(MethodCompilationStat::kCompiledBaseline);
 
     // Run these phases to get some test coverage.
     graph->BuildDominatorTree();
@@ -179,4 +272,8 @@ CompiledMethod* OptimizingCompiler::TryCompile(const DexFile::CodeItem* code_ite
                                                  ArrayRef<const uint8_t>());
 }
 
+void OptimizingCompiler::DumpStats() const {
+  compilation_stats_.Log();
+}
+
 }  // namespace art
@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_COMPILER_OPTIMIZING_OPTIMIZING_COMPILER_STATS_H_
+#define ART_COMPILER_OPTIMIZING_OPTIMIZING_COMPILER_STATS_H_
+
+#include "atomic.h"
+#include "base/logging.h"
+
+namespace art {
+
+enum MethodCompilationStat {
+  kAttemptCompilation = 0,
+  kCompiledBaseline,
+  kCompiledOptimized,
+  kInlinedInvoke,
+  kRemovedNullCheck,
+  kRemovedBoundsCheck,
+  kNotCompiledUnsupportedIsa,
+  kNotCompiledNoCodegen,
+  kNotCompiledTryCatch,
+  kNotCompiledUnresolvedMethod,
+  kNotCompiledUnresolvedField,
+  kNotCompiledVolatile,
+  kNotCompiledNonSequentialRegPair,
+  kNotCompiledUnhandledInstruction,
+  kLastStat
+};
+
+/**
+ * Counts, for the methods given to the optimizing compiler, how they were compiled, or
+ * why the compiler bailed out to Quick. Methods are compiled by several threads.
+ */
+class OptimizingCompilerStats {
+ public:
+  OptimizingCompilerStats() {}
+
+  void RecordStat(MethodCompilationStat stat) {
+    compile_stats_[stat].FetchAndAddSequentiallyConsistent(1);
+  }
+
+  int32_t GetStat(MethodCompilationStat stat) const {
+    return compile_stats_[stat].LoadRelaxed();
+  }
+
+  void Log() const {
+    int32_t attempts = compile_stats_[kAttemptCompilation].LoadRelaxed();
+    if (attempts == 0) {
+      LOG(INFO) << "The optimizing compiler did not attempt to compile any method";
+      return;
+    }
+    int32_t compiled = compile_stats_[kCompiledBaseline].LoadRelaxed()
+        + compile_stats_[kCompiledOptimized].LoadRelaxed();
+    LOG(INFO) << "The optimizing compiler compiled " << compiled << " of " << attempts
+              << " methods (" << (100.0 * compiled / attempts) << "%)";
+    for (int i = 0; i < kLastStat; i++) {
+      int32_t value = compile_stats_[i].LoadRelaxed();
+      if (i != kAttemptCompilation && value != 0) {
+        LOG(INFO) << PrintMethodCompilationStat(static_cast<MethodCompilationStat>(i))
+                  << ": " << value;
+      }
+    }
+  }
+
+ private:
+  static const char* PrintMethodCompilationStat(MethodCompilationStat stat) {
+    switch (stat) {
+      case kAttemptCompilation : return "kAttemptCompilation";
+      case kCompiledBaseline : return "kCompiledBaseline";
+      case kCompiledOptimized : return "kCompiledOptimized";
+      case kInlinedInvoke : return "kInlinedInvoke";
+      case kRemovedNullCheck : return "kRemovedNullCheck";
+      case kRemovedBoundsCheck : return "kRemovedBoundsCheck";
+      case kNotCompiledUnsupportedIsa : return "kNotCompiledUnsupportedIsa";
+      case kNotCompiledNoCodegen : return "kNotCompiledNoCodegen";
+      case kNotCompiledTryCatch : return "kNotCompiledTryCatch";
+      case kNotCompiledUnresolvedMethod : return "kNotCompiledUnresolvedMethod";
+      case kNotCompiledUnresolvedField : return "kNotCompiledUnresolvedField";
+      case kNotCompiledVolatile : return "kNotCompiledVolatile";
+      case kNotCompiledNonSequentialRegPair : return "kNotCompiledNonSequentialRegPair";
+      case kNotCompiledUnhandledInstruction : return "kNotCompiledUnhandledInstruction";
+      case kLastStat : break;
+    }
+    LOG(FATAL) << "invalid stat " << static_cast<int>(stat);
+    return nullptr;
+  }
+
+  AtomicInteger compile_stats_[kLastStat];
+
+  DISALLOW_COPY_AND_ASSIGN(OptimizingCompilerStats);
+};
+
+}  // namespace art
+
+#endif  // ART_COMPILER_OPTIMIZING_OPTIMIZING_COMPILER_STATS_H_
@@ -0,0 +1,204 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "base/casts.h"
+#include "common_compiler_test.h"
+#include "compilers.h"
+#include "driver/compiler_driver.h"
+#include "handle_scope-inl.h"
+#include "mirror/class_loader.h"
+#include "optimizing_compiler_stats.h"
+#include "scoped_thread_state_change.h"
+
+#include "gtest/gtest.h"
+
+namespace art {
+
+/**
+ * Compiles the methods of the test dex files with the optimizing compiler, through
+ * the compiler driver.
+ */
+class OptimizingCompilerTest : public CommonCompilerTest {
+ protected:
+  Compiler::Kind GetCompilerKind() const OVERRIDE {
+    return Compiler::kOptimizing;
+  }
+
+  int32_t GetStat(MethodCompilationStat stat) const {
+    return down_cast<OptimizingCompiler*>(compiler_driver_->GetCompiler())
+        ->GetCompilationStats().GetStat(stat);
+  }
+
+  // Loads `class_name` from the dex file of the same name, and compiles one of its methods.
+  void LoadAndCompile(const char* class_name, const char* method_name, const char* signature,
+                      bool is_virtual) {
+    ScopedObjectAccess soa(Thread::Current());
+    jobject class_loader = LoadDex(class_name);
+    StackHandleScope<1> hs(soa.Self());
+    Handle<mirror::ClassLoader> loader(
+        hs.NewHandle(soa.Decode<mirror::ClassLoader*>(class_loader)));
+    if (is_virtual) {
+      CompileVirtualMethod(loader, class_name, method_name, signature);
+    } else {
+      CompileDirectMethod(loader, class_name, method_name, signature);
+    }
+  }
+
+  // Starts the runtime, to call the compiled methods through JNI.
+  JNIEnv* StartRuntime() {
+    Thread::Current()->TransitionFromSuspendedToRunnable();
+    bool started = runtime_->Start();
+    CHECK(started);
+    return Thread::Current()->GetJniEnv();
+  }
+};
+
+TEST_F(OptimizingCompilerTest, RemovesChecksOfArrayLoop) {
+  TEST_DISABLED_FOR_HEAP_REFERENCE_POISONING();
+  TEST_DISABLED_FOR_MIPS();
+  LoadAndCompile("OptimizingChecks", "sum", "([I)I", false);
+
+  // The method was compiled with the optimizations, which removed the null and bounds
+  // checks of the array access in the loop.
+  EXPECT_EQ(1, GetStat(kAttemptCompilation));
+  EXPECT_EQ(1, GetStat(kCompiledOptimized));
+  EXPECT_EQ(0, GetStat(kCompiledBaseline));
+  EXPECT_EQ(1, GetStat(kRemovedNullCheck));
+  EXPECT_EQ(1, GetStat(kRemovedBoundsCheck));
+
+  JNIEnv* env = StartRuntime();
+  jclass klass = env->FindClass("OptimizingChecks");
+  ASSERT_TRUE(klass != nullptr);
+  jmethodID sum = env->GetStaticMethodID(klass, "sum", "([I)I");
+  ASSERT_TRUE(sum != nullptr);
+
+  const jint values[] = { 1, 2, 3, 4 };
+  jintArray array = env->NewIntArray(arraysize(values));
+  env->SetIntArrayRegion(array, 0, arraysize(values), values);
+  EXPECT_EQ(10, env->CallStaticIntMethod(klass, sum, array));
+  EXPECT_FALSE(env->ExceptionCheck());
+
+  // The null check kept in the loop header throws out of the optimized frame.
+  env->CallStaticIntMethod(klass, sum, nullptr);
+  ASSERT_TRUE(env->ExceptionCheck());
+  jthrowable exception = env->ExceptionOccurred();
+  env->ExceptionClear();
+  jclass npe_class = env->FindClass("java/lang/NullPointerException");
+  EXPECT_TRUE(env->IsInstanceOf(exception, npe_class));
+}
+
+TEST_F(OptimizingCompilerTest, InlinesGetterAndSetter) {
+  TEST_DISABLED_FOR_HEAP_REFERENCE_POISONING();
+  TEST_DISABLED_FOR_MIPS();
+  LoadAndCompile("OptimizingInlining", "addAndGet", "(I)I", true);
+
+  // The three calls were inlined, which let the method be compiled with the optimizations.
+  // The receiver checks of the getter and the setter were left to the caller, and the
+  // check of the argument of the static method is dominated by them.
+  EXPECT_EQ(1, GetStat(kAttemptCompilation));
+  EXPECT_EQ(3, GetStat(kInlinedInvoke));
+  EXPECT_EQ(1, GetStat(kCompiledOptimized));
+  EXPECT_EQ(0, GetStat(kCompiledBaseline));
+  EXPECT_EQ(2, GetStat(kRemovedNullCheck));
+
+  JNIEnv* env = StartRuntime();
+  jclass klass = env->FindClass("OptimizingInlining");
+  ASSERT_TRUE(klass != nullptr);
+  jmethodID add_and_get = env->GetMethodID(klass, "addAndGet", "(I)I");
+  ASSERT_TRUE(add_and_get != nullptr);
+  jobject object = env->AllocObject(klass);
+  ASSERT_TRUE(object != nullptr);
+  EXPECT_EQ(5, env->CallIntMethod(object, add_and_get, 5));
+  EXPECT_EQ(8, env->CallIntMethod(object, add_and_get, 3));
+  EXPECT_FALSE(env->ExceptionCheck());
+}
+
+TEST_F(OptimizingCompilerTest, CallsVirtualAndInterfaceMethodsWithFloatingPoint) {
+  TEST_DISABLED_FOR_HEAP_REFERENCE_POISONING();
+  TEST_DISABLED_FOR_MIPS();
+  const char* signature = "(LOptimizingInvokes$Scaler;FD)D";
+  LoadAndCompile("OptimizingInvokes", "halfAndScale", signature, true);
+
+  // The virtual and interface calls need an environment, so the method is compiled
+  // with the baseline compiler. The callees run in the interpreter, which checks the
+  // passing of the floating-point arguments and results in both directions.
+  EXPECT_EQ(1, GetStat(kAttemptCompilation));
+  EXPECT_EQ(0, GetStat(kInlinedInvoke));
+  EXPECT_EQ(0, GetStat(kCompiledOptimized));
+  EXPECT_EQ(1, GetStat(kCompiledBaseline));
+
+  JNIEnv* env = StartRuntime();
+  jclass klass = env->FindClass("OptimizingInvokes");
+  ASSERT_TRUE(klass != nullptr);
+  jclass multiplier_class = env->FindClass("OptimizingInvokes$Multiplier");
+  ASSERT_TRUE(multiplier_class != nullptr);
+  jmethodID half_and_scale = env->GetMethodID(klass, "halfAndScale", signature);
+  ASSERT_TRUE(half_and_scale != nullptr);
+  jobject object = env->AllocObject(klass);
+  ASSERT_TRUE(object != nullptr);
+  jobject multiplier = env->AllocObject(multiplier_class);
+  ASSERT_TRUE(multiplier != nullptr);
+  EXPECT_EQ(7.5, env->CallDoubleMethod(object, half_and_scale, multiplier, 5.0f, 3.0));
+  EXPECT_EQ(-0.25, env->CallDoubleMethod(object, half_and_scale, multiplier, 1.0f, -0.5));
+  EXPECT_FALSE(env->ExceptionCheck());
+}
+
+TEST_F(OptimizingCompilerTest, ChecksTypesAndDivides) {
+  TEST_DISABLED_FOR_HEAP_REFERENCE_POISONING();
+  TEST_DISABLED_FOR_MIPS();
+  const char* signature = "(Ljava/lang/Object;I)I";
+  LoadAndCompile("OptimizingTypeChecks", "castAndDivide", signature, false);
+
+  // Loading the classes checked against needs an environment, so the method is compiled
+  // with the baseline compiler.
+  EXPECT_EQ(1, GetStat(kAttemptCompilation));
+  EXPECT_EQ(0, GetStat(kCompiledOptimized));
+  EXPECT_EQ(1, GetStat(kCompiledBaseline));
+
+  JNIEnv* env = StartRuntime();
+  jclass klass = env->FindClass("OptimizingTypeChecks");
+  ASSERT_TRUE(klass != nullptr);
+  jclass base_class = env->FindClass("OptimizingTypeChecks$Base");
+  ASSERT_TRUE(base_class != nullptr);
+  jclass derived_class = env->FindClass("OptimizingTypeChecks$Derived");
+  ASSERT_TRUE(derived_class != nullptr);
+  jmethodID cast_and_divide = env->GetStaticMethodID(klass, "castAndDivide", signature);
+  ASSERT_TRUE(cast_and_divide != nullptr);
+  jobject base = env->AllocObject(base_class);
+  ASSERT_TRUE(base != nullptr);
+  jobject derived = env->AllocObject(derived_class);
+  ASSERT_TRUE(derived != nullptr);
+
+  EXPECT_EQ(14 + 2 + 1, env->CallStaticIntMethod(klass, cast_and_divide, derived, 7));
+  EXPECT_EQ(-33 + 1, env->CallStaticIntMethod(klass, cast_and_divide, base, -3));
+  EXPECT_EQ(-100, env->CallStaticIntMethod(klass, cast_and_divide, nullptr, -1));
+  EXPECT_FALSE(env->ExceptionCheck());
+
+  // The checks throw out of the compiled frame.
+  env->CallStaticIntMethod(klass, cast_and_divide, base, 0);
+  ASSERT_TRUE(env->ExceptionCheck());
+  jthrowable exception = env->ExceptionOccurred();
+  env->ExceptionClear();
+  EXPECT_TRUE(env->IsInstanceOf(exception, env->FindClass("java/lang/ArithmeticException")));
+
+  env->CallStaticIntMethod(klass, cast_and_divide, klass, 1);
+  ASSERT_TRUE(env->ExceptionCheck());
+  exception = env->ExceptionOccurred();
+  env->ExceptionClear();
+  EXPECT_TRUE(env->IsInstanceOf(exception, env->FindClass("java/lang/ClassCastException")));
+}
+
+}  // namespace art
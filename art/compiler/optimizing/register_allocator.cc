@@ -54,19 +54,35 @@ bool RegisterAllocator::CanAllocateRegistersFor(const HGraph& graph,
          !it.Done();
          it.Advance()) {
       HInstruction* current = it.Current();
-      if (current->NeedsEnvironment()) return false;
-      if (current->GetType() == Primitive::kPrimLong && instruction_set != kX86_64) return false;
-      if (current->GetType() == Primitive::kPrimFloat) return false;
-      if (current->GetType() == Primitive::kPrimDouble) return false;
+      if (current->NeedsEnvironment() && !SupportsEnvironmentOf(current)) return false;
+      if (Primitive::Is64BitType(current->GetType())
+          && instruction_set != kX86_64
+          && instruction_set != kArm64) {
+        return false;
+      }
+      // The x86 divisions take fixed registers, and ARM divides in the runtime: the
+      // allocator handles neither.
+      if ((current->IsDiv() || current->IsRem())
+          && !Primitive::IsFloatingPointType(current->GetType())
+          && instruction_set != kArm64) {
+        return false;
+      }
     }
   }
   return true;
 }
 
+bool RegisterAllocator::SupportsEnvironmentOf(HInstruction* instruction) {
+  DCHECK(instruction->NeedsEnvironment());
+  return instruction->IsNullCheck()
+      || instruction->IsBoundsCheck()
+      || instruction->IsDivZeroCheck();
+}
+
 static bool ShouldProcess(bool processing_core_registers, LiveInterval* interval) {
-  bool is_core_register = (interval->GetType() != Primitive::kPrimDouble)
-      && (interval->GetType() != Primitive::kPrimFloat);
-  return processing_core_registers == is_core_register;
+  // The code generators keep the bits of float and double values in core registers, and
+  // only use floating-point registers as scratch registers within an instruction.
+  return processing_core_registers;
 }
 
 void RegisterAllocator::AllocateRegisters() {
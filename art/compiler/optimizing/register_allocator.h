@@ -64,10 +64,18 @@ class RegisterAllocator {
                                 bool processing_core_registers,
                                 bool log_fatal_on_failure);
 
+  // Returns whether the register allocator supports all instructions of `graph`.
   static bool CanAllocateRegistersFor(const HGraph& graph, InstructionSet instruction_set);
+
+  // Returns whether the register allocator supports `instruction`, which needs an
+  // environment. Only the null, bounds and division by zero checks are supported: they only read
+  // their environment when they throw, and then leave the method, which has no catch handler.
+  static bool SupportsEnvironmentOf(HInstruction* instruction);
+
   static bool Supports(InstructionSet instruction_set) {
     return instruction_set == kX86
         || instruction_set == kArm
+        || instruction_set == kArm64
         || instruction_set == kX86_64
         || instruction_set == kThumb2;
   }
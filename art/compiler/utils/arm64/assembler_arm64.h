@@ -81,8 +81,10 @@ class Arm64Exception;
 
 class Arm64Assembler FINAL : public Assembler {
  public:
-  Arm64Assembler() : vixl_buf_(new byte[kBufferSizeArm64]),
-  vixl_masm_(new vixl::MacroAssembler(vixl_buf_, kBufferSizeArm64)) {}
+  // The buffer does not grow: `buffer_size` must be large enough for all the code emitted.
+  explicit Arm64Assembler(size_t buffer_size = kBufferSizeArm64)
+      : vixl_buf_(new byte[buffer_size]),
+        vixl_masm_(new vixl::MacroAssembler(vixl_buf_, buffer_size)) {}
 
   virtual ~Arm64Assembler() {
     delete vixl_masm_;
@@ -98,6 +100,10 @@ class Arm64Assembler FINAL : public Assembler {
   // Copy instructions out of assembly buffer into the given region of memory.
   void FinalizeInstructions(const MemoryRegion& region);
 
+  // The underlying VIXL assembler, for clients generating code directly, like the
+  // optimizing compiler.
+  vixl::MacroAssembler* GetVIXLAssembler() { return vixl_masm_; }
+
   // Emit code that will create an activation on the stack.
   void BuildFrame(size_t frame_size, ManagedRegister method_reg,
                   const std::vector<ManagedRegister>& callee_save_regs,
@@ -293,6 +293,7 @@ class X86_64Assembler FINAL : public Assembler {
   void movzxw(CpuRegister dst, const Address& src);
   void movsxw(CpuRegister dst, CpuRegister src);
   void movsxw(CpuRegister dst, const Address& src);
+  void movsxd(CpuRegister dst, CpuRegister src);
   void movw(CpuRegister dst, const Address& src);
   void movw(const Address& dst, CpuRegister src);
 
@@ -304,6 +305,8 @@ class X86_64Assembler FINAL : public Assembler {
 
   void movd(XmmRegister dst, CpuRegister src);
   void movd(CpuRegister dst, XmmRegister src);
+  void movd(XmmRegister dst, CpuRegister src, bool is64bit);
+  void movd(CpuRegister dst, XmmRegister src, bool is64bit);
 
   void addss(XmmRegister dst, XmmRegister src);
   void addss(XmmRegister dst, const Address& src);
@@ -328,7 +331,9 @@ class X86_64Assembler FINAL : public Assembler {
   void divsd(XmmRegister dst, const Address& src);
 
   void cvtsi2ss(XmmRegister dst, CpuRegister src);
+  void cvtsi2ss(XmmRegister dst, CpuRegister src, bool is64bit);
   void cvtsi2sd(XmmRegister dst, CpuRegister src);
+  void cvtsi2sd(XmmRegister dst, CpuRegister src, bool is64bit);
 
   void cvtss2si(CpuRegister dst, XmmRegister src);
   void cvtss2sd(XmmRegister dst, XmmRegister src);
@@ -337,7 +342,9 @@ class X86_64Assembler FINAL : public Assembler {
   void cvtsd2ss(XmmRegister dst, XmmRegister src);
 
   void cvttss2si(CpuRegister dst, XmmRegister src);
+  void cvttss2si(CpuRegister dst, XmmRegister src, bool is64bit);
   void cvttsd2si(CpuRegister dst, XmmRegister src);
+  void cvttsd2si(CpuRegister dst, XmmRegister src, bool is64bit);
 
   void cvtdq2pd(XmmRegister dst, XmmRegister src);
 
@@ -401,6 +408,7 @@ class X86_64Assembler FINAL : public Assembler {
   void orl(CpuRegister dst, CpuRegister src);
 
   void xorl(CpuRegister dst, CpuRegister src);
+  void xorl(CpuRegister dst, const Immediate& imm);
   void xorq(CpuRegister dst, const Immediate& imm);
   void xorq(CpuRegister dst, CpuRegister src);
 
@@ -433,6 +441,8 @@ class X86_64Assembler FINAL : public Assembler {
   void imull(CpuRegister reg);
   void imull(const Address& address);
 
+  void imulq(CpuRegister dst, CpuRegister src);
+
   void mull(CpuRegister reg);
   void mull(const Address& address);
 
@@ -446,6 +456,7 @@ class X86_64Assembler FINAL : public Assembler {
   void shrq(CpuRegister reg, const Immediate& imm);
 
   void negl(CpuRegister reg);
+  void negq(CpuRegister reg);
   void notl(CpuRegister reg);
 
   void enter(const Immediate& imm);
@@ -650,6 +661,8 @@ class X86_64Assembler FINAL : public Assembler {
   void EmitRex64(CpuRegister reg);
   void EmitRex64(CpuRegister dst, CpuRegister src);
   void EmitRex64(CpuRegister dst, const Operand& operand);
+  void EmitRex64(XmmRegister dst, CpuRegister src);
+  void EmitRex64(CpuRegister dst, XmmRegister src);
 
   // Emit a REX prefix to normalize byte registers plus necessary register bit encodings.
   void EmitOptionalByteRegNormalizingRex32(CpuRegister dst, CpuRegister src);
@@ -125,6 +125,33 @@ TEST_F(AssemblerX86_64Test, XorqImm) {
   DriverStr(RepeatRI(&x86_64::X86_64Assembler::xorq, 4U, "xorq ${imm}, %{reg}"), "xorqi");
 }
 
+TEST_F(AssemblerX86_64Test, ImulqRegs) {
+  DriverStr(RepeatRR(&x86_64::X86_64Assembler::imulq, "imulq %{reg2}, %{reg1}"), "imulq");
+}
+
+TEST_F(AssemblerX86_64Test, Negq) {
+  DriverStr(RepeatR(&x86_64::X86_64Assembler::negq, "negq %{reg}"), "negq");
+}
+
+TEST_F(AssemblerX86_64Test, Movsxd) {
+  GetAssembler()->movsxd(x86_64::CpuRegister(x86_64::RAX), x86_64::CpuRegister(x86_64::R9));
+  GetAssembler()->movsxd(x86_64::CpuRegister(x86_64::R11), x86_64::CpuRegister(x86_64::RCX));
+  const char* expected =
+    "movslq %R9d, %RAX\n"
+    "movslq %ECX, %R11\n";
+  DriverStr(expected, "movsxd");
+}
+
+TEST_F(AssemblerX86_64Test, XorlImm) {
+  GetAssembler()->xorl(x86_64::CpuRegister(x86_64::R10),
+                       x86_64::Immediate(static_cast<int32_t>(0x80000000)));
+  GetAssembler()->xorl(x86_64::CpuRegister(x86_64::RAX), x86_64::Immediate(1));
+  const char* expected =
+    "xorl $0x80000000, %R10d\n"
+    "xorl $1, %EAX\n";
+  DriverStr(expected, "xorli");
+}
+
 TEST_F(AssemblerX86_64Test, Movl) {
   GetAssembler()->movl(x86_64::CpuRegister(x86_64::R8), x86_64::CpuRegister(x86_64::R11));
   GetAssembler()->movl(x86_64::CpuRegister(x86_64::RAX), x86_64::CpuRegister(x86_64::R11));
@@ -151,6 +178,35 @@ TEST_F(AssemblerX86_64Test, Movw) {
   DriverStr(expected, "movw");
 }
 
+TEST_F(AssemblerX86_64Test, Movd) {
+  GetAssembler()->movd(x86_64::XmmRegister(x86_64::XMM0), x86_64::CpuRegister(x86_64::R11));
+  GetAssembler()->movd(x86_64::XmmRegister(x86_64::XMM9), x86_64::CpuRegister(x86_64::RAX),
+                       true);
+  GetAssembler()->movd(x86_64::CpuRegister(x86_64::R8), x86_64::XmmRegister(x86_64::XMM1),
+                       true);
+  const char* expected =
+    "movd %R11d, %xmm0\n"
+    "movq %RAX, %xmm9\n"
+    "movq %xmm1, %R8\n";
+  DriverStr(expected, "movd");
+}
+
+TEST_F(AssemblerX86_64Test, Cvt64) {
+  GetAssembler()->cvtsi2ss(x86_64::XmmRegister(x86_64::XMM0), x86_64::CpuRegister(x86_64::R9),
+                           true);
+  GetAssembler()->cvtsi2sd(x86_64::XmmRegister(x86_64::XMM10), x86_64::CpuRegister(x86_64::RCX),
+                           true);
+  GetAssembler()->cvttss2si(x86_64::CpuRegister(x86_64::R12), x86_64::XmmRegister(x86_64::XMM1),
+                            true);
+  GetAssembler()->cvttsd2si(x86_64::CpuRegister(x86_64::RDX), x86_64::XmmRegister(x86_64::XMM8),
+                            true);
+  const char* expected =
+    "cvtsi2ss %R9, %xmm0\n"
+    "cvtsi2sd %RCX, %xmm10\n"
+    "cvttss2si %xmm1, %R12\n"
+    "cvttsd2si %xmm8, %RDX\n";
+  DriverStr(expected, "cvt64");
+}
 
 std::string setcc_test_fn(x86_64::X86_64Assembler* assembler) {
   // From Condition
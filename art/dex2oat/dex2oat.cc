@@ -204,6 +204,18 @@ static void Usage(const char* fmt, ...) {
   UsageError("      Example: --num-dex-method=%d", CompilerOptions::kDefaultNumDexMethodsThreshold);
   UsageError("      Default: %d", CompilerOptions::kDefaultNumDexMethodsThreshold);
   UsageError("");
+  UsageError("  --inline-max-code-units=<code-unit-count>: size of the largest method the");
+  UsageError("      optimizing backend inlines.");
+  UsageError("      Example: --inline-max-code-units=%d",
+             CompilerOptions::kDefaultInlineMaxCodeUnits);
+  UsageError("      Default: %d", CompilerOptions::kDefaultInlineMaxCodeUnits);
+  UsageError("");
+  UsageError("  --inline-max-total-code-units=<code-unit-count>: total size of the methods the");
+  UsageError("      optimizing backend inlines into one method.");
+  UsageError("      Example: --inline-max-total-code-units=%d",
+             CompilerOptions::kDefaultInlineMaxTotalCodeUnits);
+  UsageError("      Default: %d", CompilerOptions::kDefaultInlineMaxTotalCodeUnits);
+  UsageError("");
   UsageError("  --host: used with Portable backend to link against host runtime libraries");
   UsageError("");
   UsageError("  --dump-timing: display a breakdown of where time was spent");
@@ -228,6 +240,8 @@ static void Usage(const char* fmt, ...) {
   UsageError("");
   UsageError("  --disable-passes=<pass-names>:  disable one or more passes separated by comma.");
   UsageError("      Example: --disable-passes=UseCount,BBOptimizations");
+  UsageError("      The optimizing backend passes are inliner, constant_folding,");
+  UsageError("      dead_code_elimination, null_check_elimination, GVN and BCE.");
   UsageError("");
   UsageError("  --swap-file=<file-name>:  specifies a file to use for swap.");
   UsageError("      Example: --swap-file=/data/tmp/swap.001");
@@ -878,6 +892,8 @@ static int dex2oat(int argc, char** argv) {
   int small_method_threshold = CompilerOptions::kDefaultSmallMethodThreshold;
   int tiny_method_threshold = CompilerOptions::kDefaultTinyMethodThreshold;
   int num_dex_methods_threshold = CompilerOptions::kDefaultNumDexMethodsThreshold;
+  int inline_max_code_units = CompilerOptions::kDefaultInlineMaxCodeUnits;
+  int inline_max_total_code_units = CompilerOptions::kDefaultInlineMaxTotalCodeUnits;
 
   // Take the default set of instruction features from the build.
   InstructionSetFeatures instruction_set_features =
@@ -893,6 +909,7 @@ static int dex2oat(int argc, char** argv) {
   bool dump_stats = false;
   bool dump_timing = false;
   bool dump_passes = false;
+  std::string disable_passes;
   bool include_patch_information = CompilerOptions::kDefaultIncludePatchInformation;
   bool include_debug_symbols = kIsDebugBuild;
   bool dump_slow_timing = kIsDebugBuild;
@@ -1049,6 +1066,23 @@ static int dex2oat(int argc, char** argv) {
       if (num_dex_methods_threshold < 0) {
         Usage("--num-dex-methods passed a negative value %s", num_dex_methods_threshold);
       }
+    } else if (option.starts_with("--inline-max-code-units=")) {
+      const char* code_units = option.substr(strlen("--inline-max-code-units=")).data();
+      if (!ParseInt(code_units, &inline_max_code_units)) {
+        Usage("Failed to parse --inline-max-code-units '%s' as an integer", code_units);
+      }
+      if (inline_max_code_units < 0) {
+        Usage("--inline-max-code-units passed a negative value %d", inline_max_code_units);
+      }
+    } else if (option.starts_with("--inline-max-total-code-units=")) {
+      const char* code_units = option.substr(strlen("--inline-max-total-code-units=")).data();
+      if (!ParseInt(code_units, &inline_max_total_code_units)) {
+        Usage("Failed to parse --inline-max-total-code-units '%s' as an integer", code_units);
+      }
+      if (inline_max_total_code_units < 0) {
+        Usage("--inline-max-total-code-units passed a negative value %d",
+              inline_max_total_code_units);
+      }
     } else if (option == "--host") {
       is_host = true;
     } else if (option == "--runtime-arg") {
@@ -1080,7 +1114,7 @@ static int dex2oat(int argc, char** argv) {
     } else if (option == "--print-pass-names") {
       PassDriverMEOpts::PrintPassNames();
     } else if (option.starts_with("--disable-passes=")) {
-      std::string disable_passes = option.substr(strlen("--disable-passes=")).data();
+      disable_passes = option.substr(strlen("--disable-passes=")).data();
       PassDriverMEOpts::CreateDefaultPassList(disable_passes);
     } else if (option.starts_with("--print-passes=")) {
       std::string print_passes = option.substr(strlen("--print-passes=")).data();
@@ -1277,6 +1311,9 @@ static int dex2oat(int argc, char** argv) {
                                                                               true;
 #endif
   ));  // NOLINT(whitespace/parens)
+  compiler_options->SetDisabledPasses(disable_passes);
+  compiler_options->SetInlineMaxCodeUnits(inline_max_code_units);
+  compiler_options->SetInlineMaxTotalCodeUnits(inline_max_total_code_units);
 
   // Done with usage checks, enable watchdog if requested
   WatchDog watch_dog(watch_dog_enabled);
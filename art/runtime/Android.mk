@@ -37,6 +37,7 @@ LIBART_COMMON_SRC_FILES := \
   base/unix_file/string_file.cc \
   check_jni.cc \
   class_linker.cc \
+  class_path_index.cc \
   common_throws.cc \
   debugger.cc \
   dex_file.cc \
@@ -73,6 +73,7 @@ enum LockLevel {
   kDexFileMethodInlinerLock,
   kDexFileToMethodInlinerMapLock,
   kMarkSweepMarkStackLock,
+  kInternTableShardLock,
   kTransactionLogLock,
   kInternTableLock,
   kOatFileSecondaryLookupLock,
@@ -84,6 +85,7 @@ enum LockLevel {
   kModifyLdtLock,
   kAllocatedThreadIdsLock,
   kMonitorPoolLock,
+  kBackgroundVerificationLock,
   kClassLinkerClassesLock,
   kBreakpointLock,
   kMonitorLock,
@@ -0,0 +1,177 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_BASE_WORK_STEALING_DEQUE_H_
+#define ART_RUNTIME_BASE_WORK_STEALING_DEQUE_H_
+
+#include <stdint.h>
+#include <vector>
+
+#include "atomic.h"
+#include "base/logging.h"
+#include "base/macros.h"
+#include "base/stl_util.h"
+#include "utils.h"
+
+namespace art {
+
+// A Chase-Lev work stealing deque of pointers, with the memory orderings of Le et al., "Correct and
+// Efficient Work-Stealing for Weak Memory Models" (PPoPP 2013). The owning thread pushes and pops
+// at the bottom without any locking or atomic read-modify-write, except when it takes the last
+// element. Any other thread may steal from the top with a single CAS.
+//
+// The ring buffer grows when full. Thieves may still be reading a smaller buffer when it is
+// replaced, so the old buffers are only freed with the deque.
+template <typename T>
+class WorkStealingDeque {
+ public:
+  enum StealResult {
+    kStealEmpty,    // There was nothing to steal.
+    kStealAborted,  // Lost a race with the owner or another thief, the deque may not be empty.
+    kStealSuccess,
+  };
+
+  explicit WorkStealingDeque(size_t initial_capacity = kDefaultCapacity)
+      : top_(0), bottom_(0), array_(new Array(initial_capacity)) {
+    CHECK(IsPowerOfTwo(initial_capacity)) << initial_capacity;
+  }
+
+  ~WorkStealingDeque() {
+    delete array_.LoadRelaxed();
+    STLDeleteElements(&retired_arrays_);
+  }
+
+  // Owner only.
+  void PushBottom(T* value) {
+    const intptr_t bottom = bottom_.LoadRelaxed();
+    const intptr_t top = top_.LoadRelaxed();
+    QuasiAtomic::ThreadFenceAcquire();
+    Array* array = array_.LoadRelaxed();
+    if (UNLIKELY(bottom - top > static_cast<intptr_t>(array->Capacity()) - 1)) {
+      array = Grow(array, top, bottom);
+    }
+    array->Put(bottom, value);
+    QuasiAtomic::ThreadFenceRelease();
+    bottom_.StoreRelaxed(bottom + 1);
+  }
+
+  // Owner only. Returns nullptr if the deque is empty.
+  T* PopBottom() {
+    const intptr_t bottom = bottom_.LoadRelaxed() - 1;
+    Array* array = array_.LoadRelaxed();
+    bottom_.StoreRelaxed(bottom);
+    QuasiAtomic::ThreadFenceSequentiallyConsistent();
+    intptr_t top = top_.LoadRelaxed();
+    if (top > bottom) {
+      // Empty.
+      bottom_.StoreRelaxed(bottom + 1);
+      return nullptr;
+    }
+    T* value = array->Get(bottom);
+    if (top == bottom) {
+      // Last element, race the thieves for it.
+      if (!top_.CompareExchangeStrongSequentiallyConsistent(top, top + 1)) {
+        value = nullptr;
+      }
+      bottom_.StoreRelaxed(bottom + 1);
+    }
+    return value;
+  }
+
+  // Any thread.
+  StealResult Steal(T** value) {
+    const intptr_t top = top_.LoadRelaxed();
+    QuasiAtomic::ThreadFenceSequentiallyConsistent();
+    const intptr_t bottom = bottom_.LoadRelaxed();
+    QuasiAtomic::ThreadFenceAcquire();
+    if (top >= bottom) {
+      return kStealEmpty;
+    }
+    Array* array = array_.LoadRelaxed();
+    QuasiAtomic::ThreadFenceAcquire();
+    T* stolen = array->Get(top);
+    if (!top_.CompareExchangeStrongSequentiallyConsistent(top, top + 1)) {
+      return kStealAborted;
+    }
+    *value = stolen;
+    return kStealSuccess;
+  }
+
+  // Any thread. Only exact when the deque is not being modified.
+  size_t SizeApprox() const {
+    const intptr_t size = bottom_.LoadRelaxed() - top_.LoadRelaxed();
+    return size > 0 ? static_cast<size_t>(size) : 0;
+  }
+
+  bool IsEmptyApprox() const {
+    return SizeApprox() == 0;
+  }
+
+ private:
+  static constexpr size_t kDefaultCapacity = 256;
+
+  class Array {
+   public:
+    explicit Array(size_t capacity)
+        : mask_(capacity - 1), elements_(new Atomic<T*>[capacity]) {}
+
+    ~Array() {
+      delete[] elements_;
+    }
+
+    size_t Capacity() const {
+      return mask_ + 1;
+    }
+
+    T* Get(intptr_t index) const {
+      return elements_[index & mask_].LoadRelaxed();
+    }
+
+    void Put(intptr_t index, T* value) {
+      elements_[index & mask_].StoreRelaxed(value);
+    }
+
+   private:
+    const size_t mask_;
+    Atomic<T*>* const elements_;
+
+    DISALLOW_COPY_AND_ASSIGN(Array);
+  };
+
+  Array* Grow(Array* array, intptr_t top, intptr_t bottom) {
+    Array* new_array = new Array(array->Capacity() * 2);
+    for (intptr_t i = top; i < bottom; ++i) {
+      new_array->Put(i, array->Get(i));
+    }
+    retired_arrays_.push_back(array);
+    array_.StoreRelease(new_array);
+    return new_array;
+  }
+
+  // Top and bottom only ever grow (modulo the owner's transient decrement of bottom in
+  // PopBottom), which is what makes the indices safe from ABA.
+  Atomic<intptr_t> top_;
+  Atomic<intptr_t> bottom_;
+  Atomic<Array*> array_;
+  // Owner only.
+  std::vector<Array*> retired_arrays_;
+
+  DISALLOW_COPY_AND_ASSIGN(WorkStealingDeque);
+};
+
+}  // namespace art
+
+#endif  // ART_RUNTIME_BASE_WORK_STEALING_DEQUE_H_
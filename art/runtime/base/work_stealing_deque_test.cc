@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "work_stealing_deque.h"
+
+#include <pthread.h>
+
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace art {
+
+typedef WorkStealingDeque<int> IntDeque;
+
+TEST(WorkStealingDeque, OwnerIsLifoThiefIsFifo) {
+  IntDeque deque(2);
+  int values[8];
+  for (int i = 0; i < 8; ++i) {
+    values[i] = i;
+    // Grows past the initial capacity.
+    deque.PushBottom(&values[i]);
+  }
+  EXPECT_EQ(8U, deque.SizeApprox());
+
+  int* stolen = nullptr;
+  ASSERT_EQ(IntDeque::kStealSuccess, deque.Steal(&stolen));
+  EXPECT_EQ(&values[0], stolen);
+  EXPECT_EQ(&values[7], deque.PopBottom());
+  EXPECT_EQ(6U, deque.SizeApprox());
+
+  for (int i = 6; i >= 1; --i) {
+    EXPECT_EQ(&values[i], deque.PopBottom());
+  }
+  EXPECT_TRUE(deque.IsEmptyApprox());
+  EXPECT_EQ(nullptr, deque.PopBottom());
+  EXPECT_EQ(IntDeque::kStealEmpty, deque.Steal(&stolen));
+}
+
+struct StealArgs {
+  IntDeque* deque;
+  Atomic<bool>* done;
+  Atomic<int64_t>* sum;
+  Atomic<int64_t>* count;
+};
+
+static void* Thief(void* arg) {
+  StealArgs* args = reinterpret_cast<StealArgs*>(arg);
+  while (!args->done->LoadSequentiallyConsistent()) {
+    int* value;
+    if (args->deque->Steal(&value) == IntDeque::kStealSuccess) {
+      args->sum->FetchAndAddSequentiallyConsistent(*value);
+      args->count->FetchAndAddSequentiallyConsistent(1);
+    }
+  }
+  return nullptr;
+}
+
+// Every element is taken exactly once, by either the owner or one of the thieves.
+TEST(WorkStealingDeque, ConcurrentSteal) {
+  static const int kThieves = 4;
+  static const int kValues = 100000;
+  IntDeque deque(4);
+  std::vector<int> values(kValues);
+  Atomic<bool> done(false);
+  Atomic<int64_t> sum(0);
+  Atomic<int64_t> count(0);
+  StealArgs args = { &deque, &done, &sum, &count };
+  pthread_t thieves[kThieves];
+  for (int i = 0; i < kThieves; ++i) {
+    ASSERT_EQ(0, pthread_create(&thieves[i], nullptr, Thief, &args));
+  }
+
+  for (int i = 0; i < kValues; ++i) {
+    values[i] = i;
+    deque.PushBottom(&values[i]);
+    if (i % 3 == 0) {
+      int* value = deque.PopBottom();
+      if (value != nullptr) {
+        sum.FetchAndAddSequentiallyConsistent(*value);
+        count.FetchAndAddSequentiallyConsistent(1);
+      }
+    }
+  }
+  int* value;
+  while ((value = deque.PopBottom()) != nullptr) {
+    sum.FetchAndAddSequentiallyConsistent(*value);
+    count.FetchAndAddSequentiallyConsistent(1);
+  }
+  // The owner may have lost the last element to a thief which hasn't counted it yet.
+  while (count.LoadSequentiallyConsistent() != kValues) {
+    sched_yield();
+  }
+  done.StoreSequentiallyConsistent(true);
+  for (int i = 0; i < kThieves; ++i) {
+    ASSERT_EQ(0, pthread_join(thieves[i], nullptr));
+  }
+  EXPECT_EQ(static_cast<int64_t>(kValues) * (kValues - 1) / 2, sum.LoadSequentiallyConsistent());
+}
+
+}  // namespace art
@@ -43,6 +43,7 @@
 #include "handle_scope.h"
 #include "intern_table.h"
 #include "interpreter/interpreter.h"
+#include "jni_internal.h"
 #include "leb128.h"
 #include "method_helper-inl.h"
 #include "oat.h"
@@ -68,6 +69,7 @@
 #include "scoped_thread_state_change.h"
 #include "handle_scope-inl.h"
 #include "thread.h"
+#include "thread_pool.h"
 #include "utils.h"
 #include "verifier/method_verifier.h"
 #include "well_known_classes.h"
@@ -169,7 +171,19 @@ const char* ClassLinker::class_roots_descriptors_[] = {
 
 ClassLinker::ClassLinker(InternTable* intern_table)
     // dex_lock_ is recursive as it may be used in stack dumping.
-    : dex_lock_("ClassLinker dex lock", kDefaultMutexLevel),
+    : class_path_index_lock_("ClassLinker class path index lock", kDefaultMutexLevel),
+      boot_class_path_index_(nullptr),
+      class_path_indexes_built_(0),
+      class_path_index_build_ns_(0),
+      class_path_index_lookups_(0),
+      dex_file_probes_saved_(0),
+      background_verification_lock_("ClassLinker background verification lock",
+                                    kBackgroundVerificationLock),
+      main_thread_verification_ns_(0),
+      main_thread_verified_classes_(0),
+      background_verification_ns_(0),
+      background_verified_classes_(0),
+      dex_lock_("ClassLinker dex lock", kDefaultMutexLevel),
       dex_cache_image_class_lookup_required_(false),
       failed_dex_cache_class_lookups_(0),
       class_roots_(nullptr),
@@ -1879,6 +1893,9 @@ ClassLinker::~ClassLinker() {
   mirror::ShortArray::ResetArrayClass();
   mirror::Throwable::ResetClass();
   mirror::StackTraceElement::ResetClass();
+  delete boot_class_path_index_.LoadRelaxed();
+  STLDeleteElements(&retired_class_path_indexes_);
+  STLDeleteValues(&class_path_indexes_);
   STLDeleteElements(&boot_class_path_);
   STLDeleteElements(&oat_files_);
 }
@@ -2014,18 +2031,243 @@ mirror::Class* ClassLinker::EnsureResolved(Thread* self, const char* descriptor,
   return klass;
 }
 
-typedef std::pair<const DexFile*, const DexFile::ClassDef*> ClassPathEntry;
+ClassPathIndex* ClassLinker::BuildClassPathIndex(const std::vector<const DexFile*>& class_path) {
+  const uint64_t start_ns = NanoTime();
+  ClassPathIndex* index = new ClassPathIndex(class_path);
+  const uint64_t duration_ns = NanoTime() - start_ns;
+  ++class_path_indexes_built_;
+  class_path_index_build_ns_ += duration_ns;
+  VLOG(class_linker) << "Indexed " << index->NumClasses() << " classes of "
+                     << index->NumDexFiles() << " dex files in " << PrettyDuration(duration_ns);
+  return index;
+}
+
+ClassPathIndex* ClassLinker::GetBootClassPathIndex(Thread* self) {
+  WriterMutexLock mu(self, class_path_index_lock_);
+  ClassPathIndex* index = boot_class_path_index_.LoadRelaxed();
+  // Rebuild the index if dex files have been appended to the boot class path since.
+  if (index == nullptr || index->NumDexFiles() != boot_class_path_.size()) {
+    if (index != nullptr) {
+      retired_class_path_indexes_.push_back(index);
+    }
+    index = BuildClassPathIndex(boot_class_path_);
+    boot_class_path_index_.StoreSequentiallyConsistent(index);
+  }
+  return index;
+}
 
 // Search a collection of DexFiles for a descriptor
-ClassPathEntry FindInClassPath(const char* descriptor,
-                               size_t hash, const std::vector<const DexFile*>& class_path) {
-  for (const DexFile* dex_file : class_path) {
-    const DexFile::ClassDef* dex_class_def = dex_file->FindClassDef(descriptor, hash);
-    if (dex_class_def != nullptr) {
-      return ClassPathEntry(dex_file, dex_class_def);
+ClassPathEntry ClassLinker::FindInClassPath(const char* descriptor, size_t hash,
+                                            const std::vector<const DexFile*>& class_path) {
+  if (class_path.size() < kMinDexFilesForClassPathIndex) {
+    for (const DexFile* dex_file : class_path) {
+      const DexFile::ClassDef* dex_class_def = dex_file->FindClassDef(descriptor, hash);
+      if (dex_class_def != nullptr) {
+        return ClassPathEntry(dex_file, dex_class_def);
+      }
+    }
+    return ClassPathEntry(nullptr, nullptr);
+  }
+  Thread* self = Thread::Current();
+  ClassPathEntry entry(nullptr, nullptr);
+  size_t probes = 0;
+  if (&class_path == &boot_class_path_) {
+    ClassPathIndex* index = boot_class_path_index_.LoadSequentiallyConsistent();
+    if (UNLIKELY(index == nullptr || index->NumDexFiles() != class_path.size())) {
+      index = GetBootClassPathIndex(self);
+    }
+    entry = index->Find(descriptor, hash, &probes);
+  } else {
+    bool found = false;
+    {
+      ReaderMutexLock mu(self, class_path_index_lock_);
+      auto it = class_path_indexes_.find(&class_path);
+      if (it != class_path_indexes_.end() && it->second->NumDexFiles() == class_path.size()) {
+        entry = it->second->Find(descriptor, hash, &probes);
+        found = true;
+      }
+    }
+    if (!found) {
+      WriterMutexLock mu(self, class_path_index_lock_);
+      ClassPathIndex*& index = class_path_indexes_[&class_path];
+      if (index == nullptr || index->NumDexFiles() != class_path.size()) {
+        delete index;
+        index = BuildClassPathIndex(class_path);
+      }
+      entry = index->Find(descriptor, hash, &probes);
+    }
+  }
+  class_path_index_lookups_.FetchAndAddSequentiallyConsistent(1);
+  dex_file_probes_saved_.FetchAndAddSequentiallyConsistent(probes - 1);
+  return entry;
+}
+
+void ClassLinker::ForgetClassPathIndex(const std::vector<const DexFile*>* class_path) {
+  WriterMutexLock mu(Thread::Current(), class_path_index_lock_);
+  auto it = class_path_indexes_.find(class_path);
+  if (it != class_path_indexes_.end()) {
+    delete it->second;
+    class_path_indexes_.erase(it);
+  }
+}
+
+// A share of the classes of a DexFile to verify in the background. The tasks of a DexFile share a
+// weak global reference to its class loader, so that they don't keep it alive, which the last
+// task to finish deletes.
+class BackgroundVerificationTask : public Task {
+ public:
+  struct Job {
+    jweak class_loader;
+    const DexFile* dex_file;
+    Atomic<size_t> tasks_left;
+  };
+
+  BackgroundVerificationTask(Job* job, std::vector<uint16_t>&& class_def_indexes)
+      : job_(job), class_def_indexes_(std::move(class_def_indexes)) {}
+
+  void Run(Thread* self) OVERRIDE {
+    ScopedObjectAccess soa(self);
+    ClassLinker* class_linker = Runtime::Current()->GetClassLinker();
+    for (uint16_t class_def_index : class_def_indexes_) {
+      if (Runtime::Current()->IsShuttingDown(self)) {
+        break;
+      }
+      StackHandleScope<1> hs(self);
+      Handle<mirror::ClassLoader> class_loader(
+          hs.NewHandle(soa.Decode<mirror::ClassLoader*>(job_->class_loader)));
+      if (class_loader.Get() == nullptr) {
+        // The app is done with the class loader.
+        break;
+      }
+      class_linker->VerifyClassInBackground(soa, self, class_loader, *job_->dex_file,
+                                            class_def_index);
+    }
+  }
+
+  void Finalize() OVERRIDE {
+    if (job_->tasks_left.FetchAndSubSequentiallyConsistent(1) == 1) {
+      Thread* self = Thread::Current();
+      Runtime::Current()->GetJavaVM()->DeleteWeakGlobalRef(self, job_->class_loader);
+      delete job_;
+    }
+    delete this;
+  }
+
+ private:
+  Job* const job_;
+  const std::vector<uint16_t> class_def_indexes_;
+
+  DISALLOW_COPY_AND_ASSIGN(BackgroundVerificationTask);
+};
+
+void ClassLinker::ScheduleBackgroundVerification(Thread* self,
+                                                 Handle<mirror::ClassLoader> class_loader,
+                                                 const DexFile& dex_file) {
+  Runtime* const runtime = Runtime::Current();
+  {
+    MutexLock mu(self, background_verification_lock_);
+    // There is no pool in the zygote, in the compiler, or without background verification.
+    if (background_verification_thread_pool_.get() == nullptr ||
+        !background_verified_dex_files_.insert(&dex_file).second) {
+      return;
+    }
+  }
+  // Leave out the classes the oat file has as verified, VerifyClass would only check them against
+  // the oat file. As in VerifyClassUsingOatFile, that is only done with an image.
+  std::vector<uint16_t> class_def_indexes;
+  const OatFile::OatDexFile* oat_dex_file = nullptr;
+  if (runtime->GetHeap()->HasImageSpace()) {
+    oat_dex_file = FindOpenedOatDexFileForDexFile(dex_file);
+  }
+  for (size_t i = 0; i < dex_file.NumClassDefs(); ++i) {
+    if (oat_dex_file != nullptr) {
+      mirror::Class::Status status = oat_dex_file->GetOatClass(i).GetStatus();
+      if (status == mirror::Class::kStatusVerified ||
+          status == mirror::Class::kStatusInitialized ||
+          status == mirror::Class::kStatusError) {
+        continue;
+      }
     }
+    class_def_indexes.push_back(static_cast<uint16_t>(i));
+  }
+  if (class_def_indexes.empty()) {
+    return;
+  }
+  VLOG(class_linker) << "Verifying " << class_def_indexes.size() << " classes of "
+      << dex_file.GetLocation() << " in the background";
+
+  // Small tasks, so that the threads share the work of large DexFiles evenly.
+  static constexpr size_t kClassesPerTask = 64;
+  const size_t num_tasks = (class_def_indexes.size() + kClassesPerTask - 1) / kClassesPerTask;
+  BackgroundVerificationTask::Job* job = new BackgroundVerificationTask::Job;
+  job->class_loader = runtime->GetJavaVM()->AddWeakGlobalReference(self, class_loader.Get());
+  job->dex_file = &dex_file;
+  job->tasks_left.StoreRelaxed(num_tasks);
+  MutexLock mu(self, background_verification_lock_);
+  for (size_t begin = 0; begin < class_def_indexes.size(); begin += kClassesPerTask) {
+    const size_t end = std::min(begin + kClassesPerTask, class_def_indexes.size());
+    std::vector<uint16_t> chunk(class_def_indexes.begin() + begin, class_def_indexes.begin() + end);
+    background_verification_thread_pool_->AddTask(
+        self, new BackgroundVerificationTask(job, std::move(chunk)));
+  }
+}
+
+void ClassLinker::VerifyClassInBackground(ScopedObjectAccessAlreadyRunnable& soa, Thread* self,
+                                          Handle<mirror::ClassLoader> class_loader,
+                                          const DexFile& dex_file, uint16_t class_def_index) {
+  const DexFile::ClassDef& class_def = dex_file.GetClassDef(class_def_index);
+  const char* descriptor = dex_file.GetClassDescriptor(class_def);
+  const size_t hash = ComputeModifiedUtf8Hash(descriptor);
+  // Verifying a class that hasn't been loaded yet loads it, as its initialization would.
+  mirror::Class* klass = LookupClass(descriptor, hash, class_loader.Get());
+  if (klass != nullptr) {
+    klass = EnsureResolved(self, descriptor, klass);
+  } else {
+    klass = FindClassInPathClassLoader(soa, self, descriptor, hash, class_loader);
+  }
+  if (klass == nullptr) {
+    self->ClearException();
+    return;
+  }
+  StackHandleScope<1> hs(self);
+  Handle<mirror::Class> h_klass(hs.NewHandle(klass));
+  // The class loader may have found a definition of the descriptor in an earlier DexFile.
+  if (h_klass->GetDexCache()->GetDexFile() != &dex_file || h_klass->IsVerified() ||
+      h_klass->IsErroneous()) {
+    return;
+  }
+  const uint64_t start_ns = NanoTime();
+  VerifyClass(h_klass);
+  self->ClearException();
+  background_verification_ns_.FetchAndAddSequentiallyConsistent(NanoTime() - start_ns);
+  background_verified_classes_.FetchAndAddSequentiallyConsistent(1);
+}
+
+void ClassLinker::CreateBackgroundVerificationThreadPool() {
+  Runtime* const runtime = Runtime::Current();
+  const size_t num_threads = runtime->GetBackgroundVerificationThreads();
+  // The compiler never gets here, it doesn't start its runtime.
+  if (num_threads == 0 || runtime->IsZygote() || !runtime->IsVerificationEnabled()) {
+    return;
   }
-  return ClassPathEntry(nullptr, nullptr);
+  Thread* self = Thread::Current();
+  // Creating the thread pool waits for its threads to attach.
+  ScopedThreadStateChange tsc(self, kNative);
+  MutexLock mu(self, background_verification_lock_);
+  if (background_verification_thread_pool_.get() == nullptr) {
+    background_verification_thread_pool_.reset(
+        new ThreadPool("Background verification thread pool", num_threads));
+    background_verification_thread_pool_->StartWorkers(self);
+  }
+}
+
+void ClassLinker::DeleteBackgroundVerificationThreadPool() {
+  std::unique_ptr<ThreadPool> thread_pool;
+  {
+    MutexLock mu(Thread::Current(), background_verification_lock_);
+    thread_pool.swap(background_verification_thread_pool_);
+  }
+  // Tasks which haven't started are leaked, as with other thread pools deleted at shutdown.
 }
 
 mirror::Class* ClassLinker::FindClassInPathClassLoader(ScopedObjectAccessAlreadyRunnable& soa,
@@ -2092,19 +2334,19 @@ mirror::Class* ClassLinker::FindClassInPathClassLoader(ScopedObjectAccessAlready
               LOG(WARNING) << "Null DexFile::mCookie for " << descriptor;
               break;
             }
-            for (const DexFile* dex_file : *dex_files) {
-              const DexFile::ClassDef* dex_class_def = dex_file->FindClassDef(descriptor, hash);
-              if (dex_class_def != nullptr) {
-                RegisterDexFile(*dex_file);
-                mirror::Class* klass = DefineClass(self, descriptor, hash, class_loader, *dex_file,
-                                                   *dex_class_def);
-                if (klass == nullptr) {
-                  CHECK(self->IsExceptionPending()) << descriptor;
-                  self->ClearException();
-                  return nullptr;
-                }
-                return klass;
+            // Multidex files have several dex files per element.
+            ClassPathEntry pair = FindInClassPath(descriptor, hash, *dex_files);
+            if (pair.second != nullptr) {
+              RegisterDexFile(*pair.first);
+              ScheduleBackgroundVerification(self, class_loader, *pair.first);
+              mirror::Class* klass = DefineClass(self, descriptor, hash, class_loader, *pair.first,
+                                                 *pair.second);
+              if (klass == nullptr) {
+                CHECK(self->IsExceptionPending()) << descriptor;
+                self->ClearException();
+                return nullptr;
               }
+              return klass;
             }
           }
         }
@@ -3586,9 +3828,14 @@ void ClassLinker::VerifyClass(Handle<mirror::Class> klass) {
   verifier::MethodVerifier::FailureKind verifier_failure = verifier::MethodVerifier::kNoFailure;
   std::string error_msg;
   if (!preverified) {
+    const uint64_t start_ns = NanoTime();
     verifier_failure = verifier::MethodVerifier::VerifyClass(klass.Get(),
                                                              Runtime::Current()->IsCompiler(),
                                                              &error_msg);
+    if (self->GetTid() == getpid()) {
+      main_thread_verification_ns_.FetchAndAddSequentiallyConsistent(NanoTime() - start_ns);
+      main_thread_verified_classes_.FetchAndAddSequentiallyConsistent(1);
+    }
   }
   if (preverified || verifier_failure != verifier::MethodVerifier::kHardFailure) {
     if (!preverified && verifier_failure != verifier::MethodVerifier::kNoFailure) {
@@ -5927,7 +6174,19 @@ void ClassLinker::DumpForSigQuit(std::ostream& os) {
   if (dex_cache_image_class_lookup_required_) {
     MoveImageClassesToClassTable();
   }
-  ReaderMutexLock mu(Thread::Current(), *Locks::classlinker_classes_lock_);
+  Thread* self = Thread::Current();
+  {
+    ReaderMutexLock mu(self, class_path_index_lock_);
+    os << "Class path indexes=" << class_path_indexes_built_ << " built in "
+       << PrettyDuration(class_path_index_build_ns_) << " lookups="
+       << class_path_index_lookups_.LoadRelaxed() << " dex file probes saved="
+       << dex_file_probes_saved_.LoadRelaxed() << "\n";
+  }
+  os << "Main thread verification=" << main_thread_verified_classes_.LoadRelaxed()
+     << " classes in " << PrettyDuration(main_thread_verification_ns_.LoadRelaxed())
+     << " background verification=" << background_verified_classes_.LoadRelaxed()
+     << " classes in " << PrettyDuration(background_verification_ns_.LoadRelaxed()) << "\n";
+  ReaderMutexLock mu(self, *Locks::classlinker_classes_lock_);
   os << "Zygote loaded classes=" << pre_zygote_class_table_.Size() << " post zygote classes="
      << class_table_.Size() << "\n";
 }
@@ -17,7 +17,10 @@
 #ifndef ART_RUNTIME_CLASS_LINKER_H_
 #define ART_RUNTIME_CLASS_LINKER_H_
 
+#include <memory>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
@@ -25,6 +28,7 @@
 #include "base/hash_set.h"
 #include "base/macros.h"
 #include "base/mutex.h"
+#include "class_path_index.h"
 #include "dex_file.h"
 #include "gc_root.h"
 #include "gtest/gtest.h"
@@ -53,6 +57,7 @@ template<class T> class ObjectLock;
 class Runtime;
 class ScopedObjectAccessAlreadyRunnable;
 template<size_t kNumReferences> class PACKED(4) StackHandleScope;
+class ThreadPool;
 
 typedef bool (ClassVisitor)(mirror::Class* c, void* arg);
 
@@ -83,6 +88,18 @@ class ClassLinker {
                                             Handle<mirror::ClassLoader> class_loader)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
+  // Drops the index of a class path, which has to be done before the class path is freed.
+  void ForgetClassPathIndex(const std::vector<const DexFile*>* class_path)
+      LOCKS_EXCLUDED(class_path_index_lock_);
+
+  // Starts the threads that verify app classes in the background, if the runtime was started with
+  // any. Called once the runtime is no longer the zygote.
+  void CreateBackgroundVerificationThreadPool() LOCKS_EXCLUDED(background_verification_lock_);
+
+  // Stops verifying classes in the background, finishing the classes being verified. Called at
+  // shutdown, before the threads are torn down.
+  void DeleteBackgroundVerificationThreadPool() LOCKS_EXCLUDED(background_verification_lock_);
+
   // Finds a class by its descriptor using the "system" class loader, ie by searching the
   // boot_class_path_.
   mirror::Class* FindSystemClass(Thread* self, const char* descriptor)
@@ -460,6 +477,28 @@ class ClassLinker {
                                   Handle<mirror::ClassLoader> class_loader)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
+  // Search a class path for a descriptor. Class paths of several DexFiles are searched through a
+  // ClassPathIndex, built on first use.
+  ClassPathEntry FindInClassPath(const char* descriptor, size_t hash,
+                                 const std::vector<const DexFile*>& class_path)
+      LOCKS_EXCLUDED(class_path_index_lock_);
+  ClassPathIndex* GetBootClassPathIndex(Thread* self) LOCKS_EXCLUDED(class_path_index_lock_);
+  ClassPathIndex* BuildClassPathIndex(const std::vector<const DexFile*>& class_path)
+      EXCLUSIVE_LOCKS_REQUIRED(class_path_index_lock_);
+
+  // Verifies the classes of an app DexFile that the oat file doesn't have as verified on the
+  // background verification thread pool, ahead of their initialization. Only the first call for
+  // a DexFile schedules anything.
+  void ScheduleBackgroundVerification(Thread* self, Handle<mirror::ClassLoader> class_loader,
+                                      const DexFile& dex_file)
+      LOCKS_EXCLUDED(background_verification_lock_)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  // Verifies a class of the DexFile if it is defined by the class loader and isn't verified yet.
+  void VerifyClassInBackground(ScopedObjectAccessAlreadyRunnable& soa, Thread* self,
+                               Handle<mirror::ClassLoader> class_loader, const DexFile& dex_file,
+                               uint16_t class_def_index)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
   void AppendToBootClassPath(const DexFile& dex_file)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
   void AppendToBootClassPath(const DexFile& dex_file, Handle<mirror::DexCache> dex_cache)
@@ -694,6 +733,36 @@ class ClassLinker {
 
   std::vector<const DexFile*> boot_class_path_;
 
+  // Indexes of the class paths of at least kMinDexFilesForClassPathIndex DexFiles, keyed by the
+  // class path. The boot class path index is read without locking, so the indexes it replaces are
+  // only freed at shutdown.
+  static constexpr size_t kMinDexFilesForClassPathIndex = 2;
+  ReaderWriterMutex class_path_index_lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
+  Atomic<ClassPathIndex*> boot_class_path_index_;
+  std::unordered_map<const std::vector<const DexFile*>*, ClassPathIndex*> class_path_indexes_
+      GUARDED_BY(class_path_index_lock_);
+  std::vector<ClassPathIndex*> retired_class_path_indexes_ GUARDED_BY(class_path_index_lock_);
+  // Class path index statistics, for DumpForSigQuit.
+  uint32_t class_path_indexes_built_ GUARDED_BY(class_path_index_lock_);
+  uint64_t class_path_index_build_ns_ GUARDED_BY(class_path_index_lock_);
+  Atomic<uint64_t> class_path_index_lookups_;
+  // DexFiles that searching the class paths in order would have probed, less the lookups.
+  Atomic<uint64_t> dex_file_probes_saved_;
+
+  // Classes are verified in the background with Runtime::GetBackgroundVerificationThreads()
+  // threads, which are started by CreateBackgroundVerificationThreadPool.
+  Mutex background_verification_lock_;
+  std::unique_ptr<ThreadPool> background_verification_thread_pool_
+      GUARDED_BY(background_verification_lock_);
+  std::unordered_set<const DexFile*> background_verified_dex_files_
+      GUARDED_BY(background_verification_lock_);
+  // Time spent in the verifier, and the classes it verified, on the main thread and on the
+  // background verification threads, for DumpForSigQuit.
+  Atomic<uint64_t> main_thread_verification_ns_;
+  Atomic<uint32_t> main_thread_verified_classes_;
+  Atomic<uint64_t> background_verification_ns_;
+  Atomic<uint32_t> background_verified_classes_;
+
   mutable ReaderWriterMutex dex_lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
   std::vector<size_t> new_dex_cache_roots_ GUARDED_BY(dex_lock_);;
   std::vector<GcRoot<mirror::DexCache>> dex_caches_ GUARDED_BY(dex_lock_);
@@ -831,6 +900,8 @@ class ClassLinker {
   friend class ElfPatcher;  // for FindOpenedOatFileForDexFile & FindOpenedOatFileFromOatLocation
   friend class NoDex2OatTest;  // for FindOpenedOatFileForDexFile
   friend class NoPatchoatTest;  // for FindOpenedOatFileForDexFile
+  friend class BackgroundVerificationTask;  // for VerifyClassInBackground
+  friend class BackgroundVerificationTest;  // for ScheduleBackgroundVerification
   FRIEND_TEST(ClassLinkerTest, ClassRootDescriptors);
   FRIEND_TEST(mirror::DexCacheTest, Open);
   FRIEND_TEST(ExceptionTest, FindExceptionHandler);
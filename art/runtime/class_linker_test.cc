@@ -39,6 +39,7 @@
 #include "handle_scope-inl.h"
 #include "scoped_thread_state_change.h"
 #include "thread-inl.h"
+#include "thread_pool.h"
 
 namespace art {
 
@@ -1155,4 +1156,58 @@ TEST_F(ClassLinkerTest, IsBootStrapClassLoaded) {
   EXPECT_FALSE(statics.Get()->IsBootStrapClassLoaded());
 }
 
+class BackgroundVerificationTest : public ClassLinkerTest {
+ protected:
+  void SetUpRuntimeOptions(RuntimeOptions* options) OVERRIDE {
+    options->push_back(std::make_pair("-Xbackground-verification-threads:2", nullptr));
+  }
+
+  void ScheduleBackgroundVerification(Thread* self, Handle<mirror::ClassLoader> class_loader,
+                                      const DexFile& dex_file)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+    class_linker_->ScheduleBackgroundVerification(self, class_loader, dex_file);
+  }
+
+  void WaitForBackgroundVerification(Thread* self) {
+    ThreadPool* thread_pool;
+    {
+      MutexLock mu(self, class_linker_->background_verification_lock_);
+      thread_pool = class_linker_->background_verification_thread_pool_.get();
+    }
+    ASSERT_TRUE(thread_pool != nullptr);
+    thread_pool->Wait(self, false, false);
+  }
+
+  uint32_t BackgroundVerifiedClasses() {
+    return class_linker_->background_verified_classes_.LoadSequentiallyConsistent();
+  }
+};
+
+TEST_F(BackgroundVerificationTest, VerifiesAppClasses) {
+  // Normally, the thread pool is created as the runtime starts.
+  class_linker_->CreateBackgroundVerificationThreadPool();
+
+  Thread* self = Thread::Current();
+  ScopedObjectAccess soa(self);
+  StackHandleScope<2> hs(soa.Self());
+  Handle<mirror::ClassLoader> class_loader(
+      hs.NewHandle(soa.Decode<mirror::ClassLoader*>(LoadDex("Statics"))));
+  Handle<mirror::Class> statics(
+      hs.NewHandle(class_linker_->FindClass(soa.Self(), "LStatics;", class_loader)));
+  ASSERT_TRUE(statics.Get() != nullptr);
+  EXPECT_FALSE(statics->IsVerified());
+
+  const DexFile& dex_file = *statics->GetDexCache()->GetDexFile();
+  ScheduleBackgroundVerification(soa.Self(), class_loader, dex_file);
+  // Only the first request for a DexFile schedules anything.
+  ScheduleBackgroundVerification(soa.Self(), class_loader, dex_file);
+  {
+    ScopedThreadStateChange tsc(soa.Self(), kNative);
+    WaitForBackgroundVerification(soa.Self());
+  }
+
+  EXPECT_TRUE(statics->IsVerified());
+  EXPECT_EQ(1U, BackgroundVerifiedClasses());
+}
+
 }  // namespace art
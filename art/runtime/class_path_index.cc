@@ -0,0 +1,51 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "class_path_index.h"
+
+#include "dex_file-inl.h"
+
+namespace art {
+
+ClassPathIndex::ClassPathIndex(const std::vector<const DexFile*>& class_path)
+    : class_path_(class_path) {
+  for (size_t i = 0; i < class_path_.size(); ++i) {
+    const DexFile* dex_file = class_path_[i];
+    for (size_t j = 0; j < dex_file->NumClassDefs(); ++j) {
+      const DexFile::ClassDef& class_def = dex_file->GetClassDef(j);
+      const char* descriptor = dex_file->GetClassDescriptor(class_def);
+      const size_t hash = ComputeModifiedUtf8Hash(descriptor);
+      // Classes defined again further down the class path are never loaded from there.
+      if (index_.FindWithHash(descriptor, hash) == index_.end()) {
+        index_.InsertWithHash(std::make_pair(descriptor, Location(&class_def, i)), hash);
+      }
+    }
+  }
+}
+
+ClassPathEntry ClassPathIndex::Find(const char* descriptor, size_t hash, size_t* probes) {
+  DCHECK_EQ(ComputeModifiedUtf8Hash(descriptor), hash);
+  auto it = index_.FindWithHash(descriptor, hash);
+  if (it == index_.end()) {
+    *probes = class_path_.size();
+    return ClassPathEntry(nullptr, nullptr);
+  }
+  const Location& location = it->second;
+  *probes = location.second + 1;
+  return ClassPathEntry(class_path_[location.second], location.first);
+}
+
+}  // namespace art
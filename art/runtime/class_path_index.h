@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_CLASS_PATH_INDEX_H_
+#define ART_RUNTIME_CLASS_PATH_INDEX_H_
+
+#include <utility>
+#include <vector>
+
+#include "base/hash_map.h"
+#include "base/macros.h"
+#include "dex_file.h"
+#include "utf.h"
+
+namespace art {
+
+typedef std::pair<const DexFile*, const DexFile::ClassDef*> ClassPathEntry;
+
+// Maps the descriptor of every class defined in a class path to the first DexFile defining it, so
+// that a class is found with a single hash lookup rather than one per DexFile of the class path.
+// The index is immutable once built and may be searched by several threads at once.
+class ClassPathIndex {
+ public:
+  explicit ClassPathIndex(const std::vector<const DexFile*>& class_path);
+
+  // Returns the DexFile and ClassDef defining the class, or a pair of nullptrs. Sets "probes" to
+  // the number of DexFiles searching the class path in order would have taken.
+  ClassPathEntry Find(const char* descriptor, size_t hash, size_t* probes);
+
+  // The size of the class path when it was indexed. Class paths only ever grow by appending.
+  size_t NumDexFiles() const {
+    return class_path_.size();
+  }
+
+  size_t NumClasses() const {
+    return index_.Size();
+  }
+
+ private:
+  // The class def and the position of its DexFile in the class path.
+  typedef std::pair<const DexFile::ClassDef*, uint32_t> Location;
+
+  struct EmptyFn {
+    void MakeEmpty(std::pair<const char*, Location>& pair) const {
+      pair.first = nullptr;
+      pair.second = Location(nullptr, 0);
+    }
+    bool IsEmpty(const std::pair<const char*, Location>& pair) const {
+      return pair.first == nullptr;
+    }
+  };
+  struct DescriptorHashCmp {
+    size_t operator()(const char* descriptor) const {
+      return ComputeModifiedUtf8Hash(descriptor);
+    }
+    bool operator()(const char* a, const char* b) const {
+      return CompareModifiedUtf8ToModifiedUtf8AsUtf16CodePointValues(a, b) == 0;
+    }
+  };
+  typedef HashMap<const char*, Location, EmptyFn, DescriptorHashCmp, DescriptorHashCmp> Index;
+
+  const std::vector<const DexFile*> class_path_;
+  Index index_;
+
+  DISALLOW_COPY_AND_ASSIGN(ClassPathIndex);
+};
+
+}  // namespace art
+
+#endif  // ART_RUNTIME_CLASS_PATH_INDEX_H_
@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "class_path_index.h"
+
+#include <vector>
+
+#include "common_runtime_test.h"
+#include "scoped_thread_state_change.h"
+
+namespace art {
+
+class ClassPathIndexTest : public CommonRuntimeTest {};
+
+static ClassPathEntry Find(ClassPathIndex* index, const char* descriptor, size_t* probes) {
+  return index->Find(descriptor, ComputeModifiedUtf8Hash(descriptor), probes);
+}
+
+TEST_F(ClassPathIndexTest, Find) {
+  ScopedObjectAccess soa(Thread::Current());
+  const DexFile* nested = OpenTestDexFile("Nested");
+  ASSERT_TRUE(nested != nullptr);
+  std::vector<const DexFile*> class_path;
+  class_path.push_back(nested);
+  class_path.push_back(java_lang_dex_file_);
+  ClassPathIndex index(class_path);
+  EXPECT_EQ(2U, index.NumDexFiles());
+  EXPECT_EQ(nested->NumClassDefs() + java_lang_dex_file_->NumClassDefs(), index.NumClasses());
+
+  size_t probes;
+  ClassPathEntry entry = Find(&index, "LNested;", &probes);
+  EXPECT_EQ(nested, entry.first);
+  EXPECT_EQ(nested->FindClassDef("LNested;", ComputeModifiedUtf8Hash("LNested;")), entry.second);
+  EXPECT_EQ(1U, probes);
+
+  entry = Find(&index, "Ljava/lang/Object;", &probes);
+  EXPECT_EQ(java_lang_dex_file_, entry.first);
+  ASSERT_TRUE(entry.second != nullptr);
+  EXPECT_STREQ("Ljava/lang/Object;", java_lang_dex_file_->GetClassDescriptor(*entry.second));
+  EXPECT_EQ(2U, probes);
+
+  entry = Find(&index, "LNoSuchClass;", &probes);
+  EXPECT_TRUE(entry.first == nullptr);
+  EXPECT_TRUE(entry.second == nullptr);
+  EXPECT_EQ(2U, probes);
+}
+
+// Like the class path search, the first dex file defining a class wins.
+TEST_F(ClassPathIndexTest, FirstDefinitionWins) {
+  ScopedObjectAccess soa(Thread::Current());
+  const DexFile* first = OpenTestDexFile("Nested");
+  const DexFile* second = OpenTestDexFile("Nested");
+  ASSERT_TRUE(first != nullptr);
+  ASSERT_TRUE(second != nullptr);
+  std::vector<const DexFile*> class_path;
+  class_path.push_back(first);
+  class_path.push_back(second);
+  ClassPathIndex index(class_path);
+  EXPECT_EQ(first->NumClassDefs(), index.NumClasses());
+  size_t probes;
+  EXPECT_EQ(first, Find(&index, "LNested$Inner;", &probes).first);
+  EXPECT_EQ(1U, probes);
+}
+
+}  // namespace art
@@ -130,8 +130,14 @@ class EntrypointsOrderTest : public CommonRuntimeTest {
     EXPECT_OFFSET_DIFFP(Thread, tlsPtr_, thread_local_alloc_stack_top, thread_local_alloc_stack_end,
                         kPointerSize);
     EXPECT_OFFSET_DIFFP(Thread, tlsPtr_, thread_local_alloc_stack_end, held_mutexes, kPointerSize);
-    EXPECT_OFFSET_DIFF(Thread, tlsPtr_.held_mutexes, Thread, wait_mutex_,
-                       kPointerSize * kLockLevelCount + kPointerSize, thread_tlsptr_end);
+    EXPECT_OFFSET_DIFFP(Thread, tlsPtr_, held_mutexes, nested_signal_state,
+                        kPointerSize * kLockLevelCount);
+    EXPECT_OFFSET_DIFFP(Thread, tlsPtr_, nested_signal_state, method_trace_buffer, kPointerSize);
+    EXPECT_OFFSET_DIFFP(Thread, tlsPtr_, method_trace_buffer, profiler_sample_buffer,
+                        kPointerSize);
+    EXPECT_OFFSET_DIFFP(Thread, tlsPtr_, profiler_sample_buffer, interpreter_cache, kPointerSize);
+    EXPECT_OFFSET_DIFF(Thread, tlsPtr_.interpreter_cache, Thread, wait_mutex_, kPointerSize,
+                       thread_tlsptr_end);
   }
 
   void CheckInterpreterEntryPoints() {
@@ -262,6 +262,10 @@ void ModUnionTableReferenceCache::Dump(std::ostream& os) {
 
 void ModUnionTableReferenceCache::UpdateAndMarkReferences(MarkHeapReferenceCallback* callback,
                                                           void* arg) {
+  MarkReferences(0, UpdateReferences(), callback, arg);
+}
+
+size_t ModUnionTableReferenceCache::UpdateReferences() {
   CardTable* card_table = heap_->GetCardTable();
 
   std::vector<mirror::HeapReference<Object>*> cards_references;
@@ -290,12 +294,23 @@ void ModUnionTableReferenceCache::UpdateAndMarkReferences(MarkHeapReferenceCallb
     }
   }
   cleared_cards_.clear();
-  size_t count = 0;
+  card_references_.clear();
+  card_references_.reserve(references_.size());
   for (const auto& ref : references_) {
-    for (mirror::HeapReference<Object>* obj_ptr : ref.second) {
+    card_references_.push_back(&ref.second);
+  }
+  return card_references_.size();
+}
+
+void ModUnionTableReferenceCache::MarkReferences(size_t begin, size_t end,
+                                                 MarkHeapReferenceCallback* callback, void* arg) {
+  DCHECK_LE(end, card_references_.size());
+  size_t count = 0;
+  for (size_t i = begin; i < end; ++i) {
+    for (mirror::HeapReference<Object>* obj_ptr : *card_references_[i]) {
       callback(obj_ptr, arg);
     }
-    count += ref.second.size();
+    count += card_references_[i]->size();
   }
   if (VLOG_IS_ON(heap)) {
     VLOG(gc) << "Marked " << count << " references in mod union table";
@@ -312,11 +327,23 @@ void ModUnionTableCardCache::ClearCards() {
 // Mark all references to the alloc space(s).
 void ModUnionTableCardCache::UpdateAndMarkReferences(MarkHeapReferenceCallback* callback,
                                                      void* arg) {
+  MarkReferences(0, UpdateReferences(), callback, arg);
+}
+
+size_t ModUnionTableCardCache::UpdateReferences() {
+  // The cleared cards are kept, only the chunks need updating.
+  cards_.assign(cleared_cards_.begin(), cleared_cards_.end());
+  return cards_.size();
+}
+
+void ModUnionTableCardCache::MarkReferences(size_t begin, size_t end,
+                                            MarkHeapReferenceCallback* callback, void* arg) {
+  DCHECK_LE(end, cards_.size());
   CardTable* card_table = heap_->GetCardTable();
   ModUnionScanImageRootVisitor scan_visitor(callback, arg);
   ContinuousSpaceBitmap* bitmap = space_->GetLiveBitmap();
-  for (const byte* card_addr : cleared_cards_) {
-    uintptr_t start = reinterpret_cast<uintptr_t>(card_table->AddrFromCard(card_addr));
+  for (size_t i = begin; i < end; ++i) {
+    uintptr_t start = reinterpret_cast<uintptr_t>(card_table->AddrFromCard(cards_[i]));
     DCHECK(space_->HasAddress(reinterpret_cast<Object*>(start)));
     bitmap->VisitMarkedRange(start, start + CardTable::kCardSize, scan_visitor);
   }
@@ -71,6 +71,15 @@ class ModUnionTable {
   // spaces which are stored in the mod-union table.
   virtual void UpdateAndMarkReferences(MarkHeapReferenceCallback* callback, void* arg) = 0;
 
+  // The same as UpdateAndMarkReferences, split for collectors marking in parallel. Updates the
+  // table and returns the number of chunks of references it now holds, for MarkReferences.
+  virtual size_t UpdateReferences() = 0;
+
+  // Marks the references of chunks [begin, end). May run on several threads at once for disjoint
+  // ranges of chunks, as long as the table isn't updated meanwhile.
+  virtual void MarkReferences(size_t begin, size_t end, MarkHeapReferenceCallback* callback,
+                              void* arg) = 0;
+
   // Verification, sanity checks that we don't have clean cards which conflict with out cached data
   // for said cards. Exclusive lock is required since verify sometimes uses
   // SpaceBitmap::VisitMarkedRange and VisitMarkedRange can't know if the callback will modify the
@@ -110,6 +119,15 @@ class ModUnionTableReferenceCache : public ModUnionTable {
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_)
       EXCLUSIVE_LOCKS_REQUIRED(Locks::heap_bitmap_lock_);
 
+  // A chunk is the references of one card.
+  size_t UpdateReferences()
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_)
+      EXCLUSIVE_LOCKS_REQUIRED(Locks::heap_bitmap_lock_);
+
+  void MarkReferences(size_t begin, size_t end, MarkHeapReferenceCallback* callback, void* arg)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_)
+      EXCLUSIVE_LOCKS_REQUIRED(Locks::heap_bitmap_lock_);
+
   // Exclusive lock is required since verify uses SpaceBitmap::VisitMarkedRange and
   // VisitMarkedRange can't know if the callback will modify the bitmap or not.
   void Verify()
@@ -128,6 +146,9 @@ class ModUnionTableReferenceCache : public ModUnionTable {
   // Maps from dirty cards to their corresponding alloc space references.
   AllocationTrackingSafeMap<const byte*, std::vector<mirror::HeapReference<mirror::Object>*>,
                             kAllocatorTagModUnionReferenceArray> references_;
+
+  // The values of references_ as of the last update, indexed by chunk.
+  std::vector<const std::vector<mirror::HeapReference<mirror::Object>*>*> card_references_;
 };
 
 // Card caching implementation. Keeps track of which cards we cleared and only this information.
@@ -145,6 +166,13 @@ class ModUnionTableCardCache : public ModUnionTable {
       EXCLUSIVE_LOCKS_REQUIRED(Locks::heap_bitmap_lock_)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
+  // A chunk is the objects of one card.
+  size_t UpdateReferences();
+
+  void MarkReferences(size_t begin, size_t end, MarkHeapReferenceCallback* callback, void* arg)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_)
+      EXCLUSIVE_LOCKS_REQUIRED(Locks::heap_bitmap_lock_);
+
   // Nothing to verify.
   void Verify() {}
 
@@ -153,6 +181,9 @@ class ModUnionTableCardCache : public ModUnionTable {
  protected:
   // Cleared card array, used to update the mod-union table.
   CardSet cleared_cards_;
+
+  // The cards of cleared_cards_ as of the last update, indexed by chunk.
+  std::vector<const byte*> cards_;
 };
 
 }  // namespace accounting
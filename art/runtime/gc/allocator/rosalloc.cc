@@ -48,9 +48,11 @@ RosAlloc::Run* RosAlloc::dedicated_full_run_ =
     reinterpret_cast<RosAlloc::Run*>(dedicated_full_run_storage_);
 
 RosAlloc::RosAlloc(void* base, size_t capacity, size_t max_capacity,
-                   PageReleaseMode page_release_mode, size_t page_release_size_threshold)
+                   PageReleaseMode page_release_mode, size_t page_release_size_threshold,
+                   size_t thread_local_run_size_threshold)
     : base_(reinterpret_cast<byte*>(base)), footprint_(capacity),
       capacity_(capacity), max_capacity_(max_capacity),
+      num_thread_local_size_brackets_(SizeToNumOfSizeBrackets(thread_local_run_size_threshold)),
       lock_("rosalloc global lock", kRosAllocGlobalLock),
       bulk_free_lock_("rosalloc bulk free lock", kRosAllocBulkFreeLock),
       page_release_mode_(page_release_mode),
@@ -59,6 +61,7 @@ RosAlloc::RosAlloc(void* base, size_t capacity, size_t max_capacity,
   DCHECK_EQ(RoundUp(max_capacity, kPageSize), max_capacity);
   CHECK_LE(capacity, max_capacity);
   CHECK(IsAligned<kPageSize>(page_release_size_threshold_));
+  CHECK_LE(num_thread_local_size_brackets_, kNumOfSizeBrackets);
   if (!initialized_) {
     Initialize();
   }
@@ -66,12 +69,15 @@ RosAlloc::RosAlloc(void* base, size_t capacity, size_t max_capacity,
              << std::hex << (intptr_t)base_ << ", end="
              << std::hex << (intptr_t)(base_ + capacity_)
              << ", capacity=" << std::dec << capacity_
-             << ", max_capacity=" << std::dec << max_capacity_;
+             << ", max_capacity=" << std::dec << max_capacity_
+             << ", thread_local_size_brackets=" << num_thread_local_size_brackets_;
   for (size_t i = 0; i < kNumOfSizeBrackets; i++) {
     size_bracket_lock_names_[i] =
         StringPrintf("an rosalloc size bracket %d lock", static_cast<int>(i));
     size_bracket_locks_[i] = new Mutex(size_bracket_lock_names_[i].c_str(), kRosAllocBracketLock);
     current_runs_[i] = dedicated_full_run_;
+    memset(&bracket_stats_[i], 0, sizeof(bracket_stats_[i]));
+    thread_local_bulk_frees_[i] = 0;
   }
   DCHECK_EQ(footprint_, capacity_);
   size_t num_of_pages = footprint_ / kPageSize;
@@ -547,7 +553,7 @@ RosAlloc::Run* RosAlloc::AllocRun(Thread* self, size_t idx) {
     DCHECK(!new_run->IsThreadLocal());
     DCHECK_EQ(new_run->first_search_vec_idx_, 0U);
     DCHECK(!new_run->to_be_bulk_freed_);
-    if (kUsePrefetchDuringAllocRun && idx < kNumThreadLocalSizeBrackets) {
+    if (kUsePrefetchDuringAllocRun && idx < num_thread_local_size_brackets_) {
       // Take ownership of the cache lines if we are likely to be thread local run.
       if (kPrefetchNewRunDataByZeroing) {
         // Zeroing the data is sometimes faster than prefetching but it increases memory usage
@@ -650,7 +656,7 @@ void* RosAlloc::AllocFromRun(Thread* self, size_t size, size_t* bytes_allocated)
 
   void* slot_addr;
 
-  if (LIKELY(idx < kNumThreadLocalSizeBrackets)) {
+  if (LIKELY(idx < num_thread_local_size_brackets_)) {
     // Use a thread-local run.
     Run* thread_local_run = reinterpret_cast<Run*>(self->GetRosAllocRun(idx));
     // Allow invalid since this will always fail the allocation.
@@ -669,7 +675,10 @@ void* RosAlloc::AllocFromRun(Thread* self, size_t size, size_t* bytes_allocated)
     if (UNLIKELY(slot_addr == nullptr)) {
       // The run got full. Try to free slots.
       DCHECK(thread_local_run->IsFull());
-      MutexLock mu(self, *size_bracket_locks_[idx]);
+      // BulkFree() sets the thread-local free bits without the size bracket lock, exclude it while
+      // merging them and while changing which run is thread local.
+      ReaderMutexLock rmu(self, bulk_free_lock_);
+      SizeBracketLock mu(self, this, idx);
       bool is_all_free_after_merge;
       // This is safe to do for the dedicated_full_run_ since the bitmaps are empty.
       if (thread_local_run->MergeThreadLocalFreeBitMapToAllocBitMap(&is_all_free_after_merge)) {
@@ -707,6 +716,7 @@ void* RosAlloc::AllocFromRun(Thread* self, size_t size, size_t* bytes_allocated)
         DCHECK(full_runs_[idx].find(thread_local_run) == full_runs_[idx].end());
         thread_local_run->SetIsThreadLocal(true);
         self->SetRosAllocRun(idx, thread_local_run);
+        ++bracket_stats_[idx].thread_local_run_refills;
         DCHECK(!thread_local_run->IsFull());
       }
 
@@ -724,8 +734,11 @@ void* RosAlloc::AllocFromRun(Thread* self, size_t size, size_t* bytes_allocated)
     }
   } else {
     // Use the (shared) current run.
-    MutexLock mu(self, *size_bracket_locks_[idx]);
+    SizeBracketLock mu(self, this, idx);
     slot_addr = AllocFromCurrentRunUnlocked(self, idx);
+    if (LIKELY(slot_addr != nullptr)) {
+      ++bracket_stats_[idx].shared_run_allocs;
+    }
     if (kTraceRosAlloc) {
       LOG(INFO) << "RosAlloc::AllocFromRun() : 0x" << std::hex << reinterpret_cast<intptr_t>(slot_addr)
                 << "-0x" << (reinterpret_cast<intptr_t>(slot_addr) + bracket_size)
@@ -745,7 +758,7 @@ size_t RosAlloc::FreeFromRun(Thread* self, void* ptr, Run* run) {
   const size_t idx = run->size_bracket_idx_;
   const size_t bracket_size = bracketSizes[idx];
   bool run_was_full = false;
-  MutexLock mu(self, *size_bracket_locks_[idx]);
+  SizeBracketLock mu(self, this, idx);
   if (kIsDebugBuild) {
     run_was_full = run->IsFull();
   }
@@ -754,7 +767,7 @@ size_t RosAlloc::FreeFromRun(Thread* self, void* ptr, Run* run) {
   }
   if (LIKELY(run->IsThreadLocal())) {
     // It's a thread-local run. Just mark the thread-local free bit map and return.
-    DCHECK_LT(run->size_bracket_idx_, kNumThreadLocalSizeBrackets);
+    DCHECK_LT(run->size_bracket_idx_, num_thread_local_size_brackets_);
     DCHECK(non_full_runs_[idx].find(run) == non_full_runs_[idx].end());
     DCHECK(full_runs_[idx].find(run) == full_runs_[idx].end());
     run->MarkThreadLocalFreeBitMap(ptr);
@@ -1224,6 +1237,9 @@ size_t RosAlloc::BulkFree(Thread* self, void** ptrs, size_t num_ptrs) {
     DCHECK_EQ(run->magic_num_, kMagicNum);
     // Set the bit in the bulk free bit map.
     freed_bytes += run->MarkBulkFreeBitMap(ptr);
+    if (run->IsThreadLocal()) {
+      ++thread_local_bulk_frees_[run->size_bracket_idx_];
+    }
 #ifdef HAVE_ANDROID_OS
     if (!run->to_be_bulk_freed_) {
       run->to_be_bulk_freed_ = true;
@@ -1244,11 +1260,11 @@ size_t RosAlloc::BulkFree(Thread* self, void** ptrs, size_t num_ptrs) {
     run->to_be_bulk_freed_ = false;
 #endif
     size_t idx = run->size_bracket_idx_;
-    MutexLock mu(self, *size_bracket_locks_[idx]);
     if (run->IsThreadLocal()) {
-      DCHECK_LT(run->size_bracket_idx_, kNumThreadLocalSizeBrackets);
-      DCHECK(non_full_runs_[idx].find(run) == non_full_runs_[idx].end());
-      DCHECK(full_runs_[idx].find(run) == full_runs_[idx].end());
+      // Everything else which touches the thread-local free bit maps, or changes whether a run
+      // is thread local, holds bulk_free_lock_ shared. We hold it exclusively so there is no need
+      // for the size bracket lock.
+      DCHECK_LT(run->size_bracket_idx_, num_thread_local_size_brackets_);
       run->UnionBulkFreeBitMapToThreadLocalFreeBitMap();
       if (kTraceRosAlloc) {
         LOG(INFO) << "RosAlloc::BulkFree() : Freed slot(s) in a thread local run 0x"
@@ -1258,6 +1274,7 @@ size_t RosAlloc::BulkFree(Thread* self, void** ptrs, size_t num_ptrs) {
       // A thread local run will be kept as a thread local even if
       // it's become all free.
     } else {
+      SizeBracketLock mu(self, this, idx);
       bool run_was_full = run->IsFull();
       run->MergeBulkFreeBitMapIntoAllocBitMap();
       if (kTraceRosAlloc) {
@@ -1650,7 +1667,7 @@ void RosAlloc::RevokeThreadLocalRuns(Thread* thread) {
   Thread* self = Thread::Current();
   // Avoid race conditions on the bulk free bit maps with BulkFree() (GC).
   ReaderMutexLock wmu(self, bulk_free_lock_);
-  for (size_t idx = 0; idx < kNumThreadLocalSizeBrackets; idx++) {
+  for (size_t idx = 0; idx < num_thread_local_size_brackets_; idx++) {
     MutexLock mu(self, *size_bracket_locks_[idx]);
     Run* thread_local_run = reinterpret_cast<Run*>(thread->GetRosAllocRun(idx));
     CHECK(thread_local_run != nullptr);
@@ -1702,7 +1719,7 @@ void RosAlloc::RevokeRun(Thread* self, size_t idx, Run* run) {
 void RosAlloc::RevokeThreadUnsafeCurrentRuns() {
   // Revoke the current runs which share the same idx as thread local runs.
   Thread* self = Thread::Current();
-  for (size_t idx = 0; idx < kNumThreadLocalSizeBrackets; ++idx) {
+  for (size_t idx = 0; idx < num_thread_local_size_brackets_; ++idx) {
     MutexLock mu(self, *size_bracket_locks_[idx]);
     if (current_runs_[idx] != dedicated_full_run_) {
       RevokeRun(self, idx, current_runs_[idx]);
@@ -1728,7 +1745,7 @@ void RosAlloc::AssertThreadLocalRunsAreRevoked(Thread* thread) {
     Thread* self = Thread::Current();
     // Avoid race conditions on the bulk free bit maps with BulkFree() (GC).
     ReaderMutexLock wmu(self, bulk_free_lock_);
-    for (size_t idx = 0; idx < kNumThreadLocalSizeBrackets; idx++) {
+    for (size_t idx = 0; idx < num_thread_local_size_brackets_; idx++) {
       MutexLock mu(self, *size_bracket_locks_[idx]);
       Run* thread_local_run = reinterpret_cast<Run*>(thread->GetRosAllocRun(idx));
       DCHECK(thread_local_run == nullptr || thread_local_run == dedicated_full_run_);
@@ -1745,7 +1762,7 @@ void RosAlloc::AssertAllThreadLocalRunsAreRevoked() {
     for (Thread* t : thread_list) {
       AssertThreadLocalRunsAreRevoked(t);
     }
-    for (size_t idx = 0; idx < kNumThreadLocalSizeBrackets; ++idx) {
+    for (size_t idx = 0; idx < num_thread_local_size_brackets_; ++idx) {
       MutexLock mu(self, *size_bracket_locks_[idx]);
       CHECK_EQ(current_runs_[idx], dedicated_full_run_);
     }
@@ -1967,7 +1984,7 @@ void RosAlloc::Verify() {
   }
   std::list<Thread*> threads = Runtime::Current()->GetThreadList()->GetList();
   for (Thread* thread : threads) {
-    for (size_t i = 0; i < kNumThreadLocalSizeBrackets; ++i) {
+    for (size_t i = 0; i < num_thread_local_size_brackets_; ++i) {
       MutexLock mu(self, *size_bracket_locks_[i]);
       Run* thread_local_run = reinterpret_cast<Run*>(thread->GetRosAllocRun(i));
       CHECK(thread_local_run != nullptr);
@@ -2018,7 +2035,7 @@ void RosAlloc::Run::Verify(Thread* self, RosAlloc* rosalloc) {
     std::list<Thread*> thread_list = Runtime::Current()->GetThreadList()->GetList();
     for (auto it = thread_list.begin(); it != thread_list.end(); ++it) {
       Thread* thread = *it;
-      for (size_t i = 0; i < kNumThreadLocalSizeBrackets; i++) {
+      for (size_t i = 0; i < rosalloc->num_thread_local_size_brackets_; i++) {
         MutexLock mu(self, *rosalloc->size_bracket_locks_[i]);
         Run* thread_local_run = reinterpret_cast<Run*>(thread->GetRosAllocRun(i));
         if (thread_local_run == this) {
@@ -2185,6 +2202,31 @@ size_t RosAlloc::ReleasePageRange(byte* start, byte* end) {
   return reclaimed_bytes;
 }
 
+void RosAlloc::DumpStats(std::ostream& os) {
+  Thread* self = Thread::Current();
+  ReaderMutexLock rmu(self, bulk_free_lock_);
+  os << "RosAlloc size brackets: " << num_thread_local_size_brackets_ << " of "
+     << kNumOfSizeBrackets << " use thread-local runs\n";
+  for (size_t idx = 0; idx < kNumOfSizeBrackets; ++idx) {
+    BracketStats stats;
+    {
+      MutexLock mu(self, *size_bracket_locks_[idx]);
+      stats = bracket_stats_[idx];
+    }
+    if (stats.lock_acquisitions == 0 && stats.thread_local_run_refills == 0 &&
+        stats.shared_run_allocs == 0 && thread_local_bulk_frees_[idx] == 0) {
+      continue;
+    }
+    os << "  " << bracketSizes[idx] << "B"
+       << (idx < num_thread_local_size_brackets_ ? " thread-local" : " shared")
+       << ": shared run allocs=" << stats.shared_run_allocs
+       << " thread-local run refills=" << stats.thread_local_run_refills
+       << " thread-local bulk frees=" << thread_local_bulk_frees_[idx]
+       << " lock acquisitions=" << stats.lock_acquisitions
+       << " contended=" << stats.lock_contentions << "\n";
+  }
+}
+
 void RosAlloc::LogFragmentationAllocFailure(std::ostream& os, size_t failed_alloc_bytes) {
   Thread* self = Thread::Current();
   size_t largest_continuous_free_pages = 0;
@@ -351,6 +351,17 @@ class RosAlloc {
       return idx;
     }
   }
+  // Returns the number of size brackets, counted from the smallest, needed to serve allocations of
+  // up to the given size.
+  static size_t SizeToNumOfSizeBrackets(size_t size) {
+    if (size == 0) {
+      return 0;
+    }
+    if (size > kLargeSizeThreshold) {
+      size = kLargeSizeThreshold;
+    }
+    return SizeToIndex(size) + 1;
+  }
   // Returns the page map index from an address. Requires that the
   // address is page size aligned.
   size_t ToPageMapIndex(const void* addr) const {
@@ -401,9 +412,11 @@ class RosAlloc {
   // The default value for page_release_size_threshold_.
   static constexpr size_t kDefaultPageReleaseSizeThreshold = 4 * MB;
 
-  // We use thread-local runs for the size Brackets whose indexes
-  // are less than this index. We use shared (current) runs for the rest.
-  static const size_t kNumThreadLocalSizeBrackets = 8;
+  // The default value for the thread_local_run_size_threshold constructor argument. We use
+  // thread-local runs for the size brackets up to this size. We use shared (current) runs for the
+  // rest. 0 disables thread-local runs, anything from the largest bracket size up enables them for
+  // all brackets.
+  static constexpr size_t kDefaultThreadLocalRunSizeThreshold = 128;
 
  private:
   // The base address of the memory region that's managed by this allocator.
@@ -440,6 +453,23 @@ class RosAlloc {
   Run* current_runs_[kNumOfSizeBrackets];
   // The mutexes, one per size bracket.
   Mutex* size_bracket_locks_[kNumOfSizeBrackets];
+  // Allocation counters of a size bracket. Guarded by the size bracket lock.
+  struct BracketStats {
+    // Slots allocated from the shared current run.
+    uint64_t shared_run_allocs;
+    // Runs handed to a thread as its thread-local run.
+    uint64_t thread_local_run_refills;
+    // Acquisitions of the size bracket lock by allocations and frees, and how many of them had to
+    // wait for another thread.
+    uint64_t lock_acquisitions;
+    uint64_t lock_contentions;
+  };
+  BracketStats bracket_stats_[kNumOfSizeBrackets];
+  // Slots returned to thread-local runs by BulkFree(), which does this without taking the size
+  // bracket locks.
+  uint64_t thread_local_bulk_frees_[kNumOfSizeBrackets] GUARDED_BY(bulk_free_lock_);
+  // Size brackets whose indexes are less than this use thread-local runs.
+  const size_t num_thread_local_size_brackets_;
   // Bracket lock names (since locks only have char* names).
   std::string size_bracket_lock_names_[kNumOfSizeBrackets];
   // The types of page map entries.
@@ -513,6 +543,31 @@ class RosAlloc {
   // Allocates large objects.
   void* AllocLargeObject(Thread* self, size_t size, size_t* bytes_allocated) LOCKS_EXCLUDED(lock_);
 
+  // Scoped lock of a size bracket which counts the acquisition, and whether it had to wait for
+  // another thread, in the bracket's stats.
+  class SCOPED_LOCKABLE SizeBracketLock {
+   public:
+    SizeBracketLock(Thread* self, RosAlloc* rosalloc, size_t idx)
+        EXCLUSIVE_LOCK_FUNCTION(rosalloc->size_bracket_locks_[idx])
+        : self_(self), mu_(*rosalloc->size_bracket_locks_[idx]) {
+      BracketStats* stats = &rosalloc->bracket_stats_[idx];
+      if (!mu_.ExclusiveTryLock(self_)) {
+        mu_.ExclusiveLock(self_);
+        ++stats->lock_contentions;
+      }
+      ++stats->lock_acquisitions;
+    }
+
+    ~SizeBracketLock() UNLOCK_FUNCTION() {
+      mu_.ExclusiveUnlock(self_);
+    }
+
+   private:
+    Thread* const self_;
+    Mutex& mu_;
+    DISALLOW_COPY_AND_ASSIGN(SizeBracketLock);
+  };
+
   // Revoke a run by adding it to non_full_runs_ or freeing the pages.
   void RevokeRun(Thread* self, size_t idx, Run* run);
 
@@ -525,7 +580,8 @@ class RosAlloc {
  public:
   RosAlloc(void* base, size_t capacity, size_t max_capacity,
            PageReleaseMode page_release_mode,
-           size_t page_release_size_threshold = kDefaultPageReleaseSizeThreshold);
+           size_t page_release_size_threshold = kDefaultPageReleaseSizeThreshold,
+           size_t thread_local_run_size_threshold = kDefaultThreadLocalRunSizeThreshold);
   ~RosAlloc();
   // If kThreadUnsafe is true then the allocator may avoid acquiring some locks as an optimization.
   // If used, this may cause race conditions if multiple threads are allocating at the same time.
@@ -561,6 +617,10 @@ class RosAlloc {
   size_t FootprintLimit() LOCKS_EXCLUDED(lock_);
   // Update the current capacity.
   void SetFootprintLimit(size_t bytes) LOCKS_EXCLUDED(lock_);
+  // Returns the number of size brackets, counted from the smallest, which use thread-local runs.
+  size_t NumThreadLocalSizeBrackets() const {
+    return num_thread_local_size_brackets_;
+  }
   // Releases the thread-local runs assigned to the given thread back to the common set of runs.
   void RevokeThreadLocalRuns(Thread* thread);
   // Releases the thread-local runs assigned to all the threads back to the common set of runs.
@@ -593,6 +653,9 @@ class RosAlloc {
   void Verify() EXCLUSIVE_LOCKS_REQUIRED(Locks::mutator_lock_);
 
   void LogFragmentationAllocFailure(std::ostream& os, size_t failed_alloc_bytes);
+
+  // Dumps the per size bracket allocation and lock contention counters.
+  void DumpStats(std::ostream& os) LOCKS_EXCLUDED(bulk_free_lock_);
 };
 
 }  // namespace allocator
@@ -16,10 +16,398 @@
 
 #include "concurrent_copying.h"
 
+#include <vector>
+
+#include "base/logging.h"
+#include "base/mutex-inl.h"
+#include "base/timing_logger.h"
+#include "gc/accounting/atomic_stack.h"
+#include "gc/accounting/heap_bitmap-inl.h"
+#include "gc/accounting/mod_union_table.h"
+#include "gc/accounting/space_bitmap-inl.h"
+#include "gc/heap.h"
+#include "gc/reference_processor.h"
+#include "gc/space/bump_pointer_space-inl.h"
+#include "gc/space/large_object_space.h"
+#include "gc/space/space-inl.h"
+#include "lock_word.h"
+#include "mirror/object-inl.h"
+#include "mirror/reference-inl.h"
+#include "runtime.h"
+#include "thread-inl.h"
+
 namespace art {
 namespace gc {
 namespace collector {
 
+static constexpr bool kProtectFromSpace = true;
+
+ConcurrentCopying::ConcurrentCopying(Heap* heap, bool generational,
+                                     const std::string& name_prefix)
+    : GarbageCollector(heap,
+                       name_prefix + (name_prefix.empty() ? "" : " ") +
+                       "paused copying + mark sweep"),
+      from_space_(nullptr),
+      to_space_(nullptr),
+      mark_bitmap_(nullptr),
+      large_object_mark_bitmap_(nullptr),
+      self_(nullptr),
+      gray_stack_(nullptr),
+      objects_moved_(0),
+      bytes_moved_(0) {
+  UNUSED(generational);
+}
+
+void ConcurrentCopying::RunPhases() {
+  Thread* self = Thread::Current();
+  InitializePhase();
+  {
+    ScopedPause pause(this);
+    GetHeap()->PreGcVerificationPaused(this);
+    GetHeap()->PrePauseRosAllocVerification(this);
+    FlipPhase();
+    MarkingPhase();
+  }
+  {
+    ReaderMutexLock mu(self, *Locks::mutator_lock_);
+    ReclaimPhase();
+  }
+  GetHeap()->PostGcVerification(this);
+  FinishPhase();
+}
+
+void ConcurrentCopying::SetFromSpace(space::ContinuousMemMapAllocSpace* from_space) {
+  DCHECK(from_space != nullptr);
+  from_space_ = from_space;
+}
+
+void ConcurrentCopying::SetToSpace(space::ContinuousMemMapAllocSpace* to_space) {
+  DCHECK(to_space != nullptr);
+  to_space_ = to_space;
+}
+
+void ConcurrentCopying::InitializePhase() {
+  TimingLogger::ScopedTiming t(__FUNCTION__, GetTimings());
+  self_ = Thread::Current();
+  CHECK(from_space_ != nullptr && to_space_ != nullptr);
+  CHECK(from_space_->CanMoveObjects()) << "Attempting to move from " << *from_space_;
+  immune_region_.Reset();
+  gray_stack_ = heap_->GetMarkStack();
+  CHECK(gray_stack_->IsEmpty());
+  objects_moved_ = 0;
+  bytes_moved_ = 0;
+  {
+    ReaderMutexLock mu(self_, *Locks::heap_bitmap_lock_);
+    mark_bitmap_ = heap_->GetMarkBitmap();
+    large_object_mark_bitmap_ = heap_->GetLargeObjectsSpace()->GetMarkBitmap();
+  }
+}
+
+void ConcurrentCopying::BindBitmaps() {
+  TimingLogger::ScopedTiming t(__FUNCTION__, GetTimings());
+  // Mark all of the spaces we never collect as immune.
+  for (const auto& space : GetHeap()->GetContinuousSpaces()) {
+    if (space->GetGcRetentionPolicy() == space::kGcRetentionPolicyNeverCollect ||
+        space->GetGcRetentionPolicy() == space::kGcRetentionPolicyFullCollect) {
+      CHECK(immune_region_.AddContinuousSpace(space)) << "Failed to add space " << *space;
+    }
+  }
+}
+
+void ConcurrentCopying::FlipPhase() {
+  TimingLogger::ScopedTiming t(__FUNCTION__, GetTimings());
+  // The to-space must not be left with thread-local buffers of the previous collection.
+  RevokeAllThreadLocalBuffers();
+  BindBitmaps();
+  if (kUseThreadLocalAllocationStack) {
+    TimingLogger::ScopedTiming t2("RevokeAllThreadLocalAllocationStacks", GetTimings());
+    heap_->RevokeAllThreadLocalAllocationStacks(self_);
+  }
+  // The objects allocated so far in the non-moving spaces are collected like the others.
+  heap_->SwapStacks(self_);
+  {
+    TimingLogger::ScopedTiming t2("MarkStackAsLive", GetTimings());
+    WriterMutexLock mu(self_, *Locks::heap_bitmap_lock_);
+    accounting::ObjectStack* live_stack = heap_->GetLiveStack();
+    heap_->MarkAllocStackAsLive(live_stack);
+    live_stack->Reset();
+  }
+  // Record the references the mutators stored into the immune spaces in their mod-union tables.
+  heap_->ProcessCards(GetTimings(), false);
+  // The mutators allocate in the to-space once resumed.
+  heap_->SwapSemiSpaces();
+  MarkRoots();
+}
+
+void ConcurrentCopying::MarkRoots() {
+  TimingLogger::ScopedTiming t(__FUNCTION__, GetTimings());
+  Runtime::Current()->VisitRoots(MarkRootCallback, this);
+}
+
+void ConcurrentCopying::MarkingPhase() {
+  TimingLogger::ScopedTiming t(__FUNCTION__, GetTimings());
+  for (const auto& space : heap_->GetContinuousSpaces()) {
+    accounting::ModUnionTable* table = heap_->FindModUnionTableFromSpace(space);
+    if (table != nullptr) {
+      TimingLogger::ScopedTiming t2(
+          space->IsZygoteSpace() ? "UpdateAndMarkZygoteModUnionTable" :
+                                   "UpdateAndMarkImageModUnionTable",
+          GetTimings());
+      WriterMutexLock mu(self_, *Locks::heap_bitmap_lock_);
+      table->UpdateAndMarkReferences(MarkHeapReferenceCallback, this);
+    }
+  }
+  ProcessGrayStack();
+  ProcessReferences();
+  SweepSystemWeaks();
+  heap_->PreSweepingGcVerification(this);
+}
+
+void ConcurrentCopying::ProcessReferences() {
+  TimingLogger::ScopedTiming t(__FUNCTION__, GetTimings());
+  GetHeap()->GetReferenceProcessor()->ProcessReferences(
+      false, GetTimings(), GetCurrentIteration()->GetClearSoftReferences(),
+      &IsHeapReferenceMarkedCallback, &MarkObjectCallback, &ProcessMarkStackCallback, this);
+}
+
+void ConcurrentCopying::SweepSystemWeaks() {
+  TimingLogger::ScopedTiming t(__FUNCTION__, GetTimings());
+  Runtime::Current()->SweepSystemWeaks(IsMarkedCallback, this);
+}
+
+void ConcurrentCopying::ReclaimPhase() {
+  TimingLogger::ScopedTiming t(__FUNCTION__, GetTimings());
+  {
+    CHECK(gray_stack_->IsEmpty());
+    gray_stack_->Reset();
+    // Record freed memory. Nothing has been allocated in the from-space since the flip.
+    const int64_t from_bytes = from_space_->GetBytesAllocated();
+    const uint64_t from_objects = from_space_->GetObjectsAllocated();
+    CHECK_LE(objects_moved_, from_objects);
+    RecordFree(ObjectBytePair(from_objects - objects_moved_, from_bytes - bytes_moved_));
+  }
+  // No reference to the from-space is left.
+  from_space_->Clear();
+  VLOG(heap) << "Protecting from_space_: " << *from_space_;
+  from_space_->GetMemMap()->Protect(kProtectFromSpace ? PROT_NONE : PROT_READ);
+  WriterMutexLock mu(self_, *Locks::heap_bitmap_lock_);
+  Sweep();
+  SwapBitmaps();
+}
+
+void ConcurrentCopying::Sweep() {
+  TimingLogger::ScopedTiming t(__FUNCTION__, GetTimings());
+  for (const auto& space : GetHeap()->GetContinuousSpaces()) {
+    if (space->IsContinuousMemMapAllocSpace() && space != from_space_ && space != to_space_ &&
+        !immune_region_.ContainsSpace(space)) {
+      space::ContinuousMemMapAllocSpace* alloc_space = space->AsContinuousMemMapAllocSpace();
+      TimingLogger::ScopedTiming split(
+          alloc_space->IsZygoteSpace() ? "SweepZygoteSpace" : "SweepAllocSpace", GetTimings());
+      RecordFree(alloc_space->Sweep(false));
+    }
+  }
+  TimingLogger::ScopedTiming split("SweepLargeObjects", GetTimings());
+  RecordFreeLOS(heap_->GetLargeObjectsSpace()->Sweep(false));
+}
+
+void ConcurrentCopying::FinishPhase() {
+  TimingLogger::ScopedTiming t(__FUNCTION__, GetTimings());
+  // Null the "to" and "from" spaces since copying between them isn't valid until the heap sets
+  // them again.
+  to_space_ = nullptr;
+  from_space_ = nullptr;
+  // Clear all of the spaces' mark bitmaps.
+  WriterMutexLock mu(self_, *Locks::heap_bitmap_lock_);
+  heap_->ClearMarkedObjects();
+}
+
+void ConcurrentCopying::RevokeAllThreadLocalBuffers() {
+  TimingLogger::ScopedTiming t(__FUNCTION__, GetTimings());
+  GetHeap()->RevokeAllThreadLocalBuffers();
+}
+
+inline mirror::Object* ConcurrentCopying::GetForwardingAddress(mirror::Object* from_ref) {
+  DCHECK(from_space_->HasAddress(from_ref));
+  LockWord lock_word = from_ref->GetLockWord(false);
+  if (lock_word.GetState() != LockWord::kForwardingAddress) {
+    return nullptr;
+  }
+  return reinterpret_cast<mirror::Object*>(lock_word.ForwardingAddress());
+}
+
+mirror::Object* ConcurrentCopying::Mark(mirror::Object* from_ref) {
+  if (from_ref == nullptr) {
+    return nullptr;
+  }
+  if (from_space_->HasAddress(from_ref)) {
+    mirror::Object* to_ref = GetForwardingAddress(from_ref);
+    return LIKELY(to_ref != nullptr) ? to_ref : Copy(from_ref);
+  }
+  if (to_space_->HasAddress(from_ref) || immune_region_.ContainsObject(from_ref)) {
+    return from_ref;
+  }
+  if (TestAndMarkNonMoving(from_ref)) {
+    PushGray(from_ref);
+  }
+  return from_ref;
+}
+
+mirror::Object* ConcurrentCopying::Copy(mirror::Object* from_ref) {
+  // Without the read barrier. The from-space copy of a class which moved is intact until the
+  // from-space is cleared.
+  const size_t object_size = from_ref->SizeOf<kVerifyNone, kWithoutReadBarrier>();
+  size_t bytes_allocated;
+  // Nothing else allocates in the to-space during the pause, so what was allocated in the
+  // from-space fits.
+  mirror::Object* to_ref = to_space_->Alloc(self_, object_size, &bytes_allocated, nullptr);
+  CHECK(to_ref != nullptr) << "Out of memory in the to-space copying " << from_ref;
+  memcpy(reinterpret_cast<void*>(to_ref), from_ref, object_size);
+  from_ref->SetLockWord(LockWord::FromForwardingAddress(reinterpret_cast<size_t>(to_ref)), false);
+  ++objects_moved_;
+  bytes_moved_ += bytes_allocated;
+  PushGray(to_ref);
+  return to_ref;
+}
+
+inline bool ConcurrentCopying::TestAndMarkNonMoving(mirror::Object* obj) {
+  accounting::ContinuousSpaceBitmap* bitmap = mark_bitmap_->GetContinuousSpaceBitmap(obj);
+  if (LIKELY(bitmap != nullptr)) {
+    return !bitmap->Set(obj);
+  }
+  CHECK(large_object_mark_bitmap_->HasAddress(obj)) << "Invalid object " << obj;
+  return !large_object_mark_bitmap_->Set(obj);
+}
+
+inline bool ConcurrentCopying::IsMarkedNonMoving(mirror::Object* obj) {
+  accounting::ContinuousSpaceBitmap* bitmap = mark_bitmap_->GetContinuousSpaceBitmap(obj);
+  if (LIKELY(bitmap != nullptr)) {
+    return bitmap->Test(obj);
+  }
+  CHECK(large_object_mark_bitmap_->HasAddress(obj)) << "Invalid object " << obj;
+  return large_object_mark_bitmap_->Test(obj);
+}
+
+void ConcurrentCopying::PushGray(mirror::Object* obj) {
+  if (UNLIKELY(gray_stack_->Size() >= gray_stack_->Capacity())) {
+    ExpandGrayStack();
+  }
+  gray_stack_->PushBack(obj);
+}
+
+void ConcurrentCopying::ExpandGrayStack() {
+  std::vector<mirror::Object*> temp(gray_stack_->Begin(), gray_stack_->End());
+  gray_stack_->Resize(gray_stack_->Capacity() * 2);
+  for (mirror::Object* obj : temp) {
+    gray_stack_->PushBack(obj);
+  }
+}
+
+mirror::Object* ConcurrentCopying::IsMarked(mirror::Object* obj) {
+  if (from_space_->HasAddress(obj)) {
+    // Either the forwarding address or null.
+    return GetForwardingAddress(obj);
+  }
+  if (to_space_->HasAddress(obj) || immune_region_.ContainsObject(obj)) {
+    return obj;
+  }
+  return IsMarkedNonMoving(obj) ? obj : nullptr;
+}
+
+class ConcurrentCopyingRefFieldsVisitor {
+ public:
+  explicit ConcurrentCopyingRefFieldsVisitor(ConcurrentCopying* collector)
+      : collector_(collector) {
+  }
+
+  void operator()(mirror::Object* obj, MemberOffset offset, bool /* is_static */) const
+      ALWAYS_INLINE SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+    collector_->ProcessField(obj, offset);
+  }
+
+  void operator()(mirror::Class* klass, mirror::Reference* ref) const
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+    collector_->DelayReferenceReferent(klass, ref);
+  }
+
+ private:
+  ConcurrentCopying* const collector_;
+};
+
+void ConcurrentCopying::ScanObject(mirror::Object* obj) {
+  DCHECK(!from_space_->HasAddress(obj)) << "Scanning object " << obj << " in from space";
+  ConcurrentCopyingRefFieldsVisitor visitor(this);
+  obj->VisitReferences<kMovingClasses>(visitor, visitor);
+}
+
+inline void ConcurrentCopying::ProcessField(mirror::Object* obj, MemberOffset offset) {
+  mirror::HeapReference<mirror::Object>* field =
+      obj->GetFieldObjectReferenceAddr<kVerifyNone>(offset);
+  mirror::Object* ref = field->AsMirrorPtr();
+  mirror::Object* to_ref = Mark(ref);
+  if (to_ref != ref) {
+    field->Assign(to_ref);
+  }
+}
+
+void ConcurrentCopying::ProcessGrayStack() {
+  TimingLogger::ScopedTiming t(__FUNCTION__, GetTimings());
+  while (!gray_stack_->IsEmpty()) {
+    ScanObject(gray_stack_->PopBack());
+  }
+}
+
+// Process the "referent" field in a java.lang.ref.Reference. If the referent has not yet been
+// marked, put it on the appropriate list in the heap for later processing.
+void ConcurrentCopying::DelayReferenceReferent(mirror::Class* klass,
+                                               mirror::Reference* reference) {
+  heap_->GetReferenceProcessor()->DelayReferenceReferent(klass, reference,
+                                                         &IsHeapReferenceMarkedCallback, this);
+}
+
+void ConcurrentCopying::MarkRootCallback(mirror::Object** root, void* arg,
+                                         const RootInfo& /*root_info*/) {
+  mirror::Object* ref = reinterpret_cast<ConcurrentCopying*>(arg)->Mark(*root);
+  if (ref != *root) {
+    *root = ref;
+  }
+}
+
+void ConcurrentCopying::MarkHeapReferenceCallback(mirror::HeapReference<mirror::Object>* ref,
+                                                  void* arg) {
+  mirror::Object* from_ref = ref->AsMirrorPtr();
+  mirror::Object* to_ref = reinterpret_cast<ConcurrentCopying*>(arg)->Mark(from_ref);
+  if (to_ref != from_ref) {
+    ref->Assign(to_ref);
+  }
+}
+
+mirror::Object* ConcurrentCopying::MarkObjectCallback(mirror::Object* obj, void* arg) {
+  return reinterpret_cast<ConcurrentCopying*>(arg)->Mark(obj);
+}
+
+void ConcurrentCopying::ProcessMarkStackCallback(void* arg) {
+  reinterpret_cast<ConcurrentCopying*>(arg)->ProcessGrayStack();
+}
+
+bool ConcurrentCopying::IsHeapReferenceMarkedCallback(mirror::HeapReference<mirror::Object>* ref,
+                                                      void* arg) {
+  mirror::Object* obj = ref->AsMirrorPtr();
+  mirror::Object* new_obj = reinterpret_cast<ConcurrentCopying*>(arg)->IsMarked(obj);
+  if (new_obj == nullptr) {
+    return false;
+  }
+  if (new_obj != obj) {
+    // Write barrier is not necessary since it still points to the same object, just at a different
+    // address.
+    ref->Assign(new_obj);
+  }
+  return true;
+}
+
+mirror::Object* ConcurrentCopying::IsMarkedCallback(mirror::Object* obj, void* arg) {
+  return reinterpret_cast<ConcurrentCopying*>(arg)->IsMarked(obj);
+}
+
 }  // namespace collector
 }  // namespace gc
 }  // namespace art
@@ -17,32 +17,144 @@
 #ifndef ART_RUNTIME_GC_COLLECTOR_CONCURRENT_COPYING_H_
 #define ART_RUNTIME_GC_COLLECTOR_CONCURRENT_COPYING_H_
 
+#include "base/macros.h"
+#include "base/mutex.h"
 #include "garbage_collector.h"
+#include "gc_root.h"
+#include "globals.h"
+#include "immune_region.h"
+#include "object_callbacks.h"
+#include "offsets.h"
 
 namespace art {
+
+class Thread;
+
+namespace mirror {
+  class Class;
+  class Object;
+  class Reference;
+}  // namespace mirror
+
 namespace gc {
+
+class Heap;
+
+namespace accounting {
+  template<typename T> class AtomicStack;
+  typedef AtomicStack<mirror::Object*> ObjectStack;
+  class HeapBitmap;
+  template<size_t kAlignment> class SpaceBitmap;
+  typedef SpaceBitmap<kLargeObjectAlignment> LargeObjectBitmap;
+}  // namespace accounting
+
+namespace space {
+  class ContinuousMemMapAllocSpace;
+}  // namespace space
+
 namespace collector {
 
+// Copies the reachable objects of the bump pointer space to the other bump pointer space, and
+// marks and sweeps the other spaces, with the mutators suspended for the whole collection.
+//
+// Despite its name the collector is not concurrent. That needs read barriers in compiled code and
+// the assembly stubs, which still load references without them, and a to-space reserve for the
+// objects copied while the mutators allocate.
 class ConcurrentCopying : public GarbageCollector {
  public:
   explicit ConcurrentCopying(Heap* heap, bool generational = false,
-                             const std::string& name_prefix = "")
-      : GarbageCollector(heap,
-                         name_prefix + (name_prefix.empty() ? "" : " ") +
-                         "concurrent copying + mark sweep") {}
+                             const std::string& name_prefix = "");
 
   ~ConcurrentCopying() {}
 
-  virtual void RunPhases() OVERRIDE {}
+  virtual void RunPhases() OVERRIDE NO_THREAD_SAFETY_ANALYSIS;
   virtual GcType GetGcType() const OVERRIDE {
     return kGcTypePartial;
   }
   virtual CollectorType GetCollectorType() const OVERRIDE {
     return kCollectorTypeCC;
   }
-  virtual void RevokeAllThreadLocalBuffers() OVERRIDE {}
+  virtual void RevokeAllThreadLocalBuffers() OVERRIDE;
+
+  // Sets which bump pointer space to copy from, and which to copy to. The heap swaps them at the
+  // flip.
+  void SetFromSpace(space::ContinuousMemMapAllocSpace* from_space);
+  void SetToSpace(space::ContinuousMemMapAllocSpace* to_space);
+
+  // Returns the to-space address of an object, copying it out of the from-space if needed, and
+  // marks it if it is in a non-moving space.
+  mirror::Object* Mark(mirror::Object* from_ref) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
  private:
+  void InitializePhase();
+  // Binds the bitmaps and flips the roots to the to-space.
+  void FlipPhase() EXCLUSIVE_LOCKS_REQUIRED(Locks::mutator_lock_);
+  // Scans the immune spaces and the gray objects, and processes references and system weaks.
+  void MarkingPhase() EXCLUSIVE_LOCKS_REQUIRED(Locks::mutator_lock_);
+  // Frees the from-space and sweeps the other spaces.
+  void ReclaimPhase() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  void FinishPhase();
+
+  void BindBitmaps() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  mirror::Object* Copy(mirror::Object* from_ref) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  mirror::Object* GetForwardingAddress(mirror::Object* from_ref)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Sets the mark bit of an object in a non-moving space. Returns true if it was not set before.
+  bool TestAndMarkNonMoving(mirror::Object* obj);
+  bool IsMarkedNonMoving(mirror::Object* obj);
+  void PushGray(mirror::Object* obj);
+  void ExpandGrayStack();
+
+  // Forwards and marks the references of a gray object.
+  void ScanObject(mirror::Object* obj) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  void ProcessField(mirror::Object* obj, MemberOffset offset)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  void ProcessGrayStack() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  void DelayReferenceReferent(mirror::Class* klass, mirror::Reference* reference)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Returns the address of a marked object, or null if it is unmarked.
+  mirror::Object* IsMarked(mirror::Object* obj) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  void MarkRoots() EXCLUSIVE_LOCKS_REQUIRED(Locks::mutator_lock_);
+  void ProcessReferences() EXCLUSIVE_LOCKS_REQUIRED(Locks::mutator_lock_);
+  void SweepSystemWeaks() EXCLUSIVE_LOCKS_REQUIRED(Locks::mutator_lock_);
+  void Sweep() EXCLUSIVE_LOCKS_REQUIRED(Locks::heap_bitmap_lock_)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  static void MarkRootCallback(mirror::Object** root, void* arg, const RootInfo& root_info)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  static void MarkHeapReferenceCallback(mirror::HeapReference<mirror::Object>* ref, void* arg)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  static mirror::Object* MarkObjectCallback(mirror::Object* obj, void* arg)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  static void ProcessMarkStackCallback(void* arg) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  static bool IsHeapReferenceMarkedCallback(mirror::HeapReference<mirror::Object>* ref, void* arg)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  static mirror::Object* IsMarkedCallback(mirror::Object* obj, void* arg)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  space::ContinuousMemMapAllocSpace* from_space_;
+  space::ContinuousMemMapAllocSpace* to_space_;
+
+  accounting::HeapBitmap* mark_bitmap_;
+  accounting::LargeObjectBitmap* large_object_mark_bitmap_;
+
+  ImmuneRegion immune_region_;
+
+  // The collector thread.
+  Thread* self_;
+
+  // Objects copied or marked but not scanned yet, the heap's mark stack.
+  accounting::ObjectStack* gray_stack_;
+
+  // How many objects and bytes were copied, for the freed object and byte counts.
+  size_t objects_moved_;
+  size_t bytes_moved_;
+
+  friend class ConcurrentCopyingRefFieldsVisitor;
   DISALLOW_COPY_AND_ASSIGN(ConcurrentCopying);
 };
 
@@ -64,6 +64,11 @@ static constexpr bool kParallelRecursiveMark = true;
 // ProcessMarkStack with very small mark stacks.
 static constexpr size_t kMinimumParallelMarkStackSize = 128;
 static constexpr bool kParallelProcessMarkStack = true;
+static constexpr bool kParallelModUnion = true;
+// How many tasks to split parallel work into per thread. Threads which run out of tasks steal
+// from the others, so smaller tasks even out the work where it isn't spread uniformly, such as
+// dirty cards.
+static constexpr size_t kTasksPerThread = 4;
 
 // Profiling and information flags.
 static constexpr bool kProfileLargeObjects = false;
@@ -261,6 +266,7 @@ void MarkSweep::MarkingPhase() {
 }
 
 void MarkSweep::UpdateAndMarkModUnion() {
+  const size_t thread_count = GetThreadCount(false);
   for (const auto& space : heap_->GetContinuousSpaces()) {
     if (immune_region_.ContainsSpace(space)) {
       const char* name = space->IsZygoteSpace() ? "UpdateAndMarkZygoteModUnionTable" :
@@ -268,7 +274,11 @@ void MarkSweep::UpdateAndMarkModUnion() {
       TimingLogger::ScopedTiming t(name, GetTimings());
       accounting::ModUnionTable* mod_union_table = heap_->FindModUnionTableFromSpace(space);
       CHECK(mod_union_table != nullptr);
-      mod_union_table->UpdateAndMarkReferences(MarkHeapReferenceCallback, this);
+      if (kParallelModUnion && thread_count > 1) {
+        UpdateAndMarkModUnionParallel(mod_union_table, thread_count);
+      } else {
+        mod_union_table->UpdateAndMarkReferences(MarkHeapReferenceCallback, this);
+      }
     }
   }
 }
@@ -711,6 +721,62 @@ class CardScanTask : public MarkStackTask<false> {
   }
 };
 
+class ModUnionMarkTask : public MarkStackTask<false> {
+ public:
+  ModUnionMarkTask(ThreadPool* thread_pool, MarkSweep* mark_sweep,
+                   accounting::ModUnionTable* mod_union_table, size_t begin, size_t end)
+      : MarkStackTask<false>(thread_pool, mark_sweep, 0, nullptr),
+        mod_union_table_(mod_union_table),
+        begin_(begin),
+        end_(end) {
+  }
+
+ protected:
+  accounting::ModUnionTable* const mod_union_table_;
+  const size_t begin_;
+  const size_t end_;
+
+  virtual void Finalize() {
+    delete this;
+  }
+
+  static void MarkHeapReferenceCallback(mirror::HeapReference<mirror::Object>* ref, void* arg)
+      NO_THREAD_SAFETY_ANALYSIS {
+    ModUnionMarkTask* task = reinterpret_cast<ModUnionMarkTask*>(arg);
+    mirror::Object* obj = ref->AsMirrorPtr();
+    if (obj != nullptr && task->mark_sweep_->MarkObjectParallel(obj)) {
+      task->MarkStackPush(obj);
+    }
+  }
+
+  virtual void Run(Thread* self) NO_THREAD_SAFETY_ANALYSIS {
+    mod_union_table_->MarkReferences(begin_, end_, MarkHeapReferenceCallback, this);
+    // Finish by emptying our local mark stack.
+    MarkStackTask::Run(self);
+  }
+};
+
+void MarkSweep::UpdateAndMarkModUnionParallel(accounting::ModUnionTable* mod_union_table,
+                                              size_t thread_count) {
+  Thread* self = Thread::Current();
+  ThreadPool* thread_pool = GetHeap()->GetThreadPool();
+  size_t chunks;
+  {
+    TimingLogger::ScopedTiming t("UpdateModUnionTable", GetTimings());
+    chunks = mod_union_table->UpdateReferences();
+  }
+  const size_t chunks_per_task = chunks / (thread_count * kTasksPerThread) + 1;
+  for (size_t begin = 0; begin < chunks; begin += chunks_per_task) {
+    auto* task = new ModUnionMarkTask(thread_pool, this, mod_union_table, begin,
+                                      std::min(begin + chunks_per_task, chunks));
+    thread_pool->AddTask(self, task);
+  }
+  thread_pool->SetMaxActiveWorkers(thread_count - 1);
+  thread_pool->StartWorkers(self);
+  thread_pool->Wait(self, true, true);
+  thread_pool->StopWorkers(self);
+}
+
 size_t MarkSweep::GetThreadCount(bool paused) const {
   if (heap_->GetThreadPool() == nullptr || !heap_->CareAboutPauseTimes()) {
     return 1;
@@ -738,7 +804,8 @@ void MarkSweep::ScanGrayObjects(bool paused, byte minimum_age) {
     Object** mark_stack_end = mark_stack_->End();
     const size_t mark_stack_size = mark_stack_end - mark_stack_begin;
     // Estimated number of work tasks we will create.
-    const size_t mark_stack_tasks = GetHeap()->GetContinuousSpaces().size() * thread_count;
+    const size_t mark_stack_tasks =
+        GetHeap()->GetContinuousSpaces().size() * thread_count * kTasksPerThread;
     DCHECK_NE(mark_stack_tasks, 0U);
     const size_t mark_stack_delta = std::min(CardScanTask::kMaxSize / 2,
                                              mark_stack_size / mark_stack_tasks + 1);
@@ -756,7 +823,7 @@ void MarkSweep::ScanGrayObjects(bool paused, byte minimum_age) {
       // Calculate how many bytes of heap we will scan,
       const size_t address_range = card_end - card_begin;
       // Calculate how much address range each task gets.
-      const size_t card_delta = RoundUp(address_range / thread_count + 1,
+      const size_t card_delta = RoundUp(address_range / (thread_count * kTasksPerThread) + 1,
                                         accounting::CardTable::kCardSize);
       // Create the worker tasks for this space.
       while (card_begin != card_end) {
@@ -1166,7 +1233,7 @@ void MarkSweep::ProcessMarkStackCallback(void* arg) {
 void MarkSweep::ProcessMarkStackParallel(size_t thread_count) {
   Thread* self = Thread::Current();
   ThreadPool* thread_pool = GetHeap()->GetThreadPool();
-  const size_t chunk_size = std::min(mark_stack_->Size() / thread_count + 1,
+  const size_t chunk_size = std::min(mark_stack_->Size() / (thread_count * kTasksPerThread) + 1,
                                      static_cast<size_t>(MarkStackTask<false>::kMaxSize));
   CHECK_GT(chunk_size, 0U);
   // Split the current mark stack up into work tasks.
@@ -47,6 +47,7 @@ class Heap;
 
 namespace accounting {
   template<typename T> class AtomicStack;
+  class ModUnionTable;
   typedef AtomicStack<mirror::Object*> ObjectStack;
 }  // namespace accounting
 
@@ -129,6 +130,12 @@ class MarkSweep : public GarbageCollector {
   void UpdateAndMarkModUnion()
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
+  // Update a mod-union table, then mark its references with the thread pool.
+  void UpdateAndMarkModUnionParallel(accounting::ModUnionTable* mod_union_table,
+                                     size_t thread_count)
+      EXCLUSIVE_LOCKS_REQUIRED(Locks::heap_bitmap_lock_)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
   // Pre clean cards to reduce how much work is needed in the pause.
   void PreCleanCards()
       EXCLUSIVE_LOCKS_REQUIRED(Locks::heap_bitmap_lock_)
@@ -325,6 +332,7 @@ class MarkSweep : public GarbageCollector {
   friend class MarkObjectVisitor;
   friend class ModUnionCheckReferences;
   friend class ModUnionClearCardVisitor;
+  friend class ModUnionMarkTask;
   friend class ModUnionReferenceVisitor;
   friend class ModUnionVisitor;
   friend class ModUnionTableBitmap;
@@ -24,6 +24,7 @@
 #include "base/logging.h"
 #include "base/macros.h"
 #include "base/mutex-inl.h"
+#include "base/stringprintf.h"
 #include "base/timing_logger.h"
 #include "gc/accounting/heap_bitmap-inl.h"
 #include "gc/accounting/mod_union_table.h"
@@ -85,19 +86,26 @@ void SemiSpace::BindBitmaps() {
   }
 }
 
-SemiSpace::SemiSpace(Heap* heap, bool generational, const std::string& name_prefix)
+SemiSpace::SemiSpace(Heap* heap, bool generational, const std::string& name_prefix,
+                     size_t tenuring_threshold)
     : GarbageCollector(heap,
                        name_prefix + (name_prefix.empty() ? "" : " ") + "marksweep + semispace"),
       to_space_(nullptr),
       from_space_(nullptr),
       generational_(generational),
       last_gc_to_space_end_(nullptr),
+      tenuring_threshold_(tenuring_threshold),
+      age_bits_(tenuring_threshold <= 1 ? 0 : 32 - CLZ<uint32_t>(tenuring_threshold - 1)),
+      from_space_ages_(nullptr),
+      to_space_ages_(nullptr),
       bytes_promoted_(0),
       bytes_promoted_since_last_whole_heap_collection_(0),
       large_object_bytes_allocated_at_last_whole_heap_collection_(0),
       collect_from_space_only_(generational),
       collector_name_(name_),
       swap_semi_spaces_(true) {
+  CHECK_GE(tenuring_threshold_, 1U);
+  CHECK_LE(age_bits_, kMaxAgeBits);
 }
 
 void SemiSpace::RunPhases() {
@@ -209,6 +217,16 @@ void SemiSpace::MarkingPhase() {
     if (!from_space_->HasAddress(reinterpret_cast<mirror::Object*>(last_gc_to_space_end_))) {
       last_gc_to_space_end_ = from_space_->Begin();
     }
+    if (age_bits_ != 0) {
+      from_space_ages_ = GetSurvivorAges(from_space_);
+      to_space_ages_ = GetSurvivorAges(to_space_);
+      if (to_space_ages_ != nullptr) {
+        // Left over from when the to-space was last the from-space.
+        for (size_t i = 0; i < age_bits_; ++i) {
+          to_space_ages_->bits[i]->Clear();
+        }
+      }
+    }
     // Reset this before the marking starts below.
     bytes_promoted_ = 0;
   }
@@ -477,12 +495,60 @@ static inline size_t CopyAvoidingDirtyingPages(void* dest, const void* src, size
   return saved_bytes;
 }
 
+size_t SemiSpace::GetAge(const mirror::Object* obj) const {
+  if (reinterpret_cast<const byte*>(obj) >= last_gc_to_space_end_) {
+    // Allocated since the last GC.
+    return 0;
+  }
+  size_t age = 1;
+  if (from_space_ages_ != nullptr) {
+    for (size_t i = 0; i < age_bits_; ++i) {
+      if (from_space_ages_->bits[i]->Test(obj)) {
+        age += static_cast<size_t>(1) << i;
+      }
+    }
+  }
+  return age;
+}
+
+void SemiSpace::SetAge(const mirror::Object* obj, size_t age) {
+  if (to_space_ages_ == nullptr) {
+    return;
+  }
+  // All the ages from the tenuring threshold on mean promotion at the next GC.
+  const size_t value = std::min(age, tenuring_threshold_) - 1;
+  for (size_t i = 0; i < age_bits_; ++i) {
+    if ((value & (static_cast<size_t>(1) << i)) != 0) {
+      to_space_ages_->bits[i]->Set(obj);
+    }
+  }
+}
+
+SemiSpace::SurvivorAges* SemiSpace::GetSurvivorAges(space::ContinuousMemMapAllocSpace* space) {
+  if (!space->IsBumpPointerSpace()) {
+    return nullptr;
+  }
+  SurvivorAges* ages = &survivor_ages_[space];
+  const uintptr_t begin = reinterpret_cast<uintptr_t>(space->Begin());
+  const size_t capacity = space->Limit() - space->Begin();
+  if (ages->bits[0].get() == nullptr || ages->bits[0]->HeapBegin() != begin ||
+      ages->bits[0]->HeapSize() != capacity) {
+    for (size_t i = 0; i < age_bits_; ++i) {
+      ages->bits[i].reset(accounting::ContinuousSpaceBitmap::Create(
+          StringPrintf("%s survivor age bit %zu", space->GetName(), i), space->Begin(), capacity));
+      CHECK(ages->bits[i].get() != nullptr) << "Failed to create age bitmap for " << *space;
+    }
+  }
+  return ages;
+}
+
 mirror::Object* SemiSpace::MarkNonForwardedObject(mirror::Object* obj) {
   const size_t object_size = obj->SizeOf();
   size_t bytes_allocated;
   mirror::Object* forward_address = nullptr;
-  if (generational_ && reinterpret_cast<byte*>(obj) < last_gc_to_space_end_) {
-    // If it's allocated before the last GC (older), move
+  const size_t age = generational_ ? GetAge(obj) : 0;
+  if (generational_ && age >= tenuring_threshold_) {
+    // If it survived enough collections (older), move
     // (pseudo-promote) it to the main free list space (as sort
     // of an old generation.)
     forward_address = promo_dest_space_->AllocThreadUnsafe(self_, object_size, &bytes_allocated,
@@ -492,6 +558,9 @@ mirror::Object* SemiSpace::MarkNonForwardedObject(mirror::Object* obj) {
       forward_address = to_space_->AllocThreadUnsafe(self_, object_size, &bytes_allocated, nullptr);
       // No logic for marking the bitmap, so it must be null.
       DCHECK(to_space_live_bitmap_ == nullptr);
+      if (forward_address != nullptr) {
+        SetAge(forward_address, age + 1);
+      }
     } else {
       bytes_promoted_ += bytes_allocated;
       // Dirty the card at the destionation as it may contain
@@ -533,10 +602,13 @@ mirror::Object* SemiSpace::MarkNonForwardedObject(mirror::Object* obj) {
       }
     }
   } else {
-    // If it's allocated after the last GC (younger), copy it to the to-space.
+    // If it's younger, copy it to the to-space.
     forward_address = to_space_->AllocThreadUnsafe(self_, object_size, &bytes_allocated, nullptr);
-    if (forward_address != nullptr && to_space_live_bitmap_ != nullptr) {
-      to_space_live_bitmap_->Set(forward_address);
+    if (forward_address != nullptr) {
+      if (to_space_live_bitmap_ != nullptr) {
+        to_space_live_bitmap_->Set(forward_address);
+      }
+      SetAge(forward_address, age + 1);
     }
   }
   // If it's still null, attempt to use the fallback space.
@@ -17,6 +17,7 @@
 #ifndef ART_RUNTIME_GC_COLLECTOR_SEMI_SPACE_H_
 #define ART_RUNTIME_GC_COLLECTOR_SEMI_SPACE_H_
 
+#include <map>
 #include <memory>
 
 #include "atomic.h"
@@ -60,7 +61,13 @@ class SemiSpace : public GarbageCollector {
   // If true, use remembered sets in the generational mode.
   static constexpr bool kUseRememberedSet = true;
 
-  explicit SemiSpace(Heap* heap, bool generational = false, const std::string& name_prefix = "");
+  // In the generational mode, objects are promoted once they survived this many collections in
+  // the bump pointer spaces. Set with -XX:MaxTenuringThreshold.
+  static constexpr size_t kDefaultTenuringThreshold = 1;
+  static constexpr size_t kMaxTenuringThreshold = 8;
+
+  explicit SemiSpace(Heap* heap, bool generational = false, const std::string& name_prefix = "",
+                     size_t tenuring_threshold = kDefaultTenuringThreshold);
 
   ~SemiSpace() {}
 
@@ -152,6 +159,25 @@ class SemiSpace : public GarbageCollector {
   virtual mirror::Object* MarkNonForwardedObject(mirror::Object* obj)
       EXCLUSIVE_LOCKS_REQUIRED(Locks::heap_bitmap_lock_, Locks::mutator_lock_);
 
+  // Used for the generational mode with a tenuring threshold above one. The ages of the objects
+  // in a bump pointer space which survived at least one collection are kept to the side, since
+  // the lock word has no spare bits for them: bit i of the age less one is set in bits[i].
+  // Objects allocated since the last collection have age zero.
+  static constexpr size_t kMaxAgeBits = 3;
+  struct SurvivorAges {
+    std::unique_ptr<accounting::ContinuousSpaceBitmap> bits[kMaxAgeBits];
+  };
+
+  // The number of collections the from-space object survived in the bump pointer spaces, up to
+  // the tenuring threshold.
+  size_t GetAge(const mirror::Object* obj) const;
+
+  // Records the age of an object copied to the to-space.
+  void SetAge(const mirror::Object* obj, size_t age);
+
+  // Returns the age bit planes of a bump pointer space, creating them if needed, or null.
+  SurvivorAges* GetSurvivorAges(space::ContinuousMemMapAllocSpace* space);
+
   // Schedules an unmarked object for reference processing.
   void DelayReferenceReferent(mirror::Class* klass, mirror::Reference* reference)
       SHARED_LOCKS_REQUIRED(Locks::heap_bitmap_lock_, Locks::mutator_lock_);
@@ -230,6 +256,18 @@ class SemiSpace : public GarbageCollector {
   // pointer space at the end of the last collection.
   byte* last_gc_to_space_end_;
 
+  // Used for the generational mode. The number of collections an
+  // object survives in the bump pointer spaces before it is promoted.
+  const size_t tenuring_threshold_;
+
+  // How many of the bit planes are used, enough for ages up to the
+  // tenuring threshold.
+  const size_t age_bits_;
+  std::map<space::ContinuousMemMapAllocSpace*, SurvivorAges> survivor_ages_;
+  // Cached for the current collection, null if ages are not kept.
+  SurvivorAges* from_space_ages_;
+  SurvivorAges* to_space_ages_;
+
   // Used for the generational mode. During a collection, keeps track
   // of how many bytes of objects have been copied so far from the
   // bump pointer space to the non-moving space.
@@ -119,12 +119,14 @@ Heap::Heap(size_t initial_size, size_t growth_limit, size_t min_free, size_t max
            const InstructionSet image_instruction_set, CollectorType foreground_collector_type,
            CollectorType background_collector_type, size_t parallel_gc_threads,
            size_t conc_gc_threads, bool low_memory_mode,
+           size_t rosalloc_thread_local_run_threshold,
            size_t long_pause_log_threshold, size_t long_gc_log_threshold,
            bool ignore_max_footprint, bool use_tlab,
            bool verify_pre_gc_heap, bool verify_pre_sweeping_heap, bool verify_post_gc_heap,
            bool verify_pre_gc_rosalloc, bool verify_pre_sweeping_rosalloc,
            bool verify_post_gc_rosalloc, bool use_homogeneous_space_compaction_for_oom,
-           uint64_t min_interval_homogeneous_space_compaction_by_oom)
+           uint64_t min_interval_homogeneous_space_compaction_by_oom,
+           size_t tenuring_threshold)
     : non_moving_space_(nullptr),
       rosalloc_space_(nullptr),
       dlmalloc_space_(nullptr),
@@ -140,6 +142,7 @@ Heap::Heap(size_t initial_size, size_t growth_limit, size_t min_free, size_t max
       parallel_gc_threads_(parallel_gc_threads),
       conc_gc_threads_(conc_gc_threads),
       low_memory_mode_(low_memory_mode),
+      rosalloc_thread_local_run_threshold_(rosalloc_thread_local_run_threshold),
       long_pause_log_threshold_(long_pause_log_threshold),
       long_gc_log_threshold_(long_gc_log_threshold),
       ignore_max_footprint_(ignore_max_footprint),
@@ -293,7 +296,8 @@ Heap::Heap(size_t initial_size, size_t growth_limit, size_t min_free, size_t max
   CHECK(main_mem_map_1.get() != nullptr) << error_str;
   if (support_homogeneous_space_compaction ||
       background_collector_type_ == kCollectorTypeSS ||
-      foreground_collector_type_ == kCollectorTypeSS) {
+      foreground_collector_type_ == kCollectorTypeSS ||
+      foreground_collector_type_ == kCollectorTypeCC) {
     main_mem_map_2.reset(MapAnonymousPreferredAddress(kMemMapSpaceName[1], main_mem_map_1->End(),
                                                       capacity_, PROT_READ | PROT_WRITE,
                                                       &error_str));
@@ -425,7 +429,8 @@ Heap::Heap(size_t initial_size, size_t growth_limit, size_t min_free, size_t max
     // TODO: Clean this up.
     const bool generational = foreground_collector_type_ == kCollectorTypeGSS;
     semi_space_collector_ = new collector::SemiSpace(this, generational,
-                                                     generational ? "generational" : "");
+                                                     generational ? "generational" : "",
+                                                     tenuring_threshold);
     garbage_collectors_.push_back(semi_space_collector_);
     concurrent_copying_collector_ = new collector::ConcurrentCopying(this);
     garbage_collectors_.push_back(concurrent_copying_collector_);
@@ -472,7 +477,8 @@ space::MallocSpace* Heap::CreateMallocSpaceFromMemMap(MemMap* mem_map, size_t in
     // Create rosalloc space.
     malloc_space = space::RosAllocSpace::CreateFromMemMap(mem_map, name, kDefaultStartingSize,
                                                           initial_size, growth_limit, capacity,
-                                                          low_memory_mode_, can_move_objects);
+                                                          low_memory_mode_, can_move_objects,
+                                                          rosalloc_thread_local_run_threshold_);
   } else {
     malloc_space = space::DlMallocSpace::CreateFromMemMap(mem_map, name, kDefaultStartingSize,
                                                           initial_size, growth_limit, capacity,
@@ -870,6 +876,9 @@ void Heap::DumpGcPerformanceInfo(std::ostream& os) {
   }
   os << "Total mutator paused time: " << PrettyDuration(total_paused_time) << "\n";
   os << "Total time waiting for GC to complete: " << PrettyDuration(total_wait_time_) << "\n";
+  if (rosalloc_space_ != nullptr) {
+    rosalloc_space_->DumpStats(os);
+  }
   BaseMutex::DumpAll(os);
 }
 
@@ -1805,7 +1814,13 @@ void Heap::ChangeCollector(CollectorType collector_type) {
     collector_type_ = collector_type;
     gc_plan_.clear();
     switch (collector_type_) {
-      case kCollectorTypeCC:  // Fall-through.
+      case kCollectorTypeCC: {
+        gc_plan_.push_back(collector::kGcTypeFull);
+        // The collector copies objects into the space the mutators allocate in. It may only be
+        // walked if neither uses thread-local buffers.
+        ChangeAllocator(kAllocatorTypeBumpPointer);
+        break;
+      }
       case kCollectorTypeMC:  // Fall-through.
       case kCollectorTypeSS:  // Fall-through.
       case kCollectorTypeGSS: {
@@ -2191,6 +2206,8 @@ collector::GcType Heap::CollectGarbageInternal(collector::GcType gc_type, GcCaus
         collector = semi_space_collector_;
         break;
       case kCollectorTypeCC:
+        concurrent_copying_collector_->SetFromSpace(bump_pointer_space_);
+        concurrent_copying_collector_->SetToSpace(temp_space_);
         collector = concurrent_copying_collector_;
         break;
       case kCollectorTypeMC:
@@ -161,12 +161,14 @@ class Heap {
                 InstructionSet image_instruction_set,
                 CollectorType foreground_collector_type, CollectorType background_collector_type,
                 size_t parallel_gc_threads, size_t conc_gc_threads, bool low_memory_mode,
+                size_t rosalloc_thread_local_run_threshold,
                 size_t long_pause_threshold, size_t long_gc_threshold,
                 bool ignore_max_footprint, bool use_tlab,
                 bool verify_pre_gc_heap, bool verify_pre_sweeping_heap, bool verify_post_gc_heap,
                 bool verify_pre_gc_rosalloc, bool verify_pre_sweeping_rosalloc,
                 bool verify_post_gc_rosalloc, bool use_homogeneous_space_compaction,
-                uint64_t min_interval_homogeneous_space_compaction_by_oom);
+                uint64_t min_interval_homogeneous_space_compaction_by_oom,
+                size_t tenuring_threshold);
 
   ~Heap();
 
@@ -537,6 +539,10 @@ class Heap {
     return large_object_space_;
   }
 
+  collector::ConcurrentCopying* ConcurrentCopyingCollector() {
+    return concurrent_copying_collector_;
+  }
+
   // Returns the free list space that may contain movable objects (the
   // one that's not the non-moving space), either rosalloc_space_ or
   // dlmalloc_space_.
@@ -770,7 +776,7 @@ class Heap {
   // What kind of concurrency behavior is the runtime after? Currently true for concurrent mark
   // sweep GC, false for other GC types.
   bool IsGcConcurrent() const ALWAYS_INLINE {
-    return collector_type_ == kCollectorTypeCMS || collector_type_ == kCollectorTypeCC;
+    return collector_type_ == kCollectorTypeCMS;
   }
 
   // All-known continuous spaces, where objects lie within fixed bounds.
@@ -837,6 +843,9 @@ class Heap {
   // Boolean for if we are in low memory mode.
   const bool low_memory_mode_;
 
+  // Size brackets up to this many bytes use thread-local runs in the RosAlloc spaces.
+  const size_t rosalloc_thread_local_run_threshold_;
+
   // If we get a pause longer than long pause log threshold, then we print out the GC after it
   // finishes.
   const size_t long_pause_log_threshold_;
@@ -1046,6 +1055,7 @@ class Heap {
   // Whether or not we use homogeneous space compaction to avoid OOM errors.
   bool use_homogeneous_space_compaction_for_oom_;
 
+  friend class collector::ConcurrentCopying;
   friend class collector::GarbageCollector;
   friend class collector::MarkCompact;
   friend class collector::MarkSweep;
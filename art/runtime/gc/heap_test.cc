@@ -14,14 +14,19 @@
  * limitations under the License.
  */
 
+#include "base/histogram-inl.h"
+#include "base/stringprintf.h"
 #include "common_runtime_test.h"
 #include "gc/accounting/card_table-inl.h"
+#include "gc/collector/concurrent_copying.h"
 #include "gc/accounting/space_bitmap-inl.h"
+#include "gc/space/space-inl.h"
 #include "handle_scope-inl.h"
 #include "mirror/class-inl.h"
 #include "mirror/object-inl.h"
 #include "mirror/object_array-inl.h"
 #include "scoped_thread_state_change.h"
+#include "thread_pool.h"
 
 namespace art {
 namespace gc {
@@ -71,5 +76,195 @@ TEST_F(HeapTest, HeapBitmapCapacityTest) {
   bitmap->Set(fake_end_of_heap_object);
 }
 
+class ParallelMarkingHeapTest : public HeapTest {
+ protected:
+  void SetUpRuntimeOptions(RuntimeOptions* options) OVERRIDE {
+    options->push_back(std::make_pair("-XX:ParallelGCThreads=4", nullptr));
+    options->push_back(std::make_pair("-XX:ConcGCThreads=4", nullptr));
+  }
+};
+
+// Marking split across the GC threads keeps everything reachable, through chains longer than
+// the mark stack of a single task.
+TEST_F(ParallelMarkingHeapTest, CollectKeepsReachableObjects) {
+  static const size_t kLinks = 4096;
+  static const size_t kStringsPerLink = 15;
+  ScopedObjectAccess soa(Thread::Current());
+  Thread* self = soa.Self();
+  StackHandleScope<3> hs(self);
+  Handle<mirror::Class> c(
+      hs.NewHandle(class_linker_->FindSystemClass(self, "[Ljava/lang/Object;")));
+  Handle<mirror::ObjectArray<mirror::Object>> head(
+      hs.NewHandle(mirror::ObjectArray<mirror::Object>::Alloc(self, c.Get(), kStringsPerLink + 1)));
+  ASSERT_TRUE(head.Get() != nullptr);
+  {
+    Handle<mirror::ObjectArray<mirror::Object>> link(hs.NewHandle(head.Get()));
+    for (size_t i = 0; i < kLinks; ++i) {
+      for (size_t j = 0; j < kStringsPerLink; ++j) {
+        mirror::String* string = mirror::String::AllocFromModifiedUtf8(self, "reachable");
+        ASSERT_TRUE(string != nullptr);
+        link->Set<false>(j, string);
+        // Garbage in between.
+        ASSERT_TRUE(mirror::String::AllocFromModifiedUtf8(self, "garbage") != nullptr);
+      }
+      if (i + 1 < kLinks) {
+        mirror::ObjectArray<mirror::Object>* next =
+            mirror::ObjectArray<mirror::Object>::Alloc(self, c.Get(), kStringsPerLink + 1);
+        ASSERT_TRUE(next != nullptr);
+        link->Set<false>(kStringsPerLink, next);
+        link.Assign(next);
+      }
+    }
+  }
+  for (int gc = 0; gc < 3; ++gc) {
+    Runtime::Current()->GetHeap()->CollectGarbage(false);
+  }
+
+  size_t links = 0;
+  for (mirror::ObjectArray<mirror::Object>* link = head.Get(); link != nullptr;
+       link = down_cast<mirror::ObjectArray<mirror::Object>*>(link->Get(kStringsPerLink))) {
+    for (size_t j = 0; j < kStringsPerLink; ++j) {
+      mirror::Object* string = link->Get(j);
+      ASSERT_TRUE(string != nullptr);
+      ASSERT_TRUE(string->AsString()->Equals("reachable"));
+    }
+    ++links;
+  }
+  EXPECT_EQ(kLinks, links);
+}
+
+class GenerationalHeapTest : public HeapTest {
+ protected:
+  void SetUpRuntimeOptions(RuntimeOptions* options) OVERRIDE {
+    options->push_back(std::make_pair("-Xgc:GSS", nullptr));
+    options->push_back(std::make_pair("-XX:MaxTenuringThreshold=3", nullptr));
+  }
+};
+
+// An object stays in the nursery through as many collections as the tenuring threshold, and
+// moves to the main space at the next one.
+TEST_F(GenerationalHeapTest, PromotesByAge) {
+  ScopedObjectAccess soa(Thread::Current());
+  Thread* self = soa.Self();
+  Heap* heap = Runtime::Current()->GetHeap();
+  StackHandleScope<1> hs(self);
+  Handle<mirror::String> string(
+      hs.NewHandle(mirror::String::AllocFromModifiedUtf8(self, "tenured")));
+  ASSERT_TRUE(string.Get() != nullptr);
+  for (int gc = 0; gc <= 3; ++gc) {
+    EXPECT_TRUE(heap->FindContinuousSpaceFromObject(string.Get(), false)->IsBumpPointerSpace())
+        << gc;
+    heap->CollectGarbage(false);
+  }
+  EXPECT_FALSE(heap->FindContinuousSpaceFromObject(string.Get(), false)->IsBumpPointerSpace());
+  EXPECT_TRUE(string->Equals("tenured"));
+}
+
+class ConcurrentCopyingHeapTest : public HeapTest {
+ protected:
+  void SetUpRuntimeOptions(RuntimeOptions* options) OVERRIDE {
+    options->push_back(std::make_pair("-Xgc:CC", nullptr));
+  }
+
+  // Has "threads" threads build and check lists while the main thread collects "collections"
+  // times.
+  void CollectWhileMutating(size_t threads, size_t collections);
+};
+
+// Builds linked lists of arrays holding strings, and checks every element of a list before
+// dropping it, while the objects move under it.
+class MutatorTask : public Task {
+ public:
+  explicit MutatorTask(size_t lists) : lists_(lists) {}
+
+  void Run(Thread* self) {
+    static const size_t kLinks = 256;
+    static const size_t kStringsPerLink = 7;
+    ScopedObjectAccess soa(self);
+    StackHandleScope<3> hs(self);
+    Handle<mirror::Class> c(hs.NewHandle(
+        Runtime::Current()->GetClassLinker()->FindSystemClass(self, "[Ljava/lang/Object;")));
+    CHECK(c.Get() != nullptr);
+    Handle<mirror::ObjectArray<mirror::Object>> head(
+        hs.NewHandle<mirror::ObjectArray<mirror::Object>>(nullptr));
+    Handle<mirror::ObjectArray<mirror::Object>> link(
+        hs.NewHandle<mirror::ObjectArray<mirror::Object>>(nullptr));
+    for (size_t list = 0; list < lists_; ++list) {
+      head.Assign(nullptr);
+      for (size_t i = 0; i < kLinks; ++i) {
+        link.Assign(mirror::ObjectArray<mirror::Object>::Alloc(self, c.Get(), kStringsPerLink + 1));
+        CHECK(link.Get() != nullptr);
+        link->Set<false>(kStringsPerLink, head.Get());
+        head.Assign(link.Get());
+        for (size_t j = 0; j < kStringsPerLink; ++j) {
+          mirror::String* string =
+              mirror::String::AllocFromModifiedUtf8(self, StringPrintf("%zd.%zd", i, j).c_str());
+          CHECK(string != nullptr);
+          head->Set<false>(j, string);
+        }
+      }
+      size_t i = kLinks;
+      for (mirror::ObjectArray<mirror::Object>* l = head.Get(); l != nullptr;
+           l = down_cast<mirror::ObjectArray<mirror::Object>*>(l->Get(kStringsPerLink))) {
+        CHECK_GT(i, 0U);
+        --i;
+        for (size_t j = 0; j < kStringsPerLink; ++j) {
+          mirror::Object* string = l->Get(j);
+          CHECK(string != nullptr);
+          CHECK(string->AsString()->Equals(StringPrintf("%zd.%zd", i, j)));
+        }
+      }
+      CHECK_EQ(i, 0U);
+    }
+  }
+
+  void Finalize() {
+    delete this;
+  }
+
+ private:
+  const size_t lists_;
+};
+
+void ConcurrentCopyingHeapTest::CollectWhileMutating(size_t threads, size_t collections) {
+  static const size_t kListsPerThread = 16;
+  Thread* self = Thread::Current();
+  ThreadPool thread_pool("Concurrent copying test thread pool", threads);
+  for (size_t i = 0; i < threads; ++i) {
+    thread_pool.AddTask(self, new MutatorTask(kListsPerThread));
+  }
+  thread_pool.StartWorkers(self);
+  Heap* heap = Runtime::Current()->GetHeap();
+  for (size_t i = 0; i < collections; ++i) {
+    heap->CollectGarbage(false);
+  }
+  thread_pool.Wait(self, true, false);
+}
+
+// Objects the mutators reach keep their contents across the collections that move them.
+TEST_F(ConcurrentCopyingHeapTest, CollectWhileMutating) {
+  CollectWhileMutating(4, 20);
+}
+
+// The whole collection runs in a single pause, which stays bounded with mutators allocating. This
+// checks the stop-the-world collector only, it says nothing about concurrent pause times.
+TEST_F(ConcurrentCopyingHeapTest, PauseTimes) {
+  static const uint64_t kMaxPauseUs = 500 * 1000;
+  CollectWhileMutating(4, 50);
+  collector::ConcurrentCopying* collector =
+      Runtime::Current()->GetHeap()->ConcurrentCopyingCollector();
+  const Histogram<uint64_t>& pauses = collector->GetPauseHistogram();
+  ASSERT_GE(collector->NumberOfIterations(), 50U);
+  EXPECT_EQ(collector->NumberOfIterations(), pauses.SampleSize());
+  Histogram<uint64_t>::CumulativeData data;
+  pauses.CreateHistogram(&data);
+  const uint64_t median = pauses.Percentile(0.5, data);
+  const uint64_t percentile_99 = pauses.Percentile(0.99, data);
+  EXPECT_LE(median, percentile_99);
+  EXPECT_LE(percentile_99, kMaxPauseUs)
+      << "99th percentile pause " << PrettyDuration(percentile_99 * 1000);
+  EXPECT_LE(pauses.Max(), kMaxPauseUs) << "max pause " << PrettyDuration(pauses.Max() * 1000);
+}
+
 }  // namespace gc
 }  // namespace art
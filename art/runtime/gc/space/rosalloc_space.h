@@ -40,11 +40,15 @@ class RosAllocSpace : public MallocSpace {
   // request was granted.
   static RosAllocSpace* Create(const std::string& name, size_t initial_size, size_t growth_limit,
                                size_t capacity, byte* requested_begin, bool low_memory_mode,
-                               bool can_move_objects);
+                               bool can_move_objects,
+                               size_t thread_local_run_size_threshold =
+                                   allocator::RosAlloc::kDefaultThreadLocalRunSizeThreshold);
   static RosAllocSpace* CreateFromMemMap(MemMap* mem_map, const std::string& name,
                                          size_t starting_size, size_t initial_size,
                                          size_t growth_limit, size_t capacity,
-                                         bool low_memory_mode, bool can_move_objects);
+                                         bool low_memory_mode, bool can_move_objects,
+                                         size_t thread_local_run_size_threshold =
+                                             allocator::RosAlloc::kDefaultThreadLocalRunSizeThreshold);
 
   mirror::Object* AllocWithGrowth(Thread* self, size_t num_bytes, size_t* bytes_allocated,
                                   size_t* usable_size) OVERRIDE LOCKS_EXCLUDED(lock_);
@@ -124,10 +128,16 @@ class RosAllocSpace : public MallocSpace {
     rosalloc_->LogFragmentationAllocFailure(os, failed_alloc_bytes);
   }
 
+  // Dumps the allocator's per size bracket counters.
+  void DumpStats(std::ostream& os) {
+    rosalloc_->DumpStats(os);
+  }
+
  protected:
   RosAllocSpace(const std::string& name, MemMap* mem_map, allocator::RosAlloc* rosalloc,
                 byte* begin, byte* end, byte* limit, size_t growth_limit, bool can_move_objects,
-                size_t starting_size, size_t initial_size, bool low_memory_mode);
+                size_t starting_size, size_t initial_size, bool low_memory_mode,
+                size_t thread_local_run_size_threshold);
 
  private:
   template<bool kThreadSafe = true>
@@ -136,10 +146,12 @@ class RosAllocSpace : public MallocSpace {
 
   void* CreateAllocator(void* base, size_t morecore_start, size_t initial_size,
                         size_t maximum_size, bool low_memory_mode) OVERRIDE {
-    return CreateRosAlloc(base, morecore_start, initial_size, maximum_size, low_memory_mode);
+    return CreateRosAlloc(base, morecore_start, initial_size, maximum_size, low_memory_mode,
+                          thread_local_run_size_threshold_);
   }
   static allocator::RosAlloc* CreateRosAlloc(void* base, size_t morecore_start, size_t initial_size,
-                                             size_t maximum_size, bool low_memory_mode);
+                                             size_t maximum_size, bool low_memory_mode,
+                                             size_t thread_local_run_size_threshold);
 
   void InspectAllRosAlloc(void (*callback)(void *start, void *end, size_t num_bytes, void* callback_arg),
                           void* arg, bool do_null_callback_at_end)
@@ -154,6 +166,9 @@ class RosAllocSpace : public MallocSpace {
 
   const bool low_memory_mode_;
 
+  // Allocations up to this size use thread-local runs.
+  const size_t thread_local_run_size_threshold_;
+
   friend class collector::MarkSweep;
 
   DISALLOW_COPY_AND_ASSIGN(RosAllocSpace);
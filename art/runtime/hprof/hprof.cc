@@ -15,16 +15,15 @@
  */
 
 /*
- * Preparation and completion of hprof data generation.  The output is
- * written into two files and then combined.  This is necessary because
- * we generate some of the data (strings and classes) while we dump the
- * heap, and some analysis tools require that the class and string data
- * appear first.
+ * Preparation and completion of hprof data generation.  Some analysis
+ * tools require that the class and string data appear before the heap
+ * dump that refers to them, so the heap is walked twice: once to find
+ * the classes and strings, and once to stream the heap dump itself to
+ * the output.
  */
 
 #include "hprof.h"
 
-#include <cutils/open_memstream.h>
 #include <errno.h>
 #include <fcntl.h>
 #include <stdio.h>
@@ -34,8 +33,11 @@
 #include <time.h>
 #include <time.h>
 #include <unistd.h>
+#include <zlib.h>
 
-#include <set>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 #include "base/logging.h"
 #include "base/stringprintf.h"
@@ -54,7 +56,6 @@
 #include "mirror/class-inl.h"
 #include "mirror/object-inl.h"
 #include "os.h"
-#include "safe_map.h"
 #include "scoped_thread_state_change.h"
 #include "thread_list.h"
 
@@ -171,6 +172,166 @@ enum HprofBasicType {
 typedef uint32_t HprofStringId;
 typedef uint32_t HprofClassObjectId;
 
+// Destination of the hprof byte stream. Once an error occurs all further writes fail.
+class HprofOutput {
+ public:
+  HprofOutput() : bytes_written_(0), error_(false) {}
+  virtual ~HprofOutput() {}
+
+  bool Write(const void* data, size_t length) {
+    if (UNLIKELY(error_)) {
+      return false;
+    }
+    if (UNLIKELY(!DoWrite(reinterpret_cast<const uint8_t*>(data), length))) {
+      error_ = true;
+      return false;
+    }
+    bytes_written_ += length;
+    return true;
+  }
+
+  // Writes out anything still buffered. Nothing may be written afterwards.
+  bool Finish() {
+    if (!error_ && !DoFinish()) {
+      error_ = true;
+    }
+    return !error_;
+  }
+
+  // The size of the dump before any compression.
+  uint64_t BytesWritten() const {
+    return bytes_written_;
+  }
+
+ protected:
+  virtual bool DoWrite(const uint8_t* data, size_t length) = 0;
+  virtual bool DoFinish() = 0;
+
+ private:
+  uint64_t bytes_written_;
+  bool error_;
+
+  DISALLOW_COPY_AND_ASSIGN(HprofOutput);
+};
+
+// Keeps the whole dump in memory, for DDMS which wants it as a single chunk.
+class MemoryOutput FINAL : public HprofOutput {
+ public:
+  MemoryOutput() {}
+
+  std::vector<uint8_t>* GetData() {
+    return &data_;
+  }
+
+ protected:
+  bool DoWrite(const uint8_t* data, size_t length) OVERRIDE {
+    data_.insert(data_.end(), data, data + length);
+    return true;
+  }
+
+  bool DoFinish() OVERRIDE {
+    return true;
+  }
+
+ private:
+  std::vector<uint8_t> data_;
+
+  DISALLOW_COPY_AND_ASSIGN(MemoryOutput);
+};
+
+// Collects the stream in a large buffer which is written to the file, gzip compressed if asked
+// to, whenever it fills up. Compression favors speed since the world is stopped while we dump.
+class FileOutput FINAL : public HprofOutput {
+ public:
+  FileOutput(File* file, bool compress)
+      : file_(file), compress_(compress), buffer_(new uint8_t[kBufferSize]), buffer_used_(0),
+        file_size_(0) {
+    if (compress_) {
+      memset(&zstream_, 0, sizeof(zstream_));
+      // 16 + 15 window bits asks for a gzip header and trailer around the deflate stream.
+      int rc = deflateInit2(&zstream_, Z_BEST_SPEED, Z_DEFLATED, 16 + 15, 8, Z_DEFAULT_STRATEGY);
+      CHECK_EQ(rc, Z_OK) << "deflateInit2 failed: " << (zstream_.msg != nullptr ? zstream_.msg : "");
+      compressed_buffer_.reset(new uint8_t[kBufferSize]);
+    }
+  }
+
+  ~FileOutput() {
+    if (compress_) {
+      deflateEnd(&zstream_);
+    }
+  }
+
+  // The number of bytes written to the file so far.
+  uint64_t FileSize() const {
+    return file_size_;
+  }
+
+ protected:
+  bool DoWrite(const uint8_t* data, size_t length) OVERRIDE {
+    while (length != 0) {
+      size_t chunk = kBufferSize - buffer_used_;
+      if (chunk > length) {
+        chunk = length;
+      }
+      memcpy(buffer_.get() + buffer_used_, data, chunk);
+      buffer_used_ += chunk;
+      data += chunk;
+      length -= chunk;
+      if (buffer_used_ == kBufferSize && !Drain(false)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  bool DoFinish() OVERRIDE {
+    return Drain(true);
+  }
+
+ private:
+  static constexpr size_t kBufferSize = 1 * MB;
+
+  bool Drain(bool finish) {
+    if (!compress_) {
+      if (!file_->WriteFully(buffer_.get(), buffer_used_)) {
+        return false;
+      }
+      file_size_ += buffer_used_;
+      buffer_used_ = 0;
+      return true;
+    }
+    zstream_.next_in = buffer_.get();
+    zstream_.avail_in = buffer_used_;
+    int rc;
+    do {
+      zstream_.next_out = compressed_buffer_.get();
+      zstream_.avail_out = kBufferSize;
+      rc = deflate(&zstream_, finish ? Z_FINISH : Z_NO_FLUSH);
+      if (rc == Z_STREAM_ERROR) {
+        return false;
+      }
+      size_t compressed = kBufferSize - zstream_.avail_out;
+      if (!file_->WriteFully(compressed_buffer_.get(), compressed)) {
+        return false;
+      }
+      file_size_ += compressed;
+    } while (zstream_.avail_out == 0);
+    DCHECK_EQ(zstream_.avail_in, 0U);
+    buffer_used_ = 0;
+    return !finish || rc == Z_STREAM_END;
+  }
+
+  File* const file_;
+  const bool compress_;
+  std::unique_ptr<uint8_t[]> buffer_;
+  size_t buffer_used_;
+  std::unique_ptr<uint8_t[]> compressed_buffer_;
+  z_stream zstream_;
+  uint64_t file_size_;
+
+  DISALLOW_COPY_AND_ASSIGN(FileOutput);
+};
+
 // Represents a top-level hprof record, whose serialized format is:
 // U1  TAG: denoting the type of the record
 // U4  TIME: number of microseconds since the time stamp in the header
@@ -178,7 +339,8 @@ typedef uint32_t HprofClassObjectId;
 // U1* BODY: as many bytes as specified in the above uint32_t field
 class HprofRecord {
  public:
-  HprofRecord() : alloc_length_(128), fp_(nullptr), tag_(0), time_(0), length_(0), dirty_(false) {
+  HprofRecord()
+      : alloc_length_(128), output_(nullptr), tag_(0), time_(0), length_(0), dirty_(false) {
     body_ = reinterpret_cast<unsigned char*>(malloc(alloc_length_));
   }
 
@@ -186,13 +348,13 @@ class HprofRecord {
     free(body_);
   }
 
-  int StartNewRecord(FILE* fp, uint8_t tag, uint32_t time) {
+  int StartNewRecord(HprofOutput* output, uint8_t tag, uint32_t time) {
     int rc = Flush();
     if (rc != 0) {
       return rc;
     }
 
-    fp_ = fp;
+    output_ = output;
     tag_ = tag;
     time_ = time;
     length_ = 0;
@@ -208,12 +370,7 @@ class HprofRecord {
       U4_TO_BUF_BE(headBuf, 1, time_);
       U4_TO_BUF_BE(headBuf, 5, length_);
 
-      int nb = fwrite(headBuf, 1, sizeof(headBuf), fp_);
-      if (nb != sizeof(headBuf)) {
-        return UNIQUE_ERROR;
-      }
-      nb = fwrite(body_, 1, length_, fp_);
-      if (nb != static_cast<int>(length_)) {
+      if (!output_->Write(headBuf, sizeof(headBuf)) || !output_->Write(body_, length_)) {
         return UNIQUE_ERROR;
       }
 
@@ -372,7 +529,7 @@ class HprofRecord {
   size_t alloc_length_;
   unsigned char* body_;
 
-  FILE* fp_;
+  HprofOutput* output_;
   uint8_t tag_;
   uint32_t time_;
   size_t length_;
@@ -383,61 +540,51 @@ class HprofRecord {
 
 class Hprof {
  public:
-  Hprof(const char* output_filename, int fd, bool direct_to_ddms)
+  Hprof(const char* output_filename, int fd, bool direct_to_ddms, bool compress, bool compact)
       : filename_(output_filename),
         fd_(fd),
         direct_to_ddms_(direct_to_ddms),
+        compress_(compress),
+        compact_(compact),
         start_ns_(NanoTime()),
+        output_(nullptr),
         current_record_(),
         gc_thread_serial_number_(0),
         gc_scan_state_(0),
         current_heap_(HPROF_HEAP_DEFAULT),
         objects_in_segment_(0),
-        header_fp_(NULL),
-        header_data_ptr_(NULL),
-        header_data_size_(0),
-        body_fp_(NULL),
-        body_data_ptr_(NULL),
-        body_data_size_(0),
+        tables_written_(false),
         next_string_id_(0x400000) {
     LOG(INFO) << "hprof: heap dump \"" << filename_ << "\" starting...";
-
-    header_fp_ = open_memstream(&header_data_ptr_, &header_data_size_);
-    if (header_fp_ == NULL) {
-      PLOG(FATAL) << "header open_memstream failed";
-    }
-
-    body_fp_ = open_memstream(&body_data_ptr_, &body_data_size_);
-    if (body_fp_ == NULL) {
-      PLOG(FATAL) << "body open_memstream failed";
-    }
-  }
-
-  ~Hprof() {
-    if (header_fp_ != NULL) {
-      fclose(header_fp_);
-    }
-    if (body_fp_ != NULL) {
-      fclose(body_fp_);
-    }
-    free(header_data_ptr_);
-    free(body_data_ptr_);
   }
 
   void Dump()
       EXCLUSIVE_LOCKS_REQUIRED(Locks::mutator_lock_)
       LOCKS_EXCLUDED(Locks::heap_bitmap_lock_) {
-    // Walk the roots and the heap.
-    current_record_.StartNewRecord(body_fp_, HPROF_TAG_HEAP_DUMP_SEGMENT, HPROF_TIME);
-    Runtime::Current()->VisitRoots(RootVisitor, this);
     Thread* self = Thread::Current();
+    gc::Heap* heap = Runtime::Current()->GetHeap();
+    // Find the classes and strings the heap dump will refer to, so that their records can be
+    // written first and the heap dump itself streamed to the output.
+    LookupStringId("app");
+    LookupStringId("zygote");
+    LookupStringId("image");
     {
       ReaderMutexLock mu(self, *Locks::heap_bitmap_lock_);
-      Runtime::Current()->GetHeap()->VisitObjects(VisitObjectCallback, this);
+      heap->VisitObjects(CollectObjectCallback, this);
     }
-    current_record_.StartNewRecord(body_fp_, HPROF_TAG_HEAP_DUMP_END, HPROF_TIME);
-    current_record_.Flush();
-    fflush(body_fp_);
+
+    std::unique_ptr<File> file;
+    std::unique_ptr<HprofOutput> output;
+    if (direct_to_ddms_) {
+      output.reset(new MemoryOutput());
+    } else {
+      file.reset(OpenOutputFile());
+      if (file.get() == nullptr) {
+        return;
+      }
+      output.reset(new FileOutput(file.get(), compress_));
+    }
+    output_ = output.get();
 
     // Write the header.
     WriteFixedHeader();
@@ -446,39 +593,28 @@ class Hprof {
     WriteStringTable();
     WriteClassTable();
     WriteStackTraces();
-    current_record_.Flush();
-    fflush(header_fp_);
+    tables_written_ = true;
+
+    // Walk the roots and the heap.
+    current_record_.StartNewRecord(output_, HPROF_TAG_HEAP_DUMP_SEGMENT, HPROF_TIME);
+    Runtime::Current()->VisitRoots(RootVisitor, this);
+    {
+      ReaderMutexLock mu(self, *Locks::heap_bitmap_lock_);
+      heap->VisitObjects(VisitObjectCallback, this);
+    }
+    current_record_.StartNewRecord(output_, HPROF_TAG_HEAP_DUMP_END, HPROF_TIME);
+    bool okay = current_record_.Flush() == 0;
+    okay = output_->Finish() && okay;
+    output_ = nullptr;
 
-    bool okay = true;
     if (direct_to_ddms_) {
       // Send the data off to DDMS.
-      iovec iov[2];
-      iov[0].iov_base = header_data_ptr_;
-      iov[0].iov_len = header_data_size_;
-      iov[1].iov_base = body_data_ptr_;
-      iov[1].iov_len = body_data_size_;
-      Dbg::DdmSendChunkV(CHUNK_TYPE("HPDS"), iov, 2);
+      std::vector<uint8_t>* data = down_cast<MemoryOutput*>(output.get())->GetData();
+      iovec iov[1];
+      iov[0].iov_base = data->data();
+      iov[0].iov_len = data->size();
+      Dbg::DdmSendChunkV(CHUNK_TYPE("HPDS"), iov, 1);
     } else {
-      // Where exactly are we writing to?
-      int out_fd;
-      if (fd_ >= 0) {
-        out_fd = dup(fd_);
-        if (out_fd < 0) {
-          ThrowRuntimeException("Couldn't dump heap; dup(%d) failed: %s", fd_, strerror(errno));
-          return;
-        }
-      } else {
-        out_fd = open(filename_.c_str(), O_WRONLY|O_CREAT|O_TRUNC, 0644);
-        if (out_fd < 0) {
-          ThrowRuntimeException("Couldn't dump heap; open(\"%s\") failed: %s", filename_.c_str(),
-                                strerror(errno));
-          return;
-        }
-      }
-
-      std::unique_ptr<File> file(new File(out_fd, filename_, true));
-      okay = file->WriteFully(header_data_ptr_, header_data_size_) &&
-             file->WriteFully(body_data_ptr_, body_data_size_);
       if (okay) {
         okay = file->FlushCloseOrErase() == 0;
       } else {
@@ -495,8 +631,13 @@ class Hprof {
     // Throw out a log message for the benefit of "runhat".
     if (okay) {
       uint64_t duration = NanoTime() - start_ns_;
+      std::string compressed;
+      if (compress_ && !direct_to_ddms_) {
+        compressed = StringPrintf(", %s compressed",
+            PrettySize(down_cast<FileOutput*>(output.get())->FileSize()).c_str());
+      }
       LOG(INFO) << "hprof: heap dump completed ("
-          << PrettySize(header_data_size_ + body_data_size_ + 1023)
+          << PrettySize(output->BytesWritten() + 1023) << compressed
           << ") in " << PrettyDuration(duration);
     }
   }
@@ -510,6 +651,13 @@ class Hprof {
     reinterpret_cast<Hprof*>(arg)->VisitRoot(*obj, root_info);
   }
 
+  static void CollectObjectCallback(mirror::Object* obj, void* arg)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+    DCHECK(obj != NULL);
+    DCHECK(arg != NULL);
+    reinterpret_cast<Hprof*>(arg)->CollectHeapObject(obj);
+  }
+
   static void VisitObjectCallback(mirror::Object* obj, void* arg)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
     DCHECK(obj != NULL);
@@ -517,9 +665,33 @@ class Hprof {
     reinterpret_cast<Hprof*>(arg)->DumpHeapObject(obj);
   }
 
+  // Opens the file or duplicates the file descriptor we are dumping to. Throws and returns null
+  // on failure.
+  File* OpenOutputFile() {
+    int out_fd;
+    if (fd_ >= 0) {
+      out_fd = dup(fd_);
+      if (out_fd < 0) {
+        ThrowRuntimeException("Couldn't dump heap; dup(%d) failed: %s", fd_, strerror(errno));
+        return nullptr;
+      }
+    } else {
+      out_fd = open(filename_.c_str(), O_WRONLY|O_CREAT|O_TRUNC, 0644);
+      if (out_fd < 0) {
+        ThrowRuntimeException("Couldn't dump heap; open(\"%s\") failed: %s", filename_.c_str(),
+                              strerror(errno));
+        return nullptr;
+      }
+    }
+    return new File(out_fd, filename_, true);
+  }
+
   void VisitRoot(const mirror::Object* obj, const RootInfo& root_info)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
+  // Assigns IDs to the classes and strings DumpHeapObject will use for this object.
+  void CollectHeapObject(mirror::Object* obj) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
   int DumpHeapObject(mirror::Object* obj) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
   void Finish() {
@@ -532,7 +704,7 @@ class Hprof {
     for (mirror::Class* c : classes_) {
       CHECK(c != nullptr);
 
-      int err = current_record_.StartNewRecord(header_fp_, HPROF_TAG_LOAD_CLASS, HPROF_TIME);
+      int err = current_record_.StartNewRecord(output_, HPROF_TAG_LOAD_CLASS, HPROF_TIME);
       if (UNLIKELY(err != 0)) {
         return err;
       }
@@ -554,11 +726,11 @@ class Hprof {
   int WriteStringTable() {
     HprofRecord* rec = &current_record_;
 
-    for (std::pair<std::string, HprofStringId> p : strings_) {
+    for (const std::pair<const std::string, HprofStringId>& p : strings_) {
       const std::string& string = p.first;
       size_t id = p.second;
 
-      int err = current_record_.StartNewRecord(header_fp_, HPROF_TAG_STRING, HPROF_TIME);
+      int err = current_record_.StartNewRecord(output_, HPROF_TAG_STRING, HPROF_TIME);
       if (err != 0) {
         return err;
       }
@@ -582,7 +754,7 @@ class Hprof {
 
   void StartNewHeapDumpSegment() {
     // This flushes the old segment and starts a new one.
-    current_record_.StartNewRecord(body_fp_, HPROF_TAG_HEAP_DUMP_SEGMENT, HPROF_TIME);
+    current_record_.StartNewRecord(output_, HPROF_TAG_HEAP_DUMP_SEGMENT, HPROF_TIME);
     objects_in_segment_ = 0;
 
     // Starting a new HEAP_DUMP resets the heap to default.
@@ -597,15 +769,12 @@ class Hprof {
       return 0;
     }
 
-    {
-      auto result = classes_.insert(c);
-      const mirror::Class* present = *result.first;
-      CHECK_EQ(present, c);
+    if (classes_.insert(c).second) {
+      DCHECK(!tables_written_) << "Class missed by CollectHeapObject: " << PrettyClass(c);
+      // Make sure that we've assigned a string ID for this class' name
+      LookupClassNameId(c);
     }
 
-    // Make sure that we've assigned a string ID for this class' name
-    LookupClassNameId(c);
-
     HprofClassObjectId result = PointerToLowMemUInt32(c);
     return result;
   }
@@ -623,8 +792,9 @@ class Hprof {
     if (it != strings_.end()) {
       return it->second;
     }
+    DCHECK(!tables_written_) << "String missed by CollectHeapObject: " << string;
     HprofStringId id = next_string_id_++;
-    strings_.Put(string, id);
+    strings_.insert(std::make_pair(string, id));
     return id;
   }
 
@@ -638,7 +808,7 @@ class Hprof {
 
     // Write the file header.
     // U1: NUL-terminated magic string.
-    fwrite(magic, 1, sizeof(magic), header_fp_);
+    output_->Write(magic, sizeof(magic));
 
     // U4: size of identifiers.  We're using addresses as IDs and our heap references are stored
     // as uint32_t.
@@ -646,7 +816,7 @@ class Hprof {
     COMPILE_ASSERT(sizeof(mirror::HeapReference<mirror::Object>) == sizeof(uint32_t),
       UnexpectedHeapReferenceSize);
     U4_TO_BUF_BE(buf, 0, sizeof(uint32_t));
-    fwrite(buf, 1, sizeof(uint32_t), header_fp_);
+    output_->Write(buf, sizeof(uint32_t));
 
     // The current time, in milliseconds since 0:00 GMT, 1/1/70.
     timeval now;
@@ -659,16 +829,16 @@ class Hprof {
 
     // U4: high word of the 64-bit time.
     U4_TO_BUF_BE(buf, 0, (uint32_t)(nowMs >> 32));
-    fwrite(buf, 1, sizeof(uint32_t), header_fp_);
+    output_->Write(buf, sizeof(uint32_t));
 
     // U4: low word of the 64-bit time.
     U4_TO_BUF_BE(buf, 0, (uint32_t)(nowMs & 0xffffffffULL));
-    fwrite(buf, 1, sizeof(uint32_t), header_fp_);  // xxx fix the time
+    output_->Write(buf, sizeof(uint32_t));  // xxx fix the time
   }
 
   void WriteStackTraces() {
     // Write a dummy stack trace record so the analysis tools don't freak out.
-    current_record_.StartNewRecord(header_fp_, HPROF_TAG_STACK_TRACE, HPROF_TIME);
+    current_record_.StartNewRecord(output_, HPROF_TAG_STACK_TRACE, HPROF_TIME);
     current_record_.AddU4(HPROF_NULL_STACK_TRACE);
     current_record_.AddU4(HPROF_NULL_THREAD);
     current_record_.AddU4(0);    // no frames
@@ -680,9 +850,14 @@ class Hprof {
   std::string filename_;
   int fd_;
   bool direct_to_ddms_;
+  const bool compress_;
+  // Leave out the contents of primitive arrays.
+  const bool compact_;
 
   uint64_t start_ns_;
 
+  // Where the records go, only set while we are writing them.
+  HprofOutput* output_;
   HprofRecord current_record_;
 
   uint32_t gc_thread_serial_number_;
@@ -690,17 +865,12 @@ class Hprof {
   HprofHeapId current_heap_;  // Which heap we're currently dumping.
   size_t objects_in_segment_;
 
-  FILE* header_fp_;
-  char* header_data_ptr_;
-  size_t header_data_size_;
+  // Set once the string and class tables are out, after which no new IDs may be handed out.
+  bool tables_written_;
 
-  FILE* body_fp_;
-  char* body_data_ptr_;
-  size_t body_data_size_;
-
-  std::set<mirror::Class*> classes_;
+  std::unordered_set<mirror::Class*> classes_;
   HprofStringId next_string_id_;
-  SafeMap<std::string, HprofStringId> strings_;
+  std::unordered_map<std::string, HprofStringId> strings_;
 
   DISALLOW_COPY_AND_ASSIGN(Hprof);
 };
@@ -851,6 +1021,33 @@ static int StackTraceSerialNumber(const mirror::Object* /*obj*/) {
   return HPROF_NULL_STACK_TRACE;
 }
 
+void Hprof::CollectHeapObject(mirror::Object* obj) {
+  mirror::Class* c = obj->GetClass();
+  if (c == nullptr) {
+    // Not dumped, see DumpHeapObject.
+    return;
+  }
+  if (obj->IsClass()) {
+    mirror::Class* thisClass = obj->AsClass();
+    LookupClassId(thisClass);
+    LookupClassId(thisClass->GetSuperClass());
+    size_t sFieldCount = thisClass->NumStaticFields();
+    if (sFieldCount != 0) {
+      LookupStringId(STATIC_OVERHEAD_NAME);
+      for (size_t i = 0; i < sFieldCount; ++i) {
+        LookupStringId(thisClass->GetStaticField(i)->GetName());
+      }
+    }
+    int iFieldCount = thisClass->IsObjectClass() ? 0 : thisClass->NumInstanceFields();
+    for (int i = 0; i < iFieldCount; ++i) {
+      LookupStringId(thisClass->GetInstanceField(i)->GetName());
+    }
+  } else if (!c->IsArrayClass() || obj->IsObjectArray()) {
+    // Instances and object arrays refer to their class, primitive arrays only to their type.
+    LookupClassId(c);
+  }
+}
+
 int Hprof::DumpHeapObject(mirror::Object* obj) {
   HprofRecord* rec = &current_record_;
   gc::space::ContinuousSpace* space =
@@ -909,13 +1106,15 @@ int Hprof::DumpHeapObject(mirror::Object* obj) {
         int byteLength = sFieldCount * sizeof(JValue);  // TODO bogus; fields are packed
         // Create a byte array to reflect the allocation of the
         // StaticField array at the end of this class.
-        rec->AddU1(HPROF_PRIMITIVE_ARRAY_DUMP);
+        rec->AddU1(compact_ ? HPROF_PRIMITIVE_ARRAY_NODATA_DUMP : HPROF_PRIMITIVE_ARRAY_DUMP);
         rec->AddClassStaticsId(thisClass);
         rec->AddU4(StackTraceSerialNumber(obj));
         rec->AddU4(byteLength);
         rec->AddU1(hprof_basic_byte);
-        for (int i = 0; i < byteLength; ++i) {
-          rec->AddU1(0);
+        if (!compact_) {
+          for (int i = 0; i < byteLength; ++i) {
+            rec->AddU1(0);
+          }
         }
       }
 
@@ -999,15 +1198,17 @@ int Hprof::DumpHeapObject(mirror::Object* obj) {
         HprofBasicType t = PrimitiveToBasicTypeAndSize(c->GetComponentType()->GetPrimitiveType(), &size);
 
         // obj is a primitive array.
-        rec->AddU1(HPROF_PRIMITIVE_ARRAY_DUMP);
+        rec->AddU1(compact_ ? HPROF_PRIMITIVE_ARRAY_NODATA_DUMP : HPROF_PRIMITIVE_ARRAY_DUMP);
 
         rec->AddObjectId(obj);
         rec->AddU4(StackTraceSerialNumber(obj));
         rec->AddU4(length);
         rec->AddU1(t);
 
-        // Dump the raw, packed element values.
-        if (size == 1) {
+        // Dump the raw, packed element values. The compact NODATA record has none.
+        if (compact_) {
+          // Nothing to add.
+        } else if (size == 1) {
           rec->AddU1List((const uint8_t*)aobj->GetRawData(sizeof(uint8_t), 0), length);
         } else if (size == 2) {
           rec->AddU2List((const uint16_t*)aobj->GetRawData(sizeof(uint16_t), 0), length);
@@ -1091,15 +1292,15 @@ void Hprof::VisitRoot(const mirror::Object* obj, const RootInfo& root_info) {
   gc_thread_serial_number_ = 0;
 }
 
-// If "direct_to_ddms" is true, the other arguments are ignored, and data is
-// sent directly to DDMS.
+// If "direct_to_ddms" is true, "filename", "fd" and "compress" are ignored,
+// and data is sent directly to DDMS.
 // If "fd" is >= 0, the output will be written to that file descriptor.
 // Otherwise, "filename" is used to create an output file.
-void DumpHeap(const char* filename, int fd, bool direct_to_ddms) {
+void DumpHeap(const char* filename, int fd, bool direct_to_ddms, bool compress, bool compact) {
   CHECK(filename != NULL);
 
   Runtime::Current()->GetThreadList()->SuspendAll();
-  Hprof hprof(filename, fd, direct_to_ddms);
+  Hprof hprof(filename, fd, direct_to_ddms, compress, compact);
   hprof.Dump();
   Runtime::Current()->GetThreadList()->ResumeAll();
 }
@@ -21,7 +21,13 @@ namespace art {
 
 namespace hprof {
 
-void DumpHeap(const char* filename, int fd, bool direct_to_ddms);
+// Dumps the heap in hprof format with all threads suspended.
+// If "direct_to_ddms" is true, "filename", "fd" and "compress" are ignored and the dump is sent
+// to DDMS. Otherwise it is streamed to "fd" if that is >= 0, or to a newly created "filename".
+// "compress" gzips the stream. "compact" leaves out the contents of primitive arrays, emitting
+// HPROF_PRIMITIVE_ARRAY_NODATA_DUMP records that keep only their type and length.
+void DumpHeap(const char* filename, int fd, bool direct_to_ddms, bool compress = false,
+              bool compact = false);
 
 }  // namespace hprof
 
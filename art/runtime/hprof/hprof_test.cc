@@ -0,0 +1,129 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "hprof.h"
+
+#include <string.h>
+#include <zlib.h>
+
+#include "base/stringprintf.h"
+#include "base/unix_file/fd_file.h"
+#include "common_runtime_test.h"
+#include "jni_internal.h"
+#include "os.h"
+#include "thread.h"
+
+namespace art {
+
+class HprofTest : public CommonRuntimeTest {
+ protected:
+  // Fills the heap with "count" int arrays of "length" elements, and as many strings, all reachable
+  // from a global reference. Called in native state, like the code dumping the heap.
+  jobject MakeHeap(size_t count, size_t length) {
+    JNIEnv* env = Thread::Current()->GetJniEnv();
+    jclass object_class = env->FindClass("java/lang/Object");
+    CHECK(object_class != nullptr);
+    jobjectArray holder = env->NewObjectArray(2 * count, object_class, nullptr);
+    CHECK(holder != nullptr);
+    for (size_t i = 0; i < count; ++i) {
+      jintArray array = env->NewIntArray(length);
+      CHECK(array != nullptr);
+      env->SetObjectArrayElement(holder, 2 * i, array);
+      env->DeleteLocalRef(array);
+      jstring string = env->NewStringUTF(StringPrintf("hprof test string %zd", i).c_str());
+      CHECK(string != nullptr);
+      env->SetObjectArrayElement(holder, 2 * i + 1, string);
+      env->DeleteLocalRef(string);
+    }
+    jobject global = env->NewGlobalRef(holder);
+    env->DeleteLocalRef(holder);
+    env->DeleteLocalRef(object_class);
+    return global;
+  }
+
+  void FreeHeap(jobject holder) {
+    Thread::Current()->GetJniEnv()->DeleteGlobalRef(holder);
+  }
+
+  static int64_t FileSize(const std::string& filename) {
+    std::unique_ptr<File> file(OS::OpenFileForReading(filename.c_str()));
+    CHECK(file.get() != nullptr) << filename;
+    return file->GetLength();
+  }
+};
+
+static const char kHprofMagic[] = "JAVA PROFILE 1.0.3";
+
+TEST_F(HprofTest, DumpToFile) {
+  jobject holder = MakeHeap(64, 1024);
+  ScratchFile full;
+  hprof::DumpHeap(full.GetFilename().c_str(), -1, false);
+  ScratchFile compact;
+  hprof::DumpHeap(compact.GetFilename().c_str(), -1, false, false, true);
+  FreeHeap(holder);
+
+  char magic[sizeof(kHprofMagic)];
+  std::unique_ptr<File> file(OS::OpenFileForReading(full.GetFilename().c_str()));
+  ASSERT_TRUE(file.get() != nullptr);
+  ASSERT_TRUE(file->ReadFully(magic, sizeof(magic)));
+  EXPECT_EQ(0, memcmp(kHprofMagic, magic, sizeof(magic)));
+  // The compact dump leaves out at least the 256KB of int array contents.
+  EXPECT_LT(FileSize(compact.GetFilename()) + 64 * 1024 * 4, FileSize(full.GetFilename()));
+}
+
+TEST_F(HprofTest, DumpCompressed) {
+  jobject holder = MakeHeap(64, 1024);
+  ScratchFile full;
+  hprof::DumpHeap(full.GetFilename().c_str(), -1, false);
+  ScratchFile compressed;
+  hprof::DumpHeap(compressed.GetFilename().c_str(), -1, false, true);
+  FreeHeap(holder);
+
+  // Mostly zero int arrays compress very well.
+  EXPECT_LT(FileSize(compressed.GetFilename()) * 2, FileSize(full.GetFilename()));
+  gzFile gz = gzopen(compressed.GetFilename().c_str(), "rb");
+  ASSERT_TRUE(gz != nullptr);
+  char magic[sizeof(kHprofMagic)];
+  EXPECT_EQ(static_cast<int>(sizeof(magic)), gzread(gz, magic, sizeof(magic)));
+  EXPECT_EQ(0, memcmp(kHprofMagic, magic, sizeof(magic)));
+  // Reading to the end checks the gzip trailer.
+  char buffer[4096];
+  int bytes;
+  while ((bytes = gzread(gz, buffer, sizeof(buffer))) > 0) {
+  }
+  EXPECT_EQ(0, bytes);
+  EXPECT_EQ(Z_OK, gzclose(gz));
+}
+
+// Dumps a synthetic heap of roughly 128MB in each of the modes.
+TEST_F(HprofTest, DISABLED_DumpLargeHeap) {
+  static const size_t kArrays = 32 * 1024;
+  static const size_t kArrayLength = 1024;
+  jobject holder = MakeHeap(kArrays, kArrayLength);
+  for (int mode = 0; mode < 3; ++mode) {
+    const bool compress = mode == 1;
+    const bool compact = mode == 2;
+    ScratchFile output;
+    const uint64_t start = NanoTime();
+    hprof::DumpHeap(output.GetFilename().c_str(), -1, false, compress, compact);
+    const uint64_t duration = NanoTime() - start;
+    LOG(INFO) << (compress ? "compressed" : (compact ? "compact" : "plain")) << ": "
+              << PrettySize(FileSize(output.GetFilename())) << " in " << PrettyDuration(duration);
+  }
+  FreeHeap(holder);
+}
+
+}  // namespace art
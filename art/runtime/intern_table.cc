@@ -18,35 +18,275 @@
 
 #include <memory>
 
+#include "base/allocator.h"
+#include "base/stl_util.h"
 #include "gc/space/image_space.h"
 #include "mirror/dex_cache.h"
 #include "mirror/object_array-inl.h"
 #include "mirror/object-inl.h"
 #include "mirror/string-inl.h"
+#include "read_barrier-inl.h"
 #include "thread.h"
 #include "utf.h"
+#include "utils.h"
 
 namespace art {
 
+// String.hashCode() is a polynomial hash whose low bits cluster for strings which only differ in
+// their last characters. Spread it before picking a shard from the high bits and a slot from the
+// low bits.
+static inline uint32_t SpreadHash(int32_t hash) {
+  uint32_t h = static_cast<uint32_t>(hash);
+  h ^= h >> 16;
+  h *= 0x85ebca6bU;
+  h ^= h >> 13;
+  h *= 0xc2b2ae35U;
+  h ^= h >> 16;
+  return h;
+}
+
+// Marks a removed string. Probing continues past tombstones, unlike empty slots.
+static mirror::String* const kTombstone = reinterpret_cast<mirror::String*>(1);
+
+static constexpr size_t kMinTableCapacity = 64;
+
+class InternTable::Table::SlotArray {
+ public:
+  explicit SlotArray(size_t capacity) : size_(0), used_(0), mask_(capacity - 1), slots_(capacity) {
+    DCHECK(IsPowerOfTwo(capacity)) << capacity;
+  }
+
+  size_t Capacity() const {
+    return mask_ + 1;
+  }
+
+  // Number of strings.
+  size_t size_;
+  // Number of strings and tombstones, at least one slot is always left empty to end probing.
+  size_t used_;
+  const size_t mask_;
+  std::vector<Atomic<mirror::String*>,
+      TrackingAllocator<Atomic<mirror::String*>, kAllocatorTagInternTable>> slots_;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(SlotArray);
+};
+
+InternTable::Table::Table()
+    : pre_zygote_table_(new SlotArray(kMinTableCapacity)),
+      post_zygote_table_(new SlotArray(kMinTableCapacity)) {
+}
+
+InternTable::Table::~Table() {
+  delete pre_zygote_table_.LoadRelaxed();
+  delete post_zygote_table_.LoadRelaxed();
+  STLDeleteElements(&retired_arrays_);
+}
+
+mirror::String* InternTable::Table::Find(mirror::String* s, int32_t hash) {
+  SlotArray* pre_zygote_table = pre_zygote_table_.LoadRelaxed();
+  SlotArray* post_zygote_table = post_zygote_table_.LoadRelaxed();
+  // Pairs with the release stores publishing new slot arrays.
+  QuasiAtomic::ThreadFenceAcquire();
+  mirror::String* found = Find(pre_zygote_table, s, hash);
+  if (found == nullptr) {
+    found = Find(post_zygote_table, s, hash);
+  }
+  return found;
+}
+
+mirror::String* InternTable::Table::Find(SlotArray* array, mirror::String* s, int32_t hash) {
+  const size_t mask = array->mask_;
+  for (size_t i = SpreadHash(hash) & mask; ; i = (i + 1) & mask) {
+    mirror::String* candidate = array->slots_[i].LoadRelaxed();
+    if (candidate == nullptr) {
+      return nullptr;
+    }
+    if (candidate != kTombstone) {
+      // Pairs with the release store in Insert, the string's contents are visible after this.
+      QuasiAtomic::ThreadFenceAcquire();
+      candidate = ReadBarrier::BarrierForRoot<mirror::String, kWithReadBarrier>(&candidate);
+      if (candidate->GetHashCode() == hash && candidate->Equals(s)) {
+        return candidate;
+      }
+    }
+  }
+}
+
+InternTable::Table::SlotArray* InternTable::Table::Rehash(SlotArray* array) {
+  // Leave the new array at most half full, this also drops the tombstones.
+  size_t capacity = kMinTableCapacity;
+  while (capacity < (array->size_ + 1) * 2) {
+    capacity *= 2;
+  }
+  SlotArray* new_array = new SlotArray(capacity);
+  const size_t mask = new_array->mask_;
+  for (auto& slot : array->slots_) {
+    mirror::String* s = slot.LoadRelaxed();
+    if (s == nullptr || s == kTombstone) {
+      continue;
+    }
+    // This does not need a read barrier since we only copy the reference.
+    size_t i = SpreadHash(s->GetHashCode()) & mask;
+    while (new_array->slots_[i].LoadRelaxed() != nullptr) {
+      i = (i + 1) & mask;
+    }
+    new_array->slots_[i].StoreRelaxed(s);
+  }
+  new_array->size_ = array->size_;
+  new_array->used_ = array->size_;
+  // Readers may still be probing the old array, free it later.
+  retired_arrays_.push_back(array);
+  post_zygote_table_.StoreRelease(new_array);
+  return new_array;
+}
+
+void InternTable::Table::Insert(mirror::String* s, int32_t hash) {
+  // Always insert the post zygote table, this gets swapped when we create the zygote to be the
+  // pre zygote table.
+  SlotArray* array = post_zygote_table_.LoadRelaxed();
+  if ((array->used_ + 1) * 4 > array->Capacity() * 3) {
+    array = Rehash(array);
+  }
+  const size_t mask = array->mask_;
+  size_t i = SpreadHash(hash) & mask;
+  for (;; i = (i + 1) & mask) {
+    mirror::String* current = array->slots_[i].LoadRelaxed();
+    if (current == nullptr) {
+      ++array->used_;
+      break;
+    }
+    if (current == kTombstone) {
+      break;
+    }
+  }
+  ++array->size_;
+  array->slots_[i].StoreRelease(s);
+}
+
+void InternTable::Table::Remove(mirror::String* s, int32_t hash) {
+  if (!Remove(post_zygote_table_.LoadRelaxed(), s, hash)) {
+    bool removed = Remove(pre_zygote_table_.LoadRelaxed(), s, hash);
+    DCHECK(removed);
+  }
+}
+
+bool InternTable::Table::Remove(SlotArray* array, mirror::String* s, int32_t hash) {
+  const size_t mask = array->mask_;
+  for (size_t i = SpreadHash(hash) & mask; ; i = (i + 1) & mask) {
+    mirror::String* current = array->slots_[i].LoadRelaxed();
+    if (current == nullptr) {
+      return false;
+    }
+    if (current == s) {
+      array->slots_[i].StoreRelaxed(kTombstone);
+      --array->size_;
+      return true;
+    }
+  }
+}
+
+void InternTable::Table::SwapPostZygoteWithPreZygote() {
+  SlotArray* pre_zygote_table = pre_zygote_table_.LoadRelaxed();
+  CHECK_EQ(pre_zygote_table->size_, 0U);
+  retired_arrays_.push_back(pre_zygote_table);
+  SlotArray* post_zygote_table = post_zygote_table_.LoadRelaxed();
+  pre_zygote_table_.StoreRelease(post_zygote_table);
+  post_zygote_table_.StoreRelease(new SlotArray(kMinTableCapacity));
+  VLOG(heap) << "Swapping " << post_zygote_table->size_ << " interns to the pre zygote table";
+}
+
+void InternTable::Table::FreeRetiredArrays() {
+  STLDeleteElements(&retired_arrays_);
+}
+
+void InternTable::Table::VisitRoots(RootCallback* callback, void* arg) {
+  VisitRoots(pre_zygote_table_.LoadRelaxed(), callback, arg);
+  VisitRoots(post_zygote_table_.LoadRelaxed(), callback, arg);
+}
+
+void InternTable::Table::VisitRoots(SlotArray* array, RootCallback* callback, void* arg) {
+  for (auto& slot : array->slots_) {
+    mirror::String* s = slot.LoadRelaxed();
+    if (s == nullptr || s == kTombstone) {
+      continue;
+    }
+    mirror::Object* root = s;
+    callback(&root, arg, RootInfo(kRootInternedString));
+    if (root != s) {
+      // Moved, the hash code and therefore the slot stay the same.
+      slot.StoreRelease(root->AsString());
+    }
+  }
+}
+
+void InternTable::Table::SweepWeaks(IsMarkedCallback* callback, void* arg) {
+  SweepWeaks(pre_zygote_table_.LoadRelaxed(), callback, arg);
+  SweepWeaks(post_zygote_table_.LoadRelaxed(), callback, arg);
+}
+
+void InternTable::Table::SweepWeaks(SlotArray* array, IsMarkedCallback* callback, void* arg) {
+  for (auto& slot : array->slots_) {
+    // This does not need a read barrier because this is called by GC.
+    mirror::String* s = slot.LoadRelaxed();
+    if (s == nullptr || s == kTombstone) {
+      continue;
+    }
+    mirror::Object* new_object = callback(s, arg);
+    if (new_object == nullptr) {
+      slot.StoreRelaxed(kTombstone);
+      --array->size_;
+    } else if (new_object != s) {
+      slot.StoreRelease(new_object->AsString());
+    }
+  }
+}
+
+size_t InternTable::Table::Size() const {
+  return pre_zygote_table_.LoadRelaxed()->size_ + post_zygote_table_.LoadRelaxed()->size_;
+}
+
+InternTable::Shard::Shard()
+    : lock_("InternTable shard lock", kInternTableShardLock),
+      new_intern_condition_("New intern condition", lock_) {
+}
+
 InternTable::InternTable()
     : image_added_to_intern_table_(false), log_new_roots_(false),
       allow_new_interns_(true),
       new_intern_condition_("New intern condition", *Locks::intern_table_lock_) {
 }
 
+InternTable::Shard& InternTable::GetShard(int32_t hash) {
+  return shards_[SpreadHash(hash) >> (32 - kShardBits)];
+}
+
+const InternTable::Shard& InternTable::GetShard(int32_t hash) const {
+  return shards_[SpreadHash(hash) >> (32 - kShardBits)];
+}
+
 size_t InternTable::Size() const {
-  MutexLock mu(Thread::Current(), *Locks::intern_table_lock_);
-  return strong_interns_.Size() + weak_interns_.Size();
+  return StrongSize() + WeakSize();
 }
 
 size_t InternTable::StrongSize() const {
-  MutexLock mu(Thread::Current(), *Locks::intern_table_lock_);
-  return strong_interns_.Size();
+  Thread* self = Thread::Current();
+  size_t size = 0;
+  for (const Shard& shard : shards_) {
+    MutexLock mu(self, shard.lock_);
+    size += shard.strong_interns_.Size();
+  }
+  return size;
 }
 
 size_t InternTable::WeakSize() const {
-  MutexLock mu(Thread::Current(), *Locks::intern_table_lock_);
-  return weak_interns_.Size();
+  Thread* self = Thread::Current();
+  size_t size = 0;
+  for (const Shard& shard : shards_) {
+    MutexLock mu(self, shard.lock_);
+    size += shard.weak_interns_.Size();
+  }
+  return size;
 }
 
 void InternTable::DumpForSigQuit(std::ostream& os) const {
@@ -54,46 +294,69 @@ void InternTable::DumpForSigQuit(std::ostream& os) const {
 }
 
 void InternTable::VisitRoots(RootCallback* callback, void* arg, VisitRootFlags flags) {
-  MutexLock mu(Thread::Current(), *Locks::intern_table_lock_);
-  if ((flags & kVisitRootFlagAllRoots) != 0) {
-    strong_interns_.VisitRoots(callback, arg);
-  } else if ((flags & kVisitRootFlagNewRoots) != 0) {
-    for (auto& root : new_strong_intern_roots_) {
-      mirror::String* old_ref = root.Read<kWithoutReadBarrier>();
-      root.VisitRoot(callback, arg, RootInfo(kRootInternedString));
-      mirror::String* new_ref = root.Read<kWithoutReadBarrier>();
-      if (new_ref != old_ref) {
-        // The GC moved a root in the log. Need to search the strong interns and update the
-        // corresponding object. This is slow, but luckily for us, this may only happen with a
-        // concurrent moving GC.
-        strong_interns_.Remove(old_ref);
-        strong_interns_.Insert(new_ref);
+  Thread* self = Thread::Current();
+  MutexLock mu(self, *Locks::intern_table_lock_);
+  if ((flags & kVisitRootFlagStartLoggingNewRoots) != 0) {
+    // Inserts only hold their shard lock, start logging before visiting so that a string inserted
+    // into an already visited shard is logged.
+    log_new_roots_.StoreRelaxed(true);
+  }
+  for (Shard& shard : shards_) {
+    MutexLock mu2(self, shard.lock_);
+    if ((flags & kVisitRootFlagAllRoots) != 0) {
+      shard.strong_interns_.VisitRoots(callback, arg);
+    } else if ((flags & kVisitRootFlagNewRoots) != 0) {
+      for (auto& root : shard.new_strong_intern_roots_) {
+        mirror::String* old_ref = root.Read<kWithoutReadBarrier>();
+        root.VisitRoot(callback, arg, RootInfo(kRootInternedString));
+        mirror::String* new_ref = root.Read<kWithoutReadBarrier>();
+        if (new_ref != old_ref) {
+          // The GC moved a root in the log. Need to search the strong interns and update the
+          // corresponding object. This is slow, but luckily for us, this may only happen with a
+          // concurrent moving GC.
+          const int32_t hash = new_ref->GetHashCode();
+          shard.strong_interns_.Remove(old_ref, hash);
+          shard.strong_interns_.Insert(new_ref, hash);
+        }
       }
     }
+    if ((flags & kVisitRootFlagClearRootLog) != 0) {
+      shard.new_strong_intern_roots_.clear();
+    }
   }
-  if ((flags & kVisitRootFlagClearRootLog) != 0) {
-    new_strong_intern_roots_.clear();
-  }
-  if ((flags & kVisitRootFlagStartLoggingNewRoots) != 0) {
-    log_new_roots_ = true;
-  } else if ((flags & kVisitRootFlagStopLoggingNewRoots) != 0) {
-    log_new_roots_ = false;
+  if ((flags & kVisitRootFlagStartLoggingNewRoots) == 0 &&
+      (flags & kVisitRootFlagStopLoggingNewRoots) != 0) {
+    log_new_roots_.StoreRelaxed(false);
   }
   // Note: we deliberately don't visit the weak_interns_ table and the immutable image roots.
 }
 
 mirror::String* InternTable::LookupStrong(mirror::String* s) {
-  return strong_interns_.Find(s);
+  const int32_t hash = s->GetHashCode();
+  return GetShard(hash).strong_interns_.Find(s, hash);
 }
 
 mirror::String* InternTable::LookupWeak(mirror::String* s) {
-  return weak_interns_.Find(s);
+  const int32_t hash = s->GetHashCode();
+  return GetShard(hash).weak_interns_.Find(s, hash);
 }
 
 void InternTable::SwapPostZygoteWithPreZygote() {
-  MutexLock mu(Thread::Current(), *Locks::intern_table_lock_);
-  weak_interns_.SwapPostZygoteWithPreZygote();
-  strong_interns_.SwapPostZygoteWithPreZygote();
+  Thread* self = Thread::Current();
+  MutexLock mu(self, *Locks::intern_table_lock_);
+  for (Shard& shard : shards_) {
+    MutexLock mu2(self, shard.lock_);
+    shard.weak_interns_.SwapPostZygoteWithPreZygote();
+    shard.strong_interns_.SwapPostZygoteWithPreZygote();
+  }
+}
+
+mirror::String* InternTable::InsertStrongLocked(Shard* shard, mirror::String* s, int32_t hash) {
+  if (log_new_roots_.LoadRelaxed()) {
+    shard->new_strong_intern_roots_.push_back(GcRoot<mirror::String>(s));
+  }
+  shard->strong_interns_.Insert(s, hash);
+  return s;
 }
 
 mirror::String* InternTable::InsertStrong(mirror::String* s) {
@@ -101,11 +364,10 @@ mirror::String* InternTable::InsertStrong(mirror::String* s) {
   if (runtime->IsActiveTransaction()) {
     runtime->RecordStrongStringInsertion(s);
   }
-  if (log_new_roots_) {
-    new_strong_intern_roots_.push_back(GcRoot<mirror::String>(s));
-  }
-  strong_interns_.Insert(s);
-  return s;
+  const int32_t hash = s->GetHashCode();
+  Shard& shard = GetShard(hash);
+  MutexLock mu(Thread::Current(), shard.lock_);
+  return InsertStrongLocked(&shard, s, hash);
 }
 
 mirror::String* InternTable::InsertWeak(mirror::String* s) {
@@ -113,12 +375,18 @@ mirror::String* InternTable::InsertWeak(mirror::String* s) {
   if (runtime->IsActiveTransaction()) {
     runtime->RecordWeakStringInsertion(s);
   }
-  weak_interns_.Insert(s);
+  const int32_t hash = s->GetHashCode();
+  Shard& shard = GetShard(hash);
+  MutexLock mu(Thread::Current(), shard.lock_);
+  shard.weak_interns_.Insert(s, hash);
   return s;
 }
 
 void InternTable::RemoveStrong(mirror::String* s) {
-  strong_interns_.Remove(s);
+  const int32_t hash = s->GetHashCode();
+  Shard& shard = GetShard(hash);
+  MutexLock mu(Thread::Current(), shard.lock_);
+  shard.strong_interns_.Remove(s, hash);
 }
 
 void InternTable::RemoveWeak(mirror::String* s) {
@@ -126,7 +394,10 @@ void InternTable::RemoveWeak(mirror::String* s) {
   if (runtime->IsActiveTransaction()) {
     runtime->RecordWeakStringRemoval(s);
   }
-  weak_interns_.Remove(s);
+  const int32_t hash = s->GetHashCode();
+  Shard& shard = GetShard(hash);
+  MutexLock mu(Thread::Current(), shard.lock_);
+  shard.weak_interns_.Remove(s, hash);
 }
 
 // Insert/remove methods used to undo changes made during an aborted transaction.
@@ -149,8 +420,9 @@ void InternTable::RemoveWeakFromTransaction(mirror::String* s) {
 
 void InternTable::AddImageStringsToTable(gc::space::ImageSpace* image_space) {
   CHECK(image_space != nullptr);
-  MutexLock mu(Thread::Current(), *Locks::intern_table_lock_);
-  if (!image_added_to_intern_table_) {
+  Thread* self = Thread::Current();
+  MutexLock mu(self, *Locks::intern_table_lock_);
+  if (!image_added_to_intern_table_.LoadRelaxed()) {
     mirror::Object* root = image_space->GetImageHeader().GetImageRoot(ImageHeader::kDexCaches);
     mirror::ObjectArray<mirror::DexCache>* dex_caches = root->AsObjectArray<mirror::DexCache>();
     for (int32_t i = 0; i < dex_caches->GetLength(); ++i) {
@@ -160,22 +432,25 @@ void InternTable::AddImageStringsToTable(gc::space::ImageSpace* image_space) {
       for (size_t j = 0; j < num_strings; ++j) {
         mirror::String* image_string = dex_cache->GetResolvedString(j);
         if (image_string != nullptr) {
-          mirror::String* found = LookupStrong(image_string);
+          const int32_t hash = image_string->GetHashCode();
+          Shard& shard = GetShard(hash);
+          MutexLock mu2(self, shard.lock_);
+          mirror::String* found = shard.strong_interns_.Find(image_string, hash);
           if (found == nullptr) {
-            InsertStrong(image_string);
+            InsertStrongLocked(&shard, image_string, hash);
           } else {
             DCHECK_EQ(found, image_string);
           }
         }
       }
     }
-    image_added_to_intern_table_ = true;
+    image_added_to_intern_table_.StoreRelaxed(true);
   }
 }
 
 mirror::String* InternTable::LookupStringFromImage(mirror::String* s)
     SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
-  if (image_added_to_intern_table_) {
+  if (image_added_to_intern_table_.LoadRelaxed()) {
     return nullptr;
   }
   gc::space::ImageSpace* image = Runtime::Current()->GetHeap()->GetImageSpace();
@@ -204,23 +479,93 @@ mirror::String* InternTable::LookupStringFromImage(mirror::String* s)
 void InternTable::AllowNewInterns() {
   Thread* self = Thread::Current();
   MutexLock mu(self, *Locks::intern_table_lock_);
-  allow_new_interns_ = true;
+  allow_new_interns_.StoreRelaxed(true);
   new_intern_condition_.Broadcast(self);
+  for (Shard& shard : shards_) {
+    MutexLock mu2(self, shard.lock_);
+    shard.new_intern_condition_.Broadcast(self);
+  }
 }
 
 void InternTable::DisallowNewInterns() {
   Thread* self = Thread::Current();
   MutexLock mu(self, *Locks::intern_table_lock_);
-  allow_new_interns_ = false;
+  allow_new_interns_.StoreRelaxed(false);
+  // With the mutator lock held exclusively no thread can be in the lock-free lookup, so the slot
+  // arrays replaced since the last time are no longer referenced.
+  if (Locks::mutator_lock_->IsExclusiveHeld(self)) {
+    for (Shard& shard : shards_) {
+      MutexLock mu2(self, shard.lock_);
+      shard.strong_interns_.FreeRetiredArrays();
+      shard.weak_interns_.FreeRetiredArrays();
+    }
+  }
 }
 
 mirror::String* InternTable::Insert(mirror::String* s, bool is_strong) {
   if (s == nullptr) {
     return nullptr;
   }
+  const int32_t hash = s->GetHashCode();
+  Shard& shard = GetShard(hash);
+  // Most interns are of strings which are already in the table, find those without locking. The
+  // weak table may only be used while interns are allowed, since it is swept otherwise.
+  if (LIKELY(allow_new_interns_.LoadRelaxed())) {
+    mirror::String* strong = shard.strong_interns_.Find(s, hash);
+    if (strong != nullptr) {
+      return strong;
+    }
+    if (!is_strong) {
+      mirror::String* weak = shard.weak_interns_.Find(s, hash);
+      if (weak != nullptr) {
+        return weak;
+      }
+    }
+  }
   Thread* self = Thread::Current();
+  if (UNLIKELY(Runtime::Current()->IsActiveTransaction())) {
+    return InsertInTransaction(self, s, is_strong);
+  }
+  MutexLock mu(self, shard.lock_);
+  while (UNLIKELY(!allow_new_interns_.LoadRelaxed())) {
+    shard.new_intern_condition_.WaitHoldingLocks(self);
+  }
+  // Check the strong table for a match, another thread may have inserted it since the lookup.
+  mirror::String* strong = shard.strong_interns_.Find(s, hash);
+  if (strong != nullptr) {
+    return strong;
+  }
+  // Check the image for a match.
+  mirror::String* image = LookupStringFromImage(s);
+  if (image != nullptr) {
+    if (is_strong) {
+      return InsertStrongLocked(&shard, image, hash);
+    }
+    shard.weak_interns_.Insert(image, hash);
+    return image;
+  }
+  // There is no match in the strong table, check the weak table.
+  mirror::String* weak = shard.weak_interns_.Find(s, hash);
+  if (weak != nullptr) {
+    if (is_strong) {
+      // A match was found in the weak table. Promote to the strong table.
+      shard.weak_interns_.Remove(weak, hash);
+      return InsertStrongLocked(&shard, weak, hash);
+    }
+    return weak;
+  }
+  // No match in the strong table or the weak table. Insert into the strong / weak table.
+  if (is_strong) {
+    return InsertStrongLocked(&shard, s, hash);
+  }
+  shard.weak_interns_.Insert(s, hash);
+  return s;
+}
+
+mirror::String* InternTable::InsertInTransaction(Thread* self, mirror::String* s,
+                                                 bool is_strong) {
   MutexLock mu(self, *Locks::intern_table_lock_);
-  while (UNLIKELY(!allow_new_interns_)) {
+  while (UNLIKELY(!allow_new_interns_.LoadRelaxed())) {
     new_intern_condition_.WaitHoldingLocks(self);
   }
   // Check the strong table for a match.
@@ -267,96 +612,15 @@ mirror::String* InternTable::InternWeak(mirror::String* s) {
 }
 
 bool InternTable::ContainsWeak(mirror::String* s) {
-  MutexLock mu(Thread::Current(), *Locks::intern_table_lock_);
   return LookupWeak(s) == s;
 }
 
 void InternTable::SweepInternTableWeaks(IsMarkedCallback* callback, void* arg) {
-  MutexLock mu(Thread::Current(), *Locks::intern_table_lock_);
-  weak_interns_.SweepWeaks(callback, arg);
-}
-
-std::size_t InternTable::StringHashEquals::operator()(const GcRoot<mirror::String>& root) const {
-  if (kIsDebugBuild) {
-    Locks::mutator_lock_->AssertSharedHeld(Thread::Current());
-  }
-  return static_cast<size_t>(root.Read()->GetHashCode());
-}
-
-bool InternTable::StringHashEquals::operator()(const GcRoot<mirror::String>& a,
-                                               const GcRoot<mirror::String>& b) const {
-  if (kIsDebugBuild) {
-    Locks::mutator_lock_->AssertSharedHeld(Thread::Current());
-  }
-  return a.Read()->Equals(b.Read());
-}
-
-void InternTable::Table::Remove(mirror::String* s) {
-  auto it = post_zygote_table_.Find(GcRoot<mirror::String>(s));
-  if (it != post_zygote_table_.end()) {
-    post_zygote_table_.Erase(it);
-  } else {
-    it = pre_zygote_table_.Find(GcRoot<mirror::String>(s));
-    DCHECK(it != pre_zygote_table_.end());
-    pre_zygote_table_.Erase(it);
-  }
-}
-
-mirror::String* InternTable::Table::Find(mirror::String* s) {
-  Locks::intern_table_lock_->AssertHeld(Thread::Current());
-  auto it = pre_zygote_table_.Find(GcRoot<mirror::String>(s));
-  if (it != pre_zygote_table_.end()) {
-    return it->Read();
-  }
-  it = post_zygote_table_.Find(GcRoot<mirror::String>(s));
-  if (it != post_zygote_table_.end()) {
-    return it->Read();
-  }
-  return nullptr;
-}
-
-void InternTable::Table::SwapPostZygoteWithPreZygote() {
-  CHECK(pre_zygote_table_.Empty());
-  std::swap(pre_zygote_table_, post_zygote_table_);
-  VLOG(heap) << "Swapping " << pre_zygote_table_.Size() << " interns to the pre zygote table";
-}
-
-void InternTable::Table::Insert(mirror::String* s) {
-  // Always insert the post zygote table, this gets swapped when we create the zygote to be the
-  // pre zygote table.
-  post_zygote_table_.Insert(GcRoot<mirror::String>(s));
-}
-
-void InternTable::Table::VisitRoots(RootCallback* callback, void* arg) {
-  for (auto& intern : pre_zygote_table_) {
-    intern.VisitRoot(callback, arg, RootInfo(kRootInternedString));
-  }
-  for (auto& intern : post_zygote_table_) {
-    intern.VisitRoot(callback, arg, RootInfo(kRootInternedString));
-  }
-}
-
-void InternTable::Table::SweepWeaks(IsMarkedCallback* callback, void* arg) {
-  SweepWeaks(&pre_zygote_table_, callback, arg);
-  SweepWeaks(&post_zygote_table_, callback, arg);
-}
-
-void InternTable::Table::SweepWeaks(UnorderedSet* set, IsMarkedCallback* callback, void* arg) {
-  for (auto it = set->begin(), end = set->end(); it != end;) {
-    // This does not need a read barrier because this is called by GC.
-    mirror::Object* object = it->Read<kWithoutReadBarrier>();
-    mirror::Object* new_object = callback(object, arg);
-    if (new_object == nullptr) {
-      it = set->Erase(it);
-    } else {
-      *it = GcRoot<mirror::String>(new_object->AsString());
-      ++it;
-    }
+  Thread* self = Thread::Current();
+  for (Shard& shard : shards_) {
+    MutexLock mu(self, shard.lock_);
+    shard.weak_interns_.SweepWeaks(callback, arg);
   }
 }
 
-size_t InternTable::Table::Size() const {
-  return pre_zygote_table_.Size() + post_zygote_table_.Size();
-}
-
 }  // namespace art
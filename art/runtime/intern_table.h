@@ -17,10 +17,9 @@
 #ifndef ART_RUNTIME_INTERN_TABLE_H_
 #define ART_RUNTIME_INTERN_TABLE_H_
 
-#include <unordered_set>
+#include <vector>
 
-#include "base/allocator.h"
-#include "base/hash_set.h"
+#include "atomic.h"
 #include "base/mutex.h"
 #include "gc_root.h"
 #include "object_callbacks.h"
@@ -49,6 +48,11 @@ class Transaction;
  * String.intern. Some code (XML parsers being a prime example) relies on being able to intern
  * arbitrarily many strings for the duration of a parse without permanently increasing the memory
  * footprint.
+ *
+ * Both tables are split into shards by string hash. Looking up a string which is already interned
+ * takes no lock at all, inserting a new one only takes the lock of its shard. The global
+ * Locks::intern_table_lock_ is only used for transactions, for the image strings and to
+ * serialize root visiting.
  */
 class InternTable {
  public:
@@ -97,86 +101,107 @@ class InternTable {
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) LOCKS_EXCLUDED(Locks::intern_table_lock_);
 
  private:
-  class StringHashEquals {
-   public:
-    std::size_t operator()(const GcRoot<mirror::String>& root) const NO_THREAD_SAFETY_ANALYSIS;
-    bool operator()(const GcRoot<mirror::String>& a, const GcRoot<mirror::String>& b) const
-        NO_THREAD_SAFETY_ANALYSIS;
-  };
-  class GcRootEmptyFn {
-   public:
-    void MakeEmpty(GcRoot<mirror::String>& item) const {
-      item = GcRoot<mirror::String>();
-    }
-    bool IsEmpty(const GcRoot<mirror::String>& item) const {
-      return item.IsNull();
-    }
-  };
-
-  // Table which holds pre zygote and post zygote interned strings. There is one instance for
-  // weak interns and strong interns.
+  static constexpr size_t kShardBits = 4;
+  static constexpr size_t kShardCount = 1U << kShardBits;
+
+  // Open addressing hash set of strings which may be searched without holding any lock. A slot
+  // goes from empty to holding a string, and from holding a string to a tombstone or to the new
+  // address of the string after a moving GC, but never back to empty. Growing publishes a new
+  // slot array and retires the old one, which lock-free readers may still be probing. Retired
+  // arrays are freed once no reader can be running, that is when the mutator lock is held
+  // exclusively.
+  //
+  // Other than Find, all methods require the lock of the shard owning the table.
   class Table {
    public:
-    mirror::String* Find(mirror::String* s) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_)
-        EXCLUSIVE_LOCKS_REQUIRED(Locks::intern_table_lock_);
-    void Insert(mirror::String* s) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_)
-        EXCLUSIVE_LOCKS_REQUIRED(Locks::intern_table_lock_);
-    void Remove(mirror::String* s)
-        SHARED_LOCKS_REQUIRED(Locks::mutator_lock_)
-        EXCLUSIVE_LOCKS_REQUIRED(Locks::intern_table_lock_);
+    Table();
+    ~Table();
+
+    mirror::String* Find(mirror::String* s, int32_t hash)
+        SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+    void Insert(mirror::String* s, int32_t hash) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+    void Remove(mirror::String* s, int32_t hash) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
     void VisitRoots(RootCallback* callback, void* arg)
-        SHARED_LOCKS_REQUIRED(Locks::mutator_lock_)
-        EXCLUSIVE_LOCKS_REQUIRED(Locks::intern_table_lock_);
+        SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
     void SweepWeaks(IsMarkedCallback* callback, void* arg)
-        SHARED_LOCKS_REQUIRED(Locks::mutator_lock_)
-        EXCLUSIVE_LOCKS_REQUIRED(Locks::intern_table_lock_);
-    void SwapPostZygoteWithPreZygote() EXCLUSIVE_LOCKS_REQUIRED(Locks::intern_table_lock_);
-    size_t Size() const EXCLUSIVE_LOCKS_REQUIRED(Locks::intern_table_lock_);
+        SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+    void SwapPostZygoteWithPreZygote();
+    void FreeRetiredArrays();
+    size_t Size() const;
 
    private:
-    typedef HashSet<GcRoot<mirror::String>, GcRootEmptyFn, StringHashEquals, StringHashEquals,
-        TrackingAllocator<GcRoot<mirror::String>, kAllocatorTagInternTable>> UnorderedSet;
+    class SlotArray;
 
-    void SweepWeaks(UnorderedSet* set, IsMarkedCallback* callback, void* arg)
-        SHARED_LOCKS_REQUIRED(Locks::mutator_lock_)
-        EXCLUSIVE_LOCKS_REQUIRED(Locks::intern_table_lock_);
+    static mirror::String* Find(SlotArray* array, mirror::String* s, int32_t hash)
+        SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+    static bool Remove(SlotArray* array, mirror::String* s, int32_t hash);
+    static void VisitRoots(SlotArray* array, RootCallback* callback, void* arg)
+        SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+    static void SweepWeaks(SlotArray* array, IsMarkedCallback* callback, void* arg)
+        SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+    SlotArray* Rehash(SlotArray* array);
 
     // We call SwapPostZygoteWithPreZygote when we create the zygote to reduce private dirty pages
     // caused by modifying the zygote intern table hash table. The pre zygote table are the
     // interned strings which were interned before we created the zygote space. Post zygote is self
     // explanatory.
-    UnorderedSet pre_zygote_table_;
-    UnorderedSet post_zygote_table_;
+    Atomic<SlotArray*> pre_zygote_table_;
+    Atomic<SlotArray*> post_zygote_table_;
+    std::vector<SlotArray*> retired_arrays_;
+
+    DISALLOW_COPY_AND_ASSIGN(Table);
   };
 
+  // The strong and weak interns of one range of string hashes.
+  class Shard {
+   public:
+    Shard();
+
+    mutable Mutex lock_ ACQUIRED_AFTER(Locks::intern_table_lock_);
+    ConditionVariable new_intern_condition_ GUARDED_BY(lock_);
+    // Since these contain roots, they need a read barrier to enable concurrent root scans. Do not
+    // directly access the strings in them. Use functions that contain read barriers.
+    Table strong_interns_;
+    Table weak_interns_;
+    std::vector<GcRoot<mirror::String>> new_strong_intern_roots_ GUARDED_BY(lock_);
+
+   private:
+    DISALLOW_COPY_AND_ASSIGN(Shard);
+  };
+
+  Shard& GetShard(int32_t hash);
+  const Shard& GetShard(int32_t hash) const;
+
   // Insert if non null, otherwise return nullptr.
   mirror::String* Insert(mirror::String* s, bool is_strong)
       LOCKS_EXCLUDED(Locks::intern_table_lock_)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  // Slow path of Insert while a transaction is active, changes need to be logged under the
+  // intern table lock.
+  mirror::String* InsertInTransaction(Thread* self, mirror::String* s, bool is_strong)
+      LOCKS_EXCLUDED(Locks::intern_table_lock_)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
   mirror::String* LookupStrong(mirror::String* s)
-      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_)
-      EXCLUSIVE_LOCKS_REQUIRED(Locks::intern_table_lock_);
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
   mirror::String* LookupWeak(mirror::String* s)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  mirror::String* InsertStrongLocked(Shard* shard, mirror::String* s, int32_t hash)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_)
-      EXCLUSIVE_LOCKS_REQUIRED(Locks::intern_table_lock_);
+      EXCLUSIVE_LOCKS_REQUIRED(shard->lock_);
+  // These take the lock of the shard owning `s`, which must not be held.
   mirror::String* InsertStrong(mirror::String* s)
-      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_)
-      EXCLUSIVE_LOCKS_REQUIRED(Locks::intern_table_lock_);
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
   mirror::String* InsertWeak(mirror::String* s)
-      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_)
-      EXCLUSIVE_LOCKS_REQUIRED(Locks::intern_table_lock_);
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
   void RemoveStrong(mirror::String* s)
-      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_)
-      EXCLUSIVE_LOCKS_REQUIRED(Locks::intern_table_lock_);
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
   void RemoveWeak(mirror::String* s)
-      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_)
-      EXCLUSIVE_LOCKS_REQUIRED(Locks::intern_table_lock_);
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
   // Transaction rollback access.
   mirror::String* LookupStringFromImage(mirror::String* s)
-      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_)
-      EXCLUSIVE_LOCKS_REQUIRED(Locks::intern_table_lock_);
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
   mirror::String* InsertStrongFromTransaction(mirror::String* s)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_)
       EXCLUSIVE_LOCKS_REQUIRED(Locks::intern_table_lock_);
@@ -191,21 +216,16 @@ class InternTable {
       EXCLUSIVE_LOCKS_REQUIRED(Locks::intern_table_lock_);
   friend class Transaction;
 
-  bool image_added_to_intern_table_ GUARDED_BY(Locks::intern_table_lock_);
-  bool log_new_roots_ GUARDED_BY(Locks::intern_table_lock_);
-  bool allow_new_interns_ GUARDED_BY(Locks::intern_table_lock_);
+  // Only written with the intern table lock held. Read under a shard lock, which orders it with
+  // the image strings being inserted into that shard.
+  Atomic<bool> image_added_to_intern_table_;
+  // Only written with the intern table lock held, read by inserts under their shard lock.
+  Atomic<bool> log_new_roots_;
+  // Read without any lock by the lookup fast path. This is safe since it is only cleared with the
+  // mutator lock held exclusively, so a reader which saw it set finishes before sweeping starts.
+  Atomic<bool> allow_new_interns_;
   ConditionVariable new_intern_condition_ GUARDED_BY(Locks::intern_table_lock_);
-  // Since this contains (strong) roots, they need a read barrier to
-  // enable concurrent intern table (strong) root scan. Do not
-  // directly access the strings in it. Use functions that contain
-  // read barriers.
-  Table strong_interns_ GUARDED_BY(Locks::intern_table_lock_);
-  std::vector<GcRoot<mirror::String>> new_strong_intern_roots_
-      GUARDED_BY(Locks::intern_table_lock_);
-  // Since this contains (weak) roots, they need a read barrier. Do
-  // not directly access the strings in it. Use functions that contain
-  // read barriers.
-  Table weak_interns_ GUARDED_BY(Locks::intern_table_lock_);
+  Shard shards_[kShardCount];
 };
 
 }  // namespace art
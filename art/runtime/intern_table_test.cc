@@ -16,11 +16,13 @@
 
 #include "intern_table.h"
 
+#include "base/stringprintf.h"
 #include "common_runtime_test.h"
 #include "mirror/object.h"
 #include "handle_scope-inl.h"
 #include "mirror/string.h"
 #include "scoped_thread_state_change.h"
+#include "thread_pool.h"
 
 namespace art {
 
@@ -182,4 +184,92 @@ TEST_F(InternTableTest, ContainsWeak) {
   }
 }
 
+// Interns every name of a shared set in an order which differs from task to task, so that most
+// interns hit strings another thread already added.
+class InternTask : public Task {
+ public:
+  InternTask(InternTable* intern_table, const std::vector<std::string>* names, size_t start,
+             size_t rounds)
+      : intern_table_(intern_table), names_(names), start_(start), rounds_(rounds) {}
+
+  void Run(Thread* self) {
+    ScopedObjectAccess soa(self);
+    const size_t count = names_->size();
+    for (size_t round = 0; round < rounds_; ++round) {
+      for (size_t i = 0; i < count; ++i) {
+        const std::string& name = (*names_)[(start_ + i * 7) % count];
+        mirror::String* interned = intern_table_->InternStrong(name.c_str());
+        CHECK(interned != nullptr);
+        CHECK(interned->Equals(name.c_str()));
+      }
+    }
+  }
+
+  void Finalize() {
+    delete this;
+  }
+
+ private:
+  InternTable* const intern_table_;
+  const std::vector<std::string>* const names_;
+  const size_t start_;
+  const size_t rounds_;
+};
+
+static std::vector<std::string> MakeNames(const char* prefix, size_t count) {
+  std::vector<std::string> names;
+  for (size_t i = 0; i < count; ++i) {
+    names.push_back(StringPrintf("%s%zd", prefix, i));
+  }
+  return names;
+}
+
+// Uses the runtime's table, whose strong interns are GC roots, since the tasks allocate.
+TEST_F(InternTableTest, ConcurrentInternStrong) {
+  static const size_t kThreads = 8;
+  static const size_t kNames = 4096;
+  Thread* self = Thread::Current();
+  InternTable* intern_table = Runtime::Current()->GetInternTable();
+  const std::vector<std::string> names = MakeNames("ConcurrentInternStrong", kNames);
+  const size_t initial_size = intern_table->StrongSize();
+  ThreadPool thread_pool("Intern table test thread pool", kThreads);
+  for (size_t i = 0; i < kThreads; ++i) {
+    thread_pool.AddTask(self, new InternTask(intern_table, &names, i * (kNames / kThreads), 2));
+  }
+  thread_pool.StartWorkers(self);
+  thread_pool.Wait(self, true, false);
+  EXPECT_EQ(initial_size + kNames, intern_table->StrongSize());
+
+  ScopedObjectAccess soa(self);
+  for (const std::string& name : names) {
+    StackHandleScope<1> hs(soa.Self());
+    Handle<mirror::String> s(
+        hs.NewHandle(mirror::String::AllocFromModifiedUtf8(soa.Self(), name.c_str())));
+    mirror::String* interned = intern_table->InternStrong(s.Get());
+    EXPECT_NE(s.Get(), interned);
+    EXPECT_EQ(interned, intern_table->InternStrong(name.c_str()));
+  }
+}
+
+// Run with --gtest_also_run_disabled_tests.
+TEST_F(InternTableTest, DISABLED_ConcurrentInternThroughput) {
+  static const size_t kNames = 16 * 1024;
+  static const size_t kRounds = 16;
+  Thread* self = Thread::Current();
+  InternTable* intern_table = Runtime::Current()->GetInternTable();
+  const std::vector<std::string> names = MakeNames("ConcurrentInternThroughput", kNames);
+  for (size_t threads = 1; threads <= 16; threads *= 2) {
+    ThreadPool thread_pool("Intern table throughput thread pool", threads);
+    for (size_t i = 0; i < threads; ++i) {
+      thread_pool.AddTask(self, new InternTask(intern_table, &names, i * 7919, kRounds));
+    }
+    const uint64_t start = NanoTime();
+    thread_pool.StartWorkers(self);
+    thread_pool.Wait(self, true, false);
+    const uint64_t duration = NanoTime() - start;
+    const uint64_t interns = static_cast<uint64_t>(threads) * kNames * kRounds;
+    LOG(INFO) << threads << " threads: " << interns * 1000000000 / duration << " interns/s";
+  }
+}
+
 }  // namespace art
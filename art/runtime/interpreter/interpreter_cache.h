@@ -0,0 +1,127 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_INTERPRETER_INTERPRETER_CACHE_H_
+#define ART_RUNTIME_INTERPRETER_INTERPRETER_CACHE_H_
+
+#include <stdint.h>
+#include <string.h>
+
+#include "base/casts.h"
+#include "base/macros.h"
+#include "gc_root.h"
+#include "object_callbacks.h"
+
+namespace art {
+
+class Instruction;
+namespace mirror {
+  class ArtField;
+  class ArtMethod;
+  class Class;
+  class Object;
+}  // namespace mirror
+
+namespace interpreter {
+
+// Inline caches for the instructions the interpreter executes, private to a thread so that they
+// need no synchronization. The cache is direct mapped and keyed by the address of the instruction,
+// which identifies it for as long as its method may run, since the dex files of loaded classes are
+// never freed. An instance field access caches its resolved field, and an invoke-virtual or
+// invoke-interface its target for one receiver class.
+//
+// The same instruction may run for methods of several class loaders, which share the opened dex
+// file, and resolves against the dex cache of each. A field access is therefore also keyed by the
+// method running it.
+//
+// Only results that passed all resolution and access checks are cached, and those only depend on
+// the entry's key, so a hit may skip them.
+class InterpreterCache {
+ public:
+  // A power of two.
+  static constexpr size_t kSize = 256;
+
+  InterpreterCache() {
+    Clear();
+  }
+
+  void Clear() {
+    memset(entries_, 0, sizeof(entries_));
+  }
+
+  // Returns the field the access resolved to when run by the method, or nullptr.
+  mirror::ArtField* GetField(const Instruction* inst, mirror::ArtMethod* method) const {
+    const Entry& entry = entries_[IndexOf(inst)];
+    return LIKELY(entry.inst == inst && entry.key == reinterpret_cast<mirror::Object*>(method))
+        ? reinterpret_cast<mirror::ArtField*>(entry.target) : nullptr;
+  }
+
+  void SetField(const Instruction* inst, mirror::ArtMethod* method, mirror::ArtField* field) {
+    Entry& entry = entries_[IndexOf(inst)];
+    entry.inst = inst;
+    entry.key = reinterpret_cast<mirror::Object*>(method);
+    entry.target = reinterpret_cast<mirror::Object*>(field);
+  }
+
+  // Returns the method the invoke resolved to for receivers of the class, or nullptr.
+  mirror::ArtMethod* GetMethod(const Instruction* inst, mirror::Class* klass) const {
+    const Entry& entry = entries_[IndexOf(inst)];
+    return LIKELY(entry.inst == inst && entry.key == reinterpret_cast<mirror::Object*>(klass))
+        ? reinterpret_cast<mirror::ArtMethod*>(entry.target) : nullptr;
+  }
+
+  void SetMethod(const Instruction* inst, mirror::Class* klass, mirror::ArtMethod* method) {
+    Entry& entry = entries_[IndexOf(inst)];
+    entry.inst = inst;
+    entry.key = reinterpret_cast<mirror::Object*>(klass);
+    entry.target = reinterpret_cast<mirror::Object*>(method);
+  }
+
+  // The keys and targets may be moved by the GC.
+  void VisitRoots(RootCallback* visitor, void* arg, uint32_t thread_id) {
+    for (Entry& entry : entries_) {
+      if (entry.key != nullptr) {
+        visitor(&entry.key, arg, RootInfo(kRootVMInternal, thread_id));
+      }
+      if (entry.target != nullptr) {
+        visitor(&entry.target, arg, RootInfo(kRootVMInternal, thread_id));
+      }
+    }
+  }
+
+ private:
+  struct Entry {
+    const Instruction* inst;
+    // The method running a field access, or the receiver class of an invoke.
+    mirror::Object* key;
+    // The ArtField or ArtMethod.
+    mirror::Object* target;
+  };
+
+  static size_t IndexOf(const Instruction* inst) {
+    // Instructions are 16 bit aligned.
+    return (reinterpret_cast<uintptr_t>(inst) >> 1) & (kSize - 1);
+  }
+
+  Entry entries_[kSize];
+
+  DISALLOW_COPY_AND_ASSIGN(InterpreterCache);
+};
+
+}  // namespace interpreter
+}  // namespace art
+
+#endif  // ART_RUNTIME_INTERPRETER_INTERPRETER_CACHE_H_
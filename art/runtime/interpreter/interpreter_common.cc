@@ -30,12 +30,20 @@ template<FindFieldType find_type, Primitive::Type field_type, bool do_access_che
 bool DoFieldGet(Thread* self, ShadowFrame& shadow_frame, const Instruction* inst,
                 uint16_t inst_data) {
   const bool is_static = (find_type == StaticObjectRead) || (find_type == StaticPrimitiveRead);
-  const uint32_t field_idx = is_static ? inst->VRegB_21c() : inst->VRegC_22c();
-  ArtField* f = FindFieldFromCode<find_type, do_access_check>(field_idx, shadow_frame.GetMethod(), self,
-                                                              Primitive::FieldSize(field_type));
-  if (UNLIKELY(f == nullptr)) {
-    CHECK(self->IsExceptionPending());
-    return false;
+  // Static fields are always resolved again, since that is where their class gets initialized.
+  ArtField* f =
+      is_static ? nullptr : GetInterpreterCache(self)->GetField(inst, shadow_frame.GetMethod());
+  if (f == nullptr) {
+    const uint32_t field_idx = is_static ? inst->VRegB_21c() : inst->VRegC_22c();
+    f = FindFieldFromCode<find_type, do_access_check>(field_idx, shadow_frame.GetMethod(), self,
+                                                      Primitive::FieldSize(field_type));
+    if (UNLIKELY(f == nullptr)) {
+      CHECK(self->IsExceptionPending());
+      return false;
+    }
+    if (!is_static) {
+      GetInterpreterCache(self)->SetField(inst, shadow_frame.GetMethod(), f);
+    }
   }
   Object* obj;
   if (is_static) {
@@ -206,12 +214,20 @@ bool DoFieldPut(Thread* self, const ShadowFrame& shadow_frame, const Instruction
                 uint16_t inst_data) {
   bool do_assignability_check = do_access_check;
   bool is_static = (find_type == StaticObjectWrite) || (find_type == StaticPrimitiveWrite);
-  uint32_t field_idx = is_static ? inst->VRegB_21c() : inst->VRegC_22c();
-  ArtField* f = FindFieldFromCode<find_type, do_access_check>(field_idx, shadow_frame.GetMethod(), self,
-                                                              Primitive::FieldSize(field_type));
-  if (UNLIKELY(f == nullptr)) {
-    CHECK(self->IsExceptionPending());
-    return false;
+  // See DoFieldGet.
+  ArtField* f =
+      is_static ? nullptr : GetInterpreterCache(self)->GetField(inst, shadow_frame.GetMethod());
+  if (f == nullptr) {
+    uint32_t field_idx = is_static ? inst->VRegB_21c() : inst->VRegC_22c();
+    f = FindFieldFromCode<find_type, do_access_check>(field_idx, shadow_frame.GetMethod(), self,
+                                                      Primitive::FieldSize(field_type));
+    if (UNLIKELY(f == nullptr)) {
+      CHECK(self->IsExceptionPending());
+      return false;
+    }
+    if (!is_static) {
+      GetInterpreterCache(self)->SetField(inst, shadow_frame.GetMethod(), f);
+    }
   }
   Object* obj;
   if (is_static) {
@@ -30,6 +30,7 @@
 #include "entrypoints/entrypoint_utils-inl.h"
 #include "gc/accounting/card_table-inl.h"
 #include "handle_scope-inl.h"
+#include "interpreter_cache.h"
 #include "method_helper-inl.h"
 #include "nth_caller_visitor.h"
 #include "mirror/art_field-inl.h"
@@ -87,6 +88,16 @@ static inline void DoMonitorExit(Thread* self, Object* ref) NO_THREAD_SAFETY_ANA
   ref->MonitorExit(self);
 }
 
+// Returns the inline caches of the thread, creating them when the interpreter first needs them.
+static inline InterpreterCache* GetInterpreterCache(Thread* self) {
+  InterpreterCache* cache = self->GetInterpreterCache();
+  if (UNLIKELY(cache == nullptr)) {
+    cache = new InterpreterCache();
+    self->SetInterpreterCache(cache);
+  }
+  return cache;
+}
+
 void AbortTransaction(Thread* self, const char* fmt, ...)
     SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
@@ -108,6 +119,17 @@ static inline bool DoInvoke(Thread* self, ShadowFrame& shadow_frame, const Instr
   const uint32_t method_idx = (is_range) ? inst->VRegB_3rc() : inst->VRegB_35c();
   const uint32_t vregC = (is_range) ? inst->VRegC_3rc() : inst->VRegC_35c();
   Object* receiver = (type == kStatic) ? nullptr : shadow_frame.GetVRegReference(vregC);
+  // Virtual and interface calls dispatch on the receiver class only, so the target found for the
+  // last receiver of the same class is still the right one.
+  const bool use_cache = (type == kVirtual || type == kInterface) && receiver != nullptr;
+  if (use_cache) {
+    ArtMethod* const cached_method =
+        GetInterpreterCache(self)->GetMethod(inst, receiver->GetClass());
+    if (LIKELY(cached_method != nullptr)) {
+      return DoCall<is_range, do_access_check>(cached_method, self, shadow_frame, inst, inst_data,
+                                               result);
+    }
+  }
   mirror::ArtMethod* sf_method = shadow_frame.GetMethod();
   ArtMethod* const method = FindMethodFromCode<type, do_access_check>(
       method_idx, &receiver, &sf_method, self);
@@ -121,6 +143,10 @@ static inline bool DoInvoke(Thread* self, ShadowFrame& shadow_frame, const Instr
     result->SetJ(0);
     return false;
   } else {
+    if (use_cache) {
+      // Resolution may have suspended and moved the receiver, but not changed its class.
+      GetInterpreterCache(self)->SetMethod(inst, receiver->GetClass(), method);
+    }
     return DoCall<is_range, do_access_check>(method, self, shadow_frame, inst, inst_data, result);
   }
 }
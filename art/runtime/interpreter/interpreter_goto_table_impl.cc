@@ -40,6 +40,28 @@ namespace interpreter {
     goto *currentHandlersTable[inst->Opcode(inst_data)];                    \
   } while (false)
 
+// Like ADVANCE, for instructions usually followed by one of two others. The jump to their
+// handlers is direct, and so predicted for this pair of instructions rather than for all the
+// instructions sharing the indirect jump. An alternative handler is never taken this way, so
+// instrumentation sees each instruction as before.
+#define ADVANCE_PREDICTED(_offset, _next_opcode1, _next_opcode2)            \
+  do {                                                                      \
+    int32_t disp = static_cast<int32_t>(_offset);                           \
+    inst = inst->RelativeAt(disp);                                          \
+    dex_pc = static_cast<uint32_t>(static_cast<int32_t>(dex_pc) + disp);    \
+    shadow_frame.SetDexPC(dex_pc);                                          \
+    TraceExecution(shadow_frame, inst, dex_pc, mh);                         \
+    inst_data = inst->Fetch16(0);                                           \
+    const void* next_handler = currentHandlersTable[inst->Opcode(inst_data)]; \
+    if (next_handler == &&op_##_next_opcode1) {                             \
+      goto op_##_next_opcode1;                                              \
+    }                                                                       \
+    if (next_handler == &&op_##_next_opcode2) {                             \
+      goto op_##_next_opcode2;                                              \
+    }                                                                       \
+    goto *next_handler;                                                     \
+  } while (false)
+
 #define HANDLE_PENDING_EXCEPTION() goto exception_pending_label
 
 #define POSSIBLY_HANDLE_PENDING_EXCEPTION(_is_exception_pending, _offset)   \
@@ -51,6 +73,16 @@ namespace interpreter {
     }                                                                       \
   } while (false)
 
+#define POSSIBLY_HANDLE_PENDING_EXCEPTION_PREDICTED(_is_exception_pending, _offset,          \
+                                                    _next_opcode1, _next_opcode2)            \
+  do {                                                                                       \
+    if (UNLIKELY(_is_exception_pending)) {                                                   \
+      HANDLE_PENDING_EXCEPTION();                                                            \
+    } else {                                                                                 \
+      ADVANCE_PREDICTED(_offset, _next_opcode1, _next_opcode2);                              \
+    }                                                                                        \
+  } while (false)
+
 #define UPDATE_HANDLER_TABLE() \
   currentHandlersTable = handlersTable[Runtime::Current()->GetInstrumentation()->GetInterpreterHandlerTable()]
 
@@ -375,7 +407,8 @@ JValue ExecuteGotoImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem*
     if (val == 0) {
       shadow_frame.SetVRegReference(dst, NULL);
     }
-    ADVANCE(1);
+    // Typically stores an array element or its index.
+    ADVANCE_PREDICTED(1, APUT, APUT_OBJECT);
   }
   HANDLE_INSTRUCTION_END();
 
@@ -386,7 +419,8 @@ JValue ExecuteGotoImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem*
     if (val == 0) {
       shadow_frame.SetVRegReference(dst, NULL);
     }
-    ADVANCE(2);
+    // Typically stores an array element or its index.
+    ADVANCE_PREDICTED(2, APUT, APUT_OBJECT);
   }
   HANDLE_INSTRUCTION_END();
 
@@ -1225,7 +1259,7 @@ JValue ExecuteGotoImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem*
 
   HANDLE_INSTRUCTION_START(IGET_BOOLEAN) {
     bool success = DoFieldGet<InstancePrimitiveRead, Primitive::kPrimBoolean, do_access_check>(self, shadow_frame, inst, inst_data);
-    POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, 2);
+    POSSIBLY_HANDLE_PENDING_EXCEPTION_PREDICTED(!success, 2, IF_EQZ, IF_NEZ);
   }
   HANDLE_INSTRUCTION_END();
 
@@ -1249,7 +1283,7 @@ JValue ExecuteGotoImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem*
 
   HANDLE_INSTRUCTION_START(IGET) {
     bool success = DoFieldGet<InstancePrimitiveRead, Primitive::kPrimInt, do_access_check>(self, shadow_frame, inst, inst_data);
-    POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, 2);
+    POSSIBLY_HANDLE_PENDING_EXCEPTION_PREDICTED(!success, 2, IF_EQZ, IF_NEZ);
   }
   HANDLE_INSTRUCTION_END();
 
@@ -1261,13 +1295,13 @@ JValue ExecuteGotoImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem*
 
   HANDLE_INSTRUCTION_START(IGET_OBJECT) {
     bool success = DoFieldGet<InstanceObjectRead, Primitive::kPrimNot, do_access_check>(self, shadow_frame, inst, inst_data);
-    POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, 2);
+    POSSIBLY_HANDLE_PENDING_EXCEPTION_PREDICTED(!success, 2, IF_EQZ, IF_NEZ);
   }
   HANDLE_INSTRUCTION_END();
 
   HANDLE_INSTRUCTION_START(IGET_QUICK) {
     bool success = DoIGetQuick<Primitive::kPrimInt>(shadow_frame, inst, inst_data);
-    POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, 2);
+    POSSIBLY_HANDLE_PENDING_EXCEPTION_PREDICTED(!success, 2, IF_EQZ, IF_NEZ);
   }
   HANDLE_INSTRUCTION_END();
 
@@ -1279,7 +1313,7 @@ JValue ExecuteGotoImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem*
 
   HANDLE_INSTRUCTION_START(IGET_OBJECT_QUICK) {
     bool success = DoIGetQuick<Primitive::kPrimNot>(shadow_frame, inst, inst_data);
-    POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, 2);
+    POSSIBLY_HANDLE_PENDING_EXCEPTION_PREDICTED(!success, 2, IF_EQZ, IF_NEZ);
   }
   HANDLE_INSTRUCTION_END();
 
@@ -0,0 +1,245 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "interpreter.h"
+
+#include <vector>
+
+#include "class_linker.h"
+#include "common_runtime_test.h"
+#include "handle_scope-inl.h"
+#include "instrumentation.h"
+#include "interpreter_cache.h"
+#include "mirror/art_method-inl.h"
+#include "mirror/class-inl.h"
+#include "mirror/object_array-inl.h"
+#include "mirror/string.h"
+#include "scoped_thread_state_change.h"
+#include "stack.h"
+#include "thread_list.h"
+
+namespace art {
+namespace interpreter {
+
+class InterpreterTest : public CommonRuntimeTest {
+ protected:
+  mirror::ArtMethod* FindMethod(const char* class_descriptor, const char* name,
+                                const char* signature, bool is_static)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+    mirror::Class* klass = class_linker_->FindSystemClass(Thread::Current(), class_descriptor);
+    CHECK(klass != nullptr) << class_descriptor;
+    mirror::ArtMethod* method = is_static ? klass->FindDirectMethod(name, signature)
+                                          : klass->FindVirtualMethod(name, signature);
+    CHECK(method != nullptr) << name << signature;
+    return method;
+  }
+
+  // Runs the method in the interpreter, whatever code it has been compiled to. The arguments are
+  // laid out as for ArtMethod::Invoke.
+  static JValue Interpret(mirror::ArtMethod* method, mirror::Object* receiver,
+                          std::vector<uint32_t>* args)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+    JValue result;
+    EnterInterpreterFromInvoke(Thread::Current(), method, receiver, args->data(), &result);
+    CHECK(!Thread::Current()->IsExceptionPending()) << PrettyMethod(method);
+    return result;
+  }
+
+  static uint32_t Arg(mirror::Object* object) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+    return StackReference<mirror::Object>::FromMirrorPtr(object).AsVRegValue();
+  }
+};
+
+// Counts the instructions the interpreter executes.
+class InstructionCounter : public instrumentation::InstrumentationListener {
+ public:
+  InstructionCounter() : count_(0) {}
+
+  void MethodEntered(Thread*, mirror::Object*, mirror::ArtMethod*, uint32_t) OVERRIDE {}
+  void MethodExited(Thread*, mirror::Object*, mirror::ArtMethod*, uint32_t,
+                    const JValue&) OVERRIDE {}
+  void MethodUnwind(Thread*, mirror::Object*, mirror::ArtMethod*, uint32_t) OVERRIDE {}
+  void DexPcMoved(Thread*, mirror::Object*, mirror::ArtMethod*, uint32_t) OVERRIDE {
+    ++count_;
+  }
+  void FieldRead(Thread*, mirror::Object*, mirror::ArtMethod*, uint32_t,
+                 mirror::ArtField*) OVERRIDE {}
+  void FieldWritten(Thread*, mirror::Object*, mirror::ArtMethod*, uint32_t, mirror::ArtField*,
+                    const JValue&) OVERRIDE {}
+  void ExceptionCaught(Thread*, const ThrowLocation&, mirror::ArtMethod*, uint32_t,
+                       mirror::Throwable*) OVERRIDE {}
+
+  uint64_t GetCount() const {
+    return count_;
+  }
+
+ private:
+  uint64_t count_;
+};
+
+// A call site seeing receivers of several classes, and field accesses running from the cache,
+// compute what they do uncached.
+TEST_F(InterpreterTest, InlineCaches) {
+  ScopedObjectAccess soa(Thread::Current());
+  Thread* self = soa.Self();
+  StackHandleScope<5> hs(self);
+  Handle<mirror::Class> object_array_class(
+      hs.NewHandle(class_linker_->FindSystemClass(self, "[Ljava/lang/Object;")));
+  ASSERT_TRUE(object_array_class.Get() != nullptr);
+  // Strings and classes, which use Object.hashCode(), in runs so that the cache both hits and
+  // misses.
+  static const size_t kElements = 32;
+  Handle<mirror::ObjectArray<mirror::Object>> elements(
+      hs.NewHandle(mirror::ObjectArray<mirror::Object>::Alloc(self, object_array_class.Get(),
+                                                              kElements)));
+  ASSERT_TRUE(elements.Get() != nullptr);
+  for (size_t i = 0; i < kElements; ++i) {
+    mirror::Object* element;
+    if ((i / 4) % 2 == 0) {
+      element = mirror::String::AllocFromModifiedUtf8(self, PrettySize(i * KB).c_str());
+    } else {
+      element = (i % 3 == 0) ? object_array_class.Get() : object_array_class->GetSuperClass();
+    }
+    ASSERT_TRUE(element != nullptr);
+    elements->Set<false>(i, element);
+  }
+  elements->Set<false>(kElements - 1, nullptr);
+  int32_t expected = 1;
+  for (size_t i = 0; i < kElements; ++i) {
+    mirror::Object* element = elements->Get(i);
+    int32_t hash = 0;
+    if (element != nullptr) {
+      hash = element->GetClass()->IsStringClass() ? element->AsString()->GetHashCode()
+                                                  : element->IdentityHashCode();
+    }
+    expected = 31 * expected + hash;
+  }
+
+  mirror::ArtMethod* hash_code =
+      FindMethod("Ljava/util/Arrays;", "hashCode", "([Ljava/lang/Object;)I", true);
+  for (int run = 0; run < 2; ++run) {
+    std::vector<uint32_t> args(1, Arg(elements.Get()));
+    EXPECT_EQ(expected, Interpret(hash_code, nullptr, &args).GetI());
+  }
+
+  // String.hashCode() reads and writes the fields of the string.
+  mirror::ArtMethod* string_hash_code =
+      FindMethod("Ljava/lang/String;", "hashCode", "()I", false);
+  for (const char* text : { "interpreter", "inline", "cache" }) {
+    Handle<mirror::String> string(hs.NewHandle(mirror::String::AllocFromModifiedUtf8(self, text)));
+    ASSERT_TRUE(string.Get() != nullptr);
+    mirror::String* copy = mirror::String::AllocFromModifiedUtf8(self, text);
+    ASSERT_TRUE(copy != nullptr);
+    const int32_t expected_hash = copy->GetHashCode();
+    std::vector<uint32_t> args;
+    EXPECT_EQ(expected_hash, Interpret(string_hash_code, string.Get(), &args).GetI());
+    EXPECT_EQ(expected_hash, string->GetHashCode());
+  }
+  ASSERT_TRUE(self->GetInterpreterCache() != nullptr);
+}
+
+// The same instruction runs for the methods of every class loader sharing its dex file, so a field
+// resolved for one method is not reused for another.
+TEST_F(InterpreterTest, FieldEntriesAreKeyedByMethod) {
+  ScopedObjectAccess soa(Thread::Current());
+  mirror::ArtMethod* method = FindMethod("Ljava/lang/String;", "hashCode", "()I", false);
+  mirror::ArtMethod* other_method = FindMethod("Ljava/lang/String;", "length", "()I", false);
+  mirror::Class* string_class = method->GetDeclaringClass();
+  mirror::ArtField* field = string_class->FindInstanceField("count", "I");
+  ASSERT_TRUE(field != nullptr);
+
+  InterpreterCache cache;
+  const Instruction* inst = reinterpret_cast<const Instruction*>(method->GetCodeItem()->insns_);
+  cache.SetField(inst, method, field);
+  EXPECT_EQ(field, cache.GetField(inst, method));
+  EXPECT_EQ(nullptr, cache.GetField(inst, other_method));
+}
+
+// Interpreted instructions per second running a few library methods.
+TEST_F(InterpreterTest, DISABLED_Throughput) {
+  static const size_t kLength = 1024;
+  static const size_t kIterations = 2000;
+  Thread* self = Thread::Current();
+  jobject object_array;
+  jobject other_object_array;
+  jobject int_array;
+  {
+    ScopedObjectAccess soa(self);
+    mirror::Class* object_array_class =
+        class_linker_->FindSystemClass(self, "[Ljava/lang/Object;");
+    ASSERT_TRUE(object_array_class != nullptr);
+    StackHandleScope<2> hs(self);
+    Handle<mirror::ObjectArray<mirror::Object>> array(
+        hs.NewHandle(mirror::ObjectArray<mirror::Object>::Alloc(self, object_array_class,
+                                                                kLength)));
+    Handle<mirror::ObjectArray<mirror::Object>> other_array(
+        hs.NewHandle(mirror::ObjectArray<mirror::Object>::Alloc(self, object_array_class,
+                                                                kLength)));
+    ASSERT_TRUE(array.Get() != nullptr && other_array.Get() != nullptr);
+    for (size_t i = 0; i < kLength; ++i) {
+      mirror::Object* string = mirror::String::AllocFromModifiedUtf8(self, "element");
+      ASSERT_TRUE(string != nullptr);
+      array->Set<false>(i, string);
+      other_array->Set<false>(i, string);
+    }
+    object_array = soa.AddLocalReference<jobject>(array.Get());
+    other_object_array = soa.AddLocalReference<jobject>(other_array.Get());
+    int_array = soa.AddLocalReference<jobject>(mirror::IntArray::Alloc(self, kLength));
+  }
+
+  // Runs each of the methods once.
+  auto run_methods = [&]() {
+    ScopedObjectAccess soa(self);
+    mirror::Object* objects = soa.Decode<mirror::Object*>(object_array);
+    mirror::Object* other_objects = soa.Decode<mirror::Object*>(other_object_array);
+    mirror::Object* ints = soa.Decode<mirror::Object*>(int_array);
+    std::vector<uint32_t> args(1, Arg(objects));
+    Interpret(FindMethod("Ljava/util/Arrays;", "hashCode", "([Ljava/lang/Object;)I", true),
+              nullptr, &args);
+    args.push_back(Arg(other_objects));
+    CHECK(Interpret(FindMethod("Ljava/util/Arrays;", "equals",
+                               "([Ljava/lang/Object;[Ljava/lang/Object;)Z", true),
+                    nullptr, &args).GetZ());
+    args.assign(1, Arg(ints));
+    args.push_back(42);
+    Interpret(FindMethod("Ljava/util/Arrays;", "fill", "([II)V", true), nullptr, &args);
+    args.pop_back();
+    Interpret(FindMethod("Ljava/util/Arrays;", "hashCode", "([I)I", true), nullptr, &args);
+  };
+
+  InstructionCounter counter;
+  ThreadList* thread_list = Runtime::Current()->GetThreadList();
+  instrumentation::Instrumentation* instrumentation = Runtime::Current()->GetInstrumentation();
+  thread_list->SuspendAll();
+  instrumentation->AddListener(&counter, instrumentation::Instrumentation::kDexPcMoved);
+  thread_list->ResumeAll();
+  run_methods();
+  thread_list->SuspendAll();
+  instrumentation->RemoveListener(&counter, instrumentation::Instrumentation::kDexPcMoved);
+  thread_list->ResumeAll();
+
+  const uint64_t start = NanoTime();
+  for (size_t i = 0; i < kIterations; ++i) {
+    run_methods();
+  }
+  const uint64_t duration = NanoTime() - start;
+  LOG(INFO) << counter.GetCount() * kIterations << " instructions in " << PrettyDuration(duration)
+            << ": " << counter.GetCount() * kIterations * 1000000000 / duration
+            << " instructions/s";
+}
+
+}  // namespace interpreter
+}  // namespace art
@@ -153,6 +153,7 @@ static void DexFile_closeDexFile(JNIEnv* env, jclass, jlong cookie) {
     return;
   }
   ScopedObjectAccess soa(env);
+  Runtime::Current()->GetClassLinker()->ForgetClassPathIndex(dex_files.get());
 
   size_t index = 0;
   for (const DexFile* dex_file : *dex_files) {
@@ -219,7 +219,8 @@ static void VMDebug_dumpHprofData(JNIEnv* env, jclass, jstring javaFilename, job
     }
   }
 
-  hprof::DumpHeap(filename.c_str(), fd, false);
+  // Dumps to a ".gz" file are compressed on the fly.
+  hprof::DumpHeap(filename.c_str(), fd, false, EndsWith(filename, ".gz"));
 }
 
 static void VMDebug_dumpHprofDataDdms(JNIEnv*, jclass) {
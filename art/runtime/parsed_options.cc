@@ -22,6 +22,8 @@
 
 #include "base/stringpiece.h"
 #include "debugger.h"
+#include "gc/allocator/rosalloc.h"
+#include "gc/collector/semi_space.h"
 #include "gc/heap.h"
 #include "monitor.h"
 #include "runtime.h"
@@ -190,6 +192,7 @@ bool ParsedOptions::Parse(const RuntimeOptions& options, bool ignore_unrecognize
   parallel_gc_threads_ = sysconf(_SC_NPROCESSORS_CONF) - 1;
   // Only the main GC thread, no workers.
   conc_gc_threads_ = 0;
+  tenuring_threshold_ = gc::collector::SemiSpace::kDefaultTenuringThreshold;
   // The default GC type is set in makefiles.
 #if ART_DEFAULT_GC_TYPE_IS_CMS
   collector_type_ = gc::kCollectorTypeCMS;
@@ -215,6 +218,8 @@ bool ParsedOptions::Parse(const RuntimeOptions& options, bool ignore_unrecognize
   stack_size_ = 0;  // 0 means default.
   max_spins_before_thin_lock_inflation_ = Monitor::kDefaultMaxSpinsBeforeThinLockInflation;
   low_memory_mode_ = false;
+  rosalloc_thread_local_run_threshold_ =
+      gc::allocator::RosAlloc::kDefaultThreadLocalRunSizeThreshold;
   use_tlab_ = false;
   min_interval_homogeneous_space_compaction_by_oom_ = MsToNs(100 * 1000);  // 100s.
   verify_pre_gc_heap_ = false;
@@ -268,10 +273,12 @@ bool ParsedOptions::Parse(const RuntimeOptions& options, bool ignore_unrecognize
   method_trace_ = false;
   method_trace_file_ = "/data/method-trace-file.bin";
   method_trace_file_size_ = 10 * MB;
+  method_trace_stream_ = false;
 
   profile_clock_source_ = kDefaultTraceClockSource;
 
   verify_ = true;
+  background_verification_threads_ = 0;
   image_isa_ = kRuntimeISA;
 
   for (size_t i = 0; i < options.size(); ++i) {
@@ -378,6 +385,16 @@ bool ParsedOptions::Parse(const RuntimeOptions& options, bool ignore_unrecognize
       if (!ParseUnsignedInteger(option, '=', &conc_gc_threads_)) {
         return false;
       }
+    } else if (StartsWith(option, "-XX:MaxTenuringThreshold=")) {
+      if (!ParseUnsignedInteger(option, '=', &tenuring_threshold_)) {
+        return false;
+      }
+      if (tenuring_threshold_ == 0 ||
+          tenuring_threshold_ > gc::collector::SemiSpace::kMaxTenuringThreshold) {
+        Usage("-XX:MaxTenuringThreshold must be between 1 and %zu\n",
+              gc::collector::SemiSpace::kMaxTenuringThreshold);
+        return false;
+      }
     } else if (StartsWith(option, "-Xss")) {
       size_t size = ParseMemoryOption(option.substr(strlen("-Xss")).c_str(), 1);
       if (size == 0) {
@@ -408,6 +425,10 @@ bool ParsedOptions::Parse(const RuntimeOptions& options, bool ignore_unrecognize
     } else if (option == "-XX:LowMemoryMode") {
       low_memory_mode_ = true;
       // TODO Might want to turn off must_relocate here.
+    } else if (StartsWith(option, "-XX:RosAllocThreadLocalRunThreshold=")) {
+      if (!ParseUnsignedInteger(option, '=', &rosalloc_thread_local_run_threshold_)) {
+        return false;
+      }
     } else if (option == "-XX:UseTLAB") {
       use_tlab_ = true;
     } else if (option == "-XX:EnableHSpaceCompactForOOM") {
@@ -550,6 +571,8 @@ bool ParsedOptions::Parse(const RuntimeOptions& options, bool ignore_unrecognize
       if (!ParseUnsignedInteger(option, ':', &method_trace_file_size_)) {
         return false;
       }
+    } else if (option == "-Xmethod-trace-stream") {
+      method_trace_stream_ = true;
     } else if (option == "-Xprofile:threadcpuclock") {
       Trace::SetDefaultClockSource(kTraceClockSourceThreadCpu);
     } else if (option == "-Xprofile:wallclock") {
@@ -596,6 +619,10 @@ bool ParsedOptions::Parse(const RuntimeOptions& options, bool ignore_unrecognize
       if (!ParseUnsignedInteger(option, ':', &profiler_options_.max_stack_depth_)) {
         return false;
       }
+    } else if (StartsWith(option, "-Xbackground-verification-threads:")) {
+      if (!ParseUnsignedInteger(option, ':', &background_verification_threads_)) {
+        return false;
+      }
     } else if (StartsWith(option, "-Xcompiler:")) {
       if (!ParseStringAfterChar(option, ':', &compiler_executable_)) {
         return false;
@@ -783,16 +810,19 @@ void ParsedOptions::Usage(const char* fmt, ...) {
   UsageMessage(stream, "  -Ximage:filename\n");
   UsageMessage(stream, "  -XX:ParallelGCThreads=integervalue\n");
   UsageMessage(stream, "  -XX:ConcGCThreads=integervalue\n");
+  UsageMessage(stream, "  -XX:MaxTenuringThreshold=integervalue\n");
   UsageMessage(stream, "  -XX:MaxSpinsBeforeThinLockInflation=integervalue\n");
   UsageMessage(stream, "  -XX:LongPauseLogThreshold=integervalue\n");
   UsageMessage(stream, "  -XX:LongGCLogThreshold=integervalue\n");
   UsageMessage(stream, "  -XX:DumpGCPerformanceOnShutdown\n");
   UsageMessage(stream, "  -XX:IgnoreMaxFootprint\n");
   UsageMessage(stream, "  -XX:UseTLAB\n");
+  UsageMessage(stream, "  -XX:RosAllocThreadLocalRunThreshold=integervalue\n");
   UsageMessage(stream, "  -XX:BackgroundGC=none\n");
   UsageMessage(stream, "  -Xmethod-trace\n");
   UsageMessage(stream, "  -Xmethod-trace-file:filename");
   UsageMessage(stream, "  -Xmethod-trace-file-size:integervalue\n");
+  UsageMessage(stream, "  -Xmethod-trace-stream\n");
   UsageMessage(stream, "  -Xenable-profiler\n");
   UsageMessage(stream, "  -Xprofile-filename:filename\n");
   UsageMessage(stream, "  -Xprofile-period:integervalue\n");
@@ -804,6 +834,7 @@ void ParsedOptions::Usage(const char* fmt, ...) {
   UsageMessage(stream, "  -Xprofile-top-k-change-threshold:doublevalue\n");
   UsageMessage(stream, "  -Xprofile-type:{method,stack}\n");
   UsageMessage(stream, "  -Xprofile-max-stack-depth:integervalue\n");
+  UsageMessage(stream, "  -Xbackground-verification-threads:integervalue\n");
   UsageMessage(stream, "  -Xcompiler:filename\n");
   UsageMessage(stream, "  -Xcompiler-option dex2oat-option\n");
   UsageMessage(stream, "  -Ximage-compiler-option dex2oat-option\n");
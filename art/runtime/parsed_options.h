@@ -75,16 +75,19 @@ class ParsedOptions {
   double foreground_heap_growth_multiplier_;
   unsigned int parallel_gc_threads_;
   unsigned int conc_gc_threads_;
+  unsigned int tenuring_threshold_;
   gc::CollectorType collector_type_;
   gc::CollectorType background_collector_type_;
   size_t stack_size_;
   unsigned int max_spins_before_thin_lock_inflation_;
   bool low_memory_mode_;
+  unsigned int rosalloc_thread_local_run_threshold_;
   unsigned int lock_profiling_threshold_;
   std::string stack_trace_file_;
   bool method_trace_;
   std::string method_trace_file_;
   unsigned int method_trace_file_size_;
+  bool method_trace_stream_;
   bool (*hook_is_sensitive_thread_)();
   jint (*hook_vfprintf_)(FILE* stream, const char* format, va_list ap);
   void (*hook_exit_)(jint status);
@@ -97,6 +100,7 @@ class ParsedOptions {
   std::string profile_output_filename_;
   TraceClockSource profile_clock_source_;
   bool verify_;
+  unsigned int background_verification_threads_;
   InstructionSet image_isa_;
 
   // Whether or not we use homogeneous space compaction to avoid OOM errors. If enabled,
@@ -16,9 +16,11 @@
 
 #include "profiler.h"
 
-#include <fstream>
 #include <sys/uio.h>
 #include <sys/file.h>
+#include <sys/stat.h>
+
+#include <algorithm>
 
 #include "base/stl_util.h"
 #include "base/unix_file/fd_file.h"
@@ -59,8 +61,7 @@ volatile bool BackgroundMethodSamplingProfiler::shutting_down_ = false;
 // Walk through the method within depth of max_depth_ on the Java stack
 class BoundedStackVisitor : public StackVisitor {
  public:
-  BoundedStackVisitor(std::vector<std::pair<mirror::ArtMethod*, uint32_t>>* stack,
-      Thread* thread, uint32_t max_depth)
+  BoundedStackVisitor(InstructionLocation* stack, Thread* thread, uint32_t max_depth)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_)
       : StackVisitor(thread, NULL), stack_(stack), max_depth_(max_depth), depth_(0) {
   }
@@ -70,18 +71,17 @@ class BoundedStackVisitor : public StackVisitor {
     if (m->IsRuntimeMethod()) {
       return true;
     }
-    uint32_t dex_pc_ = GetDexPc();
-    stack_->push_back(std::make_pair(m, dex_pc_));
+    stack_[depth_] = std::make_pair(m, GetDexPc());
     ++depth_;
-    if (depth_ < max_depth_) {
-      return true;
-    } else {
-      return false;
-    }
+    return depth_ < max_depth_;
+  }
+
+  uint32_t GetDepth() const {
+    return depth_;
   }
 
  private:
-  std::vector<std::pair<mirror::ArtMethod*, uint32_t>>* stack_;
+  InstructionLocation* const stack_;
   const uint32_t max_depth_;
   uint32_t depth_;
 };
@@ -94,23 +94,11 @@ static void GetSample(Thread* thread, void* arg) SHARED_LOCKS_REQUIRED(Locks::mu
   const ProfilerOptions profile_options = profiler->GetProfilerOptions();
   switch (profile_options.GetProfileType()) {
     case kProfilerMethod: {
-      mirror::ArtMethod* method = thread->GetCurrentMethod(nullptr);
-      if (false && method == nullptr) {
-        LOG(INFO) << "No current method available";
-        std::ostringstream os;
-        thread->Dump(os);
-        std::string data(os.str());
-        LOG(INFO) << data;
-      }
-      profiler->RecordMethod(method);
+      profiler->RecordMethod(thread, thread->GetCurrentMethod(nullptr));
       break;
     }
     case kProfilerBoundedStack: {
-      std::vector<InstructionLocation> stack;
-      uint32_t max_depth = profile_options.GetMaxStackDepth();
-      BoundedStackVisitor bounded_stack_visitor(&stack, thread, max_depth);
-      bounded_stack_visitor.WalkStack();
-      profiler->RecordStack(stack);
+      profiler->RecordStack(thread);
       break;
     }
     default:
@@ -211,6 +199,8 @@ void* BackgroundMethodSamplingProfiler::RunProfilerThread(void* arg) {
 
     SampleCheckpoint check_point(profiler);
 
+    const uint32_t rounds_per_collection = profiler->RoundsPerCollection();
+    uint32_t rounds_since_collection = 0;
     size_t valid_samples = 0;
     while (now_us < end_us) {
       if (ShuttingDown(self)) {
@@ -250,6 +240,13 @@ void* BackgroundMethodSamplingProfiler::RunProfilerThread(void* arg) {
       // code.  Crash the process in this case.
       CHECK_LT(waitdiff_us, kWaitTimeoutUs);
 
+      // Empty the sample buffers before they can fill up.
+      if (++rounds_since_collection == rounds_per_collection) {
+        ScopedObjectAccess soa(self);
+        profiler->CollectSamples(self);
+        rounds_since_collection = 0;
+      }
+
       // Update the current time.
       now_us = MicroTime();
     }
@@ -257,6 +254,7 @@ void* BackgroundMethodSamplingProfiler::RunProfilerThread(void* arg) {
     if (valid_samples > 0) {
       // After the profile has been taken, write it out.
       ScopedObjectAccess soa(self);   // Acquire the mutator lock.
+      profiler->CollectSamples(self);
       uint32_t size = profiler->WriteProfile();
       VLOG(profiler) << "Profile size: " << size;
     }
@@ -294,17 +292,21 @@ uint32_t BackgroundMethodSamplingProfiler::WriteProfile() {
   lseek(fd, 0, SEEK_SET);
 
   // Format the profile output and write to the file.
-  std::ostringstream os;
-  uint32_t num_methods = DumpProfile(os);
-  std::string data(os.str());
-  const char *p = data.c_str();
-  size_t length = data.length();
+  std::vector<uint8_t> data;
+  uint32_t num_methods = DumpProfile(&data);
+  const uint8_t* p = data.data();
+  size_t length = data.size();
   size_t full_length = length;
-  do {
-    int n = ::write(fd, p, length);
+  while (length > 0) {
+    ssize_t n = TEMP_FAILURE_RETRY(::write(fd, p, length));
+    if (n <= 0) {
+      PLOG(ERROR) << "Failed to write profile file " << full_name;
+      full_length -= length;
+      break;
+    }
     p += n;
     length -= n;
-  } while (length > 0);
+  }
 
   // Truncate the file to the new length.
   ftruncate(fd, full_length);
@@ -356,6 +358,12 @@ bool BackgroundMethodSamplingProfiler::Start(
 
 
 
+static void DeleteSampleBufferCallback(Thread* thread, void* arg) {
+  UNUSED(arg);
+  delete thread->GetProfilerSampleBuffer();
+  thread->SetProfilerSampleBuffer(nullptr);
+}
+
 void BackgroundMethodSamplingProfiler::Stop() {
   BackgroundMethodSamplingProfiler* profiler = nullptr;
   pthread_t profiler_pthread = 0U;
@@ -375,6 +383,12 @@ void BackgroundMethodSamplingProfiler::Stop() {
   // Wait for the sample thread to stop.
   CHECK_PTHREAD_CALL(pthread_join, (profiler_pthread, nullptr), "profiler thread shutdown");
 
+  // Nothing samples the threads anymore, free their sample buffers.
+  {
+    MutexLock mu(Thread::Current(), *Locks::thread_list_lock_);
+    Runtime::Current()->GetThreadList()->ForEach(DeleteSampleBufferCallback, nullptr);
+  }
+
   {
     MutexLock mu(Thread::Current(), *Locks::profiler_lock_);
     profiler_ = nullptr;
@@ -393,7 +407,6 @@ BackgroundMethodSamplingProfiler::BackgroundMethodSamplingProfiler(
       options_(options),
       wait_lock_("Profile wait lock"),
       period_condition_("Profile condition", wait_lock_),
-      profile_table_(wait_lock_),
       profiler_barrier_(new Barrier(0)) {
   // Populate the filtered_methods set.
   // This is empty right now, but to add a method, do this:
@@ -436,47 +449,113 @@ bool BackgroundMethodSamplingProfiler::ProcessMethod(mirror::ArtMethod* method)
   return !is_filtered;
 }
 
-// A method has been hit, record its invocation in the method map.
-// The mutator_lock must be held (shared) when this is called.
-void BackgroundMethodSamplingProfiler::RecordMethod(mirror::ArtMethod* method) {
-  // Add to the profile table unless it is filtered out.
-  if (ProcessMethod(method)) {
-    profile_table_.Put(method);
+static ProfilerSampleBuffer* GetSampleBuffer(Thread* thread) {
+  ProfilerSampleBuffer* buffer = thread->GetProfilerSampleBuffer();
+  if (UNLIKELY(buffer == nullptr)) {
+    buffer = new ProfilerSampleBuffer();
+    thread->SetProfilerSampleBuffer(buffer);
   }
+  return buffer;
+}
+
+// A method has been hit, record it in the thread's sample buffer. It is filtered and added to
+// the method map when the samples are collected.
+void BackgroundMethodSamplingProfiler::RecordMethod(Thread* thread, mirror::ArtMethod* method) {
+  ProfilerSampleBuffer* buffer = GetSampleBuffer(thread);
+  DCHECK_LT(buffer->size, ProfilerSampleBuffer::kCapacity);
+  buffer->entries[buffer->size++] = std::make_pair(method, 0U);
 }
 
-// Record the current bounded stack into sampling results.
-void BackgroundMethodSamplingProfiler::RecordStack(const std::vector<InstructionLocation>& stack) {
-  if (stack.size() == 0) {
+// Record the current bounded stack of the thread in its sample buffer.
+void BackgroundMethodSamplingProfiler::RecordStack(Thread* thread) {
+  ProfilerSampleBuffer* buffer = GetSampleBuffer(thread);
+  // RoundsPerCollection() leaves room for a header and the frames of a full stack.
+  const size_t capacity = ProfilerSampleBuffer::kCapacity;
+  const uint32_t max_depth = std::min<size_t>(options_.GetMaxStackDepth(), capacity - 1);
+  DCHECK_LE(buffer->size + max_depth + 1, capacity);
+  InstructionLocation* header = &buffer->entries[buffer->size];
+  BoundedStackVisitor bounded_stack_visitor(header + 1, thread, max_depth);
+  bounded_stack_visitor.WalkStack();
+  const uint32_t depth = bounded_stack_visitor.GetDepth();
+  if (depth == 0) {
     return;
   }
-  // Get the method on top of the stack. We use this method to perform filtering.
-  mirror::ArtMethod* method = stack.front().first;
-  if (ProcessMethod(method)) {
-      profile_table_.PutStack(stack);
+  *header = std::make_pair(nullptr, depth);
+  buffer->size += depth + 1;
+}
+
+uint32_t BackgroundMethodSamplingProfiler::RoundsPerCollection() const {
+  // Every round adds at most one sample per thread.
+  const size_t capacity = ProfilerSampleBuffer::kCapacity;
+  if (options_.GetProfileType() == kProfilerBoundedStack) {
+    const size_t max_depth = std::min<size_t>(options_.GetMaxStackDepth(), capacity - 1);
+    return capacity / (max_depth + 1);
+  }
+  return capacity;
+}
+
+static void TakeSamplesCallback(Thread* thread, void* arg) {
+  ProfilerSampleBuffer* buffer = thread->GetProfilerSampleBuffer();
+  if (buffer != nullptr) {
+    std::vector<InstructionLocation>* samples =
+        reinterpret_cast<std::vector<InstructionLocation>*>(arg);
+    samples->insert(samples->end(), buffer->entries, buffer->entries + buffer->size);
+    buffer->size = 0;
   }
 }
 
+void BackgroundMethodSamplingProfiler::CollectSamples(Thread* self) {
+  {
+    // Only hold the thread list lock to copy the samples out. Samples of threads which exit before
+    // they are collected are lost.
+    MutexLock mu(self, *Locks::thread_list_lock_);
+    Runtime::Current()->GetThreadList()->ForEach(TakeSamplesCallback, &collected_samples_);
+  }
+  const bool stacks = options_.GetProfileType() == kProfilerBoundedStack;
+  size_t i = 0;
+  while (i < collected_samples_.size()) {
+    if (stacks) {
+      // Filter on the method on top of the stack.
+      const uint32_t depth = collected_samples_[i].second;
+      const InstructionLocation* stack = &collected_samples_[i + 1];
+      if (ProcessMethod(stack[0].first)) {
+        profile_table_.PutStack(stack, depth);
+      }
+      i += depth + 1;
+    } else {
+      // Add to the profile table unless it is filtered out.
+      mirror::ArtMethod* method = collected_samples_[i].first;
+      if (ProcessMethod(method)) {
+        profile_table_.Put(method);
+      }
+      ++i;
+    }
+  }
+  collected_samples_.clear();
+}
+
 // Clean out any recordings for the method traces.
 void BackgroundMethodSamplingProfiler::CleanProfile() {
   profile_table_.Clear();
 }
 
-uint32_t BackgroundMethodSamplingProfiler::DumpProfile(std::ostream& os) {
-  return profile_table_.Write(os, options_.GetProfileType());
+uint32_t BackgroundMethodSamplingProfiler::DumpProfile(std::vector<uint8_t>* out) {
+  return profile_table_.Write(out, options_.GetProfileType());
 }
 
+const uint8_t ProfileFile::kProfileMagic[] = { 'p', 'r', 'o', 'f' };
+const uint8_t ProfileFile::kProfileVersion[] = { '0', '0', '1', '\0' };
+
 // Profile Table.
 // This holds a mapping of mirror::ArtMethod* to a count of how many times a sample
 // hit it at the top of the stack.
-ProfileSampleResults::ProfileSampleResults(Mutex& lock) : lock_(lock), num_samples_(0),
+ProfileSampleResults::ProfileSampleResults() : num_samples_(0),
     num_null_methods_(0),
-    num_boot_methods_(0) {
-  for (int i = 0; i < kHashSize; i++) {
-    table[i] = nullptr;
-  }
-  method_context_table = nullptr;
-  stack_trie_root_ = nullptr;
+    num_boot_methods_(0),
+    stack_trie_root_(nullptr),
+    previous_num_samples_(0),
+    previous_num_null_methods_(0),
+    previous_num_boot_methods_(0) {
 }
 
 ProfileSampleResults::~ProfileSampleResults() {
@@ -486,25 +565,18 @@ ProfileSampleResults::~ProfileSampleResults() {
 // Add a method to the profile table.  If it's the first time the method
 // has been seen, add it with count=1, otherwise increment the count.
 void ProfileSampleResults::Put(mirror::ArtMethod* method) {
-  MutexLock mu(Thread::Current(), lock_);
-  uint32_t index = Hash(method);
-  if (table[index] == nullptr) {
-    table[index] = new Map();
-  }
-  Map::iterator i = table[index]->find(method);
-  if (i == table[index]->end()) {
-    (*table[index])[method] = 1;
+  MethodCountMap::Iterator it = method_counts_.Find(method);
+  if (it == method_counts_.end()) {
+    method_counts_.Insert(std::make_pair(method, 1U));
   } else {
-    i->second++;
+    it->second++;
   }
   num_samples_++;
 }
 
 // Add a bounded stack to the profile table. Only the count of the method on
 // top of the frame will be increased.
-void ProfileSampleResults::PutStack(const std::vector<InstructionLocation>& stack) {
-  MutexLock mu(Thread::Current(), lock_);
-  ScopedObjectAccess soa(Thread::Current());
+void ProfileSampleResults::PutStack(const InstructionLocation* stack, size_t depth) {
   if (stack_trie_root_ == nullptr) {
     // The root of the stack trie is a dummy node so that we don't have to maintain
     // a collection of tries.
@@ -512,14 +584,13 @@ void ProfileSampleResults::PutStack(const std::vector<InstructionLocation>& stac
   }
 
   StackTrieNode* current = stack_trie_root_;
-  if (stack.size() == 0) {
+  if (depth == 0) {
     current->IncreaseCount();
     return;
   }
 
-  for (std::vector<InstructionLocation>::const_reverse_iterator iter = stack.rbegin();
-       iter != stack.rend(); ++iter) {
-    InstructionLocation inst_loc = *iter;
+  for (size_t i = depth; i != 0; --i) {
+    InstructionLocation inst_loc = stack[i - 1];
     mirror::ArtMethod* method = inst_loc.first;
     if (method == nullptr) {
       // skip null method
@@ -546,143 +617,140 @@ void ProfileSampleResults::PutStack(const std::vector<InstructionLocation>& stac
 
   if (current != stack_trie_root_ && current->GetCount() == 0) {
     // Insert into method_context table;
-    if (method_context_table == nullptr) {
-      method_context_table = new MethodContextMap();
-    }
     MethodReference method = current->GetMethod();
-    MethodContextMap::iterator i = method_context_table->find(method);
-    if (i == method_context_table->end()) {
-      TrieNodeSet* node_set = new TrieNodeSet();
-      node_set->insert(current);
-      (*method_context_table)[method] = node_set;
-    } else {
-      TrieNodeSet* node_set = i->second;
-      node_set->insert(current);
+    TrieNodes*& nodes = method_context_table_[method];
+    if (nodes == nullptr) {
+      nodes = new TrieNodes();
     }
+    nodes->push_back(current);
   }
   current->IncreaseCount();
   num_samples_++;
 }
 
-// Write the profile table to the output stream.  Also merge with the previous profile.
-uint32_t ProfileSampleResults::Write(std::ostream& os, ProfileDataType type) {
-  ScopedObjectAccess soa(Thread::Current());
+static void AppendU4(std::vector<uint8_t>* out, uint32_t value) {
+  const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+  out->insert(out->end(), bytes, bytes + sizeof(value));
+}
+
+static void AppendString(std::vector<uint8_t>* out, const std::string& value) {
+  AppendU4(out, value.size());
+  out->insert(out->end(), value.begin(), value.end());
+}
+
+void ProfileSampleResults::WriteMethod(std::vector<uint8_t>* out, const std::string& method_name,
+                                       uint32_t count, uint32_t method_size,
+                                       const PreviousContextMap* context_map) {
+  AppendString(out, method_name);
+  AppendU4(out, count);
+  AppendU4(out, method_size);
+  AppendU4(out, context_map != nullptr ? context_map->size() : 0);
+  if (context_map != nullptr) {
+    for (const auto& context_i : *context_map) {
+      AppendU4(out, context_i.first.first);
+      AppendU4(out, context_i.second);
+      AppendString(out, context_i.first.second);
+    }
+  }
+}
+
+// Write the profile table to the output.  Also merge with the previous profile.
+uint32_t ProfileSampleResults::Write(std::vector<uint8_t>* out, ProfileDataType type) {
   num_samples_ += previous_num_samples_;
   num_null_methods_ += previous_num_null_methods_;
   num_boot_methods_ += previous_num_boot_methods_;
 
   VLOG(profiler) << "Profile: "
                  << num_samples_ << "/" << num_null_methods_ << "/" << num_boot_methods_;
-  os << num_samples_ << "/" << num_null_methods_ << "/" << num_boot_methods_ << "\n";
+  out->insert(out->end(), ProfileFile::kProfileMagic,
+              ProfileFile::kProfileMagic + sizeof(ProfileFile::kProfileMagic));
+  out->insert(out->end(), ProfileFile::kProfileVersion,
+              ProfileFile::kProfileVersion + sizeof(ProfileFile::kProfileVersion));
+  AppendU4(out, type);
+  AppendU4(out, num_samples_);
+  AppendU4(out, num_null_methods_);
+  AppendU4(out, num_boot_methods_);
+  // The number of methods is filled in at the end.
+  const size_t num_methods_offset = out->size();
+  AppendU4(out, 0);
+
   uint32_t num_methods = 0;
   if (type == kProfilerMethod) {
-    for (int i = 0 ; i < kHashSize; i++) {
-      Map *map = table[i];
-      if (map != nullptr) {
-        for (const auto &meth_iter : *map) {
-          mirror::ArtMethod *method = meth_iter.first;
-          std::string method_name = PrettyMethod(method);
-
-          const DexFile::CodeItem* codeitem = method->GetCodeItem();
-          uint32_t method_size = 0;
-          if (codeitem != nullptr) {
-            method_size = codeitem->insns_size_in_code_units_;
-          }
-          uint32_t count = meth_iter.second;
-
-          // Merge this profile entry with one from a previous run (if present).  Also
-          // remove the previous entry.
-          PreviousProfile::iterator pi = previous_.find(method_name);
-          if (pi != previous_.end()) {
-            count += pi->second.count_;
-            previous_.erase(pi);
-          }
-          os << StringPrintf("%s/%u/%u\n",  method_name.c_str(), count, method_size);
-          ++num_methods;
-        }
+    for (const auto& meth_iter : method_counts_) {
+      mirror::ArtMethod *method = meth_iter.first;
+      std::string method_name = PrettyMethod(method);
+
+      const DexFile::CodeItem* codeitem = method->GetCodeItem();
+      uint32_t method_size = 0;
+      if (codeitem != nullptr) {
+        method_size = codeitem->insns_size_in_code_units_;
       }
+      uint32_t count = meth_iter.second;
+
+      // Merge this profile entry with one from a previous run (if present).  Also
+      // remove the previous entry.
+      PreviousProfile::iterator pi = previous_.find(method_name);
+      if (pi != previous_.end()) {
+        count += pi->second.count_;
+        delete pi->second.context_map_;
+        previous_.erase(pi);
+      }
+      WriteMethod(out, method_name, count, method_size, nullptr);
+      ++num_methods;
     }
   } else if (type == kProfilerBoundedStack) {
-    if (method_context_table != nullptr) {
-      for (const auto &method_iter : *method_context_table) {
-        MethodReference method = method_iter.first;
-        TrieNodeSet* node_set = method_iter.second;
-        std::string method_name = PrettyMethod(method.dex_method_index, *(method.dex_file));
-        uint32_t method_size = 0;
-        uint32_t total_count = 0;
-        PreviousContextMap new_context_map;
-        for (const auto &trie_node_i : *node_set) {
-          StackTrieNode* node = trie_node_i;
-          method_size = node->GetMethodSize();
-          uint32_t count = node->GetCount();
-          uint32_t dexpc = node->GetDexPC();
-          total_count += count;
-
-          StackTrieNode* current = node->GetParent();
-          // We go backward on the trie to retrieve context and dex_pc until the dummy root.
-          // The format of the context is "method_1@pc_1@method_2@pc_2@..."
-          std::vector<std::string> context_vector;
-          while (current != nullptr && current->GetParent() != nullptr) {
-            context_vector.push_back(StringPrintf("%s@%u",
-                PrettyMethod(current->GetMethod().dex_method_index, *(current->GetMethod().dex_file)).c_str(),
-                current->GetDexPC()));
-            current = current->GetParent();
-          }
-          std::string context_sig = Join(context_vector, '@');
-          new_context_map[std::make_pair(dexpc, context_sig)] = count;
+    for (const auto& method_iter : method_context_table_) {
+      MethodReference method = method_iter.first;
+      TrieNodes* nodes = method_iter.second;
+      std::string method_name = PrettyMethod(method.dex_method_index, *(method.dex_file));
+      uint32_t method_size = 0;
+      uint32_t total_count = 0;
+      PreviousContextMap new_context_map;
+      for (StackTrieNode* node : *nodes) {
+        method_size = node->GetMethodSize();
+        uint32_t count = node->GetCount();
+        uint32_t dexpc = node->GetDexPC();
+        total_count += count;
+
+        StackTrieNode* current = node->GetParent();
+        // We go backward on the trie to retrieve context and dex_pc until the dummy root.
+        // The format of the context is "method_1@pc_1@method_2@pc_2@..."
+        std::vector<std::string> context_vector;
+        while (current != nullptr && current->GetParent() != nullptr) {
+          MethodReference context_method = current->GetMethod();
+          context_vector.push_back(StringPrintf("%s@%u",
+              PrettyMethod(context_method.dex_method_index, *context_method.dex_file).c_str(),
+              current->GetDexPC()));
+          current = current->GetParent();
         }
+        std::string context_sig = Join(context_vector, '@');
+        new_context_map[std::make_pair(dexpc, context_sig)] = count;
+      }
 
-        PreviousProfile::iterator pi = previous_.find(method_name);
-        if (pi != previous_.end()) {
-          total_count += pi->second.count_;
-          PreviousContextMap* previous_context_map = pi->second.context_map_;
-          if (previous_context_map != nullptr) {
-            for (const auto &context_i : *previous_context_map) {
-              uint32_t count = context_i.second;
-              PreviousContextMap::iterator ci = new_context_map.find(context_i.first);
-              if (ci == new_context_map.end()) {
-                new_context_map[context_i.first] = count;
-              } else {
-                ci->second += count;
-              }
-            }
+      PreviousProfile::iterator pi = previous_.find(method_name);
+      if (pi != previous_.end()) {
+        total_count += pi->second.count_;
+        PreviousContextMap* previous_context_map = pi->second.context_map_;
+        if (previous_context_map != nullptr) {
+          for (const auto &context_i : *previous_context_map) {
+            new_context_map[context_i.first] += context_i.second;
           }
-          delete previous_context_map;
-          previous_.erase(pi);
-        }
-        // We write out profile data with dex pc and context information in the following format:
-        // "method/total_count/size/[pc_1:count_1:context_1#pc_2:count_2:context_2#...]".
-        std::vector<std::string> context_count_vector;
-        for (const auto &context_i : new_context_map) {
-          context_count_vector.push_back(StringPrintf("%u:%u:%s", context_i.first.first,
-              context_i.second, context_i.first.second.c_str()));
         }
-        os << StringPrintf("%s/%u/%u/[%s]\n", method_name.c_str(), total_count,
-            method_size, Join(context_count_vector, '#').c_str());
-        ++num_methods;
+        delete previous_context_map;
+        previous_.erase(pi);
       }
+      WriteMethod(out, method_name, total_count, method_size, &new_context_map);
+      ++num_methods;
     }
   }
 
   // Now we write out the remaining previous methods.
   for (const auto &pi : previous_) {
-    if (type == kProfilerMethod) {
-      os << StringPrintf("%s/%u/%u\n",  pi.first.c_str(), pi.second.count_, pi.second.method_size_);
-    } else if (type == kProfilerBoundedStack) {
-      os << StringPrintf("%s/%u/%u/[",  pi.first.c_str(), pi.second.count_, pi.second.method_size_);
-      PreviousContextMap* previous_context_map = pi.second.context_map_;
-      if (previous_context_map != nullptr) {
-        std::vector<std::string> context_count_vector;
-        for (const auto &context_i : *previous_context_map) {
-          context_count_vector.push_back(StringPrintf("%u:%u:%s", context_i.first.first,
-              context_i.second, context_i.first.second.c_str()));
-        }
-        os << Join(context_count_vector, '#');
-      }
-      os << "]\n";
-    }
+    WriteMethod(out, pi.first, pi.second.count_, pi.second.method_size_,
+                type == kProfilerBoundedStack ? pi.second.context_map_ : nullptr);
     ++num_methods;
   }
+  memcpy(&(*out)[num_methods_offset], &num_methods, sizeof(num_methods));
   return num_methods;
 }
 
@@ -690,108 +758,229 @@ void ProfileSampleResults::Clear() {
   num_samples_ = 0;
   num_null_methods_ = 0;
   num_boot_methods_ = 0;
-  for (int i = 0; i < kHashSize; i++) {
-    delete table[i];
-    table[i] = nullptr;
-  }
+  method_counts_.Clear();
   if (stack_trie_root_ != nullptr) {
     stack_trie_root_->DeleteChildren();
     delete stack_trie_root_;
     stack_trie_root_ = nullptr;
-    if (method_context_table != nullptr) {
-      delete method_context_table;
-      method_context_table = nullptr;
-    }
   }
+  for (const auto& method_iter : method_context_table_) {
+    delete method_iter.second;
+  }
+  method_context_table_.clear();
   for (auto &pi : previous_) {
-    if (pi.second.context_map_ != nullptr) {
-      delete pi.second.context_map_;
-      pi.second.context_map_ = nullptr;
-    }
+    delete pi.second.context_map_;
   }
   previous_.clear();
 }
 
-uint32_t ProfileSampleResults::Hash(mirror::ArtMethod* method) {
-  return (PointerToLowMemUInt32(method) >> 3) % kHashSize;
-}
+namespace {
 
-// Read a single line into the given string.  Returns true if everything OK, false
-// on EOF or error.
-static bool ReadProfileLine(int fd, std::string& line) {
-  char buf[4];
-  line.clear();
-  while (true) {
-    int n = read(fd, buf, 1);     // TODO: could speed this up but is it worth it?
-    if (n != 1) {
+// The summary and a method of a profile file.
+struct ProfileSummary {
+  ProfileSummary() : num_samples(0), num_null_methods(0), num_boot_methods(0) {}
+
+  uint32_t num_samples;
+  uint32_t num_null_methods;
+  uint32_t num_boot_methods;
+};
+
+struct ProfileMethod {
+  ProfileMethod() : count(0), method_size(0) {}
+
+  std::string method_name;
+  uint32_t count;
+  uint32_t method_size;
+  // Counts by <dex pc, context>, only read for bounded stack profiles.
+  std::vector<std::pair<std::pair<uint32_t, std::string>, uint32_t>> contexts;
+};
+
+// Reads the binary profile format, see ProfileFile.
+class ProfileReader {
+ public:
+  explicit ProfileReader(const std::string& data) : data_(data), pos_(0) {}
+
+  bool ReadU4(uint32_t* value) {
+    if (data_.size() - pos_ < sizeof(*value)) {
       return false;
     }
-    if (buf[0] == '\n') {
-      break;
+    memcpy(value, data_.data() + pos_, sizeof(*value));
+    pos_ += sizeof(*value);
+    return true;
+  }
+
+  bool ReadString(std::string* value) {
+    uint32_t length;
+    if (!ReadU4(&length) || data_.size() - pos_ < length) {
+      return false;
     }
-    line += buf[0];
+    value->assign(data_, pos_, length);
+    pos_ += length;
+    return true;
   }
-  return true;
-}
 
-void ProfileSampleResults::ReadPrevious(int fd, ProfileDataType type) {
-  // Reset counters.
-  previous_num_samples_ = previous_num_null_methods_ = previous_num_boot_methods_ = 0;
+  bool Skip(size_t length) {
+    if (data_.size() - pos_ < length) {
+      return false;
+    }
+    pos_ += length;
+    return true;
+  }
 
-  std::string line;
+ private:
+  const std::string& data_;
+  size_t pos_;
+};
 
-  // The first line contains summary information.
-  if (!ReadProfileLine(fd, line)) {
-    return;
+bool ParseBinaryProfile(const std::string& data, bool with_contexts, ProfileSummary* summary,
+                        std::vector<ProfileMethod>* methods) {
+  // The magic has already been checked.
+  if (data.size() < sizeof(ProfileFile::kProfileMagic) + sizeof(ProfileFile::kProfileVersion) ||
+      memcmp(data.data() + sizeof(ProfileFile::kProfileMagic), ProfileFile::kProfileVersion,
+             sizeof(ProfileFile::kProfileVersion)) != 0) {
+    LOG(WARNING) << "Unsupported profile version";
+    return false;
+  }
+  ProfileReader reader(data);
+  reader.Skip(sizeof(ProfileFile::kProfileMagic) + sizeof(ProfileFile::kProfileVersion));
+  uint32_t type;
+  uint32_t num_methods;
+  if (!reader.ReadU4(&type) ||
+      !reader.ReadU4(&summary->num_samples) ||
+      !reader.ReadU4(&summary->num_null_methods) ||
+      !reader.ReadU4(&summary->num_boot_methods) ||
+      !reader.ReadU4(&num_methods)) {
+    return false;
+  }
+  for (uint32_t i = 0; i < num_methods; ++i) {
+    ProfileMethod method;
+    uint32_t num_contexts;
+    if (!reader.ReadString(&method.method_name) ||
+        !reader.ReadU4(&method.count) ||
+        !reader.ReadU4(&method.method_size) ||
+        !reader.ReadU4(&num_contexts)) {
+      return false;
+    }
+    for (uint32_t j = 0; j < num_contexts; ++j) {
+      uint32_t dexpc;
+      uint32_t count;
+      std::string context;
+      if (!reader.ReadU4(&dexpc) || !reader.ReadU4(&count) || !reader.ReadString(&context)) {
+        return false;
+      }
+      if (with_contexts) {
+        method.contexts.push_back(std::make_pair(std::make_pair(dexpc, context), count));
+      }
+    }
+    methods->push_back(std::move(method));
   }
+  return true;
+}
+
+// Reads the text format written by older runtimes.
+bool ParseTextProfile(const std::string& data, bool with_contexts, ProfileSummary* summary,
+                      std::vector<ProfileMethod>* methods) {
+  std::vector<std::string> lines;
+  Split(data, '\n', lines);
+  if (lines.empty()) {
+    return false;
+  }
+  // The first line contains summary information.
   std::vector<std::string> summary_info;
-  Split(line, '/', summary_info);
+  Split(lines[0], '/', summary_info);
   if (summary_info.size() != 3) {
     // Bad summary info.  It should be count/nullcount/bootcount
-    return;
+    return false;
   }
-  previous_num_samples_ = strtoul(summary_info[0].c_str(), nullptr, 10);
-  previous_num_null_methods_ = strtoul(summary_info[1].c_str(), nullptr, 10);
-  previous_num_boot_methods_ = strtoul(summary_info[2].c_str(), nullptr, 10);
+  summary->num_samples = strtoul(summary_info[0].c_str(), nullptr, 10);
+  summary->num_null_methods = strtoul(summary_info[1].c_str(), nullptr, 10);
+  summary->num_boot_methods = strtoul(summary_info[2].c_str(), nullptr, 10);
 
-  // Now read each line until the end of file.  Each line consists of 3 or 4 fields separated by /
-  while (true) {
-    if (!ReadProfileLine(fd, line)) {
-      break;
-    }
+  // Each following line consists of 3 or 4 fields separated by /
+  for (size_t i = 1; i < lines.size(); ++i) {
     std::vector<std::string> info;
-    Split(line, '/', info);
+    Split(lines[i], '/', info);
     if (info.size() != 3 && info.size() != 4) {
       // Malformed.
-      break;
+      return false;
     }
-    std::string methodname = info[0];
-    uint32_t total_count = strtoul(info[1].c_str(), nullptr, 10);
-    uint32_t size = strtoul(info[2].c_str(), nullptr, 10);
-    PreviousContextMap* context_map = nullptr;
-    if (type == kProfilerBoundedStack && info.size() == 4) {
-      context_map = new PreviousContextMap();
+    ProfileMethod method;
+    method.method_name = info[0];
+    method.count = strtoul(info[1].c_str(), nullptr, 10);
+    method.method_size = strtoul(info[2].c_str(), nullptr, 10);
+    if (with_contexts && info.size() == 4 && info[3].size() >= 2) {
       std::string context_counts_str = info[3].substr(1, info[3].size() - 2);
       std::vector<std::string> context_count_pairs;
       Split(context_counts_str, '#', context_count_pairs);
-      for (uint32_t i = 0; i < context_count_pairs.size(); ++i) {
+      for (uint32_t j = 0; j < context_count_pairs.size(); ++j) {
         std::vector<std::string> context_count;
-        Split(context_count_pairs[i], ':', context_count);
-        if (context_count.size() == 2) {
-          // Handles the situtation when the profile file doesn't contain context information.
-          uint32_t dexpc = strtoul(context_count[0].c_str(), nullptr, 10);
-          uint32_t count = strtoul(context_count[1].c_str(), nullptr, 10);
-          (*context_map)[std::make_pair(dexpc, "")] = count;
-        } else {
-          // Handles the situtation when the profile file contains context information.
-          uint32_t dexpc = strtoul(context_count[0].c_str(), nullptr, 10);
-          uint32_t count = strtoul(context_count[1].c_str(), nullptr, 10);
-          std::string context = context_count[2];
-          (*context_map)[std::make_pair(dexpc, context)] = count;
+        Split(context_count_pairs[j], ':', context_count);
+        if (context_count.size() < 2) {
+          continue;
         }
+        uint32_t dexpc = strtoul(context_count[0].c_str(), nullptr, 10);
+        uint32_t count = strtoul(context_count[1].c_str(), nullptr, 10);
+        // Handles the situtation when the profile file doesn't contain context information.
+        std::string context = context_count.size() > 2 ? context_count[2] : "";
+        method.contexts.push_back(std::make_pair(std::make_pair(dexpc, context), count));
+      }
+    }
+    methods->push_back(std::move(method));
+  }
+  return true;
+}
+
+// Parses a profile in either format. On failure "methods" holds the methods read up to the
+// malformed one.
+bool ParseProfile(const std::string& data, bool with_contexts, ProfileSummary* summary,
+                  std::vector<ProfileMethod>* methods) {
+  if (data.size() >= sizeof(ProfileFile::kProfileMagic) &&
+      memcmp(data.data(), ProfileFile::kProfileMagic, sizeof(ProfileFile::kProfileMagic)) == 0) {
+    return ParseBinaryProfile(data, with_contexts, summary, methods);
+  }
+  return ParseTextProfile(data, with_contexts, summary, methods);
+}
+
+}  // namespace
+
+void ProfileSampleResults::ReadPrevious(int fd, ProfileDataType type) {
+  // Reset counters.
+  previous_num_samples_ = previous_num_null_methods_ = previous_num_boot_methods_ = 0;
+
+  // Read the whole file at once.
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size == 0) {
+    return;
+  }
+  std::string data(st.st_size, '\0');
+  size_t length = 0;
+  while (length < data.size()) {
+    ssize_t n = TEMP_FAILURE_RETRY(read(fd, &data[length], data.size() - length));
+    if (n <= 0) {
+      break;
+    }
+    length += n;
+  }
+  data.resize(length);
+
+  ProfileSummary summary;
+  std::vector<ProfileMethod> methods;
+  ParseProfile(data, type == kProfilerBoundedStack, &summary, &methods);
+  previous_num_samples_ = summary.num_samples;
+  previous_num_null_methods_ = summary.num_null_methods;
+  previous_num_boot_methods_ = summary.num_boot_methods;
+  previous_.reserve(methods.size());
+  for (ProfileMethod& method : methods) {
+    PreviousContextMap* context_map = nullptr;
+    if (type == kProfilerBoundedStack) {
+      context_map = new PreviousContextMap();
+      for (const auto& context : method.contexts) {
+        (*context_map)[context.first] = context.second;
       }
     }
-    previous_[methodname] = PreviousValue(total_count, size, context_map);
+    PreviousValue& value = previous_[method.method_name];
+    delete value.context_map_;
+    value = PreviousValue(method.count, method.method_size, context_map);
   }
 }
 
@@ -806,8 +995,8 @@ bool ProfileFile::LoadFile(const std::string& fileName) {
   if (st.st_size == 0) {
     return false;  // Empty profiles are invalid.
   }
-  std::ifstream in(fileName.c_str());
-  if (!in) {
+  std::unique_ptr<File> file(OS::OpenFileForReading(fileName.c_str()));
+  if (file.get() == nullptr) {
     LOG(VERBOSE) << "profile file " << fileName << " exists but can't be opened";
     LOG(VERBOSE) << "file owner: " << st.st_uid << ":" << st.st_gid;
     LOG(VERBOSE) << "me: " << getuid() << ":" << getgid();
@@ -815,59 +1004,44 @@ bool ProfileFile::LoadFile(const std::string& fileName) {
     LOG(VERBOSE) << "errno: " << errno;
     return false;
   }
-  // The first line contains summary information.
-  std::string line;
-  std::getline(in, line);
-  if (in.eof()) {
+  std::string data(st.st_size, '\0');
+  if (!file->ReadFully(&data[0], data.size())) {
     return false;
   }
-  std::vector<std::string> summary_info;
-  Split(line, '/', summary_info);
-  if (summary_info.size() != 3) {
-    // Bad summary info.  It should be total/null/boot.
+
+  ProfileSummary summary;
+  std::vector<ProfileMethod> methods;
+  if (!ParseProfile(data, false, &summary, &methods)) {
     return false;
   }
   // This is the number of hits in all profiled methods (without nullptr or boot methods)
-  uint32_t total_count = strtoul(summary_info[0].c_str(), nullptr, 10);
-
-  // Now read each line until the end of file.  Each line consists of 3 fields separated by '/'.
-  // Store the info in descending order given by the most used methods.
-  typedef std::set<std::pair<int, std::vector<std::string>>> ProfileSet;
-  ProfileSet countSet;
-  while (!in.eof()) {
-    std::getline(in, line);
-    if (in.eof()) {
-      break;
-    }
-    std::vector<std::string> info;
-    Split(line, '/', info);
-    if (info.size() != 3 && info.size() != 4) {
-      // Malformed.
-      return false;
-    }
-    int count = atoi(info[1].c_str());
-    countSet.insert(std::make_pair(-count, info));
-  }
+  uint32_t total_count = summary.num_samples;
+
+  // Go through the methods in descending order given by the most used methods.
+  std::sort(methods.begin(), methods.end(), [](const ProfileMethod& a, const ProfileMethod& b) {
+    return a.count != b.count ? a.count > b.count : a.method_name < b.method_name;
+  });
 
   uint32_t curTotalCount = 0;
-  ProfileSet::iterator end = countSet.end();
-  const ProfileData* prevData = nullptr;
-  for (ProfileSet::iterator it = countSet.begin(); it != end ; it++) {
-    const std::string& methodname = it->second[0];
-    uint32_t count = -it->first;
-    uint32_t size = strtoul(it->second[2].c_str(), nullptr, 10);
+  uint32_t prevCount = 0;
+  double prevTopKPercentage = 0;
+  profile_map_.reserve(profile_map_.size() + methods.size());
+  for (size_t i = 0; i < methods.size(); ++i) {
+    const ProfileMethod& method = methods[i];
+    uint32_t count = method.count;
     double usedPercent = (count * 100.0) / total_count;
 
     curTotalCount += count;
     // Methods with the same count should be part of the same top K percentage bucket.
-    double topKPercentage = (prevData != nullptr) && (prevData->GetCount() == count)
-      ? prevData->GetTopKUsedPercentage()
+    double topKPercentage = (i != 0) && (prevCount == count)
+      ? prevTopKPercentage
       : 100 * static_cast<double>(curTotalCount) / static_cast<double>(total_count);
 
     // Add it to the profile map.
-    ProfileData curData = ProfileData(methodname, count, size, usedPercent, topKPercentage);
-    profile_map_[methodname] = curData;
-    prevData = &curData;
+    profile_map_[method.method_name] =
+        ProfileData(method.method_name, count, method.method_size, usedPercent, topKPercentage);
+    prevCount = count;
+    prevTopKPercentage = topKPercentage;
   }
   return true;
 }
@@ -896,9 +1070,8 @@ StackTrieNode* StackTrieNode::FindChild(MethodReference method, uint32_t dex_pc)
     return nullptr;
   }
   // Create a dummy node for searching.
-  StackTrieNode* node = new StackTrieNode(method, dex_pc, 0, nullptr);
-  std::set<StackTrieNode*, StackTrieNodeComparator>::iterator i = children_.find(node);
-  delete node;
+  StackTrieNode node(method, dex_pc, 0, nullptr);
+  std::set<StackTrieNode*, StackTrieNodeComparator>::iterator i = children_.find(&node);
   return (i == children_.end()) ? nullptr : *i;
 }
 
@@ -21,9 +21,11 @@
 #include <ostream>
 #include <set>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "barrier.h"
+#include "base/hash_map.h"
 #include "base/macros.h"
 #include "base/mutex.h"
 #include "globals.h"
@@ -43,6 +45,20 @@ class Thread;
 
 typedef std::pair<mirror::ArtMethod*, uint32_t> InstructionLocation;
 
+// The samples taken of a thread since the profiler last collected them. Whoever runs the sampling
+// checkpoint for the thread appends to it without any locking, and the profiler thread empties it
+// between checkpoints, often enough that it never fills up.
+struct ProfilerSampleBuffer {
+  static constexpr size_t kCapacity = 256;
+
+  ProfilerSampleBuffer() : size(0) {}
+
+  size_t size;
+  // A method sample takes one entry, which has a null method if there was no current method. A
+  // stack sample is a (nullptr, depth) entry followed by depth frames, top of the stack first.
+  InstructionLocation entries[kCapacity];
+};
+
 // This class stores the sampled bounded stacks in a trie structure. A path of the trie represents
 // a particular context with the method on top of the stack being a leaf or an internal node of the
 // trie rather than the root.
@@ -97,16 +113,19 @@ class StackTrieNode {
 // counts the number of null methods (where we can't determine the method) and
 // the number of methods in the boot path (where we have already compiled the method).
 //
-// This object is an internal profiler object and uses the same locking as the profiler
-// itself.
+// This object is an internal profiler object and is only used by the profiler thread, which
+// collects the samples from the threads' sample buffers.
 class ProfileSampleResults {
  public:
-  explicit ProfileSampleResults(Mutex& lock);
+  ProfileSampleResults();
   ~ProfileSampleResults();
 
   void Put(mirror::ArtMethod* method);
-  void PutStack(const std::vector<InstructionLocation>& stack_dump);
-  uint32_t Write(std::ostream &os, ProfileDataType type);
+  void PutStack(const InstructionLocation* stack, size_t depth)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  // Appends the binary profile, merged with the previous one, to "out".
+  uint32_t Write(std::vector<uint8_t>* out, ProfileDataType type)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
   void ReadPrevious(int fd, ProfileDataType type);
   void Clear();
   uint32_t GetNumSamples() { return num_samples_; }
@@ -114,20 +133,46 @@ class ProfileSampleResults {
   void BootMethod() { ++num_boot_methods_; }
 
  private:
-  uint32_t Hash(mirror::ArtMethod* method);
-  static constexpr int kHashSize = 17;
-  Mutex& lock_;                  // Reference to the main profiler lock - we don't need two of them.
   uint32_t num_samples_;         // Total number of samples taken.
   uint32_t num_null_methods_;    // Number of samples where can don't know the method.
   uint32_t num_boot_methods_;    // Number of samples in the boot path.
 
-  typedef std::map<mirror::ArtMethod*, uint32_t> Map;  // Map of method vs its count.
-  Map *table[kHashSize];
-
-  typedef std::set<StackTrieNode*> TrieNodeSet;
-  // Map of method hit by profiler vs the set of stack trie nodes for this method.
-  typedef std::map<MethodReference, TrieNodeSet*, MethodReferenceComparator> MethodContextMap;
-  MethodContextMap *method_context_table;
+  struct MethodCountEmptyFn {
+    void MakeEmpty(std::pair<mirror::ArtMethod*, uint32_t>& item) const {
+      item.first = nullptr;
+      item.second = 0;
+    }
+    bool IsEmpty(const std::pair<mirror::ArtMethod*, uint32_t>& item) const {
+      return item.first == nullptr;
+    }
+  };
+  struct MethodHash {
+    size_t operator()(mirror::ArtMethod* method) const {
+      // Methods are at least 8 byte aligned.
+      return reinterpret_cast<uintptr_t>(method) >> 3;
+    }
+  };
+  // Map of method vs its count.
+  typedef HashMap<mirror::ArtMethod*, uint32_t, MethodCountEmptyFn, MethodHash> MethodCountMap;
+  MethodCountMap method_counts_;
+
+  // The trie nodes where a method was on top of the stack. A node is only added on its first hit,
+  // so this isn't on the path of most samples.
+  typedef std::vector<StackTrieNode*> TrieNodes;
+  struct MethodReferenceHash {
+    size_t operator()(const MethodReference& method) const {
+      return (reinterpret_cast<uintptr_t>(method.dex_file) >> 3) * 31 + method.dex_method_index;
+    }
+  };
+  struct MethodReferenceEquals {
+    bool operator()(const MethodReference& mr1, const MethodReference& mr2) const {
+      return mr1.dex_file == mr2.dex_file && mr1.dex_method_index == mr2.dex_method_index;
+    }
+  };
+  // Map of method hit by profiler vs the stack trie nodes for this method.
+  typedef std::unordered_map<MethodReference, TrieNodes*, MethodReferenceHash,
+                             MethodReferenceEquals> MethodContextMap;
+  MethodContextMap method_context_table_;
   StackTrieNode* stack_trie_root_;  // Root of the trie that stores sampled stack information.
 
   // Map from <pc, context> to counts.
@@ -141,7 +186,11 @@ class ProfileSampleResults {
     PreviousContextMap* context_map_;
   };
 
-  typedef std::map<std::string, PreviousValue> PreviousProfile;
+  static void WriteMethod(std::vector<uint8_t>* out, const std::string& method_name,
+                          uint32_t count, uint32_t method_size,
+                          const PreviousContextMap* context_map);
+
+  typedef std::unordered_map<std::string, PreviousValue> PreviousProfile;
   PreviousProfile previous_;
   uint32_t previous_num_samples_;
   uint32_t previous_num_null_methods_;     // Number of samples where can don't know the method.
@@ -161,7 +210,9 @@ class ProfileSampleResults {
 //
 // So the profiler thread is sleeping for the 'period' time.  It wakes up and runs for the
 // 'duration'.  The run consists of a series of samples, each of which is 'interval' microseconds
-// apart.  At the end of a run, it writes the results table to a file and goes back to sleep.
+// apart.  The samples are buffered per thread and collected into the results table by the
+// profiler thread every so often.  At the end of a run, it writes the results table to a file
+// and goes back to sleep.
 
 class BackgroundMethodSamplingProfiler {
  public:
@@ -176,8 +227,10 @@ class BackgroundMethodSamplingProfiler {
   static void Stop() LOCKS_EXCLUDED(Locks::profiler_lock_, wait_lock_);
   static void Shutdown() LOCKS_EXCLUDED(Locks::profiler_lock_);
 
-  void RecordMethod(mirror::ArtMethod *method) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
-  void RecordStack(const std::vector<InstructionLocation>& stack) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  // Record a sample of "thread" in its sample buffer. Called by the sampling checkpoint.
+  void RecordMethod(Thread* thread, mirror::ArtMethod* method)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  void RecordStack(Thread* thread) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
   bool ProcessMethod(mirror::ArtMethod* method) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
   const ProfilerOptions& GetProfilerOptions() const { return options_; }
 
@@ -194,8 +247,16 @@ class BackgroundMethodSamplingProfiler {
 
   uint32_t WriteProfile() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
+  // Empty the threads' sample buffers into the results table. Only called by the profiler thread
+  // while no sampling checkpoint is running.
+  void CollectSamples(Thread* self)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) LOCKS_EXCLUDED(Locks::thread_list_lock_);
+
+  // The number of sampling rounds after which the sample buffers have to be collected.
+  uint32_t RoundsPerCollection() const;
+
   void CleanProfile();
-  uint32_t DumpProfile(std::ostream& os) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  uint32_t DumpProfile(std::vector<uint8_t>* out) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
   static bool ShuttingDown(Thread* self) LOCKS_EXCLUDED(Locks::profiler_lock_);
 
   static BackgroundMethodSamplingProfiler* profiler_ GUARDED_BY(Locks::profiler_lock_);
@@ -221,6 +282,9 @@ class BackgroundMethodSamplingProfiler {
 
   ProfileSampleResults profile_table_;
 
+  // Samples taken from the threads' buffers, reused by CollectSamples.
+  std::vector<InstructionLocation> collected_samples_;
+
   std::unique_ptr<Barrier> profiler_barrier_;
 
   // Set of methods to be filtered out.  This will probably be rare because
@@ -235,8 +299,20 @@ class BackgroundMethodSamplingProfiler {
 //
 // Contains profile data generated from previous runs of the program and stored
 // in a file.  It is used to determine whether to compile a particular method or not.
+//
+// Profiles are written in a binary format, in native byte order:
+//   u1[4] magic, u1[4] version
+//   u4 profile type, u4 number of samples, u4 null method samples, u4 boot method samples,
+//   u4 number of methods, then for each method:
+//     u4 name length, name, u4 count, u4 method size, u4 number of contexts, then for each:
+//       u4 dex pc, u4 count, u4 context length, context
+// The older text format, "samples/null/boot" followed by a "name/count/size[/contexts]" line per
+// method, can still be read.
 class ProfileFile {
  public:
+  static const uint8_t kProfileMagic[4];
+  static const uint8_t kProfileVersion[4];
+
   class ProfileData {
    public:
     ProfileData() : count_(0), method_size_(0), used_percent_(0) {}
@@ -275,7 +351,7 @@ class ProfileFile {
 
  private:
   // Profile data is stored in a map, indexed by the full method name.
-  typedef std::map<std::string, ProfileData> ProfileMap;
+  typedef std::unordered_map<std::string, ProfileData> ProfileMap;
   ProfileMap profile_map_;
 };
 
@@ -0,0 +1,154 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "profiler.h"
+
+#include <string>
+#include <vector>
+
+#include "base/unix_file/fd_file.h"
+#include "class_linker.h"
+#include "common_runtime_test.h"
+#include "mirror/art_method-inl.h"
+#include "mirror/class-inl.h"
+#include "scoped_thread_state_change.h"
+
+namespace art {
+
+class ProfilerTest : public CommonRuntimeTest {
+ protected:
+  mirror::Class* GetObjectClass() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+    mirror::Class* c = class_linker_->FindSystemClass(Thread::Current(), "Ljava/lang/Object;");
+    CHECK(c != nullptr);
+    return c;
+  }
+
+  static void WriteFile(const ScratchFile& file, const void* data, size_t length) {
+    ASSERT_EQ(0, lseek(file.GetFd(), 0, SEEK_SET));
+    ASSERT_EQ(0, file.GetFile()->SetLength(0));
+    ASSERT_TRUE(file.GetFile()->WriteFully(data, length));
+  }
+};
+
+TEST_F(ProfilerTest, WriteAndLoad) {
+  ScratchFile profile;
+  std::string hot_name;
+  std::string cold_name;
+  {
+    ScopedObjectAccess soa(Thread::Current());
+    mirror::Class* c = GetObjectClass();
+    mirror::ArtMethod* hot = c->GetVirtualMethod(0);
+    mirror::ArtMethod* cold = c->GetVirtualMethod(1);
+    hot_name = PrettyMethod(hot);
+    cold_name = PrettyMethod(cold);
+    ProfileSampleResults results;
+    for (int i = 0; i < 3; ++i) {
+      results.Put(hot);
+    }
+    results.Put(cold);
+    std::vector<uint8_t> data;
+    EXPECT_EQ(2U, results.Write(&data, kProfilerMethod));
+    EXPECT_EQ(0, memcmp(ProfileFile::kProfileMagic, data.data(),
+                        sizeof(ProfileFile::kProfileMagic)));
+    WriteFile(profile, data.data(), data.size());
+  }
+
+  ProfileFile profile_file;
+  ASSERT_TRUE(profile_file.LoadFile(profile.GetFilename()));
+  ProfileFile::ProfileData hot_data;
+  ASSERT_TRUE(profile_file.GetProfileData(&hot_data, hot_name));
+  EXPECT_EQ(3U, hot_data.GetCount());
+  EXPECT_DOUBLE_EQ(75.0, hot_data.GetUsedPercent());
+  EXPECT_DOUBLE_EQ(75.0, hot_data.GetTopKUsedPercentage());
+  ProfileFile::ProfileData cold_data;
+  ASSERT_TRUE(profile_file.GetProfileData(&cold_data, cold_name));
+  EXPECT_EQ(1U, cold_data.GetCount());
+  EXPECT_DOUBLE_EQ(100.0, cold_data.GetTopKUsedPercentage());
+  ProfileFile::ProfileData missing;
+  EXPECT_FALSE(profile_file.GetProfileData(&missing, "void Foo.bar()"));
+}
+
+// Profiles in the older text format are still read, and merged into the new one.
+TEST_F(ProfilerTest, MergeTextProfile) {
+  ScopedObjectAccess soa(Thread::Current());
+  mirror::ArtMethod* method = GetObjectClass()->GetVirtualMethod(0);
+  const std::string method_name = PrettyMethod(method);
+  ScratchFile profile;
+  const std::string text = "6/1/2\nvoid Foo.bar()/4/10\n" + method_name + "/2/5\n";
+  WriteFile(profile, text.data(), text.size());
+
+  ProfileFile text_file;
+  ASSERT_TRUE(text_file.LoadFile(profile.GetFilename()));
+  ProfileFile::ProfileData data;
+  ASSERT_TRUE(text_file.GetProfileData(&data, "void Foo.bar()"));
+  EXPECT_EQ(4U, data.GetCount());
+
+  ProfileSampleResults results;
+  ASSERT_EQ(0, lseek(profile.GetFd(), 0, SEEK_SET));
+  results.ReadPrevious(profile.GetFd(), kProfilerMethod);
+  results.Put(method);
+  std::vector<uint8_t> binary;
+  EXPECT_EQ(2U, results.Write(&binary, kProfilerMethod));
+  WriteFile(profile, binary.data(), binary.size());
+
+  ProfileFile merged_file;
+  ASSERT_TRUE(merged_file.LoadFile(profile.GetFilename()));
+  ASSERT_TRUE(merged_file.GetProfileData(&data, "void Foo.bar()"));
+  EXPECT_EQ(4U, data.GetCount());
+  ASSERT_TRUE(merged_file.GetProfileData(&data, method_name));
+  EXPECT_EQ(3U, data.GetCount());
+  // Seven samples in all.
+  EXPECT_DOUBLE_EQ(300.0 / 7, data.GetUsedPercent());
+}
+
+// A truncated binary profile is rejected.
+TEST_F(ProfilerTest, LoadTruncated) {
+  std::vector<uint8_t> data;
+  {
+    ScopedObjectAccess soa(Thread::Current());
+    ProfileSampleResults results;
+    results.Put(GetObjectClass()->GetVirtualMethod(0));
+    results.Write(&data, kProfilerMethod);
+  }
+  ScratchFile profile;
+  WriteFile(profile, data.data(), data.size() - 1);
+  ProfileFile profile_file;
+  EXPECT_FALSE(profile_file.LoadFile(profile.GetFilename()));
+}
+
+// Samples aggregated per second, spread over all the methods of a few boot classes.
+TEST_F(ProfilerTest, DISABLED_AggregationThroughput) {
+  static const size_t kSamples = 10 * 1000 * 1000;
+  ScopedObjectAccess soa(Thread::Current());
+  std::vector<mirror::ArtMethod*> methods;
+  for (const char* descriptor : { "Ljava/lang/Object;", "Ljava/lang/String;", "Ljava/lang/Class;",
+                                  "Ljava/lang/Thread;", "Ljava/util/HashMap;" }) {
+    mirror::Class* c = class_linker_->FindSystemClass(soa.Self(), descriptor);
+    ASSERT_TRUE(c != nullptr) << descriptor;
+    for (size_t i = 0; i < c->NumVirtualMethods(); ++i) {
+      methods.push_back(c->GetVirtualMethod(i));
+    }
+  }
+  ProfileSampleResults results;
+  const uint64_t start = NanoTime();
+  for (size_t i = 0; i < kSamples; ++i) {
+    results.Put(methods[(i * 7919) % methods.size()]);
+  }
+  const uint64_t duration = NanoTime() - start;
+  LOG(INFO) << methods.size() << " methods: " << kSamples * 1000000000 / duration << " samples/s";
+}
+
+}  // namespace art
@@ -144,6 +144,7 @@ Runtime::Runtime()
       suspend_handler_(nullptr),
       stack_overflow_handler_(nullptr),
       verify_(false),
+      background_verification_threads_(0),
       target_sdk_version_(0),
       implicit_null_checks_(false),
       implicit_so_checks_(false),
@@ -181,6 +182,7 @@ Runtime::~Runtime() {
   // Make sure to let the GC complete if it is running.
   heap_->WaitForGcToComplete(gc::kGcCauseBackground, self);
   heap_->DeleteThreadPool();
+  class_linker_->DeleteBackgroundVerificationThreadPool();
 
   // Make sure our internal threads are dead before we start tearing down things they're using.
   Dbg::StopJdwp();
@@ -543,8 +545,9 @@ void Runtime::DidForkFromZygote(JNIEnv* env, NativeBridgeAction action, const ch
     }
   }
 
-  // Create the thread pool.
+  // Create the thread pools.
   heap_->CreateThreadPool();
+  class_linker_->CreateBackgroundVerificationThreadPool();
 
   StartSignalCatcher();
 
@@ -714,6 +717,7 @@ bool Runtime::Init(const RuntimeOptions& raw_options, bool ignore_unrecognized)
   intern_table_ = new InternTable;
 
   verify_ = options->verify_;
+  background_verification_threads_ = options->background_verification_threads_;
 
   if (options->interpreter_only_) {
     GetInstrumentation()->ForceInterpretOnly();
@@ -734,6 +738,7 @@ bool Runtime::Init(const RuntimeOptions& raw_options, bool ignore_unrecognized)
                        options->parallel_gc_threads_,
                        options->conc_gc_threads_,
                        options->low_memory_mode_,
+                       options->rosalloc_thread_local_run_threshold_,
                        options->long_pause_log_threshold_,
                        options->long_gc_log_threshold_,
                        options->ignore_max_footprint_,
@@ -745,7 +750,8 @@ bool Runtime::Init(const RuntimeOptions& raw_options, bool ignore_unrecognized)
                        options->verify_pre_sweeping_rosalloc_,
                        options->verify_post_gc_rosalloc_,
                        options->use_homogeneous_space_compaction_for_oom_,
-                       options->min_interval_homogeneous_space_compaction_by_oom_);
+                       options->min_interval_homogeneous_space_compaction_by_oom_,
+                       options->tenuring_threshold_);
 
   dump_gc_performance_on_shutdown_ = options->dump_gc_performance_on_shutdown_;
 
@@ -852,8 +858,8 @@ bool Runtime::Init(const RuntimeOptions& raw_options, bool ignore_unrecognized)
 
   if (options->method_trace_) {
     ScopedThreadStateChange tsc(self, kWaitingForMethodTracingStart);
-    Trace::Start(options->method_trace_file_.c_str(), -1, options->method_trace_file_size_, 0,
-                 false, false, 0);
+    Trace::Start(options->method_trace_file_.c_str(), -1, options->method_trace_file_size_,
+                 options->method_trace_stream_ ? Trace::kTraceStreaming : 0, false, false, 0);
   }
 
   // Pre-allocate an OutOfMemoryError for the double-OOME case.
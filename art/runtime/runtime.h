@@ -477,6 +477,10 @@ class Runtime {
     return verify_;
   }
 
+  size_t GetBackgroundVerificationThreads() const {
+    return background_verification_threads_;
+  }
+
   bool RunningOnValgrind() const {
     return running_on_valgrind_;
   }
@@ -641,6 +645,9 @@ class Runtime {
   // If false, verification is disabled. True by default.
   bool verify_;
 
+  // Number of threads verifying app classes ahead of their use, zero to verify them only lazily.
+  size_t background_verification_threads_;
+
   // Specifies target SDK version to allow workarounds for certain API levels.
   int32_t target_sdk_version_;
 
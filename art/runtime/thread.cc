@@ -46,6 +46,7 @@
 #include "handle_scope-inl.h"
 #include "handle_scope.h"
 #include "indirect_reference_table-inl.h"
+#include "interpreter/interpreter_cache.h"
 #include "jni_internal.h"
 #include "mirror/art_field-inl.h"
 #include "mirror/art_method-inl.h"
@@ -55,6 +56,7 @@
 #include "mirror/stack_trace_element.h"
 #include "monitor.h"
 #include "object_lock.h"
+#include "profiler.h"
 #include "quick_exception_handler.h"
 #include "quick/quick_method_frame_info.h"
 #include "reflection.h"
@@ -65,6 +67,7 @@
 #include "stack.h"
 #include "thread_list.h"
 #include "thread-inl.h"
+#include "trace.h"
 #include "utils.h"
 #include "verifier/dex_gc_map.h"
 #include "verify_object-inl.h"
@@ -1244,6 +1247,10 @@ Thread::~Thread() {
   delete tlsPtr_.name;
   delete tlsPtr_.stack_trace_sample;
   free(tlsPtr_.nested_signal_state);
+  // Only left behind if we exited while a trace was being stopped.
+  delete tlsPtr_.method_trace_buffer;
+  delete tlsPtr_.profiler_sample_buffer;
+  delete tlsPtr_.interpreter_cache;
 
   Runtime::Current()->GetHeap()->RevokeThreadLocalBuffers(this);
 
@@ -2212,6 +2219,9 @@ void Thread::VisitRoots(RootCallback* visitor, void* arg) {
   if (tlsPtr_.single_step_control != nullptr) {
     tlsPtr_.single_step_control->VisitRoots(visitor, arg, RootInfo(kRootDebugger, thread_id));
   }
+  if (tlsPtr_.interpreter_cache != nullptr) {
+    tlsPtr_.interpreter_cache->VisitRoots(visitor, arg, thread_id);
+  }
   if (tlsPtr_.deoptimization_shadow_frame != nullptr) {
     RootCallbackVisitor visitorToCallback(visitor, arg, thread_id);
     ReferenceMapVisitor<RootCallbackVisitor> mapper(this, nullptr, visitorToCallback);
@@ -51,6 +51,10 @@ namespace collector {
 }  // namespace collector
 }  // namespace gc
 
+namespace interpreter {
+  class InterpreterCache;
+}  // namespace interpreter
+
 namespace mirror {
   class ArtMethod;
   class Array;
@@ -71,7 +75,9 @@ struct DebugInvokeReq;
 class DexFile;
 class JavaVMExt;
 struct JNIEnvExt;
+struct MethodTraceBuffer;
 class Monitor;
+struct ProfilerSampleBuffer;
 class Runtime;
 class ScopedObjectAccessAlreadyRunnable;
 class ShadowFrame;
@@ -752,6 +758,30 @@ class Thread {
     tls64_.trace_clock_base = clock_base;
   }
 
+  MethodTraceBuffer* GetMethodTraceBuffer() const {
+    return tlsPtr_.method_trace_buffer;
+  }
+
+  void SetMethodTraceBuffer(MethodTraceBuffer* buffer) {
+    tlsPtr_.method_trace_buffer = buffer;
+  }
+
+  ProfilerSampleBuffer* GetProfilerSampleBuffer() const {
+    return tlsPtr_.profiler_sample_buffer;
+  }
+
+  void SetProfilerSampleBuffer(ProfilerSampleBuffer* buffer) {
+    tlsPtr_.profiler_sample_buffer = buffer;
+  }
+
+  interpreter::InterpreterCache* GetInterpreterCache() const {
+    return tlsPtr_.interpreter_cache;
+  }
+
+  void SetInterpreterCache(interpreter::InterpreterCache* cache) {
+    tlsPtr_.interpreter_cache = cache;
+  }
+
   BaseMutex* GetHeldMutex(LockLevel level) const {
     return tlsPtr_.held_mutexes[level];
   }
@@ -1029,7 +1059,9 @@ class Thread {
       deoptimization_shadow_frame(nullptr), shadow_frame_under_construction(nullptr), name(nullptr),
       pthread_self(0), last_no_thread_suspension_cause(nullptr), thread_local_start(nullptr),
       thread_local_pos(nullptr), thread_local_end(nullptr), thread_local_objects(0),
-      thread_local_alloc_stack_top(nullptr), thread_local_alloc_stack_end(nullptr) {
+      thread_local_alloc_stack_top(nullptr), thread_local_alloc_stack_end(nullptr),
+      nested_signal_state(nullptr), method_trace_buffer(nullptr), profiler_sample_buffer(nullptr),
+      interpreter_cache(nullptr) {
     }
 
     // The biased card table, see CardTable for details.
@@ -1132,7 +1164,8 @@ class Thread {
     byte* thread_local_end;
     size_t thread_local_objects;
 
-    // There are RosAlloc::kNumThreadLocalSizeBrackets thread-local size brackets per thread.
+    // Every entry starts as RosAlloc::GetDedicatedFullRun(); only the first
+    // RosAlloc::NumThreadLocalSizeBrackets() are ever replaced with real runs.
     void* rosalloc_runs[kNumRosAllocThreadLocalSizeBrackets];
 
     // Thread-local allocation stack data/routines.
@@ -1144,6 +1177,15 @@ class Thread {
 
     // Recorded thread state for nested signals.
     jmp_buf* nested_signal_state;
+
+    // Records of the method trace in progress not yet handed over to the trace.
+    MethodTraceBuffer* method_trace_buffer;
+
+    // Samples taken by the background profiler not yet collected by it.
+    ProfilerSampleBuffer* profiler_sample_buffer;
+
+    // Inline caches of the interpreter, created when it first runs on the thread.
+    interpreter::InterpreterCache* interpreter_cache;
   } tlsPtr_;
 
   // Guards the 'interrupted_' and 'wait_monitor_' members.
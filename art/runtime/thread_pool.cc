@@ -28,7 +28,13 @@ static constexpr bool kMeasureWaitTime = false;
 ThreadPoolWorker::ThreadPoolWorker(ThreadPool* thread_pool, const std::string& name,
                                    size_t stack_size)
     : thread_pool_(thread_pool),
-      name_(name) {
+      name_(name),
+      index_(thread_pool->GetThreadCount()),
+      thread_(nullptr),
+      // Any non-zero seed will do, make them differ between workers.
+      random_state_(static_cast<uint32_t>(index_) * 2654435761U + 1),
+      steal_count_(0),
+      steal_contention_count_(0) {
   std::string error_msg;
   stack_.reset(MemMap::MapAnonymous(name.c_str(), nullptr, stack_size, PROT_READ | PROT_WRITE,
                                     false, &error_msg));
@@ -49,7 +55,7 @@ void ThreadPoolWorker::Run() {
   Thread* self = Thread::Current();
   Task* task = NULL;
   thread_pool_->creation_barier_.Wait(self);
-  while ((task = thread_pool_->GetTask(self)) != NULL) {
+  while ((task = thread_pool_->GetTask(self, this)) != NULL) {
     task->Run(self);
     task->Finalize();
   }
@@ -59,6 +65,7 @@ void* ThreadPoolWorker::Callback(void* arg) {
   ThreadPoolWorker* worker = reinterpret_cast<ThreadPoolWorker*>(arg);
   Runtime* runtime = Runtime::Current();
   CHECK(runtime->AttachCurrentThread(worker->name_.c_str(), true, NULL, false));
+  worker->thread_ = Thread::Current();
   // Do work until its time to shut down.
   worker->Run();
   runtime->DetachCurrentThread();
@@ -66,14 +73,38 @@ void* ThreadPoolWorker::Callback(void* arg) {
 }
 
 void ThreadPool::AddTask(Thread* self, Task* task) {
+  ThreadPoolWorker* worker = FindWorker(self);
+  if (worker != nullptr) {
+    worker->local_tasks_.PushBottom(task);
+    // Pairs with the fence in GetTask: either we see the waiter, or it sees the task.
+    QuasiAtomic::ThreadFenceSequentiallyConsistent();
+    if (waiting_count_.LoadRelaxed() != 0) {
+      MutexLock mu(self, task_queue_lock_);
+      if (started_) {
+        task_queue_condition_.Signal(self);
+      }
+    }
+    return;
+  }
   MutexLock mu(self, task_queue_lock_);
   tasks_.push_back(task);
   // If we have any waiters, signal one.
-  if (started_ && waiting_count_ != 0) {
+  if (started_ && waiting_count_.LoadRelaxed() != 0) {
     task_queue_condition_.Signal(self);
   }
 }
 
+ThreadPoolWorker* ThreadPool::FindWorker(Thread* self) const {
+  // Cheaper than a TLS lookup for the pool sizes we use, and no lock is needed since the worker
+  // list only changes in the constructors.
+  for (ThreadPoolWorker* worker : threads_) {
+    if (worker->thread_ == self) {
+      return worker;
+    }
+  }
+  return nullptr;
+}
+
 ThreadPool::ThreadPool(const char* name, size_t num_threads)
   : name_(name),
     task_queue_lock_("task queue lock"),
@@ -129,22 +160,38 @@ void ThreadPool::StopWorkers(Thread* self) {
   started_ = false;
 }
 
-Task* ThreadPool::GetTask(Thread* self) {
+Task* ThreadPool::GetTask(Thread* self, ThreadPoolWorker* worker) {
+  // Work spawned by running tasks is found without taking the queue lock.
+  Task* task = TryGetLocalTask(worker);
+  if (task != NULL) {
+    return task;
+  }
   MutexLock mu(self, task_queue_lock_);
   while (!IsShuttingDown()) {
     const size_t thread_count = GetThreadCount();
     // Ensure that we don't use more threads than the maximum active workers.
-    const size_t active_threads = thread_count - waiting_count_;
+    const size_t active_threads = thread_count - waiting_count_.LoadRelaxed();
     // <= since self is considered an active worker.
-    if (active_threads <= max_active_workers_) {
-      Task* task = TryGetTaskLocked(self);
+    const bool may_run = active_threads <= max_active_workers_;
+    if (may_run) {
+      task = TryGetTaskLocked(self, worker);
+      if (task == NULL) {
+        task = TryGetLocalTask(worker);
+      }
       if (task != NULL) {
         return task;
       }
     }
 
     ++waiting_count_;
-    if (waiting_count_ == GetThreadCount() && tasks_.empty()) {
+    // Pairs with the fence in AddTask, so that a task pushed onto a deque after our last look is
+    // either seen here or its owner sees us waiting and signals.
+    QuasiAtomic::ThreadFenceSequentiallyConsistent();
+    if (may_run && started_ && HasLocalTasks()) {
+      --waiting_count_;
+      continue;
+    }
+    if (waiting_count_.LoadRelaxed() == GetThreadCount() && tasks_.empty()) {
       // We may be done, lets broadcast to the completion condition.
       completion_condition_.Broadcast(self);
     }
@@ -162,19 +209,97 @@ Task* ThreadPool::GetTask(Thread* self) {
 }
 
 Task* ThreadPool::TryGetTask(Thread* self) {
-  MutexLock mu(self, task_queue_lock_);
-  return TryGetTaskLocked(self);
+  {
+    MutexLock mu(self, task_queue_lock_);
+    Task* task = TryGetTaskLocked(self, NULL);
+    if (task != NULL) {
+      return task;
+    }
+  }
+  return TryGetLocalTask(FindWorker(self));
 }
 
-Task* ThreadPool::TryGetTaskLocked(Thread* self) {
+Task* ThreadPool::TryGetTaskLocked(Thread* self, ThreadPoolWorker* worker) {
   if (started_ && !tasks_.empty()) {
     Task* task = tasks_.front();
     tasks_.pop_front();
+    if (worker != NULL) {
+      // Take a fair share of the rest onto our deque, where other workers can steal it without the
+      // queue lock. This keeps a large batch of tasks added up front from serializing everyone on
+      // task_queue_lock_.
+      const size_t share = tasks_.size() / GetThreadCount();
+      for (size_t i = 0; i < share; ++i) {
+        worker->local_tasks_.PushBottom(tasks_.front());
+        tasks_.pop_front();
+      }
+      if (share != 0 && waiting_count_.LoadRelaxed() != 0) {
+        task_queue_condition_.Broadcast(self);
+      }
+    }
     return task;
   }
   return NULL;
 }
 
+Task* ThreadPool::TryGetLocalTask(ThreadPoolWorker* worker) {
+  if (!started_) {
+    return NULL;
+  }
+  if (worker != NULL) {
+    Task* task = worker->local_tasks_.PopBottom();
+    if (task != NULL) {
+      return task;
+    }
+  }
+  return TryStealTask(worker);
+}
+
+Task* ThreadPool::TryStealTask(ThreadPoolWorker* thief) {
+  const size_t thread_count = GetThreadCount();
+  if (thread_count == 0) {
+    return NULL;
+  }
+  // Start at a random victim so that thieves spread out instead of all hitting the same deque.
+  const size_t start = (thief != NULL) ? thief->NextRandom() % thread_count : 0;
+  bool contended;
+  do {
+    contended = false;
+    for (size_t i = 0; i < thread_count; ++i) {
+      ThreadPoolWorker* victim = threads_[(start + i) % thread_count];
+      if (victim == thief) {
+        continue;
+      }
+      Task* task;
+      switch (victim->local_tasks_.Steal(&task)) {
+        case WorkStealingDeque<Task>::kStealSuccess:
+          if (thief != NULL) {
+            ++thief->steal_count_;
+          }
+          return task;
+        case WorkStealingDeque<Task>::kStealAborted:
+          if (thief != NULL) {
+            ++thief->steal_contention_count_;
+          }
+          contended = true;
+          break;
+        case WorkStealingDeque<Task>::kStealEmpty:
+          break;
+      }
+    }
+    // Only go around again if we lost a race, since the deque we lost on may still have work.
+  } while (contended);
+  return NULL;
+}
+
+bool ThreadPool::HasLocalTasks() const {
+  for (ThreadPoolWorker* worker : threads_) {
+    if (!worker->local_tasks_.IsEmptyApprox()) {
+      return true;
+    }
+  }
+  return false;
+}
+
 void ThreadPool::Wait(Thread* self, bool do_work, bool may_hold_locks) {
   if (do_work) {
     Task* task = NULL;
@@ -183,9 +308,11 @@ void ThreadPool::Wait(Thread* self, bool do_work, bool may_hold_locks) {
       task->Finalize();
     }
   }
-  // Wait until each thread is waiting and the task list is empty.
+  // Wait until each thread is waiting and the task list is empty. Workers only wait once their own
+  // deques are empty, so the deques are empty too.
   MutexLock mu(self, task_queue_lock_);
-  while (!shutting_down_ && (waiting_count_ != GetThreadCount() || !tasks_.empty())) {
+  while (!shutting_down_ &&
+         (waiting_count_.LoadRelaxed() != GetThreadCount() || !tasks_.empty())) {
     if (!may_hold_locks) {
       completion_condition_.Wait(self);
     } else {
@@ -195,8 +322,28 @@ void ThreadPool::Wait(Thread* self, bool do_work, bool may_hold_locks) {
 }
 
 size_t ThreadPool::GetTaskCount(Thread* self) {
+  size_t count = 0;
+  for (ThreadPoolWorker* worker : threads_) {
+    count += worker->local_tasks_.SizeApprox();
+  }
   MutexLock mu(self, task_queue_lock_);
-  return tasks_.size();
+  return count + tasks_.size();
+}
+
+uint64_t ThreadPool::GetStealCount() const {
+  uint64_t count = 0;
+  for (ThreadPoolWorker* worker : threads_) {
+    count += worker->steal_count_;
+  }
+  return count;
+}
+
+uint64_t ThreadPool::GetStealContentionCount() const {
+  uint64_t count = 0;
+  for (ThreadPoolWorker* worker : threads_) {
+    count += worker->steal_contention_count_;
+  }
+  return count;
 }
 
 WorkStealingWorker::WorkStealingWorker(ThreadPool* thread_pool, const std::string& name,
@@ -207,7 +354,7 @@ void WorkStealingWorker::Run() {
   Thread* self = Thread::Current();
   Task* task = NULL;
   WorkStealingThreadPool* thread_pool = down_cast<WorkStealingThreadPool*>(thread_pool_);
-  while ((task = thread_pool_->GetTask(self)) != NULL) {
+  while ((task = thread_pool_->GetTask(self, this)) != NULL) {
     WorkStealingTask* stealing_task = down_cast<WorkStealingTask*>(task);
 
     {
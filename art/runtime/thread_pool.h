@@ -20,8 +20,10 @@
 #include <deque>
 #include <vector>
 
+#include "atomic.h"
 #include "barrier.h"
 #include "base/mutex.h"
+#include "base/work_stealing_deque.h"
 #include "closure.h"
 #include "mem_map.h"
 
@@ -51,10 +53,31 @@ class ThreadPoolWorker {
   static void* Callback(void* arg) LOCKS_EXCLUDED(Locks::mutator_lock_);
   virtual void Run();
 
+  // Returns a pseudo random number for picking steal victims.
+  uint32_t NextRandom() {
+    random_state_ ^= random_state_ << 13;
+    random_state_ ^= random_state_ >> 17;
+    random_state_ ^= random_state_ << 5;
+    return random_state_;
+  }
+
   ThreadPool* const thread_pool_;
   const std::string name_;
+  // Position in the thread pool's list of workers.
+  const size_t index_;
   std::unique_ptr<MemMap> stack_;
   pthread_t pthread_;
+  // The runtime thread of this worker, once attached.
+  Thread* thread_;
+
+  // Tasks added by tasks running on this worker. Only this worker pushes and pops, other threads
+  // steal from the top.
+  WorkStealingDeque<Task> local_tasks_;
+  uint32_t random_state_;
+  // Tasks stolen from other workers, and steal attempts that lost a race. Only written by this
+  // worker.
+  uint64_t steal_count_;
+  uint64_t steal_contention_count_;
 
  private:
   friend class ThreadPool;
@@ -75,7 +98,8 @@ class ThreadPool {
   void StopWorkers(Thread* self);
 
   // Add a new task, the first available started worker will process it. Does not delete the task
-  // after running it, it is the caller's responsibility.
+  // after running it, it is the caller's responsibility. Tasks added by the pool's own workers go
+  // on the worker's deque without taking any lock, everything else goes on the shared queue.
   void AddTask(Thread* self, Task* task);
 
   explicit ThreadPool(const char* name, size_t num_threads);
@@ -91,17 +115,34 @@ class ThreadPool {
     return total_wait_time_;
   }
 
+  // Returns how many tasks workers took from each other's deques, and how many steal attempts
+  // lost a race with the owner or another thief. Approximate while the workers are running.
+  uint64_t GetStealCount() const;
+  uint64_t GetStealContentionCount() const;
+
   // Provides a way to bound the maximum number of worker threads, threads must be less the the
   // thread count of the thread pool.
   void SetMaxActiveWorkers(size_t threads);
 
  protected:
   // get a task to run, blocks if there are no tasks left
-  virtual Task* GetTask(Thread* self);
+  virtual Task* GetTask(Thread* self, ThreadPoolWorker* worker);
 
   // Try to get a task, returning NULL if there is none available.
   Task* TryGetTask(Thread* self);
-  Task* TryGetTaskLocked(Thread* self) EXCLUSIVE_LOCKS_REQUIRED(task_queue_lock_);
+  Task* TryGetTaskLocked(Thread* self, ThreadPoolWorker* worker)
+      EXCLUSIVE_LOCKS_REQUIRED(task_queue_lock_);
+
+  // Pop a task from the worker's own deque or, failing that, steal one from another worker. Takes
+  // no locks. The worker may be null for threads which are not part of the pool.
+  Task* TryGetLocalTask(ThreadPoolWorker* worker);
+  Task* TryStealTask(ThreadPoolWorker* thief);
+
+  // Returns the worker which is running on self, or null if self isn't one of ours.
+  ThreadPoolWorker* FindWorker(Thread* self) const;
+
+  // Does any worker have tasks on its deque?
+  bool HasLocalTasks() const;
 
   // Are we shutting down?
   bool IsShuttingDown() const EXCLUSIVE_LOCKS_REQUIRED(task_queue_lock_) {
@@ -114,8 +155,10 @@ class ThreadPool {
   ConditionVariable completion_condition_ GUARDED_BY(task_queue_lock_);
   volatile bool started_ GUARDED_BY(task_queue_lock_);
   volatile bool shutting_down_ GUARDED_BY(task_queue_lock_);
-  // How many worker threads are waiting on the condition.
-  volatile size_t waiting_count_ GUARDED_BY(task_queue_lock_);
+  // How many worker threads are waiting on the condition. Only changed with the lock held, but
+  // read without it by workers pushing onto their deques to see whether anyone needs waking.
+  Atomic<size_t> waiting_count_;
+  // Tasks added from outside of the pool's workers.
   std::deque<Task*> tasks_ GUARDED_BY(task_queue_lock_);
   // TODO: make this immutable/const?
   std::vector<ThreadPoolWorker*> threads_;
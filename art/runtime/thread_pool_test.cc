@@ -140,4 +140,86 @@ TEST_F(ThreadPoolTest, RecursiveTest) {
   EXPECT_EQ((1 << depth) - 1, count.LoadSequentiallyConsistent());
 }
 
+class SpinUntilStolenTask : public Task {
+ public:
+  SpinUntilStolenTask(ThreadPool* const thread_pool, AtomicInteger* count, int children)
+      : thread_pool_(thread_pool), count_(count), children_(children) {}
+
+  void Run(Thread* self) {
+    // These go on our own deque, so the only way they get run while we spin is by being stolen.
+    for (int i = 0; i < children_; ++i) {
+      thread_pool_->AddTask(self, new CountTask(count_));
+    }
+    while (count_->LoadSequentiallyConsistent() == 0) {
+      usleep(100);
+    }
+  }
+
+  void Finalize() {
+    delete this;
+  }
+
+ private:
+  ThreadPool* const thread_pool_;
+  AtomicInteger* const count_;
+  const int children_;
+};
+
+// Test that idle workers steal tasks added by a busy one.
+TEST_F(ThreadPoolTest, StealTest) {
+  Thread* self = Thread::Current();
+  ThreadPool thread_pool("Thread pool test thread pool", num_threads);
+  AtomicInteger count(0);
+  static const int children = num_threads * 4;
+  thread_pool.AddTask(self, new SpinUntilStolenTask(&thread_pool, &count, children));
+  thread_pool.StartWorkers(self);
+  thread_pool.Wait(self, false, false);
+  EXPECT_EQ(children, count.LoadSequentiallyConsistent());
+  EXPECT_GT(thread_pool.GetStealCount(), 0U);
+}
+
+class NopTreeTask : public Task {
+ public:
+  NopTreeTask(ThreadPool* const thread_pool, int depth)
+      : thread_pool_(thread_pool), depth_(depth) {}
+
+  void Run(Thread* self) {
+    if (depth_ > 1) {
+      thread_pool_->AddTask(self, new NopTreeTask(thread_pool_, depth_ - 1));
+      thread_pool_->AddTask(self, new NopTreeTask(thread_pool_, depth_ - 1));
+    }
+  }
+
+  void Finalize() {
+    delete this;
+  }
+
+ private:
+  ThreadPool* const thread_pool_;
+  const int depth_;
+};
+
+// Reports task throughput for 1 to 64 threads. Tasks are tiny and mostly spawned by other tasks,
+// like the GC's mark stack overflow chunks, so this mostly measures the task queues.
+// Run with --gtest_also_run_disabled_tests.
+TEST_F(ThreadPoolTest, DISABLED_Throughput) {
+  Thread* self = Thread::Current();
+  static const int depth = 18;
+  static const int roots = 16;
+  const uint64_t num_tasks = roots * ((UINT64_C(1) << depth) - 1);
+  for (size_t threads = 1; threads <= 64; threads *= 2) {
+    ThreadPool thread_pool("Thread pool throughput thread pool", threads);
+    for (int i = 0; i < roots; ++i) {
+      thread_pool.AddTask(self, new NopTreeTask(&thread_pool, depth));
+    }
+    const uint64_t start = NanoTime();
+    thread_pool.StartWorkers(self);
+    thread_pool.Wait(self, false, false);
+    const uint64_t duration = NanoTime() - start;
+    LOG(INFO) << threads << " threads: " << num_tasks * 1000000000 / duration << " tasks/s, "
+              << thread_pool.GetStealCount() << " steals, "
+              << thread_pool.GetStealContentionCount() << " contended steals";
+  }
+}
+
 }  // namespace art
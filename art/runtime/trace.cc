@@ -74,6 +74,14 @@ namespace art {
 // 32 bits of microseconds is 70 minutes.
 //
 // All values are stored in little-endian order.
+//
+// Streaming traces (kTraceStreaming) have kTraceStreamingVersionFlag set in the version and no
+// text section before the header. Their records come straight after the header, grouped in
+// per-thread chunks but in order for each thread, and are followed by a trace summary:
+//     u2  0 (not a thread ID)
+//     u1  kTraceSummaryOp
+//     u4  length of the text
+//     ... the text section, "*version" through "*end"
 
 enum TraceAction {
     kTraceMethodEnter = 0x00,       // method entry
@@ -113,6 +121,8 @@ static const uint16_t kTraceVersionSingleClock    = 2;
 static const uint16_t kTraceVersionDualClock      = 3;
 static const uint16_t kTraceRecordSizeSingleClock = 10;  // using v2
 static const uint16_t kTraceRecordSizeDualClock   = 14;  // using v3 with two timestamps
+static const uint16_t kTraceStreamingVersionFlag  = 0xF0;
+static const uint8_t  kTraceSummaryOp             = 3;
 
 TraceClockSource Trace::default_clock_source_ = kDefaultTraceClockSource;
 
@@ -375,6 +385,11 @@ void Trace::Start(const char* trace_filename, int trace_fd, int buffer_size, int
     } else {
       enable_stats = (flags && kTraceCountAllocs) != 0;
       the_trace_ = new Trace(trace_file.release(), buffer_size, flags, sampling_enabled);
+      if (the_trace_->streaming_) {
+        CHECK_PTHREAD_CALL(pthread_create, (&the_trace_->writer_pthread_, NULL, &RunWriterThread,
+                                            the_trace_),
+                                            "Method trace writer thread");
+      }
       if (sampling_enabled) {
         CHECK_PTHREAD_CALL(pthread_create, (&sampling_pthread_, NULL, &RunSamplingThread,
                                             reinterpret_cast<void*>(interval_us)),
@@ -400,11 +415,12 @@ void Trace::Start(const char* trace_filename, int trace_fd, int buffer_size, int
 void Trace::Stop() {
   bool stop_alloc_counting = false;
   Runtime* runtime = Runtime::Current();
+  Thread* self = Thread::Current();
   runtime->GetThreadList()->SuspendAll();
   Trace* the_trace = NULL;
   pthread_t sampling_pthread = 0U;
   {
-    MutexLock mu(Thread::Current(), *Locks::trace_lock_);
+    MutexLock mu(self, *Locks::trace_lock_);
     if (the_trace_ == NULL) {
       LOG(ERROR) << "Trace stop requested, but no trace currently running";
     } else {
@@ -413,42 +429,60 @@ void Trace::Stop() {
       sampling_pthread = sampling_pthread_;
     }
   }
-  if (the_trace != NULL) {
-    stop_alloc_counting = (the_trace->flags_ & kTraceCountAllocs) != 0;
-    the_trace->FinishTracing();
+  if (the_trace != NULL && !the_trace->sampling_enabled_) {
+    runtime->GetInstrumentation()->DisableMethodTracing();
+    runtime->GetInstrumentation()->RemoveListener(the_trace,
+                                                  instrumentation::Instrumentation::kMethodEntered |
+                                                  instrumentation::Instrumentation::kMethodExited |
+                                                  instrumentation::Instrumentation::kMethodUnwind);
+  }
+  runtime->GetThreadList()->ResumeAll();
+
+  // The sampling thread may still be taking a last sample.
+  if (sampling_pthread != 0U) {
+    CHECK_PTHREAD_CALL(pthread_join, (sampling_pthread, NULL), "sampling thread shutdown");
+    sampling_pthread_ = 0U;
+  }
+  if (the_trace == NULL) {
+    return;
+  }
+  stop_alloc_counting = (the_trace->flags_ & kTraceCountAllocs) != 0;
 
+  // Nothing adds to the per-thread buffers any more, collect what is left in them.
+  runtime->GetThreadList()->SuspendAll();
+  {
+    MutexLock mu(self, *Locks::thread_list_lock_);
+    runtime->GetThreadList()->ForEach(FlushThreadBuffer, the_trace);
     if (the_trace->sampling_enabled_) {
-      MutexLock mu(Thread::Current(), *Locks::thread_list_lock_);
       runtime->GetThreadList()->ForEach(ClearThreadStackTraceAndClockBase, NULL);
-    } else {
-      runtime->GetInstrumentation()->DisableMethodTracing();
-      runtime->GetInstrumentation()->RemoveListener(the_trace,
-                                                    instrumentation::Instrumentation::kMethodEntered |
-                                                    instrumentation::Instrumentation::kMethodExited |
-                                                    instrumentation::Instrumentation::kMethodUnwind);
     }
-    if (the_trace->trace_file_.get() != nullptr) {
-      // Do not try to erase, so flush and close explicitly.
-      if (the_trace->trace_file_->Flush() != 0) {
-        PLOG(ERROR) << "Could not flush trace file.";
-      }
-      if (the_trace->trace_file_->Close() != 0) {
-        PLOG(ERROR) << "Could not close trace file.";
-      }
-    }
-    delete the_trace;
+  }
+  if (!the_trace->streaming_) {
+    the_trace->FinishTracing();
   }
   runtime->GetThreadList()->ResumeAll();
 
+  if (the_trace->streaming_) {
+    // The writer thread needs to run to drain the queue, so this happens with threads running.
+    the_trace->StopWriterThread(self);
+    ScopedObjectAccess soa(self);
+    the_trace->FinishTracing();
+  }
+  if (the_trace->trace_file_.get() != nullptr) {
+    // Do not try to erase, so flush and close explicitly.
+    if (the_trace->trace_file_->Flush() != 0) {
+      PLOG(ERROR) << "Could not flush trace file.";
+    }
+    if (the_trace->trace_file_->Close() != 0) {
+      PLOG(ERROR) << "Could not close trace file.";
+    }
+  }
+  delete the_trace;
+
   if (stop_alloc_counting) {
     // Can be racy since SetStatsEnabled is not guarded by any locks.
     Runtime::Current()->SetStatsEnabled(false);
   }
-
-  if (sampling_pthread != 0U) {
-    CHECK_PTHREAD_CALL(pthread_join, (sampling_pthread, NULL), "sampling thread shutdown");
-    sampling_pthread_ = 0U;
-  }
 }
 
 void Trace::Shutdown() {
@@ -469,24 +503,149 @@ TracingMode Trace::GetMethodTracingMode() {
 }
 
 Trace::Trace(File* trace_file, int buffer_size, int flags, bool sampling_enabled)
-    : trace_file_(trace_file), buf_(new uint8_t[buffer_size]()), flags_(flags),
+    : trace_file_(trace_file), flags_(flags),
+      streaming_((flags & kTraceStreaming) != 0 && trace_file != nullptr),
+      buf_(streaming_ ? nullptr : new uint8_t[buffer_size]()),
       sampling_enabled_(sampling_enabled), clock_source_(default_clock_source_),
       buffer_size_(buffer_size), start_time_(MicroTime()),
-      clock_overhead_ns_(GetClockOverheadNanoSeconds()), cur_offset_(0), overflow_(false) {
+      clock_overhead_ns_(GetClockOverheadNanoSeconds()),
+      buffer_lock_("trace buffer lock"),
+      pending_cond_("trace buffer pending condition", buffer_lock_),
+      drained_cond_("trace buffer drained condition", buffer_lock_),
+      stopping_(false), cur_offset_(0), overflow_(false), writer_pthread_(0U),
+      streamed_records_(0), stream_error_(false) {
   // Set up the beginning of the trace.
   uint16_t trace_version = GetTraceVersion(clock_source_);
-  memset(buf_.get(), 0, kTraceHeaderLength);
-  Append4LE(buf_.get(), kTraceMagicValue);
-  Append2LE(buf_.get() + 4, trace_version);
-  Append2LE(buf_.get() + 6, kTraceHeaderLength);
-  Append8LE(buf_.get() + 8, start_time_);
+  uint8_t header[kTraceHeaderLength];
+  memset(header, 0, kTraceHeaderLength);
+  Append4LE(header, kTraceMagicValue);
+  Append2LE(header + 4, streaming_ ? trace_version | kTraceStreamingVersionFlag : trace_version);
+  Append2LE(header + 6, kTraceHeaderLength);
+  Append8LE(header + 8, start_time_);
   if (trace_version >= kTraceVersionDualClock) {
     uint16_t record_size = GetRecordSize(clock_source_);
-    Append2LE(buf_.get() + 16, record_size);
+    Append2LE(header + 16, record_size);
+  }
+
+  if (streaming_) {
+    if (!trace_file_->WriteFully(header, kTraceHeaderLength)) {
+      PLOG(ERROR) << "Trace header write failed";
+      stream_error_ = true;
+    }
+  } else {
+    memcpy(buf_.get(), header, kTraceHeaderLength);
+    // Update current offset.
+    cur_offset_ = kTraceHeaderLength;
   }
+}
 
-  // Update current offset.
-  cur_offset_.StoreRelaxed(kTraceHeaderLength);
+Trace::~Trace() {
+  STLDeleteElements(&full_buffers_);
+  STLDeleteElements(&free_buffers_);
+}
+
+void* Trace::RunWriterThread(void* arg) {
+  Runtime* runtime = Runtime::Current();
+  CHECK(runtime->AttachCurrentThread("Method trace writer", true, runtime->GetSystemThreadGroup(),
+                                     !runtime->IsCompiler()));
+  reinterpret_cast<Trace*>(arg)->WriteBuffers(Thread::Current());
+  runtime->DetachCurrentThread();
+  return NULL;
+}
+
+void Trace::WriteBuffers(Thread* self) {
+  const size_t record_size = GetRecordSize(clock_source_);
+  MethodTraceBuffer* written = nullptr;
+  while (true) {
+    MethodTraceBuffer* buffer;
+    {
+      MutexLock mu(self, buffer_lock_);
+      if (written != nullptr) {
+        free_buffers_.push_back(written);
+      }
+      while (full_buffers_.empty() && !stopping_) {
+        pending_cond_.Wait(self);
+      }
+      if (full_buffers_.empty()) {
+        break;
+      }
+      buffer = full_buffers_.front();
+      full_buffers_.pop_front();
+      drained_cond_.Broadcast(self);
+    }
+    for (size_t offset = 0; offset < buffer->size; offset += record_size) {
+      const uint8_t* ptr = buffer->data + offset;
+      uint32_t tmid = ptr[2] | (ptr[3] << 8) | (ptr[4] << 16) | (ptr[5] << 24);
+      streamed_methods_.insert(DecodeTraceMethodId(tmid));
+    }
+    streamed_records_ += buffer->size / record_size;
+    if (!stream_error_ && !trace_file_->WriteFully(buffer->data, buffer->size)) {
+      PLOG(ERROR) << "Trace data write failed";
+      stream_error_ = true;
+    }
+    written = buffer;
+  }
+}
+
+void Trace::StopWriterThread(Thread* self) {
+  {
+    MutexLock mu(self, buffer_lock_);
+    stopping_ = true;
+    pending_cond_.Signal(self);
+  }
+  CHECK_PTHREAD_CALL(pthread_join, (writer_pthread_, NULL), "method trace writer thread shutdown");
+  writer_pthread_ = 0U;
+}
+
+void Trace::FlushThreadBuffer(Thread* thread, void* arg) {
+  reinterpret_cast<Trace*>(arg)->SwapThreadBuffer(thread, false);
+}
+
+MethodTraceBuffer* Trace::SwapThreadBuffer(Thread* thread, bool replace) {
+  MethodTraceBuffer* buffer = thread->GetMethodTraceBuffer();
+  if (buffer == nullptr && !replace) {
+    return nullptr;
+  }
+  Thread* self = Thread::Current();
+  MutexLock mu(self, buffer_lock_);
+  if (buffer != nullptr) {
+    HandOverLocked(self, buffer);
+  }
+  buffer = nullptr;
+  if (replace) {
+    if (free_buffers_.empty()) {
+      buffer = new MethodTraceBuffer();
+    } else {
+      buffer = free_buffers_.back();
+      free_buffers_.pop_back();
+      buffer->size = 0;
+    }
+  }
+  thread->SetMethodTraceBuffer(buffer);
+  return buffer;
+}
+
+void Trace::HandOverLocked(Thread* self, MethodTraceBuffer* buffer) {
+  if (streaming_) {
+    // Don't let a slow trace file make us buffer without bounds. The writer thread doesn't need
+    // the mutator lock, so it is fine to hold it while we wait.
+    while (full_buffers_.size() >= kMaxPendingBuffers) {
+      drained_cond_.WaitHoldingLocks(self);
+    }
+    full_buffers_.push_back(buffer);
+    pending_cond_.Signal(self);
+    return;
+  }
+  const size_t record_size = GetRecordSize(clock_source_);
+  size_t size = buffer->size;
+  const size_t room = buffer_size_ - cur_offset_;
+  if (size > room) {
+    size = room - room % record_size;
+    overflow_ = true;
+  }
+  memcpy(buf_.get() + cur_offset_, buffer->data, size);
+  cur_offset_ += size;
+  free_buffers_.push_back(buffer);
 }
 
 static void DumpBuf(uint8_t* buf, size_t buf_size, TraceClockSource clock_source)
@@ -507,16 +666,29 @@ void Trace::FinishTracing() {
   // Compute elapsed time.
   uint64_t elapsed = MicroTime() - start_time_;
 
-  size_t final_offset = cur_offset_.LoadRelaxed();
+  size_t final_offset;
+  bool overflow;
+  {
+    MutexLock mu(Thread::Current(), buffer_lock_);
+    final_offset = cur_offset_;
+    overflow = overflow_;
+  }
 
   std::set<mirror::ArtMethod*> visited_methods;
-  GetVisitedMethods(final_offset, &visited_methods);
+  size_t num_records;
+  if (streaming_) {
+    visited_methods.swap(streamed_methods_);
+    num_records = streamed_records_;
+  } else {
+    GetVisitedMethods(final_offset, &visited_methods);
+    num_records = (final_offset - kTraceHeaderLength) / GetRecordSize(clock_source_);
+  }
 
   std::ostringstream os;
 
   os << StringPrintf("%cversion\n", kTraceTokenChar);
   os << StringPrintf("%d\n", GetTraceVersion(clock_source_));
-  os << StringPrintf("data-file-overflow=%s\n", overflow_ ? "true" : "false");
+  os << StringPrintf("data-file-overflow=%s\n", overflow ? "true" : "false");
   if (UseThreadCpuClock()) {
     if (UseWallClock()) {
       os << StringPrintf("clock=dual\n");
@@ -527,7 +699,6 @@ void Trace::FinishTracing() {
     os << StringPrintf("clock=wall\n");
   }
   os << StringPrintf("elapsed-time-usec=%" PRIu64 "\n", elapsed);
-  size_t num_records = (final_offset - kTraceHeaderLength) / GetRecordSize(clock_source_);
   os << StringPrintf("num-method-calls=%zd\n", num_records);
   os << StringPrintf("clock-call-overhead-nsec=%d\n", clock_overhead_ns_);
   os << StringPrintf("vm=art\n");
@@ -543,7 +714,18 @@ void Trace::FinishTracing() {
   os << StringPrintf("%cend\n", kTraceTokenChar);
 
   std::string header(os.str());
-  if (trace_file_.get() == NULL) {
+  if (streaming_) {
+    uint8_t summary[7];
+    Append2LE(summary, 0);
+    summary[2] = kTraceSummaryOp;
+    Append4LE(summary + 3, header.length());
+    if (stream_error_ || !trace_file_->WriteFully(summary, sizeof(summary)) ||
+        !trace_file_->WriteFully(header.c_str(), header.length())) {
+      std::string detail(StringPrintf("Trace data write failed: %s", strerror(errno)));
+      PLOG(ERROR) << detail;
+      ThrowRuntimeException("%s", detail.c_str());
+    }
+  } else if (trace_file_.get() == NULL) {
     iovec iov[2];
     iov[0].iov_base = reinterpret_cast<void*>(const_cast<char*>(header.c_str()));
     iov[0].iov_len = header.length();
@@ -641,17 +823,14 @@ void Trace::ReadClocks(Thread* thread, uint32_t* thread_clock_diff, uint32_t* wa
 void Trace::LogMethodTraceEvent(Thread* thread, mirror::ArtMethod* method,
                                 instrumentation::Instrumentation::InstrumentationEvent event,
                                 uint32_t thread_clock_diff, uint32_t wall_clock_diff) {
-  // Advance cur_offset_ atomically.
-  int32_t new_offset;
-  int32_t old_offset;
-  do {
-    old_offset = cur_offset_.LoadRelaxed();
-    new_offset = old_offset + GetRecordSize(clock_source_);
-    if (new_offset > buffer_size_) {
-      overflow_ = true;
-      return;
-    }
-  } while (!cur_offset_.CompareExchangeWeakSequentiallyConsistent(old_offset, new_offset));
+  // Append to the thread's own buffer, handing it over once full.
+  const size_t record_size = GetRecordSize(clock_source_);
+  MethodTraceBuffer* buffer = thread->GetMethodTraceBuffer();
+  if (UNLIKELY(buffer == nullptr || buffer->size + record_size > MethodTraceBuffer::kCapacity)) {
+    buffer = SwapThreadBuffer(thread, true);
+  }
+  uint8_t* ptr = buffer->data + buffer->size;
+  buffer->size += record_size;
 
   TraceAction action = kTraceMethodEnter;
   switch (event) {
@@ -671,7 +850,6 @@ void Trace::LogMethodTraceEvent(Thread* thread, mirror::ArtMethod* method,
   uint32_t method_value = EncodeTraceMethodAndAction(method, action);
 
   // Write data
-  uint8_t* ptr = buf_.get() + old_offset;
   Append2LE(ptr, thread->GetTid());
   Append4LE(ptr + 2, method_value);
   ptr += 6;
@@ -729,6 +907,7 @@ void Trace::StoreExitingThreadInfo(Thread* thread) {
     std::string name;
     thread->GetThreadName(name);
     the_trace_->exited_threads_.Put(thread->GetTid(), name);
+    the_trace_->SwapThreadBuffer(thread, false);
   }
 }
 
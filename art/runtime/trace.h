@@ -17,6 +17,7 @@
 #ifndef ART_RUNTIME_TRACE_H_
 #define ART_RUNTIME_TRACE_H_
 
+#include <deque>
 #include <memory>
 #include <ostream>
 #include <set>
@@ -25,6 +26,7 @@
 
 #include "atomic.h"
 #include "base/macros.h"
+#include "base/mutex.h"
 #include "globals.h"
 #include "instrumentation.h"
 #include "os.h"
@@ -45,10 +47,24 @@ enum TracingMode {
   kSampleProfilingActive,
 };
 
+// Trace records of a single thread. Only the owning thread appends to it, or the sampling thread
+// while the owner is suspended, until it fills up and is handed over to the trace.
+struct MethodTraceBuffer {
+  static constexpr size_t kCapacity = 32 * KB;
+
+  MethodTraceBuffer() : size(0) {}
+
+  size_t size;
+  uint8_t data[kCapacity];
+};
+
 class Trace FINAL : public instrumentation::InstrumentationListener {
  public:
   enum TraceFlag {
     kTraceCountAllocs = 1,
+    // Stream the records to the trace file as they are produced instead of collecting them in a
+    // buffer of buffer_size bytes. Ignored when tracing to DDMS.
+    kTraceStreaming = 2,
   };
 
   static void SetDefaultClockSource(TraceClockSource clock_source);
@@ -108,11 +124,28 @@ class Trace FINAL : public instrumentation::InstrumentationListener {
   static void StoreExitingThreadInfo(Thread* thread);
 
  private:
+  // When streaming, at most this many full buffers wait for the writer thread before the threads
+  // producing them block.
+  static constexpr size_t kMaxPendingBuffers = 64;
+
   explicit Trace(File* trace_file, int buffer_size, int flags, bool sampling_enabled);
+  ~Trace();
 
   // The sampling interval in microseconds is passed as an argument.
   static void* RunSamplingThread(void* arg) LOCKS_EXCLUDED(Locks::trace_lock_);
 
+  // Writes the full buffers to the trace file until the trace is stopped.
+  static void* RunWriterThread(void* arg);
+  void WriteBuffers(Thread* self) LOCKS_EXCLUDED(buffer_lock_);
+  void StopWriterThread(Thread* self) LOCKS_EXCLUDED(buffer_lock_);
+
+  // Hands over "thread"'s buffer, if it has one, and gives it an empty one if "replace".
+  static void FlushThreadBuffer(Thread* thread, void* arg) LOCKS_EXCLUDED(buffer_lock_);
+  MethodTraceBuffer* SwapThreadBuffer(Thread* thread, bool replace) LOCKS_EXCLUDED(buffer_lock_);
+  // Queues "buffer" for the writer thread, or copies it to buf_ when not streaming.
+  void HandOverLocked(Thread* self, MethodTraceBuffer* buffer)
+      EXCLUSIVE_LOCKS_REQUIRED(buffer_lock_);
+
   void FinishTracing() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
   void ReadClocks(Thread* thread, uint32_t* thread_clock_diff, uint32_t* wall_clock_diff);
@@ -142,12 +175,16 @@ class Trace FINAL : public instrumentation::InstrumentationListener {
   // File to write trace data out to, NULL if direct to ddms.
   std::unique_ptr<File> trace_file_;
 
-  // Buffer to store trace data.
-  std::unique_ptr<uint8_t> buf_;
-
   // Flags enabling extra tracing of things such as alloc counts.
   const int flags_;
 
+  // True if the records are streamed to trace_file_ by the writer thread, rather than collected
+  // in buf_.
+  const bool streaming_;
+
+  // Buffer to store trace data, unless streaming.
+  std::unique_ptr<uint8_t[]> buf_;
+
   // True if traceview should sample instead of instrumenting method entry/exit.
   const bool sampling_enabled_;
 
@@ -162,11 +199,29 @@ class Trace FINAL : public instrumentation::InstrumentationListener {
   // Clock overhead.
   const uint32_t clock_overhead_ns_;
 
+  // Guards the buffer lists and, unless streaming, buf_.
+  Mutex buffer_lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
+  // Signaled when a full buffer is queued for the writer thread, or the trace stops.
+  ConditionVariable pending_cond_ GUARDED_BY(buffer_lock_);
+  // Signaled when the writer thread takes a full buffer off the queue.
+  ConditionVariable drained_cond_ GUARDED_BY(buffer_lock_);
+  std::deque<MethodTraceBuffer*> full_buffers_ GUARDED_BY(buffer_lock_);
+  std::vector<MethodTraceBuffer*> free_buffers_ GUARDED_BY(buffer_lock_);
+  bool stopping_ GUARDED_BY(buffer_lock_);
+
   // Offset into buf_.
-  AtomicInteger cur_offset_;
+  size_t cur_offset_ GUARDED_BY(buffer_lock_);
 
   // Did we overflow the buffer recording traces?
-  bool overflow_;
+  bool overflow_ GUARDED_BY(buffer_lock_);
+
+  // Writer thread, non-zero when streaming.
+  pthread_t writer_pthread_;
+
+  // Owned by the writer thread until it is joined.
+  std::set<mirror::ArtMethod*> streamed_methods_;
+  size_t streamed_records_;
+  bool stream_error_;
 
   // Map of thread ids and names that have already exited.
   SafeMap<pid_t, std::string> exited_threads_;
@@ -0,0 +1,154 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "trace.h"
+
+#include <string>
+
+#include "base/stringprintf.h"
+#include "base/unix_file/fd_file.h"
+#include "class_linker.h"
+#include "common_runtime_test.h"
+#include "instrumentation.h"
+#include "mirror/art_method-inl.h"
+#include "mirror/class-inl.h"
+#include "os.h"
+#include "scoped_thread_state_change.h"
+#include "thread_pool.h"
+
+namespace art {
+
+class TraceTest : public CommonRuntimeTest {
+ protected:
+  mirror::ArtMethod* GetTracedMethod() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+    mirror::Class* c = class_linker_->FindSystemClass(Thread::Current(), "Ljava/lang/Object;");
+    CHECK(c != nullptr);
+    return c->GetVirtualMethod(0);
+  }
+
+  // Has "threads" threads each report "calls" method entries and exits to the instrumentation.
+  // Returns the time it took.
+  uint64_t GenerateEvents(size_t threads, size_t calls);
+
+  static std::string ReadFile(const std::string& filename) {
+    std::unique_ptr<File> file(OS::OpenFileForReading(filename.c_str()));
+    CHECK(file.get() != nullptr) << filename;
+    std::string contents(file->GetLength(), '\0');
+    CHECK(file->ReadFully(&contents[0], contents.size()));
+    return contents;
+  }
+};
+
+class CallTask : public Task {
+ public:
+  CallTask(mirror::ArtMethod* method, size_t calls) : method_(method), calls_(calls) {}
+
+  void Run(Thread* self) {
+    ScopedObjectAccess soa(self);
+    instrumentation::Instrumentation* instrumentation = Runtime::Current()->GetInstrumentation();
+    JValue result;
+    for (size_t i = 0; i < calls_; ++i) {
+      instrumentation->MethodEnterEvent(self, nullptr, method_, 0);
+      instrumentation->MethodExitEvent(self, nullptr, method_, 0, result);
+    }
+  }
+
+  void Finalize() {
+    delete this;
+  }
+
+ private:
+  mirror::ArtMethod* const method_;
+  const size_t calls_;
+};
+
+uint64_t TraceTest::GenerateEvents(size_t threads, size_t calls) {
+  Thread* self = Thread::Current();
+  mirror::ArtMethod* method;
+  {
+    ScopedObjectAccess soa(self);
+    method = GetTracedMethod();
+  }
+  ThreadPool thread_pool("Trace test thread pool", threads);
+  for (size_t i = 0; i < threads; ++i) {
+    thread_pool.AddTask(self, new CallTask(method, calls));
+  }
+  const uint64_t start = NanoTime();
+  thread_pool.StartWorkers(self);
+  thread_pool.Wait(self, true, false);
+  return NanoTime() - start;
+}
+
+// Many more records than a per-thread buffer holds all make it to the streamed file.
+TEST_F(TraceTest, Streaming) {
+  static const size_t kThreads = 4;
+  static const size_t kCalls = 20000;
+  ScratchFile trace_file;
+  Trace::Start(trace_file.GetFilename().c_str(), -1, 0, Trace::kTraceStreaming, false, false, 0);
+  ASSERT_EQ(kMethodTracingActive, Trace::GetMethodTracingMode());
+  GenerateEvents(kThreads, kCalls);
+  Trace::Stop();
+  ASSERT_EQ(kTracingInactive, Trace::GetMethodTracingMode());
+
+  const std::string contents = ReadFile(trace_file.GetFilename());
+  ASSERT_GE(contents.size(), 32U);
+  EXPECT_EQ("SLOW", contents.substr(0, 4));
+  EXPECT_EQ(0xF0, static_cast<uint8_t>(contents[4]) & 0xF0);
+  // The summary comes last. Other threads, such as the thread pool's, may add a few calls.
+  size_t version = contents.find("*version\n");
+  ASSERT_NE(std::string::npos, version);
+  EXPECT_EQ(contents.size() - 5, contents.rfind("*end\n"));
+  size_t calls_line = contents.find("num-method-calls=", version);
+  ASSERT_NE(std::string::npos, calls_line);
+  size_t num_calls = strtoul(contents.c_str() + calls_line + strlen("num-method-calls="),
+                             nullptr, 10);
+  EXPECT_LE(2 * kThreads * kCalls, num_calls);
+}
+
+// A trace collected in memory stops recording when its buffer is full.
+TEST_F(TraceTest, Overflow) {
+  ScratchFile trace_file;
+  Trace::Start(trace_file.GetFilename().c_str(), -1, 4 * KB, 0, false, false, 0);
+  GenerateEvents(2, 10000);
+  Trace::Stop();
+
+  const std::string contents = ReadFile(trace_file.GetFilename());
+  EXPECT_EQ(0U, contents.find("*version\n"));
+  EXPECT_NE(std::string::npos, contents.find("data-file-overflow=true\n"));
+}
+
+// Method entry and exit event throughput with tracing off, streaming and collecting in memory.
+TEST_F(TraceTest, DISABLED_TraceOverhead) {
+  static const size_t kCalls = 1000000;
+  for (int mode = 0; mode < 3; ++mode) {
+    for (size_t threads = 1; threads <= 8; threads *= 2) {
+      ScratchFile trace_file;
+      if (mode != 0) {
+        Trace::Start(trace_file.GetFilename().c_str(), -1, 256 * MB,
+                     mode == 1 ? Trace::kTraceStreaming : 0, false, false, 0);
+      }
+      const uint64_t duration = GenerateEvents(threads, kCalls);
+      if (mode != 0) {
+        Trace::Stop();
+      }
+      const uint64_t events = 2 * static_cast<uint64_t>(threads) * kCalls;
+      LOG(INFO) << (mode == 0 ? "untraced" : (mode == 1 ? "streaming" : "in memory")) << ", "
+                << threads << " threads: " << events * 1000000000 / duration << " events/s";
+    }
+  }
+}
+
+}  // namespace art
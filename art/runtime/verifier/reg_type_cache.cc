@@ -17,6 +17,7 @@
 #include "reg_type_cache-inl.h"
 
 #include "base/casts.h"
+#include "base/stl_util.h"
 #include "class_linker-inl.h"
 #include "dex_file-inl.h"
 #include "mirror/class-inl.h"
@@ -138,21 +139,37 @@ bool RegTypeCache::MatchDescriptor(size_t idx, const StringPiece& descriptor, bo
 
 mirror::Class* RegTypeCache::ResolveClass(const char* descriptor, mirror::ClassLoader* loader) {
   // Class was not found, must create new type.
-  // Try resolving class
+  // Try resolving class, unless another method of the class loader already did.
+  const size_t hash = ComputeModifiedUtf8Hash(descriptor);
+  SharedRegTypeCache* shared_cache = SharedRegTypeCache::ForClassLoader(loader);
+  mirror::Class* klass = NULL;
+  if (shared_cache != nullptr && shared_cache->Find(descriptor, hash, &klass)) {
+    return klass;
+  }
   ClassLinker* class_linker = Runtime::Current()->GetClassLinker();
   Thread* self = Thread::Current();
   StackHandleScope<1> hs(self);
   Handle<mirror::ClassLoader> class_loader(hs.NewHandle(loader));
-  mirror::Class* klass = NULL;
   if (can_load_classes_) {
     klass = class_linker->FindClass(self, descriptor, class_loader);
+    if (klass == NULL) {
+      // We tried loading the class and failed, this might get an exception raised
+      // so we want to clear it before we go on.
+      DCHECK(self->IsExceptionPending());
+      self->ClearException();
+    }
   } else {
-    klass = class_linker->LookupClass(descriptor, ComputeModifiedUtf8Hash(descriptor), loader);
+    klass = class_linker->LookupClass(descriptor, hash, loader);
     if (klass != nullptr && !klass->IsLoaded()) {
       // We found the class but without it being loaded its not safe for use.
       klass = nullptr;
     }
   }
+  // A class that isn't resolved yet may still be replaced or fail to link, and one that isn't
+  // loaded yet may still be loaded, by another thread.
+  if (shared_cache != nullptr && (klass != nullptr ? klass->IsResolved() : can_load_classes_)) {
+    shared_cache->Add(descriptor, hash, klass);
+  }
   return klass;
 }
 
@@ -183,23 +200,17 @@ RegType& RegTypeCache::From(mirror::ClassLoader* loader, const char* descriptor,
     if (klass->CannotBeAssignedFromOtherTypes() || precise) {
       DCHECK(!(klass->IsAbstract()) || klass->IsArrayClass());
       DCHECK(!klass->IsInterface());
-      entry = new PreciseReferenceType(klass, descriptor_sp.as_string(), entries_.size());
+      entry = NewEntry<PreciseReferenceType>(klass, descriptor_sp.as_string(), entries_.size());
     } else {
-      entry = new ReferenceType(klass, descriptor_sp.as_string(), entries_.size());
+      entry = NewEntry<ReferenceType>(klass, descriptor_sp.as_string(), entries_.size());
     }
     AddEntry(entry);
     return *entry;
   } else {  // Class not resolved.
-    // We tried loading the class and failed, this might get an exception raised
-    // so we want to clear it before we go on.
-    if (can_load_classes_) {
-      DCHECK(Thread::Current()->IsExceptionPending());
-      Thread::Current()->ClearException();
-    } else {
-      DCHECK(!Thread::Current()->IsExceptionPending());
-    }
+    DCHECK(!Thread::Current()->IsExceptionPending());
     if (IsValidDescriptor(descriptor)) {
-      RegType* entry = new UnresolvedReferenceType(descriptor_sp.as_string(), entries_.size());
+      RegType* entry = NewEntry<UnresolvedReferenceType>(descriptor_sp.as_string(),
+                                                         entries_.size());
       AddEntry(entry);
       return *entry;
     } else {
@@ -227,16 +238,17 @@ RegType& RegTypeCache::FromClass(const char* descriptor, mirror::Class* klass, b
     // No reference to the class was found, create new reference.
     RegType* entry;
     if (precise) {
-      entry = new PreciseReferenceType(klass, descriptor, entries_.size());
+      entry = NewEntry<PreciseReferenceType>(klass, descriptor, entries_.size());
     } else {
-      entry = new ReferenceType(klass, descriptor, entries_.size());
+      entry = NewEntry<ReferenceType>(klass, descriptor, entries_.size());
     }
     AddEntry(entry);
     return *entry;
   }
 }
 
-RegTypeCache::RegTypeCache(bool can_load_classes) : can_load_classes_(can_load_classes) {
+RegTypeCache::RegTypeCache(bool can_load_classes)
+    : chunk_pos_(nullptr), chunk_end_(nullptr), can_load_classes_(can_load_classes) {
   if (kIsDebugBuild && can_load_classes) {
     Thread::Current()->AssertThreadSuspensionIsAllowable();
   }
@@ -246,14 +258,23 @@ RegTypeCache::RegTypeCache(bool can_load_classes) : can_load_classes_(can_load_c
 
 RegTypeCache::~RegTypeCache() {
   CHECK_LE(primitive_count_, entries_.size());
-  // Delete only the non primitive types.
-  if (entries_.size() == kNumPrimitivesAndSmallConstants) {
-    // All entries are from the global pool, nothing to delete.
-    return;
+  // Destroy only the non primitive types, their memory is freed with the chunks.
+  for (size_t i = kNumPrimitivesAndSmallConstants; i < entries_.size(); ++i) {
+    entries_[i]->~RegType();
+  }
+}
+
+void* RegTypeCache::AllocateEntry(size_t size) {
+  size = RoundUp(size, kEntryAlignment);
+  if (UNLIKELY(static_cast<size_t>(chunk_end_ - chunk_pos_) < size)) {
+    const size_t chunk_size = std::max(size, static_cast<size_t>(kChunkSize));
+    chunks_.emplace_back(new uint8_t[chunk_size]);
+    chunk_pos_ = chunks_.back().get();
+    chunk_end_ = chunk_pos_ + chunk_size;
   }
-  std::vector<RegType*>::iterator non_primitive_begin = entries_.begin();
-  std::advance(non_primitive_begin, kNumPrimitivesAndSmallConstants);
-  STLDeleteContainerPointers(non_primitive_begin, entries_.end());
+  void* entry = chunk_pos_;
+  chunk_pos_ += size;
+  return entry;
 }
 
 void RegTypeCache::ShutDown() {
@@ -275,6 +296,7 @@ void RegTypeCache::ShutDown() {
       delete type;
       small_precise_constants_[value - kMinSmallConstant] = nullptr;
     }
+    SharedRegTypeCache::ShutDown();
     RegTypeCache::primitive_initialized_ = false;
     RegTypeCache::primitive_count_ = 0;
   }
@@ -338,7 +360,8 @@ RegType& RegTypeCache::FromUnresolvedMerge(RegType& left, RegType& right) {
     }
   }
   // Create entry.
-  RegType* entry = new UnresolvedMergedType(left.GetId(), right.GetId(), this, entries_.size());
+  RegType* entry = NewEntry<UnresolvedMergedType>(left.GetId(), right.GetId(), this,
+                                                  entries_.size());
   AddEntry(entry);
   if (kIsDebugBuild) {
     UnresolvedMergedType* tmp_entry = down_cast<UnresolvedMergedType*>(entry);
@@ -362,7 +385,7 @@ RegType& RegTypeCache::FromUnresolvedSuperClass(RegType& child) {
       }
     }
   }
-  RegType* entry = new UnresolvedSuperClass(child.GetId(), this, entries_.size());
+  RegType* entry = NewEntry<UnresolvedSuperClass>(child.GetId(), this, entries_.size());
   AddEntry(entry);
   return *entry;
 }
@@ -379,7 +402,7 @@ UninitializedType& RegTypeCache::Uninitialized(RegType& type, uint32_t allocatio
         return *down_cast<UnresolvedUninitializedRefType*>(cur_entry);
       }
     }
-    entry = new UnresolvedUninitializedRefType(descriptor, allocation_pc, entries_.size());
+    entry = NewEntry<UnresolvedUninitializedRefType>(descriptor, allocation_pc, entries_.size());
   } else {
     mirror::Class* klass = type.GetClass();
     for (size_t i = primitive_count_; i < entries_.size(); i++) {
@@ -391,7 +414,8 @@ UninitializedType& RegTypeCache::Uninitialized(RegType& type, uint32_t allocatio
         return *down_cast<UninitializedReferenceType*>(cur_entry);
       }
     }
-    entry = new UninitializedReferenceType(klass, descriptor, allocation_pc, entries_.size());
+    entry = NewEntry<UninitializedReferenceType>(klass, descriptor, allocation_pc,
+                                                 entries_.size());
   }
   AddEntry(entry);
   return *entry;
@@ -409,7 +433,7 @@ RegType& RegTypeCache::FromUninitialized(RegType& uninit_type) {
         return *cur_entry;
       }
     }
-    entry = new UnresolvedReferenceType(descriptor, entries_.size());
+    entry = NewEntry<UnresolvedReferenceType>(descriptor, entries_.size());
   } else {
     mirror::Class* klass = uninit_type.GetClass();
     if (uninit_type.IsUninitializedThisReference() && !klass->IsFinal()) {
@@ -420,7 +444,7 @@ RegType& RegTypeCache::FromUninitialized(RegType& uninit_type) {
           return *cur_entry;
         }
       }
-      entry = new ReferenceType(klass, "", entries_.size());
+      entry = NewEntry<ReferenceType>(klass, "", entries_.size());
     } else if (klass->IsInstantiable()) {
       // We're uninitialized because of allocation, look or create a precise type as allocations
       // may only create objects of that type.
@@ -430,7 +454,8 @@ RegType& RegTypeCache::FromUninitialized(RegType& uninit_type) {
           return *cur_entry;
         }
       }
-      entry = new PreciseReferenceType(klass, uninit_type.GetDescriptor(), entries_.size());
+      entry = NewEntry<PreciseReferenceType>(klass, uninit_type.GetDescriptor(),
+                                             entries_.size());
     } else {
       return Conflict();
     }
@@ -487,7 +512,7 @@ UninitializedType& RegTypeCache::UninitializedThisArgument(RegType& type) {
         return *down_cast<UninitializedType*>(cur_entry);
       }
     }
-    entry = new UnresolvedUninitializedThisRefType(descriptor, entries_.size());
+    entry = NewEntry<UnresolvedUninitializedThisRefType>(descriptor, entries_.size());
   } else {
     mirror::Class* klass = type.GetClass();
     for (size_t i = primitive_count_; i < entries_.size(); i++) {
@@ -496,7 +521,7 @@ UninitializedType& RegTypeCache::UninitializedThisArgument(RegType& type) {
         return *down_cast<UninitializedType*>(cur_entry);
       }
     }
-    entry = new UninitializedThisReferenceType(klass, descriptor, entries_.size());
+    entry = NewEntry<UninitializedThisReferenceType>(klass, descriptor, entries_.size());
   }
   AddEntry(entry);
   return *entry;
@@ -513,9 +538,9 @@ ConstantType& RegTypeCache::FromCat1NonSmallConstant(int32_t value, bool precise
   }
   ConstantType* entry;
   if (precise) {
-    entry = new PreciseConstType(value, entries_.size());
+    entry = NewEntry<PreciseConstType>(value, entries_.size());
   } else {
-    entry = new ImpreciseConstType(value, entries_.size());
+    entry = NewEntry<ImpreciseConstType>(value, entries_.size());
   }
   AddEntry(entry);
   return *entry;
@@ -531,9 +556,9 @@ ConstantType& RegTypeCache::FromCat2ConstLo(int32_t value, bool precise) {
   }
   ConstantType* entry;
   if (precise) {
-    entry = new PreciseConstLoType(value, entries_.size());
+    entry = NewEntry<PreciseConstLoType>(value, entries_.size());
   } else {
-    entry = new ImpreciseConstLoType(value, entries_.size());
+    entry = NewEntry<ImpreciseConstLoType>(value, entries_.size());
   }
   AddEntry(entry);
   return *entry;
@@ -549,9 +574,9 @@ ConstantType& RegTypeCache::FromCat2ConstHi(int32_t value, bool precise) {
   }
   ConstantType* entry;
   if (precise) {
-    entry = new PreciseConstHiType(value, entries_.size());
+    entry = NewEntry<PreciseConstHiType>(value, entries_.size());
   } else {
-    entry = new ImpreciseConstHiType(value, entries_.size());
+    entry = NewEntry<ImpreciseConstHiType>(value, entries_.size());
   }
   AddEntry(entry);
   return *entry;
@@ -592,6 +617,7 @@ void RegTypeCache::VisitStaticRoots(RootCallback* callback, void* arg) {
   // Visit the primitive types, this is required since if there are no active verifiers they wont
   // be in the entries array, and therefore not visited as roots.
   if (primitive_initialized_) {
+    SharedRegTypeCache::VisitRoots(callback, arg);
     Undefined().VisitRoots(callback, arg);
     Conflict().VisitRoots(callback, arg);
     Boolean().VisitRoots(callback, arg);
@@ -620,5 +646,87 @@ void RegTypeCache::AddEntry(RegType* new_entry) {
   entries_.push_back(new_entry);
 }
 
+ReaderWriterMutex* SharedRegTypeCache::caches_lock_ = nullptr;
+std::vector<SharedRegTypeCache*>* SharedRegTypeCache::caches_ = nullptr;
+
+SharedRegTypeCache::SharedRegTypeCache(mirror::ClassLoader* class_loader)
+    : class_loader_(class_loader), lock_("verifier shared reg type cache lock") {
+}
+
+void SharedRegTypeCache::Init() {
+  CHECK(caches_lock_ == nullptr);
+  caches_lock_ = new ReaderWriterMutex("verifier shared reg type caches lock");
+  caches_ = new std::vector<SharedRegTypeCache*>;
+}
+
+void SharedRegTypeCache::ShutDown() {
+  STLDeleteElements(caches_);
+  delete caches_;
+  caches_ = nullptr;
+  delete caches_lock_;
+  caches_lock_ = nullptr;
+}
+
+SharedRegTypeCache* SharedRegTypeCache::ForClassLoader(mirror::ClassLoader* class_loader) {
+  if (!Runtime::Current()->IsCompiler()) {
+    return nullptr;
+  }
+  Thread* self = Thread::Current();
+  {
+    ReaderMutexLock mu(self, *caches_lock_);
+    for (SharedRegTypeCache* cache : *caches_) {
+      if (cache->class_loader_.Read() == class_loader) {
+        return cache;
+      }
+    }
+  }
+  WriterMutexLock mu(self, *caches_lock_);
+  // Another thread may have added the cache in the meantime.
+  for (SharedRegTypeCache* cache : *caches_) {
+    if (cache->class_loader_.Read() == class_loader) {
+      return cache;
+    }
+  }
+  SharedRegTypeCache* cache = new SharedRegTypeCache(class_loader);
+  caches_->push_back(cache);
+  return cache;
+}
+
+bool SharedRegTypeCache::Find(const char* descriptor, size_t hash, mirror::Class** klass) {
+  DCHECK_EQ(ComputeModifiedUtf8Hash(descriptor), hash);
+  ReaderMutexLock mu(Thread::Current(), lock_);
+  auto it = classes_.FindWithHash(descriptor, hash);
+  if (it == classes_.end()) {
+    return false;
+  }
+  *klass = it->second.Read();
+  return true;
+}
+
+void SharedRegTypeCache::Add(const char* descriptor, size_t hash, mirror::Class* klass) {
+  WriterMutexLock mu(Thread::Current(), lock_);
+  if (classes_.FindWithHash(descriptor, hash) == classes_.end()) {
+    descriptors_.push_back(descriptor);
+    classes_.InsertWithHash(std::make_pair(descriptors_.back().c_str(),
+                                           GcRoot<mirror::Class>(klass)), hash);
+  }
+}
+
+void SharedRegTypeCache::VisitRoots(RootCallback* callback, void* arg) {
+  std::vector<SharedRegTypeCache*> caches;
+  Thread* self = Thread::Current();
+  {
+    ReaderMutexLock mu(self, *caches_lock_);
+    caches = *caches_;
+  }
+  for (SharedRegTypeCache* cache : caches) {
+    cache->class_loader_.VisitRootIfNonNull(callback, arg, RootInfo(kRootUnknown));
+    ReaderMutexLock mu(self, cache->lock_);
+    for (auto& pair : cache->classes_) {
+      pair.second.VisitRootIfNonNull(callback, arg, RootInfo(kRootUnknown));
+    }
+  }
+}
+
 }  // namespace verifier
 }  // namespace art
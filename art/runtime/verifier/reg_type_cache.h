@@ -18,13 +18,21 @@
 #define ART_RUNTIME_VERIFIER_REG_TYPE_CACHE_H_
 
 #include "base/casts.h"
+#include "base/hash_map.h"
 #include "base/macros.h"
+#include "base/mutex.h"
 #include "base/stl_util.h"
+#include "gc_root.h"
 #include "object_callbacks.h"
 #include "reg_type.h"
 #include "runtime.h"
+#include "utf.h"
 
 #include <stdint.h>
+#include <deque>
+#include <memory>
+#include <string>
+#include <utility>
 #include <vector>
 
 namespace art {
@@ -38,6 +46,70 @@ namespace verifier {
 
 class RegType;
 
+// The classes that descriptors resolved to, or didn't, when verifying the methods of a class
+// loader. Shared by the RegTypeCaches of all verifying threads, so that each method doesn't look
+// the same classes up again. Only used when compiling, where the classes a class loader defines
+// don't change.
+class SharedRegTypeCache {
+ public:
+  static void Init();
+  static void ShutDown();
+
+  // Returns the cache of the class loader, or nullptr if caches aren't shared.
+  static SharedRegTypeCache* ForClassLoader(mirror::ClassLoader* class_loader)
+      LOCKS_EXCLUDED(caches_lock_)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Returns true if the descriptor was looked up before, setting klass to the class it resolved
+  // to or nullptr.
+  bool Find(const char* descriptor, size_t hash, mirror::Class** klass)
+      LOCKS_EXCLUDED(lock_)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  void Add(const char* descriptor, size_t hash, mirror::Class* klass)
+      LOCKS_EXCLUDED(lock_)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  static void VisitRoots(RootCallback* callback, void* arg)
+      LOCKS_EXCLUDED(caches_lock_)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+ private:
+  explicit SharedRegTypeCache(mirror::ClassLoader* class_loader)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  struct EmptyFn {
+    void MakeEmpty(std::pair<const char*, GcRoot<mirror::Class>>& pair) const {
+      pair.first = nullptr;
+      pair.second = GcRoot<mirror::Class>();
+    }
+    bool IsEmpty(const std::pair<const char*, GcRoot<mirror::Class>>& pair) const {
+      return pair.first == nullptr;
+    }
+  };
+  struct DescriptorHashCmp {
+    size_t operator()(const char* descriptor) const {
+      return ComputeModifiedUtf8Hash(descriptor);
+    }
+    bool operator()(const char* a, const char* b) const {
+      return CompareModifiedUtf8ToModifiedUtf8AsUtf16CodePointValues(a, b) == 0;
+    }
+  };
+  typedef HashMap<const char*, GcRoot<mirror::Class>, EmptyFn, DescriptorHashCmp,
+                  DescriptorHashCmp> ClassMap;
+
+  const GcRoot<mirror::ClassLoader> class_loader_;
+  ReaderWriterMutex lock_;
+  ClassMap classes_ GUARDED_BY(lock_);
+  // Storage for the descriptors the class map is keyed by.
+  std::deque<std::string> descriptors_ GUARDED_BY(lock_);
+
+  // The caches of all class loaders, there are only ever a few.
+  static ReaderWriterMutex* caches_lock_;
+  static std::vector<SharedRegTypeCache*>* caches_ GUARDED_BY(caches_lock_);
+
+  DISALLOW_COPY_AND_ASSIGN(SharedRegTypeCache);
+};
+
 class RegTypeCache {
  public:
   explicit RegTypeCache(bool can_load_classes);
@@ -47,6 +119,7 @@ class RegTypeCache {
       CHECK_EQ(RegTypeCache::primitive_count_, 0);
       CreatePrimitiveAndSmallConstantTypes();
       CHECK_EQ(RegTypeCache::primitive_count_, kNumPrimitivesAndSmallConstants);
+      SharedRegTypeCache::Init();
       RegTypeCache::primitive_initialized_ = true;
     }
   }
@@ -160,6 +233,13 @@ class RegTypeCache {
 
   void AddEntry(RegType* new_entry);
 
+  // Allocates the memory of a non primitive type, which lives as long as the cache.
+  void* AllocateEntry(size_t size);
+  template <class Type, typename... Args>
+  Type* NewEntry(Args&&... args) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+    return new (AllocateEntry(sizeof(Type))) Type(std::forward<Args>(args)...);
+  }
+
   template <class Type>
   static Type* CreatePrimitiveTypeInstance(const std::string& descriptor)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
@@ -168,6 +248,13 @@ class RegTypeCache {
   // The actual storage for the RegTypes.
   std::vector<RegType*> entries_;
 
+  // The non primitive types are bump allocated from chunks, rather than with an allocation each.
+  static constexpr size_t kChunkSize = 4 * KB;
+  static constexpr size_t kEntryAlignment = 8;
+  std::vector<std::unique_ptr<uint8_t[]>> chunks_;
+  uint8_t* chunk_pos_;
+  uint8_t* chunk_end_;
+
   // A quick look up for popular small constants.
   static constexpr int32_t kMinSmallConstant = -1;
   static constexpr int32_t kMaxSmallConstant = 4;
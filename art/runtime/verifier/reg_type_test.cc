@@ -450,6 +450,36 @@ TEST_F(RegTypeReferenceTest, JavalangObject) {
   EXPECT_TRUE(ref_type_3.Equals(ref_type_2));
   EXPECT_EQ(ref_type.GetId(), ref_type_3.GetId());
 }
+TEST_F(RegTypeReferenceTest, SharedCache) {
+  // What a cache resolves, or fails to, is seen by the caches of the methods verified later.
+  ScopedObjectAccess soa(Thread::Current());
+  SharedRegTypeCache* shared_cache = SharedRegTypeCache::ForClassLoader(NULL);
+  ASSERT_TRUE(shared_cache != NULL);
+  EXPECT_EQ(shared_cache, SharedRegTypeCache::ForClassLoader(NULL));
+  {
+    RegTypeCache cache(true);
+    cache.JavaLangString();
+    cache.FromDescriptor(NULL, "Ljava/lang/DoesNotExist;", false);
+  }
+  const char* string_descriptor = "Ljava/lang/String;";
+  mirror::Class* klass = NULL;
+  ASSERT_TRUE(shared_cache->Find(string_descriptor, ComputeModifiedUtf8Hash(string_descriptor),
+                                 &klass));
+  EXPECT_EQ(class_linker_->FindSystemClass(soa.Self(), string_descriptor), klass);
+  const char* missing_descriptor = "Ljava/lang/DoesNotExist;";
+  ASSERT_TRUE(shared_cache->Find(missing_descriptor, ComputeModifiedUtf8Hash(missing_descriptor),
+                                 &klass));
+  EXPECT_TRUE(klass == NULL);
+
+  RegTypeCache cache(false);
+  RegType& string_type = cache.JavaLangString();
+  EXPECT_TRUE(string_type.IsPreciseReference());
+  EXPECT_EQ(class_linker_->FindSystemClass(soa.Self(), string_descriptor),
+            string_type.GetClass());
+  EXPECT_TRUE(cache.FromDescriptor(NULL, missing_descriptor, false).IsUnresolvedReference());
+  EXPECT_FALSE(soa.Self()->IsExceptionPending());
+}
+
 TEST_F(RegTypeReferenceTest, Merging) {
   // Tests merging logic
   // String and object , LUB is object.
@@ -0,0 +1,38 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+class OptimizingInlining {
+  private int value;
+
+  private int getValue() {
+    return value;
+  }
+
+  private void setValue(int value) {
+    this.value = value;
+  }
+
+  static int valueOf(OptimizingInlining object) {
+    return object.value;
+  }
+
+  // Calls a getter and a setter, with a direct call checking the receiver, and a static
+  // method checking its argument.
+  int addAndGet(int increment) {
+    setValue(getValue() + increment);
+    return valueOf(this);
+  }
+}
@@ -0,0 +1,36 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+class OptimizingInvokes {
+  interface Scaler {
+    double scale(float value, double factor);
+  }
+
+  static class Multiplier implements Scaler {
+    public double scale(float value, double factor) {
+      return value * factor;
+    }
+  }
+
+  float half(float value) {
+    return value / 2.0f;
+  }
+
+  // Calls a virtual and an interface method, which take and return float and double values.
+  double halfAndScale(Scaler scaler, float value, double factor) {
+    return scaler.scale(half(value), factor);
+  }
+}
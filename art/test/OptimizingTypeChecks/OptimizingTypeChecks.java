@@ -0,0 +1,28 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+class OptimizingTypeChecks {
+  static class Base {}
+
+  static class Derived extends Base {}
+
+  // Casts the value to Base, and divides 100 by the divisor.
+  static int castAndDivide(Object value, int divisor) {
+    Base base = (Base) value;
+    int derived = (base instanceof Derived) ? 1 : 0;
+    return 100 / divisor + 100 % divisor + derived;
+  }
+}
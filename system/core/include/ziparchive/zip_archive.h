@@ -151,6 +151,37 @@ int32_t StartIteration(ZipArchiveHandle handle, void** cookie_ptr,
  */
 int32_t Next(void* cookie, ZipEntry* data, ZipEntryName *name);
 
+/*
+ * Called by IterateEntries for each matching entry. |name| points into the
+ * archive's central directory and is not null terminated. Returning a
+ * non-zero value stops the iteration.
+ */
+typedef int32_t (*IterateCallback)(const ZipEntryName* name, ZipEntry* data,
+                                   void* cookie);
+
+/*
+ * Call |callback| for every entry of a zip file whose name starts with
+ * |prefix| (which may be NULL), in central directory order. Unlike
+ * StartIteration / Next this does not walk the hash table, so it is the
+ * cheaper way to visit many or all of the entries of a large archive.
+ *
+ * Returns 0 once every entry has been visited, the first non-zero value
+ * returned by |callback|, or negative values on failure.
+ */
+int32_t IterateEntries(ZipArchiveHandle handle, const char* prefix,
+                       IterateCallback callback, void* cookie);
+
+/*
+ * Keep the parsed central directories of up to |max_archives| recently
+ * opened archives, shared by every handle to the same file in this process.
+ * Reopening a file that has not changed (same device, inode, size and
+ * modification time) then skips scanning its central directory. A size of
+ * 0, the default, disables the cache and drops everything it holds.
+ *
+ * Handles that are already open are unaffected.
+ */
+void SetCentralDirectoryCacheSize(uint32_t max_archives);
+
 /*
  * Uncompress and write an entry to an open file identified by |fd|.
  * |entry->uncompressed_length| bytes will be written to the file at
@@ -172,6 +203,65 @@ int32_t ExtractEntryToFile(ZipArchiveHandle handle, ZipEntry* entry, int fd);
 int32_t ExtractToMemory(ZipArchiveHandle handle, ZipEntry* entry,
                         uint8_t* begin, uint32_t size);
 
+typedef void* ZipReaderHandle;
+
+/*
+ * Start a streaming read of the uncompressed contents of |entry|, which
+ * must have been returned by FindEntry or iteration on |handle|. Sets
+ * |reader| to an opaque handle for use with ReadEntryData, which must be
+ * released with EndReading before |handle| is closed.
+ *
+ * Readers do not use the file offset of the archive, so several of them,
+ * and calls to ExtractToMemory, may run concurrently on one handle.
+ *
+ * Returns 0 on success and negative values on failure.
+ */
+int32_t StartReading(ZipArchiveHandle handle, const ZipEntry* entry,
+                     ZipReaderHandle* reader);
+
+/*
+ * Uncompress the next bytes of an entry directly into the |size| bytes
+ * at |buf|.
+ *
+ * Returns the number of bytes written, which is less than |size| only for
+ * the final chunk of the entry, 0 once the whole entry has been read, and
+ * negative values on failure. A data descriptor, if the entry has one, is
+ * not read.
+ */
+int32_t ReadEntryData(ZipReaderHandle reader, uint8_t* buf, uint32_t size);
+
+/*
+ * Release a reader returned by StartReading.
+ */
+void EndReading(ZipReaderHandle reader);
+
+/*
+ * One entry to uncompress with ExtractEntries. If |begin| is non-NULL
+ * the entry is extracted as by ExtractToMemory(handle, &entry, begin,
+ * size), otherwise as by ExtractEntryToFile(handle, &entry, fd).
+ */
+struct ZipExtractRequest {
+  ZipEntry entry;
+  uint8_t* begin;
+  uint32_t size;
+  int fd;
+
+  // Set to the result of the extraction.
+  int32_t result;
+};
+
+/*
+ * Extract every one of the |count| |requests| using up to |num_threads|
+ * threads, the calling thread included. A |num_threads| of 0 uses one
+ * thread per online CPU. Each request must have its own destination.
+ *
+ * Returns 0 if every extraction succeeded, otherwise the result of the
+ * first request (in array order) that failed. The result of each request
+ * is stored in its |result| field either way.
+ */
+int32_t ExtractEntries(ZipArchiveHandle handle, ZipExtractRequest* requests,
+                       uint32_t count, uint32_t num_threads);
+
 int GetFileDescriptor(const ZipArchiveHandle handle);
 
 const char* ErrorCodeString(int32_t error_code);
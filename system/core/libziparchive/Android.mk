@@ -75,3 +75,18 @@ LOCAL_STATIC_LIBRARIES := libziparchive-host \
 	liblog \
 	libutils
 include $(BUILD_HOST_NATIVE_TEST)
+
+include $(CLEAR_VARS)
+LOCAL_MODULE := ziparchive-benchmarks
+LOCAL_CPP_EXTENSION := .cc
+LOCAL_CFLAGS += \
+    -I$(LOCAL_PATH)/../liblog/tests \
+    -Wall -Wextra \
+    -Werror
+LOCAL_SRC_FILES := \
+    ../liblog/tests/benchmark_main.cpp \
+    zip_archive_benchmark.cc
+LOCAL_SHARED_LIBRARIES := liblog libm
+LOCAL_STATIC_LIBRARIES := libziparchive libz libutils
+LOCAL_MODULE_PATH := $(TARGET_OUT_DATA_NATIVE_TESTS)/$(LOCAL_MODULE)
+include $(BUILD_EXECUTABLE)
@@ -24,11 +24,16 @@
 #include <inttypes.h>
 #include <limits.h>
 #include <log/log.h>
+#ifdef HAVE_PREAD
+#include <pthread.h>
+#endif
 #include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
 #include <unistd.h>
 #include <utils/Compat.h>
 #include <utils/FileMap.h>
+#include <utils/Mutex.h>
 #include <zlib.h>
 
 #include <JNIHelp.h>  // TEMP_FAILURE_RETRY may or may not be in unistd
@@ -193,6 +198,7 @@ struct DataDescriptor {
 #undef DISALLOW_IMPLICIT_CONSTRUCTORS
 
 static const uint32_t kGPBDDFlagMask = 0x0008;         // mask value that signifies that the entry has a DD
+static const uint32_t kMaxInlineNameLen = 256;         // longest entry name read with its local header
 static const uint32_t kMaxErrorLen = 1024;
 
 // The maximum size of a central directory or a file
@@ -266,6 +272,41 @@ static const int32_t kErrorMessageLowerBound = -13;
 
 static const char kTempMappingFileName[] = "zip: ExtractFileToFile";
 
+/*
+ * A parsed central directory held by the process-wide cache, see
+ * SetCentralDirectoryCacheSize. The mapping and the hash table are shared
+ * by every ZipArchive opened on the same file, and freed once the cache
+ * has evicted the entry and the last of those archives is closed.
+ */
+struct CachedDirectory {
+  /* identity of the file the directory was parsed from */
+  dev_t dev;
+  ino_t ino;
+  time_t mtime;
+  off64_t size;
+
+  off64_t directory_offset;
+  android::FileMap* directory_map;
+  uint16_t num_entries;
+  uint32_t hash_table_size;
+  ZipEntryName* hash_table;
+
+  /* one for the cache while it is listed, one per open archive */
+  uint32_t refs;
+  /* next most recently used directory */
+  CachedDirectory* next;
+};
+
+/*
+ * The cache is a short list in most recently used order; lookups compare
+ * a few integers per entry, which is nothing next to a directory scan.
+ */
+static android::Mutex gDirectoryCacheLock;
+static CachedDirectory* gDirectoryCache = NULL;
+static uint32_t gDirectoryCacheMax = 0;
+
+static void ReleaseCachedDirectory(CachedDirectory* cached);
+
 /*
  * A Read-only Zip archive.
  *
@@ -305,19 +346,30 @@ struct ZipArchive {
   uint32_t hash_table_size;
   ZipEntryName* hash_table;
 
+  /*
+   * If non-NULL, directory_map and hash_table belong to this cache entry
+   * rather than to the archive.
+   */
+  CachedDirectory* cached_directory;
+
   ZipArchive(const int fd) :
       fd(fd),
       directory_offset(0),
       directory_map(NULL),
       num_entries(0),
       hash_table_size(0),
-      hash_table(NULL) {}
+      hash_table(NULL),
+      cached_directory(NULL) {}
 
   ~ZipArchive() {
     if (fd >= 0) {
       close(fd);
     }
 
+    if (cached_directory != NULL) {
+      ReleaseCachedDirectory(cached_directory);
+      return;
+    }
     if (directory_map != NULL) {
       directory_map->release();
     }
@@ -339,35 +391,6 @@ static android::FileMap* MapFileSegment(const int fd, const off64_t start,
   return file_map;
 }
 
-static int32_t CopyFileToFile(int fd, uint8_t* begin, const uint32_t length, uint64_t *crc_out) {
-  static const uint32_t kBufSize = 32768;
-  uint8_t buf[kBufSize];
-
-  uint32_t count = 0;
-  uint64_t crc = 0;
-  while (count < length) {
-    uint32_t remaining = length - count;
-
-    // Safe conversion because kBufSize is narrow enough for a 32 bit signed
-    // value.
-    ssize_t get_size = (remaining > kBufSize) ? kBufSize : remaining;
-    ssize_t actual = TEMP_FAILURE_RETRY(read(fd, buf, get_size));
-
-    if (actual != get_size) {
-      ALOGW("CopyFileToFile: copy read failed (" ZD " vs " ZD ")", actual, get_size);
-      return kIoError;
-    }
-
-    memcpy(begin + count, buf, get_size);
-    crc = crc32(crc, buf, get_size);
-    count += get_size;
-  }
-
-  *crc_out = crc;
-
-  return 0;
-}
-
 /*
  * Round up to the next highest power of 2.
  *
@@ -670,9 +693,158 @@ bail:
   return result;
 }
 
+/*
+ * Drop a reference to a cached directory, freeing it with the last one.
+ */
+static void ReleaseCachedDirectory(CachedDirectory* cached) {
+  {
+    android::AutoMutex lock(gDirectoryCacheLock);
+    if (--cached->refs != 0) {
+      return;
+    }
+  }
+
+  cached->directory_map->release();
+  free(cached->hash_table);
+  free(cached);
+}
+
+/*
+ * Evict least recently used directories until at most |max| are listed.
+ * Must be called with gDirectoryCacheLock held; returns the evicted entries
+ * that are no longer referenced, chained through |next|, for the caller to
+ * free once the lock is dropped.
+ */
+static CachedDirectory* TrimDirectoryCacheLocked(uint32_t max) {
+  CachedDirectory* unused = NULL;
+  CachedDirectory** link = &gDirectoryCache;
+  for (uint32_t i = 0; *link != NULL && i < max; ++i) {
+    link = &(*link)->next;
+  }
+  while (*link != NULL) {
+    CachedDirectory* evicted = *link;
+    *link = evicted->next;
+    if (--evicted->refs == 0) {
+      evicted->next = unused;
+      unused = evicted;
+    }
+  }
+  return unused;
+}
+
+static void FreeCachedDirectories(CachedDirectory* unused) {
+  while (unused != NULL) {
+    CachedDirectory* next = unused->next;
+    unused->directory_map->release();
+    free(unused->hash_table);
+    free(unused);
+    unused = next;
+  }
+}
+
+void SetCentralDirectoryCacheSize(uint32_t max_archives) {
+  CachedDirectory* unused;
+  {
+    android::AutoMutex lock(gDirectoryCacheLock);
+    gDirectoryCacheMax = max_archives;
+    unused = TrimDirectoryCacheLocked(max_archives);
+  }
+  FreeCachedDirectories(unused);
+}
+
+static bool MatchesFile(const CachedDirectory* cached, const struct stat& sb) {
+  return cached->dev == sb.st_dev && cached->ino == sb.st_ino &&
+      cached->mtime == sb.st_mtime && cached->size == sb.st_size;
+}
+
+/*
+ * Point |archive| at a cached copy of its central directory, if there is
+ * one, and move it to the front of the cache.
+ */
+static bool UseCachedDirectory(ZipArchive* archive, const struct stat& sb) {
+  android::AutoMutex lock(gDirectoryCacheLock);
+  for (CachedDirectory** link = &gDirectoryCache; *link != NULL;
+       link = &(*link)->next) {
+    CachedDirectory* cached = *link;
+    if (!MatchesFile(cached, sb)) {
+      continue;
+    }
+
+    *link = cached->next;
+    cached->next = gDirectoryCache;
+    gDirectoryCache = cached;
+    ++cached->refs;
+
+    archive->directory_offset = cached->directory_offset;
+    archive->directory_map = cached->directory_map;
+    archive->num_entries = cached->num_entries;
+    archive->hash_table_size = cached->hash_table_size;
+    archive->hash_table = cached->hash_table;
+    archive->cached_directory = cached;
+    return true;
+  }
+  return false;
+}
+
+/*
+ * Hand the freshly parsed directory of |archive| over to the cache. If
+ * another thread got there first, or the cache was disabled meanwhile,
+ * the archive simply keeps its own copy.
+ */
+static void AddCachedDirectory(ZipArchive* archive, const struct stat& sb) {
+  CachedDirectory* unused;
+  {
+    android::AutoMutex lock(gDirectoryCacheLock);
+    if (gDirectoryCacheMax == 0) {
+      return;
+    }
+    for (CachedDirectory* cached = gDirectoryCache; cached != NULL;
+         cached = cached->next) {
+      if (MatchesFile(cached, sb)) {
+        return;
+      }
+    }
+
+    CachedDirectory* cached =
+        reinterpret_cast<CachedDirectory*>(malloc(sizeof(CachedDirectory)));
+    if (cached == NULL) {
+      return;
+    }
+    cached->dev = sb.st_dev;
+    cached->ino = sb.st_ino;
+    cached->mtime = sb.st_mtime;
+    cached->size = sb.st_size;
+    cached->directory_offset = archive->directory_offset;
+    cached->directory_map = archive->directory_map;
+    cached->num_entries = archive->num_entries;
+    cached->hash_table_size = archive->hash_table_size;
+    cached->hash_table = archive->hash_table;
+    cached->refs = 2;
+    cached->next = gDirectoryCache;
+    gDirectoryCache = cached;
+    archive->cached_directory = cached;
+
+    unused = TrimDirectoryCacheLocked(gDirectoryCacheMax);
+  }
+  FreeCachedDirectories(unused);
+}
+
 static int32_t OpenArchiveInternal(ZipArchive* archive,
                                    const char* debug_file_name) {
   int32_t result = -1;
+
+  // Files without a meaningful inode number (e.g. on Windows) can't be
+  // told apart, so they are never cached. gDirectoryCacheMax is only a hint
+  // here; AddCachedDirectory checks it again under the lock.
+  struct stat sb;
+  bool cacheable = false;
+  if (gDirectoryCacheMax != 0 && fstat(archive->fd, &sb) == 0 && sb.st_ino != 0) {
+    if (UseCachedDirectory(archive, sb)) {
+      return 0;
+    }
+    cacheable = true;
+  }
+
   if ((result = MapCentralDirectory(archive->fd, debug_file_name, archive))) {
     return result;
   }
@@ -681,6 +853,9 @@ static int32_t OpenArchiveInternal(ZipArchive* archive,
     return result;
   }
 
+  if (cacheable) {
+    AddCachedDirectory(archive, sb);
+  }
   return 0;
 }
 
@@ -712,25 +887,6 @@ void CloseArchive(ZipArchiveHandle handle) {
   delete archive;
 }
 
-static int32_t UpdateEntryFromDataDescriptor(int fd,
-                                             ZipEntry *entry) {
-  uint8_t ddBuf[sizeof(DataDescriptor) + sizeof(DataDescriptor::kOptSignature)];
-  ssize_t actual = TEMP_FAILURE_RETRY(read(fd, ddBuf, sizeof(ddBuf)));
-  if (actual != sizeof(ddBuf)) {
-    return kIoError;
-  }
-
-  const uint32_t ddSignature = *(reinterpret_cast<const uint32_t*>(ddBuf));
-  const uint16_t offset = (ddSignature == DataDescriptor::kOptSignature) ? 4 : 0;
-  const DataDescriptor* descriptor = reinterpret_cast<const DataDescriptor*>(ddBuf + offset);
-
-  entry->crc32 = descriptor->crc32;
-  entry->compressed_length = descriptor->compressed_size;
-  entry->uncompressed_length = descriptor->uncompressed_size;
-
-  return 0;
-}
-
 // Attempts to read |len| bytes into |buf| at offset |off|.
 //
 // This method uses pread64 on platforms that support it and
@@ -754,11 +910,27 @@ static inline ssize_t ReadAtOffset(int fd, uint8_t* buf, size_t len,
 #endif  // HAVE_PREAD
 }
 
-static int32_t FindEntry(const ZipArchive* archive, const int ent,
-                         ZipEntry* data) {
-  const uint16_t nameLen = archive->hash_table[ent].name_length;
-  const char* name = archive->hash_table[ent].name;
+static int32_t UpdateEntryFromDataDescriptor(int fd, off64_t offset,
+                                             ZipEntry *entry) {
+  uint8_t ddBuf[sizeof(DataDescriptor) + sizeof(DataDescriptor::kOptSignature)];
+  ssize_t actual = ReadAtOffset(fd, ddBuf, sizeof(ddBuf), offset);
+  if (actual != sizeof(ddBuf)) {
+    return kIoError;
+  }
+
+  const uint32_t ddSignature = *(reinterpret_cast<const uint32_t*>(ddBuf));
+  const uint16_t dd_offset = (ddSignature == DataDescriptor::kOptSignature) ? 4 : 0;
+  const DataDescriptor* descriptor = reinterpret_cast<const DataDescriptor*>(ddBuf + dd_offset);
 
+  entry->crc32 = descriptor->crc32;
+  entry->compressed_length = descriptor->compressed_size;
+  entry->uncompressed_length = descriptor->uncompressed_size;
+
+  return 0;
+}
+
+static int32_t FindEntry(const ZipArchive* archive, const char* name,
+                         const uint16_t nameLen, ZipEntry* data) {
   // Recover the start of the central directory entry from the filename
   // pointer.  The filename is the first entry past the fixed-size data,
   // so we can just subtract back from that.
@@ -801,10 +973,16 @@ static int32_t FindEntry(const ZipArchive* archive, const int ent,
     return kInvalidOffset;
   }
 
-  uint8_t lfh_buf[sizeof(LocalFileHeader)];
-  ssize_t actual = ReadAtOffset(archive->fd, lfh_buf, sizeof(lfh_buf),
-                                 local_header_offset);
-  if (actual != sizeof(lfh_buf)) {
+  // Read the name that should follow the local file header along with it,
+  // which saves a second read for all but unusually long names. The central
+  // directory comes after every local header, so this can't run off the end
+  // of a valid file.
+  uint8_t lfh_buf[sizeof(LocalFileHeader) + kMaxInlineNameLen];
+  const size_t inline_name_len = (nameLen <= kMaxInlineNameLen) ? nameLen : 0;
+  ssize_t actual = ReadAtOffset(archive->fd, lfh_buf,
+                                sizeof(LocalFileHeader) + inline_name_len,
+                                local_header_offset);
+  if (actual != static_cast<ssize_t>(sizeof(LocalFileHeader) + inline_name_len)) {
     ALOGW("Zip: failed reading lfh name from offset %" PRId64, (int64_t)local_header_offset);
     return kIoError;
   }
@@ -843,22 +1021,28 @@ static int32_t FindEntry(const ZipArchive* archive, const int ent,
       return kInvalidOffset;
     }
 
-    uint8_t* name_buf = (uint8_t*) malloc(nameLen);
-    ssize_t actual = ReadAtOffset(archive->fd, name_buf, nameLen,
-                                  name_offset);
+    if (inline_name_len != 0) {
+      if (memcmp(name, lfh_buf + sizeof(LocalFileHeader), nameLen)) {
+        return kInconsistentInformation;
+      }
+    } else {
+      uint8_t* name_buf = (uint8_t*) malloc(nameLen);
+      ssize_t actual = ReadAtOffset(archive->fd, name_buf, nameLen,
+                                    name_offset);
+
+      if (actual != nameLen) {
+        ALOGW("Zip: failed reading lfh name from offset %" PRId64, (int64_t)name_offset);
+        free(name_buf);
+        return kIoError;
+      }
 
-    if (actual != nameLen) {
-      ALOGW("Zip: failed reading lfh name from offset %" PRId64, (int64_t)name_offset);
-      free(name_buf);
-      return kIoError;
-    }
+      if (memcmp(name, name_buf, nameLen)) {
+        free(name_buf);
+        return kInconsistentInformation;
+      }
 
-    if (memcmp(name, name_buf, nameLen)) {
       free(name_buf);
-      return kInconsistentInformation;
     }
-
-    free(name_buf);
   } else {
     ALOGW("Zip: lfh name did not match central directory.");
     return kInconsistentInformation;
@@ -888,6 +1072,12 @@ static int32_t FindEntry(const ZipArchive* archive, const int ent,
   return 0;
 }
 
+static int32_t FindEntry(const ZipArchive* archive, const int ent,
+                         ZipEntry* data) {
+  return FindEntry(archive, archive->hash_table[ent].name,
+                   archive->hash_table[ent].name_length, data);
+}
+
 struct IterationHandle {
   uint32_t position;
   const char* prefix;
@@ -970,34 +1160,115 @@ int32_t Next(void* cookie, ZipEntry* data, ZipEntryName* name) {
   return kIterationEnd;
 }
 
-static int32_t InflateToFile(int fd, const ZipEntry* entry,
-                             uint8_t* begin, uint32_t length,
-                             uint64_t* crc_out) {
-  int32_t result = -1;
-  const uint32_t kBufSize = 32768;
-  uint8_t read_buf[kBufSize];
-  uint8_t write_buf[kBufSize];
+int32_t IterateEntries(ZipArchiveHandle handle, const char* prefix,
+                       IterateCallback callback, void* cookie) {
+  const ZipArchive* archive = (ZipArchive*) handle;
+  if (archive == NULL || archive->directory_map == NULL) {
+    ALOGW("Zip: Invalid ZipArchiveHandle");
+    return kInvalidHandle;
+  }
+
+  const size_t prefix_len = (prefix != NULL) ? strlen(prefix) : 0;
+
+  // ParseZipArchive has already checked that every record and name lies
+  // within the mapping, so the walk needs no further bounds checks.
+  const uint8_t* ptr = reinterpret_cast<const uint8_t*>(
+      archive->directory_map->getDataPtr());
+  for (uint16_t i = 0; i < archive->num_entries; i++) {
+    const CentralDirectoryRecord* cdr =
+        reinterpret_cast<const CentralDirectoryRecord*>(ptr);
+    ZipEntryName name;
+    name.name = reinterpret_cast<const char*>(ptr + sizeof(CentralDirectoryRecord));
+    name.name_length = cdr->file_name_length;
+    ptr += sizeof(CentralDirectoryRecord) + cdr->file_name_length +
+        cdr->extra_field_length + cdr->comment_length;
+
+    if (name.name_length < prefix_len ||
+        memcmp(prefix, name.name, prefix_len) != 0) {
+      continue;
+    }
+
+    ZipEntry data;
+    int32_t result = FindEntry(archive, name.name, name.name_length, &data);
+    if (result == 0) {
+      result = callback(&name, &data, cookie);
+    }
+    if (result != 0) {
+      return result;
+    }
+  }
+
+  return 0;
+}
+
+static const uint32_t kReaderBufSize = 32768;
+
+/*
+ * The state of a streaming read of one entry, see StartReading. Compressed
+ * data is read with ReadAtOffset rather than through the file offset, so
+ * any number of readers may be active on one archive at the same time.
+ * Inflated data is written straight into the caller's buffer.
+ */
+struct ZipEntryReader {
+  const ZipArchive* archive;
+  uint16_t method;
+  uint32_t uncompressed_length;
+
+  /* offset and length of the compressed data not yet read */
+  off64_t next_offset;
+  uint32_t compressed_remaining;
+
+  /* number of bytes handed out so far */
+  uint32_t produced;
+  uint64_t crc;
+  bool done;
+
+  bool inflating;
   z_stream zstream;
-  int zerr;
+
+  uint8_t read_buf[kReaderBufSize];
+};
+
+static int32_t InitReader(ZipEntryReader* reader, const ZipArchive* archive,
+                          const ZipEntry* entry) {
+  reader->archive = archive;
+  reader->method = entry->method;
+  reader->uncompressed_length = entry->uncompressed_length;
+  reader->next_offset = entry->offset;
+  reader->compressed_remaining = entry->compressed_length;
+  reader->produced = 0;
+  reader->crc = 0;
+  reader->done = false;
+  reader->inflating = false;
+
+  if (entry->method == kCompressStored) {
+    // Stored entries have no separate compressed length worth trusting.
+    reader->compressed_remaining = entry->uncompressed_length;
+    reader->done = (entry->uncompressed_length == 0);
+    return 0;
+  }
+  if (entry->method != kCompressDeflated) {
+    ALOGW("Zip: unknown compression method %" PRIu16, entry->method);
+    return kInconsistentInformation;
+  }
 
   /*
    * Initialize the zlib stream struct.
    */
-  memset(&zstream, 0, sizeof(zstream));
-  zstream.zalloc = Z_NULL;
-  zstream.zfree = Z_NULL;
-  zstream.opaque = Z_NULL;
-  zstream.next_in = NULL;
-  zstream.avail_in = 0;
-  zstream.next_out = (Bytef*) write_buf;
-  zstream.avail_out = kBufSize;
-  zstream.data_type = Z_UNKNOWN;
+  z_stream* zstream = &reader->zstream;
+  memset(zstream, 0, sizeof(*zstream));
+  zstream->zalloc = Z_NULL;
+  zstream->zfree = Z_NULL;
+  zstream->opaque = Z_NULL;
+  zstream->next_in = NULL;
+  zstream->avail_in = 0;
+  zstream->data_type = Z_UNKNOWN;
 
   /*
    * Use the undocumented "negative window bits" feature to tell zlib
    * that there's no zlib header waiting for it.
    */
-  zerr = inflateInit2(&zstream, -MAX_WBITS);
+  const int zerr = inflateInit2(zstream, -MAX_WBITS);
   if (zerr != Z_OK) {
     if (zerr == Z_VERSION_ERROR) {
       ALOGE("Installed zlib is not compatible with linked version (%s)",
@@ -1009,95 +1280,196 @@ static int32_t InflateToFile(int fd, const ZipEntry* entry,
     return kZlibError;
   }
 
-  const uint32_t uncompressed_length = entry->uncompressed_length;
+  reader->inflating = true;
+  return 0;
+}
+
+static void FinishReader(ZipEntryReader* reader) {
+  if (reader->inflating) {
+    inflateEnd(&reader->zstream);    /* free up any allocated structures */
+    reader->inflating = false;
+  }
+}
+
+static int32_t ReadStored(ZipEntryReader* reader, uint8_t* buf, uint32_t size) {
+  if (size > reader->compressed_remaining) {
+    size = reader->compressed_remaining;
+  }
+
+  const ssize_t actual = ReadAtOffset(reader->archive->fd, buf, size,
+                                      reader->next_offset);
+  if (actual != static_cast<ssize_t>(size)) {
+    ALOGW("Zip: copy read failed (" ZD " vs %" PRIu32 ")", (ZD_TYPE) actual, size);
+    return kIoError;
+  }
+
+  reader->next_offset += size;
+  reader->compressed_remaining -= size;
+  reader->crc = crc32(reader->crc, buf, size);
+  if (reader->compressed_remaining == 0) {
+    reader->done = true;
+  }
+  return size;
+}
+
+static int32_t ReadInflated(ZipEntryReader* reader, uint8_t* buf, uint32_t size) {
+  z_stream* zstream = &reader->zstream;
+  zstream->next_out = buf;
+  zstream->avail_out = size;
 
-  uint32_t compressed_length = entry->compressed_length;
-  uint32_t write_count = 0;
-  do {
+  while (zstream->avail_out != 0) {
     /* read as much as we can */
-    if (zstream.avail_in == 0) {
-      const ZD_TYPE getSize = (compressed_length > kBufSize) ? kBufSize : compressed_length;
-      const ZD_TYPE actual = TEMP_FAILURE_RETRY(read(fd, read_buf, getSize));
-      if (actual != getSize) {
-        ALOGW("Zip: inflate read failed (" ZD " vs " ZD ")", actual, getSize);
-        result = kIoError;
-        goto z_bail;
+    if (zstream->avail_in == 0 && reader->compressed_remaining != 0) {
+      const uint32_t getSize = (reader->compressed_remaining > kReaderBufSize) ?
+          kReaderBufSize : reader->compressed_remaining;
+      const ssize_t actual = ReadAtOffset(reader->archive->fd, reader->read_buf,
+                                          getSize, reader->next_offset);
+      if (actual != static_cast<ssize_t>(getSize)) {
+        ALOGW("Zip: inflate read failed (" ZD " vs %" PRIu32 ")", (ZD_TYPE) actual, getSize);
+        return kIoError;
       }
 
-      compressed_length -= getSize;
+      reader->next_offset += getSize;
+      reader->compressed_remaining -= getSize;
 
-      zstream.next_in = read_buf;
-      zstream.avail_in = getSize;
+      zstream->next_in = reader->read_buf;
+      zstream->avail_in = getSize;
     }
 
     /* uncompress the data */
-    zerr = inflate(&zstream, Z_NO_FLUSH);
-    if (zerr != Z_OK && zerr != Z_STREAM_END) {
+    const int zerr = inflate(zstream, Z_NO_FLUSH);
+    if (zerr == Z_STREAM_END) {
+      // stream.adler holds the crc32 value for such streams.
+      reader->crc = zstream->adler;
+      reader->done = true;
+
+      if (zstream->total_out != reader->uncompressed_length ||
+          reader->compressed_remaining != 0) {
+        ALOGW("Zip: size mismatch on inflated file (%lu vs %" PRIu32 ")",
+            zstream->total_out, reader->uncompressed_length);
+        return kInconsistentInformation;
+      }
+      break;
+    }
+    if (zerr != Z_OK) {
+      // Includes Z_BUF_ERROR once the compressed data has run out early.
       ALOGW("Zip: inflate zerr=%d (nIn=%p aIn=%u nOut=%p aOut=%u)",
-          zerr, zstream.next_in, zstream.avail_in,
-          zstream.next_out, zstream.avail_out);
-      result = kZlibError;
-      goto z_bail;
+          zerr, zstream->next_in, zstream->avail_in,
+          zstream->next_out, zstream->avail_out);
+      return kZlibError;
     }
+  }
 
-    /* write when we're full or when we're done */
-    if (zstream.avail_out == 0 ||
-      (zerr == Z_STREAM_END && zstream.avail_out != kBufSize)) {
-      const size_t write_size = zstream.next_out - write_buf;
-      // The file might have declared a bogus length.
-      if (write_size + write_count > length) {
-        goto z_bail;
-      }
-      memcpy(begin + write_count, write_buf, write_size);
-      write_count += write_size;
+  return size - zstream->avail_out;
+}
 
-      zstream.next_out = write_buf;
-      zstream.avail_out = kBufSize;
-    }
-  } while (zerr == Z_OK);
+/*
+ * Fill up to |size| bytes of |buf| with the next uncompressed bytes of the
+ * entry. Returns the number of bytes written, which is only less than
+ * |size| at the end of the entry, 0 once the entry is exhausted and
+ * negative values on failure.
+ */
+static int32_t ReadFromReader(ZipEntryReader* reader, uint8_t* buf, uint32_t size) {
+  if (reader->done || size == 0) {
+    return 0;
+  }
+  if (size > INT_MAX) {
+    size = INT_MAX;
+  }
 
-  assert(zerr == Z_STREAM_END);     /* other errors should've been caught */
+  const int32_t result = (reader->method == kCompressStored) ?
+      ReadStored(reader, buf, size) : ReadInflated(reader, buf, size);
+  if (result > 0) {
+    reader->produced += result;
+  }
+  return result;
+}
 
-  // stream.adler holds the crc32 value for such streams.
-  *crc_out = zstream.adler;
+int32_t StartReading(ZipArchiveHandle handle, const ZipEntry* entry,
+                     ZipReaderHandle* reader_ptr) {
+  const ZipArchive* archive = (ZipArchive*) handle;
+  if (archive == NULL || archive->fd < 0) {
+    ALOGW("Zip: Invalid ZipArchiveHandle");
+    return kInvalidHandle;
+  }
 
-  if (zstream.total_out != uncompressed_length || compressed_length != 0) {
-    ALOGW("Zip: size mismatch on inflated file (%lu vs %" PRIu32 ")",
-        zstream.total_out, uncompressed_length);
-    result = kInconsistentInformation;
-    goto z_bail;
+  ZipEntryReader* reader = (ZipEntryReader*) malloc(sizeof(ZipEntryReader));
+  if (reader == NULL) {
+    return kIoError;
+  }
+  const int32_t result = InitReader(reader, archive, entry);
+  if (result != 0) {
+    free(reader);
+    return result;
   }
 
-  result = 0;
+  *reader_ptr = reader;
+  return 0;
+}
 
-z_bail:
-  inflateEnd(&zstream);    /* free up any allocated structures */
+int32_t ReadEntryData(ZipReaderHandle reader_handle, uint8_t* buf, uint32_t size) {
+  ZipEntryReader* reader = (ZipEntryReader*) reader_handle;
+  if (reader == NULL) {
+    return kInvalidHandle;
+  }
+  return ReadFromReader(reader, buf, size);
+}
 
-  return result;
+void EndReading(ZipReaderHandle reader_handle) {
+  ZipEntryReader* reader = (ZipEntryReader*) reader_handle;
+  if (reader != NULL) {
+    FinishReader(reader);
+    free(reader);
+  }
 }
 
 int32_t ExtractToMemory(ZipArchiveHandle handle,
                         ZipEntry* entry, uint8_t* begin, uint32_t size) {
   ZipArchive* archive = (ZipArchive*) handle;
-  const uint16_t method = entry->method;
-  off64_t data_offset = entry->offset;
 
-  if (lseek64(archive->fd, data_offset, SEEK_SET) != data_offset) {
-    ALOGW("Zip: lseek to data at %" PRId64 " failed", (int64_t)data_offset);
-    return kIoError;
+  // The reader carries a 32K read buffer, which is fine on the stack here
+  // just as it was for the old inflate loop.
+  ZipEntryReader reader;
+  int32_t return_value = InitReader(&reader, archive, entry);
+  if (return_value != 0) {
+    return return_value;
   }
 
-  // this should default to kUnknownCompressionMethod.
-  int32_t return_value = -1;
-  uint64_t crc = 0;
-  if (method == kCompressStored) {
-    return_value = CopyFileToFile(archive->fd, begin, size, &crc);
-  } else if (method == kCompressDeflated) {
-    return_value = InflateToFile(archive->fd, entry, begin, size, &crc);
+  // As before the streaming reader, a stored entry is copied for exactly
+  // |size| bytes from the start of its data, whatever the declared length.
+  if (entry->method == kCompressStored) {
+    reader.uncompressed_length = size;
+    reader.compressed_remaining = size;
+    reader.done = (size == 0);
   }
 
+  // Inflate straight into the destination; there is no intermediate
+  // output buffer to copy from.
+  while (!reader.done && reader.produced < size) {
+    return_value = ReadFromReader(&reader, begin + reader.produced,
+                                  size - reader.produced);
+    if (return_value < 0) {
+      break;
+    }
+  }
+  if (return_value >= 0) {
+    // The file might have declared a bogus length.
+    uint8_t extra;
+    if (!reader.done && ReadFromReader(&reader, &extra, 1) != 0) {
+      ALOGW("Zip: entry does not fit in %" PRIu32 " bytes", size);
+      return_value = kInconsistentInformation;
+    } else if (reader.produced != reader.uncompressed_length) {
+      ALOGW("Zip: size mismatch on extracted entry (%" PRIu32 " vs %" PRIu32 ")",
+          reader.produced, reader.uncompressed_length);
+      return_value = kInconsistentInformation;
+    } else {
+      return_value = 0;
+    }
+  }
+  FinishReader(&reader);
+
   if (!return_value && entry->has_data_descriptor) {
-    return_value = UpdateEntryFromDataDescriptor(archive->fd, entry);
+    return_value = UpdateEntryFromDataDescriptor(archive->fd, reader.next_offset, entry);
     if (return_value) {
       return return_value;
     }
@@ -1105,8 +1477,8 @@ int32_t ExtractToMemory(ZipArchiveHandle handle,
 
   // TODO: Fix this check by passing the right flags to inflate2 so that
   // it calculates the CRC for us.
-  if (entry->crc32 != crc && false) {
-    ALOGW("Zip: crc mismatch: expected %" PRIu32 ", was %" PRIu64, entry->crc32, crc);
+  if (entry->crc32 != reader.crc && false) {
+    ALOGW("Zip: crc mismatch: expected %" PRIu32 ", was %" PRIu64, entry->crc32, reader.crc);
     return kInconsistentInformation;
   }
 
@@ -1151,6 +1523,119 @@ int32_t ExtractEntryToFile(ZipArchiveHandle handle,
   return error;
 }
 
+/*
+ * A pool of threads sharing one list of extraction requests, see
+ * ExtractEntries. Requests are sorted largest first so that a big entry
+ * (classes.dex, say) doesn't start last and leave the other threads idle.
+ */
+struct ExtractBatch {
+  ZipArchiveHandle handle;
+  ZipExtractRequest** requests;
+  uint32_t count;
+  volatile uint32_t next;
+};
+
+static void ExtractRequest(ZipArchiveHandle handle, ZipExtractRequest* request) {
+  if (request->begin != NULL) {
+    request->result = ExtractToMemory(handle, &request->entry,
+                                      request->begin, request->size);
+  } else {
+    request->result = ExtractEntryToFile(handle, &request->entry, request->fd);
+  }
+}
+
+static void* ExtractBatchWorker(void* arg) {
+  ExtractBatch* batch = reinterpret_cast<ExtractBatch*>(arg);
+  while (true) {
+    const uint32_t i = __sync_fetch_and_add(&batch->next, 1);
+    if (i >= batch->count) {
+      break;
+    }
+    ExtractRequest(batch->handle, batch->requests[i]);
+  }
+  return NULL;
+}
+
+static int CompareRequestSizes(const void* lhs, const void* rhs) {
+  const uint32_t lhs_size = (*(ZipExtractRequest* const*) lhs)->entry.uncompressed_length;
+  const uint32_t rhs_size = (*(ZipExtractRequest* const*) rhs)->entry.uncompressed_length;
+  if (lhs_size != rhs_size) {
+    return (lhs_size > rhs_size) ? -1 : 1;
+  }
+  return 0;
+}
+
+int32_t ExtractEntries(ZipArchiveHandle handle, ZipExtractRequest* requests,
+                       uint32_t count, uint32_t num_threads) {
+  ZipArchive* archive = (ZipArchive*) handle;
+  if (archive == NULL || archive->fd < 0) {
+    ALOGW("Zip: Invalid ZipArchiveHandle");
+    return kInvalidHandle;
+  }
+  if (count == 0) {
+    return 0;
+  }
+
+#ifdef HAVE_PREAD
+  if (num_threads == 0) {
+    const long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    num_threads = (cpus > 0) ? cpus : 1;
+  }
+#else
+  // Without pread every read moves the shared file offset.
+  num_threads = 1;
+#endif
+  if (num_threads > count) {
+    num_threads = count;
+  }
+
+  ZipExtractRequest** sorted = (ZipExtractRequest**) malloc(count * sizeof(ZipExtractRequest*));
+  if (sorted == NULL) {
+    return kIoError;
+  }
+  for (uint32_t i = 0; i < count; ++i) {
+    sorted[i] = &requests[i];
+  }
+  qsort(sorted, count, sizeof(ZipExtractRequest*), CompareRequestSizes);
+
+  ExtractBatch batch;
+  batch.handle = handle;
+  batch.requests = sorted;
+  batch.count = count;
+  batch.next = 0;
+
+#ifdef HAVE_PREAD
+  // The calling thread is one of the workers.
+  pthread_t* threads = NULL;
+  uint32_t started = 0;
+  if (num_threads > 1) {
+    threads = (pthread_t*) malloc((num_threads - 1) * sizeof(pthread_t));
+    for (; threads != NULL && started < num_threads - 1; ++started) {
+      const int rc = pthread_create(&threads[started], NULL, ExtractBatchWorker, &batch);
+      if (rc != 0) {
+        ALOGW("Zip: unable to start extraction thread: %s", strerror(rc));
+        break;
+      }
+    }
+  }
+  ExtractBatchWorker(&batch);
+  for (uint32_t i = 0; i < started; ++i) {
+    pthread_join(threads[i], NULL);
+  }
+  free(threads);
+#else
+  ExtractBatchWorker(&batch);
+#endif
+  free(sorted);
+
+  for (uint32_t i = 0; i < count; ++i) {
+    if (requests[i].result != 0) {
+      return requests[i].result;
+    }
+  }
+  return 0;
+}
+
 const char* ErrorCodeString(int32_t error_code) {
   if (error_code > kErrorMessageLowerBound && error_code < kErrorMessageUpperBound) {
     return kErrorMessages[error_code * -1];
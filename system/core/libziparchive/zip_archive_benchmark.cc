@@ -0,0 +1,224 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ziparchive/zip_archive.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#include "benchmark.h"
+
+// Roughly the entry count of a large application APK.
+static const uint16_t kNumEntries = 10000;
+static const char kEntryData[] = "0123456789abcdef";
+
+static void Put16(std::vector<uint8_t>* out, uint16_t v) {
+  out->push_back(v & 0xff);
+  out->push_back(v >> 8);
+}
+
+static void Put32(std::vector<uint8_t>* out, uint32_t v) {
+  Put16(out, v & 0xffff);
+  Put16(out, v >> 16);
+}
+
+static void PutName(std::vector<uint8_t>* out, const std::string& name) {
+  out->insert(out->end(), name.begin(), name.end());
+}
+
+static std::string gLargeZipPath;
+
+static void RemoveLargeZip() {
+  unlink(gLargeZipPath.c_str());
+}
+
+/*
+ * Write an archive of |kNumEntries| small stored entries, and return its
+ * path. The CRCs are bogus, which nothing here checks.
+ */
+static const char* GetLargeZip() {
+  if (!gLargeZipPath.empty()) {
+    return gLargeZipPath.c_str();
+  }
+
+  std::vector<uint8_t> local;
+  std::vector<uint8_t> central;
+  const uint32_t data_size = sizeof(kEntryData) - 1;
+  for (uint16_t i = 0; i < kNumEntries; ++i) {
+    char name[64];
+    snprintf(name, sizeof(name), "res/drawable-xhdpi/entry_%05u.png", i);
+    const std::string entry_name(name);
+    const uint32_t offset = local.size();
+
+    Put32(&local, 0x04034b50);
+    Put16(&local, 10);               // version needed
+    Put16(&local, 0);                // flags
+    Put16(&local, 0);                // stored
+    Put32(&local, 0);                // time, date
+    Put32(&local, 0);                // crc32
+    Put32(&local, data_size);
+    Put32(&local, data_size);
+    Put16(&local, entry_name.size());
+    Put16(&local, 0);                // extra length
+    PutName(&local, entry_name);
+    local.insert(local.end(), kEntryData, kEntryData + data_size);
+
+    Put32(&central, 0x02014b50);
+    Put16(&central, 10);             // version made by
+    Put16(&central, 10);             // version needed
+    Put16(&central, 0);              // flags
+    Put16(&central, 0);              // stored
+    Put32(&central, 0);              // time, date
+    Put32(&central, 0);              // crc32
+    Put32(&central, data_size);
+    Put32(&central, data_size);
+    Put16(&central, entry_name.size());
+    Put16(&central, 0);              // extra length
+    Put16(&central, 0);              // comment length
+    Put16(&central, 0);              // start disk
+    Put16(&central, 0);              // internal attributes
+    Put32(&central, 0);              // external attributes
+    Put32(&central, offset);
+    PutName(&central, entry_name);
+  }
+
+  std::vector<uint8_t> eocd;
+  Put32(&eocd, 0x06054b50);
+  Put16(&eocd, 0);
+  Put16(&eocd, 0);
+  Put16(&eocd, kNumEntries);
+  Put16(&eocd, kNumEntries);
+  Put32(&eocd, central.size());
+  Put32(&eocd, local.size());
+  Put16(&eocd, 0);
+
+  // Account for differences between the host and the target.
+  char temp_path[1024];
+  snprintf(temp_path, sizeof(temp_path), "/data/local/tmp/zip_archive_benchmark_XXXXXX");
+  int fd = mkstemp(temp_path);
+  if (fd == -1) {
+    snprintf(temp_path, sizeof(temp_path), "/tmp/zip_archive_benchmark_XXXXXX");
+    fd = mkstemp(temp_path);
+  }
+  if (fd == -1) {
+    fprintf(stderr, "Unable to create %s\n", temp_path);
+    exit(EXIT_FAILURE);
+  }
+  if (write(fd, &local[0], local.size()) != static_cast<ssize_t>(local.size()) ||
+      write(fd, &central[0], central.size()) != static_cast<ssize_t>(central.size()) ||
+      write(fd, &eocd[0], eocd.size()) != static_cast<ssize_t>(eocd.size())) {
+    fprintf(stderr, "Unable to write %s\n", temp_path);
+    exit(EXIT_FAILURE);
+  }
+  close(fd);
+
+  gLargeZipPath = temp_path;
+  atexit(RemoveLargeZip);
+  return gLargeZipPath.c_str();
+}
+
+static void OpenFindClose(int iters) {
+  const char* path = GetLargeZip();
+
+  StartBenchmarkTiming();
+  for (int i = 0; i < iters; ++i) {
+    ZipArchiveHandle handle;
+    ZipEntry data;
+    if (OpenArchive(path, &handle) != 0 ||
+        FindEntry(handle, "res/drawable-xhdpi/entry_04242.png", &data) != 0) {
+      fprintf(stderr, "Unable to read %s\n", path);
+      exit(EXIT_FAILURE);
+    }
+    CloseArchive(handle);
+  }
+  StopBenchmarkTiming();
+}
+
+/*
+ *	Measure the cost of opening a 10k entry archive and looking up one
+ * entry, as the resource loader does, with the central directory parsed
+ * on every open.
+ */
+static void BM_OpenArchive(int iters) {
+  SetCentralDirectoryCacheSize(0);
+  OpenFindClose(iters);
+}
+BENCHMARK(BM_OpenArchive);
+
+/*
+ *	As above, with the central directory cache enabled. Expect this to be
+ * dominated by the open(2) and the local header reads.
+ */
+static void BM_OpenArchive_cached(int iters) {
+  SetCentralDirectoryCacheSize(8);
+  OpenFindClose(iters);
+  SetCentralDirectoryCacheSize(0);
+}
+BENCHMARK(BM_OpenArchive_cached);
+
+static int32_t CountEntry(const ZipEntryName* /*name*/, ZipEntry* /*data*/,
+                          void* cookie) {
+  ++*reinterpret_cast<int*>(cookie);
+  return 0;
+}
+
+/*
+ *	Measure visiting every entry of a 10k entry archive with StartIteration
+ * and Next, in hash table order.
+ */
+static void BM_Next(int iters) {
+  ZipArchiveHandle handle;
+  OpenArchive(GetLargeZip(), &handle);
+
+  StartBenchmarkTiming();
+  for (int i = 0; i < iters; ++i) {
+    void* cookie;
+    ZipEntry data;
+    ZipEntryName name;
+    StartIteration(handle, &cookie, NULL);
+    while (Next(cookie, &data, &name) == 0) {
+    }
+    free(cookie);
+  }
+  StopBenchmarkTiming();
+
+  CloseArchive(handle);
+}
+BENCHMARK(BM_Next);
+
+/*
+ *	Measure visiting every entry of a 10k entry archive with IterateEntries,
+ * in file order.
+ */
+static void BM_IterateEntries(int iters) {
+  ZipArchiveHandle handle;
+  OpenArchive(GetLargeZip(), &handle);
+
+  StartBenchmarkTiming();
+  for (int i = 0; i < iters; ++i) {
+    int count = 0;
+    IterateEntries(handle, NULL, CountEntry, &count);
+  }
+  StopBenchmarkTiming();
+
+  CloseArchive(handle);
+}
+BENCHMARK(BM_IterateEntries);
@@ -20,6 +20,7 @@
 #include <getopt.h>
 #include <stdio.h>
 #include <unistd.h>
+#include <string>
 #include <vector>
 
 #include <gtest/gtest.h>
@@ -144,11 +145,160 @@ TEST(ziparchive, ExtractToMemory) {
   buffer = new uint8_t[b_size];
   ASSERT_EQ(0, ExtractToMemory(handle, &data, buffer, b_size));
   ASSERT_EQ(0, memcmp(buffer, kBTxtContents, b_size));
+
+  // A stored entry can still be extracted a prefix at a time.
+  memset(buffer, 0, b_size);
+  ASSERT_EQ(0, ExtractToMemory(handle, &data, buffer, b_size / 2));
+  ASSERT_EQ(0, memcmp(buffer, kBTxtContents, b_size / 2));
   delete[] buffer;
 
   CloseArchive(handle);
 }
 
+static void ReadInChunks(ZipArchiveHandle handle, const char* entry_name,
+                         uint32_t chunk_size, std::vector<uint8_t>* out) {
+  ZipEntry data;
+  ASSERT_EQ(0, FindEntry(handle, entry_name, &data));
+
+  ZipReaderHandle reader;
+  ASSERT_EQ(0, StartReading(handle, &data, &reader));
+  std::vector<uint8_t> chunk(chunk_size);
+  int32_t actual;
+  while ((actual = ReadEntryData(reader, &chunk[0], chunk_size)) > 0) {
+    ASSERT_LE(static_cast<uint32_t>(actual), chunk_size);
+    out->insert(out->end(), chunk.begin(), chunk.begin() + actual);
+  }
+  ASSERT_EQ(0, actual);
+
+  // An exhausted reader keeps reporting the end of the entry.
+  ASSERT_EQ(0, ReadEntryData(reader, &chunk[0], chunk_size));
+  EndReading(reader);
+}
+
+TEST(ziparchive, ReadEntryData) {
+  ZipArchiveHandle handle;
+  ASSERT_EQ(0, OpenArchiveWrapper(kValidZip, &handle));
+
+  // A deflated entry, in chunks smaller than the entry.
+  std::vector<uint8_t> a_data;
+  ReadInChunks(handle, "a.txt", 5, &a_data);
+  ASSERT_EQ(sizeof(kATxtContents), a_data.size());
+  ASSERT_EQ(0, memcmp(&a_data[0], kATxtContents, a_data.size()));
+
+  // A stored entry, in one chunk larger than the entry.
+  std::vector<uint8_t> b_data;
+  ReadInChunks(handle, "b.txt", 64, &b_data);
+  ASSERT_EQ(sizeof(kBTxtContents), b_data.size());
+  ASSERT_EQ(0, memcmp(&b_data[0], kBTxtContents, b_data.size()));
+
+  CloseArchive(handle);
+}
+
+TEST(ziparchive, ExtractEntries) {
+  ZipArchiveHandle handle;
+  ASSERT_EQ(0, OpenArchiveWrapper(kValidZip, &handle));
+
+  // Each entry several times over, so that the threads overlap.
+  static const uint32_t kCopies = 8;
+  ZipExtractRequest requests[2 * kCopies];
+  std::vector<std::vector<uint8_t> > buffers(2 * kCopies);
+  for (uint32_t i = 0; i < 2 * kCopies; ++i) {
+    const char* name = (i % 2 == 0) ? "a.txt" : "b.txt";
+    ASSERT_EQ(0, FindEntry(handle, name, &requests[i].entry));
+    buffers[i].resize(requests[i].entry.uncompressed_length);
+    requests[i].begin = &buffers[i][0];
+    requests[i].size = buffers[i].size();
+    requests[i].fd = -1;
+    requests[i].result = -100;
+  }
+
+  ASSERT_EQ(0, ExtractEntries(handle, requests, 2 * kCopies, 4));
+  for (uint32_t i = 0; i < 2 * kCopies; ++i) {
+    ASSERT_EQ(0, requests[i].result);
+    const uint8_t* expected = (i % 2 == 0) ? kATxtContents : kBTxtContents;
+    ASSERT_EQ(0, memcmp(&buffers[i][0], expected, buffers[i].size()));
+  }
+
+  // A bad request is reported without affecting the others. A deflated entry
+  // that does not fit is an error; a stored one would just be truncated.
+  requests[0].size = requests[0].entry.uncompressed_length - 1;
+  const int32_t error = ExtractEntries(handle, requests, 2 * kCopies, 0);
+  ASSERT_GT(0, error);
+  ASSERT_EQ(error, requests[0].result);
+  ASSERT_EQ(0, requests[1].result);
+  ASSERT_EQ(0, requests[2].result);
+
+  CloseArchive(handle);
+}
+
+struct IterateResult {
+  std::vector<std::string> names;
+  int32_t stop_after;
+};
+
+static int32_t CollectNames(const ZipEntryName* name, ZipEntry* data,
+                            void* cookie) {
+  IterateResult* result = reinterpret_cast<IterateResult*>(cookie);
+  if (data->offset == 0) {
+    return -100;
+  }
+  result->names.push_back(std::string(name->name, name->name_length));
+  if (result->stop_after > 0 && --result->stop_after == 0) {
+    return 1;
+  }
+  return 0;
+}
+
+TEST(ziparchive, IterateEntries) {
+  ZipArchiveHandle handle;
+  ASSERT_EQ(0, OpenArchiveWrapper(kValidZip, &handle));
+
+  // Every entry, in central directory order.
+  IterateResult result = { std::vector<std::string>(), 0 };
+  ASSERT_EQ(0, IterateEntries(handle, NULL, CollectNames, &result));
+  ASSERT_EQ(static_cast<size_t>(5), result.names.size());
+
+  // Only the entries under b/, including b/ itself.
+  IterateResult prefixed = { std::vector<std::string>(), 0 };
+  ASSERT_EQ(0, IterateEntries(handle, "b/", CollectNames, &prefixed));
+  ASSERT_EQ(static_cast<size_t>(3), prefixed.names.size());
+  for (size_t i = 0; i < prefixed.names.size(); ++i) {
+    ASSERT_EQ(0u, prefixed.names[i].find("b/"));
+  }
+
+  // A non-zero return from the callback ends the walk.
+  IterateResult stopped = { std::vector<std::string>(), 2 };
+  ASSERT_EQ(1, IterateEntries(handle, NULL, CollectNames, &stopped));
+  ASSERT_EQ(static_cast<size_t>(2), stopped.names.size());
+  ASSERT_EQ(result.names[0], stopped.names[0]);
+  ASSERT_EQ(result.names[1], stopped.names[1]);
+
+  CloseArchive(handle);
+}
+
+TEST(ziparchive, CentralDirectoryCache) {
+  SetCentralDirectoryCacheSize(1);
+
+  ZipArchiveHandle first;
+  ZipArchiveHandle second;
+  ASSERT_EQ(0, OpenArchiveWrapper(kValidZip, &first));
+  ASSERT_EQ(0, OpenArchiveWrapper(kValidZip, &second));
+
+  // Dropping the cache must not invalidate the handles sharing it.
+  SetCentralDirectoryCacheSize(0);
+  CloseArchive(first);
+
+  ZipEntry data;
+  ASSERT_EQ(0, FindEntry(second, "a.txt", &data));
+  ASSERT_EQ(kCompressDeflated, data.method);
+  ASSERT_EQ(static_cast<uint32_t>(17), data.uncompressed_length);
+  uint8_t buffer[sizeof(kATxtContents)];
+  ASSERT_EQ(0, ExtractToMemory(second, &data, buffer, sizeof(buffer)));
+  ASSERT_EQ(0, memcmp(buffer, kATxtContents, sizeof(buffer)));
+
+  CloseArchive(second);
+}
+
 static const uint32_t kEmptyEntriesZip[] = {
       0x04034b50, 0x0000000a, 0x63600000, 0x00004438, 0x00000000, 0x00000000,
       0x00090000, 0x6d65001c, 0x2e797470, 0x55747874, 0x03000954, 0x52e25c13,
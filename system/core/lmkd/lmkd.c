@@ -18,6 +18,7 @@
 
 #include <arpa/inet.h>
 #include <errno.h>
+#include <math.h>
 #include <signal.h>
 #include <stdlib.h>
 #include <string.h>
@@ -39,7 +40,6 @@
 #endif
 
 #define MEMCG_SYSFS_PATH "/dev/memcg/"
-#define MEMPRESSURE_WATCH_LEVEL "medium"
 #define ZONEINFO_PATH "/proc/zoneinfo"
 #define LINE_MAX 128
 
@@ -64,16 +64,52 @@ enum lmk_cmd {
 /* default to old in-kernel interface if no memory pressure events */
 static int use_inkernel_interface = 1;
 
-/* memory pressure level medium event */
-static int mpevfd;
+/*
+ * vmpressure levels we listen for.  A listener for a level also hears
+ * every higher level, so one pressure spike usually signals several of
+ * these at once.
+ */
+enum vmpressure_level {
+    VMPRESS_LEVEL_LOW,
+    VMPRESS_LEVEL_MEDIUM,
+    VMPRESS_LEVEL_CRITICAL,
+    VMPRESS_LEVEL_COUNT
+};
+
+static const char *level_name[] = {
+    "low",
+    "medium",
+    "critical"
+};
+
+/* memory pressure level events */
+static int mpevfd[VMPRESS_LEVEL_COUNT] = { -1, -1, -1 };
+
+/*
+ * Pressure score, 0 to 100.  Each event adds the weight of its level and
+ * the score decays by half every PRESSURE_HALFLIFE_MS, so it tracks how
+ * much of the last few seconds were spent under pressure, much like the
+ * avg10 of PSI.  A sustained score raises the free memory we kill up to.
+ */
+#define PRESSURE_SCORE_MAX 100
+#define PRESSURE_HALFLIFE_MS 2000
+static const int level_weight[VMPRESS_LEVEL_COUNT] = { 5, 20, 50 };
+static double pressure_score;
+static struct timespec pressure_score_time;
+
+/* score above which low level events alone start kills */
+#define PRESSURE_SCORE_LOW_KILL 60
+
+/* upper bound on kills made in response to one pressure event */
+#define MAX_KILL_BATCH 8
 
 /* control socket listen and data */
 static int ctrl_lfd;
 static int ctrl_dfd = -1;
 static int ctrl_dfd_reopened; /* did we reopen ctrl conn on this loop? */
 
-/* 1 memory pressure level, 1 ctrl listen socket, 1 ctrl data socket */
-#define MAX_EPOLL_EVENTS 3
+/* 3 memory pressure levels, 1 ctrl listen socket, 1 ctrl data socket */
+#define MAX_EPOLL_EVENTS (VMPRESS_LEVEL_COUNT + 2)
 static int epollfd;
 static int maxevents;
 
@@ -183,12 +219,6 @@ static void adjslot_remove(struct adjslot_list *old)
     prev->next = next;
 }
 
-static struct adjslot_list *adjslot_tail(struct adjslot_list *head) {
-    struct adjslot_list *asl = head->prev;
-
-    return asl == head ? NULL : asl;
-}
-
 static void proc_slot(struct proc *procp) {
     int adjslot = ADJTOSLOT(procp->oomadj);
 
@@ -556,18 +586,47 @@ static char *proc_get_name(int pid) {
     return line;
 }
 
-static struct proc *proc_adj_lru(int oomadj) {
-    return (struct proc *)adjslot_tail(&procadjslot_list[ADJTOSLOT(oomadj)]);
+/*
+ * Find the process with the largest RSS in an adj slot, and its size in
+ * pages.  Processes that have gone away are dropped along the way.
+ */
+static struct proc *proc_adj_heaviest(int oomadj, int *sizep) {
+    struct adjslot_list *head = &procadjslot_list[ADJTOSLOT(oomadj)];
+    struct adjslot_list *asl;
+    struct adjslot_list *next;
+    struct proc *maxprocp = NULL;
+    int maxsize = 0;
+
+    for (asl = head->next; asl != head; asl = next) {
+        struct proc *procp = (struct proc *)asl;
+        int size;
+
+        next = asl->next;
+        size = proc_get_size(procp->pid);
+        if (size <= 0) {
+            pid_remove(procp->pid);
+            continue;
+        }
+        if (size > maxsize) {
+            maxsize = size;
+            maxprocp = procp;
+        }
+    }
+
+    *sizep = maxsize;
+    return maxprocp;
 }
 
-/* Kill one process specified by procp.  Returns the size of the process killed */
-static int kill_one_process(struct proc *procp, int other_free, int other_file,
-        int minfree, int min_score_adj, bool first)
+/*
+ * Kill one process specified by procp, of tasksize pages.  Returns the size
+ * of the process killed
+ */
+static int kill_one_process(struct proc *procp, int tasksize, int other_free,
+        int other_file, int minfree, int min_score_adj, bool first)
 {
     int pid = procp->pid;
     uid_t uid = procp->uid;
     char *taskname;
-    int tasksize;
     int r;
 
     taskname = proc_get_name(pid);
@@ -576,12 +635,6 @@ static int kill_one_process(struct proc *procp, int other_free, int other_file,
         return -1;
     }
 
-    tasksize = proc_get_size(pid);
-    if (tasksize <= 0) {
-        pid_remove(pid);
-        return -1;
-    }
-
     ALOGI("Killing '%s' (%d), uid %d, adj %d\n"
           "   to free %ldkB because cache %s%ldkB is below limit %ldkB for oom_adj %d\n"
           "   Free memory is %s%ldkB %s reserved",
@@ -602,18 +655,20 @@ static int kill_one_process(struct proc *procp, int other_free, int other_file,
 
 /*
  * Find a process to kill based on the current (possibly estimated) free memory
- * and cached memory sizes.  Returns the size of the killed processes.
+ * and cached memory sizes, with the minfree limits scaled by headroom percent.
+ * The largest process in the least important eligible adj slot goes first.
+ * Returns the size of the killed processes.
  */
-static int find_and_kill_process(int other_free, int other_file, bool first)
+static int find_and_kill_process(int other_free, int other_file, int headroom,
+        bool first)
 {
     int i;
-    int r;
     int min_score_adj = OOM_ADJUST_MAX + 1;
     int minfree = 0;
     int killed_size = 0;
 
     for (i = 0; i < lowmem_targets_size; i++) {
-        minfree = lowmem_minfree[i];
+        minfree = (long)lowmem_minfree[i] * headroom / 100;
         if (other_free < minfree && other_file < minfree) {
             min_score_adj = lowmem_adj[i];
             break;
@@ -625,12 +680,14 @@ static int find_and_kill_process(int other_free, int other_file, bool first)
 
     for (i = OOM_ADJUST_MAX; i >= min_score_adj; i--) {
         struct proc *procp;
+        int tasksize;
 
 retry:
-        procp = proc_adj_lru(i);
+        procp = proc_adj_heaviest(i, &tasksize);
 
         if (procp) {
-            killed_size = kill_one_process(procp, other_free, other_file, minfree, min_score_adj, first);
+            killed_size = kill_one_process(procp, tasksize, other_free, other_file,
+                                           minfree, min_score_adj, first);
             if (killed_size < 0) {
                 goto retry;
             } else {
@@ -642,44 +699,114 @@ retry:
     return 0;
 }
 
+/*
+ * Read every pressure eventfd and return the highest level signalled, or -1
+ * if none was.  The eventfds are non-blocking, so the handlers for levels
+ * that were already drained by an earlier handler find nothing to do.
+ */
+static int mp_read_levels(void) {
+    int level;
+    int max_level = -1;
+
+    for (level = 0; level < VMPRESS_LEVEL_COUNT; level++) {
+        unsigned long long evcount;
+        int ret;
+
+        if (mpevfd[level] < 0)
+            continue;
+
+        ret = read(mpevfd[level], &evcount, sizeof(evcount));
+        if (ret < 0) {
+            if (errno != EAGAIN)
+                ALOGE("Error reading %s memory pressure event fd; errno=%d",
+                      level_name[level], errno);
+            continue;
+        }
+        if (evcount > 0)
+            max_level = level;
+    }
+
+    return max_level;
+}
+
+static void pressure_score_update(int level) {
+    struct timespec now;
+    double elapsed_ms;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    elapsed_ms = (now.tv_sec - pressure_score_time.tv_sec) * 1000.0 +
+                 (now.tv_nsec - pressure_score_time.tv_nsec) / 1000000.0;
+    pressure_score_time = now;
+
+    pressure_score *= exp2(-elapsed_ms / PRESSURE_HALFLIFE_MS);
+    pressure_score += level_weight[level];
+    if (pressure_score > PRESSURE_SCORE_MAX)
+        pressure_score = PRESSURE_SCORE_MAX;
+}
+
 static void mp_event(uint32_t events __unused) {
-    int i;
-    int ret;
-    unsigned long long evcount;
+    int level;
+    int score;
+    int headroom;
     struct sysmeminfo mi;
     int other_free;
     int other_file;
     int killed_size;
+    int killed_total = 0;
+    int kills = 0;
     bool first = true;
 
-    ret = read(mpevfd, &evcount, sizeof(evcount));
-    if (ret < 0)
-        ALOGE("Error reading memory pressure event fd; errno=%d",
-              errno);
+    level = mp_read_levels();
+    if (level < 0)
+        return;
+
+    pressure_score_update(level);
+    score = (int)pressure_score;
+
+    /* Low pressure alone is only worth a kill once it has been sustained. */
+    if (level == VMPRESS_LEVEL_LOW && score < PRESSURE_SCORE_LOW_KILL)
+        return;
 
-    if (time(NULL) - kill_lasttime < KILL_TIMEOUT)
+    /* Give the last batch time to die, unless things have become critical. */
+    if (level != VMPRESS_LEVEL_CRITICAL &&
+        time(NULL) - kill_lasttime < KILL_TIMEOUT)
         return;
 
     while (zoneinfo_parse(&mi) < 0) {
         // Failed to read /proc/zoneinfo, assume ENOMEM and kill something
-        find_and_kill_process(0, 0, true);
+        find_and_kill_process(0, 0, 100, true);
     }
 
     other_free = mi.nr_free_pages - mi.totalreserve_pages;
     other_file = mi.nr_file_pages - mi.nr_shmem;
 
+    /*
+     * Kill until the estimated free memory clears the minfree limits in one
+     * go, rather than one process per event.  The more pressure we have seen
+     * recently, the further past the limits we aim.
+     */
+    headroom = 100 + score;
     do {
-        killed_size = find_and_kill_process(other_free, other_file, first);
+        killed_size = find_and_kill_process(other_free, other_file, headroom, first);
         if (killed_size > 0) {
             first = false;
             other_free += killed_size;
             other_file += killed_size;
+            killed_total += killed_size;
+            kills++;
         }
-    } while (killed_size > 0);
+    } while (killed_size > 0 && kills < MAX_KILL_BATCH);
+
+    if (kills) {
+        kill_lasttime = time(NULL);
+        ALOGI("Killed %d processes for %ldkB at %s pressure (score %d)",
+              kills, killed_total * page_k, level_name[level], score);
+    }
 }
 
-static int init_mp(char *levelstr, void *event_handler)
+static int init_mp(int level, void *event_handler)
 {
+    const char *levelstr = level_name[level];
     int mpfd;
     int evfd;
     int evctlfd;
@@ -726,7 +853,7 @@ static int init_mp(char *levelstr, void *event_handler)
         goto err;
     }
     maxevents++;
-    mpevfd = evfd;
+    mpevfd[level] = evfd;
     return 0;
 
 err:
@@ -780,8 +907,14 @@ static int init(void) {
     if (use_inkernel_interface) {
         ALOGI("Using in-kernel low memory killer interface");
     } else {
-        ret = init_mp(MEMPRESSURE_WATCH_LEVEL, (void *)&mp_event);
-        if (ret)
+        int level;
+
+        for (level = 0; level < VMPRESS_LEVEL_COUNT; level++) {
+            ret = init_mp(level, (void *)&mp_event);
+            if (ret)
+                break;
+        }
+        if (mpevfd[VMPRESS_LEVEL_LOW] < 0)
             ALOGE("Kernel does not support memory pressure events or in-kernel low memory killer");
     }
 
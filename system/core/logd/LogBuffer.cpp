@@ -94,8 +94,13 @@ static unsigned long property_get_size(const char *key) {
 
 LogBuffer::LogBuffer(LastLogTimes *times)
         : dgramQlenStatistics(false)
+        , mDgramQlenNext(0)
+        , mDgramQlenCount(0)
         , mTimes(*times) {
-    pthread_mutex_init(&mLogElementsLock, NULL);
+    log_id_for_each(i) {
+        pthread_mutex_init(&mLogElementsLock[i], NULL);
+    }
+    pthread_mutex_init(&mDgramQlenLock, NULL);
 
     static const char global_tuneable[] = "persist.logd.size"; // Settings App
     static const char global_default[] = "ro.logd.size";       // BoardConfig.mk
@@ -132,89 +137,94 @@ LogBuffer::LogBuffer(LastLogTimes *times)
     }
 }
 
+// Locks are always acquired in log id order.
+void LogBuffer::lockAll(void) {
+    log_id_for_each(i) {
+        lock(i);
+    }
+}
+
+void LogBuffer::unlockAll(void) {
+    log_id_for_each(i) {
+        unlock(i);
+    }
+}
+
+// Only the buffers selected by logMask, still in log id order.
+void LogBuffer::lockMask(unsigned int logMask) {
+    log_id_for_each(i) {
+        if (logMask & (1 << i)) {
+            lock(i);
+        }
+    }
+}
+
+void LogBuffer::unlockMask(unsigned int logMask) {
+    log_id_for_each(i) {
+        if (logMask & (1 << i)) {
+            unlock(i);
+        }
+    }
+}
+
 void LogBuffer::log(log_id_t log_id, log_time realtime,
                     uid_t uid, pid_t pid, pid_t tid,
                     const char *msg, unsigned short len) {
     if ((log_id >= LOG_ID_MAX) || (log_id < 0)) {
         return;
     }
+
+    // halves the peak performance, use with caution
+    if (dgramQlenStatistics) {
+        recordDgramQlen(realtime);
+    }
+
+    lock(log_id);
+
+    // The monotonic timestamp is acquired with the lock held, so appending
+    // keeps each collection sorted and readers never see an element slip
+    // in behind their region lock.
     LogBufferElement *elem = new LogBufferElement(log_id, realtime,
                                                   uid, pid, tid, msg, len);
+    mLogElements[log_id].push_back(elem);
+    elem->setPosition(--mLogElements[log_id].end());
 
-    pthread_mutex_lock(&mLogElementsLock);
-
-    // Insert elements in time sorted order if possible
-    //  NB: if end is region locked, place element at end of list
-    LogBufferElementCollection::iterator it = mLogElements.end();
-    LogBufferElementCollection::iterator last = it;
-    while (--it != mLogElements.begin()) {
-        if ((*it)->getRealTime() <= realtime) {
-            // halves the peak performance, use with caution
-            if (dgramQlenStatistics) {
-                LogBufferElementCollection::iterator ib = it;
-                unsigned short buckets, num = 1;
-                for (unsigned short i = 0; (buckets = stats.dgramQlen(i)); ++i) {
-                    buckets -= num;
-                    num += buckets;
-                    while (buckets && (--ib != mLogElements.begin())) {
-                        --buckets;
-                    }
-                    if (buckets) {
-                        break;
-                    }
-                    stats.recordDiff(
-                        elem->getRealTime() - (*ib)->getRealTime(), i);
-                }
-            }
-            break;
-        }
-        last = it;
-    }
+    stats.add(elem);
+    maybePrune(log_id);
+    unlock(log_id);
+}
 
-    if (last == mLogElements.end()) {
-        mLogElements.push_back(elem);
-    } else {
-        log_time end = log_time::EPOCH;
-        bool end_set = false;
-        bool end_always = false;
-
-        LogTimeEntry::lock();
-
-        LastLogTimes::iterator t = mTimes.begin();
-        while(t != mTimes.end()) {
-            LogTimeEntry *entry = (*t);
-            if (entry->owned_Locked()) {
-                if (!entry->mNonBlock) {
-                    end_always = true;
-                    break;
-                }
-                if (!end_set || (end <= entry->mEnd)) {
-                    end = entry->mEnd;
-                    end_set = true;
-                }
-            }
-            t++;
-        }
+// Record the time from start to finish of each dgramQlen bucket, across all
+// log ids since they all arrive on the same socket.
+void LogBuffer::recordDgramQlen(log_time realtime) {
+    pthread_mutex_lock(&mDgramQlenLock);
 
-        if (end_always
-                || (end_set && (end >= (*last)->getMonotonicTime()))) {
-            mLogElements.push_back(elem);
-        } else {
-            mLogElements.insert(last,elem);
+    unsigned short qlen;
+    for (unsigned short i = 0; (qlen = stats.dgramQlen(i)); ++i) {
+        if (qlen > mDgramQlenCount) {
+            break;
         }
+        const log_time &then = mDgramQlenHistory[
+            (mDgramQlenNext + LOG_BUFFER_DGRAM_QLEN_HISTORY - qlen)
+                % LOG_BUFFER_DGRAM_QLEN_HISTORY];
+        if (then <= realtime) {
+            stats.recordDiff(realtime - then, i);
+        }
+    }
 
-        LogTimeEntry::unlock();
+    mDgramQlenHistory[mDgramQlenNext] = realtime;
+    mDgramQlenNext = (mDgramQlenNext + 1) % LOG_BUFFER_DGRAM_QLEN_HISTORY;
+    if (mDgramQlenCount < LOG_BUFFER_DGRAM_QLEN_HISTORY) {
+        ++mDgramQlenCount;
     }
 
-    stats.add(len, log_id, uid, pid);
-    maybePrune(log_id);
-    pthread_mutex_unlock(&mLogElementsLock);
+    pthread_mutex_unlock(&mDgramQlenLock);
 }
 
 // If we're using more than 256K of memory for log entries, prune
 // at least 10% of the log entries.
 //
-// mLogElementsLock must be held when this function is called.
+// mLogElementsLock[id] must be held when this function is called.
 void LogBuffer::maybePrune(log_id_t id) {
     size_t sizes = stats.sizes(id);
     if (sizes > log_buffer_size(id)) {
@@ -231,9 +241,10 @@ void LogBuffer::maybePrune(log_id_t id) {
 
 // prune "pruneRows" of type "id" from the buffer.
 //
-// mLogElementsLock must be held when this function is called.
+// mLogElementsLock[id] must be held when this function is called.
 void LogBuffer::prune(log_id_t id, unsigned long pruneRows, uid_t caller_uid) {
     LogTimeEntry *oldest = NULL;
+    LogBufferElementCollection &list = mLogElements[id];
 
     LogTimeEntry::lock();
 
@@ -251,23 +262,18 @@ void LogBuffer::prune(log_id_t id, unsigned long pruneRows, uid_t caller_uid) {
     LogBufferElementCollection::iterator it;
 
     if (caller_uid != AID_ROOT) {
-        for(it = mLogElements.begin(); it != mLogElements.end();) {
+        for(it = list.begin(); it != list.end();) {
             LogBufferElement *e = *it;
 
             if (oldest && (oldest->mStart <= e->getMonotonicTime())) {
                 break;
             }
 
-            if (e->getLogId() != id) {
-                ++it;
-                continue;
-            }
-
             uid_t uid = e->getUid();
 
             if (uid == caller_uid) {
-                it = mLogElements.erase(it);
-                stats.subtract(e->getMsgLen(), id, uid, e->getPid());
+                it = list.erase(it);
+                stats.subtract(e);
                 delete e;
                 pruneRows--;
                 if (pruneRows == 0) {
@@ -284,56 +290,70 @@ void LogBuffer::prune(log_id_t id, unsigned long pruneRows, uid_t caller_uid) {
     // prune by worst offender by uid
     while (pruneRows > 0) {
         // recalculate the worst offender on every batched pass
-        uid_t worst = (uid_t) -1;
+        UidStatistics *worst = NULL;
         size_t worst_sizes = 0;
         size_t second_worst_sizes = 0;
 
         if ((id != LOG_ID_CRASH) && mPrune.worstUidEnabled()) {
             LidStatistics &l = stats.id(id);
-            l.sort();
-            UidStatisticsCollection::iterator iu = l.begin();
-            if (iu != l.end()) {
-                UidStatistics *u = *iu;
-                worst = u->getUid();
-                worst_sizes = u->sizes();
-                if (++iu != l.end()) {
-                    second_worst_sizes = (*iu)->sizes();
-                }
+            worst = l.worst();
+            if (worst) {
+                worst_sizes = worst->sizes();
+                second_worst_sizes = l.secondWorstSizes();
             }
         }
 
         bool kick = false;
-        for(it = mLogElements.begin(); it != mLogElements.end();) {
-            LogBufferElement *e = *it;
-
-            if (oldest && (oldest->mStart <= e->getMonotonicTime())) {
-                break;
-            }
-
-            if (e->getLogId() != id) {
-                ++it;
-                continue;
-            }
 
-            uid_t uid = e->getUid();
+        if (worst && !mPrune.naughtyEnabled()) {
+            // Walk just the worst offender's entries, oldest first
+            LogBufferElement *e;
+            while ((e = worst->oldest())) {
+                if (oldest && (oldest->mStart <= e->getMonotonicTime())) {
+                    break;
+                }
 
-            if ((uid == worst) || mPrune.naughty(e)) { // Worst or BlackListed
-                it = mLogElements.erase(it);
+                list.erase(e->getPosition());
                 unsigned short len = e->getMsgLen();
-                stats.subtract(len, id, uid, e->getPid());
+                stats.subtract(e);
                 delete e;
                 pruneRows--;
-                if (uid == worst) {
-                    kick = true;
-                    if ((pruneRows == 0) || (worst_sizes < second_worst_sizes)) {
+                kick = true;
+                if ((pruneRows == 0) || (worst_sizes < second_worst_sizes)) {
+                    break;
+                }
+                worst_sizes -= len;
+            }
+        } else {
+            uid_t worst_uid = worst ? worst->getUid() : (uid_t) -1;
+
+            for(it = list.begin(); it != list.end();) {
+                LogBufferElement *e = *it;
+
+                if (oldest && (oldest->mStart <= e->getMonotonicTime())) {
+                    break;
+                }
+
+                uid_t uid = e->getUid();
+
+                if ((uid == worst_uid) || mPrune.naughty(e)) { // Worst or BlackListed
+                    it = list.erase(it);
+                    unsigned short len = e->getMsgLen();
+                    stats.subtract(e);
+                    delete e;
+                    pruneRows--;
+                    if (uid == worst_uid) {
+                        kick = true;
+                        if ((pruneRows == 0) || (worst_sizes < second_worst_sizes)) {
+                            break;
+                        }
+                        worst_sizes -= len;
+                    } else if (pruneRows == 0) {
                         break;
                     }
-                    worst_sizes -= len;
-                } else if (pruneRows == 0) {
-                    break;
+                } else {
+                    ++it;
                 }
-            } else {
-                ++it;
             }
         }
 
@@ -342,59 +362,52 @@ void LogBuffer::prune(log_id_t id, unsigned long pruneRows, uid_t caller_uid) {
         }
     }
 
+    // Collection holds only "id", oldest first, so every step removes a row
     bool whitelist = false;
-    it = mLogElements.begin();
-    while((pruneRows > 0) && (it != mLogElements.end())) {
+    it = list.begin();
+    while((pruneRows > 0) && (it != list.end())) {
         LogBufferElement *e = *it;
-        if (e->getLogId() == id) {
-            if (oldest && (oldest->mStart <= e->getMonotonicTime())) {
-                if (!whitelist) {
-                    if (stats.sizes(id) > (2 * log_buffer_size(id))) {
-                        // kick a misbehaving log reader client off the island
-                        oldest->release_Locked();
-                    } else {
-                        oldest->triggerSkip_Locked(pruneRows);
-                    }
+        if (oldest && (oldest->mStart <= e->getMonotonicTime())) {
+            if (!whitelist) {
+                if (stats.sizes(id) > (2 * log_buffer_size(id))) {
+                    // kick a misbehaving log reader client off the island
+                    oldest->release_Locked();
+                } else {
+                    oldest->triggerSkip_Locked(pruneRows);
                 }
-                break;
-            }
-
-            if (mPrune.nice(e)) { // WhiteListed
-                whitelist = true;
-                it++;
-                continue;
             }
+            break;
+        }
 
-            it = mLogElements.erase(it);
-            stats.subtract(e->getMsgLen(), id, e->getUid(), e->getPid());
-            delete e;
-            pruneRows--;
-        } else {
+        if (mPrune.nice(e)) { // WhiteListed
+            whitelist = true;
             it++;
+            continue;
         }
+
+        it = list.erase(it);
+        stats.subtract(e);
+        delete e;
+        pruneRows--;
     }
 
     if (whitelist && (pruneRows > 0)) {
-        it = mLogElements.begin();
-        while((it != mLogElements.end()) && (pruneRows > 0)) {
+        it = list.begin();
+        while((it != list.end()) && (pruneRows > 0)) {
             LogBufferElement *e = *it;
-            if (e->getLogId() == id) {
-                if (oldest && (oldest->mStart <= e->getMonotonicTime())) {
-                    if (stats.sizes(id) > (2 * log_buffer_size(id))) {
-                        // kick a misbehaving log reader client off the island
-                        oldest->release_Locked();
-                    } else {
-                        oldest->triggerSkip_Locked(pruneRows);
-                    }
-                    break;
+            if (oldest && (oldest->mStart <= e->getMonotonicTime())) {
+                if (stats.sizes(id) > (2 * log_buffer_size(id))) {
+                    // kick a misbehaving log reader client off the island
+                    oldest->release_Locked();
+                } else {
+                    oldest->triggerSkip_Locked(pruneRows);
                 }
-                it = mLogElements.erase(it);
-                stats.subtract(e->getMsgLen(), id, e->getUid(), e->getPid());
-                delete e;
-                pruneRows--;
-            } else {
-                it++;
+                break;
             }
+            it = list.erase(it);
+            stats.subtract(e);
+            delete e;
+            pruneRows--;
         }
     }
 
@@ -403,16 +416,16 @@ void LogBuffer::prune(log_id_t id, unsigned long pruneRows, uid_t caller_uid) {
 
 // clear all rows of type "id" from the buffer.
 void LogBuffer::clear(log_id_t id, uid_t uid) {
-    pthread_mutex_lock(&mLogElementsLock);
+    lock(id);
     prune(id, ULONG_MAX, uid);
-    pthread_mutex_unlock(&mLogElementsLock);
+    unlock(id);
 }
 
 // get the used space associated with "id".
 unsigned long LogBuffer::getSizeUsed(log_id_t id) {
-    pthread_mutex_lock(&mLogElementsLock);
+    lock(id);
     size_t retval = stats.sizes(id);
-    pthread_mutex_unlock(&mLogElementsLock);
+    unlock(id);
     return retval;
 }
 
@@ -422,36 +435,95 @@ int LogBuffer::setSize(log_id_t id, unsigned long size) {
     if (!valid_size(size)) {
         return -1;
     }
-    pthread_mutex_lock(&mLogElementsLock);
+    lock(id);
     log_buffer_size(id) = size;
-    pthread_mutex_unlock(&mLogElementsLock);
+    unlock(id);
     return 0;
 }
 
 // get the total space allocated to "id"
 unsigned long LogBuffer::getSize(log_id_t id) {
-    pthread_mutex_lock(&mLogElementsLock);
+    lock(id);
     size_t retval = log_buffer_size(id);
-    pthread_mutex_unlock(&mLogElementsLock);
+    unlock(id);
     return retval;
 }
 
+// Find the first element of type "id" newer than "start".
+//
+// mLogElementsLock[id] must be held when this function is called.
+LogBufferElementCollection::iterator LogBuffer::seek_Locked(log_id_t id,
+                                                            log_time start) {
+    LogBufferElementCollection &list = mLogElements[id];
+
+    if (list.empty() || ((*list.begin())->getMonotonicTime() > start)) {
+        return list.begin();
+    }
+
+    // Readers are usually caught up, walk back over the newest entries.
+    LogBufferElementCollection::iterator it = list.end();
+    while (it != list.begin()) {
+        LogBufferElementCollection::iterator prev = it;
+        if ((*--prev)->getMonotonicTime() <= start) {
+            break;
+        }
+        it = prev;
+    }
+    return it;
+}
+
 log_time LogBuffer::flushTo(
-        SocketClient *reader, const log_time start, bool privileged,
+        SocketClient *reader, const log_time start, unsigned int logMask,
+        bool privileged,
         bool (*filter)(const LogBufferElement *element, void *arg), void *arg) {
-    LogBufferElementCollection::iterator it;
+    LogBufferElementCollection::iterator it[LOG_ID_MAX];
+    log_time last[LOG_ID_MAX];
     log_time max = start;
     uid_t uid = reader->getUid();
 
-    pthread_mutex_lock(&mLogElementsLock);
-    for (it = mLogElements.begin(); it != mLogElements.end(); ++it) {
-        LogBufferElement *element = *it;
+    // Writers of the buffers the reader does not want are never held up.
+    logMask &= (1 << LOG_ID_MAX) - 1;
+    lockMask(logMask);
 
-        if (!privileged && (element->getUid() != uid)) {
+    log_id_for_each(i) {
+        if (!(logMask & (1 << i))) {
             continue;
         }
+        it[i] = seek_Locked(i, start);
+        last[i] = start;
+    }
+
+    for (;;) {
+        // Merge the per id collections in monotonic time order
+        LogBufferElement *element = NULL;
+        log_id_t id = LOG_ID_MIN;
+        log_id_for_each(i) {
+            if (!(logMask & (1 << i))) {
+                continue;
+            }
+            if (it[i] == mLogElements[i].end()) {
+                // pick up anything appended while we were unlocked
+                it[i] = seek_Locked(i, last[i]);
+                if (it[i] == mLogElements[i].end()) {
+                    continue;
+                }
+            }
+            LogBufferElement *e = *it[i];
+            if (!element
+                    || (e->getMonotonicTime() < element->getMonotonicTime())) {
+                element = e;
+                id = i;
+            }
+        }
+
+        if (!element) {
+            break;
+        }
 
-        if (element->getMonotonicTime() <= start) {
+        ++it[id];
+        last[id] = element->getMonotonicTime();
+
+        if (!privileged && (element->getUid() != uid)) {
             continue;
         }
 
@@ -460,18 +532,19 @@ log_time LogBuffer::flushTo(
             continue;
         }
 
-        pthread_mutex_unlock(&mLogElementsLock);
+        unlockMask(logMask);
 
-        // range locking in LastLogTimes looks after us
+        // range locking in LastLogTimes looks after us, every iterator we
+        // hold is at least as new as this element.
         max = element->flushTo(reader);
 
         if (max == element->FLUSH_ERROR) {
             return max;
         }
 
-        pthread_mutex_lock(&mLogElementsLock);
+        lockMask(logMask);
     }
-    pthread_mutex_unlock(&mLogElementsLock);
+    unlockMask(logMask);
 
     return max;
 }
@@ -479,20 +552,20 @@ log_time LogBuffer::flushTo(
 void LogBuffer::formatStatistics(char **strp, uid_t uid, unsigned int logMask) {
     log_time oldest(CLOCK_MONOTONIC);
 
-    pthread_mutex_lock(&mLogElementsLock);
+    lockAll();
 
     // Find oldest element in the log(s)
-    LogBufferElementCollection::iterator it;
-    for (it = mLogElements.begin(); it != mLogElements.end(); ++it) {
-        LogBufferElement *element = *it;
-
-        if ((logMask & (1 << element->getLogId()))) {
+    log_id_for_each(i) {
+        if (!(logMask & (1 << i)) || mLogElements[i].empty()) {
+            continue;
+        }
+        LogBufferElement *element = *mLogElements[i].begin();
+        if (element->getMonotonicTime() < oldest) {
             oldest = element->getMonotonicTime();
-            break;
         }
     }
 
     stats.format(strp, uid, logMask, oldest);
 
-    pthread_mutex_unlock(&mLogElementsLock);
+    unlockAll();
 }
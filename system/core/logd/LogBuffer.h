@@ -21,7 +21,6 @@
 
 #include <log/log.h>
 #include <sysutils/SocketClient.h>
-#include <utils/List.h>
 
 #include <private/android_filesystem_config.h>
 
@@ -30,15 +29,23 @@
 #include "LogStatistics.h"
 #include "LogWhiteBlackList.h"
 
-typedef android::List<LogBufferElement *> LogBufferElementCollection;
+// Must cover the largest LogStatistics::dgramQlen() bucket
+#define LOG_BUFFER_DGRAM_QLEN_HISTORY 600
 
 class LogBuffer {
-    LogBufferElementCollection mLogElements;
-    pthread_mutex_t mLogElementsLock;
+    // One collection and lock per log id, each kept in monotonic time order.
+    LogBufferElementCollection mLogElements[LOG_ID_MAX];
+    pthread_mutex_t mLogElementsLock[LOG_ID_MAX];
 
     LogStatistics stats;
     bool dgramQlenStatistics;
 
+    // dgramQlen statistics span all log ids, record arrivals separately
+    pthread_mutex_t mDgramQlenLock;
+    log_time mDgramQlenHistory[LOG_BUFFER_DGRAM_QLEN_HISTORY];
+    unsigned short mDgramQlenNext;
+    unsigned short mDgramQlenCount;
+
     PruneList mPrune;
 
     unsigned long mMaxSize[LOG_ID_MAX];
@@ -52,7 +59,7 @@ public:
              uid_t uid, pid_t pid, pid_t tid,
              const char *msg, unsigned short len);
     log_time flushTo(SocketClient *writer, const log_time start,
-                     bool privileged,
+                     unsigned int logMask, bool privileged,
                      bool (*filter)(const LogBufferElement *element, void *arg) = NULL,
                      void *arg = NULL);
 
@@ -81,6 +88,16 @@ public:
     uid_t pidToUid(pid_t pid) { return stats.pidToUid(pid); }
 
 private:
+    void lock(log_id_t id) { pthread_mutex_lock(&mLogElementsLock[id]); }
+    void unlock(log_id_t id) { pthread_mutex_unlock(&mLogElementsLock[id]); }
+    void lockAll(void);
+    void unlockAll(void);
+    void lockMask(unsigned int logMask);
+    void unlockMask(unsigned int logMask);
+
+    LogBufferElementCollection::iterator seek_Locked(log_id_t id,
+                                                     log_time start);
+    void recordDgramQlen(log_time realtime);
     void maybePrune(log_id_t id);
     void prune(log_id_t id, unsigned long pruneRows, uid_t uid = AID_ROOT);
 
@@ -21,8 +21,15 @@
 #include <sysutils/SocketClient.h>
 #include <log/log.h>
 #include <log/log_read.h>
+#include <utils/List.h>
+
+class LogBufferElement;
+
+typedef android::List<LogBufferElement *> LogBufferElementCollection;
 
 class LogBufferElement {
+    friend class UidStatistics;
+
     const log_id_t mLogId;
     const uid_t mUid;
     const pid_t mPid;
@@ -32,6 +39,12 @@ class LogBufferElement {
     const log_time mMonotonicTime;
     const log_time mRealTime;
 
+    // Position in the LogBuffer collection for mLogId, set by LogBuffer
+    LogBufferElementCollection::iterator mPosition;
+    // Elements sharing mLogId and mUid, oldest first, kept by UidStatistics
+    LogBufferElement *mUidPrev;
+    LogBufferElement *mUidNext;
+
 public:
     LogBufferElement(log_id_t log_id, log_time realtime,
                      uid_t uid, pid_t pid, pid_t tid,
@@ -46,6 +59,9 @@ public:
     log_time getMonotonicTime(void) const { return mMonotonicTime; }
     log_time getRealTime(void) const { return mRealTime; }
 
+    LogBufferElementCollection::iterator getPosition() const { return mPosition; }
+    void setPosition(LogBufferElementCollection::iterator it) { mPosition = it; }
+
     static const log_time FLUSH_ERROR;
     log_time flushTo(SocketClient *writer);
 };
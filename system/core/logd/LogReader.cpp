@@ -142,7 +142,7 @@ bool LogReader::onDataAvailable(SocketClient *cli) {
             bool found() { return startTimeSet; }
         } logFindStart(logMask, pid, start);
 
-        logbuf().flushTo(cli, LogTimeEntry::EPOCH,
+        logbuf().flushTo(cli, LogTimeEntry::EPOCH, logMask,
                          FlushCommand::hasReadLogs(cli),
                          logFindStart.callback, &logFindStart);
 
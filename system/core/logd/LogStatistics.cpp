@@ -118,11 +118,40 @@ char *PidStatistics::pidToName(pid_t pid) {
 
 UidStatistics::UidStatistics(uid_t uid)
         : uid(uid)
+        , mOldest(NULL)
+        , mNewest(NULL)
+        , mWorstIndex(0)
         , mSizes(0)
         , mElements(0) {
     Pids.clear();
 }
 
+// Elements arrive in time order, append to the chain.
+void UidStatistics::link(LogBufferElement *e) {
+    e->mUidNext = NULL;
+    e->mUidPrev = mNewest;
+    if (mNewest) {
+        mNewest->mUidNext = e;
+    } else {
+        mOldest = e;
+    }
+    mNewest = e;
+}
+
+void UidStatistics::unlink(LogBufferElement *e) {
+    if (e->mUidPrev) {
+        e->mUidPrev->mUidNext = e->mUidNext;
+    } else if (mOldest == e) {
+        mOldest = e->mUidNext;
+    }
+    if (e->mUidNext) {
+        e->mUidNext->mUidPrev = e->mUidPrev;
+    } else if (mNewest == e) {
+        mNewest = e->mUidPrev;
+    }
+    e->mUidPrev = e->mUidNext = NULL;
+}
+
 UidStatistics::~UidStatistics() {
     PidStatisticsCollection::iterator it;
     for (it = begin(); it != end();) {
@@ -277,7 +306,7 @@ LidStatistics::~LidStatistics() {
     }
 }
 
-void LidStatistics::add(unsigned short size, uid_t uid, pid_t pid) {
+UidStatistics *LidStatistics::add(unsigned short size, uid_t uid, pid_t pid) {
     UidStatistics *u;
     UidStatisticsCollection::iterator it;
     UidStatisticsCollection::iterator last;
@@ -294,7 +323,8 @@ void LidStatistics::add(unsigned short size, uid_t uid, pid_t pid) {
                 Uids.erase(it);
                 Uids.insert(last, u);
             }
-            return;
+            worstUp(u->mWorstIndex);
+            return u;
         }
     }
     u = new UidStatistics(uid);
@@ -304,9 +334,13 @@ void LidStatistics::add(unsigned short size, uid_t uid, pid_t pid) {
         Uids.push_back(u);
     }
     u->add(size, pid);
+    u->mWorstIndex = mWorst.size();
+    mWorst.push(u);
+    worstUp(u->mWorstIndex);
+    return u;
 }
 
-void LidStatistics::subtract(unsigned short size, uid_t uid, pid_t pid) {
+UidStatistics *LidStatistics::subtract(unsigned short size, uid_t uid, pid_t pid) {
     if (uid == (uid_t) -1) { // init
         uid = (uid_t) AID_ROOT;
     }
@@ -316,9 +350,79 @@ void LidStatistics::subtract(unsigned short size, uid_t uid, pid_t pid) {
         UidStatistics *u = *it;
         if (uid == u->getUid()) {
             u->subtract(size, pid);
-            return;
+            worstDown(u->mWorstIndex);
+            return u;
+        }
+    }
+    return NULL;
+}
+
+void LidStatistics::add(LogBufferElement *e) {
+    add(e->getMsgLen(), e->getUid(), e->getPid())->link(e);
+}
+
+void LidStatistics::subtract(LogBufferElement *e) {
+    UidStatistics *u = subtract(e->getMsgLen(), e->getUid(), e->getPid());
+    if (u) {
+        u->unlink(e);
+    }
+}
+
+void LidStatistics::worstUp(size_t index) {
+    UidStatistics *u = mWorst[index];
+    while (index) {
+        size_t parent = (index - 1) / 2;
+        UidStatistics *p = mWorst[parent];
+        if (p->sizes() >= u->sizes()) {
+            break;
         }
+        mWorst.editItemAt(index) = p;
+        p->mWorstIndex = index;
+        index = parent;
     }
+    mWorst.editItemAt(index) = u;
+    u->mWorstIndex = index;
+}
+
+void LidStatistics::worstDown(size_t index) {
+    UidStatistics *u = mWorst[index];
+    size_t count = mWorst.size();
+    for (;;) {
+        size_t child = (2 * index) + 1;
+        if (child >= count) {
+            break;
+        }
+        if (((child + 1) < count)
+                && (mWorst[child + 1]->sizes() > mWorst[child]->sizes())) {
+            ++child;
+        }
+        UidStatistics *c = mWorst[child];
+        if (u->sizes() >= c->sizes()) {
+            break;
+        }
+        mWorst.editItemAt(index) = c;
+        c->mWorstIndex = index;
+        index = child;
+    }
+    mWorst.editItemAt(index) = u;
+    u->mWorstIndex = index;
+}
+
+UidStatistics *LidStatistics::worst() const {
+    if (mWorst.isEmpty()) {
+        return NULL;
+    }
+    return mWorst[0];
+}
+
+size_t LidStatistics::secondWorstSizes() const {
+    size_t sizes = 0;
+    for (size_t i = 1; (i <= 2) && (i < mWorst.size()); ++i) {
+        if (mWorst[i]->sizes() > sizes) {
+            sizes = mWorst[i]->sizes();
+        }
+    }
+    return sizes;
 }
 
 void LidStatistics::sort() {
@@ -461,24 +565,24 @@ void LogStatistics::recordDiff(log_time diff, unsigned short bucket) {
     }
 }
 
-void LogStatistics::add(unsigned short size,
-                        log_id_t log_id, uid_t uid, pid_t pid) {
-    mSizes[log_id] += size;
+void LogStatistics::add(LogBufferElement *e) {
+    log_id_t log_id = e->getLogId();
+    mSizes[log_id] += e->getMsgLen();
     ++mElements[log_id];
     if (!mStatistics) {
         return;
     }
-    id(log_id).add(size, uid, pid);
+    id(log_id).add(e);
 }
 
-void LogStatistics::subtract(unsigned short size,
-                             log_id_t log_id, uid_t uid, pid_t pid) {
-    mSizes[log_id] -= size;
+void LogStatistics::subtract(LogBufferElement *e) {
+    log_id_t log_id = e->getLogId();
+    mSizes[log_id] -= e->getMsgLen();
     --mElements[log_id];
     if (!mStatistics) {
         return;
     }
-    id(log_id).subtract(size, uid, pid);
+    id(log_id).subtract(e);
 }
 
 size_t LogStatistics::sizes(log_id_t log_id, uid_t uid, pid_t pid) {
@@ -22,6 +22,9 @@
 #include <log/log.h>
 #include <log/log_read.h>
 #include <utils/List.h>
+#include <utils/Vector.h>
+
+#include "LogBufferElement.h"
 
 #define log_id_for_each(i) \
     for (log_id_t i = LOG_ID_MIN; i < LOG_ID_MAX; i = (log_id_t) (i + 1))
@@ -68,10 +71,22 @@ public:
 typedef android::List<PidStatistics *> PidStatisticsCollection;
 
 class UidStatistics {
+    friend class LidStatistics;
+
     const uid_t uid;
 
     PidStatisticsCollection Pids;
 
+    // Chain of this uid's elements, oldest first
+    LogBufferElement *mOldest;
+    LogBufferElement *mNewest;
+
+    // Position in LidStatistics::mWorst
+    size_t mWorstIndex;
+
+    void link(LogBufferElement *e);
+    void unlink(LogBufferElement *e);
+
     void insert(PidStatisticsCollection::iterator i, PidStatistics *p)
         { Pids.insert(i, p); }
     void push_back(PidStatistics *p) { Pids.push_back(p); }
@@ -90,6 +105,9 @@ public:
 
     uid_t getUid() { return uid; }
 
+    // Oldest element still in the buffer, NULL if none or statistics off
+    LogBufferElement *oldest() const { return mOldest; }
+
     void add(unsigned short size, pid_t pid);
     void subtract(unsigned short size, pid_t pid);
     void sort();
@@ -116,6 +134,14 @@ typedef android::List<UidStatistics *> UidStatisticsCollection;
 class LidStatistics {
     UidStatisticsCollection Uids;
 
+    // Binary max-heap of Uids on current sizes()
+    android::Vector<UidStatistics *> mWorst;
+
+    void worstUp(size_t index);
+    void worstDown(size_t index);
+    UidStatistics *add(unsigned short size, uid_t uid, pid_t pid);
+    UidStatistics *subtract(unsigned short size, uid_t uid, pid_t pid);
+
 public:
     LidStatistics();
     ~LidStatistics();
@@ -123,10 +149,14 @@ public:
     UidStatisticsCollection::iterator begin() { return Uids.begin(); }
     UidStatisticsCollection::iterator end() { return Uids.end(); }
 
-    void add(unsigned short size, uid_t uid, pid_t pid);
-    void subtract(unsigned short size, uid_t uid, pid_t pid);
+    void add(LogBufferElement *e);
+    void subtract(LogBufferElement *e);
     void sort();
 
+    // Largest current consumer, and the sizes() of the runner up
+    UidStatistics *worst() const;
+    size_t secondWorstSizes() const;
+
     static const pid_t pid_all = (pid_t) -1;
     static const uid_t uid_all = (uid_t) -1;
 
@@ -163,8 +193,8 @@ public:
     unsigned long long minimum(unsigned short bucket);
     void recordDiff(log_time diff, unsigned short bucket);
 
-    void add(unsigned short size, log_id_t log_id, uid_t uid, pid_t pid);
-    void subtract(unsigned short size, log_id_t log_id, uid_t uid, pid_t pid);
+    void add(LogBufferElement *e);
+    void subtract(LogBufferElement *e);
     void sort();
 
     // fast track current value by id only
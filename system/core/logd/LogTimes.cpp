@@ -134,9 +134,10 @@ void *LogTimeEntry::threadStart(void *obj) {
         unlock();
 
         if (me->mTail) {
-            logbuf.flushTo(client, start, privileged, FilterFirstPass, me);
+            logbuf.flushTo(client, start, me->mLogMask, privileged, FilterFirstPass, me);
         }
-        start = logbuf.flushTo(client, start, privileged, FilterSecondPass, me);
+        start = logbuf.flushTo(client, start, me->mLogMask, privileged,
+                                FilterSecondPass, me);
 
         lock();
 
@@ -63,6 +63,7 @@ public:
     bool naughty(LogBufferElement *element);
     bool nice(LogBufferElement *element);
     bool worstUidEnabled() const { return mWorstUidEnabled; }
+    bool naughtyEnabled() const { return !mNaughty.empty(); }
 
     // *strp is malloc'd, use free to release
     void format(char **strp);
@@ -0,0 +1,191 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <log/log.h>
+#include <log/logger.h>
+#include <log/log_read.h>
+
+#include "benchmark.h"
+
+// see ../../liblog/tests/liblog_benchmark.cpp
+#define LOG_FAILURE_RETRY(exp) ({  \
+    typeof (exp) _rc;              \
+    do {                           \
+        _rc = (exp);               \
+    } while (((_rc == -1)          \
+           && ((errno == EINTR)    \
+            || (errno == EAGAIN))) \
+          || (_rc == -EINTR)       \
+          || (_rc == -EAGAIN));    \
+    _rc; })
+
+static const char payload[] =
+    "logd_benchmark sustained load line, about the length of a typical log";
+
+static const int max_threads = 16;
+
+struct writer_arg {
+    int lines;
+    volatile bool *stop;
+};
+
+static void *writer(void *obj) {
+    writer_arg *arg = reinterpret_cast<writer_arg *>(obj);
+
+    for (int i = 0; (arg->lines < 0) || (i < arg->lines); ++i) {
+        if (arg->stop && *arg->stop) {
+            break;
+        }
+        LOG_FAILURE_RETRY(
+            __android_log_buf_write(LOG_ID_MAIN, ANDROID_LOG_INFO,
+                                    "logd_benchmark", payload));
+    }
+    return NULL;
+}
+
+/*
+ *	Measure the sustained rate, in lines per second (1e9 / ns per
+ * iteration), that logd accepts from a number of concurrent writers.
+ */
+static void BM_logd_sustained(int iters, int threads) {
+    pthread_t thread[max_threads];
+    writer_arg arg = { (iters + threads - 1) / threads, NULL };
+
+    StartBenchmarkTiming();
+
+    for (int i = 0; i < threads; ++i) {
+        pthread_create(&thread[i], NULL, writer, &arg);
+    }
+    for (int i = 0; i < threads; ++i) {
+        pthread_join(thread[i], NULL);
+    }
+
+    StopBenchmarkTiming();
+
+    SetBenchmarkBytesProcessed(static_cast<uint64_t>(arg.lines) * threads
+                               * sizeof(payload));
+}
+BENCHMARK(BM_logd_sustained)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->Arg(16);
+
+static void caught_reader_latency(int /*signum*/)
+{
+    unsigned long long v = 0xDEADBEEFA55A5AA7ULL;
+
+    LOG_FAILURE_RETRY(__android_log_btwrite(0, EVENT_TYPE_LONG, &v, sizeof(v)));
+}
+
+static unsigned long long caught_convert(char *cp)
+{
+    unsigned long long l = cp[0] & 0xFF;
+    l |= (unsigned long long) (cp[1] & 0xFF) << 8;
+    l |= (unsigned long long) (cp[2] & 0xFF) << 16;
+    l |= (unsigned long long) (cp[3] & 0xFF) << 24;
+    l |= (unsigned long long) (cp[4] & 0xFF) << 32;
+    l |= (unsigned long long) (cp[5] & 0xFF) << 40;
+    l |= (unsigned long long) (cp[6] & 0xFF) << 48;
+    l |= (unsigned long long) (cp[7] & 0xFF) << 56;
+    return l;
+}
+
+static const int alarm_time = 3;
+
+/*
+ *	Measure the time from posting an event to a blocking reader receiving
+ * it, while a number of writers keep the main log buffer under pressure.
+ */
+static void BM_logd_reader_latency(int iters, int threads) {
+    pid_t pid = getpid();
+
+    struct logger_list *logger_list = android_logger_list_open(LOG_ID_EVENTS,
+        O_RDONLY, 0, pid);
+
+    if (!logger_list) {
+        fprintf(stderr, "Unable to open events log: %s\n", strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+
+    volatile bool stop = false;
+    pthread_t thread[max_threads];
+    writer_arg arg = { -1, &stop };
+    for (int i = 0; i < threads; ++i) {
+        pthread_create(&thread[i], NULL, writer, &arg);
+    }
+
+    signal(SIGALRM, caught_reader_latency);
+    alarm(alarm_time);
+
+    for (int i = 0; i < iters; ++i) {
+        log_time ts(CLOCK_REALTIME);
+
+        StartBenchmarkTiming();
+
+        LOG_FAILURE_RETRY(
+            android_btWriteLog(0, EVENT_TYPE_LONG, &ts, sizeof(ts)));
+
+        for (;;) {
+            log_msg log_msg;
+            int ret = android_logger_list_read(logger_list, &log_msg);
+            alarm(alarm_time);
+
+            if (ret <= 0) {
+                iters = i;
+                break;
+            }
+            if ((log_msg.entry.len != (4 + 1 + 8))
+             || (log_msg.id() != LOG_ID_EVENTS)) {
+                continue;
+            }
+
+            char *eventData = log_msg.msg();
+
+            if (eventData[4] != EVENT_TYPE_LONG) {
+                continue;
+            }
+            log_time tx(eventData + 4 + 1);
+            if (ts != tx) {
+                if (0xDEADBEEFA55A5AA7ULL == caught_convert(eventData + 4 + 1)) {
+                    iters = i;
+                    break;
+                }
+                continue;
+            }
+
+            break;
+        }
+
+        StopBenchmarkTiming();
+    }
+
+    signal(SIGALRM, SIG_DFL);
+    alarm(0);
+
+    stop = true;
+    for (int i = 0; i < threads; ++i) {
+        pthread_join(thread[i], NULL);
+    }
+
+    android_logger_list_free(logger_list);
+}
+BENCHMARK(BM_logd_reader_latency)->Arg(0)->Arg(1)->Arg(4)->Arg(16);
@@ -117,10 +117,19 @@
 /* Default number of threads. */
 #define DEFAULT_NUM_THREADS 2
 
+/* Capacity of the pipes used to splice() payloads; must hold a whole MAX_WRITE
+ * request or MAX_READ reply, headers and unaligned page boundaries included. */
+#define SPLICE_PIPE_SIZE (MAX_WRITE + 2 * PAGESIZE)
+
 /* Pseudo-error constant used to indicate that no fuse status is needed
  * or that a reply has already been written. */
 #define NO_STATUS 1
 
+/* Pseudo-error constant returned by the splice helpers when nothing was sent
+ * or written and the caller should copy the payload instead.  Distinct from
+ * every negative errno, which are reported to the kernel as is. */
+#define SPLICE_FALLBACK INT_MIN
+
 /* Path to system-provided mapping of package name to appIds */
 static const char* const kPackagesListFile = "/data/system/packages.list";
 
@@ -219,7 +228,12 @@ static bool int_equals(void *keyA, void *keyB) {
 
 /* Global data structure shared by all fuse handlers. */
 struct fuse {
-    pthread_mutex_t lock;
+    /* Guards the node tree and package maps.  Handlers that only resolve
+     * nodes and paths hold it for reading, so lookups from many handlers
+     * proceed in parallel; anything that links, unlinks, renames or frees
+     * nodes must hold it for writing.  Node refcounts may be acquired with
+     * either, see acquire_node_locked(). */
+    pthread_rwlock_t lock;
 
     __u64 next_generation;
     int fd;
@@ -250,6 +264,12 @@ struct fuse {
 
     Hashmap* package_to_appid;
     Hashmap* appid_with_rw;
+
+    /* Whether READ replies, and incoming requests, are moved with splice().
+     * Cleared if the kernel turns out not to support it.  Handler threads
+     * access them with __atomic builtins, without holding |lock|. */
+    bool splice_read;
+    bool splice_write;
 };
 
 /* Private data used by a single fuse handler. */
@@ -263,6 +283,15 @@ struct fuse_handler {
         __u8 request_buffer[MAX_REQUEST_SIZE];
         __u8 read_buffer[MAX_READ + PAGESIZE];
     };
+
+    /* Pipes for splice()ing payloads past the buffers above, or -1 if
+     * unavailable.  |data_pipe| carries incoming requests and outgoing file
+     * data, |reply_pipe| assembles a reply header with its data. */
+    int data_pipe[2];
+    int reply_pipe[2];
+
+    /* Bytes of FUSE_WRITE payload left in |data_pipe| by the current request. */
+    size_t write_pending;
 };
 
 static inline void *id_to_ptr(__u64 nid)
@@ -275,9 +304,11 @@ static inline __u64 ptr_to_id(void *ptr)
     return (__u64) (uintptr_t) ptr;
 }
 
+/* Safe with |lock| held for reading; the refcount can only drop (and the node
+ * be freed) with |lock| held for writing. */
 static void acquire_node_locked(struct node* node)
 {
-    node->refcount++;
+    __sync_fetch_and_add(&node->refcount, 1);
     TRACE("ACQUIRE %p (%s) rc=%d\n", node, node->name, node->refcount);
 }
 
@@ -724,8 +755,8 @@ static struct node* acquire_or_create_child_locked(
 }
 
 static void fuse_init(struct fuse *fuse, int fd, const char *source_path,
-        gid_t write_gid, derive_t derive, bool split_perms) {
-    pthread_mutex_init(&fuse->lock, NULL);
+        gid_t write_gid, derive_t derive, bool split_perms, bool splice_write) {
+    pthread_rwlock_init(&fuse->lock, NULL);
 
     fuse->fd = fd;
     fuse->next_generation = 0;
@@ -733,6 +764,8 @@ static void fuse_init(struct fuse *fuse, int fd, const char *source_path,
     fuse->split_perms = split_perms;
     fuse->write_gid = write_gid;
     fuse->inode_ctr = 1;
+    fuse->splice_read = true;
+    fuse->splice_write = splice_write;
 
     memset(&fuse->root, 0, sizeof(fuse->root));
     fuse->root.nid = FUSE_ROOT_ID; /* 1 */
@@ -818,10 +851,19 @@ static int fuse_reply_entry(struct fuse* fuse, __u64 unique,
         return -errno;
     }
 
-    pthread_mutex_lock(&fuse->lock);
-    node = acquire_or_create_child_locked(fuse, parent, name, actual_name);
+    /* Most lookups find an existing node, only take the write lock to
+     * create one. */
+    pthread_rwlock_rdlock(&fuse->lock);
+    node = lookup_child_by_name_locked(parent, name);
+    if (node) {
+        acquire_node_locked(node);
+    } else {
+        pthread_rwlock_unlock(&fuse->lock);
+        pthread_rwlock_wrlock(&fuse->lock);
+        node = acquire_or_create_child_locked(fuse, parent, name, actual_name);
+    }
     if (!node) {
-        pthread_mutex_unlock(&fuse->lock);
+        pthread_rwlock_unlock(&fuse->lock);
         return -ENOMEM;
     }
     memset(&out, 0, sizeof(out));
@@ -830,7 +872,7 @@ static int fuse_reply_entry(struct fuse* fuse, __u64 unique,
     out.entry_valid = 10;
     out.nodeid = node->nid;
     out.generation = node->gen;
-    pthread_mutex_unlock(&fuse->lock);
+    pthread_rwlock_unlock(&fuse->lock);
     fuse_reply(fuse, unique, &out, sizeof(out));
     return NO_STATUS;
 }
@@ -859,12 +901,12 @@ static int handle_lookup(struct fuse* fuse, struct fuse_handler* handler,
     char child_path[PATH_MAX];
     const char* actual_name;
 
-    pthread_mutex_lock(&fuse->lock);
+    pthread_rwlock_rdlock(&fuse->lock);
     parent_node = lookup_node_and_path_by_id_locked(fuse, hdr->nodeid,
             parent_path, sizeof(parent_path));
     TRACE("[%d] LOOKUP %s @ %"PRIx64" (%s)\n", handler->token, name, hdr->nodeid,
         parent_node ? parent_node->name : "?");
-    pthread_mutex_unlock(&fuse->lock);
+    pthread_rwlock_unlock(&fuse->lock);
 
     if (!parent_node || !(actual_name = find_file_within(parent_path, name,
             child_path, sizeof(child_path), 1))) {
@@ -882,7 +924,7 @@ static int handle_forget(struct fuse* fuse, struct fuse_handler* handler,
 {
     struct node* node;
 
-    pthread_mutex_lock(&fuse->lock);
+    pthread_rwlock_wrlock(&fuse->lock);
     node = lookup_node_by_id_locked(fuse, hdr->nodeid);
     TRACE("[%d] FORGET #%"PRIu64" @ %"PRIx64" (%s)\n", handler->token, req->nlookup,
             hdr->nodeid, node ? node->name : "?");
@@ -892,7 +934,7 @@ static int handle_forget(struct fuse* fuse, struct fuse_handler* handler,
             release_node_locked(node);
         }
     }
-    pthread_mutex_unlock(&fuse->lock);
+    pthread_rwlock_unlock(&fuse->lock);
     return NO_STATUS; /* no reply */
 }
 
@@ -902,11 +944,11 @@ static int handle_getattr(struct fuse* fuse, struct fuse_handler* handler,
     struct node* node;
     char path[PATH_MAX];
 
-    pthread_mutex_lock(&fuse->lock);
+    pthread_rwlock_rdlock(&fuse->lock);
     node = lookup_node_and_path_by_id_locked(fuse, hdr->nodeid, path, sizeof(path));
     TRACE("[%d] GETATTR flags=%x fh=%"PRIx64" @ %"PRIx64" (%s)\n", handler->token,
             req->getattr_flags, req->fh, hdr->nodeid, node ? node->name : "?");
-    pthread_mutex_unlock(&fuse->lock);
+    pthread_rwlock_unlock(&fuse->lock);
 
     if (!node) {
         return -ENOENT;
@@ -926,12 +968,12 @@ static int handle_setattr(struct fuse* fuse, struct fuse_handler* handler,
     char path[PATH_MAX];
     struct timespec times[2];
 
-    pthread_mutex_lock(&fuse->lock);
+    pthread_rwlock_rdlock(&fuse->lock);
     has_rw = get_caller_has_rw_locked(fuse, hdr);
     node = lookup_node_and_path_by_id_locked(fuse, hdr->nodeid, path, sizeof(path));
     TRACE("[%d] SETATTR fh=%"PRIx64" valid=%x @ %"PRIx64" (%s)\n", handler->token,
             req->fh, req->valid, hdr->nodeid, node ? node->name : "?");
-    pthread_mutex_unlock(&fuse->lock);
+    pthread_rwlock_unlock(&fuse->lock);
 
     if (!node) {
         return -ENOENT;
@@ -990,13 +1032,13 @@ static int handle_mknod(struct fuse* fuse, struct fuse_handler* handler,
     char child_path[PATH_MAX];
     const char* actual_name;
 
-    pthread_mutex_lock(&fuse->lock);
+    pthread_rwlock_rdlock(&fuse->lock);
     has_rw = get_caller_has_rw_locked(fuse, hdr);
     parent_node = lookup_node_and_path_by_id_locked(fuse, hdr->nodeid,
             parent_path, sizeof(parent_path));
     TRACE("[%d] MKNOD %s 0%o @ %"PRIx64" (%s)\n", handler->token,
             name, req->mode, hdr->nodeid, parent_node ? parent_node->name : "?");
-    pthread_mutex_unlock(&fuse->lock);
+    pthread_rwlock_unlock(&fuse->lock);
 
     if (!parent_node || !(actual_name = find_file_within(parent_path, name,
             child_path, sizeof(child_path), 1))) {
@@ -1021,13 +1063,13 @@ static int handle_mkdir(struct fuse* fuse, struct fuse_handler* handler,
     char child_path[PATH_MAX];
     const char* actual_name;
 
-    pthread_mutex_lock(&fuse->lock);
+    pthread_rwlock_rdlock(&fuse->lock);
     has_rw = get_caller_has_rw_locked(fuse, hdr);
     parent_node = lookup_node_and_path_by_id_locked(fuse, hdr->nodeid,
             parent_path, sizeof(parent_path));
     TRACE("[%d] MKDIR %s 0%o @ %"PRIx64" (%s)\n", handler->token,
             name, req->mode, hdr->nodeid, parent_node ? parent_node->name : "?");
-    pthread_mutex_unlock(&fuse->lock);
+    pthread_rwlock_unlock(&fuse->lock);
 
     if (!parent_node || !(actual_name = find_file_within(parent_path, name,
             child_path, sizeof(child_path), 1))) {
@@ -1070,13 +1112,13 @@ static int handle_unlink(struct fuse* fuse, struct fuse_handler* handler,
     char parent_path[PATH_MAX];
     char child_path[PATH_MAX];
 
-    pthread_mutex_lock(&fuse->lock);
+    pthread_rwlock_rdlock(&fuse->lock);
     has_rw = get_caller_has_rw_locked(fuse, hdr);
     parent_node = lookup_node_and_path_by_id_locked(fuse, hdr->nodeid,
             parent_path, sizeof(parent_path));
     TRACE("[%d] UNLINK %s @ %"PRIx64" (%s)\n", handler->token,
             name, hdr->nodeid, parent_node ? parent_node->name : "?");
-    pthread_mutex_unlock(&fuse->lock);
+    pthread_rwlock_unlock(&fuse->lock);
 
     if (!parent_node || !find_file_within(parent_path, name,
             child_path, sizeof(child_path), 1)) {
@@ -1099,13 +1141,13 @@ static int handle_rmdir(struct fuse* fuse, struct fuse_handler* handler,
     char parent_path[PATH_MAX];
     char child_path[PATH_MAX];
 
-    pthread_mutex_lock(&fuse->lock);
+    pthread_rwlock_rdlock(&fuse->lock);
     has_rw = get_caller_has_rw_locked(fuse, hdr);
     parent_node = lookup_node_and_path_by_id_locked(fuse, hdr->nodeid,
             parent_path, sizeof(parent_path));
     TRACE("[%d] RMDIR %s @ %"PRIx64" (%s)\n", handler->token,
             name, hdr->nodeid, parent_node ? parent_node->name : "?");
-    pthread_mutex_unlock(&fuse->lock);
+    pthread_rwlock_unlock(&fuse->lock);
 
     if (!parent_node || !find_file_within(parent_path, name,
             child_path, sizeof(child_path), 1)) {
@@ -1135,7 +1177,7 @@ static int handle_rename(struct fuse* fuse, struct fuse_handler* handler,
     const char* new_actual_name;
     int res;
 
-    pthread_mutex_lock(&fuse->lock);
+    pthread_rwlock_rdlock(&fuse->lock);
     has_rw = get_caller_has_rw_locked(fuse, hdr);
     old_parent_node = lookup_node_and_path_by_id_locked(fuse, hdr->nodeid,
             old_parent_path, sizeof(old_parent_path));
@@ -1164,7 +1206,7 @@ static int handle_rename(struct fuse* fuse, struct fuse_handler* handler,
         goto lookup_error;
     }
     acquire_node_locked(child_node);
-    pthread_mutex_unlock(&fuse->lock);
+    pthread_rwlock_unlock(&fuse->lock);
 
     /* Special case for renaming a file where destination is same path
      * differing only by case.  In this case we don't want to look for a case
@@ -1185,7 +1227,7 @@ static int handle_rename(struct fuse* fuse, struct fuse_handler* handler,
         goto io_error;
     }
 
-    pthread_mutex_lock(&fuse->lock);
+    pthread_rwlock_wrlock(&fuse->lock);
     res = rename_node_locked(child_node, new_name, new_actual_name);
     if (!res) {
         remove_node_from_parent_locked(child_node);
@@ -1194,11 +1236,11 @@ static int handle_rename(struct fuse* fuse, struct fuse_handler* handler,
     goto done;
 
 io_error:
-    pthread_mutex_lock(&fuse->lock);
+    pthread_rwlock_wrlock(&fuse->lock);
 done:
     release_node_locked(child_node);
 lookup_error:
-    pthread_mutex_unlock(&fuse->lock);
+    pthread_rwlock_unlock(&fuse->lock);
     return res;
 }
 
@@ -1222,12 +1264,12 @@ static int handle_open(struct fuse* fuse, struct fuse_handler* handler,
     struct fuse_open_out out;
     struct handle *h;
 
-    pthread_mutex_lock(&fuse->lock);
+    pthread_rwlock_rdlock(&fuse->lock);
     has_rw = get_caller_has_rw_locked(fuse, hdr);
     node = lookup_node_and_path_by_id_locked(fuse, hdr->nodeid, path, sizeof(path));
     TRACE("[%d] OPEN 0%o @ %"PRIx64" (%s)\n", handler->token,
             req->flags, hdr->nodeid, node ? node->name : "?");
-    pthread_mutex_unlock(&fuse->lock);
+    pthread_rwlock_unlock(&fuse->lock);
 
     if (!node) {
         return -ENOENT;
@@ -1253,6 +1295,82 @@ static int handle_open(struct fuse* fuse, struct fuse_handler* handler,
     return NO_STATUS;
 }
 
+/* Discards anything left in a (non-blocking) pipe.  Uses its own buffer, as
+ * the handler's may still hold the request being answered. */
+static void drain_pipe(int fd)
+{
+    __u8 buf[PAGESIZE];
+    while (read(fd, buf, sizeof(buf)) > 0) {
+    }
+}
+
+/* Moves up to |size| bytes at |offset| from |fd| straight into a FUSE_READ
+ * reply, without copying them through userspace.
+ *
+ * Returns NO_STATUS once replied, a negative errno to report, or
+ * SPLICE_FALLBACK if nothing was sent and the caller should copy instead. */
+static int splice_read_reply(struct fuse* fuse, struct fuse_handler* handler,
+        __u64 unique, int fd, __u32 size, __u64 offset)
+{
+    struct fuse_out_header hdr;
+    loff_t off = offset;
+    size_t len = 0;
+    size_t moved = 0;
+    ssize_t res;
+
+    while (len < size) {
+        res = splice(fd, &off, handler->data_pipe[1], NULL, size - len,
+                SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+        if (res < 0) {
+            if (len) {
+                break; /* short read, like pread64() */
+            }
+            if (errno == EINVAL || errno == ENOSYS || errno == EAGAIN) {
+                return SPLICE_FALLBACK;
+            }
+            return -errno;
+        }
+        if (res == 0) {
+            break;
+        }
+        len += res;
+    }
+
+    hdr.len = sizeof(hdr) + len;
+    hdr.error = 0;
+    hdr.unique = unique;
+    if (write(handler->reply_pipe[1], &hdr, sizeof(hdr)) != sizeof(hdr)) {
+        goto fallback;
+    }
+    while (moved < len) {
+        res = splice(handler->data_pipe[0], NULL, handler->reply_pipe[1], NULL,
+                len - moved, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+        if (res <= 0) {
+            goto fallback;
+        }
+        moved += res;
+    }
+    res = splice(handler->reply_pipe[0], NULL, fuse->fd, NULL, hdr.len, SPLICE_F_MOVE);
+    if (res == (ssize_t) hdr.len) {
+        return NO_STATUS;
+    }
+    if (res >= 0) {
+        /* The kernel took part of the reply: it must not get a second one. */
+        ERROR("[%d] short splice reply: %zd of %u\n", handler->token, res, hdr.len);
+        drain_pipe(handler->reply_pipe[0]);
+        return NO_STATUS;
+    }
+
+fallback:
+    ERROR("[%d] splice reply failed, errno=%d\n", handler->token, errno);
+    if (errno == EINVAL || errno == ENOSYS) {
+        __atomic_store_n(&fuse->splice_read, false, __ATOMIC_RELAXED);
+    }
+    drain_pipe(handler->data_pipe[0]);
+    drain_pipe(handler->reply_pipe[0]);
+    return SPLICE_FALLBACK;
+}
+
 static int handle_read(struct fuse* fuse, struct fuse_handler* handler,
         const struct fuse_in_header* hdr, const struct fuse_read_in* req)
 {
@@ -1272,6 +1390,12 @@ static int handle_read(struct fuse* fuse, struct fuse_handler* handler,
     if (size > MAX_READ) {
         return -EINVAL;
     }
+    if (__atomic_load_n(&fuse->splice_read, __ATOMIC_RELAXED) && handler->reply_pipe[0] >= 0) {
+        res = splice_read_reply(fuse, handler, unique, h->fd, size, offset);
+        if (res != SPLICE_FALLBACK) {
+            return res;
+        }
+    }
     res = pread64(h->fd, read_buffer, size, offset);
     if (res < 0) {
         return -errno;
@@ -1280,6 +1404,52 @@ static int handle_read(struct fuse* fuse, struct fuse_handler* handler,
     return NO_STATUS;
 }
 
+/* Writes the FUSE_WRITE payload left in |data_pipe| straight to |fd|.
+ *
+ * Returns the number of bytes written, or a negative errno.  Returns
+ * SPLICE_FALLBACK with the payload read into |buffer| if the caller should
+ * write it instead. */
+static int splice_write_payload(struct fuse_handler* handler, int fd,
+        __u32 size, __u64 offset, void* buffer)
+{
+    loff_t off = offset;
+    size_t len = 0;
+
+    while (len < size && handler->write_pending) {
+        ssize_t res = splice(handler->data_pipe[0], NULL, fd, &off, size - len,
+                SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+        if (res <= 0) {
+            if (len) {
+                break; /* short write, like pwrite64() */
+            }
+            if (res < 0 && errno != EINVAL && errno != ENOSYS) {
+                /* The payload is dropped: never let the caller take EAGAIN
+                 * for a payload copied into |buffer|. */
+                res = errno == EAGAIN ? -EIO : -errno;
+                drain_pipe(handler->data_pipe[0]);
+                handler->write_pending = 0;
+                return res;
+            }
+            /* Target can't take a splice (O_DIRECT, unusual filesystem). */
+            if (read(handler->data_pipe[0], buffer, handler->write_pending)
+                    != (ssize_t) handler->write_pending) {
+                drain_pipe(handler->data_pipe[0]);
+                handler->write_pending = 0;
+                return -EIO;
+            }
+            handler->write_pending = 0;
+            return SPLICE_FALLBACK;
+        }
+        len += res;
+        handler->write_pending -= res;
+    }
+    if (handler->write_pending) {
+        drain_pipe(handler->data_pipe[0]);
+        handler->write_pending = 0;
+    }
+    return len;
+}
+
 static int handle_write(struct fuse* fuse, struct fuse_handler* handler,
         const struct fuse_in_header* hdr, const struct fuse_write_in* req,
         const void* buffer)
@@ -1289,6 +1459,21 @@ static int handle_write(struct fuse* fuse, struct fuse_handler* handler,
     int res;
     __u8 aligned_buffer[req->size] __attribute__((__aligned__(PAGESIZE)));
 
+    if (handler->write_pending) {
+        TRACE("[%d] WRITE (splice) %p(%d) %u@%"PRIu64"\n", handler->token,
+                h, h->fd, req->size, req->offset);
+        res = splice_write_payload(handler, h->fd, req->size, req->offset,
+                (void*) buffer);
+        if (res != SPLICE_FALLBACK) {
+            if (res < 0) {
+                return res;
+            }
+            out.size = res;
+            fuse_reply(fuse, hdr->unique, &out, sizeof(out));
+            return NO_STATUS;
+        }
+    }
+
     if (req->flags & O_DIRECT) {
         memcpy(aligned_buffer, buffer, req->size);
         buffer = (const __u8*) aligned_buffer;
@@ -1313,10 +1498,10 @@ static int handle_statfs(struct fuse* fuse, struct fuse_handler* handler,
     struct fuse_statfs_out out;
     int res;
 
-    pthread_mutex_lock(&fuse->lock);
+    pthread_rwlock_rdlock(&fuse->lock);
     TRACE("[%d] STATFS\n", handler->token);
     res = get_node_path_locked(&fuse->root, path, sizeof(path));
-    pthread_mutex_unlock(&fuse->lock);
+    pthread_rwlock_unlock(&fuse->lock);
     if (res < 0) {
         return -ENOENT;
     }
@@ -1387,11 +1572,11 @@ static int handle_opendir(struct fuse* fuse, struct fuse_handler* handler,
     struct fuse_open_out out;
     struct dirhandle *h;
 
-    pthread_mutex_lock(&fuse->lock);
+    pthread_rwlock_rdlock(&fuse->lock);
     node = lookup_node_and_path_by_id_locked(fuse, hdr->nodeid, path, sizeof(path));
     TRACE("[%d] OPENDIR @ %"PRIx64" (%s)\n", handler->token,
             hdr->nodeid, node ? node->name : "?");
-    pthread_mutex_unlock(&fuse->lock);
+    pthread_rwlock_unlock(&fuse->lock);
 
     if (!node) {
         return -ENOENT;
@@ -1597,12 +1782,67 @@ static int handle_fuse_request(struct fuse *fuse, struct fuse_handler* handler,
     }
 }
 
+/* Reads the next request from /dev/fuse through |data_pipe|.  The payload of a
+ * FUSE_WRITE is left behind in the pipe for handle_write() to splice out;
+ * everything else is copied into the request buffer.
+ *
+ * Returns the length of the request, as read() would, or -1 with errno set. */
+static ssize_t splice_request(struct fuse* fuse, struct fuse_handler* handler)
+{
+    struct fuse_in_header* hdr = (void*) handler->request_buffer;
+    size_t head = sizeof(*hdr);
+    ssize_t len;
+    ssize_t res;
+
+    len = splice(fuse->fd, NULL, handler->data_pipe[1], NULL,
+            sizeof(handler->request_buffer), SPLICE_F_MOVE);
+    if (len < 0) {
+        if (errno == EINVAL || errno == ENOSYS) {
+            ERROR("[%d] cannot splice from fuse device, errno=%d\n",
+                    handler->token, errno);
+            __atomic_store_n(&fuse->splice_write, false, __ATOMIC_RELAXED);
+            errno = EINTR;
+        }
+        return -1;
+    }
+    if ((size_t)len < head
+            || read(handler->data_pipe[0], hdr, head) != (ssize_t) head) {
+        drain_pipe(handler->data_pipe[0]);
+        return len < (ssize_t) head ? len : 0;
+    }
+    if (hdr->opcode == FUSE_WRITE && (size_t)len >= head + sizeof(struct fuse_write_in)) {
+        head += sizeof(struct fuse_write_in);
+        handler->write_pending = len - head;
+    }
+    if (sizeof(*hdr) < (size_t)len - handler->write_pending) {
+        res = read(handler->data_pipe[0], handler->request_buffer + sizeof(*hdr),
+                len - handler->write_pending - sizeof(*hdr));
+        if (res != (ssize_t) (len - handler->write_pending - sizeof(*hdr))) {
+            drain_pipe(handler->data_pipe[0]);
+            handler->write_pending = 0;
+            return 0;
+        }
+    }
+    return len;
+}
+
 static void handle_fuse_requests(struct fuse_handler* handler)
 {
     struct fuse* fuse = handler->fuse;
     for (;;) {
-        ssize_t len = read(fuse->fd,
-                handler->request_buffer, sizeof(handler->request_buffer));
+        ssize_t len;
+        if (handler->write_pending) {
+            /* Left over by a request that never reached handle_write(). */
+            drain_pipe(handler->data_pipe[0]);
+            handler->write_pending = 0;
+        }
+        if (__atomic_load_n(&fuse->splice_write, __ATOMIC_RELAXED)
+                && handler->data_pipe[0] >= 0) {
+            len = splice_request(fuse, handler);
+        } else {
+            len = read(fuse->fd,
+                    handler->request_buffer, sizeof(handler->request_buffer));
+        }
         if (len < 0) {
             if (errno != EINTR) {
                 ERROR("[%d] handle_fuse_requests: errno=%d\n", handler->token, errno);
@@ -1660,7 +1900,7 @@ static bool remove_int_to_null(void *key, void *value, void *context) {
 }
 
 static int read_package_list(struct fuse *fuse) {
-    pthread_mutex_lock(&fuse->lock);
+    pthread_rwlock_wrlock(&fuse->lock);
 
     hashmapForEach(fuse->package_to_appid, remove_str_to_int, fuse->package_to_appid);
     hashmapForEach(fuse->appid_with_rw, remove_int_to_null, fuse->appid_with_rw);
@@ -1668,7 +1908,7 @@ static int read_package_list(struct fuse *fuse) {
     FILE* file = fopen(kPackagesListFile, "r");
     if (!file) {
         ERROR("failed to open package list: %s\n", strerror(errno));
-        pthread_mutex_unlock(&fuse->lock);
+        pthread_rwlock_unlock(&fuse->lock);
         return -1;
     }
 
@@ -1697,7 +1937,7 @@ static int read_package_list(struct fuse *fuse) {
             hashmapSize(fuse->package_to_appid),
             hashmapSize(fuse->appid_with_rw));
     fclose(file);
-    pthread_mutex_unlock(&fuse->lock);
+    pthread_rwlock_unlock(&fuse->lock);
     return 0;
 }
 
@@ -1763,6 +2003,23 @@ static void watch_package_list(struct fuse* fuse) {
     }
 }
 
+/* Opens a pipe big enough for a whole request or reply, or sets both ends to
+ * -1 so that the handler sticks to read() and write(). */
+static void open_splice_pipe(int fds[2])
+{
+    if (pipe2(fds, O_NONBLOCK | O_CLOEXEC) < 0) {
+        ERROR("cannot create splice pipe: %s\n", strerror(errno));
+        fds[0] = fds[1] = -1;
+        return;
+    }
+    if (fcntl(fds[1], F_SETPIPE_SZ, SPLICE_PIPE_SIZE) < (int) SPLICE_PIPE_SIZE) {
+        ERROR("cannot grow splice pipe: %s\n", strerror(errno));
+        close(fds[0]);
+        close(fds[1]);
+        fds[0] = fds[1] = -1;
+    }
+}
+
 static int ignite_fuse(struct fuse* fuse, int num_threads)
 {
     struct fuse_handler* handlers;
@@ -1777,6 +2034,9 @@ static int ignite_fuse(struct fuse* fuse, int num_threads)
     for (i = 0; i < num_threads; i++) {
         handlers[i].fuse = fuse;
         handlers[i].token = i;
+        handlers[i].write_pending = 0;
+        open_splice_pipe(handlers[i].data_pipe);
+        open_splice_pipe(handlers[i].reply_pipe);
     }
 
     /* When deriving permissions, this thread is used to process inotify events,
@@ -1811,17 +2071,18 @@ static int usage()
             "    -u: specify UID to run as\n"
             "    -g: specify GID to run as\n"
             "    -w: specify GID required to write (default sdcard_rw, requires -d or -l)\n"
-            "    -t: specify number of threads to use (default %d)\n"
+            "    -t: specify number of threads to use, 0 for one per CPU (default %d)\n"
             "    -d: derive file permissions based on path\n"
             "    -l: derive file permissions based on legacy internal layout\n"
             "    -s: split derived permissions for pics, av\n"
+            "    -z: splice write payloads instead of copying them\n"
             "\n", DEFAULT_NUM_THREADS);
     return 1;
 }
 
 static int run(const char* source_path, const char* dest_path, uid_t uid,
         gid_t gid, gid_t write_gid, int num_threads, derive_t derive,
-        bool split_perms) {
+        bool split_perms, bool splice_write) {
     int fd;
     char opts[256];
     int res;
@@ -1864,7 +2125,7 @@ static int run(const char* source_path, const char* dest_path, uid_t uid,
         goto error;
     }
 
-    fuse_init(&fuse, fd, source_path, write_gid, derive, split_perms);
+    fuse_init(&fuse, fd, source_path, write_gid, derive, split_perms, splice_write);
 
     umask(0);
     res = ignite_fuse(&fuse, num_threads);
@@ -1888,12 +2149,13 @@ int main(int argc, char **argv)
     int num_threads = DEFAULT_NUM_THREADS;
     derive_t derive = DERIVE_NONE;
     bool split_perms = false;
+    bool splice_write = false;
     int i;
     struct rlimit rlim;
     int fs_version;
 
     int opt;
-    while ((opt = getopt(argc, argv, "u:g:w:t:dls")) != -1) {
+    while ((opt = getopt(argc, argv, "u:g:w:t:dlsz")) != -1) {
         switch (opt) {
             case 'u':
                 uid = strtoul(optarg, NULL, 10);
@@ -1916,6 +2178,9 @@ int main(int argc, char **argv)
             case 's':
                 split_perms = true;
                 break;
+            case 'z':
+                splice_write = true;
+                break;
             case '?':
             default:
                 return usage();
@@ -1950,6 +2215,10 @@ int main(int argc, char **argv)
         ERROR("uid and gid must be nonzero\n");
         return usage();
     }
+    if (num_threads == 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_CONF);
+        num_threads = (cpus > DEFAULT_NUM_THREADS) ? cpus : DEFAULT_NUM_THREADS;
+    }
     if (num_threads < 1) {
         ERROR("number of threads must be at least 1\n");
         return usage();
@@ -1970,6 +2239,7 @@ int main(int argc, char **argv)
         sleep(1);
     }
 
-    res = run(source_path, dest_path, uid, gid, write_gid, num_threads, derive, split_perms);
+    res = run(source_path, dest_path, uid, gid, write_gid, num_threads, derive, split_perms,
+            splice_write);
     return res < 0 ? 1 : 0;
 }
@@ -0,0 +1,216 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Measures stat, open and read operations per second against a directory
+ * served by the sdcard daemon, with an increasing number of client threads.
+ * Compare runs with different "sdcard -t" settings to see how request
+ * dispatch scales.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define NUM_FILES 64
+#define FILE_SIZE (64 * 1024)
+#define READ_SIZE 4096
+#define RUN_SECONDS 2
+#define MAX_THREADS 64
+
+typedef enum {
+    OP_STAT,
+    OP_OPEN,
+    OP_READ,
+} op_t;
+
+static const char* const kOpNames[] = { "stat", "open", "read" };
+
+struct worker {
+    pthread_t thread;
+    const char* dir;
+    op_t op;
+    int index;
+    volatile bool* stop;
+    unsigned long ops;
+};
+
+static void file_path(char* buf, size_t len, const char* dir, int i) {
+    snprintf(buf, len, "%s/file%d", dir, i);
+}
+
+static int setup(const char* dir) {
+    char path[PATH_MAX];
+    char data[READ_SIZE];
+    int i, j;
+
+    memset(data, 0x5a, sizeof(data));
+    if (mkdir(dir, 0775) < 0 && errno != EEXIST) {
+        fprintf(stderr, "cannot create %s: %s\n", dir, strerror(errno));
+        return -1;
+    }
+    for (i = 0; i < NUM_FILES; i++) {
+        file_path(path, sizeof(path), dir, i);
+        int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0664);
+        if (fd < 0) {
+            fprintf(stderr, "cannot create %s: %s\n", path, strerror(errno));
+            return -1;
+        }
+        for (j = 0; j < FILE_SIZE / READ_SIZE; j++) {
+            if (write(fd, data, sizeof(data)) != sizeof(data)) {
+                fprintf(stderr, "cannot write %s: %s\n", path, strerror(errno));
+                close(fd);
+                return -1;
+            }
+        }
+        close(fd);
+    }
+    return 0;
+}
+
+static void cleanup(const char* dir) {
+    char path[PATH_MAX];
+    int i;
+
+    for (i = 0; i < NUM_FILES; i++) {
+        file_path(path, sizeof(path), dir, i);
+        unlink(path);
+    }
+    rmdir(dir);
+}
+
+static void* run_worker(void* data) {
+    struct worker* w = data;
+    char path[PATH_MAX];
+    char buf[READ_SIZE];
+    struct stat st;
+    int fd = -1;
+    int i = w->index;
+
+    if (w->op == OP_READ) {
+        file_path(path, sizeof(path), w->dir, i % NUM_FILES);
+        fd = open(path, O_RDONLY);
+        if (fd < 0) {
+            return NULL;
+        }
+    }
+
+    while (!*w->stop) {
+        i = (i + 1) % NUM_FILES;
+        switch (w->op) {
+        case OP_STAT:
+            file_path(path, sizeof(path), w->dir, i);
+            if (stat(path, &st) < 0) {
+                return NULL;
+            }
+            break;
+        case OP_OPEN:
+            file_path(path, sizeof(path), w->dir, i);
+            fd = open(path, O_RDONLY);
+            if (fd < 0) {
+                return NULL;
+            }
+            close(fd);
+            break;
+        case OP_READ:
+            /* Walk through the file one page at a time. */
+            if (pread(fd, buf, sizeof(buf),
+                    (off_t) (w->ops % (FILE_SIZE / READ_SIZE)) * READ_SIZE) < 0) {
+                close(fd);
+                return NULL;
+            }
+            break;
+        }
+        w->ops++;
+    }
+
+    if (w->op == OP_READ) {
+        close(fd);
+    }
+    return NULL;
+}
+
+static double run(const char* dir, op_t op, int num_threads) {
+    struct worker workers[MAX_THREADS];
+    volatile bool stop = false;
+    struct timespec start, end;
+    unsigned long ops = 0;
+    int i;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0; i < num_threads; i++) {
+        workers[i].dir = dir;
+        workers[i].op = op;
+        workers[i].index = i;
+        workers[i].stop = &stop;
+        workers[i].ops = 0;
+        pthread_create(&workers[i].thread, NULL, run_worker, &workers[i]);
+    }
+    sleep(RUN_SECONDS);
+    stop = true;
+    for (i = 0; i < num_threads; i++) {
+        pthread_join(workers[i].thread, NULL);
+        ops += workers[i].ops;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    return ops / seconds;
+}
+
+int main(int argc, char** argv) {
+    char dir[PATH_MAX];
+    int max_threads = 16;
+    int threads;
+    int op;
+
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <sdcard_path> [max_threads]\n", argv[0]);
+        return 1;
+    }
+    if (argc > 2) {
+        max_threads = atoi(argv[2]);
+        if (max_threads < 1 || max_threads > MAX_THREADS) {
+            fprintf(stderr, "max_threads must be between 1 and %d\n", MAX_THREADS);
+            return 1;
+        }
+    }
+
+    snprintf(dir, sizeof(dir), "%s/.sdcard_benchmark.%d", argv[1], getpid());
+    if (setup(dir) < 0) {
+        cleanup(dir);
+        return 1;
+    }
+
+    printf("%-8s %8s %14s\n", "op", "threads", "ops/sec");
+    for (op = OP_STAT; op <= OP_READ; op++) {
+        for (threads = 1; threads <= max_threads; threads *= 2) {
+            printf("%-8s %8d %14.0f\n", kOpNames[op], threads,
+                    run(dir, (op_t) op, threads));
+        }
+    }
+
+    cleanup(dir);
+    return 0;
+}